@@ -0,0 +1,17 @@
+# Try to find libqatzip
+#
+# Once done, this will define
+#
+# QATZIP_FOUND
+# QATZIP_INCLUDE_DIR
+# QATZIP_LIBRARIES
+
+find_path(QATZIP_INCLUDE_DIR NAMES qatzip.h)
+
+find_library(QATZIP_LIBRARIES NAMES qatzip)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(qatzip
+  REQUIRED_VARS QATZIP_LIBRARIES QATZIP_INCLUDE_DIR)
+
+mark_as_advanced(QATZIP_INCLUDE_DIR QATZIP_LIBRARIES)
@@ -46,6 +46,16 @@ public:
   virtual int encrypt_message(Message *message) = 0;
   virtual int decrypt_message(Message *message) = 0;
 
+  // AEAD for individual message segments on the wire (ms_secure_mode).
+  // idx names the segment and is authenticated along with it.
+  virtual bool can_encrypt_segments() { return false; }
+  virtual int encrypt_segment(__u8 idx, const bufferlist& in, bufferlist& out) {
+    return -EOPNOTSUPP;
+  }
+  virtual int decrypt_segment(__u8 idx, const bufferlist& in, bufferlist& out) {
+    return -EOPNOTSUPP;
+  }
+
   int get_protocol() {return protocol;}
   CryptoKey get_key() {return key;}
 
@@ -17,6 +17,7 @@
 # include <cryptopp/modes.h>
 # include <cryptopp/aes.h>
 # include <cryptopp/filters.h>
+# include <cryptopp/gcm.h>
 #elif defined(USE_NSS)
 # include <nspr.h>
 # include <nss.h>
@@ -211,6 +212,76 @@ public:
     out.append((const char *)decryptedtext.c_str(), decryptedtext.length());
     return 0;
   }
+
+  int encrypt_block(const char *in, char *out) const override {
+    enc_key->ProcessBlock((const byte*)in, (byte*)out);
+    return 0;
+  }
+
+  // GCM is fed buffer by buffer, so fragmented input is not flattened
+  int encrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const override {
+    bufferptr out_tmp(in.length() + CEPH_AES_GCM_TAG_LEN);
+    try {
+      CryptoPP::GCM<CryptoPP::AES>::Encryption gcm;
+      gcm.SetKeyWithIV((const byte*)secret.c_str(), AES_KEY_LEN,
+		       (const byte*)nonce, CEPH_AES_GCM_NONCE_LEN);
+      gcm.Update((const byte*)aad, aad_len);
+      byte *o = (byte*)out_tmp.c_str();
+      for (auto& p : in.buffers()) {
+	gcm.ProcessData(o, (const byte*)p.c_str(), p.length());
+	o += p.length();
+      }
+      gcm.TruncatedFinal(o, CEPH_AES_GCM_TAG_LEN);
+    } catch (CryptoPP::Exception& e) {
+      if (error) {
+	ostringstream oss;
+	oss << "gcm encrypt exception: " << e.GetWhat();
+	*error = oss.str();
+      }
+      return -1;
+    }
+    out.append(out_tmp);
+    return 0;
+  }
+
+  int decrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const override {
+    if (in.length() < CEPH_AES_GCM_TAG_LEN)
+      return -EINVAL;
+    unsigned len = in.length() - CEPH_AES_GCM_TAG_LEN;
+    bufferlist ct, tag;
+    ct.substr_of(in, 0, len);
+    tag.substr_of(in, len, CEPH_AES_GCM_TAG_LEN);
+    bufferptr out_tmp(len);
+    try {
+      CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+      gcm.SetKeyWithIV((const byte*)secret.c_str(), AES_KEY_LEN,
+		       (const byte*)nonce, CEPH_AES_GCM_NONCE_LEN);
+      gcm.Update((const byte*)aad, aad_len);
+      byte *o = (byte*)out_tmp.c_str();
+      for (auto& p : ct.buffers()) {
+	gcm.ProcessData(o, (const byte*)p.c_str(), p.length());
+	o += p.length();
+      }
+      if (!gcm.TruncatedVerify((const byte*)tag.c_str(), CEPH_AES_GCM_TAG_LEN)) {
+	if (error)
+	  *error = "gcm tag mismatch";
+	return -1;
+      }
+    } catch (CryptoPP::Exception& e) {
+      if (error) {
+	ostringstream oss;
+	oss << "gcm decrypt exception: " << e.GetWhat();
+	*error = oss.str();
+      }
+      return -1;
+    }
+    out.append(out_tmp);
+    return 0;
+  }
 };
 
 #elif defined(USE_NSS)
@@ -272,6 +343,56 @@ static int nss_aes_operation(CK_ATTRIBUTE_TYPE op,
   return 0;
 }
 
+#ifdef CKM_AES_GCM
+static int nss_aes_gcm_operation(bool encrypt, PK11SymKey *key,
+				 const char *nonce,
+				 const char *aad, size_t aad_len,
+				 const bufferlist& in, bufferlist& out,
+				 std::string *error)
+{
+  if (!encrypt && in.length() < CEPH_AES_GCM_TAG_LEN)
+    return -EINVAL;
+
+  CK_GCM_PARAMS gcm;
+  memset(&gcm, 0, sizeof(gcm));
+  gcm.pIv = (CK_BYTE_PTR)nonce;
+  gcm.ulIvLen = CEPH_AES_GCM_NONCE_LEN;
+  gcm.pAAD = (CK_BYTE_PTR)aad;
+  gcm.ulAADLen = aad_len;
+  gcm.ulTagBits = CEPH_AES_GCM_TAG_LEN * 8;
+  SECItem param;
+  param.type = siBuffer;
+  param.data = (unsigned char*)&gcm;
+  param.len = sizeof(gcm);
+
+  // NSS only does GCM in one shot
+  bufferlist incopy = in;  // it's a shallow copy!
+  unsigned char *in_buf = (unsigned char*)incopy.c_str();
+  bufferptr out_tmp(in.length() + CEPH_AES_GCM_TAG_LEN);
+  unsigned int written = 0;
+  SECStatus ret;
+  if (encrypt)
+    ret = PK11_Encrypt(key, CKM_AES_GCM, &param,
+		       (unsigned char*)out_tmp.c_str(), &written,
+		       out_tmp.length(), in_buf, in.length());
+  else
+    ret = PK11_Decrypt(key, CKM_AES_GCM, &param,
+		       (unsigned char*)out_tmp.c_str(), &written,
+		       out_tmp.length(), in_buf, in.length());
+  if (ret != SECSuccess) {
+    if (error) {
+      ostringstream oss;
+      oss << "NSS AES-GCM failed: " << PR_GetError();
+      *error = oss.str();
+    }
+    return -1;
+  }
+  out_tmp.set_length(written);
+  out.append(out_tmp);
+  return 0;
+}
+#endif
+
 class CryptoAESKeyHandler : public CryptoKeyHandler {
   CK_MECHANISM_TYPE mechanism;
   PK11SlotInfo *slot;
@@ -336,6 +457,33 @@ public:
 	       bufferlist& out, std::string *error) const override {
     return nss_aes_operation(CKA_DECRYPT, mechanism, key, param, in, out, error);
   }
+  int encrypt_block(const char *in, char *out) const override {
+    SECItem no_param = { siBuffer, NULL, 0 };
+    PK11Context *ectx = PK11_CreateContextBySymKey(CKM_AES_ECB, CKA_ENCRYPT,
+						   key, &no_param);
+    if (!ectx)
+      return -1;
+    int written = 0;
+    SECStatus ret = PK11_CipherOp(ectx, (unsigned char*)out, &written,
+				  CEPH_AES_BLOCK_LEN, (unsigned char*)in,
+				  CEPH_AES_BLOCK_LEN);
+    PK11_DestroyContext(ectx, PR_TRUE);
+    if (ret != SECSuccess || written != CEPH_AES_BLOCK_LEN)
+      return -1;
+    return 0;
+  }
+#ifdef CKM_AES_GCM
+  int encrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const override {
+    return nss_aes_gcm_operation(true, key, nonce, aad, aad_len, in, out, error);
+  }
+  int decrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const override {
+    return nss_aes_gcm_operation(false, key, nonce, aad, aad_len, in, out, error);
+  }
+#endif
 };
 
 #else
@@ -52,8 +52,39 @@ public:
 		       bufferlist& out, std::string *error) const = 0;
   virtual int decrypt(const bufferlist& in,
 		       bufferlist& out, std::string *error) const = 0;
+
+  /*
+   * authenticated encryption (AES-GCM) under a caller supplied nonce
+   * of CEPH_AES_GCM_NONCE_LEN bytes, which must never repeat for the
+   * same key. encrypt_aead appends the ciphertext followed by a
+   * CEPH_AES_GCM_TAG_LEN byte tag; decrypt_aead expects the same and
+   * fails if the tag doesn't verify.
+   */
+  virtual int encrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+			   const bufferlist& in, bufferlist& out,
+			   std::string *error) const {
+    return -EOPNOTSUPP;
+  }
+  virtual int decrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+			   const bufferlist& in, bufferlist& out,
+			   std::string *error) const {
+    return -EOPNOTSUPP;
+  }
+
+  /*
+   * encrypt a single CEPH_AES_BLOCK_LEN byte block with the raw cipher,
+   * no chaining and no padding
+   */
+  virtual int encrypt_block(const char *in, char *out) const {
+    return -EOPNOTSUPP;
+  }
 };
 
+#define CEPH_AES_BLOCK_LEN 16
+
+#define CEPH_AES_GCM_NONCE_LEN 12
+#define CEPH_AES_GCM_TAG_LEN   16
+
 /*
  * match encoding of struct ceph_secret
  */
@@ -126,6 +157,22 @@ public:
     assert(ckh); // Bad key?
     return ckh->decrypt(in, out, error);
   }
+  int encrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const {
+    assert(ckh); // Bad key?
+    return ckh->encrypt_aead(nonce, aad, aad_len, in, out, error);
+  }
+  int decrypt_aead(const char *nonce, const char *aad, size_t aad_len,
+		   const bufferlist& in, bufferlist& out,
+		   std::string *error) const {
+    assert(ckh); // Bad key?
+    return ckh->decrypt_aead(nonce, aad, aad_len, in, out, error);
+  }
+  int encrypt_block(const char *in, char *out) const {
+    assert(ckh); // Bad key?
+    return ckh->encrypt_block(in, out);
+  }
 
   void to_str(std::string& s) const;
 };
@@ -24,6 +24,62 @@
  
 #define dout_subsys ceph_subsys_auth
 
+CephxSessionHandler::CephxSessionHandler(CephContext *cct_,
+					 CryptoKey session_key,
+					 uint64_t features)
+  : AuthSessionHandler(cct_, CEPH_AUTH_CEPHX, session_key),
+    features(features)
+{
+  cct->random()->get_bytes(nonce_salt, sizeof(nonce_salt));
+}
+
+// segment wire format: nonce || ciphertext || tag
+int CephxSessionHandler::encrypt_segment(__u8 idx, const bufferlist& in,
+					 bufferlist& out)
+{
+  if (++nonce_seq == 0) {
+    // never reuse a nonce; the session has to be re-keyed
+    ldout(cct, 0) << __func__ << " nonce space exhausted" << dendl;
+    return -ERANGE;
+  }
+  char nonce[CEPH_AES_GCM_NONCE_LEN];
+  memcpy(nonce, nonce_salt, sizeof(nonce_salt));
+  ceph_le32 seq;
+  seq = nonce_seq;
+  memcpy(nonce + sizeof(nonce_salt), &seq, sizeof(seq));
+  out.append(nonce, sizeof(nonce));
+
+  std::string error;
+  int r = key.encrypt_aead(nonce, (const char *)&idx, sizeof(idx),
+			   in, out, &error);
+  if (r < 0) {
+    ldout(cct, 0) << __func__ << " failed: " << error << dendl;
+  }
+  return r;
+}
+
+int CephxSessionHandler::decrypt_segment(__u8 idx, const bufferlist& in,
+					 bufferlist& out)
+{
+  if (in.length() < CEPH_AES_GCM_NONCE_LEN + CEPH_AES_GCM_TAG_LEN) {
+    ldout(cct, 0) << __func__ << " segment too short (" << in.length()
+		  << " bytes)" << dendl;
+    return -EINVAL;
+  }
+  char nonce[CEPH_AES_GCM_NONCE_LEN];
+  in.copy(0, sizeof(nonce), nonce);
+  bufferlist ct;
+  ct.substr_of(in, sizeof(nonce), in.length() - sizeof(nonce));
+
+  std::string error;
+  int r = key.decrypt_aead(nonce, (const char *)&idx, sizeof(idx),
+			   ct, out, &error);
+  if (r < 0) {
+    ldout(cct, 0) << __func__ << " failed: " << error << dendl;
+  }
+  return r;
+}
+
 int CephxSessionHandler::_calc_signature(Message *m, uint64_t *psig)
 {
   const ceph_msg_header& header = m->get_header();
@@ -45,18 +101,35 @@ int CephxSessionHandler::_calc_signature(Message *m, uint64_t *psig)
     mswab<uint32_t>(header.crc), mswab<uint32_t>(footer.front_crc),
     mswab<uint32_t>(footer.middle_crc), mswab<uint32_t>(footer.data_crc)
   };
-  bufferlist bl_plaintext;
-  bl_plaintext.append(buffer::create_static(sizeof(sigblock), (char*)&sigblock));
+  static_assert(sizeof(sigblock) > CEPH_AES_BLOCK_LEN,
+		"signature comes from the first cipher block");
+
+  // the signature is the start of the first CBC block, which is just the
+  // first plaintext block xor the IV, encrypted; compute that block alone
+  // when the key handler can, and skip padding and the second block
+  char block[CEPH_AES_BLOCK_LEN], cblock[CEPH_AES_BLOCK_LEN];
+  memcpy(block, &sigblock, sizeof(block));
+  for (unsigned i = 0; i < sizeof(block); ++i)
+    block[i] ^= CEPH_AES_IV[i];
+  if (key.encrypt_block(block, cblock) == 0) {
+    ceph_le64 sig;
+    memcpy(&sig, cblock, sizeof(sig));
+    *psig = sig;
+  } else {
+    bufferlist bl_plaintext;
+    bl_plaintext.append(buffer::create_static(sizeof(sigblock),
+					      (char*)&sigblock));
+
+    bufferlist bl_ciphertext;
+    if (key.encrypt(cct, bl_plaintext, bl_ciphertext, NULL) < 0) {
+      lderr(cct) << __func__ << " failed to encrypt signature block" << dendl;
+      return -1;
+    }
 
-  bufferlist bl_ciphertext;
-  if (key.encrypt(cct, bl_plaintext, bl_ciphertext, NULL) < 0) {
-    lderr(cct) << __func__ << " failed to encrypt signature block" << dendl;
-    return -1;
+    bufferlist::iterator ci = bl_ciphertext.begin();
+    ::decode(*psig, ci);
   }
 
-  bufferlist::iterator ci = bl_ciphertext.begin();
-  ::decode(*psig, ci);
-
   ldout(cct, 10) << __func__ << " seq " << m->get_seq()
 		 << " front_crc_ = " << footer.front_crc
 		 << " middle_crc = " << footer.middle_crc
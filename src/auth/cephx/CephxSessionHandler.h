@@ -22,10 +22,14 @@ class Message;
 class CephxSessionHandler  : public AuthSessionHandler {
   uint64_t features;
 
+  // segment nonces are a random per-handler salt plus a counter, so
+  // the two directions (and successive sessions on the same key) never
+  // reuse one
+  char nonce_salt[8];
+  uint32_t nonce_seq = 0;
+
 public:
-  CephxSessionHandler(CephContext *cct_, CryptoKey session_key, uint64_t features)
-    : AuthSessionHandler(cct_, CEPH_AUTH_CEPHX, session_key),
-      features(features) {}
+  CephxSessionHandler(CephContext *cct_, CryptoKey session_key, uint64_t features);
   ~CephxSessionHandler() override {}
   
   bool no_security() override {
@@ -47,5 +51,11 @@ public:
     return 0;
   }
 
+  bool can_encrypt_segments() override {
+    return true;
+  }
+  int encrypt_segment(__u8 idx, const bufferlist& in, bufferlist& out) override;
+  int decrypt_segment(__u8 idx, const bufferlist& in, bufferlist& out) override;
+
 };
 
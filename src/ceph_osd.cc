@@ -42,6 +42,7 @@ using namespace std;
 #include "include/color.h"
 #include "common/errno.h"
 #include "common/pick_address.h"
+#include "include/util.h"
 
 #include "perfglue/heap_profiler.h"
 
@@ -456,6 +457,19 @@ flushjournal_out:
 	 << TEXT_NORMAL << dendl;
   }
 
+  // bind before the messengers and thread pools start so that every
+  // worker thread inherits the affinity
+  int64_t numa_node = g_conf->get_val<int64_t>("osd_numa_node");
+  if (numa_node >= 0) {
+    int r = set_numa_node_affinity(numa_node);
+    if (r < 0) {
+      derr << "unable to bind to numa node " << numa_node << ": "
+	   << cpp_strerror(r) << dendl;
+    } else {
+      dout(0) << "bound to numa node " << numa_node << dendl;
+    }
+  }
+
   std::string public_msgr_type = g_conf->ms_public_type.empty() ? g_conf->get_val<std::string>("ms_type") : g_conf->ms_public_type;
   std::string cluster_msgr_type = g_conf->ms_cluster_type.empty() ? g_conf->get_val<std::string>("ms_type") : g_conf->ms_cluster_type;
   Messenger *ms_public = Messenger::create(g_ceph_context, public_msgr_type,
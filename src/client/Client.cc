@@ -7587,6 +7587,8 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
   req->set_inode(diri.get());
   req->head.args.readdir.frag = fg;
   req->head.args.readdir.flags = CEPH_READDIR_REPLY_BITFLAGS;
+  req->head.args.readdir.max_bytes =
+    MIN(cct->_conf->client_readdir_max_bytes, (uint64_t)UINT32_MAX);
   if (dirp->last_name.length()) {
     req->path2.set_path(dirp->last_name.c_str());
   } else if (dirp->hash_order()) {
@@ -8622,25 +8624,31 @@ int Client::uninline_data(Inode *in, Context *onfinish)
 
 int Client::read(int fd, char *buf, loff_t size, loff_t offset)
 {
-  Mutex::Locker lock(client_lock);
-  tout(cct) << "read" << std::endl;
-  tout(cct) << fd << std::endl;
-  tout(cct) << size << std::endl;
-  tout(cct) << offset << std::endl;
+  bufferlist bl;
+  int r;
+  {
+    Mutex::Locker lock(client_lock);
+    tout(cct) << "read" << std::endl;
+    tout(cct) << fd << std::endl;
+    tout(cct) << size << std::endl;
+    tout(cct) << offset << std::endl;
 
-  if (unmounting)
-    return -ENOTCONN;
+    if (unmounting)
+      return -ENOTCONN;
 
-  Fh *f = get_filehandle(fd);
-  if (!f)
-    return -EBADF;
+    Fh *f = get_filehandle(fd);
+    if (!f)
+      return -EBADF;
 #if defined(__linux__) && defined(O_PATH)
-  if (f->flags & O_PATH)
-    return -EBADF;
+    if (f->flags & O_PATH)
+      return -EBADF;
 #endif
-  bufferlist bl;
-  int r = _read(f, offset, size, &bl);
-  ldout(cct, 3) << "read(" << fd << ", " << (void*)buf << ", " << size << ", " << offset << ") = " << r << dendl;
+    r = _read(f, offset, size, &bl);
+    ldout(cct, 3) << "read(" << fd << ", " << (void*)buf << ", " << size << ", " << offset << ") = " << r << dendl;
+  }
+
+  // bl holds its own references to the data, so copy it out without
+  // client_lock; other threads' cached reads need not wait on the memcpy
   if (r >= 0) {
     bl.copy(0, bl.length(), buf);
     r = bl.length();
@@ -8998,52 +9006,55 @@ int Client::pwritev(int fd, const struct iovec *iov, int iovcnt, int64_t offset)
 
 int Client::_preadv_pwritev(int fd, const struct iovec *iov, unsigned iovcnt, int64_t offset, bool write)
 {
-    Mutex::Locker lock(client_lock);
-    tout(cct) << fd << std::endl;
-    tout(cct) << offset << std::endl;
+    bufferlist bl;
+    int r;
+    {
+      Mutex::Locker lock(client_lock);
+      tout(cct) << fd << std::endl;
+      tout(cct) << offset << std::endl;
 
-    if (unmounting)
-     return -ENOTCONN;
+      if (unmounting)
+       return -ENOTCONN;
 
-    Fh *fh = get_filehandle(fd);
-    if (!fh)
-        return -EBADF;
+      Fh *fh = get_filehandle(fd);
+      if (!fh)
+          return -EBADF;
 #if defined(__linux__) && defined(O_PATH)
-    if (fh->flags & O_PATH)
-        return -EBADF;
+      if (fh->flags & O_PATH)
+          return -EBADF;
 #endif
-    loff_t totallen = 0;
-    for (unsigned i = 0; i < iovcnt; i++) {
-        totallen += iov[i].iov_len;
-    }
-    if (write) {
-        int w = _write(fh, offset, totallen, NULL, iov, iovcnt);
-        ldout(cct, 3) << "pwritev(" << fd << ", \"...\", " << totallen << ", " << offset << ") = " << w << dendl;
-        return w;
-    } else {
-        bufferlist bl;
-        int r = _read(fh, offset, totallen, &bl);
-        ldout(cct, 3) << "preadv(" << fd << ", " <<  offset << ") = " << r << dendl;
-        if (r <= 0)
-          return r;
-
-        int bufoff = 0;
-        for (unsigned j = 0, resid = r; j < iovcnt && resid > 0; j++) {
-               /*
-                * This piece of code aims to handle the case that bufferlist does not have enough data 
-                * to fill in the iov 
-                */
-               if (resid < iov[j].iov_len) {
-                    bl.copy(bufoff, resid, (char *)iov[j].iov_base);
-                    break;
-               } else {
-                    bl.copy(bufoff, iov[j].iov_len, (char *)iov[j].iov_base);
-               }
-               resid -= iov[j].iov_len;
-               bufoff += iov[j].iov_len;
-        }
-        return r;  
+      loff_t totallen = 0;
+      for (unsigned i = 0; i < iovcnt; i++) {
+          totallen += iov[i].iov_len;
+      }
+      if (write) {
+          int w = _write(fh, offset, totallen, NULL, iov, iovcnt);
+          ldout(cct, 3) << "pwritev(" << fd << ", \"...\", " << totallen << ", " << offset << ") = " << w << dendl;
+          return w;
+      }
+      r = _read(fh, offset, totallen, &bl);
+      ldout(cct, 3) << "preadv(" << fd << ", " <<  offset << ") = " << r << dendl;
     }
+    if (r <= 0)
+      return r;
+
+    // as in read(), scatter the data without holding client_lock
+    int bufoff = 0;
+    for (unsigned j = 0, resid = r; j < iovcnt && resid > 0; j++) {
+           /*
+            * This piece of code aims to handle the case that bufferlist does not have enough data 
+            * to fill in the iov 
+            */
+           if (resid < iov[j].iov_len) {
+                bl.copy(bufoff, resid, (char *)iov[j].iov_base);
+                break;
+           } else {
+                bl.copy(bufoff, iov[j].iov_len, (char *)iov[j].iov_base);
+           }
+           resid -= iov[j].iov_len;
+           bufoff += iov[j].iov_len;
+    }
+    return r;  
 }
 
 int Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
@@ -12432,7 +12443,20 @@ int Client::_ll_create(Inode *parent, const char *name, mode_t mode,
   tout(cct) << ceph_flags_sys2wire(flags) << std::endl;
 
   bool created = false;
-  int r = _lookup(parent, name, caps, in, perms);
+  int r;
+
+  if ((flags & O_CREAT) && (flags & O_EXCL) &&
+      (cct->_conf->fuse_default_permissions || may_create(parent, perms) == 0)) {
+    // the MDS fails an exclusive create with EEXIST itself, so skip the
+    // lookup round trip and send the create straight away.  Without
+    // write access to the parent take the lookup path below, which
+    // reports EEXIST ahead of EACCES.
+    r = _create(parent, name, flags, mode, in, fhp, 0, 0, 0, NULL, &created,
+		perms);
+    goto out;
+  }
+
+  r = _lookup(parent, name, caps, in, perms);
 
   if (r == 0 && (flags & O_CREAT) && (flags & O_EXCL))
     return -EEXIST;
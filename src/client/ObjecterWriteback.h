@@ -49,6 +49,7 @@ class ObjecterWriteback : public WritebackHandler {
   using WritebackHandler::write;
   ceph_tid_t write(const object_t& oid, const object_locator_t& oloc,
                            vector<pair<uint64_t, bufferlist> >& io_vec,
+			   const vector<ceph_tid_t>& journal_tids,
 			   const SnapContext& snapc, ceph::real_time mtime,
 			   uint64_t trunc_size, __u32 trunc_seq,
 			   Context *oncommit) override {
@@ -582,10 +582,19 @@ static void fuse_ll_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
   Fh *fh = reinterpret_cast<Fh*>(fi->fh);
   bufferlist bl;
   int r = cfuse->client->ll_read(fh, off, size, &bl);
-  if (r >= 0)
-    fuse_reply_buf(req, bl.c_str(), bl.length());
-  else
+  if (r >= 0) {
+    if (bl.get_num_buffers() > 1 && bl.get_num_buffers() <= IOV_MAX) {
+      // hand the segments to fuse as is rather than flattening the
+      // bufferlist into a contiguous copy first
+      vector<iovec> iov;
+      bl.prepare_iov(&iov);
+      fuse_reply_iov(req, iov.data(), iov.size());
+    } else {
+      fuse_reply_buf(req, bl.c_str(), bl.length());
+    }
+  } else {
     fuse_reply_err(req, -r);
+  }
 }
 
 static void fuse_ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf,
@@ -5,6 +5,9 @@
 #include <setjmp.h>
 #include <string>
 #include <sstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <lua.hpp>
 #include "include/types.h"
 #include "objclass/objclass.h"
@@ -752,6 +755,59 @@ static void clslua_setup_env(lua_State *L)
   lua_pop(L, 1);
 }
 
+/*
+ * Compiled chunk cache. Every call gets a fresh Lua state, but the compiled
+ * form of a script does not depend on the state, so we keep the bytecode of
+ * recently seen scripts and skip the parser when the same script comes again.
+ * The source is kept next to the bytecode so a hash collision is a miss.
+ */
+struct clslua_chunk {
+  std::string script;
+  std::shared_ptr<const std::string> code;
+};
+
+static std::mutex clslua_chunk_lock;
+static std::unordered_map<size_t, clslua_chunk> clslua_chunks;
+static const size_t clslua_max_chunks = 128;
+
+static int clslua_dump_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+  static_cast<std::string*>(ud)->append(static_cast<const char*>(p), sz);
+  return 0;
+}
+
+/*
+ * Push the compiled script on the stack, as luaL_loadstring would.
+ */
+static int clslua_load_chunk(lua_State *L, const std::string& script)
+{
+  size_t hash = std::hash<std::string>()(script);
+  std::shared_ptr<const std::string> code;
+  {
+    std::lock_guard<std::mutex> l(clslua_chunk_lock);
+    auto it = clslua_chunks.find(hash);
+    if (it != clslua_chunks.end() && it->second.script == script)
+      code = it->second.code;
+  }
+  if (code)
+    return luaL_loadbufferx(L, code->data(), code->size(), "=cached", "b");
+
+  int ret = luaL_loadstring(L, script.c_str());
+  if (ret)
+    return ret;
+
+  auto dumped = std::make_shared<std::string>();
+  if (lua_dump(L, clslua_dump_writer, dumped.get(), 0) == 0) {
+    std::lock_guard<std::mutex> l(clslua_chunk_lock);
+    if (clslua_chunks.size() >= clslua_max_chunks)
+      clslua_chunks.clear();
+    clslua_chunk& chunk = clslua_chunks[hash];
+    chunk.script = script;
+    chunk.code = dumped;
+  }
+  return 0;
+}
+
 /*
  * Schema:
  * {
@@ -897,8 +953,8 @@ static int clslua_eval(lua_State *L)
   lua_newtable(L);
   lua_settable(L, LUA_REGISTRYINDEX);
 
-  /* load and compile chunk */
-  if (luaL_loadstring(L, ctx->script.c_str()))
+  /* load and compile chunk, or reuse the compiled one */
+  if (clslua_load_chunk(L, ctx->script))
     return lua_error(L);
 
   /* execute chunk */
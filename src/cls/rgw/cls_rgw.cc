@@ -102,6 +102,16 @@ static void bi_log_index_key(cls_method_context_t hctx, string& key, string& id,
   key.append(id);
 }
 
+/*
+ * index changes are logged for sync, and also while an online reshard
+ * needs to replay what changed during its copy
+ */
+static bool log_index_op(const struct rgw_bucket_dir_header& header, bool log_op)
+{
+  return (log_op && !header.syncstopped) ||
+         header.new_instance.reshard_logging();
+}
+
 static int log_index_operation(cls_method_context_t hctx, cls_rgw_obj_key& obj_key, RGWModifyOp op,
                                string& tag, real_time& timestamp,
                                rgw_bucket_entry_ver& ver, RGWPendingState state, uint64_t index_ver,
@@ -407,6 +417,9 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
   bool done = false;
   uint32_t left_to_read = op.num_entries;
   bool more;
+  /* list key prefix shared by the noncurrent versions of the last current
+   * entry, which a listing of current objects doesn't need to look at */
+  string skip_prefix;
 
   do {
     rc = get_obj_vals(hctx, start_key, op.filter_prefix, left_to_read, &keys, &more);
@@ -425,6 +438,13 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
         break;
       }
 
+      if (!skip_prefix.empty()) {
+        if (kiter->first.compare(0, skip_prefix.size(), skip_prefix) == 0) {
+          continue;
+        }
+        skip_prefix.clear();
+      }
+
       bufferlist& entrybl = kiter->second;
       bufferlist::iterator eiter = entrybl.begin();
       try {
@@ -439,18 +459,59 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
       decode_list_index_key(kiter->first, &key, &ver);
 
       start_key = kiter->first;
+      ret.marker = key;
       CLS_LOG(20, "start_key=%s len=%zu", start_key.c_str(), start_key.size());
 
       if (!entry.is_valid()) {
         CLS_LOG(20, "entry %s[%s] is not valid\n", key.name.c_str(), key.instance.c_str());
         continue;
       }
-      
+
+      if (!op.list_versions && !key.instance.empty() &&
+          (entry.flags & RGW_BUCKET_DIRENT_FLAG_CURRENT)) {
+        /* versions of a name sort together and only one of them is current,
+         * so skip over the rest without decoding them */
+        skip_prefix = key.name;
+        skip_prefix.append(1, '\0');
+      }
+
       // filter out noncurrent versions, delete markers, and initial marker
       if (!op.list_versions && (!entry.is_visible() || op.start_obj.name == key.name)) {
         CLS_LOG(20, "entry %s[%s] is not visible\n", key.name.c_str(), key.instance.c_str());
         continue;
       }
+
+      if (!real_clock::is_zero(op.max_mtime) && entry.meta.mtime > op.max_mtime) {
+        /* count it against this call, so a long run of recent entries
+         * still returns to the caller with a marker to resume from */
+        left_to_read--;
+        continue;
+      }
+
+      if (!op.delimiter.empty()) {
+        size_t delim_pos = key.name.find(op.delimiter, op.filter_prefix.size());
+        if (delim_pos != string::npos) {
+          /* return the common prefix in place of everything under it, and
+           * seek past the lot instead of reading it */
+          string prefix_key = key.name.substr(0, delim_pos + op.delimiter.size());
+          if (m.size() < op.num_entries) {
+            struct rgw_bucket_dir_entry& prefix_entry = m[prefix_key];
+            prefix_entry.key.name = prefix_key;
+            prefix_entry.exists = true;
+            prefix_entry.flags = RGW_BUCKET_DIRENT_FLAG_COMMON_PREFIX;
+          }
+          left_to_read--;
+
+          CLS_LOG(20, "got common prefix %s m.size()=%d\n", prefix_key.c_str(), (int)m.size());
+
+          start_key = prefix_key;
+          start_key.append(1, (char)0xFF);
+          ret.marker = cls_rgw_obj_key(start_key);
+          more = true;
+          break;
+        }
+      }
+
       if (m.size() < op.num_entries) {
         m[kiter->first] = entry;
       }
@@ -458,6 +519,13 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 
       CLS_LOG(20, "got entry %s[%s] m.size()=%d\n", key.name.c_str(), key.instance.c_str(), (int)m.size());
     }
+
+    if (!skip_prefix.empty() && kiter == keys.end()) {
+      /* the batch ended inside a run of noncurrent versions, seek past the
+       * rest of them instead of reading them in the next round */
+      start_key = skip_prefix;
+      start_key.append(1, (char)0xFF);
+    }
   } while (left_to_read > 0 && !done);
 
   ret.is_truncated = more && !done;
@@ -691,7 +759,7 @@ int rgw_bucket_prepare_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     return rc;
   }
 
-  if (op.log_op && !header.syncstopped) {
+  if (log_index_op(header, op.log_op)) {
     rc = log_index_operation(hctx, op.key, op.op, op.tag, entry.meta.mtime,
                              entry.ver, info.state, header.ver, header.max_marker, op.bilog_flags, NULL, NULL, &op.zones_trace);
     if (rc < 0)
@@ -784,34 +852,20 @@ static int read_key_entry(cls_method_context_t hctx, cls_rgw_obj_key& key, strin
   return 0;
 }
 
-int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+/*
+ * apply a single complete op to the index; the caller reads the header
+ * before and writes it back after, unless the op was cancelled
+ */
+static int complete_op_entry(cls_method_context_t hctx, struct rgw_bucket_dir_header& header,
+                             rgw_cls_obj_complete_op& op, bool *cancelled)
 {
-  // decode request
-  rgw_cls_obj_complete_op op;
-  bufferlist::iterator iter = in->begin();
-  try {
-    ::decode(op, iter);
-  } catch (buffer::error& err) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
-    return -EINVAL;
-  }
-  CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
-          op.op, op.key.name.c_str(), op.key.instance.c_str(),
-          (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
-          op.tag.c_str());
-
-  struct rgw_bucket_dir_header header;
-  int rc = read_bucket_header(hctx, &header);
-  if (rc < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
-    return -EINVAL;
-  }
+  *cancelled = false;
 
   struct rgw_bucket_dir_entry entry;
   bool ondisk = true;
 
   string idx;
-  rc = read_key_entry(hctx, op.key, &idx, &entry);
+  int rc = read_key_entry(hctx, op.key, &idx, &entry);
   if (rc == -ENOENT) {
     entry.key = op.key;
     entry.ver = op.ver;
@@ -848,13 +902,14 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
 
   bufferlist op_bl;
   if (cancel) {
-    if (op.log_op && !header.syncstopped) {
+    if (log_index_op(header, op.log_op)) {
       rc = log_index_operation(hctx, op.key, op.op, op.tag, entry.meta.mtime, entry.ver,
                                CLS_RGW_STATE_COMPLETE, header.ver, header.max_marker, op.bilog_flags, NULL, NULL, &op.zones_trace);
       if (rc < 0)
         return rc;
     }
 
+    *cancelled = true;
     if (op.tag.size()) {
       bufferlist new_key_bl;
       ::encode(entry, new_key_bl);
@@ -910,7 +965,7 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     break;
   }
 
-  if (op.log_op && !header.syncstopped) {
+  if (log_index_op(header, op.log_op)) {
     rc = log_index_operation(hctx, op.key, op.op, op.tag, entry.meta.mtime, entry.ver,
                              CLS_RGW_STATE_COMPLETE, header.ver, header.max_marker, op.bilog_flags, NULL, NULL, &op.zones_trace);
     if (rc < 0)
@@ -935,7 +990,7 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
             remove_entry.key.name.c_str(), remove_entry.key.instance.c_str(), remove_entry.meta.category);
     unaccount_entry(header, remove_entry);
 
-    if (op.log_op && !header.syncstopped) {
+    if (log_index_op(header, op.log_op)) {
       ++header.ver; // increment index version, or we'll overwrite keys previously written
       rc = log_index_operation(hctx, remove_key, CLS_RGW_OP_DEL, op.tag, remove_entry.meta.mtime,
                                remove_entry.ver, CLS_RGW_STATE_COMPLETE, header.ver, header.max_marker, op.bilog_flags, NULL, NULL, &op.zones_trace);
@@ -950,6 +1005,83 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     }
   }
 
+  return 0;
+}
+
+int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op op;
+  bufferlist::iterator iter = in->begin();
+  try {
+    ::decode(op, iter);
+  } catch (buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
+    return -EINVAL;
+  }
+  CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
+          op.op, op.key.name.c_str(), op.key.instance.c_str(),
+          (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
+          op.tag.c_str());
+
+  struct rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool cancelled;
+  rc = complete_op_entry(hctx, header, op, &cancelled);
+  if (rc < 0 || cancelled) {
+    return rc;
+  }
+
+  return write_bucket_header(hctx, &header);
+}
+
+int rgw_bucket_complete_op_batch(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op_batch op;
+  bufferlist::iterator iter = in->begin();
+  try {
+    ::decode(op, iter);
+  } catch (buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op_batch(): failed to decode request\n");
+    return -EINVAL;
+  }
+  CLS_LOG(10, "rgw_bucket_complete_op_batch(): request: %d ops\n", (int)op.ops.size());
+
+  struct rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op_batch(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool applied = false;
+  for (auto& complete_op : op.ops) {
+    CLS_LOG(20, "rgw_bucket_complete_op_batch(): op=%d name=%s instance=%s tag=%s\n",
+            complete_op.op, complete_op.key.name.c_str(),
+            complete_op.key.instance.c_str(), complete_op.tag.c_str());
+    bool cancelled;
+    rc = complete_op_entry(hctx, header, complete_op, &cancelled);
+    if (rc < 0) {
+      /* each op stands on its own, as if it had been sent separately */
+      CLS_LOG(1, "rgw_bucket_complete_op_batch(): op on name=%s instance=%s failed, rc=%d\n",
+              complete_op.key.name.c_str(), complete_op.key.instance.c_str(), rc);
+      continue;
+    }
+    /* bump the index version as a separate call's header write would, so
+     * that the bilog entries of the ops don't share a key */
+    ++header.ver;
+    applied = true;
+  }
+
+  if (!applied) {
+    return 0;
+  }
   return write_bucket_header(hctx, &header);
 }
 
@@ -1515,7 +1647,7 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     return ret;
   }
 
-  if (op.log_op && !header.syncstopped) {
+  if (log_index_op(header, op.log_op)) {
     rgw_bucket_dir_entry& entry = obj.get_dir_entry();
 
     rgw_bucket_entry_ver ver;
@@ -1673,7 +1805,7 @@ static int rgw_bucket_unlink_instance(cls_method_context_t hctx, bufferlist *in,
     return ret;
   }
 
-  if (op.log_op && !header.syncstopped) {
+  if (log_index_op(header, op.log_op)) {
     rgw_bucket_entry_ver ver;
     ver.epoch = (op.olh_epoch ? op.olh_epoch : olh.get_epoch());
 
@@ -1944,7 +2076,7 @@ int rgw_dir_suggest_changes(cls_method_context_t hctx,
 	ret = cls_cxx_map_remove_key(hctx, cur_change_key);
 	if (ret < 0)
 	  return ret;
-        if (log_op && cur_disk.exists && !header.syncstopped) {
+        if (cur_disk.exists && log_index_op(header, log_op)) {
           ret = log_index_operation(hctx, cur_disk.key, CLS_RGW_OP_DEL, cur_disk.tag, cur_disk.meta.mtime,
                                     cur_disk.ver, CLS_RGW_STATE_COMPLETE, header.ver, header.max_marker, 0, NULL, NULL, NULL);
           if (ret < 0) {
@@ -1980,7 +2112,7 @@ int rgw_dir_suggest_changes(cls_method_context_t hctx,
         ret = cls_cxx_map_set_val(hctx, cur_change_key, &cur_state_bl);
         if (ret < 0)
 	  return ret;
-        if (log_op && !header.syncstopped) {
+        if (log_index_op(header, log_op)) {
           ret = log_index_operation(hctx, cur_change.key, CLS_RGW_OP_ADD, cur_change.tag, cur_change.meta.mtime,
                                     cur_change.ver, CLS_RGW_STATE_COMPLETE, header.ver, header.max_marker, 0, NULL, NULL, NULL);
           if (ret < 0) {
@@ -3753,7 +3885,7 @@ static int rgw_guard_bucket_resharding(cls_method_context_t hctx, bufferlist *in
     return rc;
   }
 
-  if (header.resharding()) {
+  if (header.resharding() && !header.new_instance.reshard_logging()) {
     return op.ret_err;
   }
 
@@ -3800,6 +3932,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_bucket_update_stats;
   cls_method_handle_t h_rgw_bucket_prepare_op;
   cls_method_handle_t h_rgw_bucket_complete_op;
+  cls_method_handle_t h_rgw_bucket_complete_op_batch;
   cls_method_handle_t h_rgw_bucket_link_olh;
   cls_method_handle_t h_rgw_bucket_unlink_instance_op;
   cls_method_handle_t h_rgw_bucket_read_olh_log;
@@ -3849,6 +3982,7 @@ CLS_INIT(rgw)
   cls_register_cxx_method(h_class, RGW_BUCKET_UPDATE_STATS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_update_stats, &h_rgw_bucket_update_stats);
   cls_register_cxx_method(h_class, RGW_BUCKET_PREPARE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_prepare_op, &h_rgw_bucket_prepare_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op, &h_rgw_bucket_complete_op);
+  cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OP_BATCH, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op_batch, &h_rgw_bucket_complete_op_batch);
   cls_register_cxx_method(h_class, RGW_BUCKET_LINK_OLH, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_link_olh, &h_rgw_bucket_link_olh);
   cls_register_cxx_method(h_class, RGW_BUCKET_UNLINK_INSTANCE, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_unlink_instance, &h_rgw_bucket_unlink_instance_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_READ_OLH_LOG, CLS_METHOD_RD, rgw_bucket_read_olh_log, &h_rgw_bucket_read_olh_log);
@@ -319,6 +319,11 @@ void cls_rgw_bucket_complete_op(librados::ObjectWriteOperation& o, RGWModifyOp o
 				list<cls_rgw_obj_key> *remove_objs, bool log_op,
                                 uint16_t bilog_op, rgw_zone_set *zones_trace);
 
+/* apply several complete ops to one index shard in a single call; an op
+ * that fails is skipped without affecting the others */
+void cls_rgw_bucket_complete_op_batch(librados::ObjectWriteOperation& o,
+                                      const list<rgw_cls_obj_complete_op>& ops);
+
 void cls_rgw_remove_obj(librados::ObjectWriteOperation& o, list<string>& keep_attr_prefixes);
 void cls_rgw_obj_store_pg_ver(librados::ObjectWriteOperation& o, const string& attr);
 void cls_rgw_obj_check_attrs_prefix(librados::ObjectOperation& o, const string& prefix, bool fail_if_exist);
@@ -356,6 +361,8 @@ int cls_rgw_clear_olh(librados::IoCtx& io_ctx, librados::ObjectWriteOperation& o
  * io_ctx        - IO context for rados.
  * start_obj     - marker for the listing.
  * filter_prefix - filter prefix.
+ * delimiter     - if not empty, entries whose names contain it after the filter
+ *                 prefix are folded into a single common prefix entry.
  * num_entries   - number of entries to request for each object (note the total
  *                 amount of entries returned depends on the number of shardings).
  * list_results  - the list results keyed by bucket index object id.
@@ -367,20 +374,23 @@ int cls_rgw_clear_olh(librados::IoCtx& io_ctx, librados::ObjectWriteOperation& o
 class CLSRGWIssueBucketList : public CLSRGWConcurrentIO {
   cls_rgw_obj_key start_obj;
   string filter_prefix;
+  string delimiter;
   uint32_t num_entries;
   bool list_versions;
+  ceph::real_time max_mtime;
   map<int, rgw_cls_list_ret>& result;
 protected:
   int issue_op(int shard_id, const string& oid) override;
 public:
   CLSRGWIssueBucketList(librados::IoCtx& io_ctx, const cls_rgw_obj_key& _start_obj,
-                        const string& _filter_prefix, uint32_t _num_entries,
-                        bool _list_versions,
+                        const string& _filter_prefix, const string& _delimiter,
+                        uint32_t _num_entries, bool _list_versions,
                         map<int, string>& oids,
                         map<int, struct rgw_cls_list_ret>& list_results,
-                        uint32_t max_aio) :
+                        uint32_t max_aio,
+                        const ceph::real_time& _max_mtime = ceph::real_time()) :
   CLSRGWConcurrentIO(io_ctx, oids, max_aio),
-  start_obj(_start_obj), filter_prefix(_filter_prefix), num_entries(_num_entries), list_versions(_list_versions), result(list_results) {}
+  start_obj(_start_obj), filter_prefix(_filter_prefix), delimiter(_delimiter), num_entries(_num_entries), list_versions(_list_versions), max_mtime(_max_mtime), result(list_results) {}
 };
 
 class CLSRGWIssueBILogList : public CLSRGWConcurrentIO {
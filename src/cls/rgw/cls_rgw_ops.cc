@@ -150,6 +150,31 @@ void rgw_cls_obj_complete_op::dump(Formatter *f) const
   ::encode_json("zones_trace", zones_trace, f);
 }
 
+void rgw_cls_obj_complete_op_batch::generate_test_instances(list<rgw_cls_obj_complete_op_batch*>& o)
+{
+  rgw_cls_obj_complete_op_batch *op = new rgw_cls_obj_complete_op_batch;
+  list<rgw_cls_obj_complete_op *> l;
+  rgw_cls_obj_complete_op::generate_test_instances(l);
+  for (auto complete_op : l) {
+    op->ops.push_back(*complete_op);
+    delete complete_op;
+  }
+  o.push_back(op);
+
+  o.push_back(new rgw_cls_obj_complete_op_batch);
+}
+
+void rgw_cls_obj_complete_op_batch::dump(Formatter *f) const
+{
+  f->open_array_section("ops");
+  for (auto& complete_op : ops) {
+    f->open_object_section("op");
+    complete_op.dump(f);
+    f->close_section();
+  }
+  f->close_section();
+}
+
 void rgw_cls_link_olh_op::generate_test_instances(list<rgw_cls_link_olh_op*>& o)
 {
   rgw_cls_link_olh_op *op = new rgw_cls_link_olh_op;
@@ -289,6 +314,8 @@ void rgw_cls_list_op::generate_test_instances(list<rgw_cls_list_op*>& o)
   op->start_obj.name = "start_obj";
   op->num_entries = 100;
   op->filter_prefix = "filter_prefix";
+  op->delimiter = "/";
+  op->max_mtime = ceph::real_clock::from_time_t(1500000000);
   o.push_back(op);
   o.push_back(new rgw_cls_list_op);
 }
@@ -297,6 +324,9 @@ void rgw_cls_list_op::dump(Formatter *f) const
 {
   f->dump_string("start_obj", start_obj.name);
   f->dump_unsigned("num_entries", num_entries);
+  f->dump_string("delimiter", delimiter);
+  utime_t ut(max_mtime);
+  ::encode_json("max_mtime", ut, f);
 }
 
 void rgw_cls_list_ret::generate_test_instances(list<rgw_cls_list_ret*>& o)
@@ -310,6 +340,7 @@ void rgw_cls_list_ret::generate_test_instances(list<rgw_cls_list_ret*>& o)
     rgw_cls_list_ret *ret = new rgw_cls_list_ret;
     ret->dir = *d;
     ret->is_truncated = true;
+    ret->marker.name = "marker";
 
     o.push_back(ret);
 
@@ -325,6 +356,9 @@ void rgw_cls_list_ret::dump(Formatter *f) const
   dir.dump(f);
   f->close_section();
   f->dump_int("is_truncated", (int)is_truncated);
+  f->open_object_section("marker");
+  marker.dump(f);
+  f->close_section();
 }
 
 void rgw_cls_check_index_ret::generate_test_instances(list<rgw_cls_check_index_ret*>& o)
@@ -296,6 +296,7 @@ WRITE_CLASS_ENCODER(cls_rgw_obj_key)
 #define RGW_BUCKET_DIRENT_FLAG_CURRENT       0x2    /* the last object instance of a versioned object */
 #define RGW_BUCKET_DIRENT_FLAG_DELETE_MARKER 0x4    /* delete marker */
 #define RGW_BUCKET_DIRENT_FLAG_VER_MARKER    0x8    /* object is versioned, a placeholder for the plain entry */
+#define RGW_BUCKET_DIRENT_FLAG_COMMON_PREFIX 0x8000 /* synthetic entry for a common prefix, only in list results */
 
 struct rgw_bucket_dir_entry {
   cls_rgw_obj_key key;
@@ -369,6 +370,9 @@ struct rgw_bucket_dir_entry {
     return is_current() && !is_delete_marker();
   }
   bool is_valid() { return (flags & RGW_BUCKET_DIRENT_FLAG_VER_MARKER) == 0; }
+  bool is_common_prefix() const {
+    return (flags & RGW_BUCKET_DIRENT_FLAG_COMMON_PREFIX) != 0;
+  }
 
   void dump(Formatter *f) const;
   void decode_json(JSONObj *obj);
@@ -607,6 +611,7 @@ enum cls_rgw_reshard_status {
   CLS_RGW_RESHARD_NONE        = 0,
   CLS_RGW_RESHARD_IN_PROGRESS = 1,
   CLS_RGW_RESHARD_DONE        = 2,
+  CLS_RGW_RESHARD_LOGGING     = 3, /* copying; writes allowed and logged */
 };
 
 struct cls_rgw_bucket_instance_entry {
@@ -652,6 +657,9 @@ struct cls_rgw_bucket_instance_entry {
   bool resharding_in_progress() const {
     return reshard_status == CLS_RGW_RESHARD_IN_PROGRESS;
   }
+  bool reshard_logging() const {
+    return reshard_status == CLS_RGW_RESHARD_LOGGING;
+  }
 };
 WRITE_CLASS_ENCODER(cls_rgw_bucket_instance_entry)
 
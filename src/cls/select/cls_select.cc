@@ -0,0 +1,103 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * select objclass
+ *
+ * Filters delimited text records of an object range where the data lives,
+ * so that only the matching records (and the partial ones at the range
+ * edges) leave the OSD.
+ */
+
+#include <errno.h>
+
+#include "objclass/objclass.h"
+
+#include "cls_select_ops.h"
+
+#include "include/compat.h"
+
+CLS_VER(1,0)
+CLS_NAME(select)
+
+/* one call reads at most this much, callers split larger ranges */
+static const uint64_t MAX_SELECT_LEN = 64 << 20;
+
+static int cls_select_csv(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  bufferlist::iterator in_iter = in->begin();
+
+  cls_select_csv_op op;
+  try {
+    ::decode(op, in_iter);
+  } catch (buffer::error& err) {
+    CLS_LOG(1, "ERROR: cls_select_csv(): failed to decode op");
+    return -EINVAL;
+  }
+
+  uint64_t len = op.len;
+  if (len == 0) {
+    uint64_t size;
+    int r = cls_cxx_stat(hctx, &size, NULL);
+    if (r < 0) {
+      return r;
+    }
+    len = (size > op.ofs ? size - op.ofs : 0);
+  }
+  if (len > MAX_SELECT_LEN) {
+    return -E2BIG;
+  }
+
+  bufferlist bl;
+  int r = cls_cxx_read(hctx, op.ofs, len, &bl);
+  if (r < 0) {
+    return r;
+  }
+
+  cls_select_csv_ret ret;
+  const char *data = bl.c_str();
+  const size_t size = bl.length();
+  const char delim = op.filter.record_delim;
+
+  size_t start = 0;
+  if (op.ofs > 0) {
+    const char *p = (const char *)memchr(data, delim, size);
+    if (!p) {
+      /* no record boundary at all, the caller has to sort it out */
+      ret.head.claim(bl);
+      ::encode(ret, *out);
+      return 0;
+    }
+    start = p - data + 1;
+    ret.head.substr_of(bl, 0, start);
+  }
+
+  while (start < size) {
+    const char *p = (const char *)memchr(data + start, delim, size - start);
+    if (!p) {
+      ret.tail.substr_of(bl, start, size - start);
+      break;
+    }
+    size_t end = p - data;
+    op.filter.apply(data + start, end - start, ret.rows);
+    ret.records++;
+    start = end + 1;
+  }
+
+  ::encode(ret, *out);
+  return 0;
+}
+
+CLS_INIT(select)
+{
+  CLS_LOG(1, "Loaded select class!");
+
+  cls_handle_t h_class;
+  cls_method_handle_t h_select_csv;
+
+  cls_register("select", &h_class);
+
+  cls_register_cxx_method(h_class, "csv", CLS_METHOD_RD, cls_select_csv, &h_select_csv);
+
+  return;
+}
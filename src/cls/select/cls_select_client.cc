@@ -0,0 +1,56 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <errno.h>
+
+#include "cls/select/cls_select_client.h"
+#include "include/compat.h"
+
+class SelectCSVCtx : public librados::ObjectOperationCompletion {
+  cls_select_csv_ret *ret;
+  int *prval;
+public:
+  SelectCSVCtx(cls_select_csv_ret *_ret, int *_prval) : ret(_ret), prval(_prval) {}
+  void handle_completion(int r, bufferlist& outbl) override {
+    if (r >= 0) {
+      try {
+        bufferlist::iterator iter = outbl.begin();
+        ::decode(*ret, iter);
+      } catch (buffer::error& err) {
+        r = -EIO;
+      }
+    }
+    if (prval) {
+      *prval = r;
+    }
+  }
+};
+
+void cls_select_csv(librados::ObjectReadOperation& op, uint64_t ofs, uint64_t len,
+                    const cls_select_csv_filter& filter,
+                    cls_select_csv_ret *ret, int *prval)
+{
+  bufferlist in;
+  cls_select_csv_op call;
+  call.ofs = ofs;
+  call.len = len;
+  call.filter = filter;
+  ::encode(call, in);
+  op.exec("select", "csv", in, new SelectCSVCtx(ret, prval));
+}
+
+int cls_select_csv(librados::IoCtx& io_ctx, const string& oid,
+                   uint64_t ofs, uint64_t len,
+                   const cls_select_csv_filter& filter,
+                   cls_select_csv_ret *ret)
+{
+  librados::ObjectReadOperation op;
+  int rval = 0;
+  cls_select_csv(op, ofs, len, filter, ret, &rval);
+
+  int r = io_ctx.operate(oid, &op, NULL);
+  if (r < 0) {
+    return r;
+  }
+  return rval;
+}
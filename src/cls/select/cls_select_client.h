@@ -0,0 +1,23 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_CLS_SELECT_CLIENT_H
+#define CEPH_CLS_SELECT_CLIENT_H
+
+#include "include/rados/librados.hpp"
+#include "cls_select_ops.h"
+
+/*
+ * filter the records in [ofs, ofs + len) of an object, see
+ * cls_select_csv_ret for how records crossing the range edges come back
+ */
+void cls_select_csv(librados::ObjectReadOperation& op, uint64_t ofs, uint64_t len,
+                    const cls_select_csv_filter& filter,
+                    cls_select_csv_ret *ret, int *prval);
+
+int cls_select_csv(librados::IoCtx& io_ctx, const string& oid,
+                   uint64_t ofs, uint64_t len,
+                   const cls_select_csv_filter& filter,
+                   cls_select_csv_ret *ret);
+
+#endif
@@ -0,0 +1,69 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_CLS_SELECT_OPS_H
+#define CEPH_CLS_SELECT_OPS_H
+
+#include "cls_select_types.h"
+
+struct cls_select_csv_op {
+  uint64_t ofs;
+  uint64_t len; /* 0 reads to the end of the object */
+  cls_select_csv_filter filter;
+
+  cls_select_csv_op() : ofs(0), len(0) {}
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    ::encode(ofs, bl);
+    ::encode(len, bl);
+    ::encode(filter, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::iterator& bl) {
+    DECODE_START(1, bl);
+    ::decode(ofs, bl);
+    ::decode(len, bl);
+    ::decode(filter, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(cls_select_csv_op)
+
+/*
+ * A range of an object rarely starts and ends on record boundaries. For a
+ * range that doesn't start at offset 0, @head holds the bytes up to and
+ * including the first record delimiter, and @tail holds whatever follows
+ * the last one. The caller joins the tail of one range with the head of
+ * the next and filters the record that makes up itself.
+ */
+struct cls_select_csv_ret {
+  bufferlist head;
+  bufferlist rows;
+  bufferlist tail;
+  uint64_t records; /* complete records scanned */
+
+  cls_select_csv_ret() : records(0) {}
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    ::encode(head, bl);
+    ::encode(rows, bl);
+    ::encode(tail, bl);
+    ::encode(records, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::iterator& bl) {
+    DECODE_START(1, bl);
+    ::decode(head, bl);
+    ::decode(rows, bl);
+    ::decode(tail, bl);
+    ::decode(records, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(cls_select_csv_ret)
+
+#endif
@@ -0,0 +1,75 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <stdlib.h>
+
+#include <boost/utility/string_view.hpp>
+
+#include "cls/select/cls_select_types.h"
+
+static bool parse_number(const string& s, double *d)
+{
+  if (s.empty()) {
+    return false;
+  }
+  char *end;
+  *d = strtod(s.c_str(), &end);
+  return *end == '\0';
+}
+
+static int compare_field(const string& field, const string& value)
+{
+  double f, v;
+  if (parse_number(field, &f) && parse_number(value, &v)) {
+    return (f < v ? -1 : (f > v ? 1 : 0));
+  }
+  return field.compare(value);
+}
+
+bool cls_select_csv_filter::apply(const char *rec, size_t len, bufferlist& out) const
+{
+  vector<boost::string_view> fields;
+  size_t start = 0;
+  for (size_t i = 0; i <= len; i++) {
+    if (i == len || rec[i] == field_delim) {
+      fields.push_back(boost::string_view(rec + start, i - start));
+      start = i + 1;
+    }
+  }
+
+  if (cmp != CLS_SELECT_CMP_NONE) {
+    if (column < 0 || (size_t)column >= fields.size()) {
+      return false;
+    }
+    int r = compare_field(fields[column].to_string(), value);
+    bool match;
+    switch (cmp) {
+    case CLS_SELECT_CMP_EQ: match = (r == 0); break;
+    case CLS_SELECT_CMP_NE: match = (r != 0); break;
+    case CLS_SELECT_CMP_LT: match = (r < 0); break;
+    case CLS_SELECT_CMP_LE: match = (r <= 0); break;
+    case CLS_SELECT_CMP_GT: match = (r > 0); break;
+    case CLS_SELECT_CMP_GE: match = (r >= 0); break;
+    default: match = false;
+    }
+    if (!match) {
+      return false;
+    }
+  }
+
+  if (projection.empty()) {
+    out.append(rec, len);
+  } else {
+    for (size_t i = 0; i < projection.size(); i++) {
+      if (i > 0) {
+        out.append(field_delim);
+      }
+      int32_t c = projection[i];
+      if (c >= 0 && (size_t)c < fields.size()) {
+        out.append(fields[c].data(), fields[c].size());
+      }
+    }
+  }
+  out.append(record_delim);
+  return true;
+}
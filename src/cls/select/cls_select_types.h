@@ -0,0 +1,65 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_CLS_SELECT_TYPES_H
+#define CEPH_CLS_SELECT_TYPES_H
+
+#include "include/types.h"
+
+enum cls_select_cmp {
+  CLS_SELECT_CMP_NONE = 0, /* every record matches */
+  CLS_SELECT_CMP_EQ   = 1,
+  CLS_SELECT_CMP_NE   = 2,
+  CLS_SELECT_CMP_LT   = 3,
+  CLS_SELECT_CMP_LE   = 4,
+  CLS_SELECT_CMP_GT   = 5,
+  CLS_SELECT_CMP_GE   = 6,
+};
+
+/*
+ * A filter over delimited text records: keep the records whose field
+ * @column compares to @value as @cmp says, and return only the fields
+ * listed in @projection (all of them if it's empty). Fields are compared
+ * as numbers when both sides parse as one, as strings otherwise. Quoted
+ * fields are not understood.
+ */
+struct cls_select_csv_filter {
+  char field_delim;
+  char record_delim;
+  int32_t column;
+  uint8_t cmp;
+  string value;
+  vector<int32_t> projection;
+
+  cls_select_csv_filter()
+    : field_delim(','), record_delim('\n'), column(0), cmp(CLS_SELECT_CMP_NONE) {}
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    ::encode(field_delim, bl);
+    ::encode(record_delim, bl);
+    ::encode(column, bl);
+    ::encode(cmp, bl);
+    ::encode(value, bl);
+    ::encode(projection, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::iterator& bl) {
+    DECODE_START(1, bl);
+    ::decode(field_delim, bl);
+    ::decode(record_delim, bl);
+    ::decode(column, bl);
+    ::decode(cmp, bl);
+    ::decode(value, bl);
+    ::decode(projection, bl);
+    DECODE_FINISH(bl);
+  }
+
+  /* evaluate a single record, without its delimiter; if it matches, append
+   * its projection and a record delimiter to @out and return true */
+  bool apply(const char *rec, size_t len, bufferlist& out) const;
+};
+WRITE_CLASS_ENCODER(cls_select_csv_filter)
+
+#endif
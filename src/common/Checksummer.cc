@@ -0,0 +1,145 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "include/types.h"
+#include "common/Checksummer.h"
+#include "arch/intel.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <string.h>
+#include <smmintrin.h>
+
+// must match xxHash/xxhash.c
+static const uint32_t PRIME32_1 = 2654435761U;
+static const uint32_t PRIME32_2 = 2246822519U;
+static const uint32_t PRIME32_3 = 3266489917U;
+static const uint32_t PRIME32_4 =  668265263U;
+static const uint32_t PRIME32_5 =  374761393U;
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+  return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t read32(const unsigned char *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;   // xxhash reads little endian words, as this does on x86
+}
+
+/// everything XXH32 does after the 16 byte stripes
+static uint32_t xxh32_finish(uint32_t h32, const unsigned char *p,
+			     unsigned left, unsigned length)
+{
+  h32 += length;
+  for (; left >= 4; left -= 4, p += 4) {
+    h32 += read32(p) * PRIME32_3;
+    h32 = rotl32(h32, 17) * PRIME32_4;
+  }
+  for (; left > 0; --left, ++p) {
+    h32 += (*p) * PRIME32_5;
+    h32 = rotl32(h32, 11) * PRIME32_1;
+  }
+  h32 ^= h32 >> 15;
+  h32 *= PRIME32_2;
+  h32 ^= h32 >> 13;
+  h32 *= PRIME32_3;
+  h32 ^= h32 >> 16;
+  return h32;
+}
+
+/*
+ * The four accumulators of xxhash32 take one 32 bit lane each of an
+ * sse register, and four buffers are hashed side by side so that the
+ * latency of the vector multiplies overlaps.
+ */
+__attribute__((target("sse4.1")))
+static inline __m128i xxh32_round(__m128i acc, const unsigned char *p)
+{
+  const __m128i prime1 = _mm_set1_epi32(PRIME32_1);
+  const __m128i prime2 = _mm_set1_epi32(PRIME32_2);
+  __m128i in = _mm_loadu_si128((const __m128i *)p);
+  acc = _mm_add_epi32(acc, _mm_mullo_epi32(in, prime2));
+  acc = _mm_or_si128(_mm_slli_epi32(acc, 13), _mm_srli_epi32(acc, 19));
+  return _mm_mullo_epi32(acc, prime1);
+}
+
+__attribute__((target("sse4.1")))
+static inline uint32_t xxh32_merge(__m128i acc)
+{
+  uint32_t v[4];
+  _mm_storeu_si128((__m128i *)v, acc);
+  return rotl32(v[0], 1) + rotl32(v[1], 7) + rotl32(v[2], 12) +
+    rotl32(v[3], 18);
+}
+
+__attribute__((target("sse4.1")))
+static void xxhash32_multi_sse41(uint32_t seed,
+				 const unsigned char *const *data,
+				 unsigned length, unsigned count, uint32_t *out)
+{
+  const __m128i init = _mm_setr_epi32(seed + PRIME32_1 + PRIME32_2,
+				      seed + PRIME32_2,
+				      seed,
+				      seed - PRIME32_1);
+  unsigned stripes = length / 16;
+  unsigned left = length % 16;
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const unsigned char *p0 = data[i];
+    const unsigned char *p1 = data[i + 1];
+    const unsigned char *p2 = data[i + 2];
+    const unsigned char *p3 = data[i + 3];
+    __m128i a0 = init, a1 = init, a2 = init, a3 = init;
+    for (unsigned s = 0; s < stripes; ++s) {
+      a0 = xxh32_round(a0, p0);
+      a1 = xxh32_round(a1, p1);
+      a2 = xxh32_round(a2, p2);
+      a3 = xxh32_round(a3, p3);
+      p0 += 16;
+      p1 += 16;
+      p2 += 16;
+      p3 += 16;
+    }
+    out[i] = xxh32_finish(xxh32_merge(a0), p0, left, length);
+    out[i + 1] = xxh32_finish(xxh32_merge(a1), p1, left, length);
+    out[i + 2] = xxh32_finish(xxh32_merge(a2), p2, left, length);
+    out[i + 3] = xxh32_finish(xxh32_merge(a3), p3, left, length);
+  }
+  for (; i < count; ++i) {
+    const unsigned char *p = data[i];
+    __m128i a = init;
+    for (unsigned s = 0; s < stripes; ++s, p += 16)
+      a = xxh32_round(a, p);
+    out[i] = xxh32_finish(xxh32_merge(a), p, left, length);
+  }
+}
+#endif
+
+void Checksummer::xxhash32_multi(uint32_t seed,
+				 const unsigned char *const *data,
+				 unsigned length, unsigned count, uint32_t *out)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+  // short inputs never reach the stripe loop
+  if (ceph_arch_intel_sse41 && length >= 16) {
+    xxhash32_multi_sse41(seed, data, length, count, out);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < count; ++i) {
+    out[i] = XXH32(data[i], length, seed);
+  }
+}
+
+void Checksummer::xxhash64_multi(uint64_t seed,
+				 const unsigned char *const *data,
+				 unsigned length, unsigned count, uint64_t *out)
+{
+  // no vector 64 bit multiply before avx-512; this saves the state
+  // setup and copies of the streaming interface still
+  for (unsigned i = 0; i < count; ++i) {
+    out[i] = XXH64(data[i], length, seed);
+  }
+}
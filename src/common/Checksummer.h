@@ -67,6 +67,76 @@ public:
     }
   }
 
+  /// xxhash32 of several buffers of the same length, side by side
+  static void xxhash32_multi(uint32_t seed, const unsigned char *const *data,
+			     unsigned length, unsigned count, uint32_t *out);
+  /// xxhash64 of several buffers of the same length
+  static void xxhash64_multi(uint64_t seed, const unsigned char *const *data,
+			     unsigned length, unsigned count, uint64_t *out);
+
+  /**
+   * Hash consecutive blocks with Multi, batching the ones that are
+   * contiguous in memory; the others go through Alg::calc().
+   */
+  template<class Alg, class Multi>
+  static void multi_blocks(
+    typename Alg::state_t state,
+    typename Alg::init_value_t init_value,
+    size_t len,
+    size_t blocks,
+    bufferlist::const_iterator& p,
+    typename Alg::value_t *pv,
+    Multi multi
+    ) {
+    static const unsigned batch = 16;
+    const unsigned char *data[batch];
+    typename Alg::init_value_t h[batch];
+    unsigned n = 0;
+    auto flush = [&]() {
+      multi(init_value, data, len, n, h);
+      for (unsigned i = 0; i < n; ++i) {
+	*pv++ = h[i];
+      }
+      n = 0;
+    };
+    while (blocks--) {
+      bufferlist::const_iterator q = p;
+      const char *d;
+      if (q.get_ptr_and_advance(len, &d) == len) {
+	p = q;
+	data[n++] = (const unsigned char *)d;
+	if (n == batch)
+	  flush();
+      } else {
+	flush();
+	*pv++ = Alg::calc(state, init_value, len, p);
+      }
+    }
+    flush();
+  }
+
+  /// crc32c of consecutive blocks, interleaved where they are contiguous
+  template<class value_t>
+  static void crc32c_blocks(
+    uint32_t init_value,
+    size_t len,
+    size_t blocks,
+    bufferlist::const_iterator& p,
+    value_t *pv,
+    uint32_t mask
+    ) {
+    static const size_t batch = 64;
+    uint32_t crcs[batch];
+    while (blocks > 0) {
+      size_t n = std::min(blocks, batch);
+      p.crc32c_blocks(len, n, init_value, crcs);
+      for (size_t i = 0; i < n; ++i) {
+	*pv++ = crcs[i] & mask;
+      }
+      blocks -= n;
+    }
+  }
+
   struct crc32c {
     typedef uint32_t init_value_t;
     typedef __le32 value_t;
@@ -86,6 +156,17 @@ public:
       ) {
       return p.crc32c(len, init_value);
     }
+
+    static void calc_blocks(
+      state_t state,
+      init_value_t init_value,
+      size_t len,
+      size_t blocks,
+      bufferlist::const_iterator& p,
+      value_t *pv
+      ) {
+      crc32c_blocks(init_value, len, blocks, p, pv, 0xffffffff);
+    }
   };
 
   struct crc32c_16 {
@@ -107,6 +188,17 @@ public:
       ) {
       return p.crc32c(len, init_value) & 0xffff;
     }
+
+    static void calc_blocks(
+      state_t state,
+      init_value_t init_value,
+      size_t len,
+      size_t blocks,
+      bufferlist::const_iterator& p,
+      value_t *pv
+      ) {
+      crc32c_blocks(init_value, len, blocks, p, pv, 0xffff);
+    }
   };
 
   struct crc32c_8 {
@@ -128,6 +220,17 @@ public:
       ) {
       return p.crc32c(len, init_value) & 0xff;
     }
+
+    static void calc_blocks(
+      state_t state,
+      init_value_t init_value,
+      size_t len,
+      size_t blocks,
+      bufferlist::const_iterator& p,
+      value_t *pv
+      ) {
+      crc32c_blocks(init_value, len, blocks, p, pv, 0xff);
+    }
   };
 
   struct xxhash32 {
@@ -157,6 +260,17 @@ public:
       }
       return XXH32_digest(state);
     }
+
+    static void calc_blocks(
+      state_t state,
+      init_value_t init_value,
+      size_t len,
+      size_t blocks,
+      bufferlist::const_iterator& p,
+      value_t *pv
+      ) {
+      multi_blocks<xxhash32>(state, init_value, len, blocks, p, pv, xxhash32_multi);
+    }
   };
 
   struct xxhash64 {
@@ -186,6 +300,17 @@ public:
       }
       return XXH64_digest(state);
     }
+
+    static void calc_blocks(
+      state_t state,
+      init_value_t init_value,
+      size_t len,
+      size_t blocks,
+      bufferlist::const_iterator& p,
+      value_t *pv
+      ) {
+      multi_blocks<xxhash64>(state, init_value, len, blocks, p, pv, xxhash64_multi);
+    }
   };
 
   template<class Alg>
@@ -221,10 +346,7 @@ public:
     typename Alg::value_t *pv =
       reinterpret_cast<typename Alg::value_t*>(csum_data->c_str());
     pv += offset / csum_block_size;
-    while (blocks--) {
-      *pv = Alg::calc(state, init_value, csum_block_size, p);
-      ++pv;
-    }
+    Alg::calc_blocks(state, init_value, csum_block_size, blocks, p, pv);
     Alg::fini(&state);
     return 0;
   }
@@ -249,18 +371,23 @@ public:
       reinterpret_cast<const typename Alg::value_t*>(csum_data.c_str());
     pv += offset / csum_block_size;
     size_t pos = offset;
+    static const size_t batch = 16;
+    typename Alg::value_t v[batch];
     while (length > 0) {
-      typename Alg::value_t v = Alg::calc(state, -1, csum_block_size, p);
-      if (*pv != v) {
-	if (bad_csum) {
-	  *bad_csum = v;
+      size_t n = std::min(length / csum_block_size, batch);
+      Alg::calc_blocks(state, -1, csum_block_size, n, p, v);
+      for (size_t i = 0; i < n; ++i) {
+	if (*pv != v[i]) {
+	  if (bad_csum) {
+	    *bad_csum = v[i];
+	  }
+	  Alg::fini(&state);
+	  return pos;
 	}
-	Alg::fini(&state);
-	return pos;
+	++pv;
+	pos += csum_block_size;
+	length -= csum_block_size;
       }
-      ++pv;
-      pos += csum_block_size;
-      length -= csum_block_size;
     }
     Alg::fini(&state);
     return -1;  // no errors
@@ -46,12 +46,14 @@ void *Finisher::finisher_thread_entry()
 
   utime_t start;
   uint64_t count = 0;
+  // kept across batches, so that after the swap the queue reuses the
+  // capacity of the previous batch instead of growing from empty again
+  vector<Context*> ls;
   while (!finisher_stop) {
     /// Every time we are woken up, we process the queue until it is empty.
     while (!finisher_queue.empty()) {
       // To reduce lock contention, we swap out the queue to process.
       // This way other threads can submit new contexts to complete while we are working.
-      vector<Context*> ls;
       list<pair<Context*,int> > ls_rval;
       ls.swap(finisher_queue);
       ls_rval.swap(finisher_queue_rval);
@@ -69,7 +69,9 @@ class Finisher {
   /// Add a context to complete, optionally specifying a parameter for the complete function.
   void queue(Context *c, int r = 0) {
     finisher_lock.Lock();
-    if (finisher_queue.empty()) {
+    // a running finisher rechecks the queue before it sleeps, so only
+    // an idle one needs waking
+    if (finisher_queue.empty() && !finisher_running) {
       finisher_cond.Signal();
     }
     if (r) {
@@ -83,7 +85,7 @@ class Finisher {
   }
   void queue(vector<Context*>& ls) {
     finisher_lock.Lock();
-    if (finisher_queue.empty()) {
+    if (finisher_queue.empty() && !finisher_running) {
       finisher_cond.Signal();
     }
     finisher_queue.insert(finisher_queue.end(), ls.begin(), ls.end());
@@ -94,7 +96,7 @@ class Finisher {
   }
   void queue(deque<Context*>& ls) {
     finisher_lock.Lock();
-    if (finisher_queue.empty()) {
+    if (finisher_queue.empty() && !finisher_running) {
       finisher_cond.Signal();
     }
     finisher_queue.insert(finisher_queue.end(), ls.begin(), ls.end());
@@ -105,7 +107,7 @@ class Finisher {
   }
   void queue(list<Context*>& ls) {
     finisher_lock.Lock();
-    if (finisher_queue.empty()) {
+    if (finisher_queue.empty() && !finisher_running) {
       finisher_cond.Signal();
     }
     finisher_queue.insert(finisher_queue.end(), ls.begin(), ls.end());
@@ -35,6 +35,8 @@ enum {
   l_throttle_put,
   l_throttle_put_sum,
   l_throttle_wait,
+  l_throttle_get_contended,
+  l_throttle_put_contended,
   l_throttle_last,
 };
 
@@ -61,6 +63,10 @@ Throttle::Throttle(CephContext *cct, const std::string& n, int64_t m,
     b.add_u64_counter(l_throttle_put, "put", "Puts");
     b.add_u64_counter(l_throttle_put_sum, "put_sum", "Put data");
     b.add_time_avg(l_throttle_wait, "wait", "Waiting latency");
+    b.add_u64_counter(l_throttle_get_contended, "get_contended",
+		      "Gets that had to take the lock");
+    b.add_u64_counter(l_throttle_put_contended, "put_contended",
+		      "Puts that had to wake a waiter");
 
     logger = { b.create_perf_counters(), cct };
     cct->get_perfcounters_collection()->add(logger.get());
@@ -93,7 +99,9 @@ bool Throttle::_wait(int64_t c, UNIQUE_LOCK_T(lock)& l)
   if (_should_wait(c) || !conds.empty()) { // always wait behind other waiters.
     {
       auto cv = conds.emplace(conds.end());
+      ++num_waiters;
       auto w = make_scope_guard([this, cv]() {
+	  --num_waiters;
 	  conds.erase(cv);
 	});
       waited = true;
@@ -137,10 +145,7 @@ int64_t Throttle::take(int64_t c)
   }
   assert(c >= 0);
   ldout(cct, 10) << "take " << c << dendl;
-  {
-    auto l = uniquely_lock(lock);
-    count += c;
-  }
+  count += c;
   if (logger) {
     logger->inc(l_throttle_take);
     logger->inc(l_throttle_take_sum, c);
@@ -161,14 +166,20 @@ bool Throttle::get(int64_t c, int64_t m)
     logger->inc(l_throttle_get_started);
   }
   bool waited = false;
-  {
+  // under budget and nobody queued: no need to lock
+  if (m || num_waiters || !_try_take(c)) {
+    if (logger) {
+      logger->inc(l_throttle_get_contended);
+    }
     auto l = uniquely_lock(lock);
     if (m) {
       assert(m > 0);
       _reset_max(m);
     }
-    waited = _wait(c, l);
-    count += c;
+    // a lock-free get may take the budget we just waited for
+    do {
+      waited = _wait(c, l) || waited;
+    } while (!_try_take(c));
   }
   if (logger) {
     logger->inc(l_throttle_get);
@@ -188,17 +199,15 @@ bool Throttle::get_or_fail(int64_t c)
   }
 
   assert (c >= 0);
-  auto l = uniquely_lock(lock);
-  if (_should_wait(c) || !conds.empty()) {
+  if (num_waiters || !_try_take(c)) {
     ldout(cct, 10) << "get_or_fail " << c << " failed" << dendl;
     if (logger) {
       logger->inc(l_throttle_get_or_fail_fail);
     }
     return false;
   } else {
-    ldout(cct, 10) << "get_or_fail " << c << " success (" << count.load()
-		   << " -> " << (count.load() + c) << ")" << dendl;
-    count += c;
+    ldout(cct, 10) << "get_or_fail " << c << " success (" << count.load() - c
+		   << " -> " << count.load() << ")" << dendl;
     if (logger) {
       logger->inc(l_throttle_get_or_fail_success);
       logger->inc(l_throttle_get);
@@ -218,13 +227,20 @@ int64_t Throttle::put(int64_t c)
   assert(c >= 0);
   ldout(cct, 10) << "put " << c << " (" << count.load() << " -> "
 		 << (count.load()-c) << ")" << dendl;
-  auto l = uniquely_lock(lock);
   if (c) {
-    if (!conds.empty())
-      conds.front().notify_one();
+    unsigned prev = count.fetch_sub(c);
     // if count goes negative, we failed somewhere!
-    assert(static_cast<int64_t>(count) >= c);
-    count -= c;
+    assert(static_cast<int64_t>(prev) >= c);
+    // a waiter bumps num_waiters before checking count under the lock,
+    // so either we see it here or it sees what we put back
+    if (num_waiters) {
+      if (logger) {
+	logger->inc(l_throttle_put_contended);
+      }
+      auto l = uniquely_lock(lock);
+      if (!conds.empty())
+	conds.front().notify_one();
+    }
     if (logger) {
       logger->inc(l_throttle_put);
       logger->inc(l_throttle_put_sum, c);
@@ -31,6 +31,7 @@ class Throttle {
   std::atomic<unsigned> count = { 0 }, max = { 0 };
   std::mutex lock;
   std::list<std::condition_variable> conds;
+  std::atomic<unsigned> num_waiters = { 0 };  ///< conds.size()
   const bool use_perf;
 
 public:
@@ -39,14 +40,26 @@ public:
 
 private:
   void _reset_max(int64_t m);
-  bool _should_wait(int64_t c) const {
+  bool _should_wait(int64_t c, int64_t cur) const {
     int64_t m = max;
-    int64_t cur = count;
     return
       m &&
       ((c <= m && cur + c > m) || // normally stay under max
        (c >= m && cur > m));     // except for large c
   }
+  bool _should_wait(int64_t c) const {
+    return _should_wait(c, count);
+  }
+
+  /// take c slots unless we should wait for them, without locking
+  bool _try_take(int64_t c) {
+    unsigned cur = count;
+    do {
+      if (_should_wait(c, cur))
+	return false;
+    } while (!count.compare_exchange_weak(cur, cur + c));
+    return true;
+  }
 
   bool _wait(int64_t c, UNIQUE_LOCK_T(lock)& l);
 
@@ -274,7 +274,7 @@ void OpTracker::unregister_inflight_op(TrackedOp *i)
   }
   i->_unregistered();
 
-  if (!tracking_enabled)
+  if (!tracking_enabled || !_keep_in_history(i))
     delete i;
   else {
     RWLock::RLocker l(lock);
@@ -284,6 +284,16 @@ void OpTracker::unregister_inflight_op(TrackedOp *i)
   }
 }
 
+bool OpTracker::_keep_in_history(TrackedOp *i)
+{
+  if (!i->lite)
+    return true;
+  if (i->get_duration() >= history.get_slow_op_threshold())
+    return true;
+  uint32_t rate = lite_sample_rate;
+  return rate && i->seq % rate == 0;
+}
+
 bool OpTracker::check_ops_in_flight(std::vector<string> &warning_vector, int *slow)
 {
   if (!tracking_enabled)
@@ -422,7 +432,14 @@ void TrackedOp::mark_event(const char *event, utime_t stamp)
   if (!state)
     return;
 
-  {
+  if (lite) {
+    uint32_t n = num_lite_events.fetch_add(1, std::memory_order_relaxed);
+    if (n < OPTRACKER_PREALLOC_EVENTS) {
+      lite_events[n].stamp = stamp;
+      lite_events[n].name.store(event, std::memory_order_release);
+    }
+    current = event;
+  } else {
     Mutex::Locker l(lock);
     events.push_back(Event(stamp, event));
     current = event;
@@ -435,6 +452,37 @@ void TrackedOp::mark_event(const char *event, utime_t stamp)
   _event_marked();
 }
 
+void TrackedOp::dump_events(Formatter *f) const
+{
+  f->open_array_section("events");
+  Mutex::Locker l(lock);
+  if (lite) {
+    // string events of a lite op still go to the events list
+    vector<Event> all(events.begin(), events.end());
+    uint32_t n = std::min<uint32_t>(num_lite_events, OPTRACKER_PREALLOC_EVENTS);
+    for (uint32_t i = 0; i < n; ++i) {
+      const char *name = lite_events[i].name.load(std::memory_order_acquire);
+      if (name)
+	all.push_back(Event(lite_events[i].stamp, name));
+    }
+    std::stable_sort(all.begin(), all.end(),
+		     [](const Event& a, const Event& b) {
+		       return a.stamp < b.stamp;
+		     });
+    for (auto& i : all) {
+      f->dump_object("event", i);
+    }
+    if (num_lite_events > OPTRACKER_PREALLOC_EVENTS)
+      f->dump_unsigned("dropped_events",
+		       num_lite_events - OPTRACKER_PREALLOC_EVENTS);
+  } else {
+    for (auto& i : events) {
+      f->dump_object("event", i);
+    }
+  }
+  f->close_section();
+}
+
 void TrackedOp::dump(utime_t now, Formatter *f) const
 {
   // Ignore if still in the constructor
@@ -58,6 +58,9 @@ public:
     history_slow_op_size = new_size;
     history_slow_op_threshold = new_threshold;
   }
+  uint32_t get_slow_op_threshold() const {
+    return history_slow_op_threshold;
+  }
 };
 
 struct ShardedTrackingData;
@@ -70,8 +73,12 @@ class OpTracker {
   float complaint_time;
   int log_threshold;
   std::atomic<bool> tracking_enabled;
+  std::atomic<bool> lite_enabled = { false };
+  std::atomic<uint32_t> lite_sample_rate = { 0 };
   RWLock       lock;
 
+  bool _keep_in_history(TrackedOp *i);
+
 public:
   CephContext *cct;
   OpTracker(CephContext *cct_, bool tracking, uint32_t num_shards);
@@ -92,6 +99,19 @@ public:
   void set_tracking(bool enable) {
     tracking_enabled = enable;
   }
+  /**
+   * In lite mode ops record their events in a fixed-size array, without
+   * taking the op lock or allocating, and only the ops slower than the
+   * slow op threshold, plus one in every sample_rate ops (none if 0),
+   * are kept in the history once done.
+   */
+  void set_lite(bool enable, uint32_t sample_rate) {
+    lite_sample_rate = sample_rate;
+    lite_enabled = enable;
+  }
+  bool is_lite() const {
+    return lite_enabled;
+  }
   bool dump_ops_in_flight(Formatter *f, bool print_only_blocked = false, set<string> filters = {""});
   bool dump_historic_ops(Formatter *f, bool by_duration = false, set<string> filters = {""});
   bool dump_historic_slow_ops(Formatter *f, set<string> filters = {""});
@@ -185,6 +205,16 @@ protected:
 
   vector<Event> events;    ///< list of events and their times
   mutable Mutex lock = {"TrackedOp::lock"}; ///< to protect the events list
+
+  /// events of a lite op, see OpTracker::set_lite()
+  struct LiteEvent {
+    utime_t stamp;
+    std::atomic<const char *> name = { nullptr };  ///< set once stamp is
+  };
+  LiteEvent lite_events[OPTRACKER_PREALLOC_EVENTS];
+  std::atomic<uint32_t> num_lite_events = { 0 };  ///< may exceed the array
+  std::atomic<double> lite_duration = { 0 };      ///< set when done
+  bool lite = false;       ///< set by tracking_start()
   const char *current = 0; ///< the current state the event is in
   uint64_t seq = 0;        ///< a unique value set by the OpTracker
 
@@ -205,7 +235,8 @@ protected:
     tracker(_tracker),
     initiated_at(initiated)
   {
-    events.reserve(OPTRACKER_PREALLOC_EVENTS);
+    if (!tracker->is_lite())
+      events.reserve(OPTRACKER_PREALLOC_EVENTS);
   }
 
   /// output any type-specific data you want to get when dump() is called
@@ -219,6 +250,9 @@ protected:
 
   virtual bool filter_out(const set<string>& filters) { return true; }
 
+  /// dump the events section, for use by _dump()
+  void dump_events(Formatter *f) const;
+
 public:
   ZTracer::Trace osd_trace;
   ZTracer::Trace pg_trace;
@@ -239,7 +273,12 @@ public:
 	break;
 
       case STATE_LIVE:
-	mark_event("done");
+	{
+	  utime_t now = ceph_clock_now();
+	  mark_event("done", now);
+	  if (lite)
+	    lite_duration = now - get_initiated();
+	}
 	tracker->unregister_inflight_op(this);
 	break;
 
@@ -278,6 +317,10 @@ public:
   }
 
   double get_duration() const {
+    if (lite) {
+      double d = lite_duration;
+      return d > 0 ? d : (double)(ceph_clock_now() - get_initiated());
+    }
     Mutex::Locker l(lock);
     if (!events.empty() && events.rbegin()->compare("done") == 0)
       return events.rbegin()->stamp - get_initiated();
@@ -291,6 +334,8 @@ public:
 		  utime_t stamp=ceph_clock_now());
 
   virtual const char *state_string() const {
+    if (lite)
+      return current;
     Mutex::Locker l(lock);
     return events.rbegin()->c_str();
   }
@@ -299,7 +344,15 @@ public:
 
   void tracking_start() {
     if (tracker->register_inflight_op(this)) {
-      events.push_back(Event(initiated_at, "initiated"));
+      lite = tracker->is_lite();
+      if (lite) {
+	lite_events[0].stamp = initiated_at;
+	lite_events[0].name = "initiated";
+	num_lite_events = 1;
+	current = "initiated";
+      } else {
+	events.push_back(Event(initiated_at, "initiated"));
+      }
       state = STATE_LIVE;
     }
   }
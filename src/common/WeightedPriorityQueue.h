@@ -17,6 +17,8 @@
 
 #include "OpQueue.h"
 
+#include <random>
+
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/rbtree.hpp>
 #include <boost/intrusive/avl_set.hpp>
@@ -123,11 +125,21 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
           next = klasses.begin();
         }
       }
+      // the klass of the last insert, ops of a klass tend to come in
+      // bursts and this saves the tree lookup for them
+      Klass *last;
+      Kit erase(Kit i) {
+        if (&*i == last) {
+          last = nullptr;
+        }
+        return klasses.erase_and_dispose(i, DelItem<Klass>());
+      }
       public:
 	unsigned key;	// priority
         Klasses klasses;
 	Kit next;
 	SubQueue(unsigned& p) :
+	  last(nullptr),
 	  key(p),
 	  next(klasses.begin())
 	  {}
@@ -141,14 +153,17 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
         return klasses.empty();
       }
       void insert(K cl, unsigned cost, T&& item, bool front = false) {
-        typename Klasses::insert_commit_data insert_data;
-      	std::pair<Kit, bool> ret =
-          klasses.insert_unique_check(cl, MapKey<Klass, K>(), insert_data);
-      	if (ret.second) {
-      	  ret.first = klasses.insert_unique_commit(*new Klass(cl), insert_data);
-          check_end();
-	}
-	ret.first->insert(cost, std::move(item), front);
+        if (!last || cl < last->key || last->key < cl) {
+          typename Klasses::insert_commit_data insert_data;
+          std::pair<Kit, bool> ret =
+            klasses.insert_unique_check(cl, MapKey<Klass, K>(), insert_data);
+          if (ret.second) {
+            ret.first = klasses.insert_unique_commit(*new Klass(cl), insert_data);
+            check_end();
+          }
+          last = &*ret.first;
+        }
+        last->insert(cost, std::move(item), front);
       }
       unsigned get_cost() const {
         assert(!empty());
@@ -157,7 +172,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
       T pop() {
         T ret = next->pop();
         if (next->empty()) {
-          next = klasses.erase_and_dispose(next, DelItem<Klass>());
+          next = erase(next);
         } else {
 	  ++next;
 	}
@@ -169,7 +184,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
         Kit i = klasses.find(cl, MapKey<Klass, K>());
         if (i != klasses.end()) {
           count = i->filter_class(out);
-	  Kit tmp = klasses.erase_and_dispose(i, DelItem<Klass>());
+	  Kit tmp = erase(i);
 	  if (next == i) {
             next = tmp;
           }
@@ -188,27 +203,47 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
       typedef bi::rbtree<SubQueue> SubQueues;
       typedef typename SubQueues::iterator Sit;
       SubQueues queues;
+      // op priorities fit in a byte, so the subqueues of those are
+      // found by index; the tree keeps them in order for pop
+      static const unsigned num_direct = 256;
+      SubQueue *direct[num_direct];
       unsigned total_prio;
       unsigned max_cost;
+      std::minstd_rand rng;
+      Sit erase(Sit i) {
+        if (i->key < num_direct) {
+          direct[i->key] = nullptr;
+        }
+        return queues.erase_and_dispose(i, DelItem<SubQueue>());
+      }
       public:
 	unsigned size;
 	Queue() :
+	  direct(),
 	  total_prio(0),
 	  max_cost(0),
+	  rng(time(0)),
 	  size(0)
 	  {}
 	bool empty() const {
 	  return !size;
 	}
 	void insert(unsigned p, K cl, unsigned cost, T&& item, bool front = false) {
-	  typename SubQueues::insert_commit_data insert_data;
-      	  std::pair<typename SubQueues::iterator, bool> ret =
-      	    queues.insert_unique_check(p, MapKey<SubQueue, unsigned>(), insert_data);
-      	  if (ret.second) {
-      	    ret.first = queues.insert_unique_commit(*new SubQueue(p), insert_data);
-	    total_prio += p;
-      	  }
-	  ret.first->insert(cl, cost, std::move(item), front);
+	  SubQueue *sq = p < num_direct ? direct[p] : nullptr;
+	  if (!sq) {
+	    typename SubQueues::insert_commit_data insert_data;
+	    std::pair<typename SubQueues::iterator, bool> ret =
+	      queues.insert_unique_check(p, MapKey<SubQueue, unsigned>(), insert_data);
+	    if (ret.second) {
+	      ret.first = queues.insert_unique_commit(*new SubQueue(p), insert_data);
+	      total_prio += p;
+	    }
+	    sq = &*ret.first;
+	    if (p < num_direct) {
+	      direct[p] = sq;
+	    }
+	  }
+	  sq->insert(cl, cost, std::move(item), front);
 	  if (cost > max_cost) {
 	    max_cost = cost;
 	  }
@@ -220,14 +255,14 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
 	  if (strict) {
 	    T ret = i->pop();
 	    if (i->empty()) {
-	      queues.erase_and_dispose(i, DelItem<SubQueue>());
+	      erase(i);
 	    }
 	    return ret;
 	  }
 	  if (queues.size() > 1) {
 	    while (true) {
 	      // Pick a new priority out of the total priority.
-	      unsigned prio = rand() % total_prio + 1;
+	      unsigned prio = rng() % total_prio + 1;
 	      unsigned tp = total_prio - i->key;
 	      // Find the priority coresponding to the picked number.
 	      // Subtract high priorities to low priorities until the picked number
@@ -242,7 +277,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
 	      // The next op's cost is multiplied by .9 and subtracted from the
 	      // max cost seen. Ops with lower costs will have a larger value
 	      // and allow them to be selected easier than ops with high costs.
-	      if (max_cost == 0 || rand() % max_cost <=
+	      if (max_cost == 0 || rng() % max_cost <=
 		  (max_cost - ((i->get_cost() * 9) / 10))) {
 		break;
 	      }
@@ -252,7 +287,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
 	  T ret = i->pop();
 	  if (i->empty()) {
 	    total_prio -= i->key;
-	    queues.erase_and_dispose(i, DelItem<SubQueue>());
+	    erase(i);
 	  }
 	  return ret;
 	}
@@ -261,7 +296,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
 	    size -= i->filter_class(cl, out);
 	    if (i->empty()) {
 	      total_prio -= i->key;
-	      i = queues.erase_and_dispose(i, DelItem<SubQueue>());
+	      i = erase(i);
 	    } else {
 	      ++i;
 	    }
@@ -286,9 +321,7 @@ class WeightedPriorityQueue :  public OpQueue <T, K>
     WeightedPriorityQueue(unsigned max_per, unsigned min_c) :
       strict(),
       normal()
-      {
-	std::srand(time(0));
-      }
+      {}
     unsigned length() const final {
       return strict.size + normal.size;
     }
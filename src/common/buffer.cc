@@ -274,8 +274,39 @@ public:
    * with the data buffer.  the data goes at the beginning, and
    * raw_combined at the end.
    */
+  /*
+   * Freed append buffers (raw_combined of CEPH_BUFFER_ALLOC_UNIT bytes
+   * with the default alignment), kept per thread for the next encode()
+   * instead of going back to the allocator.  This is plain data so
+   * that it stays usable while other thread_locals are torn down; the
+   * reaper empties it when the thread exits.
+   */
+  namespace {
+  struct raw_combined_cache_t {
+    static const unsigned max = 16;
+    char *blocks[max];
+    unsigned count;
+    bool closed;
+  };
+  thread_local raw_combined_cache_t raw_combined_cache;
+
+  struct raw_combined_cache_reaper_t {
+    bool armed = false;
+    ~raw_combined_cache_reaper_t() {
+      while (raw_combined_cache.count)
+	::free(raw_combined_cache.blocks[--raw_combined_cache.count]);
+      raw_combined_cache.closed = true;
+    }
+  };
+  thread_local raw_combined_cache_reaper_t raw_combined_cache_reaper;
+  }
+
   class buffer::raw_combined : public buffer::raw {
     size_t alignment;
+
+    static bool is_cacheable(size_t size, unsigned align) {
+      return size == CEPH_BUFFER_ALLOC_UNIT && align == sizeof(size_t);
+    }
   public:
     raw_combined(char *dataptr, unsigned l, unsigned align,
 		 int mempool)
@@ -300,6 +331,11 @@ public:
 				  alignof(buffer::raw_combined));
       size_t datalen = ROUND_UP_TO(len, alignof(buffer::raw_combined));
 
+      if (is_cacheable(rawlen + datalen, align) && raw_combined_cache.count) {
+	char *ptr = raw_combined_cache.blocks[--raw_combined_cache.count];
+	return new (ptr + datalen) raw_combined(ptr, len, align, mempool);
+      }
+
 #ifdef DARWIN
       char *ptr = (char *) valloc(rawlen + datalen);
 #else
@@ -318,6 +354,16 @@ public:
 
     static void operator delete(void *ptr) {
       raw_combined *raw = (raw_combined *)ptr;
+      size_t rawlen = ROUND_UP_TO(sizeof(buffer::raw_combined),
+				  alignof(buffer::raw_combined));
+      size_t size = (char *)ptr - raw->data + rawlen;
+      raw_combined_cache_t& cache = raw_combined_cache;
+      if (is_cacheable(size, raw->alignment) && !cache.closed &&
+	  cache.count < raw_combined_cache_t::max) {
+	raw_combined_cache_reaper.armed = true;
+	cache.blocks[cache.count++] = raw->data;
+	return;
+      }
       ::free((void *)raw->data);
     }
   };
@@ -1379,6 +1425,40 @@ public:
     return crc;
   }
 
+  template<bool is_const>
+  void buffer::list::iterator_impl<is_const>::crc32c_blocks(
+    size_t block_size, size_t blocks, uint32_t crc, uint32_t *crcs)
+  {
+    static const unsigned batch = 16;
+    unsigned char const *data[batch];
+    while (blocks > 0) {
+      if (p == ls->end())
+	seek(off);
+      size_t n = 0;
+      if (p != ls->end())
+	n = MIN((p->length() - p_off) / block_size, blocks);
+      if (n == 0) {
+	// the block spans several buffers (or we ran past the end)
+	*crcs++ = crc32c(block_size, crc);
+	--blocks;
+	continue;
+      }
+      // the next n blocks are contiguous
+      const unsigned char *start = (const unsigned char *)p->c_str() + p_off;
+      while (n > 0) {
+	unsigned m = MIN(n, (size_t)batch);
+	for (unsigned i = 0; i < m; ++i)
+	  data[i] = start + i * block_size;
+	ceph_crc32c_multi(crc, data, block_size, m, crcs);
+	crcs += m;
+	start += m * block_size;
+	advance(m * block_size);
+	n -= m;
+	blocks -= m;
+      }
+    }
+  }
+
   // explicitly instantiate only the iterator types we need, so we can hide the
   // details in this compilation unit without introducing unnecessary link time
   // dependencies.
@@ -389,6 +389,24 @@ void CephContext::do_command(std::string command, cmdmap_t& cmdmap,
     cmd_getval(this, cmdmap, "counter", counter);
     _perf_counters_collection->dump_formatted(f, false, logger, counter);
   }
+  else if (command == "perf dump binary") {
+    // skip the formatter entirely; the caller gets the packed values
+    std::string logger;
+    cmd_getval(this, cmdmap, "logger", logger);
+    _perf_counters_collection->dump_binary(out, logger);
+    delete f;
+    lgeneric_dout(this, 1) << "do_command '" << command << "' '" << ss.str()
+			   << "result is " << out->length() << " bytes" << dendl;
+    return;
+  }
+  else if (command == "perf schema id") {
+    std::string logger;
+    cmd_getval(this, cmdmap, "logger", logger);
+    f->open_object_section("perf_schema");
+    f->dump_unsigned("schema_id",
+		     _perf_counters_collection->get_schema_id(logger));
+    f->close_section();
+  }
   else if (command == "perfcounters_schema" || command == "2" ||
     command == "perf schema") {
     _perf_counters_collection->dump_formatted(f, true);
@@ -610,6 +628,8 @@ CephContext::CephContext(uint32_t module_type_,
   _admin_socket->register_command("perfcounters_dump", "perfcounters_dump", _admin_hook, "");
   _admin_socket->register_command("1", "1", _admin_hook, "");
   _admin_socket->register_command("perf dump", "perf dump name=logger,type=CephString,req=false name=counter,type=CephString,req=false", _admin_hook, "dump perfcounters value");
+  _admin_socket->register_command("perf dump binary", "perf dump binary name=logger,type=CephString,req=false", _admin_hook, "dump perfcounters values packed as binary");
+  _admin_socket->register_command("perf schema id", "perf schema id name=logger,type=CephString,req=false", _admin_hook, "dump id of the perf dump binary layout");
   _admin_socket->register_command("perfcounters_schema", "perfcounters_schema", _admin_hook, "");
   _admin_socket->register_command("perf histogram dump", "perf histogram dump name=logger,type=CephString,req=false name=counter,type=CephString,req=false", _admin_hook, "dump perf histogram values");
   _admin_socket->register_command("2", "2", _admin_hook, "");
@@ -657,6 +677,8 @@ CephContext::~CephContext()
   _admin_socket->unregister_command("perfcounters_dump");
   _admin_socket->unregister_command("1");
   _admin_socket->unregister_command("perf dump");
+  _admin_socket->unregister_command("perf dump binary");
+  _admin_socket->unregister_command("perf schema id");
   _admin_socket->unregister_command("perfcounters_schema");
   _admin_socket->unregister_command("perf histogram dump");
   _admin_socket->unregister_command("2");
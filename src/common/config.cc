@@ -890,14 +890,22 @@ md_config_t::_get_val_generic(const std::string &key) const
     return empty;
   }
 
+  // ::values has an entry for exactly the keys in the schema, so a single
+  // lookup is enough.  Hot callers pass literal option names, which are
+  // already normalized; only copy and normalize keys that did not match.
+  auto p = values.find(key);
+  if (p != values.end()) {
+    return p->second;
+  }
+
   // In key names, leading and trailing whitespace are not significant.
   string k(ConfFile::normalize_key_name(key));
-
-  const auto &opt_iter = schema.find(k);
-  if (opt_iter != schema.end()) {
-    // Using .at() is safe because all keys in the schema always have
-    // entries in ::values
-    return values.at(k);
+  if (k == key) {
+    return empty;
+  }
+  p = values.find(k);
+  if (p != values.end()) {
+    return p->second;
   } else {
     return empty;
   }
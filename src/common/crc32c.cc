@@ -11,6 +11,11 @@
 #include "common/crc32c_aarch64.h"
 #include "common/crc32c_ppc.h"
 
+#include <string.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#endif
+
 /*
  * choose best implementation based on the CPU architecture.
  */
@@ -236,3 +241,67 @@ uint32_t ceph_crc32c_zeros(uint32_t crc, unsigned len)
     crc = ceph_crc32c(crc, nullptr, remainder);
   return crc;
 }
+
+uint32_t ceph_crc32c_combine(uint32_t crc_a, uint32_t crc_b, unsigned length_b)
+{
+  /* crc32c(a|b, v) = crc32c(b, crc32c(a, v))
+   *                = crc32c(b, 0) ^ crc32c(0*len(b), crc32c(a, v))
+   * as our crc32c is linear in its initial value.
+   */
+  return crc_b ^ ceph_crc32c_zeros(crc_a, length_b);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/*
+ * The crc32 instruction has a latency of 3 cycles but a throughput
+ * of one per cycle, so feeding it three independent streams keeps it
+ * busy where a single stream has to wait for its previous result.
+ */
+__attribute__((target("sse4.2")))
+static void crc32c_multi_sse42(uint32_t crc, unsigned char const *const *data,
+			       unsigned length, unsigned count, uint32_t *out)
+{
+  unsigned i = 0;
+  for (; i + 3 <= count; i += 3) {
+    unsigned char const *p0 = data[i];
+    unsigned char const *p1 = data[i + 1];
+    unsigned char const *p2 = data[i + 2];
+    uint64_t c0 = crc, c1 = crc, c2 = crc;
+    unsigned left = length;
+    for (; left >= 8; left -= 8, p0 += 8, p1 += 8, p2 += 8) {
+      uint64_t w0, w1, w2;
+      memcpy(&w0, p0, 8);
+      memcpy(&w1, p1, 8);
+      memcpy(&w2, p2, 8);
+      c0 = _mm_crc32_u64(c0, w0);
+      c1 = _mm_crc32_u64(c1, w1);
+      c2 = _mm_crc32_u64(c2, w2);
+    }
+    for (; left > 0; --left) {
+      c0 = _mm_crc32_u8(c0, *p0++);
+      c1 = _mm_crc32_u8(c1, *p1++);
+      c2 = _mm_crc32_u8(c2, *p2++);
+    }
+    out[i] = c0;
+    out[i + 1] = c1;
+    out[i + 2] = c2;
+  }
+  for (; i < count; ++i) {
+    out[i] = ceph_crc32c_func(crc, data[i], length);
+  }
+}
+#endif
+
+void ceph_crc32c_multi(uint32_t crc, unsigned char const *const *data,
+		       unsigned length, unsigned count, uint32_t *out)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (ceph_arch_intel_sse42) {
+    crc32c_multi_sse42(crc, data, length, count, out);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < count; ++i) {
+    out[i] = ceph_crc32c_func(crc, data[i], length);
+  }
+}
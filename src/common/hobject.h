@@ -65,6 +65,12 @@ public:
     else
       key = key_;
   }
+  void set_key(std::string &&key_) {
+    if (key_ == oid.name)
+      key.clear();
+    else
+      key = std::move(key_);
+  }
 
   string to_str() const;
   
@@ -162,3 +162,32 @@ bool parse_network(const char *s, struct sockaddr_storage *network, unsigned int
 
   return false;
 }
+
+bool network_contains(const struct sockaddr_storage &network,
+		      unsigned int prefix_len,
+		      const struct sockaddr *addr)
+{
+  if (addr->sa_family != network.ss_family)
+    return false;
+  switch (network.ss_family) {
+  case AF_INET:
+    {
+      struct in_addr want, temp;
+      netmask_ipv4(&((const struct sockaddr_in*)&network)->sin_addr,
+		   prefix_len, &want);
+      netmask_ipv4(&((const struct sockaddr_in*)addr)->sin_addr,
+		   prefix_len, &temp);
+      return temp.s_addr == want.s_addr;
+    }
+  case AF_INET6:
+    {
+      struct in6_addr want, temp;
+      netmask_ipv6(&((const struct sockaddr_in6*)&network)->sin6_addr,
+		   prefix_len, &want);
+      netmask_ipv6(&((const struct sockaddr_in6*)addr)->sin6_addr,
+		   prefix_len, &temp);
+      return IN6_ARE_ADDR_EQUAL(&temp, &want);
+    }
+  }
+  return false;
+}
@@ -93,6 +93,7 @@ OPTION(xio_max_send_inline, OPT_INT) // xio maximum threshold to send inline
 
 OPTION(compressor_zlib_isal, OPT_BOOL)
 OPTION(compressor_zlib_level, OPT_INT) //regular zlib compression level, not applicable to isa-l optimized version
+OPTION(qat_compressor_enabled, OPT_BOOL)
 
 OPTION(async_compressor_enabled, OPT_BOOL)
 OPTION(async_compressor_type, OPT_STR)
@@ -157,14 +158,22 @@ OPTION(ms_async_set_affinity, OPT_BOOL)
 // If ms_async_affinity_cores is empty, all threads will be bind to current running
 // core
 OPTION(ms_async_affinity_cores, OPT_STR)
+OPTION(ms_async_coalesce_max_bytes, OPT_U64)
+OPTION(ms_async_peer_lanes, OPT_U64)
+OPTION(ms_async_zerocopy_send, OPT_BOOL)
+OPTION(ms_async_zerocopy_min_size, OPT_U64)
 OPTION(ms_async_rdma_device_name, OPT_STR)
 OPTION(ms_async_rdma_enable_hugepage, OPT_BOOL)
 OPTION(ms_async_rdma_buffer_size, OPT_INT)
 OPTION(ms_async_rdma_send_buffers, OPT_U32)
 //size of the receive buffer pool, 0 is unlimited
 OPTION(ms_async_rdma_receive_buffers, OPT_U32)
+// release idle rx buffer blocks when the dispatcher goes idle
+OPTION(ms_async_rdma_receive_buffers_shrink, OPT_BOOL)
 // max number of wr in srq
 OPTION(ms_async_rdma_receive_queue_len, OPT_U32)
+// max bytes of a tx chunk sent with IBV_SEND_INLINE
+OPTION(ms_async_rdma_max_inline_data, OPT_U32)
 OPTION(ms_async_rdma_port_num, OPT_U32)
 OPTION(ms_async_rdma_polling_us, OPT_U32)
 OPTION(ms_async_rdma_local_gid, OPT_STR)       // GID format: "fe80:0000:0000:0000:7efe:90ff:fe72:6efe", no zero folding
@@ -373,6 +382,7 @@ OPTION(client_metadata, OPT_STR)
 OPTION(client_acl_type, OPT_STR)
 OPTION(client_permissions, OPT_BOOL)
 OPTION(client_dirsize_rbytes, OPT_BOOL)
+OPTION(client_readdir_max_bytes, OPT_U64)  // size of readdir replies to ask for; 0 lets the MDS pick
 
 // note: the max amount of "in flight" dirty data is roughly (max - target)
 OPTION(fuse_use_invalidate_cb, OPT_BOOL) // use fuse 2.8+ invalidate callback to keep page cache consistent
@@ -405,6 +415,12 @@ OPTION(objecter_inject_no_watch_ping, OPT_BOOL)   // suppress watch pings
 OPTION(objecter_retry_writes_after_first_reply, OPT_BOOL)   // ignore the first reply for each write, and resend the osd op instead
 OPTION(objecter_debug_inject_relock_delay, OPT_BOOL)
 OPTION(objecter_mclock_service_tracker, OPT_BOOL)
+OPTION(objecter_pg_mapping_cache, OPT_BOOL)
+OPTION(objecter_adaptive_window, OPT_BOOL)
+OPTION(objecter_adaptive_window_min, OPT_U64)
+OPTION(objecter_adaptive_window_max, OPT_U64)
+OPTION(objecter_adaptive_window_latency_ratio, OPT_DOUBLE)
+OPTION(objecter_op_latency_stages, OPT_BOOL)
 
 // Max number of deletes at once in a single Filer::purge call
 OPTION(filer_max_purge_ops, OPT_U32)
@@ -445,6 +461,8 @@ OPTION(mds_log_pause, OPT_BOOL)
 OPTION(mds_log_skip_corrupt_events, OPT_BOOL)
 OPTION(mds_log_max_events, OPT_INT)
 OPTION(mds_log_events_per_segment, OPT_INT)
+OPTION(mds_log_submit_batch, OPT_INT)  // max events journaled per submit thread wakeup
+OPTION(mds_log_replay_batch, OPT_INT)  // max events applied per mds_lock hold during replay
 OPTION(mds_log_segment_size, OPT_INT)  // segment size for mds log, default to default file_layout_t
 OPTION(mds_log_max_segments, OPT_U32)
 OPTION(mds_bal_export_pin, OPT_BOOL)  // allow clients to pin directory trees to ranks
@@ -462,6 +480,7 @@ OPTION(mds_bal_fragment_interval, OPT_INT)      // seconds
 OPTION(mds_bal_fragment_size_max, OPT_INT) // order of magnitude higher than split size
 OPTION(mds_bal_fragment_fast_factor, OPT_FLOAT) // multiple of size_max that triggers immediate split
 OPTION(mds_bal_idle_threshold, OPT_FLOAT)
+OPTION(mds_bal_export_cooldown, OPT_FLOAT)  // seconds before an imported subtree may be rebalanced away
 OPTION(mds_bal_max, OPT_INT)
 OPTION(mds_bal_max_until, OPT_INT)
 OPTION(mds_bal_mode, OPT_INT)
@@ -622,6 +641,8 @@ OPTION(osd_tier_promote_max_bytes_sec, OPT_U64)
 OPTION(osd_objecter_finishers, OPT_INT)
 
 OPTION(osd_map_dedup, OPT_BOOL)
+OPTION(osd_map_share_decoded, OPT_BOOL)
+OPTION(osd_map_mapping_cache, OPT_BOOL)
 OPTION(osd_map_max_advance, OPT_INT) // make this < cache_size!
 OPTION(osd_map_cache_size, OPT_INT)
 OPTION(osd_map_message_max, OPT_INT)  // max maps per MOSDMap message
@@ -646,6 +667,9 @@ OPTION(osd_op_num_threads_per_shard_ssd, OPT_INT)
 OPTION(osd_op_num_shards, OPT_INT)
 OPTION(osd_op_num_shards_hdd, OPT_INT)
 OPTION(osd_op_num_shards_ssd, OPT_INT)
+OPTION(osd_op_batch_max, OPT_U64)
+OPTION(osd_op_batch_max_time, OPT_DOUBLE)
+OPTION(osd_op_batch_store, OPT_BOOL)
 
 // PrioritzedQueue (prio), Weighted Priority Queue (wpq ; default),
 // mclock_opclass, mclock_client, or debug_random. "mclock_opclass"
@@ -681,6 +705,10 @@ OPTION(osd_ignore_stale_divergent_priors, OPT_BOOL) // do not assert on divergen
 // If set to true even after reading enough shards to
 // decode the object, any error will be reported.
 OPTION(osd_read_ec_check_for_errors, OPT_BOOL) // return error if any ec shard has an error
+OPTION(osd_ec_hedged_read, OPT_BOOL)
+OPTION(osd_ec_hedged_read_percentile, OPT_FLOAT)
+OPTION(osd_ec_hedged_read_min_delay, OPT_FLOAT)
+OPTION(osd_ec_read_slow_shard_factor, OPT_FLOAT)
 
 // Only use clone_overlap for recovery if there are fewer than
 // osd_recover_clone_overlap_limit entries in the overlap set
@@ -754,6 +782,7 @@ OPTION(osd_scrub_interval_randomize_ratio, OPT_FLOAT) // randomize the scheduled
 OPTION(osd_scrub_backoff_ratio, OPT_DOUBLE)   // the probability to back off the scheduled scrub
 OPTION(osd_scrub_chunk_min, OPT_INT)
 OPTION(osd_scrub_chunk_max, OPT_INT)
+OPTION(osd_scrub_pipeline, OPT_BOOL)
 OPTION(osd_scrub_sleep, OPT_FLOAT)   // sleep between [deep]scrub ops
 OPTION(osd_scrub_auto_repair, OPT_BOOL)   // whether auto-repair inconsistencies upon deep-scrubbing
 OPTION(osd_scrub_auto_repair_num_errors, OPT_U32)   // only auto-repair when number of errors is below this threshold
@@ -1064,6 +1093,7 @@ OPTION(bluestore_blobid_prealloc, OPT_U64)
 OPTION(bluestore_clone_cow, OPT_BOOL)  // do copy-on-write for clones
 OPTION(bluestore_default_buffered_read, OPT_BOOL)
 OPTION(bluestore_default_buffered_write, OPT_BOOL)
+OPTION(bluestore_cache_decompressed, OPT_BOOL)
 OPTION(bluestore_debug_misc, OPT_BOOL)
 OPTION(bluestore_debug_no_reuse_blocks, OPT_BOOL)
 OPTION(bluestore_debug_small_allocations, OPT_INT)
@@ -1255,6 +1285,8 @@ OPTION(nss_db_path, OPT_STR) // path to nss db
 
 
 OPTION(rgw_max_chunk_size, OPT_INT)
+OPTION(rgw_compression_threads, OPT_INT) // threads compressing put data in parallel, 0 for inline
+OPTION(rgw_compression_split_size, OPT_INT) // block size a put chunk is split into for parallel compression
 OPTION(rgw_put_obj_min_window_size, OPT_INT)
 OPTION(rgw_put_obj_max_window_size, OPT_INT)
 OPTION(rgw_max_put_size, OPT_U64)
@@ -1288,6 +1320,7 @@ OPTION(rgw_data, OPT_STR)
 OPTION(rgw_enable_apis, OPT_STR)
 OPTION(rgw_cache_enabled, OPT_BOOL)   // rgw cache enabled
 OPTION(rgw_cache_lru_size, OPT_INT)   // num of entries in rgw cache
+OPTION(rgw_cache_shards, OPT_INT)   // num of independently locked rgw cache shards
 OPTION(rgw_socket_path, OPT_STR)   // path to unix domain socket, if not specified, rgw will not run as external fcgi
 OPTION(rgw_host, OPT_STR)  // host for radosgw, can be an IP, default is 0.0.0.0
 OPTION(rgw_port, OPT_STR)  // port to listen, format as "8080" "5000", if not specified, rgw will not run external fcgi
@@ -1297,6 +1330,7 @@ OPTION(rgw_content_length_compat, OPT_BOOL) // Check both HTTP_CONTENT_LENGTH an
 OPTION(rgw_lifecycle_work_time, OPT_STR) //job process lc  at 00:00-06:00s
 OPTION(rgw_lc_lock_max_time, OPT_INT)  // total run time for a single lc processor work
 OPTION(rgw_lc_max_objs, OPT_INT)
+OPTION(rgw_lc_max_worker, OPT_INT)  // number of lc worker threads per gateway
 OPTION(rgw_lc_debug_interval, OPT_INT)  // Debug run interval, in seconds
 OPTION(rgw_script_uri, OPT_STR) // alternative value for SCRIPT_URI if not set in request
 OPTION(rgw_request_uri, OPT_STR) // alternative value for REQUEST_URI if not set in request
@@ -1406,6 +1440,9 @@ OPTION(rgw_enable_usage_log, OPT_BOOL) // enable logging bandwidth usage
 OPTION(rgw_ops_log_rados, OPT_BOOL) // whether ops log should go to rados
 OPTION(rgw_ops_log_socket_path, OPT_STR) // path to unix domain socket where ops log can go
 OPTION(rgw_ops_log_data_backlog, OPT_INT) // max data backlog for ops log
+OPTION(rgw_ops_log_flush_interval, OPT_INT) // flush batched rados ops log entries every X seconds
+OPTION(rgw_ops_log_flush_threshold, OPT_INT) // bytes of batched rados ops log entries that trigger a flush
+OPTION(rgw_ops_log_max_pending, OPT_INT) // max bytes of rados ops log entries pending, further ones are dropped
 OPTION(rgw_fcgi_socket_backlog, OPT_INT) // socket  backlog for fcgi
 OPTION(rgw_usage_log_flush_threshold, OPT_INT) // threshold to flush pending log data
 OPTION(rgw_usage_log_tick_interval, OPT_INT) // flush pending log data every X seconds
@@ -1417,12 +1454,15 @@ OPTION(rgw_gc_max_objs, OPT_INT)
 OPTION(rgw_gc_obj_min_wait, OPT_INT)    // wait time before object may be handled by gc
 OPTION(rgw_gc_processor_max_time, OPT_INT)  // total run time for a single gc processor work
 OPTION(rgw_gc_processor_period, OPT_INT)  // gc processor cycle time
+OPTION(rgw_gc_max_concurrent_io, OPT_INT)  // max tail object deletes in flight per gc processor
+OPTION(rgw_s3_signing_key_cache_size, OPT_INT) // derived aws v4 signing keys to cache, 0 to disable
 OPTION(rgw_s3_success_create_obj_status, OPT_INT) // alternative success status response for create-obj (0 - default)
 OPTION(rgw_resolve_cname, OPT_BOOL)  // should rgw try to resolve hostname as a dns cname record
 OPTION(rgw_obj_stripe_size, OPT_INT)
 OPTION(rgw_extended_http_attrs, OPT_STR) // list of extended attrs that can be set on objects (beyond the default)
 OPTION(rgw_exit_timeout_secs, OPT_INT) // how many seconds to wait for process to go down before exiting unconditionally
 OPTION(rgw_get_obj_window_size, OPT_INT) // window size in bytes for single get obj request
+OPTION(rgw_get_obj_max_window_size, OPT_INT) // upper bound the get obj window may grow to
 OPTION(rgw_get_obj_max_req_size, OPT_INT) // max length of a single get obj rados op
 OPTION(rgw_relaxed_s3_bucket_names, OPT_BOOL) // enable relaxed bucket name rules for US region buckets
 OPTION(rgw_defer_to_bucket_acls, OPT_STR) // if the user has bucket perms)
@@ -1443,6 +1483,7 @@ OPTION(rgw_data_log_obj_prefix, OPT_STR) //
 OPTION(rgw_replica_log_obj_prefix, OPT_STR) //
 
 OPTION(rgw_bucket_quota_ttl, OPT_INT) // time for cached bucket stats to be cached within rgw instance
+OPTION(rgw_bucket_quota_stale_grace, OPT_INT) // time past ttl that stats under the soft threshold are served while refreshing
 OPTION(rgw_bucket_quota_soft_threshold, OPT_DOUBLE) // threshold from which we don't rely on cached info for quota decisions
 OPTION(rgw_bucket_quota_cache_size, OPT_INT) // number of entries in bucket quota cache
 OPTION(rgw_bucket_default_quota_max_objects, OPT_INT) // number of objects allowed
@@ -1479,8 +1520,11 @@ OPTION(rgw_num_async_rados_threads, OPT_INT) // num of threads to use for async
 OPTION(rgw_md_notify_interval_msec, OPT_INT) // metadata changes notification interval to followers
 OPTION(rgw_run_sync_thread, OPT_BOOL) // whether radosgw (not radosgw-admin) spawns the sync thread
 OPTION(rgw_sync_lease_period, OPT_INT) // time in second for lease that rgw takes on a specific log (or log shard)
+OPTION(rgw_data_sync_spawn_window, OPT_INT) // bucket shards synced concurrently per data log shard
+OPTION(rgw_bucket_sync_spawn_window, OPT_INT) // objects synced concurrently per bucket shard
 OPTION(rgw_sync_log_trim_interval, OPT_INT) // time in seconds between attempts to trim sync logs
 
+OPTION(rgw_sync_fetch_compressed, OPT_BOOL) // sync compressed objects without decompressing them
 OPTION(rgw_sync_data_inject_err_probability, OPT_DOUBLE) // range [0, 1]
 OPTION(rgw_sync_meta_inject_err_probability, OPT_DOUBLE) // range [0, 1]
 OPTION(rgw_sync_trace_history_size, OPT_INT) // max number of complete sync trace entries to keep
@@ -310,10 +310,18 @@ namespace ceph {
       queue.add_request(std::move(item), cl, cost);
     }
 
-    void enqueue_distributed(K cl, unsigned priority, unsigned cost, T&& item,
-			     const dmc::ReqParams& req_params) {
+    // addl_cost is in the units of the reservation tag (seconds), and
+    // is added to it as is
+    void enqueue_addl_cost(K cl, unsigned priority, double addl_cost,
+			   T&& item) {
       // priority is ignored
-      queue.add_request(std::move(item), cl, req_params, cost);
+      queue.add_request(std::move(item), cl, addl_cost);
+    }
+
+    void enqueue_distributed(K cl, unsigned priority, double addl_cost,
+			     T&& item, const dmc::ReqParams& req_params) {
+      // priority is ignored
+      queue.add_request(std::move(item), cl, req_params, addl_cost);
     }
 
     void enqueue_front(K cl,
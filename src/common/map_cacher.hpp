@@ -59,6 +59,26 @@ public:
     pair<K, V> *next    ///< [out] first key after key
     ) = 0; ///< @return 0 on success, -ENOENT if there is no next
 
+  /// Returns up to max keys after key, in order
+  virtual int get_next_keys(
+    const K &key,                   ///< [in] key after which to start
+    unsigned max,                   ///< [in] max keys to return
+    std::vector<pair<K, V> > *out   ///< [out] keys found
+    ) {
+    K pos = key;
+    while (out->size() < max) {
+      pair<K, V> next;
+      int r = get_next(pos, &next);
+      if (r == -ENOENT)
+	break;
+      if (r < 0)
+	return r;
+      pos = next.first;
+      out->push_back(std::move(next));
+    }
+    return out->empty() ? -ENOENT : 0;
+  } ///< @return 0 on success, -ENOENT if there is no next
+
   virtual ~StoreDriver() {}
 };
 
@@ -120,6 +140,51 @@ public:
     return -EINVAL;
   } ///< @return error value, 0 on success, -ENOENT if no more entries
 
+  /// Fetch up to max key/value pairs after specified key
+  int get_next_keys(
+    K key,                          ///< [in] key after which to start
+    unsigned max,                   ///< [in] max keys to return
+    std::vector<pair<K, V> > *out   ///< [out] keys found, appended
+    ) {
+    unsigned start = out->size();
+    while (out->size() - start < max) {
+      // one store scan per batch, overlaid with the unstable keys
+      std::vector<pair<K, V> > store;
+      unsigned want = max - (out->size() - start);
+      int r = driver->get_next_keys(key, want, &store);
+      if (r < 0 && r != -ENOENT)
+	return r;
+      bool store_done = store.size() < want;
+
+      auto si = store.begin();
+      pair<K, boost::optional<V> > cached;
+      bool got_cached = in_progress.get_next(key, &cached);
+      while (out->size() - start < max) {
+	bool use_store = si != store.end();
+	// past the last store key the store may hold keys we did not read
+	bool use_cached = got_cached &&
+	  (store_done || cached.first <= store.back().first);
+	if (!use_store && !use_cached)
+	  break;
+	if (use_cached && (!use_store || cached.first <= si->first)) {
+	  if (use_store && cached.first == si->first)
+	    ++si;
+	  if (cached.second)
+	    out->push_back(make_pair(cached.first, cached.second.get()));
+	  key = cached.first;
+	  got_cached = in_progress.get_next(key, &cached);
+	} else {
+	  key = si->first;
+	  out->push_back(*si);
+	  ++si;
+	}
+      }
+      if (store_done)
+	break;
+    }
+    return out->size() == start ? -ENOENT : 0;
+  } ///< @return error value, 0 on success, -ENOENT if no more entries
+
   /// Adds operation setting keys to Transaction
   void set_keys(
     const map<K, V> &keys,  ///< [in] keys/values to set
@@ -19,6 +19,8 @@
 // default to debug_mode off
 bool mempool::debug_mode = false;
 
+std::atomic<size_t> mempool::next_shard = {0};
+
 // --------------------------------------------------------------
 
 mempool::pool_t& mempool::get_pool(mempool::pool_index_t ix)
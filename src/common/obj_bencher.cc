@@ -258,6 +258,7 @@ int ObjBencher::aio_bench(
   data.min_latency = 9999.0; // this better be higher than initial latency!
   data.max_latency = 0;
   data.avg_latency = 0;
+  data.latency_hist.clear();
   data.object_contents = contentsChars;
   lock.Unlock();
 
@@ -326,6 +327,91 @@ void _aio_cb(void *cb, void *arg) {
   lc->lock->Unlock();
 }
 
+unsigned bench_latency_histogram::bucket_of(uint64_t us)
+{
+  if (us < (1ull << sub_bits))
+    return us;
+  unsigned msb = 63 - __builtin_clzll(us);
+  if (msb >= max_bits)
+    return bucket_of((1ull << max_bits) - 1);
+  unsigned shift = msb - sub_bits;
+  return ((shift + 1) << sub_bits) +
+    ((us >> shift) & ((1ull << sub_bits) - 1));
+}
+
+uint64_t bench_latency_histogram::bucket_upper(unsigned b)
+{
+  if (b < (1u << sub_bits))
+    return b;
+  unsigned shift = (b >> sub_bits) - 1;
+  uint64_t low = ((1ull << sub_bits) + (b & ((1u << sub_bits) - 1))) << shift;
+  return low + (1ull << shift) - 1;
+}
+
+void bench_latency_histogram::add(double seconds)
+{
+  uint64_t us = seconds > 0 ? (uint64_t)(seconds * 1000000.0) : 0;
+  unsigned b = bucket_of(us);
+  if (b >= counts.size())
+    counts.resize(b + 1);
+  ++counts[b];
+  ++total;
+}
+
+double bench_latency_histogram::percentile(double p) const
+{
+  if (!total)
+    return 0;
+  uint64_t want = std::max<uint64_t>(1, std::ceil(total * p / 100.0));
+  uint64_t seen = 0;
+  for (unsigned b = 0; b < counts.size(); ++b) {
+    seen += counts[b];
+    if (seen >= want)
+      return bucket_upper(b) / 1000000.0;
+  }
+  return bucket_upper(counts.size() - 1) / 1000000.0;
+}
+
+void bench_latency_histogram::dump(Formatter *f) const
+{
+  // the raw buckets, so that the histograms of several clients can
+  // be added up into one
+  f->open_array_section("latency_histogram");
+  for (unsigned b = 0; b < counts.size(); ++b) {
+    if (!counts[b])
+      continue;
+    f->open_object_section("bucket");
+    f->dump_unsigned("upper_us", bucket_upper(b));
+    f->dump_unsigned("count", counts[b]);
+    f->close_section();
+  }
+  f->close_section();
+}
+
+static const double latency_percentiles[] = { 50, 90, 99, 99.9, 99.99 };
+
+void ObjBencher::report_latency_percentiles()
+{
+  if (!formatter) {
+    for (double p : latency_percentiles) {
+      std::ostringstream name;
+      name << "p" << p << " latency(s):";
+      out(cout) << std::left << setw(24) << name.str() << std::right
+		<< data.latency_hist.percentile(p) << std::endl;
+    }
+  } else {
+    formatter->open_object_section("latency_percentiles");
+    for (double p : latency_percentiles) {
+      std::ostringstream name;
+      name << "p" << p;
+      formatter->dump_format(name.str().c_str(), "%f",
+			     data.latency_hist.percentile(p));
+    }
+    formatter->close_section();
+    data.latency_hist.dump(formatter);
+  }
+}
+
 template<class T>
 static T vec_stddev(vector<T>& v)
 {
@@ -501,6 +587,7 @@ int ObjBencher::write_bench(int secondsToRun,
     data.cur_latency = mono_clock::now() - start_times[slot];
     data.history.latency.push_back(data.cur_latency.count());
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if( data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -544,6 +631,7 @@ int ObjBencher::write_bench(int secondsToRun,
     data.cur_latency = mono_clock::now() - start_times[slot];
     data.history.latency.push_back(data.cur_latency.count());
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if (data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -604,6 +692,7 @@ int ObjBencher::write_bench(int secondsToRun,
     formatter->dump_format("max_latency:", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
   }
+  report_latency_percentiles();
   //write object size/number data for read benchmarks
   ::encode(data.object_size, b_write);
   num_objects = (data.finished + writes_per_object - 1) / writes_per_object;
@@ -749,6 +838,7 @@ int ObjBencher::seq_read_bench(int seconds_to_run, int num_objects, int concurre
       goto ERR;
     }
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if (data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -787,6 +877,7 @@ int ObjBencher::seq_read_bench(int seconds_to_run, int num_objects, int concurre
     }
     data.cur_latency = mono_clock::now() - start_times[slot];
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if (data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -847,6 +938,7 @@ int ObjBencher::seq_read_bench(int seconds_to_run, int num_objects, int concurre
     formatter->dump_format("max_latency", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
   }
+  report_latency_percentiles();
 
   completions_done();
 
@@ -871,6 +963,8 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
   std::string newName;
   bufferlist* contents[concurrentios];
   int index[concurrentios];
+  std::vector<bool> writing(concurrentios, false);
+  int writes = 0;
   int errors = 0;
   int r = 0;
   double total_latency = 0;
@@ -886,6 +980,26 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
 
   srand (time(NULL));
 
+  // cumulative popularity of the objects by rank, for zipf_theta
+  std::vector<double> zipf_cdf;
+  if (zipf_theta > 0) {
+    zipf_cdf.resize(num_objects);
+    double sum = 0;
+    for (int i = 0; i < num_objects; ++i) {
+      sum += 1.0 / pow(i + 1, zipf_theta);
+      zipf_cdf[i] = sum;
+    }
+    for (auto& c : zipf_cdf)
+      c /= sum;
+  }
+  auto pick_object = [&]() {
+    if (zipf_cdf.empty())
+      return rand() % num_objects;
+    auto p = std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(),
+			      (double)rand() / RAND_MAX);
+    return std::min<int>(p - zipf_cdf.begin(), num_objects - 1);
+  };
+
   r = completions_init(concurrentios);
   if (r < 0)
     return r;
@@ -967,6 +1081,7 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
     }
 
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if (data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -974,9 +1089,11 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
     ++data.finished;
     data.avg_latency = total_latency / data.finished;
     --data.in_flight;
+    if (writing[slot])
+      ++writes;
     lock.Unlock();
     
-    if (!no_verify) {
+    if (!no_verify && !writing[slot]) {
       snprintf(data.object_contents, data.op_size, "I'm the %16dth op!", current_index);
       if ((cur_contents->length() != data.op_size) || 
           (memcmp(data.object_contents, cur_contents->c_str(), data.op_size) != 0)) {
@@ -985,19 +1102,36 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
       }
     } 
 
-    rand_id = rand() % num_objects;
+    rand_id = pick_object();
     newName = generate_object_name(rand_id / writes_per_object, pid);
     index[slot] = rand_id;
     release_completion(slot);
 
-    // invalidate internal crc cache
-    cur_contents->invalidate_crc();
-
-    //start new read and check data if requested
-    start_times[slot] = mono_clock::now();
-    create_completion(slot, _aio_cb, (void *)&lc);
-    r = aio_read(newName, slot, contents[slot], data.op_size,
-		 data.op_size * (rand_id % writes_per_object));
+    if (write_percent && rand() % 100 < write_percent) {
+      // the same contents the write bench put there, so that later
+      // reads still verify
+      snprintf(data.object_contents, data.op_size, "I'm the %16dth op!", rand_id);
+      cur_contents->clear();
+      cur_contents->append(data.object_contents, data.op_size);
+      start_times[slot] = mono_clock::now();
+      create_completion(slot, _aio_cb, (void *)&lc);
+      r = aio_write(newName, slot, *cur_contents, data.op_size,
+		    data.op_size * (rand_id % writes_per_object));
+      writing[slot] = true;
+    } else {
+      if (writing[slot])
+	cur_contents->clear();
+      else
+	// invalidate internal crc cache
+	cur_contents->invalidate_crc();
+
+      //start new read and check data if requested
+      start_times[slot] = mono_clock::now();
+      create_completion(slot, _aio_cb, (void *)&lc);
+      r = aio_read(newName, slot, contents[slot], data.op_size,
+		   data.op_size * (rand_id % writes_per_object));
+      writing[slot] = false;
+    }
     if (r < 0) {
       goto ERR;
     }
@@ -1022,6 +1156,7 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
     }
     data.cur_latency = mono_clock::now() - start_times[slot];
     total_latency += data.cur_latency.count();
+    data.latency_hist.add(data.cur_latency.count());
     if (data.cur_latency.count() > data.max_latency)
       data.max_latency = data.cur_latency.count();
     if (data.cur_latency.count() < data.min_latency)
@@ -1029,8 +1164,10 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
     ++data.finished;
     data.avg_latency = total_latency / data.finished;
     --data.in_flight;
+    if (writing[slot])
+      ++writes;
     release_completion(slot);
-    if (!no_verify) {
+    if (!no_verify && !writing[slot]) {
       snprintf(data.object_contents, data.op_size, "I'm the %16dth op!", index[slot]);
       lock.Unlock();
       if ((contents[slot]->length() != data.op_size) || 
@@ -1057,7 +1194,10 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
 
   if (!formatter) {
     out(cout) << "Total time run:       " << timePassed.count() << std::endl
-       << "Total reads made:     " << data.finished << std::endl
+       << "Total reads made:     " << data.finished - writes << std::endl;
+    if (write_percent)
+      out(cout) << "Total writes made:    " << writes << std::endl;
+    out(cout)
        << "Read size:            " << data.op_size << std::endl
        << "Object size:          " << data.object_size << std::endl
        << "Bandwidth (MB/sec):   " << setprecision(6) << bandwidth << std::endl
@@ -1070,7 +1210,9 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
        << "Min latency(s):       " << data.min_latency << std::endl;
   } else {
     formatter->dump_format("total_time_run", "%f", timePassed.count());
-    formatter->dump_format("total_reads_made", "%d", data.finished);
+    formatter->dump_format("total_reads_made", "%d", data.finished - writes);
+    if (write_percent)
+      formatter->dump_format("total_writes_made", "%d", writes);
     formatter->dump_format("read_size", "%d", data.op_size);
     formatter->dump_format("object_size", "%d", data.object_size);
     formatter->dump_format("bandwidth", "%f", bandwidth);
@@ -1082,6 +1224,7 @@ int ObjBencher::rand_read_bench(int seconds_to_run, int num_objects, int concurr
     formatter->dump_format("max_latency", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
   }
+  report_latency_percentiles();
   completions_done();
 
   return (errors > 0 ? -EIO : 0);
@@ -35,6 +35,31 @@ struct bench_history {
   vector<long> iops;
 };
 
+/**
+ * Log-linear latency histogram, in the manner of HdrHistogram: below
+ * 2^sub_bits us the buckets are 1us wide, above that every power of
+ * two is split into 2^sub_bits buckets, so a latency is known within
+ * about 3% whatever its magnitude.
+ */
+struct bench_latency_histogram {
+  static const unsigned sub_bits = 5;
+  static const unsigned max_bits = 40;	///< 2^40us is about 12 days
+  vector<uint64_t> counts;
+  uint64_t total = 0;
+
+  void clear() {
+    counts.clear();
+    total = 0;
+  }
+  void add(double seconds);
+  /// upper bound of the latency of p percent of the ops, in seconds
+  double percentile(double p) const;
+  void dump(Formatter *f) const;
+
+  static unsigned bucket_of(uint64_t us);
+  static uint64_t bucket_upper(unsigned b);
+};
+
 struct bench_data {
   bool done; //is the benchmark is done
   uint64_t object_size; //the size of the objects
@@ -50,6 +75,7 @@ struct bench_data {
   struct bench_interval_data idata; // data that is updated by time intervals and not by events
   struct bench_history history; // data history, used to calculate stddev
   std::chrono::duration<double> cur_latency; //latency of last completed transaction - in seconds by default
+  struct bench_latency_histogram latency_hist; // latency of every completed transaction
   mono_time start_time; //start time for benchmark - use the monotonic clock as we'll measure the passage of time
   char *object_contents; //pointer to the contents written to each object
 };
@@ -65,6 +91,8 @@ class ObjBencher {
   bool show_time;
   Formatter *formatter = NULL;
   ostream *outstream = NULL;
+  int write_percent = 0;
+  double zipf_theta = 0;
 public:
   CephContext *cct;
 protected:
@@ -106,6 +134,7 @@ protected:
 
   ostream& out(ostream& os);
   ostream& out(ostream& os, utime_t& t);
+  void report_latency_percentiles();
 public:
   explicit ObjBencher(CephContext *cct_) : show_time(false), cct(cct_), lock("ObjBencher::lock") {}
   virtual ~ObjBencher() {}
@@ -124,6 +153,14 @@ public:
   void set_outstream(ostream& os) {
     outstream = &os;
   }
+  /// share of the rand bench ops that overwrite the object they pick
+  void set_write_percent(int p) {
+    write_percent = p;
+  }
+  /// skew of the objects the rand bench picks, 0 for uniform
+  void set_zipf_theta(double theta) {
+    zipf_theta = theta;
+  }
   int clean_up_slow(const std::string& prefix, int concurrentios);
 };
 
@@ -532,6 +532,13 @@ std::vector<Option> get_global_options() {
     .set_default(5)
     .set_description(""),
 
+    Option("qat_compressor_enabled", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Offload zlib compression to Intel QuickAssist devices")
+    .set_long_description("The output stays readable by the software zlib "
+                          "compressor, which is also used when no device is "
+                          "available.  Requires a build with QATzip."),
+
     Option("async_compressor_enabled", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description(""),
@@ -604,6 +611,11 @@ std::vector<Option> get_global_options() {
     .set_default(true)
     .set_description(""),
 
+    Option("perf_latency_histograms", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Keep a latency histogram for every time average perf counter")
+    .set_long_description("Time average perf counters (op latencies of the OSD, BlueStore, the Objecter, RGW, etc.) also feed a histogram with logarithmic buckets, and report their 50th, 90th, 99th and 99.9th percentiles next to their average in perf dump and to the manager (as <counter>_p99 etc. gauges).  Only applies to perf counters created after it is set.  Each histogram costs 2 KB of memory and an atomic increment per sample."),
+
     Option("ms_type", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("async+posix")
     .set_description("")
@@ -641,6 +653,12 @@ std::vector<Option> get_global_options() {
     .set_default(true)
     .set_description(""),
 
+    Option("ms_crc_data_trusted_networks", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("")
+    .set_description("Networks (CIDR, comma separated) whose links already protect data integrity")
+    .set_long_description("The async messenger neither computes nor verifies the data crc of messages exchanged with peers in these networks, e.g. links protected by IPsec or a NIC that checks integrity end to end.  The header and front crcs are still used.  Peers see the no-crc footer flag, so only the side that lists the network needs to set it.")
+    .add_see_also("ms_crc_data"),
+
     Option("ms_crc_header", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description(""),
@@ -768,6 +786,35 @@ std::vector<Option> get_global_options() {
     .set_default("")
     .set_description(""),
 
+    Option("ms_async_coalesce_max_bytes", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(256_K)
+    .set_description("Coalesce queued outgoing messages into one socket write up to this many bytes")
+    .set_long_description("When several messages are queued on a connection they are encoded back to back and sent with a single sendmsg (with MSG_MORE while more follow) once this many bytes are pending or the queue is empty.  0 sends each message as soon as it is encoded."),
+
+    Option("ms_async_peer_lanes", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min_max(1, 16)
+    .set_description("Number of parallel sessions used to send to a single peer")
+    .set_long_description("Callers that pass an ordering hash (the OSD uses the pg for cluster messages) have their messages striped over this many connections to the peer, each on its own worker thread; messages with the same hash stay on one connection and keep their order.  Every daemon on the network has to understand lanes before this is raised above 1."),
+
+    Option("ms_secure_mode", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Encrypt message payloads on authenticated connections")
+    .set_long_description("Outgoing connections ask the peer to encrypt the front, middle and data segments of every message with AES-GCM under the cephx session key.  Headers, footers and the per-segment tags stay in the clear.  A connection that asked for it is failed if the peer refuses; with no session key (auth none) messages are sent in the clear.")
+    .add_see_also("ms_crc_data"),
+
+    Option("ms_async_zerocopy_send", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Send large payloads with MSG_ZEROCOPY in the posix stack")
+    .set_long_description("Requires Linux 4.14 or later; sockets where SO_ZEROCOPY cannot be enabled keep copying.  Sent buffers stay referenced until the kernel reports their completion.")
+    .add_see_also("ms_async_zerocopy_min_size"),
+
+    Option("ms_async_zerocopy_min_size", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .set_description("Minimum size of a send to use MSG_ZEROCOPY")
+    .set_long_description("Below this the page pinning and completion handling cost more than the copy.")
+    .add_see_also("ms_async_zerocopy_send"),
+
     Option("ms_async_rdma_device_name", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("")
     .set_description(""),
@@ -788,10 +835,21 @@ std::vector<Option> get_global_options() {
     .set_default(32768)
     .set_description(""),
 
+    Option("ms_async_rdma_receive_buffers_shrink", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Release idle rx buffers when the RDMA dispatcher goes idle")
+    .set_long_description("The rx buffer pool grows on demand up to ms_async_rdma_receive_buffers. When set, registered memory blocks whose buffers are all free are deregistered and released before the dispatcher thread sleeps, so a burst does not pin memory forever.")
+    .add_see_also("ms_async_rdma_receive_buffers"),
+
     Option("ms_async_rdma_receive_queue_len", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(4096)
     .set_description(""),
 
+    Option("ms_async_rdma_max_inline_data", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(128)
+    .set_description("Max bytes of a tx chunk sent inline in the work request")
+    .set_long_description("Chunks no larger than this are posted with IBV_SEND_INLINE, so the HCA does not have to DMA them from host memory. The effective limit is whatever the device accepts when creating the queue pair; 0 disables inline sends."),
+
     Option("ms_async_rdma_port_num", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(1)
     .set_description(""),
@@ -1583,6 +1641,38 @@ std::vector<Option> get_global_options() {
     .set_long_description("When using the client-side dmclock qos service in a distributed environment, you must enable mclock service tracker for tracking completed IOs.")
     .add_see_also("osd_op_queue"),
 
+    Option("objecter_pg_mapping_cache", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Cache pg to up/acting mappings for the current osdmap epoch")
+    .set_long_description("Ops to the same pg reuse one CRUSH evaluation until the next osdmap arrives instead of running CRUSH for every op."),
+
+    Option("objecter_adaptive_window", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Limit the ops in flight to each OSD with an adaptive (AIMD) window")
+    .set_long_description("The window grows by one op per window of replies while the smoothed reply latency stays within objecter_adaptive_window_latency_ratio of the lowest latency seen from that OSD, and shrinks by a quarter, at most once per round trip, when it does not or when the OSD sends -EAGAIN or a backoff.  Ops beyond the window wait in the client instead of piling up in the OSD's queues.")
+    .add_see_also("objecter_adaptive_window_min")
+    .add_see_also("objecter_adaptive_window_max"),
+
+    Option("objecter_adaptive_window_min", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(8)
+    .set_description("Smallest per-OSD window of in-flight ops")
+    .add_see_also("objecter_adaptive_window"),
+
+    Option("objecter_adaptive_window_max", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1024)
+    .set_description("Largest (and initial) per-OSD window of in-flight ops")
+    .add_see_also("objecter_adaptive_window"),
+
+    Option("objecter_adaptive_window_latency_ratio", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(4.0)
+    .set_description("Shrink an OSD's window once its smoothed reply latency exceeds this multiple of the lowest latency seen")
+    .add_see_also("objecter_adaptive_window"),
+
+    Option("objecter_op_latency_stages", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Time each op's stages in the client")
+    .set_long_description("Record when each op is submitted, last sent to an OSD and answered, aggregate the stages into the objecter op_submit_latency and op_osd_latency counters and histograms, and hand the per-op breakdown to librados completions (rados_aio_get_latency)."),
+
     Option("filer_max_purge_ops", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(10)
     .set_description("Max in-flight operations for purging a striped range (e.g., MDS journal)"),
@@ -1776,7 +1866,7 @@ std::vector<Option> get_global_options() {
     .set_description("default properties of osd pool create"),
 
     Option("osd_erasure_code_plugins", Option::TYPE_STR, Option::LEVEL_ADVANCED)
-    .set_default("jerasure lrc"
+    .set_default("jerasure lrc clay"
   #ifdef HAVE_BETTER_YASM_ELF64
          " isa"
   #endif
@@ -1844,6 +1934,11 @@ std::vector<Option> get_global_options() {
     .set_default(100000)
     .set_description(""),
 
+    Option("osd_hit_set_sketch_width", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(4096)
+    .set_description("Counters per row of the access frequency sketch the tiering agent estimates object temperature from, 0 to scan the hit sets instead")
+    .set_long_description("The sketch is kept in memory on the primary only. Until it has seen as many accesses as it has counters per row, temperature is estimated from the hit sets."),
+
     Option("osd_hit_set_namespace", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default(".ceph-internal")
     .set_description(""),
@@ -1899,10 +1994,27 @@ std::vector<Option> get_global_options() {
     .set_default(true)
     .set_description(""),
 
+    Option("osd_map_share_decoded", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Build maps from incrementals on top of the cached previous epoch")
+    .set_long_description("When the previous epoch is in the decoded map cache, copy it and apply the incremental in place instead of decoding the full map from disk.  Unchanged parts of the map (addresses, pg_temp, crush, ...) are then shared between epochs.")
+    .add_see_also("osd_map_dedup"),
+
+    Option("osd_map_mapping_cache", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Remember the up/acting mapping of each pg looked up in a cached osdmap")
+    .set_long_description("Each decoded map in the osd map cache memoizes the result of mapping a pg (CRUSH, upmap, primary affinity and pg_temp) the first time it is looked up, so repeated lookups of the same pg in that epoch are a hash lookup.  The number of remembered pgs per map is bounded.")
+    .add_see_also("osd_map_cache_size"),
+
     Option("osd_map_max_advance", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(40)
     .set_description(""),
 
+    Option("osd_memory_target", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Target bytes of mempool-tracked memory for the OSD (0 to disable)")
+    .set_long_description("When the sum of all mempools exceeds this, the OSD shrinks its osdmap caches and returns free heap memory to the system until usage drops below the target."),
+
     Option("osd_map_cache_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(50)
     .set_description(""),
@@ -1975,10 +2087,36 @@ std::vector<Option> get_global_options() {
     .set_default(2)
     .set_description(""),
 
+    Option("osd_numa_node", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(-1)
+    .set_description("Bind the OSD's threads to the CPUs of this NUMA node")
+    .set_long_description("Set to the node local to the OSD's devices and network interface. -1 leaves the OSD unbound."),
+
     Option("osd_op_num_shards", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
 
+    Option("osd_op_batch_max", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(8)
+    .set_description("Max number of queued items for the same PG to run under one PG lock acquisition")
+    .add_see_also("osd_op_batch_max_time"),
+
+    Option("osd_op_batch_max_time", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.005)
+    .set_description("Max seconds an op shard thread keeps running items for one PG before going back to the queue")
+    .add_see_also("osd_op_batch_max"),
+
+    Option("osd_op_batch_store", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Submit the store transactions of client and replica ops batched under one PG lock acquisition together")
+    .set_long_description("Consecutive writes to a PG (e.g. small appends to a hot log object) then share one object store transaction and kv commit instead of paying for one each.  Replies are still sent per op.")
+    .add_see_also("osd_op_batch_max"),
+
+    Option("osd_op_shard_own_pgs", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Attach PGs to their op shard when they are created or loaded")
+    .set_long_description("Each op shard then finds its PGs in its own slot map, so ops do not look them up in the global pg_map (under pg_map_lock) on first use."),
+
     Option("osd_op_num_shards_hdd", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(5)
     .set_description(""),
@@ -1987,6 +2125,12 @@ std::vector<Option> get_global_options() {
     .set_default(8)
     .set_description(""),
 
+    Option("osd_op_shard_affinity", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Pin op shard N's threads to the core of messenger worker N")
+    .set_long_description("Uses the core list in ms_async_affinity_cores, which also pins the async messenger workers, wrapping around for both.  Ops are still routed to shards by PG, so the per-shard cross_core counter reports how many were handed over from another core.")
+    .add_see_also("ms_async_affinity_cores"),
+
     Option("osd_skip_data_digest", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description(""),
@@ -2305,6 +2449,30 @@ std::vector<Option> get_global_options() {
     .add_see_also("osd_op_queue_mclock_scrub_res")
     .add_see_also("osd_op_queue_mclock_scrub_wgt"),
 
+    Option("osd_op_queue_mclock_iops_capacity", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.0)
+    .set_description("small random write iops the osd device sustains")
+    .set_long_description("together with osd_op_queue_mclock_bandwidth_capacity this turns the byte cost of an op into the time it holds the device, so that large ops use up more of the mclock reservation of their class than small ones; 0 measures it when the osd starts if osd_op_queue_mclock_calibrate is set, and otherwise leaves the op cost out of the mclock tags")
+    .add_see_also("osd_op_queue")
+    .add_see_also("osd_op_queue_mclock_bandwidth_capacity")
+    .add_see_also("osd_op_queue_mclock_calibrate"),
+
+    Option("osd_op_queue_mclock_bandwidth_capacity", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("large sequential write bandwidth the osd device sustains, in bytes per second")
+    .set_long_description("see osd_op_queue_mclock_iops_capacity; 0 measures it when the osd starts if osd_op_queue_mclock_calibrate is set, and otherwise leaves the op cost out of the mclock tags")
+    .add_see_also("osd_op_queue")
+    .add_see_also("osd_op_queue_mclock_iops_capacity")
+    .add_see_also("osd_op_queue_mclock_calibrate"),
+
+    Option("osd_op_queue_mclock_calibrate", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("benchmark the object store on start to fill in the mclock capacities left at 0")
+    .set_long_description("only done when osd_op_queue is either 'mclock_opclass' or 'mclock_client'; it writes less than 100MB to the meta collection and removes it afterwards")
+    .add_see_also("osd_op_queue")
+    .add_see_also("osd_op_queue_mclock_iops_capacity")
+    .add_see_also("osd_op_queue_mclock_bandwidth_capacity"),
+
     Option("osd_ignore_stale_divergent_priors", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description(""),
@@ -2313,6 +2481,31 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("osd_ec_hedged_read", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Hedge EC client reads against slow shards")
+    .set_long_description("Read the minimum set of shards, preferring shards with lower recent sub-read latency, and if the read has not completed after osd_ec_hedged_read_percentile of recent sub-read latencies, read the remaining shards too and decode from whichever replies arrive first.  Pools with fast_read set still read all shards up front.")
+    .add_see_also("osd_ec_hedged_read_percentile")
+    .add_see_also("osd_ec_hedged_read_min_delay")
+    .add_see_also("osd_ec_read_slow_shard_factor"),
+
+    Option("osd_ec_hedged_read_percentile", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(95.0)
+    .set_min_max(1.0, 100.0)
+    .set_description("Percentile of recent sub-read latencies to wait before sending hedged EC reads")
+    .add_see_also("osd_ec_hedged_read"),
+
+    Option("osd_ec_hedged_read_min_delay", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.005)
+    .set_description("Minimum delay in seconds before sending hedged EC reads")
+    .add_see_also("osd_ec_hedged_read"),
+
+    Option("osd_ec_read_slow_shard_factor", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(2.0)
+    .set_description("Avoid reading from shards whose average sub-read latency exceeds this multiple of the median")
+    .set_long_description("Only applies when osd_ec_hedged_read is enabled, and only if the remaining shards are still enough to decode.  0 disables latency based shard selection.")
+    .add_see_also("osd_ec_hedged_read"),
+
     Option("osd_recover_clone_overlap_limit", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(10)
     .set_description(""),
@@ -2393,6 +2586,12 @@ std::vector<Option> get_global_options() {
     .set_default(20)
     .set_description(""),
 
+    Option("osd_heartbeat_max_pg_peers", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Maximum number of PG peers to heartbeat with (0 means all)")
+    .set_long_description("When the OSDs we share PGs with exceed this number, a subset is chosen spread across their crush hosts.  Neighbor and random peers are still added up to osd_heartbeat_min_peers.")
+    .add_see_also("osd_heartbeat_min_peers"),
+
     Option("osd_heartbeat_min_peers", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(10)
     .set_description(""),
@@ -2497,6 +2696,18 @@ std::vector<Option> get_global_options() {
     .set_default(10)
     .set_description(""),
 
+    Option("osd_recovery_batch_small_object_size", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .set_description("Objects up to this size (without omap) are recovered in batches")
+    .set_long_description("Replica recovery lets up to osd_recovery_batch_small_objects such objects share a single osd_recovery_max_active slot, so that they are pushed together in one message and applied in one transaction on the replica.  0 disables batching.")
+    .add_see_also("osd_recovery_batch_small_objects"),
+
+    Option("osd_recovery_batch_small_objects", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(32)
+    .set_min(1)
+    .set_description("Number of small objects that share one recovery op slot")
+    .add_see_also("osd_recovery_batch_small_object_size"),
+
     Option("osd_recovery_forget_lost_objects", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description(""),
@@ -2553,6 +2764,12 @@ std::vector<Option> get_global_options() {
     .set_default(25)
     .set_description(""),
 
+    Option("osd_scrub_pipeline", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Request replica scrub maps for the next chunk while comparing the current one")
+    .set_long_description("The next chunk is selected and blocked for writes before the current chunk's maps are compared, so replicas scan it in parallel with the comparison on the primary.")
+    .add_see_also("osd_scrub_chunk_max"),
+
     Option("osd_scrub_sleep", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
@@ -2602,11 +2819,11 @@ std::vector<Option> get_global_options() {
     .set_description(""),
 
     Option("osd_class_load_list", Option::TYPE_STR, Option::LEVEL_ADVANCED)
-    .set_default("cephfs hello journal lock log numops " "rbd refcount replica_log rgw statelog timeindex user version")
+    .set_default("cephfs hello journal lock log numops " "rbd refcount replica_log rgw select statelog timeindex user version")
     .set_description(""),
 
     Option("osd_class_default_list", Option::TYPE_STR, Option::LEVEL_ADVANCED)
-    .set_default("cephfs hello journal lock log numops " "rbd refcount replica_log rgw statelog timeindex user version")
+    .set_default("cephfs hello journal lock log numops " "rbd refcount replica_log rgw select statelog timeindex user version")
     .set_description(""),
 
     Option("osd_check_for_log_corruption", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
@@ -2633,6 +2850,11 @@ std::vector<Option> get_global_options() {
     .set_default(40)
     .set_description(""),
 
+    Option("osd_load_pgs_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(4)
+    .set_description("Number of threads reading PG info and logs at startup")
+    .set_long_description("Each PG's info and log are read from the object store by one of these threads while the OSD starts.  Set to 1 to load PGs one after another."),
+
     Option("osd_min_pg_log_entries", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(1500)
     .set_description("minimum number of entries to maintain in the PG log")
@@ -2777,6 +2999,15 @@ std::vector<Option> get_global_options() {
     .set_default(true)
     .set_description(""),
 
+    Option("osd_op_tracker_lite", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Track ops with fixed-size event arrays and only keep slow or sampled ops in the history")
+    .set_long_description("Ops record their events without locking or allocating.  Once done, an op is kept in the op history only if it took longer than osd_op_history_slow_op_threshold, or if it is sampled (see osd_op_tracker_sample_rate)."),
+
+    Option("osd_op_tracker_sample_rate", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("With osd_op_tracker_lite, keep one in every this many ops in the op history (0 keeps slow ops only)"),
+
     Option("osd_num_op_tracker_shard", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(32)
     .set_description(""),
@@ -2938,6 +3169,11 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("rocksdb_iterator_readahead", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Readahead size for iterators over a single key prefix")
+    .set_long_description("When non-zero, prefix iterators (e.g., omap scans) read this many bytes ahead from SST files, which helps long sequential scans on spinning or network storage.  0 leaves the rocksdb default."),
+
     Option("rocksdb_collect_compaction_stats", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description(""),
@@ -3104,6 +3340,11 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("osdc_blkin_trace_sample_rate", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Start a blkin trace for one in every this many objecter requests, 0 to disable sampling")
+    .set_long_description("The trace id travels in the message header, so the messenger and OSD spans of a sampled request are recorded too. osdc_blkin_trace_all traces every request regardless of this setting."),
+
     Option("osd_discard_disconnected_ops", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description(""),
@@ -3155,6 +3396,19 @@ std::vector<Option> get_global_options() {
     .set_default(16)
     .set_description(""),
 
+    Option("bdev_ioring", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Enables Linux io_uring API instead of libaio")
+    .set_long_description("Falls back to libaio if io_uring is not supported by the build or the running kernel."),
+
+    Option("bdev_ioring_hipri", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Use polled completions (IORING_SETUP_IOPOLL) with io_uring"),
+
+    Option("bdev_ioring_sqthread_poll", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Offload io_uring submission to a kernel thread (IORING_SETUP_SQPOLL)"),
+
     Option("bdev_block_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(4_K)
     .set_description(""),
@@ -3221,7 +3475,13 @@ std::vector<Option> get_global_options() {
 
     Option("bluefs_preextend_wal_files", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
-    .set_description(""),
+    .set_description("Preextend rocksdb WAL files so that appends do not update bluefs metadata")
+    .set_long_description("This requires rocksdb log recycling (recycle_log_file_num) to be enabled, so that stale data past the end of the log is detected on replay."),
+
+    Option("bluefs_wal_prealloc_size", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(64_M)
+    .set_description("Space to preallocate for each rocksdb WAL file when bluefs_preextend_wal_files is enabled")
+    .set_long_description("WAL files are preallocated (or topped up when recycled) to this size when opened, and grown in steps of this size afterwards, so that small synchronous commits only issue a data write and a device flush."),
 
     Option("bluestore_bluefs", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(true)
@@ -3277,7 +3537,7 @@ std::vector<Option> get_global_options() {
 
     Option("bluestore_spdk_io_sleep", Option::TYPE_UINT, Option::LEVEL_DEV)
     .set_default(5)
-    .set_description("Time period to wait if there is no completed I/O from polling"),
+    .set_description("Time period to wait if there is no completed I/O from polling, 0 means busy polling"),
 
     Option("bluestore_block_path", Option::TYPE_STR, Option::LEVEL_DEV)
     .set_default("")
@@ -3431,6 +3691,16 @@ std::vector<Option> get_global_options() {
     .set_safe()
     .set_description(""),
 
+    Option("bluestore_gc_background_bytes_per_sec", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Rate at which partly overwritten compressed blobs are rewritten in the background, 0 to disable")
+    .set_long_description("Objects whose compressed blobs are overwritten without being garbage collected right away are remembered per collection, and rewritten along with a later transaction on the same collection while the store is not busy."),
+
+    Option("bluestore_gc_background_ratio", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(.5)
+    .set_min_max(0.0, 1.0)
+    .set_description("Rewrite compressed blobs in the background once less than this fraction of their data is still referenced"),
+
     Option("bluestore_max_blob_size", Option::TYPE_UINT, Option::LEVEL_DEV)
     .set_default(0)
     .set_safe()
@@ -3468,14 +3738,29 @@ std::vector<Option> get_global_options() {
     .set_default(.2)
     .set_description("Ratio above/below target for a shard when trying to align to an existing extent or blob boundary"),
 
+    Option("bluestore_extent_map_shard_adaptive", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Adjust the shard target size of each object to how many shards its updates dirty")
+    .set_long_description("Objects whose updates keep dirtying a single shard are resharded to smaller shards, those whose updates dirty many shards at once to bigger ones, within bluestore_extent_map_shard_min_size and bluestore_extent_map_shard_max_size."),
+
     Option("bluestore_extent_map_inline_shard_prealloc_size", Option::TYPE_UINT, Option::LEVEL_DEV)
     .set_default(256)
     .set_description("Preallocated buffer for inline shards"),
 
+    Option("bluestore_onode_attr_patch", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Write attr-only onode updates as patches merged into the onode key")
+    .set_long_description("A transaction that changes nothing but the xattrs of an object merges a small patch into its onode instead of rewriting the whole onode. Older versions cannot read onodes with pending patches."),
+
     Option("bluestore_cache_trim_interval", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(.2)
     .set_description("How frequently we trim the bluestore cache"),
 
+    Option("bluestore_cache_trim_max_batch_bytes", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(16_M)
+    .set_description("Max bytes to trim from a cache shard while holding its lock")
+    .set_long_description("Trimming drops the shard lock between batches so lookups are not blocked for the duration of a large trim.  0 trims in one pass."),
+
     Option("bluestore_cache_trim_max_skip_pinned", Option::TYPE_UINT, Option::LEVEL_DEV)
     .set_default(64)
     .set_description("Max pinned cache entries we consider before giving up"),
@@ -3518,6 +3803,23 @@ std::vector<Option> get_global_options() {
     .set_default(512_M)
     .set_description("Max memory (bytes) to devote to kv database (rocksdb)"),
 
+    Option("bluestore_cache_autotune", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Automatically adjust the meta/data/kv cache ratios based on cache misses")
+    .set_long_description("The kv cache only takes part when rocksdb_perf is enabled, since its misses are otherwise not tracked."),
+
+    Option("bluestore_cache_autotune_interval", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(5)
+    .set_description("Seconds between cache ratio adjustments"),
+
+    Option("bluestore_cache_autotune_step", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(.02)
+    .set_description("Fraction of bluestore cache moved between pools per adjustment"),
+
+    Option("bluestore_cache_autotune_min_ratio", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(.01)
+    .set_description("Autotuning never shrinks a cache pool below this ratio"),
+
     Option("bluestore_kvbackend", Option::TYPE_STR, Option::LEVEL_DEV)
     .set_default("rocksdb")
     .add_tag("mkfs")
@@ -3525,7 +3827,7 @@ std::vector<Option> get_global_options() {
 
     Option("bluestore_allocator", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("stupid")
-    .set_enum_allowed({"bitmap", "stupid"})
+    .set_enum_allowed({"bitmap", "stupid", "avl"})
     .set_description("Allocator policy"),
 
     Option("bluestore_freelist_blocks_per_key", Option::TYPE_INT, Option::LEVEL_DEV)
@@ -3550,11 +3852,13 @@ std::vector<Option> get_global_options() {
 
     Option("bluestore_rocksdb_cf", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
-    .set_description("Enable use of rocksdb column families for bluestore metadata"),
+    .set_description("Enable use of rocksdb column families for bluestore metadata")
+    .set_long_description("Only used at mkfs time: the key prefixes listed in bluestore_rocksdb_cfs then get their own column family, so that short-lived deferred writes and churning omap data are flushed and compacted apart from the onodes."),
 
-    Option("bluestore_rocksdb_cfs", Option::TYPE_STR, Option::LEVEL_DEV)
+    Option("bluestore_rocksdb_cfs", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("M= P= L=")
-    .set_description("List of whitespace-separate key/value pairs where key is CF name and value is CF options"),
+    .set_description("List of whitespace-separate key/value pairs where key is CF name and value is CF options")
+    .set_long_description("The CF names are bluestore key prefixes (e.g. M for omap, P for pg metadata omap, L for deferred writes, O for onodes, X for shared blobs).  The options, in rocksdb column family options format with ';' separators, override bluestore_rocksdb_options for that column family; they can be changed on an existing store, the list of column families cannot."),
 
     Option("bluestore_fsck_on_mount", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(false)
@@ -3580,6 +3884,11 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description("Run deep fsck after mkfs"),
 
+    Option("bluestore_fsck_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_description("Number of threads used to check objects during fsck")
+    .set_long_description("Object keys are still walked in order by a single thread; the per-object extent and blob checks and, for a deep fsck, the data reads are spread over this many threads.  Each thread keeps its own used block bitmap, so memory use for it grows with the thread count."),
+
     Option("bluestore_sync_submit_transaction", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(false)
     .set_description("Try to submit metadata transaction to rocksdb in queuing thread context"),
@@ -3625,6 +3934,22 @@ std::vector<Option> get_global_options() {
     .set_safe()
     .set_description("Default bluestore_deferred_batch_ops for non-rotational (solid state) media"),
 
+    Option("bluestore_deferred_batch_bytes", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_safe()
+    .set_description("Max bytes queued in a sequencer's deferred write batch before it is submitted (0 for no limit)"),
+
+    Option("bluestore_max_defer_interval", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(3)
+    .set_safe()
+    .set_description("Max seconds deferred writes may stay queued before they are submitted (0 for no limit)"),
+
+    Option("bluestore_pool_stats", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_safe()
+    .set_description("Account write path statistics per pool")
+    .set_long_description("When enabled, bytes written, deferred and compressed, allocation changes and transaction state latencies are summed per pool and can be read with the dump_objectstore_pool_stats admin socket command."),
+
     Option("bluestore_nid_prealloc", Option::TYPE_INT, Option::LEVEL_DEV)
     .set_default(1024)
     .set_description("Number of unique object ids to preallocate at a time"),
@@ -3643,6 +3968,12 @@ std::vector<Option> get_global_options() {
     .set_safe()
     .set_description("Cache read results by default (unless hinted NOCACHE or WONTNEED)"),
 
+    Option("bluestore_cache_decompressed", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_safe()
+    .set_description("Cache decompressed blob contents even for reads that are not otherwise buffered (unless hinted NOCACHE)")
+    .add_see_also("bluestore_default_buffered_read"),
+
     Option("bluestore_default_buffered_write", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_safe()
@@ -3700,6 +4031,12 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("bluestore_kv_finalize_threads", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min(1)
+    .set_description("Number of threads finalizing committed transactions")
+    .set_long_description("Committed transactions are spread across the finalize threads by sequencer (PG), so per-sequencer ordering is preserved.  Each thread reports its own bluestore_kv_final-N perf counters."),
+
     Option("bluestore_debug_random_read_err", Option::TYPE_FLOAT, Option::LEVEL_DEV)
     .set_default(0)
     .set_description(""),
@@ -3818,6 +4155,12 @@ std::vector<Option> get_global_options() {
     .set_default(5000)
     .set_description("Block writing when this many inodes have outstanding writes (xfs)"),
 
+    Option("filestore_wbthrottle_flushers", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min(1)
+    .set_description("Number of threads syncing writes the wbthrottle flushes")
+    .set_long_description("More than one lets the fdatasyncs of different objects reach the device together, which helps backing devices that serve concurrent syncs, such as raid sets or hdds with a write cache."),
+
     Option("filestore_odsync_write", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(false)
     .set_description("Write with O_DSYNC"),
@@ -4317,6 +4660,18 @@ std::vector<Option> get_rgw_options() {
     .set_default(4_M)
     .set_description(""),
 
+    Option("rgw_compression_threads", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(4)
+    .set_description("Number of threads compressing object data on upload")
+    .set_long_description("Chunks larger than rgw_compression_split_size are split "
+                          "into blocks that are compressed in parallel on this "
+                          "thread pool. 0 compresses every chunk inline on the "
+                          "request thread. Takes effect on restart."),
+
+    Option("rgw_compression_split_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(1_M)
+    .set_description("Size of the blocks a chunk is split into for parallel compression"),
+
     Option("rgw_put_obj_min_window_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(16_M)
     .set_description(""),
@@ -4381,6 +4736,13 @@ std::vector<Option> get_rgw_options() {
     .set_default(10000)
     .set_description(""),
 
+    Option("rgw_cache_shards", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_description("Number of shards of the rgw metadata cache")
+    .set_long_description("Each shard has its own lock and LRU holding its "
+        "share of rgw_cache_lru_size entries, so that concurrent requests for "
+        "different users and buckets don't contend on one cache lock."),
+
     Option("rgw_socket_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("")
     .set_description(""),
@@ -4417,6 +4779,13 @@ std::vector<Option> get_rgw_options() {
     .set_default(32)
     .set_description(""),
 
+    Option("rgw_lc_max_worker", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(3)
+    .set_description("Number of lifecycle worker threads")
+    .set_long_description("Each worker claims buckets from the lifecycle shards "
+                          "independently, so this many buckets are processed in "
+                          "parallel by each gateway."),
+
     Option("rgw_lc_debug_interval", Option::TYPE_INT, Option::LEVEL_DEV)
     .set_default(-1)
     .set_description(""),
@@ -4764,6 +5133,21 @@ std::vector<Option> get_rgw_options() {
     .set_default(5 << 20)
     .set_description(""),
 
+    Option("rgw_ops_log_flush_interval", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_description("Seconds between flushes of batched rados ops log entries"),
+
+    Option("rgw_ops_log_flush_threshold", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(1_M)
+    .set_description("Bytes of batched rados ops log entries that trigger an early flush"),
+
+    Option("rgw_ops_log_max_pending", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(64_M)
+    .set_description("Max bytes of ops log entries waiting to be flushed")
+    .set_long_description("Entries logged while this many bytes are already waiting "
+                          "for the flusher are dropped rather than slowing down "
+                          "requests. The number dropped is reported in the log."),
+
     Option("rgw_fcgi_socket_backlog", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(1024)
     .set_description(""),
@@ -4808,6 +5192,19 @@ std::vector<Option> get_rgw_options() {
     .set_default(1_hr)
     .set_description(""),
 
+    Option("rgw_gc_max_concurrent_io", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_description("Max number of tail object deletes gc keeps in flight"),
+
+    Option("rgw_s3_signing_key_cache_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(10000)
+    .set_description("Number of derived AWS v4 signing keys to cache")
+    .set_long_description("A v4 signing key is derived from the secret key and "
+                          "the date, region and service of the request through "
+                          "four HMACs. Caching it saves that work for every "
+                          "further request in the same scope. 0 disables the "
+                          "cache. The size is read once, on first use."),
+
     Option("rgw_s3_success_create_obj_status", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
@@ -4832,6 +5229,15 @@ std::vector<Option> get_rgw_options() {
     .set_default(16_M)
     .set_description(""),
 
+    Option("rgw_get_obj_max_window_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(64_M)
+    .set_description("Upper bound for the read-ahead window of a single get obj request")
+    .set_long_description("A get obj request starts with rgw_get_obj_window_size "
+        "bytes of reads in flight. Whenever it has to wait for the window while "
+        "the client has already consumed all completed data, reads are bound "
+        "by OSD latency and the window is doubled, up to this size. Set it to "
+        "rgw_get_obj_window_size or lower to disable growth."),
+
     Option("rgw_get_obj_max_req_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(4_M)
     .set_description(""),
@@ -4900,6 +5306,15 @@ std::vector<Option> get_rgw_options() {
     .set_default(600)
     .set_description(""),
 
+    Option("rgw_bucket_quota_stale_grace", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(300)
+    .set_description("Seconds expired quota stats may still be used while they are refreshed")
+    .set_long_description("Cached bucket and user stats below the soft threshold "
+                          "are used for this long past rgw_bucket_quota_ttl while "
+                          "an asynchronous refresh is in progress, instead of "
+                          "fetching them synchronously in the request. 0 disables "
+                          "this."),
+
     Option("rgw_bucket_quota_soft_threshold", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(0.95)
     .set_description(""),
@@ -5008,10 +5423,31 @@ std::vector<Option> get_rgw_options() {
     .set_default(120)
     .set_description(""),
 
+    Option("rgw_data_sync_spawn_window", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(20)
+    .set_description("Number of bucket shards each data log shard syncs concurrently")
+    .set_long_description("The window grows up to four times this size while "
+                          "the data log shard is behind the source zone."),
+
+    Option("rgw_bucket_sync_spawn_window", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(20)
+    .set_description("Number of objects each bucket shard syncs concurrently")
+    .set_long_description("The window grows up to four times this size while "
+                          "the bucket shard is behind the source zone."),
+
     Option("rgw_sync_log_trim_interval", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(1200)
     .set_description(""),
 
+    Option("rgw_sync_fetch_compressed", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Sync compressed objects in their stored form")
+    .set_long_description("When the destination placement target has compression "
+                          "enabled, fetch compressed objects from the source zone "
+                          "without decompressing them, and store them as is, "
+                          "instead of decompressing on the source and recompressing "
+                          "on the destination."),
+
     Option("rgw_sync_data_inject_err_probability", Option::TYPE_FLOAT, Option::LEVEL_DEV)
     .set_default(0)
     .set_description(""),
@@ -5237,6 +5673,17 @@ static std::vector<Option> get_rbd_options() {
     .set_default(1)
     .set_description("number of threads to utilize for internal processing"),
 
+    Option("rbd_io_dispatch_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("number of threads sending IO in parallel while an image's queue is idle (0 to disable)")
+    .set_long_description("With rbd_non_blocking_aio, IO is normally sent from "
+                          "the single librbd op thread. When this is non-zero, "
+                          "IO that needs no exclusive lock request, refresh or "
+                          "write blocking is instead spread over this many "
+                          "threads, shared by all images, keeping submission "
+                          "order only between overlapping extents.")
+    .add_see_also("rbd_non_blocking_aio"),
+
     Option("rbd_op_thread_timeout", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(60)
     .set_description("time in seconds for detecting a hung thread"),
@@ -5279,6 +5726,44 @@ static std::vector<Option> get_rbd_options() {
     .set_default(false)
     .set_description("whether to block writes to the cache before the aio_write call completes"),
 
+    Option("rbd_cache_writeback_coalesce", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("whether to merge adjacent dirty extents of an object into a single write when flushing the cache")
+    .set_long_description("Small sequential writes that are not merged in the cache (for example, because each has its own journal event) are otherwise written back one by one."),
+
+    Option("rbd_persistent_cache_enabled", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("whether to keep a local persistent write-back log while holding the exclusive lock")
+    .set_long_description("Writes are acknowledged once appended to a log file "
+                          "on local SSD, NVMe or DAX-mounted persistent memory "
+                          "and written back to the image in the background. "
+                          "Requires the exclusive-lock feature; the log is "
+                          "drained before the lock is released.")
+    .add_see_also("rbd_persistent_cache_path")
+    .add_see_also("rbd_persistent_cache_size"),
+
+    Option("rbd_persistent_cache_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("/var/lib/ceph/rbd-cache")
+    .set_description("directory holding persistent write-back cache logs"),
+
+    Option("rbd_persistent_cache_size", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1_G)
+    .set_description("maximum size of a persistent write-back cache log in bytes"),
+
+    Option("rbd_parent_cache_enabled", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("whether clones share a host-wide local cache of parent image data")
+    .add_see_also("rbd_parent_cache_path")
+    .add_see_also("rbd_parent_cache_size"),
+
+    Option("rbd_parent_cache_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("/var/lib/ceph/rbd-parent-cache")
+    .set_description("directory holding the shared parent image cache"),
+
+    Option("rbd_parent_cache_size", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(10_G)
+    .set_description("stop populating the parent cache once its directory holds this many bytes"),
+
     Option("rbd_concurrent_management_ops", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(10)
     .set_min(1)
@@ -5421,6 +5906,26 @@ static std::vector<Option> get_rbd_options() {
     .set_default(0)
     .set_description("maximum age (in seconds) for pending commits"),
 
+    Option("rbd_journal_object_max_in_flight_appends", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("maximum number of in-flight appends per journal object")
+    .set_long_description("appends queued while the limit is reached are sent "
+                          "together once an in-flight append completes, so "
+                          "the batch size grows with the journal latency. "
+                          "0 means unlimited"),
+
+    Option("rbd_journal_concurrent_io", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("write to the image concurrently with the journal")
+    .set_long_description("by default a write is only sent to the image once "
+                          "its journal event is safe. when enabled both are "
+                          "sent at once and the write is acknowledged when "
+                          "both completed, so every acknowledged write can "
+                          "still be replayed from the journal. a write that "
+                          "was never acknowledged may however reach the image "
+                          "without reaching the journal (and mirrors of the "
+                          "image)"),
+
     Option("rbd_journal_pool", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("")
     .set_description("pool for journal objects"),
@@ -5629,6 +6134,16 @@ std::vector<Option> get_mds_options() {
     .set_default(1024)
     .set_description(""),
 
+    Option("mds_log_submit_batch", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(128)
+    .set_description("maximum number of events the journal submit thread appends per batch")
+    .set_long_description("Flushes requested by events in the same batch are coalesced into a single journal flush, so concurrent requests share one write and one safe-reply round trip."),
+
+    Option("mds_log_replay_batch", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(64)
+    .set_description("maximum number of journal events applied per mds_lock acquisition during replay")
+    .set_long_description("Events are read and decoded without mds_lock and then applied in order in batches of up to this many, which shortens replay of long journals at the cost of holding mds_lock for longer at a time."),
+
     Option("mds_log_segment_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
@@ -5697,6 +6212,11 @@ std::vector<Option> get_mds_options() {
     .set_default(0)
     .set_description(""),
 
+    Option("mds_bal_export_cooldown", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("minimum time an imported subtree stays before the balancer exports it again")
+    .set_long_description("Popularity counters decay slowly, so a subtree that was just migrated can look like the best candidate to move again on the next rebalance, and bounce between ranks.  While this many seconds have not passed since the import, the balancer leaves the subtree where it is.  Idle subtrees are still returned to their parent's rank.  0 disables the check."),
+
     Option("mds_bal_max", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(-1)
     .set_description(""),
@@ -5949,6 +6469,11 @@ std::vector<Option> get_mds_options() {
     .set_default(100)
     .set_description("minimum number of capabilities a client may hold"),
 
+    Option("mds_recall_max_sessions", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("maximum number of client sessions sent a recall on each cache pressure check")
+    .set_long_description("Sessions holding the most caps are recalled first; the rest wait for a later check.  0 recalls from every session over its limit at once."),
+
     Option("mds_max_ratio_caps_per_client", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(.8)
     .set_description("maximum ratio of current caps that may be recalled during MDS cache pressure"),
@@ -6094,6 +6619,11 @@ std::vector<Option> get_mds_client_options() {
     .set_default(true)
     .set_description(""),
 
+    Option("client_readdir_max_bytes", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("maximum size of each readdir reply requested from the MDS")
+    .set_long_description("Readdir replies carry the attributes of every entry, so listing a large directory costs one MDS round trip per reply.  Larger replies mean fewer round trips.  0 leaves the size to the MDS (about 512KB)."),
+
     Option("fuse_use_invalidate_cb", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description(""),
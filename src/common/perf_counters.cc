@@ -16,6 +16,11 @@
 #include "common/perf_counters.h"
 #include "common/dout.h"
 #include "common/valgrind.h"
+#include "include/crc32c.h"
+#include "include/encoding.h"
+
+#include <sched.h>
+#include <thread>
 
 using std::ostringstream;
 
@@ -148,6 +153,39 @@ void PerfCountersCollection::dump_formatted_generic(
   f->close_section();
 }
 
+void PerfCountersCollection::dump_binary(
+    bufferlist *out,
+    const std::string &logger) const
+{
+  Mutex::Locker lck(m_lock);
+  uint32_t schema_id = -1;
+  bufferlist values;
+  for (auto l : m_loggers) {
+    if (logger.empty() || l->get_name() == logger) {
+      schema_id = l->schema_crc(schema_id);
+      l->encode_values(values);
+    }
+  }
+  __u8 v = 1;
+  ::encode(v, *out);
+  ::encode(schema_id, *out);
+  ::encode((uint32_t)(values.length() / sizeof(uint64_t)), *out);
+  out->claim_append(values);
+}
+
+uint32_t PerfCountersCollection::get_schema_id(
+    const std::string &logger) const
+{
+  Mutex::Locker lck(m_lock);
+  uint32_t schema_id = -1;
+  for (auto l : m_loggers) {
+    if (logger.empty() || l->get_name() == logger) {
+      schema_id = l->schema_crc(schema_id);
+    }
+  }
+  return schema_id;
+}
+
 void PerfCountersCollection::with_counters(std::function<void(
       const PerfCountersCollection::CounterMap &)> fn) const
 {
@@ -158,10 +196,54 @@ void PerfCountersCollection::with_counters(std::function<void(
 
 // ---------------------------
 
+const std::vector<std::pair<const char*, double>>
+PerfCounters::latency_percentiles = {
+  {"p50", .5},
+  {"p90", .9},
+  {"p99", .99},
+  {"p999", .999},
+};
+
 PerfCounters::~PerfCounters()
 {
 }
 
+unsigned PerfCounters::perf_counter_data_any_d::get_num_shards()
+{
+  static const unsigned num_shards =
+    std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+  return num_shards;
+}
+
+unsigned PerfCounters::perf_counter_data_any_d::get_shard_index()
+{
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  if (cpu >= 0)
+    return cpu % get_num_shards();
+#endif
+  // no cpu to go by, spread the threads instead
+  static std::atomic<unsigned> next_thread = { 0 };
+  static thread_local unsigned thread_shard = next_thread++;
+  return thread_shard % get_num_shards();
+}
+
+void PerfCounters::_inc(perf_counter_data_any_d& data, uint64_t amt)
+{
+  auto shard = data.get_shard();
+  std::atomic<uint64_t>& u64 = shard ? shard->u64 : data.u64;
+  if (data.type & PERFCOUNTER_LONGRUNAVG) {
+    std::atomic<uint64_t>& avgcount = shard ? shard->avgcount : data.avgcount;
+    std::atomic<uint64_t>& avgcount2 =
+      shard ? shard->avgcount2 : data.avgcount2;
+    avgcount++;
+    u64 += amt;
+    avgcount2++;
+  } else {
+    u64 += amt;
+  }
+}
+
 void PerfCounters::inc(int idx, uint64_t amt)
 {
   if (!m_cct->_conf->perf)
@@ -172,13 +254,7 @@ void PerfCounters::inc(int idx, uint64_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt;
-    data.avgcount2++;
-  } else {
-    data.u64 += amt;
-  }
+  _inc(data, amt);
 }
 
 void PerfCounters::dec(int idx, uint64_t amt)
@@ -192,7 +268,12 @@ void PerfCounters::dec(int idx, uint64_t amt)
   assert(!(data.type & PERFCOUNTER_LONGRUNAVG));
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  data.u64 -= amt;
+  // the sum of the shards wraps back around
+  auto shard = data.get_shard();
+  if (shard)
+    shard->u64 -= amt;
+  else
+    data.u64 -= amt;
 }
 
 void PerfCounters::set(int idx, uint64_t amt)
@@ -208,6 +289,10 @@ void PerfCounters::set(int idx, uint64_t amt)
 
   ANNOTATE_BENIGN_RACE_SIZED(&data.u64, sizeof(data.u64),
                              "perf counter atomic");
+  if (data.shards) {
+    for (unsigned i = 0; i < data.get_num_shards(); ++i)
+      data.shards[i].u64 = 0;
+  }
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
     data.avgcount++;
     data.u64 = amt;
@@ -227,7 +312,7 @@ uint64_t PerfCounters::get(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return 0;
-  return data.u64;
+  return data.read_u64();
 }
 
 void PerfCounters::tinc(int idx, utime_t amt, uint32_t avgcount)
@@ -240,13 +325,9 @@ void PerfCounters::tinc(int idx, utime_t amt, uint32_t avgcount)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.to_nsec();
-    data.avgcount2++;
-  } else {
-    data.u64 += amt.to_nsec();
-  }
+  _inc(data, amt.to_nsec());
+  if (data.latency_histogram)
+    data.latency_histogram->inc(amt.to_nsec());
 }
 
 void PerfCounters::tinc(int idx, ceph::timespan amt, uint32_t avgcount)
@@ -259,13 +340,9 @@ void PerfCounters::tinc(int idx, ceph::timespan amt, uint32_t avgcount)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.count();
-    data.avgcount2++;
-  } else {
-    data.u64 += amt.count();
-  }
+  _inc(data, amt.count());
+  if (data.latency_histogram)
+    data.latency_histogram->inc(amt.count());
 }
 
 void PerfCounters::tset(int idx, utime_t amt)
@@ -293,7 +370,7 @@ utime_t PerfCounters::tget(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return utime_t();
-  uint64_t v = data.u64;
+  uint64_t v = data.read_u64();
   return utime_t(v / 1000000000ull, v % 1000000000ull);
 }
 
@@ -328,6 +405,20 @@ pair<uint64_t, uint64_t> PerfCounters::get_tavg_ms(int idx) const
   return make_pair(a.second, a.first / 1000000ull);
 }
 
+utime_t PerfCounters::get_tavg_percentile(int idx, double fraction) const
+{
+  if (!m_cct->_conf->perf)
+    return utime_t();
+
+  assert(idx > m_lower_bound);
+  assert(idx < m_upper_bound);
+  const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
+  if (!data.latency_histogram)
+    return utime_t();
+  uint64_t v = data.latency_histogram->get_percentile(fraction);
+  return utime_t(v / 1000000000ull, v % 1000000000ull);
+}
+
 void PerfCounters::reset()
 {
   perf_counter_data_vec_t::iterator d = m_data.begin();
@@ -420,6 +511,14 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
           } else {
             f->dump_format_unquoted("avgtime", "%" PRId64 ".%09" PRId64, 0, 0);
           }
+          if (d->latency_histogram) {
+            for (auto& p : latency_percentiles) {
+              uint64_t v = d->latency_histogram->get_percentile(p.second);
+              f->dump_format_unquoted(p.first, "%" PRId64 ".%09" PRId64,
+                                      v / 1000000000ull,
+                                      v % 1000000000ull);
+            }
+          }
 	} else {
 	  ceph_abort();
 	}
@@ -431,7 +530,7 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
         d->histogram->dump_formatted(f);
         f->close_section();
       } else {
-	uint64_t v = d->u64;
+	uint64_t v = d->read_u64();
 	if (d->type & PERFCOUNTER_U64) {
 	  f->dump_unsigned(d->name, v);
 	} else if (d->type & PERFCOUNTER_TIME) {
@@ -447,6 +546,36 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
   f->close_section();
 }
 
+void PerfCounters::encode_values(bufferlist& bl) const
+{
+  for (const auto& d : m_data) {
+    if (d.type & PERFCOUNTER_HISTOGRAM) {
+      continue;
+    }
+    if (d.type & PERFCOUNTER_LONGRUNAVG) {
+      pair<uint64_t,uint64_t> a = d.read_avg();
+      ::encode(a.first, bl);
+      ::encode(a.second, bl);
+    } else {
+      ::encode(d.read_u64(), bl);
+    }
+  }
+}
+
+uint32_t PerfCounters::schema_crc(uint32_t crc) const
+{
+  crc = ceph_crc32c(crc, (const unsigned char *)m_name.c_str(),
+		    m_name.length() + 1);
+  for (const auto& d : m_data) {
+    if (d.type & PERFCOUNTER_HISTOGRAM) {
+      continue;
+    }
+    crc = ceph_crc32c(crc, (const unsigned char *)d.name, strlen(d.name) + 1);
+    crc = ceph_crc32c(crc, (const unsigned char *)&d.type, sizeof(d.type));
+  }
+  return crc;
+}
+
 const std::string &PerfCounters::get_name() const
 {
   return m_name;
@@ -547,6 +676,14 @@ void PerfCountersBuilder::add_impl(
   data.prio = prio ? prio : prio_default;
   data.type = (enum perfcounter_type_d)ty;
   data.histogram = std::move(histogram);
+  if ((ty & PERFCOUNTER_TIME) && (ty & PERFCOUNTER_LONGRUNAVG) &&
+      m_perf_counters->m_cct->_conf->get_val<bool>("perf_latency_histograms")) {
+    data.latency_histogram.reset(new PerfLatencyHistogram);
+  }
+  if ((ty & PERFCOUNTER_LONGRUNAVG) ||
+      ((ty & PERFCOUNTER_COUNTER) && !(ty & PERFCOUNTER_HISTOGRAM))) {
+    data.make_shards();
+  }
 }
 
 PerfCounters *PerfCountersBuilder::create_perf_counters()
@@ -24,6 +24,7 @@
 #include <cstdint>
 
 #include "common/perf_histogram.h"
+#include "include/buffer_fwd.h"
 #include "include/utime.h"
 #include "common/Mutex.h"
 #include "common/ceph_time.h"
@@ -146,6 +147,24 @@ class PerfCounters
 public:
   /** Represents a PerfCounters data element. */
   struct perf_counter_data_any_d {
+    /**
+     * Counters and averages bumped from many threads are split into
+     * shards, picked by cpu, so that the threads do not keep stealing
+     * the same cache line from each other.  Readers sum them up.  Each
+     * shard is padded so that no two shards share a cache line.
+     */
+    struct shard_t {
+      std::atomic<uint64_t> u64 = { 0 };
+      std::atomic<uint64_t> avgcount = { 0 };
+      std::atomic<uint64_t> avgcount2 = { 0 };
+      char pad[128 - 3 * sizeof(std::atomic<uint64_t>)];
+    };
+
+    /// number of shards of a sharded counter
+    static unsigned get_num_shards();
+    /// shard the calling thread should update
+    static unsigned get_shard_index();
+
     perf_counter_data_any_d()
       : name(NULL),
         description(NULL),
@@ -157,7 +176,7 @@ public:
         description(other.description),
         nick(other.nick),
 	type(other.type),
-	u64(other.u64.load()) {
+	u64(other.read_u64()) {
       pair<uint64_t,uint64_t> a = other.read_avg();
       u64 = a.first;
       avgcount = a.second;
@@ -165,6 +184,10 @@ public:
       if (other.histogram) {
         histogram.reset(new PerfHistogram<>(*other.histogram));
       }
+      if (other.latency_histogram) {
+        latency_histogram.reset(
+	  new PerfLatencyHistogram(*other.latency_histogram));
+      }
     }
 
     const char *name;
@@ -176,6 +199,18 @@ public:
     std::atomic<uint64_t> avgcount = { 0 };
     std::atomic<uint64_t> avgcount2 = { 0 };
     std::unique_ptr<PerfHistogram<>> histogram;
+    std::unique_ptr<shard_t[]> shards;	///< null if not sharded
+    /// percentiles of a time average, see perf_latency_histograms
+    std::unique_ptr<PerfLatencyHistogram> latency_histogram;
+
+    void make_shards() {
+      shards.reset(new shard_t[get_num_shards()]);
+    }
+
+    /// where inc/tinc should account
+    shard_t *get_shard() {
+      return shards ? &shards[get_shard_index()] : nullptr;
+    }
 
     void reset()
     {
@@ -183,10 +218,29 @@ public:
 	    u64 = 0;
 	    avgcount = 0;
 	    avgcount2 = 0;
+	if (shards) {
+	  for (unsigned i = 0; i < get_num_shards(); ++i) {
+	    shards[i].u64 = 0;
+	    shards[i].avgcount = 0;
+	    shards[i].avgcount2 = 0;
+	  }
+	}
       }
       if (histogram) {
         histogram->reset();
       }
+      if (latency_histogram) {
+        latency_histogram->reset();
+      }
+    }
+
+    uint64_t read_u64() const {
+      uint64_t v = u64;
+      if (shards) {
+	for (unsigned i = 0; i < get_num_shards(); ++i)
+	  v += shards[i].u64;
+      }
+      return v;
     }
 
     // read <sum, count> safely by making sure the post- and pre-count
@@ -198,6 +252,18 @@ public:
 	count = avgcount;
 	sum = u64;
       } while (avgcount2 != count);
+      if (shards) {
+	for (unsigned i = 0; i < get_num_shards(); ++i) {
+	  const shard_t& shard = shards[i];
+	  uint64_t s_sum, s_count;
+	  do {
+	    s_count = shard.avgcount;
+	    s_sum = shard.u64;
+	  } while (shard.avgcount2 != s_count);
+	  sum += s_sum;
+	  count += s_count;
+	}
+      }
       return make_pair(sum, count);
     }
   };
@@ -241,7 +307,14 @@ public:
                                  const std::string &counter = "") {
     dump_formatted_generic(f, schema, true, counter);
   }
+  /// append the raw values of all non-histogram counters, see
+  /// PerfCountersCollection::dump_binary
+  void encode_values(bufferlist& bl) const;
+  /// fold counter names and types into a schema hash
+  uint32_t schema_crc(uint32_t crc) const;
   pair<uint64_t, uint64_t> get_tavg_ms(int idx) const;
+  /// given percentile (e.g., .99) of a time average, if it has a histogram
+  utime_t get_tavg_percentile(int idx, double fraction) const;
 
   const std::string& get_name() const;
   void set_name(std::string s) {
@@ -253,6 +326,9 @@ public:
     prio_adjust = p;
   }
 
+  /// (name, fraction) of the percentiles reported for latency histograms
+  static const std::vector<std::pair<const char*, double>> latency_percentiles;
+
   int get_adjusted_priority(int p) const {
     return std::max(std::min(p + prio_adjust,
                              (int)PerfCountersBuilder::PRIO_CRITICAL),
@@ -267,6 +343,8 @@ private:
   void dump_formatted_generic(ceph::Formatter *f, bool schema, bool histograms,
                               const std::string &counter = "");
 
+  static void _inc(perf_counter_data_any_d& data, uint64_t amt);
+
   typedef std::vector<perf_counter_data_any_d> perf_counter_data_vec_t;
 
   CephContext *m_cct;
@@ -320,6 +398,20 @@ public:
     dump_formatted_generic(f, schema, true, logger, counter);
   }
 
+  /**
+   * Packed dump for high frequency scrapers: a version byte, the
+   * schema id, the number of values and then the raw values as
+   * little-endian u64s.  Loggers are ordered by name and counters by
+   * index; histograms are skipped, averages emit sum then count and
+   * times are in nanoseconds.  The layout is fully described by
+   * "perf schema", so collectors only need to refetch it when the
+   * schema id changes.
+   */
+  void dump_binary(bufferlist *out, const std::string &logger = "") const;
+
+  /// hash of the logger and counter names and types dump_binary covers
+  uint32_t get_schema_id(const std::string &logger = "") const;
+
   // A reference to a perf_counter_data_any_d, with an accompanying
   // pointer to the enclosing PerfCounters, in order that the consumer
   // can see the prio_adjust
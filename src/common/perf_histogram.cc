@@ -14,6 +14,7 @@
 
 #include "common/perf_histogram.h"
 
+#include <cmath>
 #include <limits>
 
 void PerfHistogramCommon::dump_formatted_axis(
@@ -119,3 +120,44 @@ PerfHistogramCommon::get_axis_bucket_ranges(
   ret.back().second = std::numeric_limits<int64_t>::max();
   return ret;
 }
+
+uint64_t PerfLatencyHistogram::get_percentile(double fraction) const
+{
+  uint64_t counts[num_buckets];
+  uint64_t total = 0;
+  for (int i = 0; i < num_buckets; i++) {
+    counts[i] = m_rawData[i];
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = std::ceil(fraction * total);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < num_buckets; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return get_bucket_max(i);
+    }
+  }
+  return get_bucket_max(num_buckets - 1);
+}
+
+void PerfLatencyHistogram::dump_formatted(ceph::Formatter *f) const
+{
+  f->open_array_section("buckets");
+  for (int i = 0; i < num_buckets; i++) {
+    uint64_t count = m_rawData[i];
+    if (!count) {
+      continue;
+    }
+    f->open_object_section("bucket");
+    f->dump_unsigned("max", get_bucket_max(i));
+    f->dump_unsigned("count", count);
+    f->close_section();
+  }
+  f->close_section();
+}
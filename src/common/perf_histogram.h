@@ -224,4 +224,68 @@ protected:
   }
 };
 
+/// PerfLatencyHistogram keeps a one dimensional histogram of latencies, in
+/// nanoseconds, with logarithmic buckets: every power of two is split into
+/// sub_buckets linear sub-buckets, so that any value is known within 1 /
+/// sub_buckets of its magnitude (HDR histogram style), whatever its range.
+/// It only costs one atomic increment per value and is meant to be attached
+/// to time average counters to get percentiles out of them.
+class PerfLatencyHistogram {
+public:
+  static const int sub_bucket_bits = 2;
+  static const int sub_buckets = 1 << sub_bucket_bits;
+  static const int num_buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+  PerfLatencyHistogram() {
+    m_rawData.reset(new std::atomic<uint64_t>[num_buckets] {});
+  }
+
+  PerfLatencyHistogram(const PerfLatencyHistogram &other) {
+    m_rawData.reset(new std::atomic<uint64_t>[num_buckets] {});
+    for (int i = 0; i < num_buckets; i++) {
+      m_rawData[i] = other.m_rawData[i].load();
+    }
+  }
+
+  void reset() {
+    for (int i = 0; i < num_buckets; i++) {
+      m_rawData[i] = 0;
+    }
+  }
+
+  void inc(uint64_t value) {
+    m_rawData[get_bucket(value)]++;
+  }
+
+  /// bucket the given value falls in
+  static int get_bucket(uint64_t value) {
+    if (value < sub_buckets) {
+      return value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - sub_bucket_bits;
+    return (shift + 1) * sub_buckets + ((value >> shift) & (sub_buckets - 1));
+  }
+
+  /// highest value that falls in the given bucket
+  static uint64_t get_bucket_max(int bucket) {
+    if (bucket < sub_buckets) {
+      return bucket;
+    }
+    int shift = bucket / sub_buckets - 1;
+    uint64_t min = (uint64_t)(sub_buckets + bucket % sub_buckets) << shift;
+    return min + ((uint64_t)1 << shift) - 1;
+  }
+
+  /// value below which the given fraction (e.g., .99) of the values fall,
+  /// rounded up to the end of its bucket; 0 if empty
+  uint64_t get_percentile(double fraction) const;
+
+  /// Dump non-empty buckets to a Formatter object
+  void dump_formatted(ceph::Formatter *f) const;
+
+protected:
+  std::unique_ptr<std::atomic<uint64_t>[]> m_rawData;
+};
+
 #endif
@@ -25,6 +25,10 @@
 #include <sys/vfs.h>
 #endif
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #if defined(__APPLE__) || defined(__FreeBSD__)
 #include <sys/param.h>
 #include <sys/mount.h>
@@ -285,6 +289,52 @@ void collect_sys_info(map<string, string> *m, CephContext *cct)
   distro_detect(m, cct);
 }
 
+int set_numa_node_affinity(int node)
+{
+#if defined(__linux__)
+  char fn[128];
+  snprintf(fn, sizeof(fn), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE *f = fopen(fn, "r");
+  if (!f)
+    return -errno;
+  char buf[4096];
+  char *line = fgets(buf, sizeof(buf), f);
+  fclose(f);
+  if (!line)
+    return -EINVAL;
+
+  // cpulist is a comma separated list of cpus and ranges, e.g. "0-7,16-23"
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  char *p = line;
+  while (*p && *p != '\n') {
+    char *end;
+    long first = strtol(p, &end, 10);
+    if (end == p)
+      return -EINVAL;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      if (end == p + 1)
+	return -EINVAL;
+      p = end;
+    }
+    for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+      CPU_SET(cpu, &cpus);
+    if (*p == ',')
+      ++p;
+  }
+  if (CPU_COUNT(&cpus) == 0)
+    return -EINVAL;
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0)
+    return -errno;
+  return 0;
+#else
+  return -EOPNOTSUPP;
+#endif
+}
+
 void dump_services(Formatter* f, const map<string, list<int> >& services, const char* type)
 {
   assert(f);
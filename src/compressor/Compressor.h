@@ -16,8 +16,10 @@
 #define CEPH_COMPRESSOR_H
 
 
+#include <errno.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/optional.hpp>
 #include "include/assert.h"	// boost clobbers this
 #include "include/buffer.h"
@@ -68,6 +70,30 @@ public:
   // alignment with decode methods
   virtual int decompress(ceph::bufferlist::iterator &p, size_t compressed_len, ceph::bufferlist &out) = 0;
 
+  /**
+   * Train a dictionary of at most max_size bytes from sample data, to
+   * improve the compression of small buffers resembling the samples.
+   *
+   * @return 0 on success or -EOPNOTSUPP if the algorithm has no
+   * dictionary support
+   */
+  virtual int train_dictionary(const std::vector<ceph::bufferlist> &samples,
+			       size_t max_size,
+			       ceph::bufferlist *dict) {
+    return -EOPNOTSUPP;
+  }
+  /**
+   * Get a compressor of the same type that compresses with the
+   * dictionary dict.  Its output can be decompressed by any compressor
+   * of this type once the dictionary has been loaded in the process.
+   *
+   * @return nullptr if the algorithm has no dictionary support or if
+   * dict is not a valid dictionary
+   */
+  virtual CompressorRef with_dictionary(const ceph::bufferlist &dict) {
+    return CompressorRef();
+  }
+
   static CompressorRef create(CephContext *cct, const std::string &type);
   static CompressorRef create(CephContext *cct, int alg);
 
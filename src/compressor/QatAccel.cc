@@ -0,0 +1,115 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <qatzip.h>
+
+#include "QatAccel.h"
+
+QatAccel::~QatAccel()
+{
+  for (auto s : idle_sessions)
+    destroy_session(s);
+}
+
+bool QatAccel::init(int l)
+{
+  level = l;
+  QzSession_T *session = create_session();
+  if (!session)
+    return false;
+  put_session(session);
+  return true;
+}
+
+QzSession_T *QatAccel::create_session()
+{
+  QzSession_T *session = new QzSession_T();
+  QzSessionParams_T params;
+  int r = qzGetDefaults(&params);
+  if (r != QZ_OK) {
+    delete session;
+    return nullptr;
+  }
+  params.direction = QZ_DIR_COMPRESS;
+  params.comp_algorithm = QZ_DEFLATE;
+  params.data_fmt = QZ_DEFLATE_RAW;
+  params.comp_lvl = level;
+  params.sw_backup = 0;
+  r = qzInit(session, params.sw_backup);
+  if (r != QZ_OK && r != QZ_DUPLICATE) {
+    delete session;
+    return nullptr;
+  }
+  r = qzSetupSession(session, &params);
+  if (r != QZ_OK && r != QZ_DUPLICATE) {
+    qzClose(session);
+    delete session;
+    return nullptr;
+  }
+  return session;
+}
+
+void QatAccel::destroy_session(QzSession_T *session)
+{
+  qzTeardownSession(session);
+  qzClose(session);
+  delete session;
+}
+
+QzSession_T *QatAccel::get_session()
+{
+  {
+    std::lock_guard<std::mutex> l(sessions_lock);
+    if (!idle_sessions.empty()) {
+      QzSession_T *session = idle_sessions.back();
+      idle_sessions.pop_back();
+      return session;
+    }
+  }
+  return create_session();
+}
+
+void QatAccel::put_session(QzSession_T *session)
+{
+  {
+    std::lock_guard<std::mutex> l(sessions_lock);
+    if (idle_sessions.size() < max_idle_sessions) {
+      idle_sessions.push_back(session);
+      return;
+    }
+  }
+  destroy_session(session);
+}
+
+int QatAccel::compress(const bufferlist &in, bufferlist &out)
+{
+  QzSession_T *session = get_session();
+  if (!session)
+    return -EIO;
+
+  // the device compresses one contiguous buffer into one stream
+  bufferlist src = in;
+  unsigned src_len = src.length();
+  const unsigned char *c_in = (const unsigned char*)src.c_str();
+
+  unsigned out_len = qzMaxCompressedLength(src_len, session);
+  bufferptr ptr = buffer::create_page_aligned(out_len);
+  int r = qzCompress(session, c_in, &src_len,
+		     (unsigned char*)ptr.c_str(), &out_len, 1);
+  if (r != QZ_OK || src_len != in.length()) {
+    destroy_session(session);
+    return -EIO;
+  }
+  put_session(session);
+  out.append(ptr, 0, out_len);
+  return 0;
+}
@@ -0,0 +1,54 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_QATACCEL_H
+#define CEPH_QATACCEL_H
+
+#include <mutex>
+#include <vector>
+
+#include "include/buffer.h"
+
+struct QzSession_S;
+
+/**
+ * Deflate compression offloaded to Intel QuickAssist devices through
+ * QATzip.  The output is a raw deflate stream, as produced by the
+ * software zlib compressor, so that either side can read it.
+ *
+ * QATzip sessions can only be used by one thread at a time: idle
+ * sessions are kept and handed out to the callers.
+ */
+class QatAccel {
+ public:
+  QatAccel() {}
+  ~QatAccel();
+
+  /// set up the first session, false if QAT cannot be used
+  bool init(int level);
+
+  /// compress **in** as one raw deflate stream appended to **out**
+  int compress(const bufferlist &in, bufferlist &out);
+
+ private:
+  static const size_t max_idle_sessions = 16;
+  int level = 1;
+  std::mutex sessions_lock;
+  std::vector<QzSession_S*> idle_sessions;
+
+  QzSession_S *get_session();
+  void put_session(QzSession_S *session);
+  QzSession_S *create_session();
+  static void destroy_session(QzSession_S *session);
+};
+
+#endif
@@ -20,7 +20,6 @@
 #include "compressor/Compressor.h"
 #include "include/buffer.h"
 #include "include/encoding.h"
-#include "common/Tub.h"
 
 
 class LZ4Compressor : public Compressor {
@@ -83,22 +82,31 @@ class LZ4Compressor : public Compressor {
     LZ4_streamDecode_t lz4_stream_decode;
     LZ4_setStreamDecode(&lz4_stream_decode, nullptr, 0);
 
-    bufferptr cur_ptr = p.get_current_ptr();
-    bufferptr *ptr = &cur_ptr;
-    Tub<bufferptr> data_holder;
-    if (compressed_len != cur_ptr.length()) {
-      data_holder.construct(compressed_len);
-      p.copy_deep(compressed_len, *data_holder);
-      ptr = data_holder.get();
-    }
-
-    char *c_in = ptr->c_str();
     char *c_out = dstptr.c_str();
+    bufferptr block_holder;
     for (unsigned i = 0; i < count; ++i) {
+      uint32_t block_len = compressed_pairs[i].second;
+      if (block_len > compressed_len) {
+	return -1;
+      }
+      compressed_len -= block_len;
+      // decompress straight from the input unless the block spans
+      // several of its segments
+      const char *c_in;
+      bufferptr cur_ptr = p.get_current_ptr();
+      if (cur_ptr.length() >= block_len) {
+	c_in = cur_ptr.c_str();
+	p.advance(block_len);
+      } else {
+	if (block_holder.length() < block_len) {
+	  block_holder = buffer::create(block_len);
+	}
+	p.copy(block_len, block_holder.c_str());
+	c_in = block_holder.c_str();
+      }
       int r = LZ4_decompress_safe_continue(
-          &lz4_stream_decode, c_in, c_out, compressed_pairs[i].second, compressed_pairs[i].first);
+          &lz4_stream_decode, c_in, c_out, block_len, compressed_pairs[i].first);
       if (r == (int)compressed_pairs[i].first) {
-        c_in += compressed_pairs[i].second;
         c_out += compressed_pairs[i].first;
       } else if (r < 0) {
         return -1;
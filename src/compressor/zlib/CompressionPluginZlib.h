@@ -28,6 +28,7 @@
 class CompressionPluginZlib : public CompressionPlugin {
 public:
   bool has_isal = false;
+  bool has_qat = false;
 
   explicit CompressionPluginZlib(CephContext *cct) : CompressionPlugin(cct)
   {}
@@ -43,9 +44,11 @@ public:
       isal = (ceph_arch_intel_pclmul && ceph_arch_intel_sse41);
     }
 #endif
-    if (compressor == 0 || has_isal != isal) {
-      compressor = std::make_shared<ZlibCompressor>(cct, isal);
+    bool qat = cct->_conf->qat_compressor_enabled;
+    if (compressor == 0 || has_isal != isal || has_qat != qat) {
+      compressor = std::make_shared<ZlibCompressor>(cct, isal, qat);
       has_isal = isal;
+      has_qat = qat;
     }
     *cs = compressor;
     return 0;
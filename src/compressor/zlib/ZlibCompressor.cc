@@ -47,24 +47,142 @@ _prefix(std::ostream* _dout)
 // compression ratio.
 #define ZLIB_MEMORY_LEVEL 8
 
+ZlibCompressor::ZlibCompressor(CephContext *cct, bool isal, bool qat)
+  : Compressor(COMP_ALG_ZLIB, "zlib"), isal_enabled(isal), cct(cct)
+{
+#ifdef HAVE_QATZIP
+  if (qat) {
+    qat_enabled = qat_accel.init(cct->_conf->compressor_zlib_level);
+    if (!qat_enabled) {
+      dout(1) << "QAT compression offload unavailable, using software"
+	      << dendl;
+    }
+  }
+#endif
+}
+
+ZlibCompressor::~ZlibCompressor()
+{
+  for (auto& i : idle_deflate) {
+    deflateEnd(i.second);
+    delete i.second;
+  }
+  for (auto strm : idle_inflate) {
+    inflateEnd(strm);
+    delete strm;
+  }
+}
+
+z_stream *ZlibCompressor::get_deflate(int level)
+{
+  z_stream *strm = nullptr;
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    for (auto i = idle_deflate.rbegin(); i != idle_deflate.rend(); ++i) {
+      if (i->first == level) {
+	strm = i->second;
+	idle_deflate.erase(std::next(i).base());
+	break;
+      }
+    }
+  }
+  if (strm) {
+    if (deflateReset(strm) == Z_OK)
+      return strm;
+    deflateEnd(strm);
+    delete strm;
+  }
+
+  /* allocate deflate state */
+  strm = new z_stream;
+  strm->zalloc = Z_NULL;
+  strm->zfree = Z_NULL;
+  strm->opaque = Z_NULL;
+  int ret = deflateInit2(strm, level, Z_DEFLATED, ZLIB_DEFAULT_WIN_SIZE, ZLIB_MEMORY_LEVEL, Z_DEFAULT_STRATEGY);
+  if (ret != Z_OK) {
+    dout(1) << "Compression init error: init return "
+         << ret << " instead of Z_OK" << dendl;
+    delete strm;
+    return nullptr;
+  }
+  return strm;
+}
+
+void ZlibCompressor::put_deflate(int level, z_stream *strm)
+{
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    if (idle_deflate.size() < max_idle_streams) {
+      idle_deflate.push_back(std::make_pair(level, strm));
+      return;
+    }
+  }
+  deflateEnd(strm);
+  delete strm;
+}
+
+z_stream *ZlibCompressor::get_inflate()
+{
+  z_stream *strm = nullptr;
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    if (!idle_inflate.empty()) {
+      strm = idle_inflate.back();
+      idle_inflate.pop_back();
+    }
+  }
+  if (strm) {
+    if (inflateReset(strm) == Z_OK)
+      return strm;
+    inflateEnd(strm);
+    delete strm;
+  }
+
+  /* allocate inflate state */
+  strm = new z_stream;
+  strm->zalloc = Z_NULL;
+  strm->zfree = Z_NULL;
+  strm->opaque = Z_NULL;
+  strm->avail_in = 0;
+  strm->next_in = Z_NULL;
+
+  // choose the variation of compressor
+  int ret = inflateInit2(strm, ZLIB_DEFAULT_WIN_SIZE);
+  if (ret != Z_OK) {
+    dout(1) << "Decompression init error: init return "
+         << ret << " instead of Z_OK" << dendl;
+    delete strm;
+    return nullptr;
+  }
+  return strm;
+}
+
+void ZlibCompressor::put_inflate(z_stream *strm)
+{
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    if (idle_inflate.size() < max_idle_streams) {
+      idle_inflate.push_back(strm);
+      return;
+    }
+  }
+  inflateEnd(strm);
+  delete strm;
+}
+
 int ZlibCompressor::zlib_compress(const bufferlist &in, bufferlist &out)
 {
   int ret;
   unsigned have;
-  z_stream strm;
   unsigned char* c_in;
   int begin = 1;
 
-  /* allocate deflate state */
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  ret = deflateInit2(&strm, cct->_conf->compressor_zlib_level, Z_DEFLATED, ZLIB_DEFAULT_WIN_SIZE, ZLIB_MEMORY_LEVEL, Z_DEFAULT_STRATEGY);
-  if (ret != Z_OK) {
-    dout(1) << "Compression init error: init return "
-         << ret << " instead of Z_OK" << dendl;
+  int level = cct->_conf->compressor_zlib_level;
+  z_stream *pstrm = get_deflate(level);
+  if (!pstrm) {
     return -1;
   }
+  z_stream &strm = *pstrm;
 
   for (std::list<buffer::ptr>::const_iterator i = in.buffers().begin();
       i != in.buffers().end();) {
@@ -91,6 +209,7 @@ int ZlibCompressor::zlib_compress(const bufferlist &in, bufferlist &out)
          dout(1) << "Compression error: compress return Z_STREAM_ERROR("
               << ret << ")" << dendl;
          deflateEnd(&strm);
+         delete pstrm;
          return -1;
       }
       have = MAX_LEN - strm.avail_out;
@@ -99,11 +218,12 @@ int ZlibCompressor::zlib_compress(const bufferlist &in, bufferlist &out)
     if (strm.avail_in != 0) {
       dout(10) << "Compression error: unused input" << dendl;
       deflateEnd(&strm);
+      delete pstrm;
       return -1;
     }
   }
 
-  deflateEnd(&strm);
+  put_deflate(level, pstrm);
   return 0;
 }
 
@@ -163,6 +283,21 @@ int ZlibCompressor::isal_compress(const bufferlist &in, bufferlist &out)
 
 int ZlibCompressor::compress(const bufferlist &in, bufferlist &out)
 {
+#ifdef HAVE_QATZIP
+  if (qat_enabled) {
+    // the device writes a raw deflate stream like zlib_compress
+    bufferlist qat_out;
+    bufferptr mark = buffer::create(1);
+    // put a compressor variation mark in front of compressed stream, not used at the moment
+    mark.c_str()[0] = 2;
+    qat_out.append(mark);
+    if (qat_accel.compress(in, qat_out) == 0) {
+      out.claim_append(qat_out);
+      return 0;
+    }
+    dout(10) << "QAT compression failed, falling back to software" << dendl;
+  }
+#endif
 #if __x86_64__ && defined(HAVE_BETTER_YASM_ELF64)
   if (isal_enabled)
     return isal_compress(in, out);
@@ -177,24 +312,14 @@ int ZlibCompressor::decompress(bufferlist::iterator &p, size_t compressed_size,
 {
   int ret;
   unsigned have;
-  z_stream strm;
   const char* c_in;
   int begin = 1;
 
-  /* allocate inflate state */
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  strm.avail_in = 0;
-  strm.next_in = Z_NULL;
-
-  // choose the variation of compressor
-  ret = inflateInit2(&strm, ZLIB_DEFAULT_WIN_SIZE);
-  if (ret != Z_OK) {
-    dout(1) << "Decompression init error: init return "
-         << ret << " instead of Z_OK" << dendl;
+  z_stream *pstrm = get_inflate();
+  if (!pstrm) {
     return -1;
   }
+  z_stream &strm = *pstrm;
 
   size_t remaining = MIN(p.get_remaining(), compressed_size);
 
@@ -214,6 +339,7 @@ int ZlibCompressor::decompress(bufferlist::iterator &p, size_t compressed_size,
        dout(1) << "Decompression error: decompress return "
             << ret << dendl;
        inflateEnd(&strm);
+       delete pstrm;
        return -1;
       }
       have = MAX_LEN - strm.avail_out;
@@ -221,8 +347,7 @@ int ZlibCompressor::decompress(bufferlist::iterator &p, size_t compressed_size,
     } while (strm.avail_out == 0);
   }
 
-  /* clean up and return */
-  (void)inflateEnd(&strm);
+  put_inflate(pstrm);
   return 0;
 }
 
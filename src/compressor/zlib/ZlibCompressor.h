@@ -17,14 +17,28 @@
 #ifndef CEPH_COMPRESSION_ZLIB_H
 #define CEPH_COMPRESSION_ZLIB_H
 
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "acconfig.h"
 #include "compressor/Compressor.h"
+#ifdef HAVE_QATZIP
+#include "compressor/QatAccel.h"
+#endif
+
+struct z_stream_s;
 
 class ZlibCompressor : public Compressor {
   bool isal_enabled;
+  bool qat_enabled = false;
   CephContext *const cct;
+#ifdef HAVE_QATZIP
+  QatAccel qat_accel;
+#endif
 public:
-  ZlibCompressor(CephContext *cct, bool isal)
-    : Compressor(COMP_ALG_ZLIB, "zlib"), isal_enabled(isal), cct(cct) {}
+  ZlibCompressor(CephContext *cct, bool isal, bool qat = false);
+  ~ZlibCompressor() override;
 
   int compress(const bufferlist &in, bufferlist &out) override;
   int decompress(const bufferlist &in, bufferlist &out) override;
@@ -32,6 +46,18 @@ public:
 private:
   int zlib_compress(const bufferlist &in, bufferlist &out);
   int isal_compress(const bufferlist &in, bufferlist &out);
+
+  // the zlib states are large and costly to set up, keep the idle
+  // ones (with their compression level) for later calls
+  static const size_t max_idle_streams = 16;
+  std::mutex streams_lock;
+  std::vector<std::pair<int, z_stream_s*>> idle_deflate;
+  std::vector<z_stream_s*> idle_inflate;
+
+  z_stream_s *get_deflate(int level);
+  void put_deflate(int level, z_stream_s *strm);
+  z_stream_s *get_inflate();
+  void put_inflate(z_stream_s *strm);
  };
 
 
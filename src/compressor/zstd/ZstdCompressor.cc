@@ -0,0 +1,276 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <map>
+
+#include "ZstdCompressor.h"
+#include "zstd/lib/dictBuilder/zdict.h"
+
+/**
+ * A trained dictionary with its digested compression and
+ * decompression forms.  Dictionaries are identified by the id zstd
+ * stores in them, which is also recorded in every frame compressed
+ * with them.
+ */
+struct ZstdDictionary {
+  unsigned id;
+  bufferlist data;
+  ZSTD_CDict *cdict = nullptr;
+  ZSTD_DDict *ddict = nullptr;
+
+  ZstdDictionary(unsigned i, const bufferlist &d) : id(i), data(d) {
+    data.rebuild();
+    cdict = ZSTD_createCDict(data.c_str(), data.length(), COMPRESSION_LEVEL);
+    ddict = ZSTD_createDDict(data.c_str(), data.length());
+  }
+  ~ZstdDictionary() {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+  }
+};
+
+// every dictionary loaded in the process, by id, so that any
+// compressor instance can decompress the frames that use them
+static std::mutex dictionaries_lock;
+static std::map<unsigned, std::shared_ptr<ZstdDictionary>> dictionaries;
+
+static std::shared_ptr<ZstdDictionary> lookup_dictionary(unsigned id)
+{
+  std::lock_guard<std::mutex> l(dictionaries_lock);
+  auto p = dictionaries.find(id);
+  if (p == dictionaries.end())
+    return nullptr;
+  return p->second;
+}
+
+ZstdCompressor::~ZstdCompressor()
+{
+  for (auto s : idle_cstreams)
+    ZSTD_freeCStream(s);
+  for (auto s : idle_dstreams)
+    ZSTD_freeDStream(s);
+}
+
+ZSTD_CStream *ZstdCompressor::get_cstream()
+{
+  std::lock_guard<std::mutex> l(streams_lock);
+  if (idle_cstreams.empty())
+    return ZSTD_createCStream();
+  ZSTD_CStream *s = idle_cstreams.back();
+  idle_cstreams.pop_back();
+  return s;
+}
+
+void ZstdCompressor::put_cstream(ZSTD_CStream *s)
+{
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    if (idle_cstreams.size() < max_idle_streams) {
+      idle_cstreams.push_back(s);
+      return;
+    }
+  }
+  ZSTD_freeCStream(s);
+}
+
+ZSTD_DStream *ZstdCompressor::get_dstream()
+{
+  std::lock_guard<std::mutex> l(streams_lock);
+  if (idle_dstreams.empty())
+    return ZSTD_createDStream();
+  ZSTD_DStream *s = idle_dstreams.back();
+  idle_dstreams.pop_back();
+  return s;
+}
+
+void ZstdCompressor::put_dstream(ZSTD_DStream *s)
+{
+  {
+    std::lock_guard<std::mutex> l(streams_lock);
+    if (idle_dstreams.size() < max_idle_streams) {
+      idle_dstreams.push_back(s);
+      return;
+    }
+  }
+  ZSTD_freeDStream(s);
+}
+
+int ZstdCompressor::compress(const bufferlist &src, bufferlist &dst)
+{
+  ZSTD_CStream *s = get_cstream();
+  size_t r;
+  if (dict) {
+    ZSTD_frameParameters fparams = { 1, 0, 0 };
+    r = ZSTD_initCStream_usingCDict_advanced(s, dict->cdict, fparams,
+					     src.length());
+  } else {
+    r = ZSTD_initCStream_srcSize(s, COMPRESSION_LEVEL, src.length());
+  }
+  if (ZSTD_isError(r)) {
+    ZSTD_freeCStream(s);
+    return -EINVAL;
+  }
+  auto p = src.begin();
+  size_t left = src.length();
+
+  size_t const out_max = ZSTD_compressBound(left);
+  bufferptr outptr = buffer::create_page_aligned(out_max);
+  ZSTD_outBuffer_s outbuf;
+  outbuf.dst = outptr.c_str();
+  outbuf.size = outptr.length();
+  outbuf.pos = 0;
+
+  while (left) {
+    assert(!p.end());
+    struct ZSTD_inBuffer_s inbuf;
+    inbuf.pos = 0;
+    inbuf.size = p.get_ptr_and_advance(left, (const char**)&inbuf.src);
+    left -= inbuf.size;
+    ZSTD_EndDirective const zed = (left==0) ? ZSTD_e_end : ZSTD_e_continue;
+    r = ZSTD_compress_generic(s, &outbuf, &inbuf, zed);
+    if (ZSTD_isError(r)) {
+      // the stream is in an unknown state, do not reuse it
+      ZSTD_freeCStream(s);
+      return -EINVAL;
+    }
+  }
+  assert(p.end());
+
+  put_cstream(s);
+
+  // prefix with decompressed length
+  ::encode((uint32_t)src.length(), dst);
+  dst.append(outptr, 0, outbuf.pos);
+  return 0;
+}
+
+int ZstdCompressor::decompress(const bufferlist &src, bufferlist &dst)
+{
+  bufferlist::iterator i = const_cast<bufferlist&>(src).begin();
+  return decompress(i, src.length(), dst);
+}
+
+int ZstdCompressor::decompress(bufferlist::iterator &p,
+			       size_t compressed_len,
+			       bufferlist &dst)
+{
+  if (compressed_len < 4) {
+    return -1;
+  }
+  compressed_len -= 4;
+  uint32_t dst_len;
+  ::decode(dst_len, p);
+
+  // find the dictionary the frame was compressed with, if any
+  std::shared_ptr<ZstdDictionary> d;
+  {
+    char header[ZSTD_FRAMEHEADERSIZE_MAX];
+    size_t header_len = std::min(compressed_len, sizeof(header));
+    bufferlist::iterator q = p;
+    q.copy(header_len, header);
+    unsigned id = ZSTD_getDictID_fromFrame(header, header_len);
+    if (id) {
+      d = (dict && dict->id == id) ? dict : lookup_dictionary(id);
+      if (!d) {
+	return -ENOENT;
+      }
+    }
+  }
+
+  bufferptr dstptr(dst_len);
+  ZSTD_outBuffer_s outbuf;
+  outbuf.dst = dstptr.c_str();
+  outbuf.size = dstptr.length();
+  outbuf.pos = 0;
+  ZSTD_DStream *s = get_dstream();
+  size_t r;
+  if (d) {
+    r = ZSTD_initDStream_usingDDict(s, d->ddict);
+  } else {
+    r = ZSTD_initDStream(s);
+  }
+  if (ZSTD_isError(r)) {
+    ZSTD_freeDStream(s);
+    return -EINVAL;
+  }
+  while (compressed_len > 0) {
+    if (p.end()) {
+      ZSTD_freeDStream(s);
+      return -1;
+    }
+    ZSTD_inBuffer_s inbuf;
+    inbuf.pos = 0;
+    inbuf.size = p.get_ptr_and_advance(compressed_len,
+				       (const char**)&inbuf.src);
+    r = ZSTD_decompressStream(s, &outbuf, &inbuf);
+    if (ZSTD_isError(r)) {
+      ZSTD_freeDStream(s);
+      return -EINVAL;
+    }
+    compressed_len -= inbuf.size;
+  }
+  put_dstream(s);
+
+  dst.append(dstptr, 0, outbuf.pos);
+  return 0;
+}
+
+int ZstdCompressor::train_dictionary(const std::vector<bufferlist> &samples,
+				     size_t max_size,
+				     bufferlist *dict)
+{
+  bufferlist all;
+  std::vector<size_t> sizes;
+  for (auto& bl : samples) {
+    if (bl.length() == 0)
+      continue;
+    all.append(bl);
+    sizes.push_back(bl.length());
+  }
+  if (sizes.empty())
+    return -EINVAL;
+
+  bufferptr out = buffer::create(max_size);
+  size_t r = ZDICT_trainFromBuffer(out.c_str(), out.length(),
+				   all.c_str(), sizes.data(), sizes.size());
+  if (ZDICT_isError(r))
+    return -EINVAL;
+  dict->clear();
+  dict->append(out, 0, r);
+  return 0;
+}
+
+CompressorRef ZstdCompressor::with_dictionary(const bufferlist &data)
+{
+  bufferlist d = data;
+  unsigned id = ZSTD_getDictID_fromDict(d.c_str(), d.length());
+  if (!id) {
+    // raw content dictionaries carry no id, so frames compressed
+    // with them could not find them back
+    return CompressorRef();
+  }
+
+  std::lock_guard<std::mutex> l(dictionaries_lock);
+  auto& slot = dictionaries[id];
+  if (!slot) {
+    auto nd = std::make_shared<ZstdDictionary>(id, d);
+    if (!nd->cdict || !nd->ddict) {
+      dictionaries.erase(id);
+      return CompressorRef();
+    }
+    slot = nd;
+  } else if (!slot->data.contents_equal(d)) {
+    // a different dictionary with the same id is already in use
+    return CompressorRef();
+  }
+  return std::make_shared<ZstdCompressor>(slot);
+}
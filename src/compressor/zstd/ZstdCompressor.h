@@ -18,89 +18,49 @@
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd/lib/zstd.h"
 
+#include <mutex>
+#include <vector>
+
 #include "include/buffer.h"
 #include "include/encoding.h"
 #include "compressor/Compressor.h"
 
 #define COMPRESSION_LEVEL 5
 
+struct ZstdDictionary;
+
 class ZstdCompressor : public Compressor {
  public:
   ZstdCompressor() : Compressor(COMP_ALG_ZSTD, "zstd") {}
+  explicit ZstdCompressor(std::shared_ptr<ZstdDictionary> d)
+    : Compressor(COMP_ALG_ZSTD, "zstd"), dict(d) {}
+  ~ZstdCompressor() override;
 
-  int compress(const bufferlist &src, bufferlist &dst) override {
-    ZSTD_CStream *s = ZSTD_createCStream();
-    ZSTD_initCStream_srcSize(s, COMPRESSION_LEVEL, src.length());
-    auto p = src.begin();
-    size_t left = src.length();
-
-    size_t const out_max = ZSTD_compressBound(left);
-    bufferptr outptr = buffer::create_page_aligned(out_max);
-    ZSTD_outBuffer_s outbuf;
-    outbuf.dst = outptr.c_str();
-    outbuf.size = outptr.length();
-    outbuf.pos = 0;
-
-    while (left) {
-      assert(!p.end());
-      struct ZSTD_inBuffer_s inbuf;
-      inbuf.pos = 0;
-      inbuf.size = p.get_ptr_and_advance(left, (const char**)&inbuf.src);
-      left -= inbuf.size;
-      ZSTD_EndDirective const zed = (left==0) ? ZSTD_e_end : ZSTD_e_continue;
-      size_t r = ZSTD_compress_generic(s, &outbuf, &inbuf, zed);
-      if (ZSTD_isError(r)) {
-	return -EINVAL;
-      }
-    }
-    assert(p.end());
-
-    ZSTD_freeCStream(s);
-
-    // prefix with decompressed length
-    ::encode((uint32_t)src.length(), dst);
-    dst.append(outptr, 0, outbuf.pos);
-    return 0;
-  }
-
-  int decompress(const bufferlist &src, bufferlist &dst) override {
-    bufferlist::iterator i = const_cast<bufferlist&>(src).begin();
-    return decompress(i, src.length(), dst);
-  }
-
+  int compress(const bufferlist &src, bufferlist &dst) override;
+  int decompress(const bufferlist &src, bufferlist &dst) override;
   int decompress(bufferlist::iterator &p,
 		 size_t compressed_len,
-		 bufferlist &dst) override {
-    if (compressed_len < 4) {
-      return -1;
-    }
-    compressed_len -= 4;
-    uint32_t dst_len;
-    ::decode(dst_len, p);
+		 bufferlist &dst) override;
+
+  int train_dictionary(const std::vector<bufferlist> &samples,
+		       size_t max_size,
+		       bufferlist *dict) override;
+  CompressorRef with_dictionary(const bufferlist &dict) override;
+
+ private:
+  // the dictionary we compress with, if any
+  std::shared_ptr<ZstdDictionary> dict;
 
-    bufferptr dstptr(dst_len);
-    ZSTD_outBuffer_s outbuf;
-    outbuf.dst = dstptr.c_str();
-    outbuf.size = dstptr.length();
-    outbuf.pos = 0;
-    ZSTD_DStream *s = ZSTD_createDStream();
-    ZSTD_initDStream(s);
-    while (compressed_len > 0) {
-      if (p.end()) {
-	return -1;
-      }
-      ZSTD_inBuffer_s inbuf;
-      inbuf.pos = 0;
-      inbuf.size = p.get_ptr_and_advance(compressed_len,
-					 (const char**)&inbuf.src);
-      ZSTD_decompressStream(s, &outbuf, &inbuf);
-      compressed_len -= inbuf.size;
-    }
-    ZSTD_freeDStream(s);
+  // streams are expensive to set up, keep the idle ones for later calls
+  static const size_t max_idle_streams = 16;
+  std::mutex streams_lock;
+  std::vector<ZSTD_CStream*> idle_cstreams;
+  std::vector<ZSTD_DStream*> idle_dstreams;
 
-    dst.append(dstptr, 0, outbuf.pos);
-    return 0;
-  }
+  ZSTD_CStream *get_cstream();
+  void put_cstream(ZSTD_CStream *s);
+  ZSTD_DStream *get_dstream();
+  void put_dstream(ZSTD_DStream *s);
 };
 
 #endif
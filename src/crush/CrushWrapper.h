@@ -1477,9 +1477,31 @@ public:
   void do_rule(int rule, int x, vector<int>& out, int maxout,
 	       const WeightVector& weight,
 	       uint64_t choose_args_index) const {
-    int rawout[maxout];
     char work[crush_work_size(crush, maxout)];
     crush_init_workspace(crush, work);
+    do_rule(rule, x, out, maxout, weight, choose_args_index, work);
+  }
+
+  /**
+   * Size of the do_rule() workspace for up to maxout results.  A
+   * workspace set up with init_work() can be passed to do_rule() for
+   * any number of mappings as long as the map is not modified in
+   * between.  Sizing and initializing it is linear in the number of
+   * buckets, so callers mapping many inputs should share one.
+   */
+  size_t work_size(int maxout) const {
+    return crush_work_size(crush, maxout);
+  }
+  void init_work(void *work) const {
+    crush_init_workspace(crush, work);
+  }
+
+  template<typename WeightVector>
+  void do_rule(int rule, int x, vector<int>& out, int maxout,
+	       const WeightVector& weight,
+	       uint64_t choose_args_index,
+	       void *work) const {
+    int rawout[maxout];
     crush_choose_arg_map arg_map = choose_args_get_with_fallback(
       choose_args_index);
     int numrep = crush_do_rule(crush, rule, x, rawout, maxout, &weight[0],
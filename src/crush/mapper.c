@@ -328,10 +328,17 @@ static int bucket_straw2_choose(const struct crush_bucket_straw2 *bucket,
 	__s64 ln, draw, high_draw = 0;
         __u32 *weights = get_choose_arg_weights(bucket, arg, position);
         __s32 *ids = get_choose_arg_ids(bucket, arg);
+	/* hash a chunk of items at a time so the hashing can be vectorized */
+	__u32 hashes[16];
 	for (i = 0; i < bucket->h.size; i++) {
+		if ((i & 15) == 0)
+			crush_hash32_3_batch(bucket->h.hash, x, ids + i, r,
+					     hashes,
+					     bucket->h.size - i < 16 ?
+					     bucket->h.size - i : 16);
                 dprintk("weight 0x%x item %d\n", weights[i], ids[i]);
 		if (weights[i]) {
-			u = crush_hash32_3(bucket->h.hash, x, ids[i], r);
+			u = hashes[i & 15];
 			u &= 0xffff;
 
 			/*
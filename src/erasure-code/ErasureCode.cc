@@ -196,6 +196,148 @@ int ErasureCode::encode_chunks(const set<int> &want_to_encode,
 {
   assert("ErasureCode::encode_chunks not implemented" == 0);
 }
+
+/*
+ * Generic implementation for codes that are linear over xor, which
+ * is every matrix and bit matrix code: the parity of the delta stripe
+ * (old ^ new in the changed chunk, zero elsewhere) is exactly what
+ * has to be xor'ed into the old parity.  It costs one encode but
+ * only needs the changed chunk and the coding chunks.
+ */
+int ErasureCode::encode_parity_delta(int data_chunk,
+				     const bufferlist &old_data,
+				     const bufferlist &new_data,
+				     map<int, bufferlist> *parity)
+{
+  if (!supports_parity_delta())
+    return -EOPNOTSUPP;
+
+  unsigned int k = get_data_chunk_count();
+  unsigned int m = get_chunk_count() - k;
+  unsigned blocksize = old_data.length();
+  if (blocksize == 0 || new_data.length() != blocksize)
+    return -EINVAL;
+
+  bool found = false;
+  for (unsigned int i = 0; i < k; i++) {
+    if (chunk_index(i) == data_chunk)
+      found = true;
+  }
+  if (!found)
+    return -EINVAL;
+  for (unsigned int i = k; i < k + m; i++) {
+    auto p = parity->find(chunk_index(i));
+    if (p == parity->end() || p->second.length() != blocksize)
+      return -EINVAL;
+  }
+
+  bufferlist o = old_data, n = new_data;
+  const char *op = o.c_str();
+  const char *np = n.c_str();
+  set<int> want;
+  map<int, bufferlist> delta;
+  for (unsigned int i = 0; i < k + m; i++) {
+    int chunk = chunk_index(i);
+    bufferptr buf(buffer::create_aligned(blocksize, SIMD_ALIGN));
+    if (chunk == data_chunk) {
+      char *d = buf.c_str();
+      for (unsigned j = 0; j < blocksize; j++)
+	d[j] = op[j] ^ np[j];
+    } else {
+      buf.zero();
+    }
+    delta[chunk].push_back(std::move(buf));
+    want.insert(chunk);
+  }
+  int r = encode_chunks(want, &delta);
+  if (r)
+    return r;
+
+  for (unsigned int i = k; i < k + m; i++) {
+    int chunk = chunk_index(i);
+    // don't modify the old parity in place, it may share its buffer
+    bufferlist &p = (*parity)[chunk];
+    const char *pp = p.c_str();
+    const char *dp = delta[chunk].c_str();
+    bufferptr buf(buffer::create_aligned(blocksize, SIMD_ALIGN));
+    char *out = buf.c_str();
+    for (unsigned j = 0; j < blocksize; j++)
+      out[j] = pp[j] ^ dp[j];
+    p.clear();
+    p.push_back(std::move(buf));
+  }
+  return 0;
+}
+
+/*
+ * Gather each data chunk of every stripe into one aligned shard
+ * buffer and run encode_chunks() once over the shards.  Only valid
+ * for codes that code every byte column (or packet) independently,
+ * which is what supports_multi_stripe() promises.
+ */
+int ErasureCode::encode_stripes(const set<int> &want_to_encode,
+				const bufferlist &in,
+				unsigned stripe_width,
+				map<int, bufferlist> *encoded)
+{
+  if (!supports_multi_stripe())
+    return -EOPNOTSUPP;
+
+  unsigned int k = get_data_chunk_count();
+  unsigned int m = get_chunk_count() - k;
+  if (stripe_width == 0 || in.length() % stripe_width)
+    return -EINVAL;
+  unsigned chunk_size = get_chunk_size(stripe_width);
+  if (chunk_size * k != stripe_width)
+    return -EINVAL;
+  unsigned stripes = in.length() / stripe_width;
+  if (stripes == 0)
+    return 0;
+  unsigned shard_size = stripes * chunk_size;
+
+  vector<char*> data(k);
+  for (unsigned int i = 0; i < k + m; i++) {
+    bufferptr buf(buffer::create_aligned(shard_size, SIMD_ALIGN));
+    if (i < k)
+      data[i] = buf.c_str();
+    bufferlist &shard = (*encoded)[chunk_index(i)];
+    shard.clear();
+    shard.push_back(std::move(buf));
+  }
+  auto p = in.begin();
+  for (unsigned s = 0; s < stripes; s++) {
+    for (unsigned int i = 0; i < k; i++)
+      p.copy(chunk_size, data[i] + s * chunk_size);
+  }
+
+  int r = encode_chunks(want_to_encode, encoded);
+  if (r)
+    return r;
+  for (unsigned int i = 0; i < k + m; i++) {
+    if (want_to_encode.count(i) == 0)
+      encoded->erase(i);
+  }
+  return 0;
+}
+
+int ErasureCode::decode_stripes(const set<int> &want_to_read,
+				const map<int, bufferlist> &chunks,
+				unsigned chunk_size,
+				map<int, bufferlist> *decoded)
+{
+  if (!supports_multi_stripe())
+    return -EOPNOTSUPP;
+  if (chunks.empty() || chunk_size == 0)
+    return -EINVAL;
+  unsigned shard_size = chunks.begin()->second.length();
+  if (shard_size % chunk_size)
+    return -EINVAL;
+  for (auto& i : chunks) {
+    if (i.second.length() != shard_size)
+      return -EINVAL;
+  }
+  return _decode(want_to_read, chunks, decoded);
+}
  
 int ErasureCode::_decode(const set<int> &want_to_read,
 			 const map<int, bufferlist> &chunks,
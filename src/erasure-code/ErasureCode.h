@@ -66,7 +66,7 @@ namespace ceph {
 
     int minimum_to_decode(const std::set<int> &want_to_read,
 			  const std::set<int> &available,
-			  std::map<int, std::vector<std::pair<int, int>>> *minimum) final override;
+			  std::map<int, std::vector<std::pair<int, int>>> *minimum) override;
 
     int minimum_to_decode_with_cost(const std::set<int> &want_to_read,
                                             const std::map<int, int> &available,
@@ -82,9 +82,24 @@ namespace ceph {
     int encode_chunks(const std::set<int> &want_to_encode,
                               std::map<int, bufferlist> *encoded) override;
 
+    int encode_parity_delta(int data_chunk,
+			    const bufferlist &old_data,
+			    const bufferlist &new_data,
+			    std::map<int, bufferlist> *parity) override;
+
+    int encode_stripes(const std::set<int> &want_to_encode,
+		       const bufferlist &in,
+		       unsigned stripe_width,
+		       std::map<int, bufferlist> *encoded) override;
+
+    int decode_stripes(const std::set<int> &want_to_read,
+		       const std::map<int, bufferlist> &chunks,
+		       unsigned chunk_size,
+		       std::map<int, bufferlist> *decoded) override;
+
     int decode(const std::set<int> &want_to_read,
                 const std::map<int, bufferlist> &chunks,
-                std::map<int, bufferlist> *decoded, int chunk_size) override final;
+                std::map<int, bufferlist> *decoded, int chunk_size) override;
 
     virtual int _decode(const std::set<int> &want_to_read,
 			const std::map<int, bufferlist> &chunks,
@@ -146,6 +146,7 @@
 #include <ostream>
 #include <memory>
 #include <string>
+#include <errno.h>
 #include "include/buffer_fwd.h"
 
 class CrushWrapper;
@@ -370,6 +371,74 @@ namespace ceph {
     virtual int encode_chunks(const std::set<int> &want_to_encode,
                               std::map<int, bufferlist> *encoded) = 0;
 
+    /**
+     * Return true if **encode_parity_delta** is implemented, i.e. the
+     * coding chunks of a stripe can be brought up to date from the
+     * old and new content of a single data chunk, without reading
+     * the other data chunks.
+     *
+     * @return **true** if parity delta updates are supported
+     */
+    virtual bool supports_parity_delta() const { return false; }
+
+    /**
+     * Update the coding chunks in **parity** after data chunk
+     * **data_chunk** changed from **old_data** to **new_data**.
+     *
+     * **parity** must contain the current content of every coding
+     * chunk of the stripe, each as long as **old_data** and
+     * **new_data**. On success they are replaced with the content
+     * they would have if the whole stripe was encoded again.
+     *
+     * @param [in] data_chunk index of the data chunk that changed
+     * @param [in] old_data previous content of the data chunk
+     * @param [in] new_data new content of the data chunk
+     * @param [in,out] parity map coding chunk indexes to chunk data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int encode_parity_delta(int data_chunk,
+				    const bufferlist &old_data,
+				    const bufferlist &new_data,
+				    std::map<int, bufferlist> *parity) {
+      return -EOPNOTSUPP;
+    }
+
+    /**
+     * Return true if **encode_stripes** and **decode_stripes** are
+     * implemented, i.e. the code works byte column by byte column
+     * (or packet by packet) so that the chunks of consecutive stripes
+     * can be processed in a single call over contiguous shards.
+     *
+     * @return **true** if multi stripe encode and decode are supported
+     */
+    virtual bool supports_multi_stripe() const { return false; }
+
+    /**
+     * Encode **in**, made of consecutive stripes of **stripe_width**
+     * bytes, in a single call. On success **encoded** maps each chunk
+     * index in **want_to_encode** to the concatenation of that chunk
+     * for every stripe, in stripe order, which is the layout of a
+     * shard. The result is identical to calling **encode** on each
+     * stripe and appending the chunks.
+     *
+     * **stripe_width** must be a multiple of the data chunk count and
+     * require no padding, i.e. **get_chunk_size(stripe_width)** times
+     * the data chunk count must be **stripe_width**. The length of
+     * **in** must be a multiple of **stripe_width**.
+     *
+     * @param [in] want_to_encode chunk indexes to be encoded
+     * @param [in] in stripes to be encoded
+     * @param [in] stripe_width size of one stripe
+     * @param [out] encoded map chunk indexes to shard data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int encode_stripes(const std::set<int> &want_to_encode,
+			       const bufferlist &in,
+			       unsigned stripe_width,
+			       std::map<int, bufferlist> *encoded) {
+      return -EOPNOTSUPP;
+    }
+
     /**
      * Decode the **chunks** and store at least **want_to_read**
      * chunks in **decoded**.
@@ -412,6 +481,29 @@ namespace ceph {
                               const std::map<int, bufferlist> &chunks,
                               std::map<int, bufferlist> *decoded) = 0;
 
+    /**
+     * Decode **chunks**, each the concatenation of the same chunk of
+     * consecutive stripes, in a single call and store at least the
+     * **want_to_read** shards in **decoded**. The result is identical
+     * to calling **decode** for each stripe and appending the chunks.
+     *
+     * Every bufferlist in **chunks** must have the same length, a
+     * multiple of **chunk_size**. Only available when
+     * **supports_multi_stripe** returns true.
+     *
+     * @param [in] want_to_read chunk indexes to be decoded
+     * @param [in] chunks map chunk indexes to shard data
+     * @param [in] chunk_size size of the chunk of one stripe
+     * @param [out] decoded map chunk indexes to shard data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int decode_stripes(const std::set<int> &want_to_read,
+			       const std::map<int, bufferlist> &chunks,
+			       unsigned chunk_size,
+			       std::map<int, bufferlist> *decoded) {
+      return -EOPNOTSUPP;
+    }
+
     /**
      * Return the ordered list of chunks or an empty vector
      * if no remapping is necessary.
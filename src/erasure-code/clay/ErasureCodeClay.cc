@@ -0,0 +1,566 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph distributed storage system
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#include "common/debug.h"
+#include "erasure-code/ErasureCodePlugin.h"
+#include "ErasureCodeClay.h"
+
+#define dout_context g_ceph_context
+#define dout_subsys ceph_subsys_osd
+#undef dout_prefix
+#define dout_prefix _prefix(_dout)
+
+using namespace std;
+
+static ostream& _prefix(std::ostream* _dout)
+{
+  return *_dout << "ErasureCodeClay: ";
+}
+
+static int pow_int(int a, int x)
+{
+  int power = 1;
+  while (x) {
+    if (x & 1)
+      power *= a;
+    x /= 2;
+    a *= a;
+  }
+  return power;
+}
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+  while (b) {
+    unsigned r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+static bufferlist sub_chunk(bufferlist &bl, int index, unsigned sc_size)
+{
+  bufferlist r;
+  r.substr_of(bl, index * sc_size, sc_size);
+  return r;
+}
+
+static bufferlist aligned_buffer(unsigned size, bool zero)
+{
+  bufferptr ptr(buffer::create_aligned(size, ErasureCode::SIMD_ALIGN));
+  if (zero)
+    ptr.zero();
+  bufferlist bl;
+  bl.push_back(std::move(ptr));
+  return bl;
+}
+
+// the coding below writes through views of the node buffers and
+// needs each of them in one aligned piece
+static void make_contiguous(bufferlist &bl)
+{
+  if (!bl.is_contiguous() || !bl.is_aligned(ErasureCode::SIMD_ALIGN))
+    bl.rebuild_aligned_size_and_memory(bl.length(), ErasureCode::SIMD_ALIGN);
+}
+
+int ErasureCodeClay::init(ErasureCodeProfile &profile, ostream *ss)
+{
+  int r = parse(profile, ss);
+  if (r)
+    return r;
+  r = ErasureCode::init(profile, ss);
+  if (r)
+    return r;
+
+  ErasureCodePluginRegistry &registry = ErasureCodePluginRegistry::instance();
+  r = registry.factory(mds.profile["plugin"], directory, mds.profile,
+		       &mds.erasure_code, ss);
+  if (r)
+    return r;
+  r = registry.factory(pft.profile["plugin"], directory, pft.profile,
+		       &pft.erasure_code, ss);
+  if (r)
+    return r;
+
+  // every sub-chunk is coded by both scalar codes
+  unsigned a = mds.erasure_code->get_chunk_size(1);
+  unsigned b = pft.erasure_code->get_chunk_size(1);
+  sub_chunk_alignment = a / gcd(a, b) * b;
+  return 0;
+}
+
+int ErasureCodeClay::parse(ErasureCodeProfile &profile, ostream *ss)
+{
+  int err = ErasureCode::parse(profile, ss);
+  err |= to_int("k", profile, &k, DEFAULT_K, ss);
+  err |= to_int("m", profile, &m, DEFAULT_M, ss);
+  err |= sanity_check_k(k, ss);
+  err |= to_int("d", profile, &d, std::to_string(k + m - 1), ss);
+  if (err)
+    return err;
+
+  if (chunk_mapping.size() > 0) {
+    *ss << "mapping " << profile.find("mapping")->second
+	<< " is not supported by clay" << std::endl;
+    chunk_mapping.clear();
+    return -EINVAL;
+  }
+
+  if (d < k || d > k + m - 1) {
+    *ss << "value of d " << d
+	<< " must be within [ " << k << "," << k + m - 1 << "]" << std::endl;
+    return -EINVAL;
+  }
+
+  string plugin, technique;
+  err |= to_string("scalar_mds", profile, &plugin, "jerasure", ss);
+  err |= to_string("technique", profile, &technique, "reed_sol_van", ss);
+  if (err)
+    return err;
+  if (plugin == "jerasure") {
+    if (technique != "reed_sol_van" &&
+	technique != "cauchy_orig" &&
+	technique != "cauchy_good") {
+      *ss << "technique " << technique << " is not supported with "
+	  << "scalar_mds=jerasure, use one of reed_sol_van, cauchy_orig, "
+	  << "cauchy_good" << std::endl;
+      return -EINVAL;
+    }
+  } else if (plugin == "isa") {
+    if (technique != "reed_sol_van" && technique != "cauchy") {
+      *ss << "technique " << technique << " is not supported with "
+	  << "scalar_mds=isa, use one of reed_sol_van, cauchy" << std::endl;
+      return -EINVAL;
+    }
+  } else {
+    *ss << "scalar_mds " << plugin << " is not supported, use one of "
+	<< "jerasure, isa" << std::endl;
+    return -EINVAL;
+  }
+
+  q = d - k + 1;
+  nu = (k + m) % q ? q - (k + m) % q : 0;
+  t = (k + m + nu) / q;
+  sub_chunk_no = pow_int(q, t);
+  if (k + m + nu > 254) {
+    *ss << "k + m + nu = " << k + m + nu << " must be at most 254"
+	<< std::endl;
+    return -EINVAL;
+  }
+  dout(10) << __func__ << " k=" << k << " m=" << m << " d=" << d
+	   << " q=" << q << " t=" << t << " nu=" << nu
+	   << " sub_chunk_no=" << sub_chunk_no << dendl;
+
+  mds.profile["plugin"] = plugin;
+  mds.profile["technique"] = technique;
+  mds.profile["k"] = std::to_string(k + nu);
+  mds.profile["m"] = std::to_string(m);
+  mds.profile["w"] = std::to_string(w);
+
+  pft.profile["plugin"] = plugin;
+  pft.profile["technique"] = technique;
+  pft.profile["k"] = "2";
+  pft.profile["m"] = "2";
+  pft.profile["w"] = std::to_string(w);
+  return 0;
+}
+
+unsigned int ErasureCodeClay::get_chunk_size(unsigned int object_size) const
+{
+  unsigned alignment = sub_chunk_no * k * sub_chunk_alignment;
+  unsigned tail = object_size % alignment;
+  unsigned padded_length = object_size + (tail ? alignment - tail : 0);
+  assert(padded_length % k == 0);
+  return padded_length / k;
+}
+
+void ErasureCodeClay::get_plane_vector(int z, vector<int> &z_vec) const
+{
+  z_vec.resize(t);
+  for (int i = t - 1; i >= 0; i--) {
+    z_vec[i] = z % q;
+    z /= q;
+  }
+}
+
+bool ErasureCodeClay::is_repair(const set<int> &want_to_read,
+				const set<int> &available_chunks) const
+{
+  if (sub_chunk_no == 1 || want_to_read.size() != 1)
+    return false;
+  int lost = *want_to_read.begin();
+  if (available_chunks.count(lost) ||
+      available_chunks.size() < (unsigned)d)
+    return false;
+
+  // the other nodes of the lost node's row are always helpers
+  int y0 = node_of(lost) / q;
+  for (int x = 0; x < q; x++) {
+    int node = y0 * q + x;
+    if (node == node_of(lost) || is_virtual(node))
+      continue;
+    int chunk = node < k ? node : node - nu;
+    if (!available_chunks.count(chunk))
+      return false;
+  }
+  return true;
+}
+
+void ErasureCodeClay::get_repair_subchunks(
+  int lost_node,
+  vector<pair<int, int>> *repair_sub_chunks) const
+{
+  // the repair planes are those where the digit of the lost node's
+  // row is its column: runs of q^(t-1-y0) consecutive planes
+  int x0 = lost_node % q;
+  int y0 = lost_node / q;
+  int seq = pow_int(q, t - 1 - y0);
+  int runs = pow_int(q, y0);
+  for (int j = 0; j < runs; j++)
+    repair_sub_chunks->push_back(make_pair(j * q * seq + x0 * seq, seq));
+}
+
+int ErasureCodeClay::minimum_to_decode(
+  const set<int> &want_to_read,
+  const set<int> &available,
+  map<int, vector<pair<int, int>>> *minimum)
+{
+  if (!is_repair(want_to_read, available))
+    return ErasureCode::minimum_to_decode(want_to_read, available, minimum);
+
+  int lost = *want_to_read.begin();
+  int y0 = node_of(lost) / q;
+  set<int> helpers;
+  for (int x = 0; x < q; x++) {
+    int node = y0 * q + x;
+    if (node != node_of(lost) && !is_virtual(node))
+      helpers.insert(node < k ? node : node - nu);
+  }
+  for (auto i = available.begin();
+       i != available.end() && helpers.size() < (unsigned)d;
+       ++i)
+    helpers.insert(*i);
+
+  vector<pair<int, int>> sub_chunks;
+  get_repair_subchunks(node_of(lost), &sub_chunks);
+  for (auto i : helpers)
+    (*minimum)[i] = sub_chunks;
+  return 0;
+}
+
+int ErasureCodeClay::decode(const set<int> &want_to_read,
+			    const map<int, bufferlist> &chunks,
+			    map<int, bufferlist> *decoded, int chunk_size)
+{
+  set<int> avail;
+  for (auto& i : chunks)
+    avail.insert(i.first);
+
+  if (is_repair(want_to_read, avail) &&
+      (unsigned)chunk_size > chunks.begin()->second.length())
+    return repair(want_to_read, chunks, decoded, chunk_size);
+  return ErasureCode::_decode(want_to_read, chunks, decoded);
+}
+
+int ErasureCodeClay::encode_chunks(const set<int> &want_to_encode,
+				   map<int, bufferlist> *encoded)
+{
+  unsigned chunk_size = (*encoded)[0].length();
+  map<int, bufferlist> coupled;
+  set<int> parity;
+  for (int i = 0; i < k + m; i++) {
+    coupled[node_of(i)] = (*encoded)[i];
+    if (i >= k)
+      parity.insert(node_of(i));
+  }
+  for (int i = k; i < k + nu; i++)
+    coupled[i] = aligned_buffer(chunk_size, true);
+  return decode_layered(parity, &coupled);
+}
+
+int ErasureCodeClay::decode_chunks(const set<int> &want_to_read,
+				   const map<int, bufferlist> &chunks,
+				   map<int, bufferlist> *decoded)
+{
+  unsigned chunk_size = chunks.begin()->second.length();
+  map<int, bufferlist> coupled;
+  set<int> erased;
+  for (int i = 0; i < k + m; i++) {
+    coupled[node_of(i)] = (*decoded)[i];
+    if (chunks.count(i))
+      make_contiguous(coupled[node_of(i)]);
+    else
+      erased.insert(node_of(i));
+  }
+  for (int i = k; i < k + nu; i++)
+    coupled[i] = aligned_buffer(chunk_size, true);
+  return decode_layered(erased, &coupled);
+}
+
+/*
+ * The pairwise transform between node (x, y) at plane z and node
+ * (z_vec[y], y) at the plane where digit y is x instead, ordered by
+ * column so that both ends of a pair agree, is
+ *
+ *   0: C of the lower column   2: U of the lower column
+ *   1: C of the higher column  3: U of the higher column
+ *
+ * where 2 and 3 are the coding chunks of the (2, 2) code over 0 and
+ * 1.  Any two of them determine the other two.
+ */
+int ErasureCodeClay::pair_transform(const set<int> &unknown,
+				    map<int, bufferlist> &pair)
+{
+  map<int, bufferlist> known;
+  for (auto& i : pair) {
+    if (!unknown.count(i.first))
+      known[i.first] = i.second;
+  }
+  return pft.erasure_code->decode_chunks(unknown, known, &pair);
+}
+
+int ErasureCodeClay::decode_uncoupled(const set<int> &erased,
+				      const vector<int> &planes,
+				      const vector<int> &plane_index,
+				      map<int, bufferlist> &coupled,
+				      map<int, bufferlist> &uncoupled,
+				      unsigned sc_size)
+{
+  int nodes = q * t;
+  vector<int> z_vec;
+
+  // a plane only depends on planes where it intersects fewer erased
+  // nodes, so go by increasing intersection score
+  vector<vector<int>> by_score(t + 1);
+  for (auto z : planes) {
+    get_plane_vector(z, z_vec);
+    int score = 0;
+    for (auto node : erased) {
+      if (z_vec[node / q] == node % q)
+	score++;
+    }
+    by_score[score].push_back(z);
+  }
+
+  vector<bool> done(nodes * planes.size(), false);
+  for (auto& level : by_score) {
+    for (auto z : level) {
+      int iz = plane_index[z];
+      get_plane_vector(z, z_vec);
+      for (int node = 0; node < nodes; node++) {
+	if (erased.count(node) || done[node * planes.size() + iz])
+	  continue;
+	int x = node % q, y = node / q;
+	if (z_vec[y] == x) {
+	  bufferlist c = sub_chunk(coupled[node], iz, sc_size);
+	  bufferlist u = sub_chunk(uncoupled[node], iz, sc_size);
+	  memcpy(u.c_str(), c.c_str(), sc_size);
+	  done[node * planes.size() + iz] = true;
+	  continue;
+	}
+	int node_sw = y * q + z_vec[y];
+	int iz_sw = plane_index[z + (x - z_vec[y]) * pow_int(q, t - 1 - y)];
+	int lo = x < z_vec[y] ? 0 : 1;
+	map<int, bufferlist> pair;
+	pair[lo] = sub_chunk(coupled[node], iz, sc_size);
+	pair[1 - lo] = sub_chunk(coupled[node_sw], iz_sw, sc_size);
+	pair[2 + lo] = sub_chunk(uncoupled[node], iz, sc_size);
+	pair[3 - lo] = sub_chunk(uncoupled[node_sw], iz_sw, sc_size);
+	set<int> unknown;
+	if (erased.count(node_sw)) {
+	  // decoded in a plane of lower score
+	  assert(done[node_sw * planes.size() + iz_sw]);
+	  unknown = { 1 - lo, 2 + lo };
+	} else {
+	  unknown = { 2 + lo, 3 - lo };
+	  done[node_sw * planes.size() + iz_sw] = true;
+	}
+	int r = pair_transform(unknown, pair);
+	if (r)
+	  return r;
+	done[node * planes.size() + iz] = true;
+      }
+
+      map<int, bufferlist> known, all;
+      for (int node = 0; node < nodes; node++) {
+	all[node] = sub_chunk(uncoupled[node], iz, sc_size);
+	if (!erased.count(node))
+	  known[node] = all[node];
+      }
+      int r = mds.erasure_code->decode_chunks(erased, known, &all);
+      if (r)
+	return r;
+      for (auto node : erased)
+	done[node * planes.size() + iz] = true;
+    }
+  }
+  return 0;
+}
+
+int ErasureCodeClay::decode_layered(const set<int> &erased,
+				    map<int, bufferlist> *coupled)
+{
+  if (erased.empty())
+    return 0;
+  if (erased.size() > (unsigned)m)
+    return -EIO;
+
+  int nodes = q * t;
+  unsigned chunk_size = coupled->begin()->second.length();
+  assert(chunk_size % sub_chunk_no == 0);
+  unsigned sc_size = chunk_size / sub_chunk_no;
+
+  vector<int> planes(sub_chunk_no);
+  for (int z = 0; z < sub_chunk_no; z++)
+    planes[z] = z;
+  map<int, bufferlist> uncoupled;
+  for (int node = 0; node < nodes; node++)
+    uncoupled[node] = aligned_buffer(chunk_size, false);
+
+  int r = decode_uncoupled(erased, planes, planes, *coupled, uncoupled,
+			   sc_size);
+  if (r)
+    return r;
+
+  // every uncoupled sub-chunk is known, couple the erased nodes back
+  vector<int> z_vec;
+  for (int z = 0; z < sub_chunk_no; z++) {
+    get_plane_vector(z, z_vec);
+    for (auto node : erased) {
+      int x = node % q, y = node / q;
+      if (z_vec[y] == x) {
+	bufferlist c = sub_chunk((*coupled)[node], z, sc_size);
+	bufferlist u = sub_chunk(uncoupled[node], z, sc_size);
+	memcpy(c.c_str(), u.c_str(), sc_size);
+	continue;
+      }
+      int node_sw = y * q + z_vec[y];
+      bool sw_erased = erased.count(node_sw);
+      if (sw_erased && x > z_vec[y])
+	continue;	// done along with the other end of the pair
+      int z_sw = z + (x - z_vec[y]) * pow_int(q, t - 1 - y);
+      int lo = x < z_vec[y] ? 0 : 1;
+      map<int, bufferlist> pair;
+      pair[lo] = sub_chunk((*coupled)[node], z, sc_size);
+      pair[1 - lo] = sub_chunk((*coupled)[node_sw], z_sw, sc_size);
+      pair[2 + lo] = sub_chunk(uncoupled[node], z, sc_size);
+      pair[3 - lo] = sub_chunk(uncoupled[node_sw], z_sw, sc_size);
+      set<int> unknown = { lo };
+      if (sw_erased)
+	unknown.insert(1 - lo);
+      r = pair_transform(unknown, pair);
+      if (r)
+	return r;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Repair the lost node (x0, y0) from the repair planes, where digit
+ * y0 is x0, of d helpers.  The nodes that are neither helpers nor
+ * lost are aloof.  In each repair plane the unknown uncoupled
+ * sub-chunks are those of the lost node, of the other nodes of row
+ * y0 (paired with the lost node outside the repair planes) and of
+ * the aloof nodes: m of them, which the scalar code can decode.  The
+ * lost node is then coupled back from the row y0 pairs.
+ */
+int ErasureCodeClay::repair(const set<int> &want_to_read,
+			    const map<int, bufferlist> &chunks,
+			    map<int, bufferlist> *repaired, int chunk_size)
+{
+  assert(want_to_read.size() == 1);
+  if (chunk_size % sub_chunk_no)
+    return -EINVAL;
+  int nodes = q * t;
+  unsigned sc_size = chunk_size / sub_chunk_no;
+  unsigned repair_size = sub_chunk_no / q * sc_size;
+  for (auto& i : chunks) {
+    if (i.second.length() != repair_size) {
+      dout(0) << __func__ << " chunk " << i.first << " is "
+	      << i.second.length() << " bytes, expected " << repair_size
+	      << dendl;
+      return -EINVAL;
+    }
+  }
+
+  int lost = *want_to_read.begin();
+  int lost_node = node_of(lost);
+  int x0 = lost_node % q, y0 = lost_node / q;
+
+  vector<pair<int, int>> ranges;
+  get_repair_subchunks(lost_node, &ranges);
+  vector<int> planes;
+  vector<int> plane_index(sub_chunk_no, -1);
+  for (auto& range : ranges) {
+    for (int z = range.first; z < range.first + range.second; z++) {
+      plane_index[z] = planes.size();
+      planes.push_back(z);
+    }
+  }
+
+  map<int, bufferlist> coupled, uncoupled;
+  set<int> erased;
+  for (auto& i : chunks) {
+    coupled[node_of(i.first)] = i.second;
+    make_contiguous(coupled[node_of(i.first)]);
+  }
+  for (int node = 0; node < nodes; node++) {
+    if (is_virtual(node))
+      coupled[node] = aligned_buffer(repair_size, true);
+    else if (!coupled.count(node))
+      coupled[node] = aligned_buffer(repair_size, false);  // lost or aloof
+    if (node / q == y0 ||
+	(!is_virtual(node) && !chunks.count(node < k ? node : node - nu)))
+      erased.insert(node);
+    uncoupled[node] = aligned_buffer(repair_size, false);
+  }
+  if (erased.size() > (unsigned)m)
+    return -EIO;
+
+  int r = decode_uncoupled(erased, planes, plane_index, coupled, uncoupled,
+			   sc_size);
+  if (r)
+    return r;
+
+  bufferlist out = aligned_buffer(chunk_size, false);
+  bufferlist scratch = aligned_buffer(sc_size, false);
+  int seq = pow_int(q, t - 1 - y0);
+  for (auto z : planes) {
+    int iz = plane_index[z];
+    bufferlist c = sub_chunk(out, z, sc_size);
+    bufferlist u = sub_chunk(uncoupled[lost_node], iz, sc_size);
+    memcpy(c.c_str(), u.c_str(), sc_size);
+    for (int x = 0; x < q; x++) {
+      if (x == x0)
+	continue;
+      int node = y0 * q + x;
+      int z_sw = z + (x - x0) * seq;
+      int lo = x < x0 ? 0 : 1;
+      map<int, bufferlist> pair;
+      pair[lo] = sub_chunk(coupled[node], iz, sc_size);
+      pair[1 - lo] = sub_chunk(out, z_sw, sc_size);
+      pair[2 + lo] = sub_chunk(uncoupled[node], iz, sc_size);
+      pair[3 - lo] = scratch;
+      r = pair_transform({ 1 - lo, 3 - lo }, pair);
+      if (r)
+	return r;
+    }
+  }
+  (*repaired)[lost] = out;
+  return 0;
+}
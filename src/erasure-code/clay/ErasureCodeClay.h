@@ -0,0 +1,136 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph distributed storage system
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef CEPH_ERASURE_CODE_CLAY_H
+#define CEPH_ERASURE_CODE_CLAY_H
+
+#include "erasure-code/ErasureCode.h"
+
+/**
+ * Coupled-layer (clay) minimum storage regenerating code.
+ *
+ * The k + m chunks (plus nu zero filled virtual chunks, so that q
+ * divides their count) are laid out as a q x t grid of nodes, and
+ * every chunk is split into q^t sub-chunks, one per plane.  Within a
+ * plane the "uncoupled" sub-chunks form a codeword of a scalar MDS
+ * code with k + nu data chunks.  The stored "coupled" sub-chunks are
+ * derived from the uncoupled ones by a pairwise transform between
+ * nodes of the same grid row, itself a (2,2) scalar MDS code.
+ *
+ * Any m erased chunks can be decoded as with a scalar code.  A
+ * single lost chunk can also be repaired from d helpers reading
+ * only 1/q of each helper chunk, instead of reading k full chunks.
+ */
+class ErasureCodeClay : public ErasureCode {
+public:
+  std::string DEFAULT_K{"4"};
+  std::string DEFAULT_M{"2"};
+  int k = 0, m = 0, d = 0, w = 8;
+  int q = 0, t = 0, nu = 0;
+  int sub_chunk_no = 0;
+  unsigned sub_chunk_alignment = 0;
+
+  std::string directory;
+
+  struct ScalarMDS {
+    ErasureCodeInterfaceRef erasure_code;
+    ErasureCodeProfile profile;
+  };
+  ScalarMDS mds;	///< (k + nu, m) code of each plane
+  ScalarMDS pft;	///< (2, 2) code of the pairwise transform
+
+  explicit ErasureCodeClay(const std::string &dir)
+    : directory(dir)
+  {}
+
+  ~ErasureCodeClay() override {}
+
+  unsigned int get_chunk_count() const override {
+    return k + m;
+  }
+
+  unsigned int get_data_chunk_count() const override {
+    return k;
+  }
+
+  int get_sub_chunk_count() override {
+    return sub_chunk_no;
+  }
+
+  unsigned int get_chunk_size(unsigned int object_size) const override;
+
+  int minimum_to_decode(const std::set<int> &want_to_read,
+			const std::set<int> &available,
+			std::map<int, std::vector<std::pair<int, int>>> *minimum) override;
+
+  int decode(const std::set<int> &want_to_read,
+	     const std::map<int, bufferlist> &chunks,
+	     std::map<int, bufferlist> *decoded, int chunk_size) override;
+
+  int encode_chunks(const std::set<int> &want_to_encode,
+		    std::map<int, bufferlist> *encoded) override;
+
+  int decode_chunks(const std::set<int> &want_to_read,
+		    const std::map<int, bufferlist> &chunks,
+		    std::map<int, bufferlist> *decoded) override;
+
+  int init(ErasureCodeProfile &profile, std::ostream *ss) override;
+
+  /// true if the chunk in want_to_read can be repaired from sub-chunks
+  bool is_repair(const std::set<int> &want_to_read,
+		 const std::set<int> &available_chunks) const;
+
+  /// sub-chunk ranges (offset, count) to read from every helper
+  void get_repair_subchunks(int lost_node,
+			    std::vector<std::pair<int, int>> *repair_sub_chunks) const;
+
+private:
+  int parse(ErasureCodeProfile &profile, std::ostream *ss);
+
+  int node_of(int chunk) const {
+    return chunk < k ? chunk : chunk + nu;
+  }
+
+  bool is_virtual(int node) const {
+    return node >= k && node < k + nu;
+  }
+
+  void get_plane_vector(int z, std::vector<int> &z_vec) const;
+
+  int repair(const std::set<int> &want_to_read,
+	     const std::map<int, bufferlist> &chunks,
+	     std::map<int, bufferlist> *repaired, int chunk_size);
+
+  int decode_layered(const std::set<int> &erased,
+		     std::map<int, bufferlist> *coupled);
+
+  /**
+   * Compute the uncoupled sub-chunks of every node for the planes
+   * in **planes**, processed by increasing number of **erased** nodes
+   * they intersect.  The coupled sub-chunks of the nodes outside
+   * **erased** must be known for those planes.  Buffers only hold the
+   * planes in **planes**, and plane_index maps a plane to its
+   * position in them.
+   */
+  int decode_uncoupled(const std::set<int> &erased,
+		       const std::vector<int> &planes,
+		       const std::vector<int> &plane_index,
+		       std::map<int, bufferlist> &coupled,
+		       std::map<int, bufferlist> &uncoupled,
+		       unsigned sc_size);
+
+  /// solve the pairwise transform for the positions in **unknown**
+  int pair_transform(const std::set<int> &unknown,
+		     std::map<int, bufferlist> &pair);
+};
+
+#endif
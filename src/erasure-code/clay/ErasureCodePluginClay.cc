@@ -0,0 +1,46 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph distributed storage system
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include "ceph_ver.h"
+#include "common/debug.h"
+#include "ErasureCodePluginClay.h"
+#include "ErasureCodeClay.h"
+
+#define dout_subsys ceph_subsys_osd
+#undef dout_prefix
+#define dout_prefix _prefix(_dout)
+
+int ErasureCodePluginClay::factory(const std::string &directory,
+				   ErasureCodeProfile &profile,
+				   ErasureCodeInterfaceRef *erasure_code,
+				   std::ostream *ss) {
+  ErasureCodeClay *interface = new ErasureCodeClay(directory);
+  int r = interface->init(profile, ss);
+  if (r) {
+    delete interface;
+    return r;
+  }
+  *erasure_code = ErasureCodeInterfaceRef(interface);
+  return 0;
+}
+
+#ifndef BUILDING_FOR_EMBEDDED
+
+const char *__erasure_code_version() { return CEPH_GIT_NICE_VER; }
+
+int __erasure_code_init(char *plugin_name, char *directory)
+{
+  ErasureCodePluginRegistry &instance = ErasureCodePluginRegistry::instance();
+  return instance.add(plugin_name, new ErasureCodePluginClay());
+}
+
+#endif
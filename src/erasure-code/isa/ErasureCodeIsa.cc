@@ -214,16 +214,42 @@ ErasureCodeIsaDefault::isa_decode(int *erasures,
     return 0;
   }
 
+  if (nerrs > m)
+    return -1;
+
+  bufferptr decode_tbls;
+  if (get_decoding_table(erasures, nerrs, &decode_tbls) < 0)
+    return -1;
+
+  // Recover data sources
+  ec_encode_data(blocksize,
+                 k, nerrs, (unsigned char*) decode_tbls.c_str(),
+                 recover_source, recover_target);
+
+
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+int
+ErasureCodeIsaDefault::get_decoding_table(int *erasures,
+                                          int nerrs,
+                                          bufferptr *decode_tbls)
+{
+  int i, r;
   unsigned char d[k * (m + k)];
-  unsigned char decode_tbls[k * (m + k)*32];
-  unsigned char *p_tbls = decode_tbls;
 
   int decode_index[k];
 
-  if (nerrs > m)
-    return -1;
-
-  std::string erasure_signature; // describes a matrix configuration for caching
+  // describes a matrix configuration for caching, the cache is shared
+  // by all (k,m) profiles using the same matrix type
+  std::string erasure_signature;
+  {
+    char id[128];
+    snprintf(id, sizeof (id), "k%dm%d", k, m);
+    erasure_signature += id;
+  }
 
   // ---------------------------------------------
   // Construct b by removing error rows
@@ -249,10 +275,12 @@ ErasureCodeIsaDefault::isa_decode(int *erasures,
   // ---------------------------------------------
   // Try to get an already computed matrix
   // ---------------------------------------------
-  if (!tcache.getDecodingTableFromCache(erasure_signature, p_tbls, matrixtype, k, m)) {
+  if (!tcache.getDecodingTableFromCache(erasure_signature, decode_tbls,
+                                        matrixtype)) {
     int j;
     unsigned char b[k * (m + k)];
     unsigned char c[k * (m + k)];
+    unsigned char tbls[k * (m + k)*32];
 
     for (i = 0; i < k; i++) {
       r = decode_index[i];
@@ -298,15 +326,44 @@ ErasureCodeIsaDefault::isa_decode(int *erasures,
     // ---------------------------------------------
     // Initialize Decoding Table
     // ---------------------------------------------
-    ec_init_tables(k, nerrs, c, decode_tbls);
-    tcache.putDecodingTableToCache(erasure_signature, p_tbls, matrixtype, k, m);
+    ec_init_tables(k, nerrs, c, tbls);
+    *decode_tbls = tcache.putDecodingTableToCache(erasure_signature, tbls,
+                                                  sizeof (tbls), matrixtype);
   }
-  // Recover data sources
-  ec_encode_data(blocksize,
-                 k, nerrs, decode_tbls, recover_source, recover_target);
+  return 0;
+}
 
+// -----------------------------------------------------------------------------
 
-  return 0;
+void
+ErasureCodeIsaDefault::prewarm_decoding_tables()
+{
+  // single parity codes always decode with xor
+  if (m == 1)
+    return;
+
+  if (!tcache.claimDecodingTablePrewarm(matrixtype, k, m))
+    return;
+
+  dout(10) << "[ cache tables ] prewarming decoding tables for k=" <<
+    k << " m=" << m << dendl;
+
+  int erasures[3];
+  bufferptr table;
+  for (int e0 = 0; e0 < k + m; e0++) {
+    // single erasures served by xor decoding need no table
+    if (!((matrixtype == kVandermonde) && (e0 < (k + 1)))) {
+      erasures[0] = e0;
+      erasures[1] = -1;
+      get_decoding_table(erasures, 1, &table);
+    }
+    for (int e1 = e0 + 1; e1 < k + m; e1++) {
+      erasures[0] = e0;
+      erasures[1] = e1;
+      erasures[2] = -1;
+      get_decoding_table(erasures, 2, &table);
+    }
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -417,5 +474,6 @@ ErasureCodeIsaDefault::prepare()
 
   assert((matrixtype == kVandermonde) || (matrixtype == kCauchy));
 
+  prewarm_decoding_tables();
 }
 // -----------------------------------------------------------------------------
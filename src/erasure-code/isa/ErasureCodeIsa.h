@@ -76,6 +76,17 @@ public:
   int encode_chunks(const std::set<int> &want_to_encode,
                             std::map<int, bufferlist> *encoded) override;
 
+  // both matrix types (and the m=1 xor codec) are linear over xor
+  bool supports_parity_delta() const override {
+    return true;
+  }
+
+  // ... and code one byte column at a time, so consecutive stripes
+  // can be coded in one call over whole shards
+  bool supports_multi_stripe() const override {
+    return true;
+  }
+
   int decode_chunks(const std::set<int> &want_to_read,
                             const std::map<int, bufferlist> &chunks,
                             std::map<int, bufferlist> *decoded) override;
@@ -145,6 +156,17 @@ public:
 
   void prepare() override;
 
+  /**
+   * Get the decoding table for the **nerrs** chunks listed in
+   * **erasures**, from the shared cache or by computing and caching it.
+   *
+   * @return 0 on success or -1 if the decoding matrix is not invertible
+   */
+  int get_decoding_table(int *erasures, int nerrs, bufferptr *decode_tbls);
+
+  /// cache the decoding tables of every single and double erasure
+  void prewarm_decoding_tables();
+
  private:
   int parse(ErasureCodeProfile &profile,
                     std::ostream *ss) override;
@@ -110,6 +110,15 @@ ErasureCodeIsaTableCache::getDecodingTableCacheSize(int matrixtype)
 
 // -----------------------------------------------------------------------------
 
+bool
+ErasureCodeIsaTableCache::claimDecodingTablePrewarm(int matrixtype, int k, int m)
+{
+  Mutex::Locker lock(codec_tables_guard);
+  return decoding_tables_prewarmed.insert(std::make_tuple(matrixtype, k, m)).second;
+}
+
+// -----------------------------------------------------------------------------
+
 ErasureCodeIsaTableCache::lru_map_t*
 ErasureCodeIsaTableCache::getDecodingTables(int matrix_type)
 {
@@ -230,12 +239,62 @@ ErasureCodeIsaTableCache::getLock()
 
 // -----------------------------------------------------------------------------
 
+namespace {
+
+// small per-thread copy of the decoding tables used last; the tables
+// never change once cached, so an entry found here is always valid
+struct thread_decoding_table {
+  const void *owner;
+  int matrixtype;
+  std::string signature;
+  bufferptr table;
+};
+
+struct thread_decoding_tables {
+  std::vector<thread_decoding_table> entries;
+  unsigned next = 0;
+};
+
+thread_local thread_decoding_tables thread_tables;
+
 bool
-ErasureCodeIsaTableCache::getDecodingTableFromCache(std::string &signature,
-                                                    unsigned char* &table,
-                                                    int matrixtype,
-                                                    int k,
-                                                    int m)
+thread_tables_lookup(const void *owner, int matrixtype,
+                     const std::string &signature, bufferptr *table)
+{
+  for (const auto &e : thread_tables.entries) {
+    if (e.owner == owner && e.matrixtype == matrixtype &&
+        e.signature == signature) {
+      *table = e.table;
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+thread_tables_insert(const void *owner, int matrixtype,
+                     const std::string &signature, const bufferptr &table)
+{
+  thread_decoding_table e{owner, matrixtype, signature, table};
+  if ((int) thread_tables.entries.size() <
+      ErasureCodeIsaTableCache::decoding_tables_thread_length) {
+    thread_tables.entries.push_back(std::move(e));
+  } else {
+    // replace the oldest entry
+    thread_tables.entries[thread_tables.next] = std::move(e);
+    thread_tables.next = (thread_tables.next + 1) %
+      ErasureCodeIsaTableCache::decoding_tables_thread_length;
+  }
+}
+
+} // anonymous namespace
+
+// -----------------------------------------------------------------------------
+
+bool
+ErasureCodeIsaTableCache::getDecodingTableFromCache(const std::string &signature,
+                                                    bufferptr *table,
+                                                    int matrixtype)
 {
   // --------------------------------------------------------------------------
   // LRU decoding matrix cache
@@ -243,38 +302,50 @@ ErasureCodeIsaTableCache::getDecodingTableFromCache(std::string &signature,
 
   dout(12) << "[ get table    ] = " << signature << dendl;
 
-  // we try to fetch a decoding table from an LRU cache
+  if (thread_tables_lookup(this, matrixtype, signature, table)) {
+    ++decoding_table_hits;
+    return true;
+  }
+
+  // we try to fetch a decoding table from the shared LRU cache
   bool found = false;
 
-  Mutex::Locker lock(codec_tables_guard);
+  {
+    Mutex::Locker lock(codec_tables_guard);
 
-  lru_map_t* decode_tbls_map =
-    getDecodingTables(matrixtype);
+    lru_map_t* decode_tbls_map =
+      getDecodingTables(matrixtype);
 
-  lru_list_t* decode_tbls_lru =
-    getDecodingTablesLru(matrixtype);
+    lru_list_t* decode_tbls_lru =
+      getDecodingTablesLru(matrixtype);
 
-  if (decode_tbls_map->count(signature)) {
-    dout(12) << "[ cached table ] = " << signature << dendl;
-    // copy the table out of the cache
-    memcpy(table, (*decode_tbls_map)[signature].second.c_str(), k * (m + k)*32);
-    // find item in LRU queue and push back
-    dout(12) << "[ cache size   ] = " << decode_tbls_lru->size() << dendl;
-    decode_tbls_lru->splice( (decode_tbls_lru->begin()), *decode_tbls_lru, (*decode_tbls_map)[signature].first);
-    found = true;
+    lru_map_t::iterator it = decode_tbls_map->find(signature);
+    if (it != decode_tbls_map->end()) {
+      dout(12) << "[ cached table ] = " << signature << dendl;
+      *table = it->second.second;
+      // find item in LRU queue and push back
+      dout(12) << "[ cache size   ] = " << decode_tbls_lru->size() << dendl;
+      decode_tbls_lru->splice( (decode_tbls_lru->begin()), *decode_tbls_lru, it->second.first);
+      found = true;
+    }
   }
 
+  if (found) {
+    ++decoding_table_hits;
+    thread_tables_insert(this, matrixtype, signature, *table);
+  } else {
+    ++decoding_table_misses;
+  }
   return found;
 }
 
 // -----------------------------------------------------------------------------
 
-void
-ErasureCodeIsaTableCache::putDecodingTableToCache(std::string &signature,
-                                                  unsigned char* &table,
-                                                  int matrixtype,
-                                                  int k,
-                                                  int m)
+bufferptr
+ErasureCodeIsaTableCache::putDecodingTableToCache(const std::string &signature,
+                                                  const unsigned char *table,
+                                                  unsigned length,
+                                                  int matrixtype)
 {
   // --------------------------------------------------------------------------
   // LRU decoding matrix cache
@@ -282,46 +353,42 @@ ErasureCodeIsaTableCache::putDecodingTableToCache(std::string &signature,
 
   dout(12) << "[ put table    ] = " << signature << dendl;
 
-  // we store a new table to the cache
-
-  bufferptr cachetable;
-
-  Mutex::Locker lock(codec_tables_guard);
-
-  lru_map_t* decode_tbls_map =
-    getDecodingTables(matrixtype);
-
-  lru_list_t* decode_tbls_lru =
-    getDecodingTablesLru(matrixtype);
-
-  // evt. shrink the LRU queue/map
-  if ((int) decode_tbls_lru->size() >= ErasureCodeIsaTableCache::decoding_tables_lru_length) {
-    dout(12) << "[ shrink lru   ] = " << signature << dendl;
-    // reuse old buffer
-    cachetable = (*decode_tbls_map)[decode_tbls_lru->back()].second;
-
-    if ((int) cachetable.length() != (k * (m + k)*32)) {
-      // we need to replace this with a different size buffer
-      cachetable = buffer::create(k * (m + k)*32);
+  // we store a new table to the cache; evicted buffers are never reused
+  // since other threads may still hold references to them
+
+  bufferptr cachetable = buffer::create(length);
+  memcpy(cachetable.c_str(), table, length);
+
+  {
+    Mutex::Locker lock(codec_tables_guard);
+
+    lru_map_t* decode_tbls_map =
+      getDecodingTables(matrixtype);
+
+    lru_list_t* decode_tbls_lru =
+      getDecodingTablesLru(matrixtype);
+
+    lru_map_t::iterator it = decode_tbls_map->find(signature);
+    if (it != decode_tbls_map->end()) {
+      // somebody might have deposited this table in the meanwhile
+      cachetable = it->second.second;
+      decode_tbls_lru->splice( (decode_tbls_lru->begin()), *decode_tbls_lru, it->second.first);
+    } else {
+      // evt. shrink the LRU queue/map
+      if ((int) decode_tbls_lru->size() >= ErasureCodeIsaTableCache::decoding_tables_lru_length) {
+        dout(12) << "[ shrink lru   ] = " << signature << dendl;
+        // remove from map
+        decode_tbls_map->erase(decode_tbls_lru->back());
+        // remove from lru
+        decode_tbls_lru->pop_back();
+      }
+      dout(12) << "[ store table  ] = " << signature << dendl;
+      decode_tbls_lru->push_front(signature);
+      (*decode_tbls_map)[signature] = std::make_pair(decode_tbls_lru->begin(), cachetable);
+      dout(12) << "[ cache size   ] = " << decode_tbls_lru->size() << dendl;
     }
-
-    // remove from map
-    decode_tbls_map->erase(decode_tbls_lru->back());
-    // remove from lru
-    decode_tbls_lru->pop_back();
-    // add to the head of lru
-    decode_tbls_lru->push_front(signature);
-    // add the new to the map
-    (*decode_tbls_map)[signature] = std::make_pair(decode_tbls_lru->begin(), cachetable);
-  } else {
-    dout(12) << "[ store table  ] = " << signature << dendl;
-    // allocate a new buffer
-    cachetable = buffer::create(k * (m + k)*32);
-    decode_tbls_lru->push_front(signature);
-    (*decode_tbls_map)[signature] = std::make_pair(decode_tbls_lru->begin(), cachetable);
-    dout(12) << "[ cache size   ] = " << decode_tbls_lru->size() << dendl;
   }
 
-  // copy-in the new table
-  memcpy(cachetable.c_str(), table, k * (m + k)*32);
+  thread_tables_insert(this, matrixtype, signature, cachetable);
+  return cachetable;
 }
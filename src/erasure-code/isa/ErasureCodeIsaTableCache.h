@@ -29,7 +29,10 @@
 #include "common/Mutex.h"
 #include "erasure-code/ErasureCodeInterface.h"
 // -----------------------------------------------------------------------------
+#include <atomic>
 #include <list>
+#include <set>
+#include <tuple>
 // -----------------------------------------------------------------------------
 
 class ErasureCodeIsaTableCache {
@@ -47,6 +50,11 @@ public:
 
   static const int decoding_tables_lru_length = 2516;
 
+  // decoding tables only depend on their signature and never change,
+  // so each thread keeps the ones it used last and finds them again
+  // without taking codec_tables_guard
+  static const int decoding_tables_thread_length = 64;
+
   typedef std::pair<std::list<std::string>::iterator, bufferptr> lru_entry_t;
   typedef std::map< int, unsigned char** > codec_table_t;
   typedef std::map< int, codec_table_t > codec_tables_t;
@@ -56,7 +64,9 @@ public:
   typedef std::list< std::string > lru_list_t;
 
   ErasureCodeIsaTableCache() :
-  codec_tables_guard("isa-lru-cache")
+  codec_tables_guard("isa-lru-cache"),
+  decoding_table_hits(0),
+  decoding_table_misses(0)
   {
   }
 
@@ -64,17 +74,18 @@ public:
 
   Mutex codec_tables_guard; // mutex used to protect modifications in encoding/decoding table maps
 
-  bool getDecodingTableFromCache(std::string &signature,
-                                 unsigned char* &table,
-                                 int matrixtype,
-                                 int k,
-                                 int m);
+  // the signature must identify k, m and the erasures; on a hit
+  // table references the cached table, which stays valid as long as
+  // the reference is held
+  bool getDecodingTableFromCache(const std::string &signature,
+                                 bufferptr *table,
+                                 int matrixtype);
 
-  void putDecodingTableToCache(std::string&,
-                               unsigned char*&,
-                               int matrixtype,
-                               int k,
-                               int m);
+  // store a copy of table and return a reference to it
+  bufferptr putDecodingTableToCache(const std::string &signature,
+                                    const unsigned char *table,
+                                    unsigned length,
+                                    int matrixtype);
 
   unsigned char** getEncodingTable(int matrix, int k, int m);
   unsigned char** getEncodingCoefficient(int matrix, int k, int m);
@@ -87,6 +98,16 @@ public:
 
   int getDecodingTableCacheSize(int matrixtype = 0);
 
+  // true for the first caller only for a given (matrixtype, k, m)
+  bool claimDecodingTablePrewarm(int matrixtype, int k, int m);
+
+  uint64_t getDecodingTableHits() const {
+    return decoding_table_hits;
+  }
+  uint64_t getDecodingTableMisses() const {
+    return decoding_table_misses;
+  }
+
 private:
   codec_technique_tables_t encoding_coefficient; // encoding coefficients accessed via table[matrix][k][m]
   codec_technique_tables_t encoding_table; // encoding coefficients accessed via table[matrix][k][m]
@@ -98,6 +119,11 @@ private:
 
   lru_list_t* getDecodingTablesLru(int matrix_type);
 
+  std::set<std::tuple<int, int, int>> decoding_tables_prewarmed;
+
+  std::atomic<uint64_t> decoding_table_hits;
+  std::atomic<uint64_t> decoding_table_misses;
+
   Mutex* getLock();
 
 };
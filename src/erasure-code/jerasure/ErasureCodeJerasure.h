@@ -59,6 +59,18 @@ public:
   int encode_chunks(const std::set<int> &want_to_encode,
 			    std::map<int, bufferlist> *encoded) override;
 
+  // all jerasure techniques are linear over xor
+  bool supports_parity_delta() const override {
+    return true;
+  }
+
+  // ... and code one word (or one w * packetsize group for the bit
+  // matrix techniques) at a time, so consecutive stripes can be coded
+  // in one call over whole shards
+  bool supports_multi_stripe() const override {
+    return true;
+  }
+
   int decode_chunks(const std::set<int> &want_to_read,
 			    const std::map<int, bufferlist> &chunks,
 			    std::map<int, bufferlist> *decoded) override;
@@ -427,6 +427,10 @@ namespace buffer CEPH_BUFFER_API {
       /// calculate crc from iterator position
       uint32_t crc32c(size_t length, uint32_t crc);
 
+      /// calculate the crcs of consecutive blocks from iterator position
+      void crc32c_blocks(size_t block_size, size_t blocks, uint32_t crc,
+			 uint32_t *crcs);
+
       friend bool operator==(const iterator_impl& lhs,
 			     const iterator_impl& rhs) {
 	return &lhs.get_bl() == &rhs.get_bl() && lhs.get_off() == rhs.get_off();
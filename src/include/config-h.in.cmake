@@ -87,9 +87,15 @@
 /* Defined if you have LZ4 */
 #cmakedefine HAVE_LZ4
 
+/* Defined if you have QATzip */
+#cmakedefine HAVE_QATZIP
+
 /* Defined if you have libaio */
 #cmakedefine HAVE_LIBAIO
 
+/* Defined if liburing is available (io_uring based bdev) */
+#cmakedefine HAVE_LIBURING
+
 /* Defined if OpenLDAP enabled */
 #cmakedefine HAVE_OPENLDAP
 
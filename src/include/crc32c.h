@@ -50,6 +50,33 @@ static inline uint32_t ceph_crc32c(uint32_t crc, unsigned char const *data, unsi
   return ceph_crc32c_func(crc, data, length);
 }
 
+/**
+ * calculate the crc32c of the concatenation of two buffers
+ *
+ * Note: this only reads the crcs of both parts, not their data.
+ *
+ * @param crc_a crc32c of the first buffer, for any initial value
+ * @param crc_b crc32c of the second buffer, with an initial value of 0
+ * @param length_b length of the second buffer
+ * @return crc32c of both buffers, for the initial value of crc_a
+ */
+uint32_t ceph_crc32c_combine(uint32_t crc_a, uint32_t crc_b, unsigned length_b);
+
+/**
+ * calculate crc32c of several independent buffers of the same length
+ *
+ * Interleaves the buffers where the CPU can overlap crc instructions,
+ * which is faster than calling ceph_crc32c() on each of them in turn.
+ *
+ * @param crc initial value used for every buffer
+ * @param data pointers to the buffers, none of them NULL
+ * @param length length of each buffer
+ * @param count number of buffers
+ * @param out filled with the crc32c of each buffer
+ */
+void ceph_crc32c_multi(uint32_t crc, unsigned char const *const *data,
+		       unsigned length, unsigned count, uint32_t *out);
+
 #ifdef __cplusplus
 }
 #endif
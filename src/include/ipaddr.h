@@ -24,4 +24,12 @@ const struct ifaddrs *find_ip_in_subnet(const struct ifaddrs *addrs,
  */
 bool parse_network(const char *s, struct sockaddr_storage *network, unsigned int *prefix_len);
 
+/*
+ * Return true if addr is inside network/prefix_len (as returned by
+ * parse_network); addresses of a different family never match.
+ */
+bool network_contains(const struct sockaddr_storage &network,
+		      unsigned int prefix_len,
+		      const struct sockaddr *addr);
+
 #endif
@@ -156,6 +156,7 @@ namespace mempool {
   f(buffer_meta)		      \
   f(osd)			      \
   f(osd_mapbl)			      \
+  f(osd_op)			      \
   f(osd_pglog)			      \
   f(osdmap)			      \
   f(osdmap_mapping)		      \
@@ -215,6 +216,9 @@ struct stats_t {
 pool_t& get_pool(pool_index_t ix);
 const char *get_pool_name(pool_index_t ix);
 
+/// round-robin source of per-thread shard indexes
+extern std::atomic<size_t> next_shard;
+
 struct type_t {
   const char *type_name;
   size_t item_size;
@@ -243,11 +247,13 @@ public:
   void adjust_count(ssize_t items, ssize_t bytes);
 
   shard_t* pick_a_shard() {
-    // Dirt cheap, see:
-    //   http://fossies.org/dox/glibc-2.24/pthread__self_8c_source.html
-    size_t me = (size_t)pthread_self();
-    size_t i = (me >> 3) & ((1 << num_shard_bits) - 1);
-    return &shard[i];
+    // pthread_self() values are stack-aligned and tend to share their
+    // low bits, which piled busy threads onto the same shard.  Hand out
+    // shards round-robin instead, once per thread.
+    static thread_local size_t me =
+      next_shard.fetch_add(1, std::memory_order_relaxed) &
+      ((1 << num_shard_bits) - 1);
+    return &shard[me];
   }
 
   type_t *get_type(const std::type_info& ti, size_t size) {
@@ -417,6 +423,13 @@ public:
     using unordered_map =						\
       std::unordered_map<k,v,h,eq,pool_allocator<std::pair<const k,v>>>;\
                                                                         \
+    template<typename k, typename v,					\
+	     typename h=std::hash<k>,					\
+	     typename eq = std::equal_to<k>>				\
+    using unordered_multimap =						\
+      std::unordered_multimap<k,v,h,eq,					\
+			      pool_allocator<std::pair<const k,v>>>;	\
+                                                                        \
     inline size_t allocated_bytes() {					\
       return mempool::get_pool(id).allocated_bytes();			\
     }									\
@@ -120,6 +120,9 @@ struct ceph_msg_connect_reply {
 } __attribute__ ((packed));
 
 #define CEPH_MSG_CONNECT_LOSSY  1  /* messages i send may be safely dropped */
+#define CEPH_MSG_CONNECT_SECURE 2  /* encrypt message segments on the wire */
+#define CEPH_MSG_CONNECT_LANE_SHIFT 4 /* upper bits: session lane to this peer */
+#define CEPH_MSG_CONNECT_LANE_MAX   16
 
 
 /*
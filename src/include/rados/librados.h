@@ -303,6 +303,20 @@ struct rados_cluster_stat_t {
   uint64_t num_objects;
 };
 
+/**
+ * @struct rados_aio_latency
+ * Where the time of one asynchronous operation went, in nanoseconds.
+ * Filled in by rados_aio_get_latency().
+ */
+struct rados_aio_latency {
+  uint64_t submit_ns;    /* submission until last sent to an osd (throttles,
+			    map waits, resends) */
+  uint64_t osd_ns;       /* last send until the reply (network and osd) */
+  uint64_t complete_ns;  /* reply until the completion was marked complete */
+  uint64_t dispatch_ns;  /* complete until the callback started, 0 if the
+			    completion has no callback */
+};
+
 /**
  * @typedef rados_write_op_t
  *
@@ -356,6 +370,14 @@ typedef void *rados_read_op_t;
  */
 typedef void *rados_completion_t;
 
+/**
+ * @typedef rados_completion_queue_t
+ * Collects finished completions so that application threads can reap
+ * them in batches (see rados_aio_cq_wait()) instead of getting a
+ * callback per operation from librados' finisher thread.
+ */
+typedef void *rados_completion_queue_t;
+
 /**
  * @struct blkin_trace_info
  * blkin trace information for Zipkin tracing
@@ -1844,6 +1866,56 @@ CEPH_RADOS_API int rados_aio_create_completion(void *cb_arg,
                                                rados_callback_t cb_safe,
 				               rados_completion_t *pc);
 
+/**
+ * Create a completion queue
+ *
+ * @param pcq where to store the queue
+ * @returns 0
+ */
+CEPH_RADOS_API int rados_aio_cq_create(rados_completion_queue_t *pcq);
+
+/**
+ * Destroy a completion queue
+ *
+ * All completions created on it must have been reaped and released.
+ *
+ * @param cq the queue to destroy
+ */
+CEPH_RADOS_API void rados_aio_cq_destroy(rados_completion_queue_t cq);
+
+/**
+ * Constructs a completion that is delivered to a queue
+ *
+ * When the operation finishes the completion is appended to cq
+ * instead of invoking callbacks. It is still released with
+ * rados_aio_release(), but not before it has been reaped.
+ *
+ * @param cq the queue to deliver to
+ * @param pc where to store the completion
+ * @returns 0
+ */
+CEPH_RADOS_API int rados_aio_create_completion_cq(rados_completion_queue_t cq,
+                                                  rados_completion_t *pc);
+
+/**
+ * Reap finished completions from a queue
+ *
+ * Blocks until at least min_nr completions are queued or the timeout
+ * expires, then hands back up to max_nr of them in completion order.
+ *
+ * @param cq the queue to reap from
+ * @param min_nr how many completions to wait for
+ * @param max_nr size of the completions array
+ * @param completions where to store the reaped completions
+ * @param timeout how long to wait, or NULL to wait indefinitely
+ * @returns the number of completions stored, which may be less than
+ * min_nr on timeout
+ */
+CEPH_RADOS_API int rados_aio_cq_wait(rados_completion_queue_t cq,
+                                     unsigned min_nr, unsigned max_nr,
+                                     rados_completion_t *completions,
+                                     struct timespec *timeout);
+
 /**
  * Block until an operation completes
  *
@@ -1962,6 +2034,21 @@ CEPH_RADOS_API int rados_aio_get_return_value(rados_completion_t c);
  */
 CEPH_RADOS_API uint64_t rados_aio_get_version(rados_completion_t c);
 
+/**
+ * Get the per-stage timing of an asychronous operation
+ *
+ * Timing is recorded only when the objecter_op_latency_stages option
+ * is enabled, and only for completions that track a single operation.
+ *
+ * @pre The operation is complete
+ *
+ * @param c async operation to inspect
+ * @param lat where to store the timing
+ * @returns 0 on success, -ENODATA if no timing was recorded
+ */
+CEPH_RADOS_API int rados_aio_get_latency(rados_completion_t c,
+                                         struct rados_aio_latency *lat);
+
 /**
  * Release a completion
  *
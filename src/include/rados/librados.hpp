@@ -24,6 +24,7 @@ namespace librados
   using ceph::bufferlist;
 
   struct AioCompletionImpl;
+  struct AioCompletionQueueImpl;
   class IoCtx;
   struct IoCtxImpl;
   class ObjectOperationImpl;
@@ -199,10 +200,35 @@ namespace librados
     int get_return_value();
     int get_version() __attribute__ ((deprecated));
     uint64_t get_version64();
+    /// per-stage timing, see rados_aio_get_latency()
+    int get_latency(struct rados_aio_latency *lat);
     void release();
     AioCompletionImpl *pc;
   };
 
+  /**
+   * Collects finished completions created with
+   * Rados::aio_create_completion(AioCompletionQueue*) so that
+   * application threads can reap them in batches instead of getting a
+   * callback per op from the finisher thread.
+   */
+  struct CEPH_RADOS_API AioCompletionQueue {
+    AioCompletionQueue();
+    ~AioCompletionQueue();
+    /**
+     * Wait until at least min_nr completions have finished or the
+     * timeout (if non-NULL) expires, and reap up to max_nr of them.
+     *
+     * @returns the number of completions stored in completions
+     */
+    int wait(unsigned min_nr, unsigned max_nr, AioCompletion **completions,
+	     struct timespec *timeout);
+    AioCompletionQueueImpl *pcq;
+  private:
+    AioCompletionQueue(const AioCompletionQueue&);
+    AioCompletionQueue& operator=(const AioCompletionQueue&);
+  };
+
   struct CEPH_RADOS_API PoolAsyncCompletion {
     PoolAsyncCompletion(PoolAsyncCompletionImpl *pc_) : pc(pc_) {}
     int set_callback(void *cb_arg, callback_t cb);
@@ -1108,6 +1134,24 @@ namespace librados
         const blkin_trace_info *trace_info);
     int aio_operate(const std::string& oid, AioCompletion *c,
 		    ObjectReadOperation *op, bufferlist *pbl);
+    /**
+     * Schedule independent write operations on several objects at once
+     *
+     * The ops are submitted together, so they share the client-side
+     * locking and go out back to back on each OSD session, and c
+     * completes once when all of them have.
+     *
+     * @param oids the objects to operate on, one per op
+     * @param ops which operations to perform on each object
+     * @param c completes with 0, or the first error if any op failed
+     * @param prvals if non-NULL, resized to hold each op's own result
+     * @param flags LIBRADOS_OPERATION_* flags applied to every op
+     * @returns 0 on success, negative error code on failure
+     */
+    int aio_operate_batch(const std::vector<std::string>& oids,
+			  const std::vector<ObjectWriteOperation*>& ops,
+			  AioCompletion *c, std::vector<int> *prvals,
+			  int flags);
 
     int aio_operate(const std::string& oid, AioCompletion *c,
 		    ObjectReadOperation *op, snap_t snapid, int flags,
@@ -1430,6 +1474,8 @@ namespace librados
     static AioCompletion *aio_create_completion();
     static AioCompletion *aio_create_completion(void *cb_arg, callback_t cb_complete,
 						callback_t cb_safe);
+    /// the completion is reaped from cq rather than calling back
+    static AioCompletion *aio_create_completion(AioCompletionQueue *cq);
     
     friend std::ostream& operator<<(std::ostream &oss, const Rados& r);
   private:
@@ -106,6 +106,13 @@ typedef enum {
   RBD_MIRROR_MODE_POOL      /* mirroring enabled on all journaled images */
 } rbd_mirror_mode_t;
 
+/* where the time of one aio request went, see rbd_aio_get_latency() */
+typedef struct {
+  uint64_t queue_ns;    /* submission until dispatch (image request queue,
+                           exclusive lock and write blocks) */
+  uint64_t service_ns;  /* dispatch until complete (cache, objecter, osds) */
+} rbd_aio_latency_t;
+
 typedef struct {
   char *uuid;
   char *cluster_name;
@@ -757,6 +764,14 @@ CEPH_RBD_API int rbd_aio_is_complete(rbd_completion_t c);
 CEPH_RBD_API int rbd_aio_wait_for_complete(rbd_completion_t c);
 CEPH_RBD_API ssize_t rbd_aio_get_return_value(rbd_completion_t c);
 CEPH_RBD_API void *rbd_aio_get_arg(rbd_completion_t c);
+/**
+ * Get the per-stage timing of a completed aio request.
+ *
+ * @returns 0 on success, -ENODATA if the request is not complete or
+ * was never dispatched
+ */
+CEPH_RBD_API int rbd_aio_get_latency(rbd_completion_t c,
+                                     rbd_aio_latency_t *lat);
 CEPH_RBD_API void rbd_aio_release(rbd_completion_t c);
 CEPH_RBD_API int rbd_flush(rbd_image_t image);
 /**
@@ -117,6 +117,7 @@ public:
     int wait_for_complete();
     ssize_t get_return_value();
     void *get_arg();
+    int get_latency(rbd_aio_latency_t *lat);
     void release();
   };
 
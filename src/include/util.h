@@ -78,6 +78,10 @@ int get_fs_stats(ceph_data_stats_t &stats, const char *path);
 /// collect info from @p uname(2), @p /proc/meminfo and @p /proc/cpuinfo
 void collect_sys_info(map<string, string> *m, CephContext *cct);
 
+/// bind the calling thread, and threads it creates afterwards, to the cpus
+/// of numa node @p node; returns 0 or a negative error code
+int set_numa_node_affinity(int node);
+
 /// dump service ids grouped by their host to the specified formatter
 /// @param f formatter for the output
 /// @param services a map from hostname to a list of service id hosted by this host
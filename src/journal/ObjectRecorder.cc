@@ -22,12 +22,14 @@ ObjectRecorder::ObjectRecorder(librados::IoCtx &ioctx, const std::string &oid,
                                ContextWQ *work_queue, SafeTimer &timer,
                                Mutex &timer_lock, Handler *handler,
                                uint8_t order, uint32_t flush_interval,
-                               uint64_t flush_bytes, double flush_age)
+                               uint64_t flush_bytes, double flush_age,
+                               uint64_t max_in_flight_appends)
   : RefCountedObject(NULL, 0), m_oid(oid), m_object_number(object_number),
     m_cct(NULL), m_op_work_queue(work_queue), m_timer(timer),
     m_timer_lock(timer_lock), m_handler(handler), m_order(order),
     m_soft_max_size(1 << m_order), m_flush_interval(flush_interval),
-    m_flush_bytes(flush_bytes), m_flush_age(flush_age), m_flush_handler(this),
+    m_flush_bytes(flush_bytes), m_flush_age(flush_age),
+    m_max_in_flight_appends(max_in_flight_appends), m_flush_handler(this),
     m_lock(lock), m_append_tid(0), m_pending_bytes(0),
     m_size(0), m_overflowed(false), m_object_closed(false),
     m_in_flight_flushes(false), m_aio_scheduled(false) {
@@ -277,6 +279,14 @@ void ObjectRecorder::handle_append_flushed(uint64_t tid, int r) {
 
     m_in_flight_appends.erase(iter);
     m_in_flight_flushes = true;
+
+    // appends held back by the in-flight limit go out as one batch
+    if (!m_pending_buffers.empty() && !m_aio_scheduled) {
+      m_op_work_queue->queue(new FunctionContext([this] (int r) {
+          send_appends_aio();
+        }));
+      m_aio_scheduled = true;
+    }
     m_lock->Unlock();
   }
 
@@ -320,6 +330,12 @@ void ObjectRecorder::append_overflowed() {
                                   it->second.begin(), it->second.end());
   }
 
+  // and those the in-flight limit held back, which come next
+  restart_append_buffers.splice(restart_append_buffers.end(),
+                                m_pending_buffers,
+                                m_pending_buffers.begin(),
+                                m_pending_buffers.end());
+
   restart_append_buffers.splice(restart_append_buffers.end(),
                                 m_append_buffers,
                                 m_append_buffers.begin(),
@@ -348,7 +364,7 @@ void ObjectRecorder::send_appends(AppendBuffers *append_buffers) {
 
   m_pending_buffers.splice(m_pending_buffers.end(), *append_buffers,
                            append_buffers->begin(), append_buffers->end());
-  if (!m_aio_scheduled) {
+  if (!m_aio_scheduled && can_send_appends()) {
     m_op_work_queue->queue(new FunctionContext([this] (int r) {
         send_appends_aio();
     }));
@@ -393,7 +409,8 @@ void ObjectRecorder::send_appends_aio() {
 
   {
     m_lock->Lock();
-    if (m_pending_buffers.empty()) {
+    if (m_pending_buffers.empty() || !can_send_appends()) {
+      // otherwise handle_append_flushed sends them
       m_aio_scheduled = false;
       if (m_in_flight_appends.empty() && m_object_closed) {
         // all remaining unsent appends should be redirected to new object
@@ -414,6 +431,12 @@ void ObjectRecorder::send_appends_aio() {
   gather_ctx->activate();
 }
 
+bool ObjectRecorder::can_send_appends() const {
+  assert(m_lock->is_locked());
+  return (m_max_in_flight_appends == 0 ||
+          m_in_flight_tids.size() < m_max_in_flight_appends);
+}
+
 void ObjectRecorder::notify_handler_unlock() {
   assert(m_lock->is_locked());
   if (m_object_closed) {
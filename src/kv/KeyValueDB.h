@@ -341,6 +341,13 @@ public:
       get_wholespace_iterator());
   }
 
+  /// like get_iterator, but the backend may stop looking at keys once
+  /// they reach upper; callers must still check the keys they get back
+  virtual Iterator get_bounded_iterator(const std::string &prefix,
+					const std::string &upper) {
+    return get_iterator(prefix);
+  }
+
   void add_column_family(const std::string& cf_name, void *handle) {
     cf_handles.insert(std::make_pair(cf_name, handle));
   }
@@ -358,6 +365,17 @@ public:
     return -EOPNOTSUPP;
   }
 
+  /**
+   * get_cache_stats - report block cache usage and cumulative misses
+   *
+   * Used by the owner of the db to decide how much memory the kv cache
+   * deserves relative to its own caches.
+   */
+  virtual int get_cache_stats(uint64_t *usage, uint64_t *capacity,
+			      uint64_t *misses) {
+    return -EOPNOTSUPP;
+  }
+
   virtual ~KeyValueDB() {}
 
   /// compact the underlying store
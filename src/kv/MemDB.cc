@@ -51,12 +51,6 @@ static string make_key(const string &prefix, const string &value)
   return out;
 }
 
-void MemDB::_encode(mdb_iter_t iter, bufferlist &bl)
-{
-  ::encode(iter->first, bl);
-  ::encode(iter->second, bl);
-}
-
 std::string MemDB::_get_data_fn()
 {
   string fn = m_db_path + "/" + "MemDB.db";
@@ -65,7 +59,7 @@ std::string MemDB::_get_data_fn()
 
 void MemDB::_save()
 {
-  std::lock_guard<std::mutex> l(m_lock);
+  std::lock_guard<std::mutex> l(m_write_lock);
   dout(10) << __func__ << " Saving MemDB to file: "<< _get_data_fn().c_str() << dendl;
   int mode = 0644;
   int fd = TEMP_FAILURE_RETRY(::open(_get_data_fn().c_str(),
@@ -77,11 +71,14 @@ void MemDB::_save()
     return;
   }
   bufferlist bl;
-  mdb_iter_t iter = m_map.begin();
-  while (iter != m_map.end()) {
-    dout(10) << __func__ << " Key:"<< iter->first << dendl;
-    _encode(iter, bl);
-    ++iter;
+  uint64_t seq = m_last_seq;
+  for (Node *n = m_head.next[0]; n; n = n->next[0]) {
+    const Version *v = _visible(n, seq);
+    if (!v)
+      continue;
+    dout(10) << __func__ << " Key:"<< n->key << dendl;
+    ::encode(n->key, bl);
+    ::encode(v->value, bl);
   }
   bl.write_fd(fd);
 
@@ -90,7 +87,7 @@ void MemDB::_save()
 
 int MemDB::_load()
 {
-  std::lock_guard<std::mutex> l(m_lock);
+  std::lock_guard<std::mutex> l(m_write_lock);
   dout(10) << __func__ << " Reading MemDB from file: "<< _get_data_fn().c_str() << dendl;
   /*
    * Open file and read it in single shot.
@@ -113,6 +110,7 @@ int MemDB::_load()
     return -err;
   }
 
+  uint64_t seq = m_last_seq + 1;
   ssize_t file_size = st.st_size;
   ssize_t bytes_done = 0;
   while (bytes_done < file_size) {
@@ -123,9 +121,9 @@ int MemDB::_load()
     bytes_done += ::decode_file(fd, datap);
 
     dout(10) << __func__ << " Key:"<< key << dendl;
-    m_map[key] = datap;
-    m_total_bytes += datap.length();
+    _update(key, false, datap, seq, 0);
   }
+  m_last_seq = seq;
   VOID_TEMP_FAILURE_RETRY(::close(fd));
   return 0;
 }
@@ -185,6 +183,18 @@ MemDB::~MemDB()
 {
   close();
   dout(10) << __func__ << " Destroying MemDB instance: "<< dendl;
+  Node *n = m_head.next[0];
+  while (n) {
+    Node *next = n->next[0];
+    _free(n);
+    n = next;
+  }
+  for (int i = 0; i < 2; ++i) {
+    for (auto n : m_retired_nodes[i])
+      _free(n);
+    for (auto v : m_retired_versions[i])
+      delete v;
+  }
 }
 
 void MemDB::close()
@@ -200,20 +210,27 @@ int MemDB::submit_transaction(KeyValueDB::Transaction t)
   MDBTransactionImpl* mt =  static_cast<MDBTransactionImpl*>(t.get());
 
   dtrace << __func__ << " " << mt->get_ops().size() << dendl;
+  std::lock_guard<std::mutex> l(m_write_lock);
+  uint64_t seq = m_last_seq + 1;
+  uint64_t floor = _snapshot_floor();
   for(auto& op : mt->get_ops()) {
     if(op.first == MDBTransactionImpl::WRITE) {
       ms_op_t set_op = op.second;
-      _setkey(set_op);
+      _setkey(set_op, seq, floor);
     } else if (op.first == MDBTransactionImpl::MERGE) {
       ms_op_t merge_op = op.second;
-      _merge(merge_op);
+      _merge(merge_op, seq, floor);
     } else {
       ms_op_t rm_op = op.second;
       assert(op.first == MDBTransactionImpl::DELETE);
-      _rmkey(rm_op);
+      _rmkey(rm_op, seq, floor);
     }
   }
+  // make the whole transaction visible at once
+  m_last_seq.store(seq, std::memory_order_release);
 
+  _purge_dead(floor);
+  _reclaim();
   return 0;
 }
 
@@ -278,44 +295,88 @@ void MemDB::MDBTransactionImpl::merge(
   return;
 }
 
-int MemDB::_setkey(ms_op_t &op)
-{
-  std::lock_guard<std::mutex> l(m_lock);
-  std::string key = make_key(op.first.first, op.first.second);
-  bufferlist bl = op.second;
+/*
+ * Caller takes m_write_lock.  The new version gets seq, which readers
+ * ignore until the transaction is published, and the versions of key
+ * no snapshot can see anymore (i.e., those older than the newest one
+ * at or below floor) are dropped.
+ */
+void MemDB::_update(const std::string &key, bool deleted,
+		    const bufferptr& value, uint64_t seq, uint64_t floor)
+{
+  Node *prev[max_height];
+  Node *n = _find_greater_or_equal(key, prev);
+  if (!n || n->key != key) {
+    if (deleted) {
+      return;
+    }
+    int height = _random_height();
+    n = new Node(key, height);
+    n->head.store(new Version(seq, false, value, nullptr),
+		  std::memory_order_relaxed);
+    // link bottom up, so that a reader finding it at some level will
+    // also find it at the levels below
+    for (int i = 0; i < height; ++i) {
+      n->next[i].store(prev[i]->next[i].load(std::memory_order_relaxed),
+		       std::memory_order_relaxed);
+      prev[i]->next[i].store(n, std::memory_order_release);
+    }
+    m_total_bytes += value.length();
+    return;
+  }
 
-  m_total_bytes += bl.length();
+  Version *head = n->head.load(std::memory_order_relaxed);
+  if (head && !head->deleted) {
+    assert(m_total_bytes >= head->value.length());
+    m_total_bytes -= head->value.length();
+  }
+  if (!deleted) {
+    m_total_bytes += value.length();
+  }
 
-  bufferlist bl_old;
-  if (_get(op.first.first, op.first.second, &bl_old)) {
-    /*
-     * delete and free existing key.
-     */
-    assert(m_total_bytes >= bl_old.length());
-    m_total_bytes -= bl_old.length();
-    m_map.erase(key);
+  Version *older = head;
+  if (head && head->seq == seq) {
+    // overwritten within the same transaction
+    older = head->older.load(std::memory_order_relaxed);
+    _retire(head);
+  }
+  for (Version *v = older; v; v = v->older.load(std::memory_order_relaxed)) {
+    if (v->seq <= floor) {
+      Version *drop = v->older.load(std::memory_order_relaxed);
+      v->older.store(nullptr, std::memory_order_release);
+      while (drop) {
+	Version *o = drop->older.load(std::memory_order_relaxed);
+	_retire(drop);
+	drop = o;
+      }
+      break;
+    }
   }
 
-  m_map[key] = bufferptr((char *) bl.c_str(), bl.length());
-  iterator_seq_no++;
-  return 0;
+  Version *nv = older;
+  if (!deleted || (older && !older->deleted)) {
+    nv = new Version(seq, deleted, value, older);
+  }
+  n->head.store(nv, std::memory_order_release);
+  if ((!nv || nv->deleted) && !n->dead) {
+    n->dead = true;
+    m_dead.push_back(n);
+  }
 }
 
-int MemDB::_rmkey(ms_op_t &op)
+int MemDB::_setkey(ms_op_t &op, uint64_t seq, uint64_t floor)
 {
-  std::lock_guard<std::mutex> l(m_lock);
   std::string key = make_key(op.first.first, op.first.second);
+  bufferlist bl = op.second;
+  _update(key, false, bufferptr((char *) bl.c_str(), bl.length()), seq, floor);
+  return 0;
+}
 
-  bufferlist bl_old;
-  if (_get(op.first.first, op.first.second, &bl_old)) {
-    assert(m_total_bytes >= bl_old.length());
-    m_total_bytes -= bl_old.length();
-  }
-  iterator_seq_no++;
-  /*
-   * Erase will call the destructor for bufferptr.
-   */
-  return m_map.erase(key);
+int MemDB::_rmkey(ms_op_t &op, uint64_t seq, uint64_t floor)
+{
+  std::string key = make_key(op.first.first, op.first.second);
+  _update(key, true, bufferptr(), seq, floor);
+  return 0;
 }
 
 std::shared_ptr<KeyValueDB::MergeOperator> MemDB::_find_merge_op(std::string prefix)
@@ -331,13 +392,11 @@ std::shared_ptr<KeyValueDB::MergeOperator> MemDB::_find_merge_op(std::string pre
 }
 
 
-int MemDB::_merge(ms_op_t &op)
+int MemDB::_merge(ms_op_t &op, uint64_t seq, uint64_t floor)
 {
-  std::lock_guard<std::mutex> l(m_lock);
   std::string prefix = op.first.first;
   std::string key = make_key(op.first.first, op.first.second);
   bufferlist bl = op.second;
-  int64_t bytes_adjusted = bl.length();
 
   /*
    *  find the operator for this prefix
@@ -346,60 +405,53 @@ int MemDB::_merge(ms_op_t &op)
   assert(mop);
 
   /*
-   * call the merge operator with value and non value
+   * call the merge operator with value and non value; the writer sees
+   * its own transaction, so look at the newest version whatever its seq
    */
-  bufferlist bl_old;
-  if (_get(op.first.first, op.first.second, &bl_old) == false) {
-    std::string new_val;
+  Node *n = _find_greater_or_equal(key, nullptr);
+  const Version *cur = nullptr;
+  if (n && n->key == key) {
+    cur = n->head.load(std::memory_order_relaxed);
+  }
+  std::string new_val;
+  if (!cur || cur->deleted) {
     /*
      * Merge non existent.
      */
     mop->merge_nonexistent(bl.c_str(), bl.length(), &new_val);
-    m_map[key] = bufferptr(new_val.c_str(), new_val.length());
   } else {
     /*
      * Merge existing.
      */
-    std::string new_val;
-    mop->merge(bl_old.c_str(), bl_old.length(), bl.c_str(), bl.length(), &new_val);
-    m_map[key] = bufferptr(new_val.c_str(), new_val.length());
-    bytes_adjusted -= bl_old.length();
-    bl_old.clear();
+    mop->merge(cur->value.c_str(), cur->value.length(),
+	       bl.c_str(), bl.length(), &new_val);
   }
-
-  assert((int64_t)m_total_bytes + bytes_adjusted >= 0);
-  m_total_bytes += bytes_adjusted;
-  iterator_seq_no++;
+  _update(key, false, bufferptr(new_val.c_str(), new_val.length()),
+	  seq, floor);
   return 0;
 }
 
-/*
- * Caller take btree lock.
- */
 bool MemDB::_get(const string &prefix, const string &k, bufferlist *out)
 {
   string key = make_key(prefix, k);
 
-  mdb_iter_t iter = m_map.find(key);
-  if (iter == m_map.end()) {
+  ReadGuard g(this);
+  Node *n = _find_greater_or_equal(key, nullptr);
+  if (!n || n->key != key) {
     return false;
   }
-
-  out->push_back((m_map[key].clone()));
+  const Version *v = _committed(n);
+  if (!v) {
+    return false;
+  }
+  out->push_back(bufferptr(v->value.c_str(), v->value.length()));
   return true;
 }
 
-bool MemDB::_get_locked(const string &prefix, const string &k, bufferlist *out)
-{
-  std::lock_guard<std::mutex> l(m_lock);
-  return _get(prefix, k, out);
-}
-
-
 int MemDB::get(const string &prefix, const std::string& key,
                  bufferlist *out)
 {
-  if (_get_locked(prefix, key, out)) {
+  if (_get(prefix, key, out)) {
     return 0;
   }
   return -ENOENT;
@@ -410,61 +462,253 @@ int MemDB::get(const string &prefix, const std::set<string> &keys,
 {
   for (const auto& i : keys) {
     bufferlist bl;
-    if (_get_locked(prefix, i, &bl))
+    if (_get(prefix, i, &bl))
       out->insert(make_pair(i, bl));
   }
 
   return 0;
 }
 
-void MemDB::MDBWholeSpaceIteratorImpl::fill_current()
+/*
+ * Skiplist.  Readers walk it without locks, the writer (holding
+ * m_write_lock) publishes links with release stores.
+ */
+MemDB::Node *MemDB::_find_greater_or_equal(const std::string& key,
+					   Node **prev)
+{
+  Node *x = &m_head;
+  int level = max_height - 1;
+  while (true) {
+    Node *next = x->next[level].load(std::memory_order_acquire);
+    if (next && next->key < key) {
+      x = next;
+    } else {
+      if (prev)
+	prev[level] = x;
+      if (level == 0)
+	return next;
+      --level;
+    }
+  }
+}
+
+MemDB::Node *MemDB::_find_less_than(const std::string& key)
 {
-  bufferlist bl;
-  bl.append(m_iter->second.clone());
-  m_key_value = std::make_pair(m_iter->first, bl);
+  Node *x = &m_head;
+  int level = max_height - 1;
+  while (true) {
+    Node *next = x->next[level].load(std::memory_order_acquire);
+    if (next && next->key < key) {
+      x = next;
+    } else {
+      if (level == 0)
+	return x == &m_head ? nullptr : x;
+      --level;
+    }
+  }
 }
 
-bool MemDB::MDBWholeSpaceIteratorImpl::valid()
+MemDB::Node *MemDB::_find_last()
 {
-  if (m_key_value.first.empty()) {
-    return false;
+  Node *x = &m_head;
+  int level = max_height - 1;
+  while (true) {
+    Node *next = x->next[level].load(std::memory_order_acquire);
+    if (next) {
+      x = next;
+    } else {
+      if (level == 0)
+	return x == &m_head ? nullptr : x;
+      --level;
+    }
   }
-  return true;
 }
 
-bool MemDB::MDBWholeSpaceIteratorImpl::iterator_validate() {
+int MemDB::_random_height()
+{
+  // each level holds a quarter of the nodes of the one below
+  int height = 1;
+  while (height < max_height && (m_rand() & 3) == 0)
+    ++height;
+  return height;
+}
 
-  if (this_seq_no != *global_seq_no) {
-    auto key = m_key_value.first;
-    assert(!key.empty());
+/// newest version of n as of seq, or nullptr if n did not exist then
+const MemDB::Version *MemDB::_visible(const Node *n, uint64_t seq)
+{
+  for (const Version *v = n->head.load(std::memory_order_acquire);
+       v;
+       v = v->older.load(std::memory_order_acquire)) {
+    if (v->seq <= seq)
+      return v->deleted ? nullptr : v;
+  }
+  return nullptr;
+}
 
-    bool restart_iter = false;
-    if (!m_using_btree) {
-      /*
-       * Map is modified and marker key does not exists, 
-       * restart the iterator from next key.
-       */
-      if (m_map_p->find(key) == m_map_p->end()) {
-        restart_iter = true;
-      }
-    } else {
-      restart_iter = true;
-    }
+/*
+ * Newest committed version of n.  Only the versions of the transaction
+ * being applied are newer than m_last_seq, and the version below them
+ * is never dropped, so re-reading m_last_seq as we go is enough.
+ */
+const MemDB::Version *MemDB::_committed(const Node *n) const
+{
+  for (const Version *v = n->head.load(std::memory_order_acquire);
+       v;
+       v = v->older.load(std::memory_order_acquire)) {
+    if (v->seq <= m_last_seq.load(std::memory_order_acquire))
+      return v->deleted ? nullptr : v;
+  }
+  return nullptr;
+}
 
-    if (restart_iter) {
-      m_iter = m_map_p->lower_bound(key);
-      if (m_iter == m_map_p->end()) {
-        return false;
-      }
+void MemDB::_free(Node *n)
+{
+  Version *v = n->head.load(std::memory_order_relaxed);
+  while (v) {
+    Version *o = v->older.load(std::memory_order_relaxed);
+    delete v;
+    v = o;
+  }
+  delete n;
+}
+
+/*
+ * Snapshots.  The writer never drops a version a registered snapshot
+ * can see; a snapshot registered after the floor was computed gets a
+ * seq not below it.
+ */
+uint64_t MemDB::_snapshot_floor()
+{
+  std::lock_guard<std::mutex> l(m_snap_lock);
+  uint64_t floor = m_last_seq;
+  if (!m_snapshots.empty() && *m_snapshots.begin() < floor)
+    floor = *m_snapshots.begin();
+  return floor;
+}
+
+uint64_t MemDB::_get_snapshot()
+{
+  std::lock_guard<std::mutex> l(m_snap_lock);
+  uint64_t seq = m_last_seq.load(std::memory_order_acquire);
+  m_snapshots.insert(seq);
+  return seq;
+}
+
+void MemDB::_put_snapshot(uint64_t seq)
+{
+  std::lock_guard<std::mutex> l(m_snap_lock);
+  auto p = m_snapshots.find(seq);
+  assert(p != m_snapshots.end());
+  m_snapshots.erase(p);
+}
+
+/*
+ * Reclamation.  Readers count themselves in the slot of the epoch they
+ * entered.  Whatever the writer unlinks goes to the slot of the current
+ * epoch, and the epoch only moves on once the readers of the previous
+ * one are gone: at that point nobody can still reach what was retired
+ * two epochs ago, which shares their slot.
+ */
+MemDB::ReadGuard::ReadGuard(MemDB *d) : db(d)
+{
+  while (true) {
+    uint64_t e = db->m_epoch.load();
+    slot = e & 1;
+    ++db->m_readers[slot];
+    if (db->m_epoch.load() == e)
+      break;
+    --db->m_readers[slot];
+  }
+}
+
+MemDB::ReadGuard::~ReadGuard()
+{
+  --db->m_readers[slot];
+}
+
+void MemDB::_retire(Node *n)
+{
+  m_retired_nodes[m_epoch.load() & 1].push_back(n);
+}
+
+void MemDB::_retire(Version *v)
+{
+  m_retired_versions[m_epoch.load() & 1].push_back(v);
+}
+
+void MemDB::_reclaim()
+{
+  uint64_t e = m_epoch.load();
+  unsigned old = (e + 1) & 1;
+  if (m_readers[old].load() != 0) {
+    return;
+  }
+  for (auto n : m_retired_nodes[old])
+    _free(n);
+  m_retired_nodes[old].clear();
+  for (auto v : m_retired_versions[old])
+    delete v;
+  m_retired_versions[old].clear();
+  m_epoch.store(e + 1);
+}
+
+/// unlink the removed keys no snapshot can see anymore
+void MemDB::_purge_dead(uint64_t floor)
+{
+  std::vector<Node*> keep;
+  for (auto n : m_dead) {
+    Version *head = n->head.load(std::memory_order_relaxed);
+    if (head && !head->deleted) {
+      // set again since
+      n->dead = false;
+      continue;
+    }
+    if (head && head->seq > floor) {
+      keep.push_back(n);
+      continue;
     }
+    Node *prev[max_height];
+    Node *found = _find_greater_or_equal(n->key, prev);
+    assert(found == n);
+    for (int i = 0; i < n->height; ++i) {
+      prev[i]->next[i].store(n->next[i].load(std::memory_order_relaxed),
+			     std::memory_order_release);
+    }
+    _retire(n);
+  }
+  m_dead.swap(keep);
+}
 
-    /*
-     * This iter is valid now.
-     */
-    this_seq_no = *global_seq_no;
+/*
+ * Iterator.
+ */
+void MemDB::MDBWholeSpaceIteratorImpl::fill_current()
+{
+  const bufferptr& value = _visible(m_node, m_seq)->value;
+  bufferlist bl;
+  bl.append(value.c_str(), value.length());
+  m_key_value = std::make_pair(m_node->key, bl);
+}
+
+void MemDB::MDBWholeSpaceIteratorImpl::_set(const Node *n, bool forward)
+{
+  free_last();
+  while (n && !_visible(n, m_seq)) {
+    if (forward) {
+      n = n->next[0].load(std::memory_order_acquire);
+    } else {
+      n = m_db->_find_less_than(n->key);
+    }
+  }
+  m_node = n;
+  if (m_node) {
+    fill_current();
   }
+}
 
-  return true;
+bool MemDB::MDBWholeSpaceIteratorImpl::valid()
+{
+  return m_node != nullptr;
 }
 
 void
@@ -505,36 +749,18 @@ bufferlist MemDB::MDBWholeSpaceIteratorImpl::value()
 
 int MemDB::MDBWholeSpaceIteratorImpl::next()
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
-  if (!iterator_validate()) {
-    free_last();
-    return -1;
-  }
-  free_last();
-  ++m_iter;
-  if (m_iter != m_map_p->end()) {
-    fill_current();
-    return 0;
-  } else {
-    return -1;
+  if (m_node) {
+    _set(m_node->next[0].load(std::memory_order_acquire), true);
   }
+  return 0;
 }
 
-int MemDB::MDBWholeSpaceIteratorImpl:: prev()
+int MemDB::MDBWholeSpaceIteratorImpl::prev()
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
-  if (!iterator_validate()) {
-    free_last();
-    return -1;
-  }
-  free_last();
-  if (m_iter != m_map_p->begin()) {
-    --m_iter;
-    fill_current();
-    return 0;
-  } else {
-    return -1;
+  if (m_node) {
+    _set(m_db->_find_less_than(m_node->key), false);
   }
+  return 0;
 }
 
 /*
@@ -542,68 +768,51 @@ int MemDB::MDBWholeSpaceIteratorImpl:: prev()
  */
 int MemDB::MDBWholeSpaceIteratorImpl::seek_to_first(const std::string &k)
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
-  free_last();
   if (k.empty()) {
-    m_iter = m_map_p->begin();
+    _set(m_db->m_head.next[0].load(std::memory_order_acquire), true);
   } else {
-    m_iter = m_map_p->lower_bound(k);
+    _set(m_db->_find_greater_or_equal(k, nullptr), true);
   }
-  
-  if (m_iter == m_map_p->end()) {
-    return -1;
-  }
-  fill_current();
   return 0;
 }
 
+/*
+ * Last key of the given prefix, if prefix is null then last key in btree.
+ */
 int MemDB::MDBWholeSpaceIteratorImpl::seek_to_last(const std::string &k)
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
-  free_last();
   if (k.empty()) {
-    m_iter = m_map_p->end();
-    --m_iter;
+    _set(m_db->_find_last(), false);
   } else {
-    m_iter = m_map_p->lower_bound(k);
-  }
-
-  if (m_iter == m_map_p->end()) {
-    return -1;
+    string limit = k;
+    limit.push_back(KEY_DELIM + 1);
+    _set(m_db->_find_less_than(limit), false);
   }
-  fill_current();
   return 0;
 }
 
 MemDB::MDBWholeSpaceIteratorImpl::~MDBWholeSpaceIteratorImpl()
 {
   free_last();
+  m_db->_put_snapshot(m_seq);
 }
 
 int MemDB::MDBWholeSpaceIteratorImpl::upper_bound(const std::string &prefix,
     const std::string &after) {
-
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
-
   dtrace << "upper_bound " << prefix.c_str() << after.c_str() << dendl;
   string k = make_key(prefix, after);
-  m_iter = m_map_p->upper_bound(k);
-  if (m_iter != m_map_p->end()) {
-    fill_current();
-    return 0;
+  const Node *n = m_db->_find_greater_or_equal(k, nullptr);
+  if (n && n->key == k) {
+    n = n->next[0].load(std::memory_order_acquire);
   }
-  return -1;
+  _set(n, true);
+  return 0;
 }
 
 int MemDB::MDBWholeSpaceIteratorImpl::lower_bound(const std::string &prefix,
     const std::string &to) {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
   dtrace << "lower_bound " << prefix.c_str() << to.c_str() << dendl;
   string k = make_key(prefix, to);
-  m_iter = m_map_p->lower_bound(k);
-  if (m_iter != m_map_p->end()) {
-    fill_current();
-    return 0;
-  }
-  return -1;
+  _set(m_db->_find_greater_or_equal(k, nullptr), true);
+  return 0;
 }
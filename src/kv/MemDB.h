@@ -9,33 +9,96 @@
 #define CEPH_OS_BLUESTORE_MEMDB_H
 
 #include "include/buffer.h"
+#include <atomic>
 #include <ostream>
 #include <set>
 #include <map>
+#include <mutex>
+#include <random>
 #include <string>
 #include <memory>
+#include <vector>
 #include "include/memory.h"
 #include <boost/scoped_ptr.hpp>
 #include "include/encoding.h"
-#include "include/btree_map.h"
 #include "KeyValueDB.h"
 #include "osd/osd_types.h"
 
 using std::string;
-#define KEY_DELIM '\0' 
-
+#define KEY_DELIM '\0'
+
+/**
+ * The keys live in a skiplist that readers walk without taking any
+ * lock.  Writers are serialized on m_write_lock, which is taken once
+ * per transaction, and every transaction is applied under a single
+ * sequence number that is only published once all of its ops are in.
+ *
+ * Each key keeps a chain of versions, newest first.  A reader picks the
+ * newest version not newer than its snapshot, so iterators see the db
+ * as it was when they were created, and a get never sees a transaction
+ * half applied.  Versions no live snapshot can see anymore, and the
+ * nodes of removed keys, are unlinked by the writer and freed once the
+ * readers that might still be looking at them are gone (epoch based
+ * reclamation, see ReadGuard).
+ */
 class MemDB : public KeyValueDB
 {
   typedef std::pair<std::pair<std::string, std::string>, bufferlist> ms_op_t;
-  std::mutex m_lock;
-  uint64_t m_total_bytes;
-  uint64_t m_allocated_bytes;
 
-  typedef std::map<std::string, bufferptr> mdb_map_t;
-  typedef mdb_map_t::iterator mdb_iter_t;
-  bool m_using_btree;
+  struct Version {
+    const uint64_t seq;
+    const bool deleted;
+    const bufferptr value;
+    std::atomic<Version*> older;
+
+    Version(uint64_t s, bool d, const bufferptr& v, Version *o)
+      : seq(s), deleted(d), value(v), older(o) {}
+  };
+
+  static const int max_height = 12;
+
+  struct Node {
+    const std::string key;
+    const int height;
+    bool dead = false;		///< queued in m_dead (writer only)
+    std::atomic<Version*> head;
+    std::unique_ptr<std::atomic<Node*>[]> next;
+
+    Node(const std::string& k, int h)
+      : key(k), height(h), head(nullptr), next(new std::atomic<Node*>[h]) {
+      for (int i = 0; i < h; ++i)
+	next[i].store(nullptr, std::memory_order_relaxed);
+    }
+  };
+
+  /// pins the current reclamation epoch for as long as it lives
+  class ReadGuard {
+    MemDB *db;
+    unsigned slot;
+  public:
+    explicit ReadGuard(MemDB *d);
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ~ReadGuard();
+  };
+  friend class ReadGuard;
+
+  std::mutex m_write_lock;	///< serializes writers
+  Node m_head;			///< skiplist head, holds no key
+  std::minstd_rand m_rand;	///< node heights (writer only)
+  std::atomic<uint64_t> m_last_seq;	///< last applied transaction
+
+  std::mutex m_snap_lock;	///< protects m_snapshots
+  std::multiset<uint64_t> m_snapshots;	///< seqs of live iterators
+
+  std::atomic<uint64_t> m_epoch;
+  std::atomic<uint64_t> m_readers[2];
+  std::vector<Node*> m_retired_nodes[2];	///< writer only
+  std::vector<Version*> m_retired_versions[2];	///< writer only
+  std::vector<Node*> m_dead;	///< removed keys waiting to be unlinked
 
-  mdb_map_t m_map;
+  std::atomic<uint64_t> m_total_bytes;
+  uint64_t m_allocated_bytes;
 
   CephContext *m_cct;
   void* m_priv;
@@ -46,19 +109,44 @@ class MemDB : public KeyValueDB
   int _open(ostream &out);
   void close() override;
   bool _get(const string &prefix, const string &k, bufferlist *out);
-  bool _get_locked(const string &prefix, const string &k, bufferlist *out);
   std::string _get_data_fn();
-  void _encode(mdb_iter_t iter, bufferlist &bl);
   void _save();
   int _load();
-  uint64_t iterator_seq_no;
+
+  // skiplist, see MemDB.cc
+  Node *_find_greater_or_equal(const std::string& key, Node **prev);
+  Node *_find_less_than(const std::string& key);
+  Node *_find_last();
+  int _random_height();
+  static const Version *_visible(const Node *n, uint64_t seq);
+  const Version *_committed(const Node *n) const;
+  static void _free(Node *n);
+
+  uint64_t _snapshot_floor();
+  uint64_t _get_snapshot();
+  void _put_snapshot(uint64_t seq);
+  void _retire(Node *n);
+  void _retire(Version *v);
+  void _reclaim();
+  void _purge_dead(uint64_t floor);
+
+  /*
+   * Transaction states.
+   */
+  void _update(const std::string &key, bool deleted, const bufferptr& value,
+	       uint64_t seq, uint64_t floor);
+  int _merge(ms_op_t &op, uint64_t seq, uint64_t floor);
+  int _setkey(ms_op_t &op, uint64_t seq, uint64_t floor);
+  int _rmkey(ms_op_t &op, uint64_t seq, uint64_t floor);
 
 public:
   MemDB(CephContext *c, const string &path, void *p) :
-    m_total_bytes(0), m_allocated_bytes(0), m_using_btree(false),
-    m_cct(c), m_priv(p), m_db_path(path), iterator_seq_no(1)
+    m_head(std::string(), max_height), m_last_seq(0), m_epoch(0),
+    m_total_bytes(0), m_allocated_bytes(0),
+    m_cct(c), m_priv(p), m_db_path(path)
   {
-    //Nothing as of now
+    m_readers[0] = 0;
+    m_readers[1] = 0;
   }
 
   ~MemDB() override;
@@ -105,16 +193,6 @@ public:
     ~MDBTransactionImpl() override {};
   };
 
-private:
-
-  /*
-   * Transaction states.
-   */
-  int _merge(const std::string &k, bufferptr &bl);
-  int _merge(ms_op_t &op);
-  int _setkey(ms_op_t &op);
-  int _rmkey(ms_op_t &op);
-
 public:
 
   int init(string option_str="") override { m_options = option_str; return 0; }
@@ -140,26 +218,21 @@ public:
 
   using KeyValueDB::get;
 
+  /**
+   * Snapshot iterator: it sees the db as of its creation, whatever is
+   * committed afterwards.
+   */
   class MDBWholeSpaceIteratorImpl : public KeyValueDB::WholeSpaceIteratorImpl {
-
-      mdb_iter_t m_iter;
+      MemDB *m_db;
+      ReadGuard m_guard;
+      const uint64_t m_seq;
+      const Node *m_node = nullptr;
       std::pair<string, bufferlist> m_key_value;
-      mdb_map_t *m_map_p;
-      std::mutex *m_map_lock_p;
-      uint64_t *global_seq_no;
-      uint64_t this_seq_no;
-      bool m_using_btree;
 
+      void _set(const Node *n, bool forward);
   public:
-    MDBWholeSpaceIteratorImpl(mdb_map_t *btree_p, std::mutex *btree_lock_p,
-                              uint64_t *iterator_seq_no, bool using_btree) {
-      m_map_p = btree_p;
-      m_map_lock_p = btree_lock_p;
-      std::lock_guard<std::mutex> l(*m_map_lock_p);
-      global_seq_no = iterator_seq_no;
-      this_seq_no = *iterator_seq_no;
-      m_using_btree = using_btree;
-    }
+    explicit MDBWholeSpaceIteratorImpl(MemDB *db)
+      : m_db(db), m_guard(db), m_seq(db->_get_snapshot()) {}
 
     void fill_current();
     void free_last();
@@ -174,7 +247,6 @@ public:
     int upper_bound(const std::string &prefix, const std::string &after) override;
     int lower_bound(const std::string &prefix, const std::string &to) override;
     bool valid() override;
-    bool iterator_validate();
 
     int next() override;
     int prev() override;
@@ -188,12 +260,10 @@ public:
   };
 
   uint64_t get_estimated_size(std::map<std::string,uint64_t> &extra) override {
-      std::lock_guard<std::mutex> l(m_lock);
       return m_allocated_bytes;
   };
 
   int get_statfs(struct store_statfs_t *buf) override {
-    std::lock_guard<std::mutex> l(m_lock);
     buf->reset();
     buf->total = m_total_bytes;
     buf->allocated = m_allocated_bytes;
@@ -203,9 +273,8 @@ public:
 
   WholeSpaceIterator get_wholespace_iterator() override {
     return std::shared_ptr<KeyValueDB::WholeSpaceIteratorImpl>(
-      new MDBWholeSpaceIteratorImpl(&m_map, &m_lock, &iterator_seq_no, m_using_btree));
+      new MDBWholeSpaceIteratorImpl(this));
   }
 };
 
 #endif
-
@@ -567,6 +567,8 @@ int RocksDBStore::do_open(ostream &out, bool create_if_missing,
   plb.add_time_avg(l_rocksdb_write_delay_time, "rocksdb_write_delay_time", "Rocksdb write delay time");
   plb.add_time_avg(l_rocksdb_write_pre_and_post_process_time, 
       "rocksdb_write_pre_and_post_time", "total time spent on writing a record, excluding write process");
+  plb.add_u64_counter(l_rocksdb_iter_tombstones_skipped,
+      "rocksdb_iter_tombstones_skipped", "Deleted keys skipped by prefix iterators");
   logger = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(logger);
 
@@ -709,6 +711,33 @@ void RocksDBStore::get_statistics(Formatter *f)
   }
 }
 
+int RocksDBStore::set_cache_size(uint64_t s)
+{
+  cache_size = s;
+  set_cache_flag = true;
+  if (db && bbt_opts.block_cache) {
+    // already open; resize the live block cache
+    uint64_t row_cache_size = cache_size * g_conf->rocksdb_cache_row_ratio;
+    bbt_opts.block_cache->SetCapacity(cache_size - row_cache_size);
+    dout(10) << __func__ << " block_cache size now "
+	     << prettybyte_t(cache_size - row_cache_size) << dendl;
+  }
+  return 0;
+}
+
+int RocksDBStore::get_cache_stats(uint64_t *usage, uint64_t *capacity,
+				  uint64_t *misses)
+{
+  if (!bbt_opts.block_cache || !dbstats) {
+    // misses are only tracked with rocksdb_perf enabled
+    return -EOPNOTSUPP;
+  }
+  *usage = bbt_opts.block_cache->GetUsage();
+  *capacity = bbt_opts.block_cache->GetCapacity();
+  *misses = dbstats->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+  return 0;
+}
+
 int RocksDBStore::submit_common(rocksdb::WriteOptions& woptions, KeyValueDB::Transaction t) 
 {
   // enable rocksdb breakdown
@@ -997,35 +1026,40 @@ int RocksDBStore::get(
     std::map<string, bufferlist> *out)
 {
   utime_t start = ceph_clock_now();
+  if (keys.empty()) {
+    return 0;
+  }
+  // one MultiGet looks all the keys up in the same snapshot and shares
+  // the memtable and version references between them
   auto cf = get_cf_handle(prefix);
+  std::vector<rocksdb::ColumnFamilyHandle*> cfs(keys.size(),
+						cf ? cf : default_cf);
+  std::vector<string> full_keys;
+  std::vector<rocksdb::Slice> slices;
+  slices.reserve(keys.size());
   if (cf) {
     for (auto& key : keys) {
-      std::string value;
-      auto status = db->Get(rocksdb::ReadOptions(),
-			    cf,
-			    rocksdb::Slice(key),
-			    &value);
-      if (status.ok()) {
-	(*out)[key].append(value);
-      } else if (status.IsIOError()) {
-	ceph_abort_msg(cct, status.ToString());
-      }
+      slices.emplace_back(key);
     }
   } else {
+    full_keys.reserve(keys.size());
     for (auto& key : keys) {
-      std::string value;
-      string k = combine_strings(prefix, key);
-      auto status = db->Get(rocksdb::ReadOptions(),
-			    default_cf,
-			    rocksdb::Slice(k),
-			    &value);
-      if (status.ok()) {
-	(*out)[key].append(value);
-      } else if (status.IsIOError()) {
-	ceph_abort_msg(cct, status.ToString());
-      }
+      full_keys.push_back(combine_strings(prefix, key));
+      slices.emplace_back(full_keys.back());
     }
   }
+  std::vector<std::string> values;
+  std::vector<rocksdb::Status> status = db->MultiGet(rocksdb::ReadOptions(),
+						     cfs, slices, &values);
+  size_t i = 0;
+  for (auto& key : keys) {
+    if (status[i].ok()) {
+      (*out)[key].append(values[i]);
+    } else if (status[i].IsIOError()) {
+      ceph_abort_msg(cct, status[i].ToString());
+    }
+    ++i;
+  }
   utime_t lat = ceph_clock_now() - start;
   logger->inc(l_rocksdb_gets);
   logger->tinc(l_rocksdb_get_latency, lat);
@@ -1211,6 +1245,23 @@ bool RocksDBStore::check_omap_dir(string &omap_dir)
 void RocksDBStore::compact_range(const string& start, const string& end)
 {
   rocksdb::CompactRangeOptions options;
+  string prefix, key;
+  if (!cf_handles.empty() && split_key(start, &prefix, &key) == 0) {
+    // a prefix with its own column family stores its keys without the
+    // prefix; compact them there, up to the end of the column family
+    // unless the range ends within the same prefix
+    auto cf = get_cf_handle(prefix);
+    if (cf) {
+      string end_prefix, end_key;
+      bool bounded = split_key(end, &end_prefix, &end_key) == 0 &&
+	end_prefix == prefix;
+      rocksdb::Slice cstart(key);
+      rocksdb::Slice cend(end_key);
+      db->CompactRange(options, cf, key.empty() ? nullptr : &cstart,
+		       bounded ? &cend : nullptr);
+      return;
+    }
+  }
   rocksdb::Slice cstart(start);
   rocksdb::Slice cend(end);
   db->CompactRange(options, &cstart, &cend);
@@ -1416,15 +1467,162 @@ public:
   }
 };
 
+/**
+ * Iterates over a single prefix of the default column family.
+ *
+ * The rocksdb iterator is created with iterate_upper_bound set past the
+ * prefix, so a seek or next() that runs off the end of the prefix stops
+ * there instead of stepping over the (possibly deleted) keys of the
+ * prefixes that follow.  A caller that only wants part of the prefix
+ * can pass a tighter bound.  With rocksdb_perf enabled, the number of
+ * deleted keys the iterator had to skip is accounted to the
+ * rocksdb_iter_tombstones_skipped counter.
+ */
+class PrefixIteratorImpl : public KeyValueDB::IteratorImpl {
+protected:
+  string prefix;
+  string upper;
+  string bound;
+  rocksdb::Slice bound_slice;
+  rocksdb::Iterator *dbiter;
+  PerfCounters *logger;
+  bool track_skipped;
+
+  struct SkipTracker {
+    PrefixIteratorImpl *it;
+    uint64_t before = 0;
+    explicit SkipTracker(PrefixIteratorImpl *i) : it(i) {
+      if (it->track_skipped)
+	before = rocksdb::get_perf_context()->internal_delete_skipped_count;
+    }
+    ~SkipTracker() {
+      if (it->track_skipped) {
+	uint64_t after =
+	  rocksdb::get_perf_context()->internal_delete_skipped_count;
+	// the perf context may have been reset in between
+	if (after > before)
+	  it->logger->inc(l_rocksdb_iter_tombstones_skipped, after - before);
+      }
+    }
+  };
+
+  int _status() {
+    assert(!dbiter->status().IsIOError());
+    return dbiter->status().ok() ? 0 : -1;
+  }
+public:
+  PrefixIteratorImpl(rocksdb::DB *db,
+		     rocksdb::ColumnFamilyHandle *cf,
+		     const std::string& p,
+		     size_t readahead,
+		     PerfCounters *l,
+		     const std::string& b = string())
+    : prefix(p),
+      upper(RocksDBStore::past_prefix(p)),
+      bound(b.empty() ? upper : RocksDBStore::combine_strings(p, b)),
+      bound_slice(bound),
+      logger(l),
+      track_skipped(g_conf->rocksdb_perf) {
+    rocksdb::ReadOptions options;
+    options.iterate_upper_bound = &bound_slice;
+    options.readahead_size = readahead;
+    dbiter = db->NewIterator(options, cf);
+    if (track_skipped &&
+	rocksdb::GetPerfLevel() < rocksdb::PerfLevel::kEnableCount) {
+      rocksdb::SetPerfLevel(rocksdb::PerfLevel::kEnableCount);
+    }
+  }
+  ~PrefixIteratorImpl() override {
+    delete dbiter;
+  }
+
+  int seek_to_first() override {
+    SkipTracker t(this);
+    dbiter->Seek(prefix);
+    return _status();
+  }
+  int seek_to_last() override {
+    SkipTracker t(this);
+    dbiter->SeekForPrev(upper);
+    return _status();
+  }
+  int upper_bound(const string &after) override {
+    lower_bound(after);
+    if (valid() && (key() == after)) {
+      next();
+    }
+    return _status();
+  }
+  int lower_bound(const string &to) override {
+    SkipTracker t(this);
+    dbiter->Seek(RocksDBStore::combine_strings(prefix, to));
+    return _status();
+  }
+  int next(bool validate=true) override {
+    if (!validate || valid()) {
+      SkipTracker t(this);
+      dbiter->Next();
+    }
+    return _status();
+  }
+  int prev(bool validate=true) override {
+    if (!validate || valid()) {
+      SkipTracker t(this);
+      dbiter->Prev();
+    }
+    return _status();
+  }
+  bool valid() override {
+    // the upper bound stops us at the end, but prev() can still walk
+    // off the front of the prefix
+    return dbiter->Valid() &&
+      dbiter->key().starts_with(rocksdb::Slice(prefix.data(), prefix.size() + 1));
+  }
+  string key() override {
+    string out_key;
+    RocksDBStore::split_key(dbiter->key(), 0, &out_key);
+    return out_key;
+  }
+  std::pair<std::string, std::string> raw_key() override {
+    return make_pair(prefix, key());
+  }
+  bufferlist value() override {
+    return to_bufferlist(dbiter->value());
+  }
+  bufferptr value_as_ptr() override {
+    rocksdb::Slice val = dbiter->value();
+    return bufferptr(val.data(), val.size());
+  }
+  int status() override {
+    return dbiter->status().ok() ? 0 : -1;
+  }
+};
+
 KeyValueDB::Iterator RocksDBStore::get_iterator(const std::string& prefix)
 {
+  size_t readahead = cct->_conf->get_val<uint64_t>("rocksdb_iterator_readahead");
   rocksdb::ColumnFamilyHandle *cf_handle =
     static_cast<rocksdb::ColumnFamilyHandle*>(get_cf_handle(prefix));
   if (cf_handle) {
+    rocksdb::ReadOptions options;
+    options.readahead_size = readahead;
     return std::make_shared<CFIteratorImpl>(
       prefix,
-      db->NewIterator(rocksdb::ReadOptions(), cf_handle));
+      db->NewIterator(options, cf_handle));
   } else {
-    return KeyValueDB::get_iterator(prefix);
+    return std::make_shared<PrefixIteratorImpl>(
+      db, default_cf, prefix, readahead, logger);
+  }
+}
+
+KeyValueDB::Iterator RocksDBStore::get_bounded_iterator(
+  const std::string& prefix,
+  const std::string& upper)
+{
+  if (get_cf_handle(prefix)) {
+    return get_iterator(prefix);
   }
+  size_t readahead = cct->_conf->get_val<uint64_t>("rocksdb_iterator_readahead");
+  return std::make_shared<PrefixIteratorImpl>(
+    db, default_cf, prefix, readahead, logger, upper);
 }
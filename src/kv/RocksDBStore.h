@@ -42,6 +42,7 @@ enum {
   l_rocksdb_write_memtable_time,
   l_rocksdb_write_delay_time,
   l_rocksdb_write_pre_and_post_process_time,
+  l_rocksdb_iter_tombstones_skipped,
   l_rocksdb_last,
 };
 
@@ -125,10 +126,10 @@ public:
   int init(string options_str) override;
   /// compact rocksdb for all keys with a given prefix
   void compact_prefix(const string& prefix) override {
-    compact_range(prefix, past_prefix(prefix));
+    compact_range(combine_strings(prefix, string()), past_prefix(prefix));
   }
   void compact_prefix_async(const string& prefix) override {
-    compact_range_async(prefix, past_prefix(prefix));
+    compact_range_async(combine_strings(prefix, string()), past_prefix(prefix));
   }
 
   void compact_range(const string& prefix, const string& start, const string& end) override {
@@ -372,6 +373,8 @@ public:
   };
 
   Iterator get_iterator(const std::string& prefix) override;
+  Iterator get_bounded_iterator(const std::string& prefix,
+				const std::string& upper) override;
 
   /// Utility
   static string combine_strings(const string &prefix, const string &value) {
@@ -467,11 +470,9 @@ err:
     return total_size;
   }
 
-  int set_cache_size(uint64_t s) override {
-    cache_size = s;
-    set_cache_flag = true;
-    return 0;
-  }
+  int set_cache_size(uint64_t s) override;
+  int get_cache_stats(uint64_t *usage, uint64_t *capacity,
+		      uint64_t *misses) override;
 
   WholeSpaceIterator get_wholespace_iterator() override;
 };
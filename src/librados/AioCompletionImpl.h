@@ -15,6 +15,9 @@
 #ifndef CEPH_LIBRADOS_AIOCOMPLETIONIMPL_H
 #define CEPH_LIBRADOS_AIOCOMPLETIONIMPL_H
 
+#include <deque>
+
+#include "common/Clock.h"
 #include "common/Cond.h"
 #include "common/Mutex.h"
 
@@ -23,9 +26,52 @@
 #include "include/rados/librados.hpp"
 #include "include/xlist.h"
 #include "osd/osd_types.h"
+#include "osdc/Objecter.h"
 
 class IoCtxImpl;
 
+/**
+ * Completions created on a queue are handed to it as they finish, and
+ * the application reaps them from its own threads instead of taking
+ * callbacks from the single finisher thread.
+ */
+struct librados::AioCompletionQueueImpl {
+  Mutex lock;
+  Cond cond;
+  std::deque<void*> done;
+
+  AioCompletionQueueImpl() : lock("AioCompletionQueueImpl lock", false, false) {}
+
+  void push(void *cookie) {
+    lock.Lock();
+    done.push_back(cookie);
+    cond.SignalAll();
+    lock.Unlock();
+  }
+
+  /// wait for min_nr completions or the timeout, reap up to max_nr
+  int wait(unsigned min_nr, unsigned max_nr, void **out,
+	   const struct timespec *timeout) {
+    utime_t until;
+    if (timeout)
+      until = ceph_clock_now() + utime_t(*timeout);
+    lock.Lock();
+    while (done.size() < min_nr) {
+      if (!timeout)
+	cond.Wait(lock);
+      else if (cond.WaitUntil(lock, until) == ETIMEDOUT)
+	break;
+    }
+    unsigned n = 0;
+    while (n < max_nr && !done.empty()) {
+      out[n++] = done.front();
+      done.pop_front();
+    }
+    lock.Unlock();
+    return n;
+  }
+};
+
 struct librados::AioCompletionImpl {
   Mutex lock;
   Cond cond;
@@ -48,6 +94,15 @@ struct librados::AioCompletionImpl {
   ceph_tid_t aio_write_seq;
   xlist<AioCompletionImpl*>::item aio_write_list_item;
 
+  // what cq hands back when we complete: the C++ wrapper or ourselves
+  AioCompletionQueueImpl *cq = nullptr;
+  void *cq_cookie = nullptr;
+
+  // stage timing (objecter_op_latency_stages), see get_latency()
+  Objecter::op_latency_t latency;
+  ceph::mono_time complete_stamp;
+  ceph::mono_time dispatch_stamp;
+
   AioCompletionImpl() : lock("AioCompletionImpl lock", false, false),
 			ref(1), rval(0), released(false),
 			complete(false),
@@ -60,6 +115,15 @@ struct librados::AioCompletionImpl {
 			is_read(false), blp(nullptr), out_buf(nullptr),
 			io(NULL), aio_write_seq(0), aio_write_list_item(this) { }
 
+  // lock is held and complete was just set
+  void _queue_complete() {
+    assert(lock.is_locked());
+    if (latency.is_set())
+      complete_stamp = ceph::mono_clock::now();
+    if (cq)
+      cq->push(cq_cookie);
+  }
+
   int set_complete_callback(void *cb_arg, rados_callback_t cb) {
     lock.Lock();
     callback_complete = cb;
@@ -124,6 +188,20 @@ struct librados::AioCompletionImpl {
     lock.Unlock();
     return v;
   }
+  int get_latency(struct rados_aio_latency *lat) {
+    Mutex::Locker l(lock);
+    if (!complete || !latency.is_set())
+      return -ENODATA;
+    auto ns = [](ceph::timespan t) -> uint64_t {
+      return std::chrono::nanoseconds(t).count();
+    };
+    lat->submit_ns = ns(latency.sent - latency.submit);
+    lat->osd_ns = ns(latency.reply - latency.sent);
+    lat->complete_ns = ns(complete_stamp - latency.reply);
+    lat->dispatch_ns = dispatch_stamp == ceph::mono_time() ?
+      0 : ns(dispatch_stamp - complete_stamp);
+    return 0;
+  }
 
   void get() {
     lock.Lock();
@@ -163,6 +241,10 @@ struct C_AioComplete : public Context {
   }
 
   void finish(int r) override {
+    if (c->latency.is_set()) {
+      Mutex::Locker l(c->lock);
+      c->dispatch_stamp = ceph::mono_clock::now();
+    }
     rados_callback_t cb_complete = c->callback_complete;
     void *cb_complete_arg = c->callback_complete_arg;
     if (cb_complete)
@@ -200,6 +282,7 @@ struct C_AioCompleteAndSafe : public Context {
     c->lock.Lock();
     c->rval = r;
     c->complete = true;
+    c->_queue_complete();
     c->lock.Unlock();
 
     rados_callback_t cb_complete = c->callback_complete;
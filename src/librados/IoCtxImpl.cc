@@ -75,6 +75,19 @@ struct C_notify_Finish : public Context {
   }
 };
 
+struct C_aio_batch_op : public Context {
+  int *prval;
+  Context *sub;
+
+  C_aio_batch_op(int *prval, Context *sub) : prval(prval), sub(sub) {}
+
+  void finish(int r) override {
+    if (prval)
+      *prval = r;
+    sub->complete(r);
+  }
+};
+
 struct C_aio_linger_cancel : public Context {
   Objecter *objecter;
   Objecter::LingerOp *linger_op;
@@ -110,6 +123,7 @@ struct C_aio_linger_Complete : public Context {
     c->rval = r;
     c->complete = true;
     c->cond.Signal();
+    c->_queue_complete();
 
     if (c->callback_complete ||
 	c->callback_safe) {
@@ -197,6 +211,7 @@ struct C_aio_selfmanaged_snap_op_Complete : public Context {
     c->rval = r;
     c->complete = true;
     c->cond.Signal();
+    c->_queue_complete();
 
     if (c->callback_complete || c->callback_safe) {
       client->finisher.queue(new librados::C_AioComplete(c));
@@ -765,6 +780,48 @@ int librados::IoCtxImpl::operate_read(const object_t& oid,
   return r;
 }
 
+void librados::IoCtxImpl::aio_submit(Objecter::Op *op, AioCompletionImpl *c)
+{
+  if (client->cct->_conf->objecter_op_latency_stages) {
+    op->latency_out = &c->latency;
+  }
+  objecter->op_submit(op, &c->tid);
+}
+
+int librados::IoCtxImpl::aio_operate_batch(
+  const std::vector<object_t>& oids,
+  const std::vector< ::ObjectOperation*>& ops,
+  AioCompletionImpl *c, const SnapContext& snap_context, int flags,
+  std::vector<int> *prvals)
+{
+  FUNCTRACE();
+  auto ut = ceph::real_clock::now();
+  /* can't write to a snapshot */
+  if (snap_seq != CEPH_NOSNAP)
+    return -EROFS;
+  if (oids.size() != ops.size())
+    return -EINVAL;
+  if (prvals)
+    prvals->assign(ops.size(), 0);
+
+  c->io = this;
+  queue_aio_write(c);
+
+  // c completes once, with the first error if any op failed
+  C_GatherBuilder gather(client->cct, new C_aio_Complete(c));
+  std::vector<Objecter::Op*> batch;
+  batch.reserve(ops.size());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    Context *oncomplete = new C_aio_batch_op(
+      prvals ? &(*prvals)[i] : nullptr, gather.new_sub());
+    batch.push_back(objecter->prepare_mutate_op(
+      oids[i], oloc, *ops[i], snap_context, ut, flags, oncomplete, nullptr));
+  }
+  gather.activate();
+  objecter->op_submit_batch(batch);
+  return 0;
+}
+
 int librados::IoCtxImpl::aio_operate_read(const object_t &oid,
 					  ::ObjectOperation *o,
 					  AioCompletionImpl *c,
@@ -791,7 +848,7 @@ int librados::IoCtxImpl::aio_operate_read(const object_t &oid,
   Objecter::Op *objecter_op = objecter->prepare_read_op(oid, oloc,
 		 *o, snap_seq, pbl, flags,
 		 oncomplete, &c->objver, nullptr, 0, &trace);
-  objecter->op_submit(objecter_op, &c->tid);
+  aio_submit(objecter_op, c);
   trace.event("rados operate read submitted");
 
   return 0;
@@ -827,7 +884,7 @@ int librados::IoCtxImpl::aio_operate(const object_t& oid,
   Objecter::Op *op = objecter->prepare_mutate_op(
     oid, oloc, *o, snap_context, ut, flags,
     oncomplete, &c->objver, osd_reqid_t(), &trace);
-  objecter->op_submit(op, &c->tid);
+  aio_submit(op, c);
   trace.event("rados operate op submitted");
 
   return 0;
@@ -859,7 +916,7 @@ int librados::IoCtxImpl::aio_read(const object_t oid, AioCompletionImpl *c,
     oid, oloc,
     off, len, snapid, pbl, 0,
     oncomplete, &c->objver, nullptr, 0, &trace);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -892,7 +949,7 @@ int librados::IoCtxImpl::aio_read(const object_t oid, AioCompletionImpl *c,
     oid, oloc,
     off, len, snapid, &c->bl, 0,
     oncomplete, &c->objver, nullptr, 0, &trace);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -932,7 +989,7 @@ int librados::IoCtxImpl::aio_sparse_read(const object_t oid,
     oid, oloc,
     onack->m_ops, snapid, NULL, 0,
     onack, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -952,7 +1009,7 @@ int librados::IoCtxImpl::aio_cmpext(const object_t& oid,
   Objecter::Op *o = objecter->prepare_cmpext_op(
     oid, oloc, off, cmp_bl, snap_seq, 0,
     onack, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -980,7 +1037,7 @@ int librados::IoCtxImpl::aio_cmpext(const object_t& oid,
 
   Objecter::Op *o = objecter->prepare_read_op(
     oid, oloc, onack->m_ops, snap_seq, NULL, 0, onack, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1015,7 +1072,7 @@ int librados::IoCtxImpl::aio_write(const object_t &oid, AioCompletionImpl *c,
     oid, oloc,
     off, len, snapc, bl, ut, 0,
     oncomplete, &c->objver, nullptr, 0, &trace);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -1044,7 +1101,7 @@ int librados::IoCtxImpl::aio_append(const object_t &oid, AioCompletionImpl *c,
     oid, oloc,
     len, snapc, bl, ut, 0,
     oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -1074,7 +1131,7 @@ int librados::IoCtxImpl::aio_write_full(const object_t &oid,
     oid, oloc,
     snapc, bl, ut, 0,
     oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -1109,7 +1166,7 @@ int librados::IoCtxImpl::aio_writesame(const object_t &oid,
     write_len, off,
     snapc, bl, ut, 0,
     oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -1135,7 +1192,7 @@ int librados::IoCtxImpl::aio_remove(const object_t &oid, AioCompletionImpl *c, i
     oid, oloc,
     snapc, ut, flags,
     oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
 
   return 0;
 }
@@ -1151,7 +1208,7 @@ int librados::IoCtxImpl::aio_stat(const object_t& oid, AioCompletionImpl *c,
     oid, oloc,
     snap_seq, psize, &onack->mtime, 0,
     onack, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1165,7 +1222,7 @@ int librados::IoCtxImpl::aio_stat2(const object_t& oid, AioCompletionImpl *c,
     oid, oloc,
     snap_seq, psize, &onack->mtime, 0,
     onack, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1256,7 +1313,7 @@ int librados::IoCtxImpl::hit_set_list(uint32_t hash, AioCompletionImpl *c,
   object_locator_t oloc(poolid);
   Objecter::Op *o = objecter->prepare_pg_read_op(
     hash, oloc, rd, NULL, 0, oncomplete, NULL, NULL);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1273,7 +1330,7 @@ int librados::IoCtxImpl::hit_set_get(uint32_t hash, AioCompletionImpl *c,
   object_locator_t oloc(poolid);
   Objecter::Op *o = objecter->prepare_pg_read_op(
     hash, oloc, rd, NULL, 0, oncomplete, NULL, NULL);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1318,7 +1375,7 @@ int librados::IoCtxImpl::get_inconsistent_objects(const pg_t& pg,
   Objecter::Op *o = objecter->prepare_pg_read_op(
     oloc.hash, oloc, op, nullptr, CEPH_OSD_FLAG_PGOP, oncomplete,
     nullptr, nullptr);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1339,7 +1396,7 @@ int librados::IoCtxImpl::get_inconsistent_snapsets(const pg_t& pg,
   Objecter::Op *o = objecter->prepare_pg_read_op(
     oloc.hash, oloc, op, nullptr, CEPH_OSD_FLAG_PGOP, oncomplete,
     nullptr, nullptr);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1403,7 +1460,7 @@ int librados::IoCtxImpl::aio_exec(const object_t& oid, AioCompletionImpl *c,
   rd.call(cls, method, inbl);
   Objecter::Op *o = objecter->prepare_read_op(
     oid, oloc, rd, snap_seq, outbl, 0, oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1429,7 +1486,7 @@ int librados::IoCtxImpl::aio_exec(const object_t& oid, AioCompletionImpl *c,
   rd.call(cls, method, inbl);
   Objecter::Op *o = objecter->prepare_read_op(
     oid, oloc, rd, snap_seq, &c->bl, 0, oncomplete, &c->objver);
-  objecter->op_submit(o, &c->tid);
+  aio_submit(o, c);
   return 0;
 }
 
@@ -1968,6 +2025,7 @@ void librados::IoCtxImpl::C_aio_stat_Ack::finish(int r)
   if (r >= 0 && pmtime) {
     *pmtime = real_clock::to_time_t(mtime);
   }
+  c->_queue_complete();
 
   if (c->callback_complete) {
     c->io->client->finisher.queue(new C_AioComplete(c));
@@ -1996,6 +2054,7 @@ void librados::IoCtxImpl::C_aio_stat2_Ack::finish(int r)
   if (r >= 0 && pts) {
     *pts = real_clock::to_timespec(mtime);
   }
+  c->_queue_complete();
 
   if (c->callback_complete) {
     c->io->client->finisher.queue(new C_AioComplete(c));
@@ -2024,6 +2083,8 @@ void librados::IoCtxImpl::C_aio_Complete::finish(int r)
       c->blp->copy(0, c->blp->length(), c->out_buf);
     c->rval = c->blp->length();
   }
+  // only once out_buf is filled in: reapers don't take our lock
+  c->_queue_complete();
 
   if (c->callback_complete ||
       c->callback_safe) {
@@ -161,6 +161,12 @@ struct librados::IoCtxImpl {
 		  int flags, const blkin_trace_info *trace_info = nullptr);
   int aio_operate_read(const object_t& oid, ::ObjectOperation *o,
 		       AioCompletionImpl *c, int flags, bufferlist *pbl, const blkin_trace_info *trace_info = nullptr);
+  int aio_operate_batch(const std::vector<object_t>& oids,
+			const std::vector< ::ObjectOperation*>& ops,
+			AioCompletionImpl *c, const SnapContext& snap_context,
+			int flags, std::vector<int> *prvals);
+  /// submit an op completing c, recording its stage timing in c
+  void aio_submit(Objecter::Op *op, AioCompletionImpl *c);
 
   struct C_aio_stat_Ack : public Context {
     librados::AioCompletionImpl *c;
@@ -418,6 +418,7 @@ struct C_aio_watch_flush_Complete : public Context {
     c->rval = r;
     c->complete = true;
     c->cond.Signal();
+    c->_queue_complete();
 
     if (c->callback_complete ||
 	c->callback_safe) {
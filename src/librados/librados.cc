@@ -1047,6 +1047,13 @@ uint64_t librados::AioCompletion::AioCompletion::get_version64()
   return c->get_version();
 }
 
+int librados::AioCompletion::AioCompletion::get_latency(
+  struct rados_aio_latency *lat)
+{
+  AioCompletionImpl *c = (AioCompletionImpl *)pc;
+  return c->get_latency(lat);
+}
+
 void librados::AioCompletion::AioCompletion::release()
 {
   AioCompletionImpl *c = (AioCompletionImpl *)pc;
@@ -1054,6 +1061,26 @@ void librados::AioCompletion::AioCompletion::release()
   delete this;
 }
 
+///////////////////////////// AioCompletionQueue //////////////////////////////
+librados::AioCompletionQueue::AioCompletionQueue()
+  : pcq(new AioCompletionQueueImpl)
+{
+}
+
+librados::AioCompletionQueue::~AioCompletionQueue()
+{
+  delete pcq;
+}
+
+int librados::AioCompletionQueue::wait(unsigned min_nr, unsigned max_nr,
+				       AioCompletion **completions,
+				       struct timespec *timeout)
+{
+  // completions made by Rados::aio_create_completion(cq) carry their
+  // wrapper as the cookie
+  return pcq->wait(min_nr, max_nr, (void **)completions, timeout);
+}
+
 ///////////////////////////// IoCtx //////////////////////////////
 librados::IoCtx::IoCtx() : io_ctx_impl(NULL)
 {
@@ -1515,6 +1542,20 @@ int librados::IoCtx::aio_operate(const std::string& oid, AioCompletion *c,
 				  translate_flags(flags));
 }
 
+int librados::IoCtx::aio_operate_batch(
+  const std::vector<std::string>& oids,
+  const std::vector<ObjectWriteOperation*>& ops,
+  AioCompletion *c, std::vector<int> *prvals, int flags)
+{
+  std::vector<object_t> objs(oids.begin(), oids.end());
+  std::vector< ::ObjectOperation*> os;
+  os.reserve(ops.size());
+  for (auto o : ops)
+    os.push_back(&o->impl->o);
+  return io_ctx_impl->aio_operate_batch(objs, os, c->pc, io_ctx_impl->snapc,
+					translate_flags(flags), prvals);
+}
+
 int librados::IoCtx::aio_operate(const std::string& oid, AioCompletion *c,
 				 librados::ObjectWriteOperation *o,
 				 snap_t snap_seq, std::vector<snap_t>& snaps)
@@ -2749,6 +2790,16 @@ librados::AioCompletion *librados::Rados::aio_create_completion(void *cb_arg,
   return new AioCompletion(c);
 }
 
+librados::AioCompletion *librados::Rados::aio_create_completion(
+  AioCompletionQueue *cq)
+{
+  AioCompletionImpl *c = new AioCompletionImpl;
+  AioCompletion *completion = new AioCompletion(c);
+  c->cq = cq->pcq;
+  c->cq_cookie = completion;
+  return completion;
+}
+
 librados::ObjectOperation::ObjectOperation()
 {
   impl = new ObjectOperationImpl;
@@ -4674,6 +4725,36 @@ extern "C" int rados_aio_create_completion(void *cb_arg,
   return 0;
 }
 
+extern "C" int rados_aio_cq_create(rados_completion_queue_t *pcq)
+{
+  *pcq = new librados::AioCompletionQueueImpl;
+  return 0;
+}
+
+extern "C" void rados_aio_cq_destroy(rados_completion_queue_t cq)
+{
+  delete (librados::AioCompletionQueueImpl *)cq;
+}
+
+extern "C" int rados_aio_create_completion_cq(rados_completion_queue_t cq,
+					      rados_completion_t *pc)
+{
+  librados::AioCompletionImpl *c = new librados::AioCompletionImpl;
+  c->cq = (librados::AioCompletionQueueImpl *)cq;
+  c->cq_cookie = c;
+  *pc = c;
+  return 0;
+}
+
+extern "C" int rados_aio_cq_wait(rados_completion_queue_t cq,
+				 unsigned min_nr, unsigned max_nr,
+				 rados_completion_t *completions,
+				 struct timespec *timeout)
+{
+  return ((librados::AioCompletionQueueImpl *)cq)->wait(min_nr, max_nr,
+							 completions, timeout);
+}
+
 extern "C" int rados_aio_wait_for_complete(rados_completion_t c)
 {
   tracepoint(librados, rados_aio_wait_for_complete_enter, c);
@@ -4754,6 +4835,12 @@ extern "C" uint64_t rados_aio_get_version(rados_completion_t c)
   return retval;
 }
 
+extern "C" int rados_aio_get_latency(rados_completion_t c,
+				     struct rados_aio_latency *lat)
+{
+  return ((librados::AioCompletionImpl*)c)->get_latency(lat);
+}
+
 extern "C" void rados_aio_release(rados_completion_t c)
 {
   tracepoint(librados, rados_aio_release_enter, c);
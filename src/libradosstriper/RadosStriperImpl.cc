@@ -528,7 +528,10 @@ int libradosstriper::RadosStriperImpl::write(const std::string& soid,
   // and size and take a shared lock on it
   ceph_file_layout layout;
   std::string lockCookie;
-  int rc = createAndOpenStripedObject(soid, &layout, len+off, &lockCookie, true);
+  uint64_t size = len+off;
+  // try the common case of an existing object first, the open falls back
+  // to creating the object if it does not exist
+  int rc = openStripedObjectForWrite(soid, &layout, &size, &lockCookie, true);
   if (rc) return rc;
   return write_in_open_object(soid, layout, lockCookie, bl, len, off);
 }
@@ -584,7 +587,8 @@ int libradosstriper::RadosStriperImpl::aio_write(const std::string& soid,
 {
   ceph_file_layout layout;
   std::string lockCookie;
-  int rc = createAndOpenStripedObject(soid, &layout, len+off, &lockCookie, true);
+  uint64_t size = len+off;
+  int rc = openStripedObjectForWrite(soid, &layout, &size, &lockCookie, true);
   if (rc) return rc;
   return aio_write_in_open_object(soid, c, layout, lockCookie, bl, len, off);
 }
@@ -1438,6 +1442,13 @@ int libradosstriper::RadosStriperImpl::openStripedObjectForWrite(const std::stri
   // atomically update object size, only if smaller than current one
   if (!isFileSizeAbsolute)
     *size += curSize;
+  if (*size <= curSize) {
+    // the object is already big enough. It cannot shrink while we hold the
+    // shared lock, as truncation takes the exclusive one, so overwrites
+    // inside the object do not need to touch the size
+    *size = curSize;
+    return 0;
+  }
   librados::ObjectWriteOperation writeOp;
   writeOp.cmpxattr(XATTR_SIZE, LIBRADOS_CMPXATTR_OP_GT, *size);
   std::ostringstream oss;
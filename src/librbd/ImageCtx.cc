@@ -25,6 +25,7 @@
 #include "librbd/Types.h"
 #include "librbd/Utils.h"
 #include "librbd/LibrbdWriteback.h"
+#include "librbd/cache/WriteLogImageCache.h"
 #include "librbd/exclusive_lock/AutomaticPolicy.h"
 #include "librbd/exclusive_lock/StandardPolicy.h"
 #include "librbd/io/AioCompletion.h"
@@ -397,6 +398,8 @@ struct C_InvalidateCache : public Context {
     plb.add_u64_counter(l_librbd_cmp, "cmp", "CompareAndWrites");
     plb.add_u64_counter(l_librbd_cmp_bytes, "cmp_bytes", "Data size in cmps");
     plb.add_time_avg(l_librbd_cmp_latency, "cmp_latency", "Latency of cmps");
+    plb.add_time_avg(l_librbd_aio_queue_latency, "aio_queue_latency",
+                     "Time requests wait between submission and dispatch");
     plb.add_u64_counter(l_librbd_snap_create, "snap_create", "Snap creations");
     plb.add_u64_counter(l_librbd_snap_remove, "snap_remove", "Snap removals");
     plb.add_u64_counter(l_librbd_snap_rollback, "snap_rollback", "Snap rollbacks");
@@ -405,6 +408,10 @@ struct C_InvalidateCache : public Context {
     plb.add_u64_counter(l_librbd_resize, "resize", "Resizes");
     plb.add_u64_counter(l_librbd_readahead, "readahead", "Read ahead");
     plb.add_u64_counter(l_librbd_readahead_bytes, "readahead_bytes", "Data size in read ahead");
+    plb.add_u64_counter(l_librbd_writeback_ops, "writeback_ops", "Object writes issued by cache writeback");
+    plb.add_u64_counter(l_librbd_writeback_extents, "writeback_extents", "Dirty cache extents written back");
+    plb.add_u64_counter(l_librbd_parent_cache_hit, "parent_cache_hit", "Parent reads served by the parent cache");
+    plb.add_u64_counter(l_librbd_parent_cache_miss, "parent_cache_miss", "Parent reads that missed the parent cache");
     plb.add_u64_counter(l_librbd_invalidate_cache, "invalidate_cache", "Cache invalidates");
 
     plb.add_time(l_librbd_opened_time, "opened_time", "Opened time",
@@ -997,6 +1004,7 @@ struct C_InvalidateCache : public Context {
         "rbd_cache_max_dirty_age", false)(
         "rbd_cache_max_dirty_object", false)(
         "rbd_cache_block_writes_upfront", false)(
+        "rbd_cache_writeback_coalesce", false)(
         "rbd_concurrent_management_ops", false)(
         "rbd_balance_snap_reads", false)(
         "rbd_localize_snap_reads", false)(
@@ -1016,12 +1024,16 @@ struct C_InvalidateCache : public Context {
         "rbd_journal_object_flush_interval", false)(
         "rbd_journal_object_flush_bytes", false)(
         "rbd_journal_object_flush_age", false)(
+        "rbd_journal_object_max_in_flight_appends", false)(
+        "rbd_journal_concurrent_io", false)(
         "rbd_journal_pool", false)(
         "rbd_journal_max_payload_bytes", false)(
         "rbd_journal_max_concurrent_object_sets", false)(
         "rbd_mirroring_resync_after_disconnect", false)(
         "rbd_mirroring_replay_delay", false)(
-        "rbd_skip_partial_discard", false);
+        "rbd_skip_partial_discard", false)(
+        "rbd_persistent_cache_enabled", false)(
+        "rbd_parent_cache_enabled", false);
 
     md_config_t local_config_t;
     std::map<std::string, bufferlist> res;
@@ -1056,6 +1068,7 @@ struct C_InvalidateCache : public Context {
     ASSIGN_OPTION(cache_max_dirty_age, double);
     ASSIGN_OPTION(cache_max_dirty_object, int64_t);
     ASSIGN_OPTION(cache_block_writes_upfront, bool);
+    ASSIGN_OPTION(cache_writeback_coalesce, bool);
     ASSIGN_OPTION(concurrent_management_ops, int64_t);
     ASSIGN_OPTION(balance_snap_reads, bool);
     ASSIGN_OPTION(localize_snap_reads, bool);
@@ -1076,12 +1089,16 @@ struct C_InvalidateCache : public Context {
     ASSIGN_OPTION(journal_object_flush_interval, int64_t);
     ASSIGN_OPTION(journal_object_flush_bytes, int64_t);
     ASSIGN_OPTION(journal_object_flush_age, double);
+    ASSIGN_OPTION(journal_object_max_in_flight_appends, int64_t);
+    ASSIGN_OPTION(journal_concurrent_io, bool);
     ASSIGN_OPTION(journal_max_payload_bytes, uint64_t);
     ASSIGN_OPTION(journal_max_concurrent_object_sets, int64_t);
     ASSIGN_OPTION(mirroring_resync_after_disconnect, bool);
     ASSIGN_OPTION(mirroring_replay_delay, int64_t);
     ASSIGN_OPTION(skip_partial_discard, bool);
     ASSIGN_OPTION(blkin_trace_all, bool);
+    ASSIGN_OPTION(persistent_cache_enabled, bool);
+    ASSIGN_OPTION(parent_cache_enabled, bool);
 
     if (thread_safe) {
       ASSIGN_OPTION(journal_pool, std::string);
@@ -1104,6 +1121,10 @@ struct C_InvalidateCache : public Context {
     return new Journal<ImageCtx>(*this);
   }
 
+  cache::ImageCache *ImageCtx::create_image_cache() {
+    return new cache::WriteLogImageCache<ImageCtx>(*this);
+  }
+
   void ImageCtx::set_image_name(const std::string &image_name) {
     // update the name so rename can be invoked repeatedly
     RWLock::RLocker owner_locker(owner_lock);
@@ -172,6 +172,7 @@ namespace librbd {
     double cache_max_dirty_age;
     uint32_t cache_max_dirty_object;
     bool cache_block_writes_upfront;
+    bool cache_writeback_coalesce;
     uint32_t concurrent_management_ops;
     bool balance_snap_reads;
     bool localize_snap_reads;
@@ -192,6 +193,8 @@ namespace librbd {
     int journal_object_flush_interval;
     uint64_t journal_object_flush_bytes;
     double journal_object_flush_age;
+    uint64_t journal_object_max_in_flight_appends;
+    bool journal_concurrent_io;
     std::string journal_pool;
     uint32_t journal_max_payload_bytes;
     int journal_max_concurrent_object_sets;
@@ -199,6 +202,8 @@ namespace librbd {
     int mirroring_replay_delay;
     bool skip_partial_discard;
     bool blkin_trace_all;
+    bool persistent_cache_enabled;
+    bool parent_cache_enabled;
 
     LibrbdAdminSocketHook *asok_hook;
 
@@ -318,6 +323,7 @@ namespace librbd {
     ExclusiveLock<ImageCtx> *create_exclusive_lock();
     ObjectMap<ImageCtx> *create_object_map(uint64_t snap_id);
     Journal<ImageCtx> *create_journal();
+    cache::ImageCache *create_image_cache();
 
     void clear_pending_completions();
 
@@ -2,10 +2,12 @@
 // vim: ts=8 sw=2 smarttab
 
 #include <errno.h>
+#include <set>
 
 #include "common/ceph_context.h"
 #include "common/dout.h"
 #include "common/Mutex.h"
+#include "common/perf_counters.h"
 #include "common/WorkQueue.h"
 #include "include/Context.h"
 #include "include/rados/librados.hpp"
@@ -17,6 +19,7 @@
 #include "librbd/LibrbdWriteback.h"
 #include "librbd/ObjectMap.h"
 #include "librbd/Journal.h"
+#include "librbd/Types.h"
 #include "librbd/Utils.h"
 #include "librbd/io/AioCompletion.h"
 #include "librbd/io/ObjectRequest.h"
@@ -92,6 +95,14 @@ namespace librbd {
     LibrbdWriteback *m_wb_handler;
   };
 
+  /// object extent of a write covered by a single journal event
+  struct JournalExtent {
+    uint64_t journal_tid;
+    uint64_t off;
+    uint64_t len;
+  };
+  typedef std::vector<JournalExtent> JournalExtents;
+
   struct C_WriteJournalCommit : public Context {
     typedef std::vector<std::pair<uint64_t,uint64_t> > Extents;
 
@@ -101,7 +112,7 @@ namespace librbd {
     uint64_t off;
     bufferlist bl;
     SnapContext snapc;
-    uint64_t journal_tid;
+    JournalExtents journal_extents;
     ZTracer::Trace trace;
     Context *req_comp;
     bool request_sent = false;
@@ -109,15 +120,15 @@ namespace librbd {
     C_WriteJournalCommit(ImageCtx *_image_ctx, const std::string &_oid,
                          uint64_t _object_no, uint64_t _off,
                          const bufferlist &_bl, const SnapContext& _snapc,
-                         uint64_t _journal_tid,
+                         const JournalExtents &_journal_extents,
 			 const ZTracer::Trace &trace, Context *_req_comp)
       : image_ctx(_image_ctx), oid(_oid), object_no(_object_no), off(_off),
-        bl(_bl), snapc(_snapc), journal_tid(_journal_tid),
+        bl(_bl), snapc(_snapc), journal_extents(_journal_extents),
         trace(trace), req_comp(_req_comp) {
       CephContext *cct = image_ctx->cct;
       ldout(cct, 20) << this << " C_WriteJournalCommit: "
-                     << "delaying write until journal tid "
-                     << journal_tid << " safe" << dendl;
+                     << "delaying write until " << journal_extents.size()
+                     << " journal event(s) safe" << dendl;
     }
 
     void complete(int r) override {
@@ -147,13 +158,16 @@ namespace librbd {
       // all IO operations are flushed prior to closing the journal
       assert(image_ctx->journal != NULL);
 
-      Extents file_extents;
-      Striper::extent_to_file(cct, &image_ctx->layout, object_no, off,
-                              bl.length(), file_extents);
-      for (Extents::iterator it = file_extents.begin();
-           it != file_extents.end(); ++it) {
-        image_ctx->journal->commit_io_event_extent(journal_tid, it->first,
-                                                   it->second, r);
+      for (auto &journal_extent : journal_extents) {
+        Extents file_extents;
+        Striper::extent_to_file(cct, &image_ctx->layout, object_no,
+                                journal_extent.off, journal_extent.len,
+                                file_extents);
+        for (Extents::iterator it = file_extents.begin();
+             it != file_extents.end(); ++it) {
+          image_ctx->journal->commit_io_event_extent(
+            journal_extent.journal_tid, it->first, it->second, r);
+        }
       }
     }
 
@@ -192,6 +206,46 @@ namespace librbd {
     }
   };
 
+  /**
+   * write one contiguous object extent, after the journal events
+   * covering it (if any) are safe
+   */
+  static void send_object_write(ImageCtx *image_ctx, const std::string &oid,
+                                uint64_t object_no, uint64_t off,
+                                const bufferlist &bl, const SnapContext &snapc,
+                                const JournalExtents &journal_extents,
+                                const ZTracer::Trace &trace,
+                                Context *on_finish) {
+    image_ctx->perfcounter->inc(l_librbd_writeback_ops);
+    if (journal_extents.empty()) {
+      auto req = new io::ObjectWriteRequest(
+        image_ctx, oid, object_no, off, bl, snapc, 0, trace, on_finish);
+      req->send();
+      return;
+    }
+
+    // all IO operations are flushed prior to closing the journal
+    assert(image_ctx->journal != NULL);
+    Context *ctx = new C_WriteJournalCommit(image_ctx, oid, object_no, off, bl,
+                                           snapc, journal_extents, trace,
+                                           on_finish);
+    if (journal_extents.size() == 1) {
+      image_ctx->journal->flush_event(journal_extents.front().journal_tid,
+                                      ctx);
+      return;
+    }
+
+    std::set<uint64_t> journal_tids;
+    for (auto &journal_extent : journal_extents) {
+      journal_tids.insert(journal_extent.journal_tid);
+    }
+    C_Gather *gather_ctx = new C_Gather(image_ctx->cct, ctx);
+    for (auto journal_tid : journal_tids) {
+      image_ctx->journal->flush_event(journal_tid, gather_ctx->new_sub());
+    }
+    gather_ctx->activate();
+  }
+
   LibrbdWriteback::LibrbdWriteback(ImageCtx *ictx, Mutex& lock)
     : m_tid(0), m_lock(lock), m_ictx(ictx) {
   }
@@ -279,18 +333,60 @@ namespace librbd {
     C_OrderedWrite *req_comp = new C_OrderedWrite(m_ictx->cct, result, trace,
                                                   this);
 
-    // all IO operations are flushed prior to closing the journal
-    assert(journal_tid == 0 || m_ictx->journal != NULL);
+    JournalExtents journal_extents;
     if (journal_tid != 0) {
-      m_ictx->journal->flush_event(
-        journal_tid, new C_WriteJournalCommit(
-	  m_ictx, oid.name, object_no, off, bl, snapc, journal_tid, trace,
-          req_comp));
-    } else {
-      auto req = new io::ObjectWriteRequest(
-	m_ictx, oid.name, object_no, off, bl, snapc, 0, trace, req_comp);
-      req->send();
+      journal_extents.push_back({journal_tid, off, len});
+    }
+    m_ictx->perfcounter->inc(l_librbd_writeback_extents);
+    send_object_write(m_ictx, oid.name, object_no, off, bl, snapc,
+                      journal_extents, trace, req_comp);
+    return ++m_tid;
+  }
+
+  bool LibrbdWriteback::can_scattered_write() {
+    return m_ictx->cache_writeback_coalesce;
+  }
+
+  ceph_tid_t LibrbdWriteback::write(const object_t& oid,
+				    const object_locator_t& oloc,
+				    vector<pair<uint64_t, bufferlist> >& io_vec,
+				    const vector<ceph_tid_t>& journal_tids,
+				    const SnapContext& snapc,
+				    ceph::real_time mtime, uint64_t trunc_size,
+				    __u32 trunc_seq, Context *oncommit)
+  {
+    assert(!io_vec.empty() && io_vec.size() == journal_tids.size());
+    uint64_t object_no = oid_to_object_no(oid.name, m_ictx->object_prefix);
+
+    write_result_d *result = new write_result_d(oid.name, oncommit);
+    m_writes[oid.name].push(result);
+    ldout(m_ictx->cct, 20) << "write will wait for result " << result << dendl;
+    C_OrderedWrite *req_comp = new C_OrderedWrite(m_ictx->cct, result, {},
+                                                  this);
+    m_ictx->perfcounter->inc(l_librbd_writeback_extents, io_vec.size());
+
+    // dirty extents that touch (e.g. separate journal events, or a write
+    // that landed next to one already in flight) go out as one object write
+    C_Gather *gather_ctx = new C_Gather(m_ictx->cct, req_comp);
+    for (size_t i = 0; i < io_vec.size();) {
+      uint64_t off = io_vec[i].first;
+      bufferlist bl;
+      JournalExtents journal_extents;
+      do {
+        if (journal_tids[i] != 0) {
+          journal_extents.push_back({journal_tids[i], io_vec[i].first,
+                                     io_vec[i].second.length()});
+        }
+        bl.claim_append(io_vec[i].second);
+        ++i;
+      } while (i < io_vec.size() && io_vec[i].first == off + bl.length());
+
+      ldout(m_ictx->cct, 20) << "scattered write " << oid << " " << off << "~"
+                             << bl.length() << dendl;
+      send_object_write(m_ictx, oid.name, object_no, off, bl, snapc,
+                        journal_extents, {}, gather_ctx->new_sub());
     }
+    gather_ctx->activate();
     return ++m_tid;
   }
 
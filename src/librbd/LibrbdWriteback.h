@@ -40,7 +40,15 @@ namespace librbd {
                      __u32 trunc_seq, ceph_tid_t journal_tid,
                      const ZTracer::Trace &parent_trace,
                      Context *oncommit) override;
-    using WritebackHandler::write;
+
+    // Coalesces adjacent extents; trunc_size and trunc_seq are ignored
+    bool can_scattered_write() override;
+    ceph_tid_t write(const object_t& oid, const object_locator_t& oloc,
+                     vector<pair<uint64_t, bufferlist> >& io_vec,
+                     const vector<ceph_tid_t>& journal_tids,
+                     const SnapContext& snapc, ceph::real_time mtime,
+                     uint64_t trunc_size, __u32 trunc_seq,
+                     Context *oncommit) override;
 
     void overwrite_extent(const object_t& oid, uint64_t off,
                           uint64_t len, ceph_tid_t original_journal_tid,
@@ -35,6 +35,8 @@ enum {
   l_librbd_cmp_bytes,
   l_librbd_cmp_latency,
 
+  l_librbd_aio_queue_latency,  // submission to dispatch
+
   l_librbd_snap_create,
   l_librbd_snap_remove,
   l_librbd_snap_rollback,
@@ -46,6 +48,12 @@ enum {
   l_librbd_readahead,
   l_librbd_readahead_bytes,
 
+  l_librbd_writeback_ops,
+  l_librbd_writeback_extents,
+
+  l_librbd_parent_cache_hit,
+  l_librbd_parent_cache_miss,
+
   l_librbd_invalidate_cache,
 
   l_librbd_opened_time,
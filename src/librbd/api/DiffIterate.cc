@@ -32,6 +32,66 @@ enum ObjectDiffState {
   OBJECT_DIFF_STATE_HOLE    = 2
 };
 
+// object diff states are packed like a BitVector<2> object map: four
+// objects per byte, so whole words of both can be combined at once
+inline uint8_t get_object_diff_state(const std::vector<uint8_t> &states,
+                                     uint64_t object_no) {
+  return (states[object_no / 4] >> ((3 - (object_no % 4)) * 2)) & 0x03;
+}
+
+inline void set_object_diff_state(std::vector<uint8_t> *states,
+                                  uint64_t object_no, uint8_t state) {
+  uint8_t shift = (3 - (object_no % 4)) * 2;
+  uint8_t &byte = (*states)[object_no / 4];
+  byte = (byte & ~(0x03 << shift)) | (state << shift);
+}
+
+inline uint8_t get_object_state(const unsigned char *object_map,
+                                uint64_t object_no) {
+  return (object_map[object_no / 4] >> ((3 - (object_no % 4)) * 2)) & 0x03;
+}
+
+// apply one snapshot step to every object packed in a word: an object
+// that went away becomes a hole, a written or changed one is updated,
+// and anything else keeps its state from the earlier steps
+template <typename T>
+T diff_object_states(T prev, T cur, T diff) {
+  const T lo = static_cast<T>(0x5555555555555555ULL);
+  T cur_lo = cur & lo;
+  T cur_hi = (cur >> 1) & lo;
+  T prev_lo = prev & lo;
+  T prev_hi = (prev >> 1) & lo;
+
+  T cur_none = ~(cur_lo | cur_hi) & lo;                 // OBJECT_NONEXISTENT
+  T prev_none = ~(prev_lo | prev_hi) & lo;
+  T cur_exists = cur_lo & ~cur_hi;                      // OBJECT_EXISTS
+  T changed = (cur_lo ^ prev_lo) | (cur_hi ^ prev_hi);
+  T exists_to_clean = (prev_lo & ~prev_hi) & (cur_lo & cur_hi);
+
+  T hole = cur_none & ~prev_none;
+  T updated = ~cur_none & lo & (cur_exists | (changed & ~exists_to_clean));
+  T touched = hole | updated;
+  return static_cast<T>((diff & ~(touched | (touched << 1))) |
+                        (hole << 1) | updated);
+}
+
+void diff_object_state_bytes(const unsigned char *prev,
+                             const unsigned char *cur, uint8_t *diff,
+                             uint64_t bytes) {
+  uint64_t i = 0;
+  for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+    uint64_t p, c, d;
+    memcpy(&p, prev + i, sizeof(p));
+    memcpy(&c, cur + i, sizeof(c));
+    memcpy(&d, diff + i, sizeof(d));
+    d = diff_object_states<uint64_t>(p, c, d);
+    memcpy(diff + i, &d, sizeof(d));
+  }
+  for (; i < bytes; ++i) {
+    diff[i] = diff_object_states<uint8_t>(prev[i], cur[i], diff[i]);
+  }
+}
+
 struct DiffContext {
   DiffIterate<>::Callback callback;
   void *callback_arg;
@@ -287,7 +347,7 @@ int DiffIterate<I>::execute() {
 
   int r;
   bool fast_diff_enabled = false;
-  BitVector<2> object_diff_state;
+  std::vector<uint8_t> object_diff_state;
   {
     RWLock::RLocker snap_locker(m_image_ctx.snap_lock);
     if (m_whole_object && (m_image_ctx.features & RBD_FEATURE_FAST_DIFF) != 0) {
@@ -353,9 +413,9 @@ int DiffIterate<I>::execute() {
 
       if (fast_diff_enabled) {
         const uint64_t object_no = p->second.front().objectno;
-        if (object_diff_state[object_no] != OBJECT_DIFF_STATE_NONE) {
-          bool updated = (object_diff_state[object_no] ==
-                            OBJECT_DIFF_STATE_UPDATED);
+        uint8_t state = get_object_diff_state(object_diff_state, object_no);
+        if (state != OBJECT_DIFF_STATE_NONE) {
+          bool updated = (state == OBJECT_DIFF_STATE_UPDATED);
           for (std::vector<ObjectExtent>::iterator q = p->second.begin();
                q != p->second.end(); ++q) {
             r = m_callback(off + q->offset, q->length, updated, m_callback_arg);
@@ -391,7 +451,7 @@ int DiffIterate<I>::execute() {
 
 template <typename I>
 int DiffIterate<I>::diff_object_map(uint64_t from_snap_id, uint64_t to_snap_id,
-                                    BitVector<2>* object_diff_state) {
+                                    std::vector<uint8_t>* object_diff_state) {
   assert(m_image_ctx.snap_lock.is_locked());
   CephContext* cct = m_image_ctx.cct;
 
@@ -405,9 +465,11 @@ int DiffIterate<I>::diff_object_map(uint64_t from_snap_id, uint64_t to_snap_id,
   }
 
   object_diff_state->clear();
+  uint64_t object_diff_state_size = 0;
   uint64_t current_snap_id = from_snap_id;
   uint64_t next_snap_id = to_snap_id;
-  BitVector<2> prev_object_map;
+  bufferlist prev_object_map;
+  uint64_t prev_object_map_size = 0;
   bool prev_object_map_valid = false;
   while (true) {
     uint64_t current_size = m_image_ctx.size;
@@ -457,34 +519,51 @@ int DiffIterate<I>::diff_object_map(uint64_t from_snap_id, uint64_t to_snap_id,
     }
     object_map.resize(num_objs);
 
-    uint64_t overlap = MIN(object_map.size(), prev_object_map.size());
-    for (uint64_t i = 0; i < overlap; ++i) {
-      ldout(cct, 20) << __func__ << ": object state: " << i << " "
-                     << static_cast<uint32_t>(prev_object_map[i])
-                     << "->" << static_cast<uint32_t>(object_map[i]) << dendl;
-      if (object_map[i] == OBJECT_NONEXISTENT) {
-        if (prev_object_map[i] != OBJECT_NONEXISTENT) {
-          (*object_diff_state)[i] = OBJECT_DIFF_STATE_HOLE;
+    bufferlist object_map_data(object_map.get_data());
+    const unsigned char *cur =
+      reinterpret_cast<const unsigned char *>(object_map_data.c_str());
+    const unsigned char *prev =
+      reinterpret_cast<const unsigned char *>(prev_object_map.c_str());
+
+    // whole bytes of the overlap a word at a time, then the odd objects
+    uint64_t overlap = MIN(num_objs, prev_object_map_size);
+    diff_object_state_bytes(prev, cur, object_diff_state->data(),
+                            overlap / 4);
+    for (uint64_t i = overlap - (overlap % 4); i < overlap; ++i) {
+      uint8_t prev_state = get_object_state(prev, i);
+      uint8_t state = get_object_state(cur, i);
+      if (state == OBJECT_NONEXISTENT) {
+        if (prev_state != OBJECT_NONEXISTENT) {
+          set_object_diff_state(object_diff_state, i, OBJECT_DIFF_STATE_HOLE);
         }
-      } else if (object_map[i] == OBJECT_EXISTS ||
-                 (prev_object_map[i] != object_map[i] &&
-                  !(prev_object_map[i] == OBJECT_EXISTS &&
-                    object_map[i] == OBJECT_EXISTS_CLEAN))) {
-        (*object_diff_state)[i] = OBJECT_DIFF_STATE_UPDATED;
+      } else if (state == OBJECT_EXISTS ||
+                 (prev_state != state &&
+                  !(prev_state == OBJECT_EXISTS &&
+                    state == OBJECT_EXISTS_CLEAN))) {
+        set_object_diff_state(object_diff_state, i,
+                              OBJECT_DIFF_STATE_UPDATED);
       }
     }
     ldout(cct, 20) << "diff_object_map: computed overlap diffs" << dendl;
 
-    object_diff_state->resize(object_map.size());
-    if (object_map.size() > prev_object_map.size() &&
+    if (num_objs < object_diff_state_size) {
+      // drop the states of truncated objects sharing the last byte
+      for (uint64_t i = num_objs; i < (num_objs + 3) / 4 * 4; ++i) {
+        set_object_diff_state(object_diff_state, i, OBJECT_DIFF_STATE_NONE);
+      }
+    }
+    object_diff_state->resize((num_objs + 3) / 4, 0);
+    object_diff_state_size = num_objs;
+    if (num_objs > prev_object_map_size &&
         (diff_from_start || prev_object_map_valid)) {
-      for (uint64_t i = overlap; i < object_diff_state->size(); ++i) {
+      for (uint64_t i = overlap; i < num_objs; ++i) {
         ldout(cct, 20) << __func__ << ": object state: " << i << " "
                        << "->" << static_cast<uint32_t>(object_map[i]) << dendl;
-        if (object_map[i] == OBJECT_NONEXISTENT) {
-          (*object_diff_state)[i] = OBJECT_DIFF_STATE_NONE;
+        if (get_object_state(cur, i) == OBJECT_NONEXISTENT) {
+          set_object_diff_state(object_diff_state, i, OBJECT_DIFF_STATE_NONE);
         } else {
-          (*object_diff_state)[i] = OBJECT_DIFF_STATE_UPDATED;
+          set_object_diff_state(object_diff_state, i,
+                                OBJECT_DIFF_STATE_UPDATED);
         }
       }
     }
@@ -494,7 +573,8 @@ int DiffIterate<I>::diff_object_map(uint64_t from_snap_id, uint64_t to_snap_id,
       break;
     }
     current_snap_id = next_snap_id;
-    prev_object_map = object_map;
+    prev_object_map.claim(object_map_data);
+    prev_object_map_size = num_objs;
     prev_object_map_valid = true;
   }
   return 0;
@@ -54,7 +54,7 @@ private:
   int execute();
 
   int diff_object_map(uint64_t from_snap_id, uint64_t to_snap_id,
-                      BitVector<2>* object_diff_state);
+                      std::vector<uint8_t>* object_diff_state);
 
 };
 
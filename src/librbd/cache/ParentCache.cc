@@ -0,0 +1,147 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "librbd/cache/ParentCache.h"
+#include "include/buffer.h"
+#include "include/compat.h"
+#include "common/ceph_context.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define dout_subsys ceph_subsys_rbd
+#undef dout_prefix
+#define dout_prefix *_dout << "librbd::cache::ParentCache: " << this << " " \
+                           <<  __func__ << ": "
+
+namespace librbd {
+namespace cache {
+
+ParentCache *ParentCache::get_instance(CephContext *cct) {
+  ParentCache *parent_cache;
+  cct->lookup_or_create_singleton_object<ParentCache>(
+    parent_cache, "librbd::cache::parent_cache");
+  return parent_cache;
+}
+
+ParentCache::ParentCache(CephContext *cct)
+  : m_cct(cct),
+    m_path(cct->_conf->get_val<std::string>("rbd_parent_cache_path")),
+    m_max_bytes(cct->_conf->get_val<uint64_t>("rbd_parent_cache_size")),
+    m_lock("librbd::cache::ParentCache::m_lock") {
+  scan();
+}
+
+std::string ParentCache::make_key(int64_t pool_id,
+                                  const std::string &image_id,
+                                  librados::snap_t snap_id,
+                                  uint64_t image_offset, uint64_t length) {
+  std::ostringstream oss;
+  oss << pool_id << "." << image_id << "." << std::hex << snap_id << "."
+      << image_offset << "." << length;
+  return oss.str();
+}
+
+bool ParentCache::lookup(const std::string &key, uint64_t length,
+                         bufferlist *bl) {
+  std::string path = m_path + "/" + key;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  bool hit = false;
+  if (::fstat(fd, &st) == 0 && (uint64_t)st.st_size == length) {
+    bufferlist data;
+    ssize_t r = data.read_fd(fd, length);
+    if (r == (ssize_t)length) {
+      bl->claim(data);
+      hit = true;
+    } else {
+      ldout(m_cct, 5) << "short read of " << path << ": r=" << r << dendl;
+    }
+  }
+  VOID_TEMP_FAILURE_RETRY(::close(fd));
+  return hit;
+}
+
+void ParentCache::insert(const std::string &key, const bufferlist &bl) {
+  std::string tmp_path;
+  {
+    Mutex::Locker locker(m_lock);
+    if (m_bytes + bl.length() > m_max_bytes) {
+      if (!m_full_logged) {
+        ldout(m_cct, 1) << m_path << " is full (" << m_bytes << " bytes)"
+                        << dendl;
+        m_full_logged = true;
+      }
+      return;
+    }
+    if (!m_inserting.insert(key).second) {
+      return;
+    }
+    m_bytes += bl.length();
+
+    std::ostringstream oss;
+    oss << m_path << "/." << key << ".tmp." << getpid() << "." << ++m_tmp_seq;
+    tmp_path = oss.str();
+  }
+
+  std::string path = m_path + "/" + key;
+  int r = 0;
+  if (::access(path.c_str(), F_OK) == 0) {
+    // another process beat us to it
+    r = -EEXIST;
+  } else {
+    bufferlist data(bl);
+    r = data.write_file(tmp_path.c_str(), 0644);
+    if (r == 0 && ::rename(tmp_path.c_str(), path.c_str()) < 0) {
+      r = -errno;
+      ::unlink(tmp_path.c_str());
+    }
+  }
+  if (r < 0 && r != -EEXIST) {
+    lderr(m_cct) << "failed to populate " << path << ": " << cpp_strerror(r)
+                 << dendl;
+  }
+
+  Mutex::Locker locker(m_lock);
+  m_inserting.erase(key);
+  if (r < 0) {
+    m_bytes -= bl.length();
+  }
+}
+
+void ParentCache::scan() {
+  DIR *dir = ::opendir(m_path.c_str());
+  if (dir == nullptr) {
+    int r = -errno;
+    lderr(m_cct) << "failed to open " << m_path << ": " << cpp_strerror(r)
+                 << dendl;
+    // admit nothing: lookups just miss and inserts would fail anyway
+    m_bytes = m_max_bytes;
+    return;
+  }
+
+  struct dirent *de;
+  while ((de = ::readdir(dir)) != nullptr) {
+    struct stat st;
+    if (de->d_name[0] == '.' ||
+        ::fstatat(dirfd(dir), de->d_name, &st, 0) < 0 ||
+        !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    m_bytes += st.st_size;
+  }
+  ::closedir(dir);
+
+  ldout(m_cct, 5) << m_path << " holds " << m_bytes << " bytes" << dendl;
+}
+
+} // namespace cache
+} // namespace librbd
@@ -0,0 +1,62 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_LIBRBD_CACHE_PARENT_CACHE
+#define CEPH_LIBRBD_CACHE_PARENT_CACHE
+
+#include "include/buffer_fwd.h"
+#include "include/int_types.h"
+#include "include/rados/librados.hpp"
+#include "common/Mutex.h"
+#include <set>
+#include <string>
+
+class CephContext;
+
+namespace librbd {
+namespace cache {
+
+/**
+ * Host-wide read cache of parent image data, shared by every clone (and
+ * every process) on the host through files in a local directory.
+ *
+ * Entries are keyed by parent pool, image id, snapshot and image extent.
+ * A clone's parent is a protected snapshot, so cached data never goes
+ * stale and needs no invalidation.  Entries are published with an
+ * atomic rename; once the directory reaches rbd_parent_cache_size no
+ * more are admitted until an administrator trims it.
+ */
+class ParentCache {
+public:
+  static ParentCache *get_instance(CephContext *cct);
+
+  explicit ParentCache(CephContext *cct);
+
+  static std::string make_key(int64_t pool_id, const std::string &image_id,
+                              librados::snap_t snap_id,
+                              uint64_t image_offset, uint64_t length);
+
+  /// synchronously read an entry of exactly @length bytes
+  bool lookup(const std::string &key, uint64_t length, ceph::bufferlist *bl);
+
+  /// populate an entry; blocking, so call it from a work queue
+  void insert(const std::string &key, const ceph::bufferlist &bl);
+
+private:
+  CephContext *m_cct;
+  std::string m_path;
+  uint64_t m_max_bytes;
+
+  Mutex m_lock;
+  uint64_t m_bytes = 0;                ///< approximate, from startup scan
+  std::set<std::string> m_inserting;
+  uint64_t m_tmp_seq = 0;
+  bool m_full_logged = false;
+
+  void scan();
+};
+
+} // namespace cache
+} // namespace librbd
+
+#endif // CEPH_LIBRBD_CACHE_PARENT_CACHE
@@ -0,0 +1,748 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "WriteLogImageCache.h"
+#include "include/buffer.h"
+#include "include/byteorder.h"
+#include "include/crc32c.h"
+#include "include/stringify.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include "common/perf_counters.h"
+#include "common/WorkQueue.h"
+#include "librbd/ImageCtx.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define dout_subsys ceph_subsys_rbd
+#undef dout_prefix
+#define dout_prefix *_dout << "librbd::WriteLogImageCache: " << this << " " \
+                           <<  __func__ << ": "
+
+namespace librbd {
+namespace cache {
+
+namespace {
+
+enum {
+  l_librbd_pwl_first = 26500,
+
+  l_librbd_pwl_wr,
+  l_librbd_pwl_wr_bytes,
+  l_librbd_pwl_wr_deferred,
+  l_librbd_pwl_rd_hit,
+  l_librbd_pwl_rd_partial_hit,
+  l_librbd_pwl_rd_miss,
+  l_librbd_pwl_dirty_bytes,
+  l_librbd_pwl_writeback_bytes,
+  l_librbd_pwl_passthrough,
+
+  l_librbd_pwl_last,
+};
+
+const uint64_t LOG_ENTRY_MAGIC = 0x72626470776c3031ULL;  // "rbdpwl01"
+
+struct LogEntryHeader {
+  ceph_le64 magic;
+  ceph_le64 seq;
+  ceph_le64 image_offset;
+  ceph_le32 length;
+  ceph_le32 data_crc;
+  ceph_le32 header_crc;     ///< over everything above
+  ceph_le32 pad;
+} __attribute__ ((packed));
+
+uint32_t header_crc(const LogEntryHeader &h) {
+  return ceph_crc32c(0, (const unsigned char *)&h,
+                     offsetof(LogEntryHeader, header_crc));
+}
+
+} // anonymous namespace
+
+template <typename I>
+WriteLogImageCache<I>::WriteLogImageCache(I &image_ctx)
+  : m_image_ctx(image_ctx), m_image_writeback(image_ctx),
+    m_max_log_bytes(image_ctx.cct->_conf->template get_val<uint64_t>(
+      "rbd_persistent_cache_size")),
+    m_lock("librbd::cache::WriteLogImageCache::m_lock") {
+  m_path = image_ctx.cct->_conf->template get_val<std::string>(
+    "rbd_persistent_cache_path") + "/rbd-pwl." +
+    stringify(image_ctx.md_ctx.get_id()) + "." + image_ctx.id + ".log";
+}
+
+template <typename I>
+WriteLogImageCache<I>::~WriteLogImageCache() {
+  if (m_fd >= 0) {
+    // shut down failed: leave the log behind to be replayed
+    VOID_TEMP_FAILURE_RETRY(::close(m_fd));
+    perf_stop();
+  }
+  assert(m_perfcounter == nullptr);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_read(Extents &&image_extents, bufferlist *bl,
+                                     int fadvise_flags, Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "image_extents=" << image_extents << ", "
+                 << "on_finish=" << on_finish << dendl;
+
+  // dirty data the read overlaps, newest last, as (offset into bl, data)
+  std::vector<std::pair<uint64_t, bufferptr> > overlays;
+  uint64_t total = 0;
+  bool covered = true;
+  {
+    Mutex::Locker locker(m_lock);
+    std::vector<std::pair<uint64_t, std::pair<uint64_t, bufferptr> > > found;
+    for (auto &extent : image_extents) {
+      uint64_t start = extent.first;
+      uint64_t end = extent.first + extent.second;
+      bool extent_covered = false;
+      auto it = m_dirty_index.lower_bound(
+        start > m_max_entry_length ? start - m_max_entry_length : 0);
+      for (; it != m_dirty_index.end() && it->first < end; ++it) {
+        const Entry &e = *it->second;
+        uint64_t s = std::max(start, e.image_offset);
+        uint64_t t = std::min(end, e.image_offset + e.length);
+        if (s >= t) {
+          continue;
+        }
+        if (s == start && t == end) {
+          extent_covered = true;
+        }
+        bufferptr bp;
+        int r = read_log(e.log_offset + (s - e.image_offset), t - s, &bp);
+        if (r < 0) {
+          lderr(cct) << "failed to read log: " << cpp_strerror(r) << dendl;
+          complete(on_finish, r);
+          return;
+        }
+        found.push_back(std::make_pair(
+          e.seq, std::make_pair(total + (s - start), std::move(bp))));
+      }
+      covered = covered && extent_covered;
+      total += extent.second;
+    }
+    std::sort(found.begin(), found.end(),
+              [](const decltype(found)::value_type &a,
+                 const decltype(found)::value_type &b) {
+                return a.first < b.first;
+              });
+    for (auto &f : found) {
+      overlays.push_back(std::move(f.second));
+    }
+  }
+
+  if (overlays.empty()) {
+    m_perfcounter->inc(l_librbd_pwl_rd_miss);
+    m_image_writeback.aio_read(std::move(image_extents), bl, fadvise_flags,
+                               on_finish);
+    return;
+  }
+
+  auto apply = [bl, total, overlays](bufferlist &&image_bl) {
+    bufferptr flat = buffer::create(total);
+    uint64_t len = std::min<uint64_t>(image_bl.length(), total);
+    if (len > 0) {
+      image_bl.copy(0, len, flat.c_str());
+    }
+    if (len < total) {
+      memset(flat.c_str() + len, 0, total - len);
+    }
+    for (auto &o : overlays) {
+      memcpy(flat.c_str() + o.first, o.second.c_str(), o.second.length());
+    }
+    bl->clear();
+    bl->append(std::move(flat));
+  };
+
+  if (covered) {
+    // the log has all of it
+    m_perfcounter->inc(l_librbd_pwl_rd_hit);
+    apply(bufferlist());
+    complete(on_finish, total);
+    return;
+  }
+
+  m_perfcounter->inc(l_librbd_pwl_rd_partial_hit);
+  bufferlist *image_bl = new bufferlist();
+  Context *ctx = new FunctionContext(
+    [image_bl, apply, on_finish](int r) {
+      if (r >= 0) {
+        apply(std::move(*image_bl));
+      }
+      delete image_bl;
+      on_finish->complete(r);
+    });
+  m_image_writeback.aio_read(std::move(image_extents), image_bl, fadvise_flags,
+                             ctx);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_write(Extents &&image_extents,
+                                      bufferlist&& bl,
+                                      int fadvise_flags,
+                                      Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "image_extents=" << image_extents << ", "
+                 << "on_finish=" << on_finish << dendl;
+
+  uint64_t bytes = bl.length();
+  if (log_bytes(bl, image_extents) > m_max_log_bytes) {
+    // would not fit even in an empty log
+    Extents extents(std::move(image_extents));
+    bufferlist data(std::move(bl));
+    passthrough([this, extents, data, fadvise_flags](Context *ctx) {
+        Extents e(extents);
+        bufferlist d(data);
+        m_image_writeback.aio_write(std::move(e), std::move(d),
+                                    fadvise_flags, ctx);
+      }, on_finish);
+    return;
+  }
+
+  {
+    Mutex::Locker locker(m_lock);
+    if (m_barriers > 0 || !m_deferred_writes.empty() ||
+        !fits(bl, image_extents)) {
+      // wait for a passthrough op, or for the log to drain
+      ldout(cct, 20) << "deferring write" << dendl;
+      m_perfcounter->inc(l_librbd_pwl_wr_deferred);
+      m_deferred_writes.push_back({std::move(image_extents), std::move(bl),
+                                   on_finish});
+      writeback();
+      return;
+    }
+
+    int r = append(image_extents, bl);
+    if (r < 0) {
+      lderr(cct) << "failed to append to log: " << cpp_strerror(r) << dendl;
+      complete(on_finish, r);
+      return;
+    }
+    writeback();
+  }
+
+  m_perfcounter->inc(l_librbd_pwl_wr);
+  m_perfcounter->inc(l_librbd_pwl_wr_bytes, bytes);
+  complete(on_finish, 0);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_discard(uint64_t offset, uint64_t length,
+                                        bool skip_partial_discard,
+                                        Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "offset=" << offset << ", "
+                 << "length=" << length << ", "
+                 << "on_finish=" << on_finish << dendl;
+
+  passthrough([this, offset, length, skip_partial_discard](Context *ctx) {
+      m_image_writeback.aio_discard(offset, length, skip_partial_discard, ctx);
+    }, on_finish);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_flush(Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "on_finish=" << on_finish << dendl;
+
+  // every acknowledged write is in the log already
+  if (::fdatasync(m_fd) < 0) {
+    int r = -errno;
+    lderr(cct) << "failed to sync log: " << cpp_strerror(r) << dendl;
+    complete(on_finish, r);
+    return;
+  }
+
+  // and passthrough ops went to the image
+  m_image_writeback.aio_flush(on_finish);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_writesame(uint64_t offset, uint64_t length,
+                                          bufferlist&& bl, int fadvise_flags,
+                                          Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "offset=" << offset << ", "
+                 << "length=" << length << ", "
+                 << "data_len=" << bl.length() << ", "
+                 << "on_finish=" << on_finish << dendl;
+
+  bufferlist data(std::move(bl));
+  passthrough([this, offset, length, data, fadvise_flags](Context *ctx) {
+      bufferlist d(data);
+      m_image_writeback.aio_writesame(offset, length, std::move(d),
+                                      fadvise_flags, ctx);
+    }, on_finish);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::aio_compare_and_write(Extents &&image_extents,
+                                                  bufferlist&& cmp_bl,
+                                                  bufferlist&& bl,
+                                                  uint64_t *mismatch_offset,
+                                                  int fadvise_flags,
+                                                  Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "image_extents=" << image_extents << ", "
+                 << "on_finish=" << on_finish << dendl;
+
+  Extents extents(std::move(image_extents));
+  bufferlist cmp_data(std::move(cmp_bl));
+  bufferlist data(std::move(bl));
+  passthrough([this, extents, cmp_data, data, mismatch_offset,
+               fadvise_flags](Context *ctx) {
+      Extents e(extents);
+      bufferlist c(cmp_data);
+      bufferlist d(data);
+      m_image_writeback.aio_compare_and_write(
+        std::move(e), std::move(c), std::move(d), mismatch_offset,
+        fadvise_flags, ctx);
+    }, on_finish);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::init(Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 5) << "path=" << m_path << dendl;
+
+  int r = open_log();
+  if (r < 0) {
+    lderr(cct) << "failed to open " << m_path << ": " << cpp_strerror(r)
+               << dendl;
+    on_finish->complete(r);
+    return;
+  }
+
+  perf_start();
+  Mutex::Locker locker(m_lock);
+  m_perfcounter->set(l_librbd_pwl_dirty_bytes, m_dirty_bytes);
+  if (!m_dirty.empty()) {
+    ldout(cct, 1) << "replaying " << m_dirty.size() << " log entries ("
+                  << m_dirty_bytes << " bytes)" << dendl;
+    writeback();
+  }
+
+  // writes can go ahead while the replay drains; reads see the log
+  complete(on_finish, 0);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::shut_down(Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 5) << dendl;
+
+  drain(new FunctionContext([this, on_finish](int r) {
+      CephContext *cct = m_image_ctx.cct;
+      if (r < 0) {
+        lderr(cct) << "failed to write back log: " << cpp_strerror(r)
+                   << dendl;
+        on_finish->complete(r);
+        return;
+      }
+      ::unlink(m_path.c_str());
+      VOID_TEMP_FAILURE_RETRY(::close(m_fd));
+      m_fd = -1;
+      perf_stop();
+      on_finish->complete(r);
+    }));
+}
+
+template <typename I>
+void WriteLogImageCache<I>::invalidate(Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << dendl;
+
+  // dirty data is the only copy, so it is written back, not dropped
+  drain(on_finish);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::flush(Context *on_finish) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << dendl;
+
+  drain(new FunctionContext([this, on_finish](int r) {
+      if (r < 0) {
+        on_finish->complete(r);
+        return;
+      }
+      RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
+      m_image_writeback.aio_flush(on_finish);
+    }));
+}
+
+template <typename I>
+int WriteLogImageCache<I>::open_log() {
+  m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (m_fd < 0) {
+    return -errno;
+  }
+
+  int r = replay_log();
+  if (r < 0) {
+    VOID_TEMP_FAILURE_RETRY(::close(m_fd));
+    m_fd = -1;
+  }
+  return r;
+}
+
+template <typename I>
+int WriteLogImageCache<I>::replay_log() {
+  CephContext *cct = m_image_ctx.cct;
+
+  struct stat st;
+  if (::fstat(m_fd, &st) < 0) {
+    return -errno;
+  }
+
+  // entries are only valid up to the first torn or corrupt one
+  uint64_t pos = 0;
+  uint64_t size = st.st_size;
+  while (pos + sizeof(LogEntryHeader) <= size) {
+    LogEntryHeader h;
+    ssize_t n = ::pread(m_fd, &h, sizeof(h), pos);
+    if (n != (ssize_t)sizeof(h)) {
+      break;
+    }
+    if (h.magic != LOG_ENTRY_MAGIC || h.header_crc != header_crc(h) ||
+        pos + sizeof(h) + h.length > size) {
+      break;
+    }
+    bufferptr bp;
+    int r = read_log(pos + sizeof(h), h.length, &bp);
+    if (r < 0) {
+      return r;
+    }
+    if (ceph_crc32c(0, (const unsigned char *)bp.c_str(), bp.length()) !=
+          h.data_crc) {
+      break;
+    }
+    m_seq = h.seq;
+    add_entry(h.seq, h.image_offset, h.length, pos + sizeof(h));
+    pos += sizeof(h) + h.length;
+  }
+
+  if (pos < size) {
+    ldout(cct, 1) << "dropping " << (size - pos) << " bytes of torn log tail"
+                  << dendl;
+    if (::ftruncate(m_fd, pos) < 0) {
+      return -errno;
+    }
+  }
+  m_log_tail = pos;
+  return 0;
+}
+
+template <typename I>
+int WriteLogImageCache<I>::read_log(uint64_t log_offset, uint64_t length,
+                                    bufferptr *bp) {
+  *bp = buffer::create(length);
+  uint64_t done = 0;
+  while (done < length) {
+    ssize_t n = ::pread(m_fd, bp->c_str() + done, length - done,
+                        log_offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -errno;
+    }
+    if (n == 0) {
+      return -EIO;
+    }
+    done += n;
+  }
+  return 0;
+}
+
+template <typename I>
+uint64_t WriteLogImageCache<I>::log_bytes(const bufferlist &bl,
+                                         const Extents &image_extents) const {
+  for (auto &extent : image_extents) {
+    if (extent.second > UINT32_MAX) {
+      return UINT64_MAX;
+    }
+  }
+  return bl.length() + image_extents.size() * sizeof(LogEntryHeader);
+}
+
+template <typename I>
+bool WriteLogImageCache<I>::fits(const bufferlist &bl,
+                                 const Extents &image_extents) const {
+  uint64_t bytes = log_bytes(bl, image_extents);
+  return bytes <= m_max_log_bytes && m_log_tail + bytes <= m_max_log_bytes;
+}
+
+template <typename I>
+int WriteLogImageCache<I>::append(const Extents &image_extents,
+                                  const bufferlist &bl) {
+  assert(m_lock.is_locked());
+
+  // one entry per extent, all in a single write
+  bufferlist records;
+  std::vector<std::pair<LogEntryHeader, uint64_t> > entries;
+  uint64_t pos = m_log_tail;
+  uint64_t off = 0;
+  uint64_t seq = m_seq;
+  for (auto &extent : image_extents) {
+    bufferlist data;
+    data.substr_of(bl, off, extent.second);
+    off += extent.second;
+
+    LogEntryHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = LOG_ENTRY_MAGIC;
+    h.seq = ++seq;
+    h.image_offset = extent.first;
+    h.length = extent.second;
+    h.data_crc = data.crc32c(0);
+    h.header_crc = header_crc(h);
+    records.append((const char *)&h, sizeof(h));
+    records.claim_append(data);
+    entries.push_back(std::make_pair(h, pos + sizeof(h)));
+    pos += sizeof(h) + extent.second;
+  }
+
+  int r = records.write_fd(m_fd, m_log_tail);
+  if (r < 0) {
+    return r;
+  }
+
+  m_seq = seq;
+  m_log_tail = pos;
+  for (auto &e : entries) {
+    add_entry(e.first.seq, e.first.image_offset, e.first.length, e.second);
+  }
+  if (m_perfcounter) {
+    m_perfcounter->set(l_librbd_pwl_dirty_bytes, m_dirty_bytes);
+  }
+  return 0;
+}
+
+template <typename I>
+void WriteLogImageCache<I>::add_entry(uint64_t seq, uint64_t image_offset,
+                                      uint64_t length, uint64_t log_offset) {
+  m_dirty.push_back({seq, image_offset, length, log_offset,
+                     m_dirty_index.end()});
+  Entry &e = m_dirty.back();
+  e.index_it = m_dirty_index.insert(std::make_pair(image_offset, &e));
+  m_max_entry_length = std::max(m_max_entry_length, length);
+  m_dirty_bytes += length;
+}
+
+template <typename I>
+void WriteLogImageCache<I>::reset_log() {
+  assert(m_lock.is_locked());
+  assert(m_dirty.empty());
+
+  // everything has reached the image; make sure a crash doesn't get to
+  // replay it over whatever comes next
+  if (::ftruncate(m_fd, 0) < 0 || ::fdatasync(m_fd) < 0) {
+    int r = -errno;
+    lderr(m_image_ctx.cct) << "failed to reset log: " << cpp_strerror(r)
+                           << dendl;
+    return;
+  }
+  m_log_tail = 0;
+  m_max_entry_length = 0;
+}
+
+template <typename I>
+void WriteLogImageCache<I>::writeback() {
+  assert(m_lock.is_locked());
+  if (m_writeback_in_flight || m_writeback_error < 0 || m_dirty.empty()) {
+    return;
+  }
+
+  // strictly in log order, so overlapping writes land as issued
+  const Entry &e = m_dirty.front();
+  bufferptr bp;
+  int r = read_log(e.log_offset, e.length, &bp);
+  if (r < 0) {
+    lderr(m_image_ctx.cct) << "failed to read log: " << cpp_strerror(r)
+                           << dendl;
+    m_writeback_error = r;
+    return;
+  }
+  m_writeback_in_flight = true;
+
+  uint64_t image_offset = e.image_offset;
+  bufferlist bl;
+  bl.append(std::move(bp));
+  m_image_ctx.op_work_queue->queue(new FunctionContext(
+    [this, image_offset, bl](int) {
+      bufferlist data(bl);
+      m_perfcounter->inc(l_librbd_pwl_writeback_bytes, data.length());
+      RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
+      m_image_writeback.aio_write(
+        {{image_offset, data.length()}}, std::move(data), 0,
+        new FunctionContext([this](int r) {
+            handle_writeback(r);
+          }));
+    }), 0);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::handle_writeback(int r) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "r=" << r << dendl;
+
+  std::list<Context*> waiters;
+  std::list<std::pair<Context*, int> > completions;
+  {
+    Mutex::Locker locker(m_lock);
+    m_writeback_in_flight = false;
+    if (r < 0) {
+      lderr(cct) << "failed to write back log entry: " << cpp_strerror(r)
+                 << dendl;
+      m_writeback_error = r;
+      waiters.swap(m_drain_waiters);
+    } else {
+      Entry &e = m_dirty.front();
+      m_dirty_index.erase(e.index_it);
+      m_dirty_bytes -= e.length;
+      m_dirty.pop_front();
+      m_perfcounter->set(l_librbd_pwl_dirty_bytes, m_dirty_bytes);
+
+      if (m_dirty.empty()) {
+        reset_log();
+        waiters.swap(m_drain_waiters);
+        process_deferred_writes(&completions);
+      }
+      writeback();
+    }
+  }
+
+  for (auto ctx : waiters) {
+    ctx->complete(r < 0 ? r : 0);
+  }
+  for (auto &c : completions) {
+    c.first->complete(c.second);
+  }
+}
+
+template <typename I>
+void WriteLogImageCache<I>::drain(Context *on_drained) {
+  Mutex::Locker locker(m_lock);
+  if (m_dirty.empty()) {
+    complete(on_drained, 0);
+    return;
+  }
+
+  // retry after an earlier writeback error
+  m_writeback_error = 0;
+  m_drain_waiters.push_back(on_drained);
+  writeback();
+}
+
+template <typename I>
+void WriteLogImageCache<I>::process_deferred_writes(
+    std::list<std::pair<Context*, int> > *completions) {
+  assert(m_lock.is_locked());
+  while (m_barriers == 0 && !m_deferred_writes.empty()) {
+    DeferredWrite &w = m_deferred_writes.front();
+    if (!fits(w.bl, w.image_extents)) {
+      break;
+    }
+    int r = append(w.image_extents, w.bl);
+    if (r < 0) {
+      lderr(m_image_ctx.cct) << "failed to append to log: "
+                             << cpp_strerror(r) << dendl;
+    } else {
+      m_perfcounter->inc(l_librbd_pwl_wr);
+      m_perfcounter->inc(l_librbd_pwl_wr_bytes, w.bl.length());
+    }
+    completions->push_back(std::make_pair(w.on_finish, r));
+    m_deferred_writes.pop_front();
+  }
+  writeback();
+}
+
+template <typename I>
+template <typename F>
+void WriteLogImageCache<I>::passthrough(F &&op, Context *on_finish) {
+  {
+    Mutex::Locker locker(m_lock);
+    ++m_barriers;
+  }
+  m_perfcounter->inc(l_librbd_pwl_passthrough);
+
+  // later writes are held back until op has reached the image
+  F f(std::move(op));
+  drain(new FunctionContext([this, f, on_finish](int r) {
+      if (r < 0) {
+        finish_passthrough();
+        on_finish->complete(r);
+        return;
+      }
+      RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
+      f(new FunctionContext([this, on_finish](int r) {
+          finish_passthrough();
+          on_finish->complete(r);
+        }));
+    }));
+}
+
+template <typename I>
+void WriteLogImageCache<I>::finish_passthrough() {
+  std::list<std::pair<Context*, int> > completions;
+  {
+    Mutex::Locker locker(m_lock);
+    assert(m_barriers > 0);
+    --m_barriers;
+    process_deferred_writes(&completions);
+  }
+  for (auto &c : completions) {
+    c.first->complete(c.second);
+  }
+}
+
+template <typename I>
+void WriteLogImageCache<I>::complete(Context *on_finish, int r) {
+  m_image_ctx.op_work_queue->queue(on_finish, r);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::perf_start() {
+  PerfCountersBuilder plb(m_image_ctx.cct,
+                          "librbd-pwl-" + m_image_ctx.id + "-" +
+                            m_image_ctx.md_ctx.get_pool_name() + "-" +
+                            m_image_ctx.name,
+                          l_librbd_pwl_first, l_librbd_pwl_last);
+  plb.add_u64_counter(l_librbd_pwl_wr, "wr", "Writes appended to the log");
+  plb.add_u64_counter(l_librbd_pwl_wr_bytes, "wr_bytes",
+                      "Bytes appended to the log");
+  plb.add_u64_counter(l_librbd_pwl_wr_deferred, "wr_deferred",
+                      "Writes that waited for log space or a passthrough op");
+  plb.add_u64_counter(l_librbd_pwl_rd_hit, "rd_hit",
+                      "Reads served entirely from the log");
+  plb.add_u64_counter(l_librbd_pwl_rd_partial_hit, "rd_partial_hit",
+                      "Reads from the image patched with log data");
+  plb.add_u64_counter(l_librbd_pwl_rd_miss, "rd_miss",
+                      "Reads that overlapped no dirty data");
+  plb.add_u64(l_librbd_pwl_dirty_bytes, "dirty_bytes",
+              "Bytes in the log not yet written back");
+  plb.add_u64_counter(l_librbd_pwl_writeback_bytes, "writeback_bytes",
+                      "Bytes written back to the image");
+  plb.add_u64_counter(l_librbd_pwl_passthrough, "passthrough",
+                      "Ops sent to the image after draining the log");
+  m_perfcounter = plb.create_perf_counters();
+  m_image_ctx.cct->get_perfcounters_collection()->add(m_perfcounter);
+}
+
+template <typename I>
+void WriteLogImageCache<I>::perf_stop() {
+  assert(m_perfcounter);
+  m_image_ctx.cct->get_perfcounters_collection()->remove(m_perfcounter);
+  delete m_perfcounter;
+  m_perfcounter = nullptr;
+}
+
+} // namespace cache
+} // namespace librbd
+
+template class librbd::cache::WriteLogImageCache<librbd::ImageCtx>;
@@ -0,0 +1,137 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_LIBRBD_CACHE_WRITE_LOG_IMAGE_CACHE
+#define CEPH_LIBRBD_CACHE_WRITE_LOG_IMAGE_CACHE
+
+#include "ImageCache.h"
+#include "ImageWriteback.h"
+#include "common/Mutex.h"
+#include "include/buffer.h"
+#include <list>
+#include <map>
+#include <string>
+
+class Context;
+class PerfCounters;
+
+namespace librbd {
+
+struct ImageCtx;
+
+namespace cache {
+
+/**
+ * Persistent write-back cache kept as an append-only log in a local
+ * file (SSD, NVMe or DAX-mounted PMEM).
+ *
+ * Writes are acknowledged once appended to the log and are durable
+ * once a flush has synced it; the log is written back to the image in
+ * order, one entry at a time, in the background.  Reads go to the
+ * image and are patched with whatever dirty log data they overlap, or
+ * skip the image entirely when the log covers them.  Discard,
+ * writesame and compare-and-write wait for the log to drain and go
+ * straight to the image, holding back later writes until they are
+ * done.
+ *
+ * The cache only lives while the exclusive lock is held: it is opened
+ * (replaying any log a crash left behind) after the lock is acquired
+ * and drained and removed before it is released.
+ */
+template <typename ImageCtxT = librbd::ImageCtx>
+class WriteLogImageCache : public ImageCache {
+public:
+  WriteLogImageCache(ImageCtxT &image_ctx);
+  ~WriteLogImageCache() override;
+
+  /// client AIO methods
+  void aio_read(Extents&& image_extents, ceph::bufferlist *bl,
+                int fadvise_flags, Context *on_finish) override;
+  void aio_write(Extents&& image_extents, ceph::bufferlist&& bl,
+                 int fadvise_flags, Context *on_finish) override;
+  void aio_discard(uint64_t offset, uint64_t length,
+                   bool skip_partial_discard, Context *on_finish) override;
+  void aio_flush(Context *on_finish) override;
+  void aio_writesame(uint64_t offset, uint64_t length,
+                     ceph::bufferlist&& bl,
+                     int fadvise_flags, Context *on_finish) override;
+  void aio_compare_and_write(Extents&& image_extents,
+                             ceph::bufferlist&& cmp_bl, ceph::bufferlist&& bl,
+                             uint64_t *mismatch_offset,int fadvise_flags,
+                             Context *on_finish) override;
+
+  /// internal state methods
+  void init(Context *on_finish) override;
+  void shut_down(Context *on_finish) override;
+
+  void invalidate(Context *on_finish) override;
+  void flush(Context *on_finish) override;
+
+private:
+  struct Entry {
+    uint64_t seq;
+    uint64_t image_offset;
+    uint64_t length;
+    uint64_t log_offset;    ///< of the data, just past the entry header
+    typename std::multimap<uint64_t, Entry*>::iterator index_it;
+  };
+
+  struct DeferredWrite {
+    Extents image_extents;
+    ceph::bufferlist bl;
+    Context *on_finish;
+  };
+
+  ImageCtxT &m_image_ctx;
+  ImageWriteback<ImageCtxT> m_image_writeback;
+  std::string m_path;
+  uint64_t m_max_log_bytes;
+  int m_fd = -1;
+  PerfCounters *m_perfcounter = nullptr;
+
+  Mutex m_lock;
+  uint64_t m_seq = 0;
+  uint64_t m_log_tail = 0;
+  uint64_t m_dirty_bytes = 0;
+  std::list<Entry> m_dirty;                        ///< in log order
+  std::multimap<uint64_t, Entry*> m_dirty_index;   ///< by image offset
+  uint64_t m_max_entry_length = 0;
+  bool m_writeback_in_flight = false;
+  int m_writeback_error = 0;
+  unsigned m_barriers = 0;       ///< passthrough ops draining or running
+  std::list<Context*> m_drain_waiters;
+  std::list<DeferredWrite> m_deferred_writes;
+
+  int open_log();
+  int replay_log();
+  int read_log(uint64_t log_offset, uint64_t length, ceph::bufferptr *bp);
+  int append(const Extents &image_extents, const ceph::bufferlist &bl);
+  void add_entry(uint64_t seq, uint64_t image_offset, uint64_t length,
+                 uint64_t log_offset);
+  void reset_log();
+  uint64_t log_bytes(const ceph::bufferlist &bl,
+                     const Extents &image_extents) const;
+  bool fits(const ceph::bufferlist &bl, const Extents &image_extents) const;
+
+  void writeback();
+  void handle_writeback(int r);
+  void drain(Context *on_drained);
+  void process_deferred_writes(
+    std::list<std::pair<Context*, int> > *completions);
+
+  template <typename F>
+  void passthrough(F &&op, Context *on_finish);
+  void finish_passthrough();
+
+  void complete(Context *on_finish, int r);
+
+  void perf_start();
+  void perf_stop();
+};
+
+} // namespace cache
+} // namespace librbd
+
+extern template class librbd::cache::WriteLogImageCache<librbd::ImageCtx>;
+
+#endif // CEPH_LIBRBD_CACHE_WRITE_LOG_IMAGE_CACHE
@@ -6,6 +6,7 @@
 #include "common/errno.h"
 #include "librbd/Utils.h"
 #include "librbd/deep_copy/Utils.h"
+#include "librbd/object_map/DiffRequest.h"
 #include "osdc/Striper.h"
 
 #define dout_subsys ceph_subsys_rbd
@@ -16,6 +17,7 @@
 namespace librbd {
 namespace deep_copy {
 
+using librbd::util::create_context_callback;
 using librbd::util::unique_lock_name;
 
 template <typename I>
@@ -44,7 +46,7 @@ void ImageCopyRequest<I>::send() {
     return;
   }
 
-  send_object_copies();
+  compute_diff();
 }
 
 template <typename I>
@@ -55,6 +57,30 @@ void ImageCopyRequest<I>::cancel() {
   m_canceled = true;
 }
 
+template <typename I>
+void ImageCopyRequest<I>::compute_diff() {
+  ldout(m_cct, 20) << dendl;
+
+  Context *ctx = create_context_callback<
+    ImageCopyRequest<I>, &ImageCopyRequest<I>::handle_compute_diff>(this);
+  auto req = object_map::DiffRequest<I>::create(
+    *m_src_image_ctx, m_snap_id_start, m_snap_id_end, &m_object_diff_state,
+    ctx);
+  req->send();
+}
+
+template <typename I>
+void ImageCopyRequest<I>::handle_compute_diff(int r) {
+  ldout(m_cct, 20) << "r=" << r << dendl;
+
+  if (r < 0) {
+    ldout(m_cct, 10) << "fast-diff optimization disabled" << dendl;
+    m_object_diff_state.resize(0);
+  }
+
+  send_object_copies();
+}
+
 template <typename I>
 void ImageCopyRequest<I>::send_object_copies() {
   m_object_no = 0;
@@ -103,6 +129,16 @@ void ImageCopyRequest<I>::send_next_object_copy() {
     m_ret_val = -ECANCELED;
   }
 
+  // objects the object maps show as untouched within the snapshot
+  // range are already in sync, anything past the diff is copied
+  while (m_ret_val == 0 && m_object_no < m_end_object_no &&
+         m_object_no < m_object_diff_state.size() &&
+         m_object_diff_state[m_object_no] == object_map::DIFF_STATE_NONE) {
+    ldout(m_cct, 20) << "skipping unchanged object_num=" << m_object_no
+                     << dendl;
+    complete_object_copy(m_object_no++);
+  }
+
   if (m_ret_val < 0 || m_object_no >= m_end_object_no) {
     return;
   }
@@ -138,13 +174,7 @@ void ImageCopyRequest<I>::handle_object_copy(uint64_t object_no, int r) {
         m_ret_val = r;
       }
     } else {
-      m_copied_objects.push(object_no);
-      while (m_copied_objects.top() ==
-             (m_object_number ? *m_object_number + 1 : 0)) {
-        m_object_number = m_copied_objects.top();
-        m_copied_objects.pop();
-        m_prog_ctx->update_progress(*m_object_number + 1, m_end_object_no);
-      }
+      complete_object_copy(object_no);
     }
 
     send_next_object_copy();
@@ -156,6 +186,20 @@ void ImageCopyRequest<I>::handle_object_copy(uint64_t object_no, int r) {
   }
 }
 
+template <typename I>
+void ImageCopyRequest<I>::complete_object_copy(uint64_t object_no) {
+  assert(m_lock.is_locked());
+
+  m_copied_objects.push(object_no);
+  while (!m_copied_objects.empty() &&
+         m_copied_objects.top() ==
+           (m_object_number ? *m_object_number + 1 : 0)) {
+    m_object_number = m_copied_objects.top();
+    m_copied_objects.pop();
+    m_prog_ctx->update_progress(*m_object_number + 1, m_end_object_no);
+  }
+}
+
 template <typename I>
 void ImageCopyRequest<I>::finish(int r) {
   ldout(m_cct, 20) << "r=" << r << dendl;
@@ -8,6 +8,7 @@
 #include "include/rados/librados.hpp"
 #include "common/Mutex.h"
 #include "common/RefCountedObj.h"
+#include "common/bit_vector.hpp"
 #include "librbd/Types.h"
 #include "librbd/deep_copy/Types.h"
 #include <functional>
@@ -53,10 +54,15 @@ private:
   /**
    * @verbatim
    *
-   * <start>   . . . . .
+   * <start>
+   *    |
+   *    v
+   * COMPUTE_DIFF
+   *    |
+   *    |      . . . . .
    *    |      .       .  (parallel execution of
-   *    v      v       .   multiple objects at once)
-   * COPY_OBJECT . . . .
+   *    v      v       .   multiple objects at once,
+   * COPY_OBJECT . . . .   unchanged ones skipped)
    *    |
    *    v
    * <finish>
@@ -83,11 +89,16 @@ private:
   std::priority_queue<
     uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> m_copied_objects;
   SnapMap m_snap_map;
+  ceph::BitVector<2> m_object_diff_state;
   int m_ret_val = 0;
 
+  void compute_diff();
+  void handle_compute_diff(int r);
+
   void send_object_copies();
   void send_next_object_copy();
   void handle_object_copy(uint64_t object_no, int r);
+  void complete_object_copy(uint64_t object_no);
 
   void finish(int r);
 };
@@ -15,6 +15,7 @@
 #include "librbd/Journal.h"
 #include "librbd/ObjectMap.h"
 #include "librbd/Utils.h"
+#include "librbd/cache/ImageCache.h"
 #include "librbd/image/RefreshRequest.h"
 #include "librbd/journal/Policy.h"
 
@@ -43,7 +44,8 @@ PostAcquireRequest<I>::PostAcquireRequest(I &image_ctx, Context *on_acquire,
   : m_image_ctx(image_ctx),
     m_on_acquire(on_acquire),
     m_on_finish(create_async_context_callback(image_ctx, on_finish)),
-    m_object_map(nullptr), m_journal(nullptr), m_error_result(0) {
+    m_object_map(nullptr), m_journal(nullptr), m_image_cache(nullptr),
+    m_error_result(0) {
 }
 
 template <typename I>
@@ -203,7 +205,7 @@ void PostAcquireRequest<I>::handle_close_journal(int r) {
 template <typename I>
 void PostAcquireRequest<I>::send_open_object_map() {
   if (!m_image_ctx.test_features(RBD_FEATURE_OBJECT_MAP)) {
-    send_open_journal();
+    send_open_image_cache();
     return;
   }
 
@@ -231,6 +233,49 @@ void PostAcquireRequest<I>::handle_open_object_map(int r) {
     m_object_map = nullptr;
   }
 
+  send_open_image_cache();
+}
+
+template <typename I>
+void PostAcquireRequest<I>::send_open_image_cache() {
+  // the write-back log would reorder writes against the journal
+  bool cache_enabled;
+  {
+    RWLock::RLocker snap_locker(m_image_ctx.snap_lock);
+    cache_enabled = (m_image_ctx.persistent_cache_enabled &&
+                     !m_image_ctx.read_only &&
+                     !m_image_ctx.test_features(RBD_FEATURE_JOURNALING,
+                                                m_image_ctx.snap_lock));
+  }
+  if (!cache_enabled) {
+    send_open_journal();
+    return;
+  }
+
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 10) << dendl;
+
+  using klass = PostAcquireRequest<I>;
+  Context *ctx = create_context_callback<
+    klass, &klass::handle_open_image_cache>(this);
+
+  m_image_cache = m_image_ctx.create_image_cache();
+  m_image_cache->init(ctx);
+}
+
+template <typename I>
+void PostAcquireRequest<I>::handle_open_image_cache(int r) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 10) << "r=" << r << dendl;
+
+  if (r < 0) {
+    // not fatal: IO goes straight to the image instead
+    lderr(cct) << "failed to open image cache: " << cpp_strerror(r) << dendl;
+
+    delete m_image_cache;
+    m_image_cache = nullptr;
+  }
+
   send_open_journal();
 }
 
@@ -271,6 +316,9 @@ void PostAcquireRequest<I>::apply() {
 
     assert(m_image_ctx.journal == nullptr);
     m_image_ctx.journal = m_journal;
+
+    assert(m_image_ctx.image_cache == nullptr);
+    m_image_ctx.image_cache = m_image_cache;
   }
 
   m_prepare_lock_completed = true;
@@ -283,6 +331,8 @@ void PostAcquireRequest<I>::revert() {
   m_image_ctx.object_map = nullptr;
   m_image_ctx.journal = nullptr;
 
+  // only opened without a journal, which is the only way to fail from here
+  assert(m_image_cache == nullptr);
   delete m_object_map;
   delete m_journal;
 
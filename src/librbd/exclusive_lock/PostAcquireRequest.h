@@ -40,6 +40,9 @@ private:
    * OPEN_OBJECT_MAP (skip if
    *      |           disabled)
    *      v
+   * OPEN_IMAGE_CACHE (skip if
+   *      |            disabled)
+   *      v
    * OPEN_JOURNAL (skip if
    *      |   *     disabled)
    *      |   *
@@ -69,6 +72,7 @@ private:
 
   decltype(m_image_ctx.object_map) m_object_map;
   decltype(m_image_ctx.journal) m_journal;
+  decltype(m_image_ctx.image_cache) m_image_cache;
 
   bool m_prepare_lock_completed = false;
   int m_error_result;
@@ -76,6 +80,9 @@ private:
   void send_refresh();
   void handle_refresh(int r);
 
+  void send_open_image_cache();
+  void handle_open_image_cache(int r);
+
   void send_open_journal();
   void handle_open_journal(int r);
 
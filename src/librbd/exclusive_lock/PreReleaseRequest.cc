@@ -11,6 +11,7 @@
 #include "librbd/Journal.h"
 #include "librbd/ObjectMap.h"
 #include "librbd/Utils.h"
+#include "librbd/cache/ImageCache.h"
 #include "librbd/io/ImageRequestWQ.h"
 
 #define dout_subsys ceph_subsys_rbd
@@ -112,7 +113,8 @@ void PreReleaseRequest<I>::send_block_writes() {
     // setting the lock as required will automatically cause the IO
     // queue to re-request the lock if any IO is queued
     if (m_image_ctx.clone_copy_on_read ||
-        m_image_ctx.test_features(RBD_FEATURE_JOURNALING)) {
+        m_image_ctx.test_features(RBD_FEATURE_JOURNALING) ||
+        m_image_ctx.image_cache != nullptr) {
       m_image_ctx.io_work_queue->set_require_lock(io::DIRECTION_BOTH, true);
     } else {
       m_image_ctx.io_work_queue->set_require_lock(io::DIRECTION_WRITE, true);
@@ -156,6 +158,51 @@ void PreReleaseRequest<I>::handle_wait_for_ops(int r) {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 10) << dendl;
 
+  send_shut_down_image_cache();
+}
+
+template <typename I>
+void PreReleaseRequest<I>::send_shut_down_image_cache() {
+  if (m_image_ctx.image_cache == nullptr) {
+    send_invalidate_cache(false);
+    return;
+  }
+
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 10) << dendl;
+
+  // the write-back log must reach the image before another client can
+  // take the lock
+  Context *ctx = create_async_context_callback(
+    m_image_ctx, create_context_callback<
+      PreReleaseRequest<I>,
+      &PreReleaseRequest<I>::handle_shut_down_image_cache>(this));
+  m_image_ctx.image_cache->shut_down(ctx);
+}
+
+template <typename I>
+void PreReleaseRequest<I>::handle_shut_down_image_cache(int r) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 10) << "r=" << r << dendl;
+
+  if (r < 0) {
+    lderr(cct) << "failed to shut down image cache: " << cpp_strerror(r)
+               << dendl;
+    if (!m_shutting_down && r != -EBLACKLISTED) {
+      m_image_ctx.io_work_queue->unblock_writes();
+      save_result(r);
+      finish();
+      return;
+    }
+    // the log stays on disk and is replayed by the next owner on this host
+  }
+
+  {
+    RWLock::WLocker snap_locker(m_image_ctx.snap_lock);
+    delete m_image_ctx.image_cache;
+    m_image_ctx.image_cache = nullptr;
+  }
+
   send_invalidate_cache(false);
 }
 
@@ -358,8 +358,13 @@ void RefreshRequest<I>::send_v2_get_flags() {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 10) << this << " " << __func__ << dendl;
 
+  // fetch the group alongside the flags in a single round trip unless
+  // the OSD has been found not to support it
   librados::ObjectReadOperation op;
   cls_client::get_flags_start(&op, m_snapc.snaps);
+  if (!m_legacy_group) {
+    cls_client::image_get_group_start(&op);
+  }
 
   using klass = RefreshRequest<I>;
   librados::AioCompletion *comp = create_rados_callback<
@@ -380,8 +385,16 @@ Context *RefreshRequest<I>::handle_v2_get_flags(int *result) {
   if (*result == 0) {
     bufferlist::iterator it = m_out_bl.begin();
     cls_client::get_flags_finish(&it, &m_flags, m_snapc.snaps, &m_snap_flags);
+    if (!m_legacy_group) {
+      *result = cls_client::image_get_group_finish(&it, &m_group_spec);
+    }
   }
-  if (*result == -EOPNOTSUPP) {
+  if (*result == -EOPNOTSUPP && !m_legacy_group) {
+    // retry with separate flags and group requests
+    m_legacy_group = true;
+    send_v2_get_flags();
+    return nullptr;
+  } else if (*result == -EOPNOTSUPP) {
     // Older OSD doesn't support RBD flags, need to assume the worst
     *result = 0;
     ldout(cct, 10) << "OSD does not support RBD flags, disabling object map "
@@ -403,7 +416,11 @@ Context *RefreshRequest<I>::handle_v2_get_flags(int *result) {
     return m_on_finish;
   }
 
-  send_v2_get_group();
+  if (m_legacy_group) {
+    send_v2_get_group();
+  } else {
+    send_v2_get_snapshots();
+  }
   return nullptr;
 }
 
@@ -465,8 +482,14 @@ void RefreshRequest<I>::send_v2_get_snapshots() {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 10) << this << " " << __func__ << dendl;
 
+  // the snapshot timestamps and namespaces are fetched in the same
+  // round trip unless the OSD has been found not to support them
   librados::ObjectReadOperation op;
   cls_client::snapshot_list_start(&op, m_snapc.snaps);
+  if (!m_legacy_snapshot) {
+    cls_client::snapshot_timestamp_list_start(&op, m_snapc.snaps);
+    cls_client::snapshot_namespace_list_start(&op, m_snapc.snaps);
+  }
 
   using klass = RefreshRequest<I>;
   librados::AioCompletion *comp = create_rados_callback<
@@ -491,8 +514,21 @@ Context *RefreshRequest<I>::handle_v2_get_snapshots(int *result) {
 					       &m_snap_sizes,
                                                &m_snap_parents,
                                                &m_snap_protection);
+    if (*result == 0 && !m_legacy_snapshot) {
+      *result = cls_client::snapshot_timestamp_list_finish(
+        &it, m_snapc.snaps, &m_snap_timestamps);
+    }
+    if (*result == 0 && !m_legacy_snapshot) {
+      *result = cls_client::snapshot_namespace_list_finish(
+        &it, m_snapc.snaps, &m_snap_namespaces);
+    }
   }
-  if (*result == -ENOENT) {
+  if (*result == -EOPNOTSUPP && !m_legacy_snapshot) {
+    // retry with separate snapshot, timestamp and namespace requests
+    m_legacy_snapshot = true;
+    send_v2_get_snapshots();
+    return nullptr;
+  } else if (*result == -ENOENT) {
     ldout(cct, 10) << "out-of-sync snapshot state detected" << dendl;
     send_v2_get_mutable_metadata();
     return nullptr;
@@ -502,7 +538,11 @@ Context *RefreshRequest<I>::handle_v2_get_snapshots(int *result) {
     return m_on_finish;
   }
 
-  send_v2_get_snap_timestamps();
+  if (m_legacy_snapshot) {
+    send_v2_get_snap_timestamps();
+  } else {
+    send_v2_refresh_parent();
+  }
   return nullptr;
 }
 
@@ -55,19 +55,19 @@ private:
    *            V2_GET_METADATA                               |
    *                |                                         |
    *                v                                         |
-   *            V2_GET_FLAGS                                  |
+   *            V2_GET_FLAGS (and group)                      |
    *                |                                         |
    *                v                                         |
-   *            V2_GET_GROUP                                  |
+   *            V2_GET_GROUP (skip unless legacy OSD)         |
    *                |                                         |
    *                v                                         |
    *            V2_GET_SNAPSHOTS (skip if no snaps)           |
-   *                |                                         |
+   *                |   (and timestamps, namespaces)          |
    *                v                                         |
-   *            V2_GET_SNAP_TIMESTAMPS                        |
+   *            V2_GET_SNAP_TIMESTAMPS (skip unless legacy)   |
    *                |                                         |
    *                v                                         |
-   *            V2_GET_SNAP_NAMESPACES                        |
+   *            V2_GET_SNAP_NAMESPACES (skip unless legacy)   |
    *                |                                         |
    *                v                                         |
    *            V2_REFRESH_PARENT (skip if no parent or       |
@@ -153,6 +153,8 @@ private:
   bool m_exclusive_locked = false;
 
   bool m_blocked_writes = false;
+  bool m_legacy_group = false;
+  bool m_legacy_snapshot = false;
   bool m_incomplete_update = false;
 
   void send_v1_read_header();
@@ -58,7 +58,12 @@ void AioCompletion::complete() {
 
   tracepoint(librbd, aio_complete_enter, this, rval);
   utime_t elapsed;
-  elapsed = ceph_clock_now() - start_time;
+  complete_time = ceph_clock_now();
+  elapsed = complete_time - start_time;
+  if (!dispatch_time.is_zero()) {
+    ictx->perfcounter->tinc(l_librbd_aio_queue_latency,
+                            dispatch_time - start_time);
+  }
   switch (aio_type) {
   case AIO_TYPE_GENERIC:
   case AIO_TYPE_OPEN:
@@ -120,6 +125,13 @@ void AioCompletion::init_time(ImageCtx *i, aio_type_t t) {
   }
 }
 
+void AioCompletion::set_dispatch_time() {
+  Mutex::Locker locker(lock);
+  if (dispatch_time.is_zero()) {
+    dispatch_time = ceph_clock_now();
+  }
+}
+
 void AioCompletion::start_op(bool ignore_type) {
   Mutex::Locker locker(lock);
   assert(ictx != nullptr);
@@ -207,5 +219,15 @@ ssize_t AioCompletion::get_return_value() {
   return r;
 }
 
+int AioCompletion::get_latency(rbd_aio_latency_t *lat) {
+  Mutex::Locker locker(lock);
+  if (state == AIO_STATE_PENDING || dispatch_time.is_zero()) {
+    return -ENODATA;
+  }
+  lat->queue_ns = (dispatch_time - start_time).to_nsec();
+  lat->service_ns = (complete_time - dispatch_time).to_nsec();
+  return 0;
+}
+
 } // namespace io
 } // namespace librbd
@@ -54,6 +54,8 @@ struct AioCompletion {
   bool released;
   ImageCtx *ictx;
   utime_t start_time;
+  utime_t dispatch_time;  ///< first sent on by an ImageRequest
+  utime_t complete_time;
   aio_type_t aio_type;
 
   ReadResult read_result;
@@ -123,6 +125,7 @@ struct AioCompletion {
   }
 
   void init_time(ImageCtx *i, aio_type_t t);
+  void set_dispatch_time();
   void start_op(bool ignore_type = false);
   void fail(int r);
 
@@ -147,6 +150,7 @@ struct AioCompletion {
   bool is_complete();
 
   ssize_t get_return_value();
+  int get_latency(rbd_aio_latency_t *lat);
 
   void get() {
     lock.Lock();
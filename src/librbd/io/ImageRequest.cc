@@ -237,6 +237,7 @@ void ImageRequest<I>::send() {
                  << "completion=" << aio_comp << dendl;
 
   aio_comp->get();
+  aio_comp->set_dispatch_time();
   int r = clip_request();
   if (r < 0) {
     m_aio_comp->fail(r);
@@ -440,14 +441,27 @@ void AbstractImageWriteRequest<I>::send_request() {
 
   if (!object_extents.empty()) {
     uint64_t journal_tid = 0;
+    // the cache defers its writeback to the journal on its own
+    bool concurrent_io = (journaling && image_ctx.journal_concurrent_io &&
+                          image_ctx.object_cacher == NULL);
     aio_comp->set_request_count(
-      object_extents.size() + get_object_cache_request_count(journaling));
+      object_extents.size() + get_object_cache_request_count(journaling) +
+      (concurrent_io ? 1 : 0));
 
     ObjectRequests requests;
     send_object_requests(object_extents, snapc,
                          (journaling ? &requests : nullptr));
 
-    if (journaling) {
+    if (concurrent_io) {
+      // write the image while the event is appended, but only complete
+      // once the event is safe so that any acknowledged write replays
+      assert(image_ctx.journal != NULL);
+      journal_tid = append_journal_event({}, m_synchronous);
+      image_ctx.journal->wait_event(journal_tid, new C_AioRequest(aio_comp));
+      for (auto request : requests) {
+        request->send();
+      }
+    } else if (journaling) {
       // in-flight ops are flushed prior to closing the journal
       assert(image_ctx.journal != NULL);
       journal_tid = append_journal_event(requests, m_synchronous);
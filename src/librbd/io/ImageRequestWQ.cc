@@ -3,6 +3,7 @@
 
 #include "librbd/io/ImageRequestWQ.h"
 #include "common/errno.h"
+#include "common/Finisher.h"
 #include "common/zipkin_trace.h"
 #include "librbd/ExclusiveLock.h"
 #include "librbd/ImageCtx.h"
@@ -21,6 +22,31 @@
 namespace librbd {
 namespace io {
 
+namespace {
+
+struct DispatchFinisherSingleton {
+  std::vector<Finisher*> finishers;
+
+  explicit DispatchFinisherSingleton(CephContext *cct) {
+    auto count = cct->_conf->get_val<uint64_t>("rbd_io_dispatch_threads");
+    for (uint64_t i = 0; i < count; ++i) {
+      Finisher *finisher = new Finisher(cct, "librbd::io::dispatch",
+                                        "io_dispatch");
+      finisher->start();
+      finishers.push_back(finisher);
+    }
+  }
+  ~DispatchFinisherSingleton() {
+    for (auto finisher : finishers) {
+      finisher->wait_for_empty();
+      finisher->stop();
+      delete finisher;
+    }
+  }
+};
+
+} // anonymous namespace
+
 template <typename I>
 struct ImageRequestWQ<I>::C_AcquireLock : public Context {
   ImageRequestWQ *work_queue;
@@ -66,9 +92,16 @@ ImageRequestWQ<I>::ImageRequestWQ(I *image_ctx, const string &name,
 				  time_t ti, ThreadPool *tp)
   : ThreadPool::PointerWQ<ImageRequest<I> >(name, ti, 0, tp),
     m_image_ctx(*image_ctx),
-    m_lock(util::unique_lock_name("ImageRequestWQ<I>::m_lock", this)) {
+    m_lock(util::unique_lock_name("ImageRequestWQ<I>::m_lock", this)),
+    m_dispatch_lock(util::unique_lock_name(
+      "ImageRequestWQ<I>::m_dispatch_lock", this)) {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 5) << "ictx=" << image_ctx << dendl;
+
+  DispatchFinisherSingleton *dispatch_finishers;
+  cct->lookup_or_create_singleton_object<DispatchFinisherSingleton>(
+    dispatch_finishers, "librbd::io::dispatch_finishers");
+  m_dispatch_finishers = dispatch_finishers->finishers;
   this->register_work_queue();
 }
 
@@ -240,9 +273,12 @@ void ImageRequestWQ<I>::aio_read(AioCompletion *c, uint64_t off, uint64_t len,
   RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
   if (m_image_ctx.non_blocking_aio || writes_blocked() || !writes_empty() ||
       require_lock_on_read()) {
-    queue(ImageRequest<I>::create_read_request(
-            m_image_ctx, c, {{off, len}}, std::move(read_result), op_flags,
-            trace));
+    auto req = ImageRequest<I>::create_read_request(
+      m_image_ctx, c, {{off, len}}, std::move(read_result), op_flags,
+      trace);
+    if (!dispatch(req, off, len)) {
+      queue(req);
+    }
   } else {
     c->start_op();
     ImageRequest<I>::aio_read(&m_image_ctx, c, {{off, len}},
@@ -278,8 +314,11 @@ void ImageRequestWQ<I>::aio_write(AioCompletion *c, uint64_t off, uint64_t len,
 
   RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
   if (m_image_ctx.non_blocking_aio || writes_blocked()) {
-    queue(ImageRequest<I>::create_write_request(
-            m_image_ctx, c, {{off, len}}, std::move(bl), op_flags, trace));
+    auto req = ImageRequest<I>::create_write_request(
+      m_image_ctx, c, {{off, len}}, std::move(bl), op_flags, trace);
+    if (!dispatch(req, off, len)) {
+      queue(req);
+    }
   } else {
     c->start_op();
     ImageRequest<I>::aio_write(&m_image_ctx, c, {{off, len}},
@@ -315,8 +354,11 @@ void ImageRequestWQ<I>::aio_discard(AioCompletion *c, uint64_t off,
 
   RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
   if (m_image_ctx.non_blocking_aio || writes_blocked()) {
-    queue(ImageRequest<I>::create_discard_request(
-            m_image_ctx, c, off, len, skip_partial_discard, trace));
+    auto req = ImageRequest<I>::create_discard_request(
+      m_image_ctx, c, off, len, skip_partial_discard, trace);
+    if (!dispatch(req, off, len)) {
+      queue(req);
+    }
   } else {
     c->start_op();
     ImageRequest<I>::aio_discard(&m_image_ctx, c, off, len,
@@ -384,8 +426,11 @@ void ImageRequestWQ<I>::aio_writesame(AioCompletion *c, uint64_t off,
 
   RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
   if (m_image_ctx.non_blocking_aio || writes_blocked()) {
-    queue(ImageRequest<I>::create_writesame_request(
-            m_image_ctx, c, off, len, std::move(bl), op_flags, trace));
+    auto req = ImageRequest<I>::create_writesame_request(
+      m_image_ctx, c, off, len, std::move(bl), op_flags, trace);
+    if (!dispatch(req, off, len)) {
+      queue(req);
+    }
   } else {
     c->start_op();
     ImageRequest<I>::aio_writesame(&m_image_ctx, c, off, len, std::move(bl),
@@ -424,9 +469,12 @@ void ImageRequestWQ<I>::aio_compare_and_write(AioCompletion *c,
 
   RWLock::RLocker owner_locker(m_image_ctx.owner_lock);
   if (m_image_ctx.non_blocking_aio || writes_blocked()) {
-    queue(ImageRequest<I>::create_compare_and_write_request(
-            m_image_ctx, c, {{off, len}}, std::move(cmp_bl), std::move(bl),
-            mismatch_off, op_flags, trace));
+    auto req = ImageRequest<I>::create_compare_and_write_request(
+      m_image_ctx, c, {{off, len}}, std::move(cmp_bl), std::move(bl),
+      mismatch_off, op_flags, trace);
+    if (!dispatch(req, off, len)) {
+      queue(req);
+    }
   } else {
     c->start_op();
     ImageRequest<I>::aio_compare_and_write(&m_image_ctx, c, {{off, len}},
@@ -732,6 +780,115 @@ void ImageRequestWQ<I>::queue(ImageRequest<I> *req) {
   ThreadPool::PointerWQ<ImageRequest<I> >::queue(req);
 }
 
+template <typename I>
+bool ImageRequestWQ<I>::dispatch(ImageRequest<I> *req, uint64_t off,
+                                 uint64_t len) {
+  assert(m_image_ctx.owner_lock.is_locked());
+  if (m_dispatch_finishers.empty() ||
+      m_image_ctx.state->is_refresh_required()) {
+    return false;
+  }
+
+  bool write_op = req->is_write_op();
+  {
+    RWLock::RLocker locker(m_lock);
+    // anything already queued or stalled must be processed first
+    if (m_queued_reads > 0 || m_queued_writes > 0 || m_io_blockers > 0 ||
+        m_write_blockers > 0 || is_lock_required(write_op)) {
+      return false;
+    }
+    if (write_op) {
+      // block_writes() waits for this to be sent
+      m_in_flight_writes++;
+    }
+  }
+
+  DispatchEntry *entry = new DispatchEntry();
+  entry->req = req;
+  entry->off = off;
+  entry->len = len;
+  entry->write_op = write_op;
+  entry->blockers = 0;
+  entry->ready = false;
+  entry->shard = (std::hash<const void*>()(this) + (off >> m_image_ctx.order)) %
+                   m_dispatch_finishers.size();
+  {
+    // only overlapping extents need to keep their submission order
+    Mutex::Locker locker(m_dispatch_lock);
+    for (auto other : m_dispatching) {
+      if (entry->conflicts(*other)) {
+        ++entry->blockers;
+      }
+    }
+    m_dispatching.push_back(entry);
+  }
+
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "ictx=" << &m_image_ctx << ", req=" << req << ", "
+                 << "shard=" << entry->shard << ", "
+                 << "blockers=" << entry->blockers << dendl;
+
+  m_dispatch_finishers[entry->shard]->queue(new FunctionContext(
+    [this, entry](int r) {
+      {
+        Mutex::Locker locker(m_dispatch_lock);
+        entry->ready = true;
+        if (entry->blockers > 0) {
+          // requeued by finish_dispatched()
+          return;
+        }
+      }
+      send_dispatched(entry);
+    }));
+  return true;
+}
+
+template <typename I>
+void ImageRequestWQ<I>::send_dispatched(DispatchEntry *entry) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "ictx=" << &m_image_ctx << ", "
+                 << "req=" << entry->req << dendl;
+
+  entry->req->start_op();
+  entry->req->send();
+  finish_dispatched(entry);
+}
+
+template <typename I>
+void ImageRequestWQ<I>::finish_dispatched(DispatchEntry *entry) {
+  std::list<DispatchEntry*> unblocked;
+  {
+    Mutex::Locker locker(m_dispatch_lock);
+    auto it = std::find(m_dispatching.begin(), m_dispatching.end(), entry);
+    assert(it != m_dispatching.end());
+    for (auto later = std::next(it); later != m_dispatching.end(); ++later) {
+      DispatchEntry *other = *later;
+      if (other->conflicts(*entry)) {
+        assert(other->blockers > 0);
+        if (--other->blockers == 0 && other->ready) {
+          unblocked.push_back(other);
+        }
+      }
+    }
+    m_dispatching.erase(it);
+  }
+
+  for (auto other : unblocked) {
+    m_dispatch_finishers[other->shard]->queue(new FunctionContext(
+      [this, other](int r) {
+        send_dispatched(other);
+      }));
+  }
+
+  if (entry->write_op) {
+    finish_in_flight_write();
+  }
+  delete entry->req;
+  delete entry;
+
+  finish_in_flight_io();
+}
+
 template <typename I>
 void ImageRequestWQ<I>::handle_acquire_lock(int r, ImageRequest<I> *req) {
   CephContext *cct = m_image_ctx.cct;
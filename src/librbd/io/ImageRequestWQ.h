@@ -5,12 +5,16 @@
 #define CEPH_LIBRBD_IO_IMAGE_REQUEST_WQ_H
 
 #include "include/Context.h"
+#include "common/Mutex.h"
 #include "common/RWLock.h"
 #include "common/WorkQueue.h"
 #include "librbd/io/Types.h"
 
 #include <list>
 #include <atomic>
+#include <vector>
+
+class Finisher;
 
 namespace librbd {
 
@@ -81,6 +85,21 @@ private:
   struct C_BlockedWrites;
   struct C_RefreshFinish;
 
+  struct DispatchEntry {
+    ImageRequest<ImageCtxT> *req;
+    uint64_t off;
+    uint64_t len;
+    bool write_op;
+    unsigned shard;
+    unsigned blockers;        ///< earlier conflicting entries not yet sent
+    bool ready;               ///< reached the front of its shard
+
+    bool conflicts(const DispatchEntry &other) const {
+      return ((write_op || other.write_op) &&
+              off < other.off + other.len && other.off < off + len);
+    }
+  };
+
   ImageCtxT &m_image_ctx;
   mutable RWLock m_lock;
   Contexts m_write_blocker_contexts;
@@ -96,6 +115,11 @@ private:
   bool m_shutdown = false;
   Context *m_on_shutdown = nullptr;
 
+  // parallel dispatch while the queue is idle and the lock is held
+  std::vector<Finisher*> m_dispatch_finishers;
+  Mutex m_dispatch_lock;
+  std::list<DispatchEntry*> m_dispatching;   ///< in submission order
+
   bool is_lock_required(bool write_op) const;
 
   inline bool require_lock_on_read() const {
@@ -116,6 +140,10 @@ private:
 
   void queue(ImageRequest<ImageCtxT> *req);
 
+  bool dispatch(ImageRequest<ImageCtxT> *req, uint64_t off, uint64_t len);
+  void send_dispatched(DispatchEntry *entry);
+  void finish_dispatched(DispatchEntry *entry);
+
   void handle_acquire_lock(int r, ImageRequest<ImageCtxT> *req);
   void handle_refreshed(int r, ImageRequest<ImageCtxT> *req);
   void handle_blocked_writes(int r);
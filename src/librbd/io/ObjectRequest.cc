@@ -15,6 +15,7 @@
 #include "librbd/ImageCtx.h"
 #include "librbd/ObjectMap.h"
 #include "librbd/Utils.h"
+#include "librbd/cache/ParentCache.h"
 #include "librbd/io/AioCompletion.h"
 #include "librbd/io/CopyupRequest.h"
 #include "librbd/io/ImageRequest.h"
@@ -238,6 +239,21 @@ bool ObjectReadRequest<I>::should_complete(int r)
 
   bool finished = true;
 
+  if (!m_parent_cache_key.empty()) {
+    // parent read missed the parent cache
+    if (r >= 0 && m_read_data.length() == m_parent_cache_length) {
+      cache::ParentCache *parent_cache = cache::ParentCache::get_instance(
+        image_ctx->cct);
+      std::string key(std::move(m_parent_cache_key));
+      bufferlist bl(m_read_data);
+      image_ctx->op_work_queue->queue(new FunctionContext(
+        [parent_cache, key, bl](int r) {
+          parent_cache->insert(key, bl);
+        }), 0);
+    }
+    m_parent_cache_key.clear();
+  }
+
   switch (m_state) {
   case LIBRBD_AIO_READ_GUARD:
     ldout(image_ctx->cct, 20) << "READ_CHECK_GUARD" << dendl;
@@ -378,6 +394,26 @@ template <typename I>
 void ObjectReadRequest<I>::read_from_parent(Extents&& parent_extents)
 {
   I *image_ctx = this->m_ictx;
+  ParentSpec parent_spec;
+  if (image_ctx->parent_cache_enabled && parent_extents.size() == 1 &&
+      image_ctx->get_parent_spec(this->m_snap_id, &parent_spec) == 0) {
+    m_parent_cache_length = parent_extents[0].second;
+    m_parent_cache_key = cache::ParentCache::make_key(
+      parent_spec.pool_id, parent_spec.image_id, parent_spec.snap_id,
+      parent_extents[0].first, m_parent_cache_length);
+    if (cache::ParentCache::get_instance(image_ctx->cct)->lookup(
+          m_parent_cache_key, m_parent_cache_length, &m_read_data)) {
+      ldout(image_ctx->cct, 20) << "parent cache hit "
+                                << m_parent_cache_key << dendl;
+      image_ctx->perfcounter->inc(l_librbd_parent_cache_hit);
+      m_parent_cache_key.clear();
+      image_ctx->op_work_queue->queue(util::create_context_callback<
+        ObjectRequest<I> >(this), m_parent_cache_length);
+      return;
+    }
+    image_ctx->perfcounter->inc(l_librbd_parent_cache_miss);
+  }
+
   AioCompletion *parent_completion = AioCompletion::create_and_start<
     ObjectRequest<I> >(this, util::get_image_ctx(image_ctx), AIO_TYPE_READ);
 
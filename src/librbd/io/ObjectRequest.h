@@ -199,6 +199,8 @@ private:
   int m_op_flags;
   ceph::bufferlist m_read_data;
   ExtentMap m_ext_map;
+  std::string m_parent_cache_key;
+  uint64_t m_parent_cache_length = 0;
 
   /**
    * Reads go through the following state machine to deal with
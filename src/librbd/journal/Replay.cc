@@ -28,6 +28,27 @@ static const uint64_t IN_FLIGHT_IO_HIGH_WATER_MARK(64);
 
 static NoOpProgressContext no_op_progress_callback;
 
+bool get_modify_extent(const EventEntry &event_entry, uint64_t *offset,
+                       uint64_t *length) {
+  if (auto event = boost::get<AioWriteEvent>(&event_entry.event)) {
+    *offset = event->offset;
+    *length = event->length;
+  } else if (auto event = boost::get<AioDiscardEvent>(&event_entry.event)) {
+    *offset = event->offset;
+    *length = event->length;
+  } else if (auto event = boost::get<AioWriteSameEvent>(&event_entry.event)) {
+    *offset = event->offset;
+    *length = event->length;
+  } else if (auto event = boost::get<AioCompareAndWriteEvent>(
+               &event_entry.event)) {
+    *offset = event->offset;
+    *length = event->length;
+  } else {
+    return false;
+  }
+  return *length > 0;
+}
+
 template <typename I, typename E>
 struct ExecuteOp : public Context {
   I &image_ctx;
@@ -184,6 +205,8 @@ Replay<I>::~Replay() {
   assert(m_aio_modify_safe_contexts.empty());
   assert(m_op_events.empty());
   assert(m_in_flight_op_events == 0);
+  assert(m_in_flight_extents.empty());
+  assert(!m_blocked_event);
 }
 
 template <typename I>
@@ -204,6 +227,13 @@ void Replay<I>::process(const EventEntry &event_entry,
                  << dendl;
 
   on_ready = util::create_async_context_callback(m_image_ctx, on_ready);
+  dispatch(event_entry, on_ready, on_safe);
+}
+
+template <typename I>
+void Replay<I>::dispatch(const EventEntry &event_entry,
+                         Context *on_ready, Context *on_safe) {
+  CephContext *cct = m_image_ctx.cct;
 
   RWLock::RLocker owner_lock(m_image_ctx.owner_lock);
   if (m_image_ctx.exclusive_lock == nullptr ||
@@ -214,6 +244,27 @@ void Replay<I>::process(const EventEntry &event_entry,
     return;
   }
 
+  // IO to disjoint extents is replayed concurrently, anything else
+  // waits for the IO in flight that it could be reordered with
+  uint64_t offset;
+  uint64_t length;
+  bool modify = get_modify_extent(event_entry, &offset, &length);
+  {
+    Mutex::Locker locker(m_lock);
+    assert(!m_blocked_event);
+    if (modify ? m_in_flight_extents.intersects(offset, length) :
+                 !m_in_flight_extents.empty()) {
+      ldout(cct, 20) << ": waiting for in-flight IO: "
+                     << m_in_flight_extents << dendl;
+      m_blocked_event.reset(new BlockedEvent(event_entry, on_ready, on_safe));
+      return;
+    }
+    if (modify) {
+      m_in_flight_extents.insert(offset, length);
+      m_aio_modify_extents[on_safe] = {offset, length};
+    }
+  }
+
   boost::apply_visitor(EventVisitor(this, on_ready, on_safe),
                        event_entry.event);
 }
@@ -869,6 +920,7 @@ void Replay<I>::handle_aio_modify_complete(Context *on_ready, Context *on_safe,
   if (on_ready != nullptr) {
     on_ready->complete(0);
   }
+  release_modify_extent(on_safe);
 
   if (filters.find(r) != filters.end())
     r = 0;
@@ -1054,6 +1106,7 @@ Replay<I>::create_aio_modify_completion(Context *on_ready,
   if (m_shut_down) {
     ldout(cct, 5) << ": ignoring event after shut down" << dendl;
     on_ready->complete(0);
+    release_modify_extent(on_safe);
     m_image_ctx.op_work_queue->queue(on_safe, -ESHUTDOWN);
     return nullptr;
   }
@@ -1082,6 +1135,11 @@ Replay<I>::create_aio_modify_completion(Context *on_ready,
                    << dendl;
     assert(m_on_aio_ready == nullptr);
     std::swap(m_on_aio_ready, on_ready);
+  } else if (m_aio_modify_extents.count(on_safe) != 0) {
+    // nothing in flight overlaps this event: move on to the next one
+    // without waiting for the ack
+    on_ready->complete(0);
+    on_ready = nullptr;
   }
 
   // when the modification is ACKed by librbd, we can process the next
@@ -1093,6 +1151,37 @@ Replay<I>::create_aio_modify_completion(Context *on_ready,
   return aio_comp;
 }
 
+template <typename I>
+void Replay<I>::release_modify_extent(Context *on_safe) {
+  assert(m_lock.is_locked());
+
+  auto it = m_aio_modify_extents.find(on_safe);
+  if (it == m_aio_modify_extents.end()) {
+    return;
+  }
+  m_in_flight_extents.erase(it->second.first, it->second.second);
+  m_aio_modify_extents.erase(it);
+
+  if (!m_blocked_event) {
+    return;
+  }
+  uint64_t offset;
+  uint64_t length;
+  bool modify = get_modify_extent(m_blocked_event->event_entry, &offset,
+                                  &length);
+  if (modify ? !m_in_flight_extents.intersects(offset, length) :
+               m_in_flight_extents.empty()) {
+    CephContext *cct = m_image_ctx.cct;
+    ldout(cct, 20) << ": resuming blocked event" << dendl;
+    std::shared_ptr<BlockedEvent> blocked_event(m_blocked_event.release());
+    m_image_ctx.op_work_queue->queue(new FunctionContext(
+      [this, blocked_event](int r) {
+        dispatch(blocked_event->event_entry, blocked_event->on_ready,
+                 blocked_event->on_safe);
+      }), 0);
+  }
+}
+
 template <typename I>
 io::AioCompletion *Replay<I>::create_aio_flush_completion(Context *on_safe) {
   assert(m_lock.is_locked());
@@ -8,6 +8,7 @@
 #include "include/buffer_fwd.h"
 #include "include/Context.h"
 #include "common/Mutex.h"
+#include "include/interval_set.h"
 #include "librbd/io/Types.h"
 #include "librbd/journal/Types.h"
 #include <boost/variant.hpp>
@@ -61,6 +62,19 @@ private:
   typedef std::list<Context *> Contexts;
   typedef std::unordered_set<Context *> ContextSet;
   typedef std::unordered_map<uint64_t, OpEvent> OpEvents;
+  typedef std::unordered_map<Context *, std::pair<uint64_t, uint64_t> >
+    ModifyExtents;
+
+  /// an event held back until the IO it depends on has completed
+  struct BlockedEvent {
+    EventEntry event_entry;
+    Context *on_ready;
+    Context *on_safe;
+    BlockedEvent(const EventEntry &event_entry, Context *on_ready,
+                 Context *on_safe)
+      : event_entry(event_entry), on_ready(on_ready), on_safe(on_safe) {
+    }
+  };
 
   struct C_OpOnComplete : public Context {
     Replay *replay;
@@ -133,6 +147,16 @@ private:
   Context *m_flush_ctx = nullptr;
   Context *m_on_aio_ready = nullptr;
 
+  // image extents of the AIO modify events that were sent but not yet
+  // acked: events that don't overlap them are replayed concurrently
+  interval_set<uint64_t> m_in_flight_extents;
+  ModifyExtents m_aio_modify_extents;	///< keyed by on_safe
+  std::unique_ptr<BlockedEvent> m_blocked_event;
+
+  void dispatch(const EventEntry &event_entry, Context *on_ready,
+                Context *on_safe);
+  void release_modify_extent(Context *on_safe);
+
   void handle_event(const AioDiscardEvent &event, Context *on_ready,
                     Context *on_safe);
   void handle_event(const AioWriteEvent &event, Context *on_ready,
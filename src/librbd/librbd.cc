@@ -795,6 +795,12 @@ namespace librbd {
     return c->get_arg();
   }
 
+  int RBD::AioCompletion::get_latency(rbd_aio_latency_t *lat)
+  {
+    librbd::io::AioCompletion *c = (librbd::io::AioCompletion *)pc;
+    return c->get_latency(lat);
+  }
+
   void RBD::AioCompletion::release()
   {
     librbd::io::AioCompletion *c = (librbd::io::AioCompletion *)pc;
@@ -4178,6 +4184,12 @@ extern "C" void *rbd_aio_get_arg(rbd_completion_t c)
   return comp->get_arg();
 }
 
+extern "C" int rbd_aio_get_latency(rbd_completion_t c, rbd_aio_latency_t *lat)
+{
+  librbd::RBD::AioCompletion *comp = (librbd::RBD::AioCompletion *)c;
+  return comp->get_latency(lat);
+}
+
 extern "C" void rbd_aio_release(rbd_completion_t c)
 {
   librbd::RBD::AioCompletion *comp = (librbd::RBD::AioCompletion *)c;
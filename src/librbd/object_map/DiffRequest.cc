@@ -0,0 +1,209 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "librbd/object_map/DiffRequest.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include "cls/rbd/cls_rbd_client.h"
+#include "include/rbd/object_map_types.h"
+#include "librbd/ImageCtx.h"
+#include "librbd/ObjectMap.h"
+#include "librbd/Utils.h"
+#include "osdc/Striper.h"
+
+#define dout_subsys ceph_subsys_rbd
+#undef dout_prefix
+#define dout_prefix *_dout << "librbd::object_map::DiffRequest: " \
+                           << this << " " << __func__ << ": "
+
+namespace librbd {
+namespace object_map {
+
+using util::create_rados_callback;
+
+namespace {
+
+// same rules as the fast-diff of DiffIterate: an object that went away
+// is a hole, one that was written or changed state since the previous
+// snapshot is updated, anything else keeps what earlier snapshots said
+uint8_t diff_object_state(uint8_t prev_state, uint8_t state,
+                          uint8_t diff_state) {
+  if (state == OBJECT_NONEXISTENT) {
+    if (prev_state != OBJECT_NONEXISTENT) {
+      return DIFF_STATE_HOLE;
+    }
+  } else if (state == OBJECT_EXISTS ||
+             (prev_state != state &&
+              !(prev_state == OBJECT_EXISTS &&
+                state == OBJECT_EXISTS_CLEAN))) {
+    return DIFF_STATE_UPDATED;
+  }
+  return diff_state;
+}
+
+} // anonymous namespace
+
+template <typename I>
+void DiffRequest<I>::send() {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 10) << "snap_id_start=" << m_snap_id_start << ", "
+                 << "snap_id_end=" << m_snap_id_end << dendl;
+
+  int r = 0;
+  {
+    RWLock::RLocker snap_locker(m_image_ctx.snap_lock);
+    if (!m_image_ctx.test_features(RBD_FEATURE_FAST_DIFF,
+                                   m_image_ctx.snap_lock)) {
+      ldout(cct, 10) << "fast-diff feature not enabled" << dendl;
+      r = -EINVAL;
+    } else if (m_snap_id_start >= m_snap_id_end) {
+      lderr(cct) << "invalid snapshot range" << dendl;
+      r = -EINVAL;
+    } else if (m_snap_id_start == 0) {
+      m_diff_from_start = true;
+      if (!m_image_ctx.snap_info.empty()) {
+        m_current_snap_id = m_image_ctx.snap_info.begin()->first;
+      } else {
+        m_current_snap_id = CEPH_NOSNAP;
+      }
+    } else {
+      m_current_snap_id = m_snap_id_start;
+    }
+  }
+
+  if (r < 0) {
+    finish(r);
+    return;
+  }
+
+  m_object_diff_state->clear();
+  load_object_map();
+}
+
+template <typename I>
+void DiffRequest<I>::load_object_map() {
+  CephContext *cct = m_image_ctx.cct;
+
+  int r = 0;
+  uint64_t flags = 0;
+  {
+    RWLock::RLocker snap_locker(m_image_ctx.snap_lock);
+    if (m_current_snap_id == CEPH_NOSNAP) {
+      m_current_size = m_image_ctx.size;
+      flags = m_image_ctx.flags;
+      m_next_snap_id = CEPH_NOSNAP;
+    } else {
+      auto snap_it = m_image_ctx.snap_info.find(m_current_snap_id);
+      if (snap_it == m_image_ctx.snap_info.end()) {
+        lderr(cct) << "snapshot " << m_current_snap_id << " not found"
+                   << dendl;
+        r = -ENOENT;
+      } else {
+        m_current_size = snap_it->second.size;
+        flags = snap_it->second.flags;
+        ++snap_it;
+        m_next_snap_id = (snap_it == m_image_ctx.snap_info.end() ?
+                            CEPH_NOSNAP : snap_it->first);
+      }
+    }
+  }
+
+  if (r == 0 && (flags & RBD_FLAG_FAST_DIFF_INVALID) != 0) {
+    ldout(cct, 1) << "cannot perform fast diff on invalid object map" << dendl;
+    r = -EINVAL;
+  }
+  if (r < 0) {
+    finish(r);
+    return;
+  }
+
+  std::string oid(ObjectMap<>::object_map_name(m_image_ctx.id,
+                                               m_current_snap_id));
+  ldout(cct, 20) << "oid=" << oid << dendl;
+
+  librados::ObjectReadOperation op;
+  cls_client::object_map_load_start(&op);
+
+  m_out_bl.clear();
+  librados::AioCompletion *rados_completion = create_rados_callback<
+    DiffRequest<I>, &DiffRequest<I>::handle_load_object_map>(this);
+  r = m_image_ctx.md_ctx.aio_operate(oid, rados_completion, &op, &m_out_bl);
+  assert(r == 0);
+  rados_completion->release();
+}
+
+template <typename I>
+void DiffRequest<I>::handle_load_object_map(int r) {
+  CephContext *cct = m_image_ctx.cct;
+  ldout(cct, 20) << "r=" << r << dendl;
+
+  if (r == 0) {
+    bufferlist::iterator it = m_out_bl.begin();
+    r = cls_client::object_map_load_finish(&it, &m_object_map);
+  }
+  if (r < 0) {
+    lderr(cct) << "failed to load object map for snapshot "
+               << m_current_snap_id << ": " << cpp_strerror(r) << dendl;
+    finish(r);
+    return;
+  }
+
+  uint64_t num_objs = Striper::get_num_objects(m_image_ctx.layout,
+                                               m_current_size);
+  if (m_object_map.size() < num_objs) {
+    ldout(cct, 1) << "object map too small: " << m_object_map.size() << " < "
+                  << num_objs << dendl;
+    finish(-EINVAL);
+    return;
+  }
+  m_object_map.resize(num_objs);
+
+  // the diff never shrinks: objects cut off by a resize within the range
+  // have to be removed by whoever consumes it
+  uint64_t prev_num_objs = m_prev_object_map.size();
+  if (m_object_diff_state->size() < num_objs) {
+    m_object_diff_state->resize(num_objs);
+  }
+
+  uint64_t overlap = std::min(num_objs, prev_num_objs);
+  for (uint64_t i = 0; i < overlap; ++i) {
+    (*m_object_diff_state)[i] = diff_object_state(
+      m_prev_object_map[i], m_object_map[i], (*m_object_diff_state)[i]);
+  }
+  for (uint64_t i = num_objs; i < prev_num_objs; ++i) {
+    if (m_prev_object_map[i] != OBJECT_NONEXISTENT) {
+      (*m_object_diff_state)[i] = DIFF_STATE_HOLE;
+    }
+  }
+  if (m_diff_from_start || m_prev_object_map_valid) {
+    for (uint64_t i = overlap; i < num_objs; ++i) {
+      if (m_object_map[i] != OBJECT_NONEXISTENT) {
+        (*m_object_diff_state)[i] = DIFF_STATE_UPDATED;
+      }
+    }
+  }
+
+  if (m_current_snap_id == m_next_snap_id ||
+      m_next_snap_id > m_snap_id_end) {
+    finish(0);
+    return;
+  }
+
+  m_current_snap_id = m_next_snap_id;
+  std::swap(m_prev_object_map, m_object_map);
+  m_prev_object_map_valid = true;
+  load_object_map();
+}
+
+template <typename I>
+void DiffRequest<I>::finish(int r) {
+  ldout(m_image_ctx.cct, 10) << "r=" << r << dendl;
+
+  m_on_finish->complete(r);
+  delete this;
+}
+
+} // namespace object_map
+} // namespace librbd
+
+template class librbd::object_map::DiffRequest<librbd::ImageCtx>;
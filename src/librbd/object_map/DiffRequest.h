@@ -0,0 +1,96 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_LIBRBD_OBJECT_MAP_DIFF_REQUEST_H
+#define CEPH_LIBRBD_OBJECT_MAP_DIFF_REQUEST_H
+
+#include "include/int_types.h"
+#include "include/buffer.h"
+#include "common/bit_vector.hpp"
+
+class Context;
+
+namespace librbd {
+
+class ImageCtx;
+
+namespace object_map {
+
+enum DiffState {
+  DIFF_STATE_NONE    = 0,  ///< unchanged within the snapshot range
+  DIFF_STATE_UPDATED = 1,  ///< written or created
+  DIFF_STATE_HOLE    = 2   ///< removed
+};
+
+/**
+ * Compute which objects changed between two snapshots from the on-disk
+ * object maps of the image, without touching the data objects.  With a
+ * start snapshot of zero every object that exists up to the end snapshot
+ * is reported as updated.  Fails with -EINVAL if the image does not have
+ * fast-diff or one of the object maps in the range is invalid, in which
+ * case the caller has to fall back to looking at every object.
+ */
+template <typename ImageCtxT = ImageCtx>
+class DiffRequest {
+public:
+  static DiffRequest *create(ImageCtxT &image_ctx, uint64_t snap_id_start,
+                             uint64_t snap_id_end,
+                             ceph::BitVector<2> *object_diff_state,
+                             Context *on_finish) {
+    return new DiffRequest(image_ctx, snap_id_start, snap_id_end,
+                           object_diff_state, on_finish);
+  }
+
+  DiffRequest(ImageCtxT &image_ctx, uint64_t snap_id_start,
+              uint64_t snap_id_end, ceph::BitVector<2> *object_diff_state,
+              Context *on_finish)
+    : m_image_ctx(image_ctx), m_snap_id_start(snap_id_start),
+      m_snap_id_end(snap_id_end), m_object_diff_state(object_diff_state),
+      m_on_finish(on_finish) {
+  }
+
+  void send();
+
+private:
+  /**
+   * @verbatim
+   *
+   * <start>
+   *    |
+   *    v
+   * LOAD_OBJECT_MAP < . . .
+   *    |                  .  (for every snapshot
+   *    v                  .   up to the end one)
+   * <finish> . . . . . . .
+   *
+   * @endverbatim
+   */
+
+  ImageCtxT &m_image_ctx;
+  uint64_t m_snap_id_start;
+  uint64_t m_snap_id_end;
+  ceph::BitVector<2> *m_object_diff_state;
+  Context *m_on_finish;
+
+  bool m_diff_from_start = false;
+  uint64_t m_current_snap_id = 0;
+  uint64_t m_next_snap_id = 0;
+  uint64_t m_current_size = 0;
+
+  ceph::BitVector<2> m_object_map;
+  ceph::BitVector<2> m_prev_object_map;
+  bool m_prev_object_map_valid = false;
+  bufferlist m_out_bl;
+
+  void load_object_map();
+  void handle_load_object_map(int r);
+
+  void finish(int r);
+};
+
+} // namespace object_map
+} // namespace librbd
+
+extern template class librbd::object_map::DiffRequest<librbd::ImageCtx>;
+
+#endif // CEPH_LIBRBD_OBJECT_MAP_DIFF_REQUEST_H
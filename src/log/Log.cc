@@ -44,7 +44,7 @@ Log::Log(SubsystemMap *s)
     m_subs(s),
     m_queue_mutex_holder(0),
     m_flush_mutex_holder(0),
-    m_new(), m_recent(),
+    m_new(nullptr), m_new_len(0), m_recent(),
     m_fd(-1),
     m_uid(0),
     m_gid(0),
@@ -87,6 +87,9 @@ Log::~Log()
   if (m_fd >= 0)
     VOID_TEMP_FAILURE_RETRY(::close(m_fd));
 
+  EntryQueue t;
+  _take_new(&t);
+
   pthread_mutex_destroy(&m_queue_mutex);
   pthread_mutex_destroy(&m_flush_mutex);
   pthread_cond_destroy(&m_cond_loggers);
@@ -212,20 +215,56 @@ void Log::stop_graylog()
 
 void Log::submit_entry(Entry *e)
 {
-  pthread_mutex_lock(&m_queue_mutex);
-  m_queue_mutex_holder = pthread_self();
-
   if (m_inject_segv)
     *(volatile int *)(0) = 0xdead;
 
   // wait for flush to catch up
-  while (m_new.m_len > m_max_new)
-    pthread_cond_wait(&m_cond_loggers, &m_queue_mutex);
+  if (m_new_len.load(std::memory_order_relaxed) > m_max_new) {
+    pthread_mutex_lock(&m_queue_mutex);
+    m_queue_mutex_holder = pthread_self();
+    while (m_new_len.load(std::memory_order_relaxed) > m_max_new && !m_stop)
+      pthread_cond_wait(&m_cond_loggers, &m_queue_mutex);
+    m_queue_mutex_holder = 0;
+    pthread_mutex_unlock(&m_queue_mutex);
+  }
 
-  m_new.enqueue(e);
-  pthread_cond_signal(&m_cond_flusher);
-  m_queue_mutex_holder = 0;
-  pthread_mutex_unlock(&m_queue_mutex);
+  // the flusher is only woken up for the first entry of a batch; the
+  // others just push behind it
+  Entry *head = m_new.load(std::memory_order_relaxed);
+  do {
+    e->m_next = head;
+  } while (!m_new.compare_exchange_weak(head, e,
+					std::memory_order_release,
+					std::memory_order_relaxed));
+  m_new_len.fetch_add(1, std::memory_order_relaxed);
+  if (!head) {
+    pthread_mutex_lock(&m_queue_mutex);
+    m_queue_mutex_holder = pthread_self();
+    pthread_cond_signal(&m_cond_flusher);
+    m_queue_mutex_holder = 0;
+    pthread_mutex_unlock(&m_queue_mutex);
+  }
+}
+
+/// move the new entries to q, oldest first
+void Log::_take_new(EntryQueue *q)
+{
+  Entry *e = m_new.exchange(nullptr, std::memory_order_acquire);
+  Entry *prev = nullptr;
+  int n = 0;
+  while (e) {
+    Entry *next = e->m_next;
+    e->m_next = prev;
+    prev = e;
+    e = next;
+    ++n;
+  }
+  while (prev) {
+    Entry *next = prev->m_next;
+    q->enqueue(prev);
+    prev = next;
+  }
+  m_new_len.fetch_sub(n, std::memory_order_relaxed);
 }
 
 
@@ -271,10 +310,10 @@ void Log::flush()
 {
   pthread_mutex_lock(&m_flush_mutex);
   m_flush_mutex_holder = pthread_self();
+  EntryQueue t;
+  _take_new(&t);
   pthread_mutex_lock(&m_queue_mutex);
   m_queue_mutex_holder = pthread_self();
-  EntryQueue t;
-  t.swap(m_new);
   pthread_cond_broadcast(&m_cond_loggers);
   m_queue_mutex_holder = 0;
   pthread_mutex_unlock(&m_queue_mutex);
@@ -384,14 +423,8 @@ void Log::dump_recent()
   pthread_mutex_lock(&m_flush_mutex);
   m_flush_mutex_holder = pthread_self();
 
-  pthread_mutex_lock(&m_queue_mutex);
-  m_queue_mutex_holder = pthread_self();
-
   EntryQueue t;
-  t.swap(m_new);
-
-  m_queue_mutex_holder = 0;
-  pthread_mutex_unlock(&m_queue_mutex);
+  _take_new(&t);
   _flush(&t, &m_recent, false);
 
   EntryQueue old;
@@ -449,7 +482,7 @@ void *Log::entry()
   pthread_mutex_lock(&m_queue_mutex);
   m_queue_mutex_holder = pthread_self();
   while (!m_stop) {
-    if (!m_new.empty()) {
+    if (m_new.load(std::memory_order_relaxed)) {
       m_queue_mutex_holder = 0;
       pthread_mutex_unlock(&m_queue_mutex);
       flush();
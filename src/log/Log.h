@@ -4,6 +4,8 @@
 #ifndef __CEPH_LOG_LOG_H
 #define __CEPH_LOG_LOG_H
 
+#include <atomic>
+
 #include "common/Thread.h"
 
 #include "EntryQueue.h"
@@ -30,7 +32,9 @@ class Log : private Thread
   pthread_t m_queue_mutex_holder;
   pthread_t m_flush_mutex_holder;
 
-  EntryQueue m_new;    ///< new entries
+  /// new entries, newest first; pushed without taking m_queue_mutex
+  std::atomic<Entry*> m_new;
+  std::atomic<int> m_new_len;
   EntryQueue m_recent; ///< recent (less new) entries we've already written at low detail
 
   std::string m_log_file;
@@ -54,6 +58,7 @@ class Log : private Thread
 
   void *entry() override;
 
+  void _take_new(EntryQueue *q);
   void _flush(EntryQueue *q, EntryQueue *requeue, bool crash);
 
   void _log_message(const char *s, bool crash);
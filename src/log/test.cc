@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <thread>
 
 #include "log/Log.h"
 #include "common/Clock.h"
@@ -187,6 +188,30 @@ TEST(Log, ManyGather)
   log.stop();
 }
 
+TEST(Log, ManyThreads)
+{
+  SubsystemMap subs;
+  subs.add(1, "foo", 20, 1);
+  Log log(&subs);
+  log.start();
+  log.set_log_file("/tmp/big");
+  log.reopen_log_file();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&log, &subs] {
+      for (int i = 0; i < many; i++) {
+	int l = 10;
+	if (subs.should_gather(1, l))
+	  log.submit_entry(log.create_entry(l, 1, "from a thread"));
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  log.flush();
+  log.stop();
+}
+
 void do_segv()
 {
   SubsystemMap subs;
@@ -1542,15 +1542,10 @@ public:
   C_IO_Dir_OMAP_FetchedMore(CDir *d, MDSInternalContextBase *f) :
     CDirIOContext(d), fin(f), ret(0) { }
   void finish(int r) {
-    // merge results
-    if (omap.empty()) {
-      omap.swap(omap_more);
-    } else {
-      omap.insert(omap_more.begin(), omap_more.end());
-    }
     if (more) {
-      dir->_omap_fetch_more(hdrbl, omap, fin);
+      dir->_omap_fetch_more(hdrbl, omap, omap_more, fin);
     } else {
+      CDir::merge_omap_batch(omap, omap_more);
       dir->_omap_fetched(hdrbl, omap, !fin, r);
       if (fin)
 	fin->complete(r);
@@ -1576,7 +1571,8 @@ public:
     if (r >= 0) r = ret1;
     if (r >= 0) r = ret2;
     if (more) {
-      dir->_omap_fetch_more(hdrbl, omap, fin);
+      map<string, bufferlist> none;
+      dir->_omap_fetch_more(hdrbl, none, omap, fin);
     } else {
       dir->_omap_fetched(hdrbl, omap, !fin, r);
       if (fin)
@@ -1618,26 +1614,45 @@ void CDir::_omap_fetch(MDSInternalContextBase *c, const std::set<dentry_key_t>&
 			     new C_OnFinisher(fin, cache->mds->finisher));
 }
 
+void CDir::merge_omap_batch(map<string, bufferlist>& omap,
+			    map<string, bufferlist>& omap_more)
+{
+  if (omap.empty()) {
+    omap.swap(omap_more);
+    return;
+  }
+  // each batch starts after the last key of the previous one, so append
+  // at the end instead of searching the map for every key
+  for (auto& p : omap_more)
+    omap.emplace_hint(omap.end(), p.first, std::move(p.second));
+  omap_more.clear();
+}
+
 void CDir::_omap_fetch_more(
   bufferlist& hdrbl,
   map<string, bufferlist>& omap,
+  map<string, bufferlist>& omap_more,
   MDSInternalContextBase *c)
 {
   // we have more omap keys to fetch!
   object_t oid = get_ondisk_object();
   object_locator_t oloc(cache->mds->mdsmap->get_metadata_pool());
   C_IO_Dir_OMAP_FetchedMore *fin = new C_IO_Dir_OMAP_FetchedMore(this, c);
-  fin->hdrbl.claim(hdrbl);
-  fin->omap.swap(omap);
   ObjectOperation rd;
-  rd.omap_get_vals(fin->omap.rbegin()->first,
+  rd.omap_get_vals(omap_more.empty() ? omap.rbegin()->first :
+		     omap_more.rbegin()->first,
 		   "", /* filter prefix */
 		   g_conf->mds_dir_keys_per_op,
 		   &fin->omap_more,
 		   &fin->more,
 		   &fin->ret);
+  // put the next batch in flight before merging the one we just got;
+  // fin cannot complete until we return to the finisher
   cache->mds->objecter->read(oid, oloc, rd, CEPH_NOSNAP, NULL, 0,
 			     new C_OnFinisher(fin, cache->mds->finisher));
+  fin->hdrbl.claim(hdrbl);
+  fin->omap.swap(omap);
+  merge_omap_batch(fin->omap, omap_more);
 }
 
 CDentry *CDir::_load_dentry(
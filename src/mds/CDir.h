@@ -597,8 +597,11 @@ protected:
   compact_set<string> wanted_items;
 
   void _omap_fetch(MDSInternalContextBase *fin, const std::set<dentry_key_t>& keys);
+  static void merge_omap_batch(std::map<std::string, bufferlist>& omap,
+			       std::map<std::string, bufferlist>& omap_more);
   void _omap_fetch_more(
     bufferlist& hdrbl, std::map<std::string, bufferlist>& omap,
+    std::map<std::string, bufferlist>& omap_more,
     MDSInternalContextBase *fin);
   CDentry *_load_dentry(
       const std::string &key,
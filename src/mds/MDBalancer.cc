@@ -586,6 +586,7 @@ void MDBalancer::prep_rebalance(int beat)
     int cluster_size = mds->get_mds_map()->get_num_in_mds();
     mds_rank_t whoami = mds->get_nodeid();
     rebalance_time = ceph_clock_now();
+    trim_import_stamps(rebalance_time);
 
     dout(5) << " prep_rebalance: cluster loads are" << dendl;
 
@@ -749,6 +750,7 @@ int MDBalancer::mantle_prep_rebalance()
   /* prepare for balancing */
   int cluster_size = mds->get_mds_map()->get_num_in_mds();
   rebalance_time = ceph_clock_now();
+  trim_import_stamps(rebalance_time);
   mds->mdcache->migrator->clear_export_queue();
 
   /* fill in the metrics for each mds by grabbing load struct */
@@ -857,6 +859,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 	    dir->inode->is_stray())
 	  continue;
 	if (dir->is_freezing() || dir->is_frozen()) continue;  // export pbly already in progress
+	if (in_export_cooldown(dir)) continue;
 	double pop = dir->pop_auth_subtree.meta_load(rebalance_time, mds->mdcache->decayrate);
 	assert(dir->inode->authority().first == target);  // cuz that's how i put it in the map, dummy
 
@@ -864,7 +867,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 	  dout(0) << "reexporting " << *dir
 		  << " pop " << pop
 		  << " back to mds." << target << dendl;
-	  mds->mdcache->migrator->export_dir_nicely(dir, target);
+	  note_export(dir, target);
 	  have += pop;
 	  import_from_map.erase(plast);
 	  import_pop_map.erase(pop);
@@ -914,6 +917,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 	 pot != candidates.end();
 	 ++pot) {
       if ((*pot)->get_inode()->is_stray()) continue;
+      if (in_export_cooldown(*pot)) continue;
       find_exports(*pot, amount, exports, have, already_exporting);
       if (have > amount-MIN_OFFLOAD)
 	break;
@@ -928,7 +932,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 	       << " to mds." << target
 	       << " " << **it
 	       << dendl;
-      mds->mdcache->migrator->export_dir_nicely(*it, target);
+      note_export(*it, target);
     }
   }
 
@@ -936,6 +940,39 @@ void MDBalancer::try_rebalance(balance_state_t& state)
   mds->mdcache->show_subtrees();
 }
 
+bool MDBalancer::in_export_cooldown(CDir *dir)
+{
+  auto p = import_stamps.find(dir->dirfrag());
+  if (p == import_stamps.end())
+    return false;
+  if (rebalance_time - p->second >= g_conf->mds_bal_export_cooldown) {
+    import_stamps.erase(p);
+    return false;
+  }
+  dout(5) << " keeping " << *dir << ", imported at " << p->second << dendl;
+  if (mds->logger)
+    mds->logger->inc(l_mds_bal_cooldown_skips);
+  return true;
+}
+
+void MDBalancer::trim_import_stamps(utime_t now)
+{
+  double cooldown = g_conf->mds_bal_export_cooldown;
+  for (auto p = import_stamps.begin(); p != import_stamps.end(); ) {
+    if (cooldown <= 0 || now - p->second >= cooldown)
+      import_stamps.erase(p++);
+    else
+      ++p;
+  }
+}
+
+void MDBalancer::note_export(CDir *dir, mds_rank_t target)
+{
+  mds->mdcache->migrator->export_dir_nicely(dir, target);
+  if (mds->logger)
+    mds->logger->inc(l_mds_bal_exports);
+}
+
 void MDBalancer::find_exports(CDir *dir,
                               double amount,
                               list<CDir*>& exports,
@@ -1217,6 +1254,9 @@ void MDBalancer::add_import(CDir *dir, utime_t now)
 {
   dirfrag_load_vec_t subload = dir->pop_auth_subtree;
 
+  if (g_conf->mds_bal_export_cooldown > 0)
+    import_stamps[dir->dirfrag()] = now;
+
   while (true) {
     dir = dir->inode->get_parent_dir();
     if (!dir) break;
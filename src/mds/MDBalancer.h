@@ -93,6 +93,9 @@ private:
   int localize_balancer();
   void send_heartbeat();
   void handle_heartbeat(MHeartbeat *m);
+  bool in_export_cooldown(CDir *dir);
+  void trim_import_stamps(utime_t now);
+  void note_export(CDir *dir, mds_rank_t target);
   void find_exports(CDir *dir,
                     double amount,
                     list<CDir*>& exports,
@@ -138,6 +141,10 @@ private:
   // dirfrags that already have one in flight.
   set<dirfrag_t>   split_pending, merge_pending;
 
+  // when each subtree we are auth for was imported, for
+  // mds_bal_export_cooldown
+  map<dirfrag_t, utime_t> import_stamps;
+
   // per-epoch scatter/gathered info
   map<mds_rank_t, mds_load_t>  mds_load;
   map<mds_rank_t, double>       mds_meta_load;
@@ -11872,6 +11872,19 @@ int MDCache::cache_status(Formatter *f)
   mempool::get_pool(mempool::mds_co::id).dump(f);
   f->close_section();
 
+  // what each cached inode costs, counting everything in mds_co
+  // (dentries, dirfrags, locks, caps) against the inodes
+  size_t pool_bytes = mempool::get_pool(mempool::mds_co::id).allocated_bytes();
+  size_t num_inodes = inode_map.size() + snap_inode_map.size();
+  f->open_object_section("footprint");
+  f->dump_unsigned("inodes", num_inodes);
+  f->dump_unsigned("dentries", lru.lru_get_size() + bottom_lru.lru_get_size());
+  f->dump_unsigned("bytes_per_inode", num_inodes ? pool_bytes / num_inodes : 0);
+  f->dump_unsigned("sizeof_inode", sizeof(CInode));
+  f->dump_unsigned("sizeof_dentry", sizeof(CDentry));
+  f->dump_unsigned("sizeof_dir", sizeof(CDir));
+  f->close_section();
+
   f->close_section();
   return 0;
 }
@@ -368,67 +368,79 @@ void MDLog::_submit_thread()
     }
 
     int64_t features = mdsmap_up_features;
-    PendingEvent data = it->second.front();
-    it->second.pop_front();
 
-    submit_mutex.Unlock();
-
-    if (data.le) {
-      LogEvent *le = data.le;
-      LogSegment *ls = le->_segment;
-      // encode it, with event type
-      bufferlist bl;
-      le->encode_with_header(bl, features);
-
-      uint64_t write_pos = journaler->get_write_pos();
-
-      le->set_start_off(write_pos);
-      if (le->get_type() == EVENT_SUBTREEMAP)
-	ls->offset = write_pos;
+    // group commit: take a batch of events in one go and issue a single
+    // journal flush for all of them, however many asked for one
+    list<PendingEvent> batch;
+    auto last = it->second.begin();
+    for (int64_t n = std::max<int64_t>(1, g_conf->mds_log_submit_batch);
+	 n > 0 && last != it->second.end(); --n)
+      ++last;
+    batch.splice(batch.end(), it->second, it->second.begin(), last);
 
-      dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
-	      << " : " << *le << dendl;
-
-      // journal it.
-      const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
-      ls->end = new_write_pos;
+    submit_mutex.Unlock();
 
-      MDSLogContextBase *fin;
-      if (data.fin) {
-	fin = dynamic_cast<MDSLogContextBase*>(data.fin);
-	assert(fin);
-	fin->set_write_pos(new_write_pos);
+    bool do_flush = false;
+    int appended = 0;
+    for (auto& data : batch) {
+      if (data.le) {
+	LogEvent *le = data.le;
+	LogSegment *ls = le->_segment;
+	// encode it, with event type
+	bufferlist bl;
+	le->encode_with_header(bl, features);
+
+	uint64_t write_pos = journaler->get_write_pos();
+
+	le->set_start_off(write_pos);
+	if (le->get_type() == EVENT_SUBTREEMAP)
+	  ls->offset = write_pos;
+
+	dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
+		<< " : " << *le << dendl;
+
+	// journal it.
+	const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
+	ls->end = new_write_pos;
+
+	MDSLogContextBase *fin;
+	if (data.fin) {
+	  fin = dynamic_cast<MDSLogContextBase*>(data.fin);
+	  assert(fin);
+	  fin->set_write_pos(new_write_pos);
+	} else {
+	  fin = new C_MDL_Flushed(this, new_write_pos);
+	}
+
+	journaler->wait_for_flush(fin);
+
+	if (logger)
+	  logger->set(l_mdl_wrpos, ls->end);
+
+	delete le;
+	appended++;
       } else {
-	fin = new C_MDL_Flushed(this, new_write_pos);
-      }
-
-      journaler->wait_for_flush(fin);
-
-      if (data.flush)
-	journaler->flush();
-
-      if (logger)
-	logger->set(l_mdl_wrpos, ls->end);
-
-      delete le;
-    } else {
-      if (data.fin) {
-	MDSInternalContextBase* fin =
-		dynamic_cast<MDSInternalContextBase*>(data.fin);
-	assert(fin);
-	C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
-	fin2->set_write_pos(journaler->get_write_pos());
-	journaler->wait_for_flush(fin2);
+	if (data.fin) {
+	  MDSInternalContextBase* fin =
+		  dynamic_cast<MDSInternalContextBase*>(data.fin);
+	  assert(fin);
+	  C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
+	  fin2->set_write_pos(journaler->get_write_pos());
+	  journaler->wait_for_flush(fin2);
+	}
       }
       if (data.flush)
-	journaler->flush();
+	do_flush = true;
     }
 
+    if (do_flush)
+      journaler->flush();
+
     submit_mutex.Lock();
-    if (data.flush)
+    if (do_flush)
       unflushed = 0;
-    else if (data.le)
-      unflushed++;
+    else
+      unflushed += appended;
   }
 
   submit_mutex.Unlock();
@@ -1255,9 +1267,36 @@ void MDLog::_replay_thread()
 {
   dout(10) << "_replay_thread start" << dendl;
 
+  // decoded events are applied in batches so that a long replay takes
+  // mds_lock once per batch rather than once per event
+  list<LogEvent*> batch;
+  const size_t max_batch = std::max<int64_t>(1, g_conf->mds_log_replay_batch);
+  auto apply_batch = [this, &batch]() {
+    if (batch.empty())
+      return true;
+    Mutex::Locker l(mds->mds_lock);
+    bool stopping = mds->is_daemon_stopping();
+    for (auto le : batch) {
+      if (!stopping) {
+	logger->inc(l_mdl_replayed);
+	le->replay(mds);
+      }
+      delete le;
+    }
+    batch.clear();
+    return !stopping;
+  };
+
   // loop
   int r = 0;
   while (1) {
+    // apply what we have before we block on a read or act on an error;
+    // standby trimming below may drop the segments it refers to
+    if (batch.size() >= max_batch || !journaler->is_readable()) {
+      if (!apply_batch())
+	return;
+    }
+
     // wait for read?
     while (!journaler->is_readable() &&
 	   journaler->get_read_pos() < journaler->get_write_pos() &&
@@ -1379,6 +1418,7 @@ void MDLog::_replay_thread()
     if (segments.empty()) {
       dout(10) << "_replay " << pos << "~" << bl.length() << " / " << journaler->get_write_pos() 
 	       << " " << le->get_stamp() << " -- waiting for subtree_map.  (skipping " << *le << ")" << dendl;
+      delete le;
     } else {
       dout(10) << "_replay " << pos << "~" << bl.length() << " / " << journaler->get_write_pos() 
 	       << " " << le->get_stamp() << ": " << *le << dendl;
@@ -1387,20 +1427,15 @@ void MDLog::_replay_thread()
       le->_segment->end = journaler->get_read_pos();
       num_events++;
 
-      {
-        Mutex::Locker l(mds->mds_lock);
-        if (mds->is_daemon_stopping()) {
-          return;
-        }
-        logger->inc(l_mdl_replayed);
-        le->replay(mds);
-      }
+      batch.push_back(le);
     }
-    delete le;
 
     logger->set(l_mdl_rdpos, pos);
   }
 
+  if (!apply_batch())
+    return;
+
   // done!
   if (r == 0) {
     assert(journaler->get_read_pos() == journaler->get_write_pos());
@@ -1106,7 +1106,11 @@ void MDSDaemon::respawn()
 
 bool MDSDaemon::ms_dispatch(Message *m)
 {
+  // every message serializes on mds_lock; track how long dispatch waits
+  // for it and how long rank dispatch then holds it
+  utime_t start = ceph_clock_now();
   Mutex::Locker l(mds_lock);
+  utime_t locked = ceph_clock_now();
   if (stopping) {
     return false;
   }
@@ -1126,7 +1130,13 @@ bool MDSDaemon::ms_dispatch(Message *m)
 
   // Not core, try it as a rank message
   if (mds_rank) {
-    return mds_rank->ms_dispatch(m);
+    bool handled = mds_rank->ms_dispatch(m);
+    if (mds_rank && mds_rank->logger) {
+      mds_rank->logger->tinc(l_mds_dispatch_lock_wait, locked - start);
+      mds_rank->logger->tinc(l_mds_dispatch_lock_hold,
+                             ceph_clock_now() - locked);
+    }
+    return handled;
   } else {
     return false;
   }
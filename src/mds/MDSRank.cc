@@ -2603,6 +2603,14 @@ void MDSRank::create_logger()
     mds_plb.add_u64_counter(
       l_mds_imported_inodes, "imported_inodes", "Imported inodes", "imi",
       PerfCountersBuilder::PRIO_INTERESTING);
+    mds_plb.add_time_avg(l_mds_dispatch_lock_wait, "dispatch_lock_wait",
+                         "Time waiting for mds_lock before dispatching a message");
+    mds_plb.add_time_avg(l_mds_dispatch_lock_hold, "dispatch_lock_hold",
+                         "Time mds_lock is held dispatching a rank message");
+    mds_plb.add_u64_counter(l_mds_bal_exports, "bal_exports",
+                            "Subtree exports started by the balancer");
+    mds_plb.add_u64_counter(l_mds_bal_cooldown_skips, "bal_cooldown_skips",
+                            "Recently imported subtrees the balancer kept");
     logger = mds_plb.create_perf_counters();
     g_ceph_context->get_perfcounters_collection()->add(logger);
   }
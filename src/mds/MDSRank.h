@@ -69,6 +69,10 @@ enum {
   l_mds_exported_inodes,
   l_mds_imported,
   l_mds_imported_inodes,
+  l_mds_dispatch_lock_wait,
+  l_mds_dispatch_lock_hold,
+  l_mds_bal_exports,
+  l_mds_bal_cooldown_skips,
   l_mds_last,
 };
 
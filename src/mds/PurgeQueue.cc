@@ -103,6 +103,8 @@ void PurgeQueue::create_logger()
   pcb.add_u64(l_pq_executing, "pq_executing", "Purge queue tasks in flight");
   pcb.add_u64_counter(l_pq_executed, "pq_executed", "Purge queue tasks executed", "purg",
       PerfCountersBuilder::PRIO_INTERESTING);
+  pcb.add_u64(l_pq_backlog_bytes, "pq_backlog_bytes",
+      "Purge queue journal bytes not yet consumed");
 
   logger.reset(pcb.create_perf_counters());
   g_ceph_context->get_perfcounters_collection()->add(logger.get());
@@ -263,6 +265,8 @@ void PurgeQueue::push(const PurgeItem &pi, Context *completion)
   ::encode(pi, bl);
   journaler.append_entry(bl);
   journaler.wait_for_flush(completion);
+  logger->set(l_pq_backlog_bytes,
+	      journaler.get_write_pos() - journaler.get_read_pos());
 
   // Maybe go ahead and do something with it right away
   bool could_consume = _consume();
@@ -303,8 +307,13 @@ uint32_t PurgeQueue::_calculate_ops(const PurgeItem &item) const
 
     ops_required = MIN(num, g_conf->filer_max_purge_ops);
 
-    // Account for removing (or zeroing) backtrace
-    ops_required += 1;
+    // Account for removing (or zeroing) backtrace.  A purged file with
+    // data in the default namespace loses its backtrace along with
+    // object 0, so don't charge for an op _execute_item never issues.
+    if (item.action != PurgeItem::PURGE_FILE || item.size == 0 ||
+	!item.layout.pool_ns.empty()) {
+      ops_required += 1;
+    }
 
     // Account for deletions for old pools
     if (item.action != PurgeItem::TRUNCATE_FILE) {
@@ -394,6 +403,8 @@ bool PurgeQueue::_consume()
     dout(20) << " executing item (0x" << std::hex << item.ino
              << std::dec << ")" << dendl;
     _execute_item(item, journaler.get_read_pos());
+    logger->set(l_pq_backlog_bytes,
+		journaler.get_write_pos() - journaler.get_read_pos());
   }
 
   dout(10) << " cannot consume right now" << dendl;
@@ -60,6 +60,7 @@ enum {
   l_pq_executing_ops,
   l_pq_executing,
   l_pq_executed,
+  l_pq_backlog_bytes,
   l_pq_last
 };
 
@@ -173,6 +173,12 @@ void Server::create_logger()
       "Request type remove snapshot");
   plb.add_u64_counter(l_mdss_req_renamesnap, "req_renamesnap",
       "Request type rename snapshot");
+  plb.add_u64_counter(l_mdss_recall_sessions, "recall_sessions",
+      "Sessions asked to release caps");
+  plb.add_u64_counter(l_mdss_recall_caps, "recall_caps",
+      "Caps asked to be released");
+  plb.add_u64_counter(l_mdss_recall_deferred, "recall_deferred",
+      "Sessions left for a later recall pass");
   logger = plb.create_perf_counters();
   g_ceph_context->get_perfcounters_collection()->add(logger);
 }
@@ -1106,11 +1112,25 @@ void Server::recall_client_state(void)
 
   set<Session*> sessions;
   mds->sessionmap.get_client_session_set(sessions);
+
+  // recall from the biggest holders first, and from at most
+  // mds_recall_max_sessions of them per pass so that cache pressure on a
+  // large cluster does not turn into a burst to every client at once
+  vector<Session*> by_caps;
   for (auto &session : sessions) {
     if (!session->is_open() ||
 	!session->info.inst.name.is_client())
       continue;
+    by_caps.push_back(session);
+  }
+  std::sort(by_caps.begin(), by_caps.end(),
+	    [](const Session *a, const Session *b) {
+	      return a->caps.size() > b->caps.size();
+	    });
 
+  uint64_t max_sessions = g_conf->get_val<uint64_t>("mds_recall_max_sessions");
+  uint64_t recalled = 0;
+  for (auto &session : by_caps) {
     dout(10) << " session " << session->info.inst
 	     << " caps " << session->caps.size()
 	     << ", leases " << session->leases.size()
@@ -1118,10 +1138,17 @@ void Server::recall_client_state(void)
 
     uint64_t newlim = MAX(MIN((session->caps.size() * ratio), max_caps_per_client), min_caps_per_client);
     if (session->caps.size() > newlim) {
+      if (max_sessions && recalled >= max_sessions) {
+	logger->inc(l_mdss_recall_deferred);
+	continue;
+      }
       MClientSession *m = new MClientSession(CEPH_SESSION_RECALL_STATE);
       m->head.max_caps = newlim;
       mds->send_message_client(m, session);
+      logger->inc(l_mdss_recall_sessions);
+      logger->inc(l_mdss_recall_caps, session->caps.size() - newlim);
       session->notify_recall_sent(newlim);
+      recalled++;
     }
   }
 }
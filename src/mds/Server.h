@@ -64,6 +64,9 @@ enum {
   l_mdss_req_setxattr,
   l_mdss_req_symlink,
   l_mdss_req_unlink,
+  l_mdss_recall_sessions,
+  l_mdss_recall_caps,
+  l_mdss_recall_deferred,
   l_mdss_last,
 };
 
@@ -30,6 +30,10 @@ class MOSDMap : public Message {
   map<epoch_t, bufferlist> incremental_maps;
   epoch_t oldest_map =0, newest_map = 0;
 
+  // features the maps above are already encoded for (0: native
+  // encoding).  Local only; never sent on the wire.
+  uint64_t encode_features = 0;
+
   epoch_t get_first() const {
     epoch_t e = 0;
     map<epoch_t, bufferlist>::const_iterator i = maps.begin();
@@ -79,57 +83,72 @@ public:
       newest_map = 0;
     }
   }
+  /**
+   * Whether peers with these features need the maps reencoded in a
+   * legacy format rather than the mon's native encoding.
+   */
+  static bool need_reencode(uint64_t features) {
+    return ((features & CEPH_FEATURE_PGID64) == 0 ||
+	    (features & CEPH_FEATURE_PGPOOL3) == 0 ||
+	    (features & CEPH_FEATURE_OSDENC) == 0 ||
+	    (features & CEPH_FEATURE_OSDMAP_ENC) == 0 ||
+	    (features & CEPH_FEATURE_MSG_ADDR2) == 0 ||
+	    !HAVE_FEATURE(features, SERVER_LUMINOUS));
+  }
+
+  static void reencode_incremental(bufferlist& bl, uint64_t features) {
+    OSDMap::Incremental inc;
+    bufferlist::iterator q = bl.begin();
+    inc.decode(q);
+    bl.clear();
+    if (inc.fullmap.length()) {
+      // embedded full map?
+      OSDMap m;
+      m.decode(inc.fullmap);
+      inc.fullmap.clear();
+      m.encode(inc.fullmap, features | CEPH_FEATURE_RESERVED);
+    }
+    if (inc.crush.length()) {
+      // embedded crush map
+      CrushWrapper c;
+      auto p = inc.crush.begin();
+      c.decode(p);
+      inc.crush.clear();
+      c.encode(inc.crush, features);
+    }
+    inc.encode(bl, features | CEPH_FEATURE_RESERVED);
+  }
+
+  static void reencode_full(bufferlist& bl, uint64_t features) {
+    OSDMap m;
+    m.decode(bl);
+    bl.clear();
+    m.encode(bl, features | CEPH_FEATURE_RESERVED);
+  }
+
   void encode_payload(uint64_t features) override {
     header.version = HEAD_VERSION;
     ::encode(fsid, payload);
-    if ((features & CEPH_FEATURE_PGID64) == 0 ||
-	(features & CEPH_FEATURE_PGPOOL3) == 0 ||
-	(features & CEPH_FEATURE_OSDENC) == 0 ||
-        (features & CEPH_FEATURE_OSDMAP_ENC) == 0 ||
-	(features & CEPH_FEATURE_MSG_ADDR2) == 0 ||
-	!HAVE_FEATURE(features, SERVER_LUMINOUS)) {
+    if (need_reencode(features)) {
       if ((features & CEPH_FEATURE_PGID64) == 0 ||
 	  (features & CEPH_FEATURE_PGPOOL3) == 0)
 	header.version = 1;  // old old_client version
       else if ((features & CEPH_FEATURE_OSDENC) == 0)
 	header.version = 2;  // old pg_pool_t
 
-      // reencode maps using old format
-      //
-      // FIXME: this can probably be done more efficiently higher up
-      // the stack, or maybe replaced with something that only
-      // includes the pools the client cares about.
-      for (map<epoch_t,bufferlist>::iterator p = incremental_maps.begin();
-	   p != incremental_maps.end();
-	   ++p) {
-	OSDMap::Incremental inc;
-	bufferlist::iterator q = p->second.begin();
-	inc.decode(q);
-	p->second.clear();
-	if (inc.fullmap.length()) {
-	  // embedded full map?
-	  OSDMap m;
-	  m.decode(inc.fullmap);
-	  inc.fullmap.clear();
-	  m.encode(inc.fullmap, features | CEPH_FEATURE_RESERVED);
+      // reencode maps using old format, unless the sender already did
+      // so for exactly this feature set.
+      if (encode_features != features) {
+	for (map<epoch_t,bufferlist>::iterator p = incremental_maps.begin();
+	     p != incremental_maps.end();
+	     ++p) {
+	  reencode_incremental(p->second, features);
 	}
-	if (inc.crush.length()) {
-	  // embedded crush map
-	  CrushWrapper c;
-	  auto p = inc.crush.begin();
-	  c.decode(p);
-	  inc.crush.clear();
-	  c.encode(inc.crush, features);
+	for (map<epoch_t,bufferlist>::iterator p = maps.begin();
+	     p != maps.end();
+	     ++p) {
+	  reencode_full(p->second, features);
 	}
-	inc.encode(p->second, features | CEPH_FEATURE_RESERVED);
-      }
-      for (map<epoch_t,bufferlist>::iterator p = maps.begin();
-	   p != maps.end();
-	   ++p) {
-	OSDMap m;
-	m.decode(p->second);
-	p->second.clear();
-	m.encode(p->second, features | CEPH_FEATURE_RESERVED);
       }
     }
     ::encode(incremental_maps, payload);
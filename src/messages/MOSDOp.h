@@ -65,6 +65,8 @@ private:
   dmc::ReqParams qos_params;
 
 public:
+  MEMPOOL_CLASS_HELPERS();
+
   friend class MOSDOpReply;
 
   ceph_tid_t get_client_tid() { return header.tid; }
@@ -527,8 +529,8 @@ struct ceph_osd_request_head {
 	reqid = osd_reqid_t();
 
       hobj.pool = pgid.pgid.pool();
-      hobj.set_key(oloc.key);
-      hobj.nspace = oloc.nspace;
+      hobj.set_key(std::move(oloc.key));
+      hobj.nspace = std::move(oloc.nspace);
       hobj.set_hash(pgid.pgid.ps());
 
       OSDOp::split_osd_op_vector_in_data(ops, data);
@@ -571,8 +573,9 @@ struct ceph_osd_request_head {
     ::decode(features, p);
 
     hobj.pool = pgid.pgid.pool();
-    hobj.set_key(oloc.key);
-    hobj.nspace = oloc.nspace;
+    // the locator is a temporary; hand its strings over rather than copy
+    hobj.set_key(std::move(oloc.key));
+    hobj.nspace = std::move(oloc.nspace);
 
     OSDOp::split_osd_op_vector_in_data(ops, data);
 
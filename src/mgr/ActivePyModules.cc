@@ -158,10 +158,9 @@ PyObject *ActivePyModules::get_daemon_status_python(
 
 PyObject *ActivePyModules::get_python(const std::string &what)
 {
-  PyThreadState *tstate = PyEval_SaveThread();
-  Mutex::Locker l(lock);
-  PyEval_RestoreThread(tstate);
-
+  // Everything below is guarded by the cluster_state and daemon_state
+  // locks; our own lock only protects the module table, so don't hold
+  // it here and serialize every module's (possibly large) dumps.
   if (what == "fs_map") {
     PyFormatter f;
     cluster_state.with_fsmap([&f](const FSMap &fsmap) {
@@ -272,12 +271,20 @@ PyObject *ActivePyModules::get_python(const std::string &what)
     );
     return f.get();
   } else if (what == "pg_dump") {
-    PyFormatter f;
-        cluster_state.with_pgmap(
-        [&f](const PGMap &pg_map) {
-	  pg_map.dump(&f);
+    // Building the python objects for every PG is slow; do it from a
+    // private copy so that the cluster state lock (and with it the
+    // ingestion of pg stats) is only held for the copy.
+    PGMap pg_map;
+    PyThreadState *tstate = PyEval_SaveThread();
+    cluster_state.with_pgmap(
+        [&pg_map](const PGMap &p) {
+	  pg_map = p;
         }
     );
+    PyEval_RestoreThread(tstate);
+
+    PyFormatter f;
+    pg_map.dump(&f);
     return f.get();
   } else if (what == "df") {
     PyFormatter f;
@@ -139,13 +139,22 @@ void DaemonPerfCounters::update(MMgrReport *report)
     session->declared_types.erase(t);
   }
 
+  if (!report->declare_types.empty() || !report->undeclare_types.empty() ||
+      decode_order.size() != session->declared_types.size()) {
+    decode_order.clear();
+    decode_order.reserve(session->declared_types.size());
+    for (const auto &t_path : session->declared_types) {
+      decode_order.emplace_back(&types.at(t_path), &instances[t_path]);
+    }
+  }
+
   const auto now = ceph_clock_now();
 
   // Parse packed data according to declared set of types
   bufferlist::iterator p = report->packed.begin();
   DECODE_START(1, p);
-  for (const auto &t_path : session->declared_types) {
-    const auto &t = types.at(t_path);
+  for (const auto &i : decode_order) {
+    const auto &t = *i.first;
     uint64_t val = 0;
     uint64_t avgcount = 0;
     uint64_t avgcount2 = 0;
@@ -156,7 +165,7 @@ void DaemonPerfCounters::update(MMgrReport *report)
       ::decode(avgcount2, p);
     }
     // TODO: interface for insertion of avgs
-    instances[t_path].push(now, val);
+    i.second->push(now, val);
   }
   DECODE_FINISH(p);
 }
@@ -18,6 +18,7 @@
 #include <string>
 #include <memory>
 #include <set>
+#include <vector>
 #include <boost/circular_buffer.hpp>
 
 #include "common/RWLock.h"
@@ -74,10 +75,17 @@ class DaemonPerfCounters
 
   std::map<std::string, PerfCounterInstance> instances;
 
+  // The declared counters in the order their values are packed in a
+  // report, so that decoding one doesn't need two string map lookups
+  // per counter.  Rebuilt whenever the declared set changes.
+  std::vector<std::pair<const PerfCounterType*, PerfCounterInstance*>>
+    decode_order;
+
   void update(MMgrReport *report);
 
   void clear()
   {
+    decode_order.clear();
     instances.clear();
   }
 };
@@ -257,50 +257,81 @@ void MgrClient::send_report()
       session->declared.erase(path);
     };
 
+    // What to report, by path: the counters themselves, plus one gauge
+    // per percentile of those keeping a latency histogram
+    struct report_counter_t {
+      PerfCounterType type;
+      uint64_t value = 0;
+      uint64_t avgcount = 0;
+    };
+    std::map<std::string, report_counter_t> counters;
+    for (const auto &i : by_path) {
+      auto& path = i.first;
+      auto& data = *(i.second.data);
+      auto& perf_counters = *(i.second.perf_counters);
+
+      // Counters that still exist, but are no longer permitted by
+      // stats_threshold, get undeclared below
+      if (!include_counter(data, perf_counters)) {
+        continue;
+      }
+
+      report_counter_t& c = counters[path];
+      c.type.path = path;
+      if (data.description) {
+	c.type.description = data.description;
+      }
+      if (data.nick) {
+	c.type.nick = data.nick;
+      }
+      c.type.type = data.type;
+      c.type.priority = perf_counters.get_adjusted_priority(data.prio);
+      if (data.type & PERFCOUNTER_LONGRUNAVG) {
+        pair<uint64_t,uint64_t> a = data.read_avg();
+        c.value = a.first;
+        c.avgcount = a.second;
+      } else {
+        c.value = data.read_u64();
+      }
+
+      if (data.latency_histogram) {
+        for (auto& p : PerfCounters::latency_percentiles) {
+          std::string ppath = path + "_" + p.first;
+          report_counter_t& pc = counters[ppath];
+          pc.type.path = ppath;
+          pc.type.description = c.type.description + " (" + p.first + ")";
+          pc.type.type = PERFCOUNTER_TIME;
+          pc.type.priority = c.type.priority;
+          pc.value = data.latency_histogram->get_percentile(p.second);
+        }
+      }
+    }
+
     ENCODE_START(1, 1, report->packed);
 
     // Find counters that no longer exist, and undeclare them
     for (auto p = session->declared.begin(); p != session->declared.end(); ) {
       const auto &path = *(p++);
-      if (by_path.count(path) == 0) {
+      if (counters.count(path) == 0) {
         undeclare(path);
       }
     }
 
-    for (const auto &i : by_path) {
+    for (auto &i : counters) {
       auto& path = i.first;
-      auto& data = *(i.second.data);
-      auto& perf_counters = *(i.second.perf_counters);
-
-      // Find counters that still exist, but are no longer permitted by
-      // stats_threshold
-      if (!include_counter(data, perf_counters)) {
-        if (session->declared.count(path)) {
-          undeclare(path);
-        }
-        continue;
-      }
+      auto& c = i.second;
+      bool avg = c.type.type & PERFCOUNTER_LONGRUNAVG;
 
       if (session->declared.count(path) == 0) {
 	ldout(cct,20) << " declare " << path << dendl;
-	PerfCounterType type;
-	type.path = path;
-	if (data.description) {
-	  type.description = data.description;
-	}
-	if (data.nick) {
-	  type.nick = data.nick;
-	}
-	type.type = data.type;
-        type.priority = perf_counters.get_adjusted_priority(data.prio);
-	report->declare_types.push_back(std::move(type));
+	report->declare_types.push_back(std::move(c.type));
 	session->declared.insert(path);
       }
 
-      ::encode(static_cast<uint64_t>(data.u64), report->packed);
-      if (data.type & PERFCOUNTER_LONGRUNAVG) {
-        ::encode(static_cast<uint64_t>(data.avgcount), report->packed);
-        ::encode(static_cast<uint64_t>(data.avgcount2), report->packed);
+      ::encode(c.value, report->packed);
+      if (avg) {
+        ::encode(c.avgcount, report->packed);
+        ::encode(c.avgcount, report->packed);
       }
     }
     ENCODE_FINISH(report->packed);
@@ -147,13 +147,19 @@ static PyObject *osdmap_map_pool_pgs_up(BasePyOSDMap* self, PyObject *args)
   auto pi = self->osdmap->get_pg_pool(poolid);
   if (!pi)
     return nullptr;
+  // map every pg in the pool through the same crush workspace rather
+  // than allocating a fresh one per pg; the balancer calls this for
+  // every pool on each optimization step.
+  vector<char> work(self->osdmap->crush->work_size(pi->get_size()));
+  self->osdmap->crush->init_work(work.data());
   map<pg_t,vector<int>> pm;
   for (unsigned ps = 0; ps < pi->get_pg_num(); ++ps) {
     pg_t pgid(ps, poolid);
-    self->osdmap->pg_to_up_acting_osds(pgid, &pm[pgid], nullptr, nullptr, nullptr);
+    self->osdmap->pg_to_up_acting_osds(pgid, &pm[pgid], nullptr, nullptr,
+                                       nullptr, work.data());
   }
   PyFormatter f;
-  for (auto p : pm) {
+  for (auto& p : pm) {
     string pg = stringify(p.first);
     f.open_array_section(pg.c_str());
     for (auto o : p.second) {
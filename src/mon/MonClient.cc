@@ -591,6 +591,7 @@ void MonClient::_reopen_session(int rank)
 
   active_con.reset();
   pending_cons.clear();
+  hunt_tried.clear();
 
   _start_hunting();
 
@@ -633,6 +634,7 @@ MonConnection& MonClient::_add_conn(unsigned rank, uint64_t global_id)
   auto conn = messenger->get_connection(monmap.get_inst(rank));
   MonConnection mc(cct, conn, global_id);
   auto inserted = pending_cons.insert(make_pair(peer, move(mc)));
+  hunt_tried.insert(peer);
   ldout(cct, 10) << "picked mon." << monmap.get_name(rank)
                  << " con " << conn
                  << " addr " << conn->get_peer_addr()
@@ -666,6 +668,37 @@ void MonClient::_add_conns(uint64_t global_id)
   }
 }
 
+void MonClient::_hunt_next(const entity_addr_t& failed)
+{
+  // replace a failed hunted mon with one we have not tried in this hunt,
+  // so a dead mon does not hold up the hunt until the next tick
+  uint16_t min_priority = std::numeric_limits<uint16_t>::max();
+  vector<unsigned> ranks;
+  for (const auto& m : monmap.mon_info) {
+    if (hunt_tried.count(m.second.public_addr)) {
+      continue;
+    }
+    if (m.second.priority < min_priority) {
+      min_priority = m.second.priority;
+      ranks.clear();
+    }
+    if (m.second.priority == min_priority) {
+      ranks.push_back(monmap.get_rank(m.first));
+    }
+  }
+  if (ranks.empty()) {
+    // all tried; keep the failed one so we are still hunting, and let
+    // the next tick start over with backoff
+    return;
+  }
+  pending_cons.erase(failed);
+  std::random_device rd;
+  std::mt19937 rng(rd());
+  unsigned rank = ranks[rng() % ranks.size()];
+  _add_conn(rank, global_id).start(monmap.get_epoch(), entity_name,
+				   *auth_supported);
+}
+
 bool MonClient::ms_handle_reset(Connection *con)
 {
   Mutex::Locker lock(monc_lock);
@@ -676,6 +709,7 @@ bool MonClient::ms_handle_reset(Connection *con)
   if (_hunting()) {
     if (pending_cons.count(con->get_peer_addr())) {
       ldout(cct, 10) << __func__ << " hunted mon " << con->get_peer_addr() << dendl;
+      _hunt_next(con->get_peer_addr());
     } else {
       ldout(cct, 10) << __func__ << " stray mon " << con->get_peer_addr() << dendl;
     }
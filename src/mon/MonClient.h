@@ -152,6 +152,7 @@ private:
 
   std::unique_ptr<MonConnection> active_con;
   std::map<entity_addr_t, MonConnection> pending_cons;
+  std::set<entity_addr_t> hunt_tried;  ///< mons tried since the hunt began
 
   EntityName entity_name;
 
@@ -212,6 +213,7 @@ private:
   MonConnection& _add_conn(unsigned rank, uint64_t global_id);
   void _un_backoff();
   void _add_conns(uint64_t global_id);
+  void _hunt_next(const entity_addr_t& failed);
   void _send_mon_message(Message *m);
 
 public:
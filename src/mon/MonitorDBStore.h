@@ -261,39 +261,49 @@ class MonitorDBStore
   };
 
   int apply_transaction(MonitorDBStore::TransactionRef t) {
+    return apply_transactions(list<TransactionRef>{t});
+  }
+
+  /**
+   * apply several transactions, in order, with a single synchronous
+   * submit to the backing store
+   */
+  int apply_transactions(const list<MonitorDBStore::TransactionRef>& tls) {
     KeyValueDB::Transaction dbt = db->get_transaction();
 
-    if (do_dump) {
-      if (!g_conf->mon_debug_dump_json) {
-        bufferlist bl;
-        t->encode(bl);
-        bl.write_fd(dump_fd_binary);
-      } else {
-        t->dump(&dump_fmt, true);
-        dump_fmt.flush(dump_fd_json);
-        dump_fd_json.flush();
+    list<pair<string, pair<string,string> > > compact;
+    for (auto& t : tls) {
+      if (do_dump) {
+	if (!g_conf->mon_debug_dump_json) {
+	  bufferlist bl;
+	  t->encode(bl);
+	  bl.write_fd(dump_fd_binary);
+	} else {
+	  t->dump(&dump_fmt, true);
+	  dump_fmt.flush(dump_fd_json);
+	  dump_fd_json.flush();
+	}
       }
-    }
 
-    list<pair<string, pair<string,string> > > compact;
-    for (list<Op>::const_iterator it = t->ops.begin();
-	 it != t->ops.end();
-	 ++it) {
-      const Op& op = *it;
-      switch (op.type) {
-      case Transaction::OP_PUT:
-	dbt->set(op.prefix, op.key, op.bl);
-	break;
-      case Transaction::OP_ERASE:
-	dbt->rmkey(op.prefix, op.key);
-	break;
-      case Transaction::OP_COMPACT:
-	compact.push_back(make_pair(op.prefix, make_pair(op.key, op.endkey)));
-	break;
-      default:
-	derr << __func__ << " unknown op type " << op.type << dendl;
-	ceph_abort();
-	break;
+      for (list<Op>::const_iterator it = t->ops.begin();
+	   it != t->ops.end();
+	   ++it) {
+	const Op& op = *it;
+	switch (op.type) {
+	case Transaction::OP_PUT:
+	  dbt->set(op.prefix, op.key, op.bl);
+	  break;
+	case Transaction::OP_ERASE:
+	  dbt->rmkey(op.prefix, op.key);
+	  break;
+	case Transaction::OP_COMPACT:
+	  compact.push_back(make_pair(op.prefix, make_pair(op.key, op.endkey)));
+	  break;
+	default:
+	  derr << __func__ << " unknown op type " << op.type << dendl;
+	  ceph_abort();
+	  break;
+	}
       }
     }
     int r = db->submit_transaction_sync(dbt);
@@ -312,19 +322,23 @@ class MonitorDBStore
     return r;
   }
 
-  struct C_DoTransaction : public Context {
+  struct C_DoTransactions : public Context {
     MonitorDBStore *store;
-    MonitorDBStore::TransactionRef t;
-    Context *oncommit;
-    C_DoTransaction(MonitorDBStore *s, MonitorDBStore::TransactionRef t,
-		    Context *f)
-      : store(s), t(t), oncommit(f)
-    {}
+    explicit C_DoTransactions(MonitorDBStore *s) : store(s) {}
     void finish(int r) override {
-      /* The store serializes writes.  Each transaction is handled
-       * sequentially by the io_work Finisher.  If a transaction takes longer
-       * to apply its state to permanent storage, then no other transaction
-       * will be handled meanwhile.
+      list<pair<TransactionRef, Context*> > batch;
+      {
+	Mutex::Locker l(store->queue_lock);
+	batch.swap(store->queued);
+	store->io_scheduled = false;
+      }
+      if (batch.empty())
+	return;
+
+      /* The store serializes writes.  Each batch is handled sequentially
+       * by the io_work Finisher.  If a batch takes longer to apply its
+       * state to permanent storage, then no other transaction will be
+       * handled meanwhile; those queue up and go out in the next batch.
        *
        * We will now randomly inject random delays.  We can safely sleep prior
        * to applying the transaction as it won't break the model.
@@ -339,8 +353,14 @@ class MonitorDBStore
           << " seconds" << dendl;
         delay.sleep();
       }
-      int ret = store->apply_transaction(t);
-      oncommit->complete(ret);
+      list<TransactionRef> tls;
+      for (auto& p : batch)
+	tls.push_back(p.first);
+      lsubdout(g_ceph_context, mon, 20)
+	<< "apply_transactions " << tls.size() << " transactions" << dendl;
+      int ret = store->apply_transactions(tls);
+      for (auto& p : batch)
+	p.second->complete(ret);
     }
   };
 
@@ -348,13 +368,28 @@ class MonitorDBStore
    * queue transaction
    *
    * Queue a transaction to commit asynchronously.  Trigger a context
-   * on completion (without any locks held).
+   * on completion (without any locks held).  Transactions queued while
+   * an earlier one is being written are committed together, in order,
+   * with a single sync of the backing store.
    */
   void queue_transaction(MonitorDBStore::TransactionRef t,
 			 Context *oncommit) {
-    io_work.queue(new C_DoTransaction(this, t, oncommit));
+    Mutex::Locker l(queue_lock);
+    queued.push_back(make_pair(t, oncommit));
+    if (!io_scheduled) {
+      io_scheduled = true;
+      io_work.queue(new C_DoTransactions(this));
+    }
   }
 
+ private:
+  // transactions waiting for the next group commit on io_work
+  Mutex queue_lock;
+  list<pair<TransactionRef, Context*> > queued;
+  bool io_scheduled;
+
+ public:
+
   /**
    * block and flush all io activity
    */
@@ -753,7 +788,9 @@ class MonitorDBStore
       dump_fd_binary(-1),
       dump_fmt(true),
       io_work(g_ceph_context, "monstore", "fn_monstore"),
-      is_open(false) {
+      is_open(false),
+      queue_lock("MonitorDBStore::queue_lock"),
+      io_scheduled(false) {
   }
   ~MonitorDBStore() {
     assert(!is_open);
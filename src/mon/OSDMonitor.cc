@@ -186,6 +186,8 @@ OSDMonitor::OSDMonitor(
    cct(cct),
    inc_osd_cache(g_conf->mon_osd_cache_size),
    full_osd_cache(g_conf->mon_osd_cache_size),
+   inc_osd_legacy_cache(g_conf->mon_osd_cache_size),
+   full_osd_legacy_cache(g_conf->mon_osd_cache_size),
    last_attempted_minwait_time(utime_t()),
    mapper(mn->cct, &mn->cpu_tp),
    op_tracker(cct, true, 1)
@@ -1224,9 +1226,24 @@ void OSDMonitor::encode_pending(MonitorDBStore::TransactionRef t)
   t->put(OSD_PG_CREATING_PREFIX, "creating", creatings_bl);
 
   // health
-  health_check_map_t next;
-  tmp.check_health(&next);
-  encode_health(next, t);
+  ostringstream health_conf;
+  health_conf << g_conf->mon_warn_on_legacy_crush_tunables << " "
+	      << g_conf->mon_crush_min_required_version << " "
+	      << g_conf->mon_warn_on_crush_straw_calc_version_zero << " "
+	      << g_conf->mon_warn_on_cache_pools_without_hit_sets << " "
+	      << g_conf->osd_failsafe_full_ratio;
+  if (health_cache_epoch != osdmap.get_epoch() ||
+      health_cache_conf != health_conf.str() ||
+      pending_inc.may_change_health()) {
+    health_cache = health_check_map_t();
+    tmp.check_health(&health_cache);
+    health_cache_conf = health_conf.str();
+  } else {
+    dout(20) << __func__ << " reusing health checks from e"
+	     << health_cache_epoch << dendl;
+  }
+  health_cache_epoch = tmp.get_epoch();
+  encode_health(health_cache, t);
 }
 
 void OSDMonitor::trim_creating_pgs(creating_pgs_t* creating_pgs,
@@ -2853,25 +2870,41 @@ void OSDMonitor::send_latest(MonOpRequestRef op, epoch_t start)
 }
 
 
-MOSDMap *OSDMonitor::build_latest_full()
+/**
+ * Features to encode maps for when sending to this session.  Replies
+ * to proxied sessions travel through the forwarding mon, which
+ * reencodes them for the client itself, so keep those native.
+ */
+static uint64_t map_encode_features(MonSession *s)
+{
+  if (!s || s->proxy_con)
+    return 0;
+  return s->con_features;
+}
+
+MOSDMap *OSDMonitor::build_latest_full(uint64_t features)
 {
   MOSDMap *r = new MOSDMap(mon->monmap->fsid);
-  get_version_full(osdmap.get_epoch(), r->maps[osdmap.get_epoch()]);
+  get_version_full(osdmap.get_epoch(), features, r->maps[osdmap.get_epoch()]);
   r->oldest_map = get_first_committed();
   r->newest_map = osdmap.get_epoch();
+  r->encode_features = features;
   return r;
 }
 
-MOSDMap *OSDMonitor::build_incremental(epoch_t from, epoch_t to)
+MOSDMap *OSDMonitor::build_incremental(epoch_t from, epoch_t to,
+				       uint64_t features)
 {
-  dout(10) << "build_incremental [" << from << ".." << to << "]" << dendl;
+  dout(10) << "build_incremental [" << from << ".." << to << "] features 0x"
+	   << std::hex << features << std::dec << dendl;
   MOSDMap *m = new MOSDMap(mon->monmap->fsid);
   m->oldest_map = get_first_committed();
   m->newest_map = osdmap.get_epoch();
+  m->encode_features = features;
 
   for (epoch_t e = to; e >= from && e > 0; e--) {
     bufferlist bl;
-    int err = get_version(e, bl);
+    int err = get_version(e, features, bl);
     if (err == 0) {
       assert(bl.length());
       // if (get_version(e, bl) > 0) {
@@ -2881,7 +2914,7 @@ MOSDMap *OSDMonitor::build_incremental(epoch_t from, epoch_t to)
     } else {
       assert(err == -ENOENT);
       assert(!bl.length());
-      get_version_full(e, bl);
+      get_version_full(e, features, bl);
       if (bl.length() > 0) {
       //else if (get_version("full", e, bl) > 0) {
       dout(20) << "build_incremental   full " << e << " "
@@ -2899,7 +2932,8 @@ void OSDMonitor::send_full(MonOpRequestRef op)
 {
   op->mark_osdmon_event(__func__);
   dout(5) << "send_full to " << op->get_req()->get_orig_source_inst() << dendl;
-  mon->send_reply(op, build_latest_full());
+  mon->send_reply(op,
+    build_latest_full(map_encode_features(op->get_session())));
 }
 
 void OSDMonitor::send_incremental(MonOpRequestRef op, epoch_t first)
@@ -2930,6 +2964,7 @@ void OSDMonitor::send_incremental(epoch_t first,
 {
   dout(5) << "send_incremental [" << first << ".." << osdmap.get_epoch() << "]"
 	  << " to " << session->inst << dendl;
+  uint64_t features = map_encode_features(session);
 
   if (first <= session->osd_epoch) {
     dout(10) << __func__ << " " << session->inst << " should already have epoch "
@@ -2940,7 +2975,7 @@ void OSDMonitor::send_incremental(epoch_t first,
   if (first < get_first_committed()) {
     first = get_first_committed();
     bufferlist bl;
-    int err = get_version_full(first, bl);
+    int err = get_version_full(first, features, bl);
     assert(err == 0);
     assert(bl.length());
 
@@ -2951,6 +2986,7 @@ void OSDMonitor::send_incremental(epoch_t first,
     m->oldest_map = get_first_committed();
     m->newest_map = osdmap.get_epoch();
     m->maps[first] = bl;
+    m->encode_features = features;
 
     if (req) {
       mon->send_reply(req, m);
@@ -2966,7 +3002,7 @@ void OSDMonitor::send_incremental(epoch_t first,
   while (first <= osdmap.get_epoch()) {
     epoch_t last = MIN(first + g_conf->osd_map_message_max - 1,
 		       osdmap.get_epoch());
-    MOSDMap *m = build_incremental(first, last);
+    MOSDMap *m = build_incremental(first, last, features);
 
     if (req) {
       // send some maps.  it may not be all of them, but it will get them
@@ -3006,6 +3042,39 @@ int OSDMonitor::get_version_full(version_t ver, bufferlist& bl)
     return ret;
 }
 
+int OSDMonitor::get_version(version_t ver, uint64_t features, bufferlist& bl)
+{
+  if (!MOSDMap::need_reencode(features))
+    return get_version(ver, bl);
+  legacy_map_key_t key(ver, features);
+  if (inc_osd_legacy_cache.lookup(key, &bl)) {
+    return 0;
+  }
+  int ret = get_version(ver, bl);
+  if (!ret) {
+    MOSDMap::reencode_incremental(bl, features);
+    inc_osd_legacy_cache.add(key, bl);
+  }
+  return ret;
+}
+
+int OSDMonitor::get_version_full(version_t ver, uint64_t features,
+				 bufferlist& bl)
+{
+  if (!MOSDMap::need_reencode(features))
+    return get_version_full(ver, bl);
+  legacy_map_key_t key(ver, features);
+  if (full_osd_legacy_cache.lookup(key, &bl)) {
+    return 0;
+  }
+  int ret = get_version_full(ver, bl);
+  if (!ret) {
+    MOSDMap::reencode_full(bl, features);
+    full_osd_legacy_cache.add(key, bl);
+  }
+  return ret;
+}
+
 epoch_t OSDMonitor::blacklist(const entity_addr_t& a, utime_t until)
 {
   dout(10) << "blacklist " << a << " until " << until << dendl;
@@ -3040,7 +3109,8 @@ void OSDMonitor::check_osdmap_sub(Subscription *sub)
     if (sub->next >= 1)
       send_incremental(sub->next, sub->session, sub->incremental_onetime);
     else
-      sub->session->con->send_message(build_latest_full());
+      sub->session->con->send_message(
+        build_latest_full(map_encode_features(sub->session)));
     if (sub->onetime)
       mon->session_map.remove_sub(sub);
     else
@@ -3439,7 +3509,7 @@ namespace {
     RECOVERY_PRIORITY, RECOVERY_OP_PRIORITY, SCRUB_PRIORITY,
     COMPRESSION_MODE, COMPRESSION_ALGORITHM, COMPRESSION_REQUIRED_RATIO,
     COMPRESSION_MAX_BLOB_SIZE, COMPRESSION_MIN_BLOB_SIZE,
-    CSUM_TYPE, CSUM_MAX_BLOCK, CSUM_MIN_BLOCK };
+    CSUM_TYPE, CSUM_MAX_BLOCK, CSUM_MIN_BLOCK, COMPRESSION_DICTIONARY };
 
   std::set<osd_pool_get_choices>
     subtract_second_from_first(const std::set<osd_pool_get_choices>& first,
@@ -4048,6 +4118,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
       {"csum_type", CSUM_TYPE},
       {"csum_max_block", CSUM_MAX_BLOCK},
       {"csum_min_block", CSUM_MIN_BLOCK},
+      {"compression_dictionary", COMPRESSION_DICTIONARY},
     };
 
     typedef std::set<osd_pool_get_choices> choices_set_t;
@@ -4250,6 +4321,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case CSUM_TYPE:
 	  case CSUM_MAX_BLOCK:
 	  case CSUM_MIN_BLOCK:
+	  case COMPRESSION_DICTIONARY:
             pool_opts_t::key_t key = pool_opts_t::get_opt_desc(i->first).key;
             if (p->opts.is_set(key)) {
               f->open_object_section("pool");
@@ -4404,6 +4476,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case CSUM_TYPE:
 	  case CSUM_MAX_BLOCK:
 	  case CSUM_MIN_BLOCK:
+	  case COMPRESSION_DICTIONARY:
 	    for (i = ALL_CHOICES.begin(); i != ALL_CHOICES.end(); ++i) {
 	      if (i->second == *it)
 		break;
@@ -5991,6 +6064,32 @@ int OSDMonitor::prepare_command_pool_set(map<string,cmd_vartype> &cmdmap,
 	  return -EINVAL;
         }
       }
+    } else if (var == "compression_dictionary") {
+      // a comma separated list of base64 encoded dictionaries: the
+      // current one first, then the ones still needed to read old data
+      if (!unset) {
+        CompressorRef c = Compressor::create(cct, "zstd");
+        vector<string> encoded;
+        get_str_vec(val, ",", encoded);
+        if (encoded.empty()) {
+          ss << "compression_dictionary is empty";
+          return -EINVAL;
+        }
+        for (auto& e : encoded) {
+          bufferlist in, dict;
+          in.append(e);
+          try {
+            dict.decode_base64(in);
+          } catch (buffer::error& err) {
+            ss << "compression_dictionary must be base64 encoded";
+            return -EINVAL;
+          }
+          if (!c || !c->with_dictionary(dict)) {
+            ss << "compression_dictionary is not a valid zstd dictionary";
+            return -EINVAL;
+          }
+        }
+      }
     } else if (var == "compression_required_ratio") {
       if (floaterr.length()) {
         ss << "error parsing float value '" << val << "': " << floaterr;
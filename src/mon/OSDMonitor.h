@@ -23,6 +23,7 @@
 
 #include <map>
 #include <set>
+#include <boost/functional/hash.hpp>
 using namespace std;
 
 #include "include/types.h"
@@ -143,6 +144,14 @@ public:
   SimpleLRU<version_t, bufferlist> inc_osd_cache;
   SimpleLRU<version_t, bufferlist> full_osd_cache;
 
+  // maps reencoded for legacy peers, keyed on (epoch, features), so
+  // that many sessions with the same feature set share one encoding
+  typedef pair<version_t, uint64_t> legacy_map_key_t;
+  SimpleLRU<legacy_map_key_t, bufferlist, std::less<legacy_map_key_t>,
+	    boost::hash<legacy_map_key_t>> inc_osd_legacy_cache;
+  SimpleLRU<legacy_map_key_t, bufferlist, std::less<legacy_map_key_t>,
+	    boost::hash<legacy_map_key_t>> full_osd_legacy_cache;
+
   bool check_failures(utime_t now);
   bool check_failure(utime_t now, int target_osd, failure_info_t& fi);
   void force_failure(int target_osd, int by);
@@ -150,6 +159,12 @@ public:
   // the time of last msg(MSG_ALIVE and MSG_PGTEMP) proposed without delay
   utime_t last_attempted_minwait_time;
 
+  // OSDMap::check_health() result for osdmap epoch health_cache_epoch,
+  // reused while incrementals leave its inputs untouched
+  health_check_map_t health_cache;
+  epoch_t health_cache_epoch = 0;
+  string health_cache_conf;
+
   bool _have_pending_crush();
   CrushWrapper &_get_stable_crush();
   void _get_pending_crush(CrushWrapper& newcrush);
@@ -244,8 +259,9 @@ private:
   bool can_mark_in(int o);
 
   // ...
-  MOSDMap *build_latest_full();
-  MOSDMap *build_incremental(epoch_t first, epoch_t last);
+  MOSDMap *build_latest_full(uint64_t features = 0);
+  MOSDMap *build_incremental(epoch_t first, epoch_t last,
+			     uint64_t features = 0);
   void send_full(MonOpRequestRef op);
   void send_incremental(MonOpRequestRef op, epoch_t first);
 public:
@@ -529,6 +545,9 @@ public:
 
   int get_version(version_t ver, bufferlist& bl) override;
   int get_version_full(version_t ver, bufferlist& bl) override;
+  // as above, but encoded for a peer with the given features
+  int get_version(version_t ver, uint64_t features, bufferlist& bl);
+  int get_version_full(version_t ver, uint64_t features, bufferlist& bl);
 
   epoch_t blacklist(const entity_addr_t& a, utime_t until);
 
@@ -1036,11 +1036,19 @@ void PGMap::apply_incremental(CephContext *cct, const Incremental& inc)
     auto t = pg_stat.find(update_pg);
     if (t == pg_stat.end()) {
       pg_stat.insert(make_pair(update_pg, update_stat));
+      stat_pg_add(update_pg, update_stat);
     } else {
-      stat_pg_sub(update_pg, t->second);
+      // most updates only carry new counters; when the mapping and
+      // blockers are unchanged, leave the per-osd indexes alone.
+      bool sameosds =
+	t->second.acting == update_stat.acting &&
+	t->second.up == update_stat.up &&
+	t->second.up_primary == update_stat.up_primary &&
+	t->second.blocked_by == update_stat.blocked_by;
+      stat_pg_sub(update_pg, t->second, sameosds);
       t->second = update_stat;
+      stat_pg_add(update_pg, update_stat, sameosds);
     }
-    stat_pg_add(update_pg, update_stat);
   }
   for (auto p = inc.get_osd_stat_updates().begin();
        p != inc.get_osd_stat_updates().end();
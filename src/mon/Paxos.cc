@@ -124,6 +124,10 @@ void Paxos::init_logger()
   pcb.add_u64_avg(l_paxos_share_state_bytes, "share_state_bytes", "Data in shared state");
   pcb.add_u64_counter(l_paxos_new_pn, "new_pn", "New proposal number queries");
   pcb.add_time_avg(l_paxos_new_pn_latency, "new_pn_latency", "New proposal number getting latency");
+  pcb.add_time_avg(l_paxos_round_latency, "round_latency",
+      "Latency of a full proposal round on the leader");
+  pcb.add_u64_avg(l_paxos_round_proposals, "round_proposals",
+      "Queued proposals batched into one round");
   logger = pcb.create_perf_counters();
   g_ceph_context->get_perfcounters_collection()->add(logger);
 }
@@ -1080,6 +1084,11 @@ void Paxos::finish_round()
   
   dout(10) << __func__ << " done w/ waiters, state " << get_statename(state) << dendl;
 
+  if (round_start_stamp != utime_t()) {
+    logger->tinc(l_paxos_round_latency, ceph_clock_now() - round_start_stamp);
+    round_start_stamp = utime_t();
+  }
+
   if (should_trim()) {
     trim();
   }
@@ -1342,6 +1351,7 @@ void Paxos::leader_init()
 
   // discard pending transaction
   pending_proposal.reset();
+  round_start_stamp = utime_t();
 
   finish_contexts(g_ceph_context, pending_finishers, -EAGAIN);
   finish_contexts(g_ceph_context, committing_finishers, -EAGAIN);
@@ -1399,6 +1409,7 @@ void Paxos::restart()
 
   // discard pending transaction
   pending_proposal.reset();
+  round_start_stamp = utime_t();
 
   finish_contexts(g_ceph_context, committing_finishers, -EAGAIN);
   finish_contexts(g_ceph_context, pending_finishers, -EAGAIN);
@@ -1539,6 +1550,9 @@ void Paxos::propose_pending()
 
   pending_proposal.reset();
 
+  logger->inc(l_paxos_round_proposals, pending_finishers.size());
+  round_start_stamp = ceph_clock_now();
+
   committing_finishers.swap(pending_finishers);
   state = STATE_UPDATING;
   begin(bl);
@@ -156,6 +156,8 @@ enum {
   l_paxos_share_state_bytes,
   l_paxos_new_pn,
   l_paxos_new_pn_latency,
+  l_paxos_round_latency,
+  l_paxos_round_proposals,
   l_paxos_last,
 };
 
@@ -864,6 +866,11 @@ private:
 
 
   utime_t commit_start_stamp;
+  /**
+   * When the value currently being proposed left propose_pending(); used
+   * to account the whole begin/accept/commit/refresh round.
+   */
+  utime_t round_start_stamp;
   friend struct C_Committed;
 
   /**
@@ -195,6 +195,10 @@ using namespace std;
 
 #define dout_subsys ceph_subsys_ms
 
+// the most frequent message on an OSD; account for it (and OpRequest)
+// in the osd_op mempool
+MEMPOOL_DEFINE_OBJECT_FACTORY(MOSDOp, mosdop, osd_op);
+
 void Message::encode(uint64_t features, int crcflags)
 {
   // encode and copy out of *m
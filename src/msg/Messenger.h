@@ -513,6 +513,19 @@ public:
    * @param dest The entity to get a connection for.
    */
   virtual ConnectionRef get_connection(const entity_inst_t& dest) = 0;
+  /**
+   * Get one of several parallel Connections to an entity. Messages
+   * passed with the same hash always use the same Connection, so they
+   * stay ordered relative to each other. Implementations without
+   * multiple sessions per peer just return get_connection(dest).
+   *
+   * @param dest The entity to get a connection for.
+   * @param hash Selects the connection, e.g. a hash of the pg.
+   */
+  virtual ConnectionRef get_connection_lane(const entity_inst_t& dest,
+					    uint32_t hash) {
+    return get_connection(dest);
+  }
   /**
    * Get the Connection object associated with ourselves.
    */
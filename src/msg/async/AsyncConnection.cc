@@ -124,7 +124,7 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
   : Connection(cct, m), delay_state(NULL), async_msgr(m), conn_id(q->get_id()),
     logger(w->get_perf_counter()), global_seq(0), connect_seq(0), peer_global_seq(0),
     state(STATE_NONE), state_after_send(STATE_NONE), port(-1),
-    dispatch_queue(q), can_write(WriteStatus::NOWRITE),
+    dispatch_queue(q), crcflags(m->crcflags), can_write(WriteStatus::NOWRITE),
     keepalive(false), recv_buf(NULL),
     recv_max_prefetch(MAX(msgr->cct->_conf->ms_tcp_prefetch_max_size, TCP_PREFETCH_MIN_SIZE)),
     recv_start(0), recv_end(0),
@@ -146,6 +146,8 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
 
 AsyncConnection::~AsyncConnection()
 {
+  // messages may still race in after the connection was closed
+  _discard_pending_out();
   assert(out_q.empty());
   assert(sent.empty());
   delete authorizer;
@@ -657,9 +659,23 @@ void AsyncConnection::process()
             goto fail;
           }
 
+          if (secure && decrypt_segments() < 0) {
+            ldout(async_msgr->cct, 0) << __func__ << " failed to decrypt message seq "
+                                      << current_header.seq << dendl;
+            goto fail;
+          }
+
           ldout(async_msgr->cct, 20) << __func__ << " got " << front.length() << " + " << middle.length()
                               << " + " << data.length() << " byte message" << dendl;
-          Message *message = decode_message(async_msgr->cct, async_msgr->crcflags, current_header, footer,
+          int flags = crcflags;
+          if (flags & MSG_CRC_HEADER)
+            logger->inc(l_msgr_crc_bytes, front.length() + middle.length());
+          if ((flags & MSG_CRC_DATA) &&
+              !(footer.flags & CEPH_MSG_FOOTER_NOCRC))
+            logger->inc(l_msgr_crc_bytes, data.length());
+          else
+            logger->inc(l_msgr_crc_skipped_bytes, data.length());
+          Message *message = decode_message(async_msgr->cct, flags, current_header, footer,
                                             front, middle, data, this);
           if (!message) {
             ldout(async_msgr->cct, 1) << __func__ << " decode message failed " << dendl;
@@ -740,6 +756,8 @@ void AsyncConnection::process()
 
           logger->inc(l_msgr_recv_messages);
           logger->inc(l_msgr_recv_bytes, cur_msg_size + sizeof(ceph_msg_header) + sizeof(ceph_msg_footer));
+          if (lane)
+            logger->inc(l_msgr_recv_lane_bytes, cur_msg_size + sizeof(ceph_msg_header) + sizeof(ceph_msg_footer));
 
           async_msgr->ms_fast_preprocess(message);
           auto fast_dispatch_time = ceph::mono_clock::now();
@@ -1010,6 +1028,9 @@ ssize_t AsyncConnection::_process_connection()
         connect_msg.flags = 0;
         if (policy.lossy)
           connect_msg.flags |= CEPH_MSG_CONNECT_LOSSY;  // this is fyi, actually, server decides!
+        connect_msg.flags |= lane << CEPH_MSG_CONNECT_LANE_SHIFT;
+        if (async_msgr->cct->_conf->get_val<bool>("ms_secure_mode"))
+          connect_msg.flags |= CEPH_MSG_CONNECT_SECURE;
         bl.append((char*)&connect_msg, sizeof(connect_msg));
         if (authorizer) {
           bl.append(authorizer->bl.c_str(), authorizer->bl.length());
@@ -1157,6 +1178,14 @@ ssize_t AsyncConnection::_process_connection()
           session_security.reset();
         }
 
+        secure = connect_reply.flags & CEPH_MSG_CONNECT_SECURE;
+        if (!secure && (connect_msg.flags & CEPH_MSG_CONNECT_SECURE) &&
+            session_security && session_security->can_encrypt_segments()) {
+          // don't silently fall back to plaintext
+          ldout(async_msgr->cct, 0) << __func__ << " peer refused secure mode" << dendl;
+          goto fail;
+        }
+
         if (delay_state)
           assert(delay_state->ready());
         dispatch_queue->queue_connect(this);
@@ -1244,6 +1273,7 @@ ssize_t AsyncConnection::_process_connection()
                              << " (socket is " << socket_addr << ")" << dendl;
         }
         set_peer_addr(peer_addr);  // so that connection_state gets set up
+        update_crcflags();
         state = STATE_ACCEPTING_WAIT_CONNECT_MSG;
         break;
       }
@@ -1487,8 +1517,9 @@ ssize_t AsyncConnection::handle_connect_msg(ceph_msg_connect &connect, bufferlis
   // We've verified the authorizer for this AsyncConnection, so set up the session security structure.  PLR
   ldout(async_msgr->cct, 10) << __func__ << " accept setting up session_security." << dendl;
 
-  // existing?
-  AsyncConnectionRef existing = async_msgr->lookup_conn(peer_addr);
+  // existing?  each lane is its own session with the peer
+  lane = connect.flags >> CEPH_MSG_CONNECT_LANE_SHIFT;
+  AsyncConnectionRef existing = async_msgr->lookup_conn(peer_addr, lane);
 
   inject_delay();
 
@@ -1779,6 +1810,11 @@ ssize_t AsyncConnection::handle_connect_msg(ceph_msg_connect &connect, bufferlis
       get_auth_session_handler(async_msgr->cct, connect.authorizer_protocol,
                                session_key, get_features()));
 
+  secure = (connect.flags & CEPH_MSG_CONNECT_SECURE) && session_security &&
+           session_security->can_encrypt_segments();
+  if (secure)
+    reply.flags = reply.flags | CEPH_MSG_CONNECT_SECURE;
+
   reply_bl.append((char*)&reply, sizeof(reply));
 
   if (reply.authorizer_len)
@@ -1909,34 +1945,90 @@ int AsyncConnection::send_message(Message *m)
   if (can_fast_prepare)
     prepare_send_message(f, m, bl);
 
-  std::lock_guard<std::mutex> l(write_lock);
-  // "features" changes will change the payload encoding
-  if (can_fast_prepare && (can_write == WriteStatus::NOWRITE || get_features() != f)) {
-    // ensure the correctness of message encoding
-    bl.clear();
-    m->get_payload().clear();
-    ldout(async_msgr->cct, 5) << __func__ << " clear encoded buffer previous "
-                              << f << " != " << get_features() << dendl;
-  }
-  if (can_write == WriteStatus::CLOSED) {
+  WriteStatus status = can_write.load();
+  if (status == WriteStatus::CLOSED) {
     ldout(async_msgr->cct, 10) << __func__ << " connection closed."
                                << " Drop message " << m << dendl;
     m->put();
   } else {
     m->trace.event("async enqueueing message");
-    out_q[m->get_priority()].emplace_back(std::move(bl), m);
+    if (can_fast_prepare && status == WriteStatus::NOWRITE) {
+      // features are not settled before the connection is established
+      bl.clear();
+      m->get_payload().clear();
+    }
+    // otherwise the encoding is checked against the connection features
+    // once the message reaches out_q (see _splice_pending_out)
+    pending_msg_t *p = new pending_msg_t;
+    p->m = m;
+    p->bl.swap(bl);
+    p->features = f;
+    p->next = pending_out.load(std::memory_order_relaxed);
+    while (!pending_out.compare_exchange_weak(p->next, p,
+					      std::memory_order_release,
+					      std::memory_order_relaxed))
+      ;
     ldout(async_msgr->cct, 15) << __func__ << " inline write is denied, reschedule m=" << m << dendl;
-    if (can_write != WriteStatus::REPLACING)
+    // a write event that has not run yet will pick this message up too
+    if (status != WriteStatus::REPLACING &&
+	!write_event_pending.exchange(true))
       center->dispatch_event_external(write_handler);
   }
   return 0;
 }
 
+/*
+ * Moves messages queued by send_message into out_q.
+ * Must hold write_lock prior to calling.
+ */
+void AsyncConnection::_splice_pending_out()
+{
+  if (!pending_out.load(std::memory_order_relaxed))
+    return;
+  pending_msg_t *p = pending_out.exchange(nullptr, std::memory_order_acquire);
+  // reverse into arrival order
+  pending_msg_t *head = nullptr;
+  while (p) {
+    pending_msg_t *next = p->next;
+    p->next = head;
+    head = p;
+    p = next;
+  }
+  uint64_t features = get_features();
+  while (head) {
+    p = head;
+    head = head->next;
+    // "features" changes will change the payload encoding
+    if (p->bl.length() && p->features != features) {
+      // ensure the correctness of message encoding
+      p->bl.clear();
+      p->m->get_payload().clear();
+      ldout(async_msgr->cct, 5) << __func__ << " clear encoded buffer previous "
+                                << p->features << " != " << features << dendl;
+    }
+    out_q[p->m->get_priority()].emplace_back(std::move(p->bl), p->m);
+    delete p;
+  }
+}
+
+void AsyncConnection::_discard_pending_out()
+{
+  pending_msg_t *p = pending_out.exchange(nullptr, std::memory_order_acquire);
+  while (p) {
+    pending_msg_t *next = p->next;
+    ldout(async_msgr->cct, 20) << __func__ << " discard " << p->m << dendl;
+    p->m->put();
+    delete p;
+    p = next;
+  }
+}
+
 void AsyncConnection::requeue_sent()
 {
   if (sent.empty())
     return;
 
+  _splice_pending_out();
   list<pair<bufferlist, Message*> >& rq = out_q[CEPH_MSG_PRIO_HIGHEST];
   out_seq -= sent.size();
   while (!sent.empty()) {
@@ -1982,6 +2074,7 @@ void AsyncConnection::discard_out_queue()
     (*p)->put();
   }
   sent.clear();
+  _discard_pending_out();
   for (map<int, list<pair<bufferlist, Message*> > >::iterator p = out_q.begin(); p != out_q.end(); ++p)
     for (list<pair<bufferlist, Message*> >::iterator r = p->second.begin(); r != p->second.end(); ++r) {
       ldout(async_msgr->cct, 20) << __func__ << " discard " << r->second << dendl;
@@ -2145,19 +2238,90 @@ void AsyncConnection::prepare_send_message(uint64_t features, Message *m, buffer
                                << features << " " << m << " " << *m << dendl;
 
   // encode and copy out of *m
-  m->encode(features, msgr->crcflags);
+  int flags = crcflags;
+  m->encode(features, flags);
+  if (flags & MSG_CRC_HEADER)
+    logger->inc(l_msgr_crc_bytes,
+		m->get_payload().length() + m->get_middle().length());
+  if (flags & MSG_CRC_DATA)
+    logger->inc(l_msgr_crc_bytes, m->get_data().length());
+  else
+    logger->inc(l_msgr_crc_skipped_bytes, m->get_data().length());
 
   bl.append(m->get_payload());
   bl.append(m->get_middle());
   bl.append(m->get_data());
 }
 
+// Replace the plaintext segments in bl with their ciphertext and
+// advertise the wire lengths in the header. The footer crcs keep
+// covering the plaintext and are checked after decryption. m's own
+// payload is left alone so a requeued message encodes afresh.
+int AsyncConnection::encrypt_segments(Message *m, bufferlist& bl)
+{
+  ceph_msg_header& header = m->get_header();
+  assert(bl.length() == header.front_len + header.middle_len + header.data_len);
+  uint32_t lens[3] = {header.front_len, header.middle_len, header.data_len};
+  unsigned off = 0;
+  bufferlist out;
+  for (unsigned i = 0; i < 3; ++i) {
+    if (!lens[i])
+      continue;
+    bufferlist in, enc;
+    in.substr_of(bl, off, lens[i]);
+    off += lens[i];
+    int r = session_security->encrypt_segment(i, in, enc);
+    if (r < 0) {
+      ldout(async_msgr->cct, 1) << __func__ << " failed to encrypt segment "
+                                << i << " of " << *m << dendl;
+      return r;
+    }
+    lens[i] = enc.length();
+    out.claim_append(enc);
+  }
+  header.front_len = lens[0];
+  header.middle_len = lens[1];
+  header.data_len = lens[2];
+  bl.swap(out);
+  return 0;
+}
+
+// Inverse of encrypt_segments on the message being read. The header
+// lengths are patched back to plaintext but header.crc is left as
+// sent, since the signature covers it.
+int AsyncConnection::decrypt_segments()
+{
+  bufferlist *segs[3] = {&front, &middle, &data};
+  for (unsigned i = 0; i < 3; ++i) {
+    if (!segs[i]->length())
+      continue;
+    bufferlist plain;
+    int r = session_security->decrypt_segment(i, *segs[i], plain);
+    if (r < 0)
+      return r;
+    segs[i]->swap(plain);
+  }
+  current_header.front_len = front.length();
+  current_header.middle_len = middle.length();
+  current_header.data_len = data.length();
+  return 0;
+}
+
 ssize_t AsyncConnection::write_message(Message *m, bufferlist& bl, bool more)
 {
   FUNCTRACE();
   assert(center->in_thread());
   m->set_seq(++out_seq);
 
+  // bl stays plaintext until here so that prepare_send_message can run
+  // outside the connection thread; the nonce sequence lives in
+  // session_security, which is only touched from it
+  if (secure) {
+    int r = encrypt_segments(m, bl);
+    if (r < 0)
+      return r;
+  }
+
   if (msgr->crcflags & MSG_CRC_HEADER)
     m->calc_header_crc();
 
@@ -2204,13 +2368,28 @@ ssize_t AsyncConnection::write_message(Message *m, bufferlist& bl, bool more)
   m->trace.event("async writing message");
   ldout(async_msgr->cct, 20) << __func__ << " sending " << m->get_seq()
                              << " " << m << dendl;
+  ++outcoming_msgs;
+  ssize_t rc = 0;
+  if (more &&
+      outcoming_bl.length() < async_msgr->cct->_conf->ms_async_coalesce_max_bytes) {
+    // more messages are queued; encode them into outcoming_bl too and
+    // hand the whole batch to the socket at once
+    ldout(async_msgr->cct, 20) << __func__ << " coalescing " << m << ", "
+                               << outcoming_bl.length() << " bytes pending" << dendl;
+    m->put();
+    return 0;
+  }
   ssize_t total_send_size = outcoming_bl.length();
-  ssize_t rc = _try_send(more);
+  rc = _try_send(more);
   if (rc < 0) {
     ldout(async_msgr->cct, 1) << __func__ << " error sending " << m << ", "
                               << cpp_strerror(rc) << dendl;
   } else {
     logger->inc(l_msgr_send_bytes, total_send_size - outcoming_bl.length());
+    if (lane)
+      logger->inc(l_msgr_send_lane_bytes, total_send_size - outcoming_bl.length());
+    logger->inc(l_msgr_send_messages_per_write, outcoming_msgs);
+    outcoming_msgs = 0;
     ldout(async_msgr->cct, 10) << __func__ << " sending " << m << (rc ? " continuely." :" done.") << dendl;
   }
   if (m->get_type() == CEPH_MSG_OSD_OP)
@@ -2222,6 +2401,14 @@ ssize_t AsyncConnection::write_message(Message *m, bufferlist& bl, bool more)
   return rc;
 }
 
+void AsyncConnection::update_crcflags()
+{
+  crcflags = async_msgr->get_peer_crcflags(get_peer_addr());
+  if (crcflags != async_msgr->crcflags)
+    ldout(async_msgr->cct, 10) << __func__ << " not checking data crc for "
+                               << get_peer_addr() << dendl;
+}
+
 void AsyncConnection::reset_recv_state()
 {
   // clean up state internal variables and states
@@ -2359,6 +2546,9 @@ void AsyncConnection::handle_write()
   ldout(async_msgr->cct, 10) << __func__ << dendl;
   ssize_t r = 0;
 
+  // anything sent from here on needs a new event
+  write_event_pending = false;
+
   write_lock.lock();
   if (can_write == WriteStatus::CANWRITE) {
     if (keepalive) {
@@ -2412,7 +2602,18 @@ void AsyncConnection::handle_write()
 	left = ack_left;
 	r = _try_send(left);
       } else if (is_queued()) {
+	// flushes anything write_message left coalesced in outcoming_bl
+	ssize_t total_send_size = outcoming_bl.length();
 	r = _try_send();
+	if (r >= 0) {
+	  logger->inc(l_msgr_send_bytes, total_send_size - outcoming_bl.length());
+	  if (lane)
+	    logger->inc(l_msgr_send_lane_bytes, total_send_size - outcoming_bl.length());
+	}
+      }
+      if (r >= 0 && outcoming_msgs) {
+	logger->inc(l_msgr_send_messages_per_write, outcoming_msgs);
+	outcoming_msgs = 0;
       }
     }
 
@@ -74,6 +74,8 @@ class AsyncConnection : public Connection {
   void handle_ack(uint64_t seq);
   void _append_keepalive_or_ack(bool ack=false, utime_t *t=NULL);
   ssize_t write_message(Message *m, bufferlist& bl, bool more);
+  int encrypt_segments(Message *m, bufferlist& bl);
+  int decrypt_segments();
   void inject_delay();
   ssize_t _reply_accept(char tag, ceph_msg_connect &connect, ceph_msg_connect_reply &reply,
                     bufferlist &authorizer_reply) {
@@ -95,7 +97,7 @@ class AsyncConnection : public Connection {
     return 0;
   }
   bool is_queued() const {
-    return !out_q.empty() || outcoming_bl.length();
+    return !out_q.empty() || pending_out.load() || outcoming_bl.length();
   }
   void shutdown_socket() {
     for (auto &&t : register_time_events)
@@ -113,6 +115,7 @@ class AsyncConnection : public Connection {
   }
   Message *_get_next_outgoing(bufferlist *bl) {
     Message *m = 0;
+    _splice_pending_out();
     if (!out_q.empty()) {
       map<int, list<pair<bufferlist, Message*> > >::reverse_iterator it = out_q.rbegin();
       assert(!it->second.empty());
@@ -127,8 +130,10 @@ class AsyncConnection : public Connection {
     return m;
   }
   bool _has_next_outgoing() const {
-    return !out_q.empty();
+    return !out_q.empty() || pending_out.load();
   }
+  void _splice_pending_out();
+  void _discard_pending_out();
   void reset_recv_state();
 
    /**
@@ -198,6 +203,7 @@ class AsyncConnection : public Connection {
   void connect(const entity_addr_t& addr, int type) {
     set_peer_type(type);
     set_peer_addr(addr);
+    update_crcflags();
     policy = msgr->get_policy(type);
     _connect();
   }
@@ -304,6 +310,11 @@ class AsyncConnection : public Connection {
 
   // lockfree, only used in own thread
   bufferlist outcoming_bl;
+  unsigned outcoming_msgs = 0;  ///< messages encoded since the last send
+
+  /// msgr->crcflags as it applies to this peer (see update_crcflags)
+  std::atomic<int> crcflags;
+  void update_crcflags();
   bool open_write = false;
 
   std::mutex write_lock;
@@ -316,6 +327,18 @@ class AsyncConnection : public Connection {
   std::atomic<WriteStatus> can_write;
   list<Message*> sent; // the first bufferlist need to inject seq
   map<int, list<pair<bufferlist, Message*> > > out_q;  // priority queue for outbound msgs
+  // send_message pushes onto pending_out (a lock-free stack, newest first)
+  // without taking write_lock; _splice_pending_out moves the entries into
+  // out_q in arrival order, under write_lock.
+  struct pending_msg_t {
+    pending_msg_t *next;
+    Message *m;
+    bufferlist bl;
+    uint64_t features;  // features bl was encoded with
+  };
+  std::atomic<pending_msg_t*> pending_out{nullptr};
+  // set while a write_handler event queued by send_message has not run yet
+  std::atomic<bool> write_event_pending{false};
   bool keepalive;
 
   std::mutex lock;
@@ -369,6 +392,9 @@ class AsyncConnection : public Connection {
   Worker *worker;
   EventCenter *center;
   ceph::shared_ptr<AuthSessionHandler> session_security;
+  // negotiated CEPH_MSG_CONNECT_SECURE: front/middle/data travel
+  // encrypted by session_security, header and footer stay in the clear
+  bool secure = false;
 
  public:
   // used by eventcallback
@@ -399,6 +425,10 @@ class AsyncConnection : public Connection {
   PerfCounters *get_perf_counter() {
     return logger;
   }
+
+  /// which of the parallel sessions to peer_addr this is; 0 for the
+  /// primary one (see AsyncMessenger::get_connection_lane)
+  unsigned lane = 0;
 }; /* AsyncConnection */
 
 typedef boost::intrusive_ptr<AsyncConnection> AsyncConnectionRef;
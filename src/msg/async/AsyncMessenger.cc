@@ -28,6 +28,8 @@
 #include "messages/MOSDOp.h"
 #include "messages/MOSDOpReply.h"
 #include "common/EventTrace.h"
+#include "include/ipaddr.h"
+#include "include/str_list.h"
 
 #define dout_subsys ceph_subsys_ms
 #undef dout_prefix
@@ -271,6 +273,31 @@ AsyncMessenger::AsyncMessenger(CephContext *cct, entity_name_t name,
     processor_num = stack->get_num_worker();
   for (unsigned i = 0; i < processor_num; ++i)
     processors.push_back(new Processor(this, stack->get_worker(i), cct));
+
+  list<string> networks;
+  get_str_list(cct->_conf->get_val<std::string>("ms_crc_data_trusted_networks"),
+	       networks);
+  for (auto& n : networks) {
+    sockaddr_storage net;
+    unsigned prefix_len;
+    if (!parse_network(n.c_str(), &net, &prefix_len)) {
+      lderr(cct) << __func__ << " failed to parse network " << n
+		 << " in ms_crc_data_trusted_networks" << dendl;
+      continue;
+    }
+    crc_trusted_networks.push_back(make_pair(net, prefix_len));
+  }
+}
+
+int AsyncMessenger::get_peer_crcflags(const entity_addr_t& peer) const
+{
+  if (!(crcflags & MSG_CRC_DATA))
+    return crcflags;
+  for (auto& n : crc_trusted_networks) {
+    if (network_contains(n.first, n.second, peer.get_sockaddr()))
+      return crcflags & ~MSG_CRC_DATA;
+  }
+  return crcflags;
 }
 
 /**
@@ -507,20 +534,27 @@ void AsyncMessenger::add_accept(Worker *w, ConnectedSocket cli_socket, entity_ad
   lock.Unlock();
 }
 
-AsyncConnectionRef AsyncMessenger::create_connect(const entity_addr_t& addr, int type)
+AsyncConnectionRef AsyncMessenger::create_connect(const entity_addr_t& addr, int type,
+						   unsigned lane)
 {
   assert(lock.is_locked());
   assert(addr != my_inst.addr);
 
-  ldout(cct, 10) << __func__ << " " << addr
+  ldout(cct, 10) << __func__ << " " << addr << " lane " << lane
       << ", creating connection and registering" << dendl;
 
   // create connection
   Worker *w = stack->get_worker();
   AsyncConnectionRef conn = new AsyncConnection(cct, this, &dispatch_queue, w);
+  conn->lane = lane;
   conn->connect(addr, type);
-  assert(!conns.count(addr));
-  conns[addr] = conn;
+  if (lane) {
+    assert(!lane_conns.count(make_pair(addr, lane)));
+    lane_conns[make_pair(addr, lane)] = conn;
+  } else {
+    assert(!conns.count(addr));
+    conns[addr] = conn;
+  }
   w->get_perf_counter()->inc(l_msgr_active_connections);
 
   return conn;
@@ -545,6 +579,33 @@ ConnectionRef AsyncMessenger::get_connection(const entity_inst_t& dest)
   return conn;
 }
 
+ConnectionRef AsyncMessenger::get_connection_lane(const entity_inst_t& dest,
+						  uint32_t hash)
+{
+  unsigned lanes = cct->_conf->ms_async_peer_lanes;
+  if (lanes <= 1)
+    return get_connection(dest);
+
+  unsigned lane = hash % lanes;
+  Mutex::Locker l(lock);
+  if (my_inst.addr == dest.addr) {
+    // local
+    return local_connection;
+  }
+
+  AsyncConnectionRef conn = _lookup_conn(dest.addr, lane);
+  if (conn) {
+    ldout(cct, 20) << __func__ << " " << dest << " lane " << lane
+		   << " existing " << conn << dendl;
+  } else {
+    conn = create_connect(dest.addr, dest.name.type(), lane);
+    ldout(cct, 10) << __func__ << " " << dest << " lane " << lane
+		   << " new " << conn << dendl;
+  }
+
+  return conn;
+}
+
 ConnectionRef AsyncMessenger::get_loopback_connection()
 {
   return local_connection;
@@ -663,6 +724,16 @@ void AsyncMessenger::shutdown_connections(bool queue_reset)
     p->stop(queue_reset);
   }
 
+  while (!lane_conns.empty()) {
+    auto it = lane_conns.begin();
+    AsyncConnectionRef p = it->second;
+    ldout(cct, 5) << __func__ << " mark down " << it->first.first
+		  << " lane " << it->first.second << " " << p << dendl;
+    lane_conns.erase(it);
+    p->get_perf_counter()->dec(l_msgr_active_connections);
+    p->stop(queue_reset);
+  }
+
   {
     Mutex::Locker l(deleted_lock);
     while (!deleted_conns.empty()) {
@@ -685,6 +756,19 @@ void AsyncMessenger::mark_down(const entity_addr_t& addr)
   } else {
     ldout(cct, 1) << __func__ << " " << addr << " -- connection dne" << dendl;
   }
+  // the other lanes to this peer go down with it
+  vector<unsigned> lanes;
+  for (auto it = lane_conns.lower_bound(make_pair(addr, 0u));
+       it != lane_conns.end() && it->first.first == addr; ++it)
+    lanes.push_back(it->first.second);
+  for (auto lane : lanes) {
+    p = _lookup_conn(addr, lane);
+    if (p) {
+      ldout(cct, 1) << __func__ << " " << addr << " lane " << lane
+		    << " -- " << p << dendl;
+      p->stop(true);
+    }
+  }
   lock.Unlock();
 }
 
@@ -742,9 +826,15 @@ int AsyncMessenger::reap_dead()
     auto it = deleted_conns.begin();
     AsyncConnectionRef p = *it;
     ldout(cct, 5) << __func__ << " delete " << p << dendl;
-    auto conns_it = conns.find(p->peer_addr);
-    if (conns_it != conns.end() && conns_it->second == p)
-      conns.erase(conns_it);
+    if (p->lane) {
+      auto lane_it = lane_conns.find(make_pair(p->peer_addr, p->lane));
+      if (lane_it != lane_conns.end() && lane_it->second == p)
+        lane_conns.erase(lane_it);
+    } else {
+      auto conns_it = conns.find(p->peer_addr);
+      if (conns_it != conns.end() && conns_it->second == p)
+        conns.erase(conns_it);
+    }
     accepting_conns.erase(p);
     deleted_conns.erase(it);
     ++num;
@@ -149,6 +149,8 @@ public:
    * @{
    */
   ConnectionRef get_connection(const entity_inst_t& dest) override;
+  ConnectionRef get_connection_lane(const entity_inst_t& dest,
+				    uint32_t hash) override;
   ConnectionRef get_loopback_connection() override;
   void mark_down(const entity_addr_t& addr) override;
   void mark_down_all() override {
@@ -190,11 +192,13 @@ private:
    *
    * @param addr The address of the entity to connect to.
    * @param type The peer type of the entity at the address.
+   * @param lane The session lane to this peer, see get_connection_lane.
    *
    * @return a pointer to the newly-created connection. Caller does not own a
    * reference; take one if you need it.
    */
-  AsyncConnectionRef create_connect(const entity_addr_t& addr, int type);
+  AsyncConnectionRef create_connect(const entity_addr_t& addr, int type,
+				    unsigned lane = 0);
 
   /**
    * Queue up a Message for delivery to the entity specified
@@ -218,6 +222,9 @@ private:
  private:
   static const uint64_t ReapDeadConnectionThreshold = 5;
 
+  /// networks whose links already protect data integrity
+  std::vector<std::pair<sockaddr_storage, unsigned>> crc_trusted_networks;
+
   NetworkStack *stack;
   std::vector<Processor*> processors;
   friend class Processor;
@@ -272,6 +279,12 @@ private:
    */
   ceph::unordered_map<entity_addr_t, AsyncConnectionRef> conns;
 
+  /**
+   * additional sessions to a peer, keyed by (address, lane); lane 0 is
+   * the one in conns. See ms_async_peer_lanes.
+   */
+  map<pair<entity_addr_t, unsigned>, AsyncConnectionRef> lane_conns;
+
   /**
    * list of connection are in teh process of accepting
    *
@@ -301,8 +314,27 @@ private:
   Cond  stop_cond;
   bool stopped;
 
-  AsyncConnectionRef _lookup_conn(const entity_addr_t& k) {
+  AsyncConnectionRef _lookup_lane_conn(const entity_addr_t& k, unsigned lane) {
+    assert(lock.is_locked());
+    auto p = lane_conns.find(make_pair(k, lane));
+    if (p == lane_conns.end())
+      return NULL;
+
+    // lazy delete, see "deleted_conns"
+    Mutex::Locker l(deleted_lock);
+    if (deleted_conns.erase(p->second)) {
+      p->second->get_perf_counter()->dec(l_msgr_active_connections);
+      lane_conns.erase(p);
+      return NULL;
+    }
+
+    return p->second;
+  }
+
+  AsyncConnectionRef _lookup_conn(const entity_addr_t& k, unsigned lane = 0) {
     assert(lock.is_locked());
+    if (lane)
+      return _lookup_lane_conn(k, lane);
     ceph::unordered_map<entity_addr_t, AsyncConnectionRef>::iterator p = conns.find(k);
     if (p == conns.end())
       return NULL;
@@ -340,13 +372,31 @@ public:
   /**
    * This wraps _lookup_conn.
    */
-  AsyncConnectionRef lookup_conn(const entity_addr_t& k) {
+  AsyncConnectionRef lookup_conn(const entity_addr_t& k, unsigned lane = 0) {
     Mutex::Locker l(lock);
-    return _lookup_conn(k);
+    return _lookup_conn(k, lane);
   }
 
   int accept_conn(AsyncConnectionRef conn) {
     Mutex::Locker l(lock);
+    if (conn->lane) {
+      auto key = make_pair(conn->peer_addr, conn->lane);
+      auto it = lane_conns.find(key);
+      if (it != lane_conns.end()) {
+        AsyncConnectionRef existing = it->second;
+        Mutex::Locker l(deleted_lock);
+        if (deleted_conns.erase(existing)) {
+          existing->get_perf_counter()->dec(l_msgr_active_connections);
+          lane_conns.erase(it);
+        } else if (conn != existing) {
+          return -1;
+        }
+      }
+      lane_conns[key] = conn;
+      conn->get_perf_counter()->inc(l_msgr_active_connections);
+      accepting_conns.erase(conn);
+      return 0;
+    }
     auto it = conns.find(conn->peer_addr);
     if (it != conns.end()) {
       AsyncConnectionRef existing = it->second;
@@ -369,6 +419,12 @@ public:
 
   void learned_addr(const entity_addr_t &peer_addr_for_me);
   void add_accept(Worker *w, ConnectedSocket cli_socket, entity_addr_t &addr);
+
+  /**
+   * crc flags for messages to and from this peer: crcflags, without
+   * MSG_CRC_DATA if the peer is in ms_crc_data_trusted_networks.
+   */
+  int get_peer_crcflags(const entity_addr_t& peer) const;
   NetworkStack *get_stack() {
     return stack;
   }
@@ -19,8 +19,13 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <algorithm>
+#include <deque>
 
 #include "PosixStack.h"
 
@@ -32,6 +37,10 @@
 #include "msg/Messenger.h"
 #include "include/sock_compat.h"
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define HAVE_MSG_ZEROCOPY
+#endif
+
 #define dout_subsys ceph_subsys_ms
 #undef dout_prefix
 #define dout_prefix *_dout << "PosixStack "
@@ -42,9 +51,29 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   entity_addr_t sa;
   bool connected;
 
+  // MSG_ZEROCOPY: sendmsg calls of at least zerocopy_min bytes are sent
+  // without copying, and the buffers they cover stay referenced here
+  // until the kernel reports their completion on the error queue.
+  PerfCounters *logger;
+  uint64_t zerocopy_min = 0;  // 0 means zerocopy is off for this socket
+  uint32_t zerocopy_next_id = 0;
+  struct zerocopy_pin_t {
+    uint32_t last_id;
+    bufferlist bl;
+  };
+  std::deque<zerocopy_pin_t> zerocopy_pinned;
+
  public:
-  explicit PosixConnectedSocketImpl(NetHandler &h, const entity_addr_t &sa, int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+  explicit PosixConnectedSocketImpl(NetHandler &h, const entity_addr_t &sa, int f, bool connected,
+                                    PerfCounters *logger, uint64_t zerocopy_min)
+      : handler(h), _fd(f), sa(sa), connected(connected), logger(logger) {
+#ifdef HAVE_MSG_ZEROCOPY
+    int one = 1;
+    if (zerocopy_min &&
+        ::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0)
+      this->zerocopy_min = zerocopy_min;
+#endif
+  }
 
   int is_connected() override {
     if (connected)
@@ -66,6 +95,8 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
 
   ssize_t read(char *buf, size_t len) override {
+    if (!zerocopy_pinned.empty())
+      reap_zerocopy();
     ssize_t r = ::read(_fd, buf, len);
     if (r < 0)
       r = -errno;
@@ -74,23 +105,34 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 
   // return the sent length
   // < 0 means error occured
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  // *calls counts the MSG_ZEROCOPY sendmsg calls that sent something
+  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more,
+                            int flags = 0, uint32_t *calls = nullptr)
   {
     size_t sent = 0;
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0) | flags);
       if (r < 0) {
         if (errno == EINTR) {
           continue;
         } else if (errno == EAGAIN) {
           break;
         }
+#ifdef HAVE_MSG_ZEROCOPY
+        if (errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+          // out of optmem for completion notifications; copy the rest
+          flags &= ~MSG_ZEROCOPY;
+          continue;
+        }
+#endif
         return -errno;
       }
 
       sent += r;
+      if (calls && (flags & MSG_ZEROCOPY))
+        ++*calls;
       if (len == sent) break;
 
       while (r > 0) {
@@ -128,7 +170,14 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      ssize_t r;
+      if (zerocopy_min && msglen >= zerocopy_min) {
+        r = send_zerocopy(bl, sent_bytes, msg, msglen, left_pbrs || more);
+      } else {
+        r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+        if (zerocopy_min && r > 0)
+          logger->inc(l_msgr_send_copied_bytes, r);
+      }
       if (r < 0)
         return r;
 
@@ -151,11 +200,65 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 
     return static_cast<ssize_t>(sent_bytes);
   }
+
+  ssize_t send_zerocopy(const bufferlist &bl, size_t off, struct msghdr &msg,
+                        unsigned msglen, bool more) {
+#ifdef HAVE_MSG_ZEROCOPY
+    uint32_t calls = 0;
+    reap_zerocopy();
+    ssize_t r = do_sendmsg(_fd, msg, msglen, more, MSG_ZEROCOPY, &calls);
+    if (calls) {
+      // the kernel numbers every successful zerocopy sendmsg; keep the
+      // buffers we handed it until the last of these ids completes
+      zerocopy_next_id += calls;
+      zerocopy_pinned.push_back(zerocopy_pin_t{zerocopy_next_id - 1, bufferlist()});
+      zerocopy_pinned.back().bl.substr_of(bl, off, r);
+    } else if (r > 0) {
+      logger->inc(l_msgr_send_copied_bytes, r);
+    }
+    return r;
+#else
+    return do_sendmsg(_fd, msg, msglen, more);
+#endif
+  }
+
+  void reap_zerocopy() {
+#ifdef HAVE_MSG_ZEROCOPY
+    while (!zerocopy_pinned.empty()) {
+      struct msghdr msg;
+      char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(_fd, &msg, MSG_ERRQUEUE) < 0)
+        return;  // EAGAIN: nothing completed yet
+      for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+           cm = CMSG_NXTHDR(&msg, cm)) {
+        struct sock_extended_err *serr =
+          reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+        if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+          continue;
+        // [ee_info, ee_data] completed; ids wrap, so compare as a distance
+        bool copied = serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+        while (!zerocopy_pinned.empty() &&
+               (int32_t)(zerocopy_pinned.front().last_id - serr->ee_data) <= 0) {
+          logger->inc(copied ? l_msgr_send_copied_bytes : l_msgr_send_zerocopy_bytes,
+                      zerocopy_pinned.front().bl.length());
+          zerocopy_pinned.pop_front();
+        }
+      }
+    }
+#endif
+  }
+
   void shutdown() override {
     ::shutdown(_fd, SHUT_RDWR);
   }
   void close() override {
     ::close(_fd);
+    // nothing more will be reported for this socket; the kernel keeps its
+    // own page references for whatever is still queued
+    zerocopy_pinned.clear();
   }
   int fd() const override {
     return _fd;
@@ -206,7 +309,10 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(
+      handler, *out, sd, true, w->get_perf_counter(),
+      static_cast<PosixWorker*>(w)->get_zerocopy_min()));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -215,6 +321,15 @@ void PosixWorker::initialize()
 {
 }
 
+uint64_t PosixWorker::get_zerocopy_min() const
+{
+#ifdef HAVE_MSG_ZEROCOPY
+  if (cct->_conf->ms_async_zerocopy_send)
+    return MAX(1, cct->_conf->ms_async_zerocopy_min_size);
+#endif
+  return 0;
+}
+
 int PosixWorker::listen(entity_addr_t &sa, const SocketOptions &opt,
                         ServerSocket *sock)
 {
@@ -274,7 +389,9 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
 
   net.set_priority(sd, opts.priority, addr.get_family());
   *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+      std::unique_ptr<PosixConnectedSocketImpl>(
+        new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock,
+                                     perf_logger, get_zerocopy_min())));
   return 0;
 }
 
@@ -292,3 +409,25 @@ PosixNetworkStack::PosixNetworkStack(CephContext *c, const string &t)
       lderr(cct) << __func__ << " failed to parse " << corestr << " in " << cct->_conf->ms_async_affinity_cores << dendl;
   }
 }
+
+void PosixNetworkStack::spawn_worker(unsigned i, std::function<void ()> &&func)
+{
+  threads.resize(i+1);
+  threads[i] = std::thread(func);
+#ifdef __linux__
+  int cpuid = get_cpuid(i);
+  if (cpuid >= 0 && cpuid < CPU_SETSIZE) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpuid, &cpuset);
+    int r = pthread_setaffinity_np(threads[i].native_handle(),
+                                   sizeof(cpuset), &cpuset);
+    if (r != 0)
+      lderr(cct) << __func__ << " failed to bind worker " << i << " to cpu "
+                 << cpuid << ": " << cpp_strerror(r) << dendl;
+    else
+      ldout(cct, 10) << __func__ << " bound worker " << i << " to cpu "
+                     << cpuid << dendl;
+  }
+#endif
+}
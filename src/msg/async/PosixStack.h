@@ -33,6 +33,8 @@ class PosixWorker : public Worker {
   int listen(entity_addr_t &sa, const SocketOptions &opt,
                      ServerSocket *socks) override;
   int connect(const entity_addr_t &addr, const SocketOptions &opts, ConnectedSocket *socket) override;
+  /// minimum sendmsg size for MSG_ZEROCOPY, 0 if not in use
+  uint64_t get_zerocopy_min() const;
 };
 
 class PosixNetworkStack : public NetworkStack {
@@ -47,10 +49,7 @@ class PosixNetworkStack : public NetworkStack {
       return -1;
     return coreids[id % coreids.size()];
   }
-  void spawn_worker(unsigned i, std::function<void ()> &&func) override {
-    threads.resize(i+1);
-    threads[i] = std::thread(func);
-  }
+  void spawn_worker(unsigned i, std::function<void ()> &&func) override;
   void join_worker(unsigned i) override {
     assert(threads.size() > i && threads[i].joinable());
     threads[i].join();
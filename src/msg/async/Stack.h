@@ -198,6 +198,14 @@ enum {
   l_msgr_running_recv_time,
   l_msgr_running_fast_dispatch_time,
 
+  l_msgr_send_messages_per_write,
+  l_msgr_crc_bytes,
+  l_msgr_crc_skipped_bytes,
+  l_msgr_send_zerocopy_bytes,
+  l_msgr_send_copied_bytes,
+  l_msgr_send_lane_bytes,
+  l_msgr_recv_lane_bytes,
+
   l_msgr_last,
 };
 
@@ -238,6 +246,14 @@ class Worker {
     plb.add_time(l_msgr_running_recv_time, "msgr_running_recv_time", "The total time of message receiving");
     plb.add_time(l_msgr_running_fast_dispatch_time, "msgr_running_fast_dispatch_time", "The total time of fast dispatch");
 
+    plb.add_u64_avg(l_msgr_send_messages_per_write, "msgr_send_messages_per_write", "Messages handed to the socket per write");
+    plb.add_u64_counter(l_msgr_crc_bytes, "msgr_crc_bytes", "Message bytes checksummed, sent and received");
+    plb.add_u64_counter(l_msgr_crc_skipped_bytes, "msgr_crc_skipped_bytes", "Message data bytes sent or received without a data crc");
+    plb.add_u64_counter(l_msgr_send_zerocopy_bytes, "msgr_send_zerocopy_bytes", "Network bytes sent with MSG_ZEROCOPY");
+    plb.add_u64_counter(l_msgr_send_copied_bytes, "msgr_send_copied_bytes", "Network bytes copied by the kernel while MSG_ZEROCOPY is enabled");
+    plb.add_u64_counter(l_msgr_send_lane_bytes, "msgr_send_lane_bytes", "Network bytes sent on additional per-peer lanes");
+    plb.add_u64_counter(l_msgr_recv_lane_bytes, "msgr_recv_lane_bytes", "Network bytes received on additional per-peer lanes");
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
@@ -648,6 +648,9 @@ DPDKQueuePair::DPDKQueuePair(CephContext *c, EventCenter *cen, DPDKDevice* dev,
   plb.add_u64_counter(l_dpdk_qp_rx_linearize_ops, "dpdk_receive_linearize_ops", "DPDK received linearize operations");
   plb.add_u64_counter(l_dpdk_qp_tx_linearize_ops, "dpdk_send_linearize_ops", "DPDK send linearize operations");
   plb.add_u64_counter(l_dpdk_qp_tx_queue_length, "dpdk_send_queue_length", "DPDK send queue length");
+  plb.add_u64_counter(l_dpdk_qp_rx_forwarded, "dpdk_receive_forwarded", "DPDK received packets forwarded to the worker owning the flow");
+  plb.add_u64_counter(l_dpdk_qp_rx_forward_dropped, "dpdk_receive_forward_dropped", "DPDK received packets dropped because the forward queue was full");
+  plb.add_time_avg(l_dpdk_qp_rx_forward_lat, "dpdk_receive_forward_latency", "DPDK latency of handing a packet to another worker");
 
   perf_logger = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perf_logger);
@@ -93,6 +93,9 @@ enum {
   l_dpdk_qp_rx_linearize_ops,
   l_dpdk_qp_tx_linearize_ops,
   l_dpdk_qp_tx_queue_length,
+  l_dpdk_qp_rx_forwarded,
+  l_dpdk_qp_rx_forward_dropped,
+  l_dpdk_qp_rx_forward_lat,
   l_dpdk_qp_last
 };
 
@@ -558,6 +561,7 @@ class DPDKQueuePair {
   tx_buf* get_tx_buf() { return _tx_buf_factory.get(); }
 
   void handle_stats();
+  PerfCounters *get_perf_counter() { return perf_logger; }
 
  private:
   template <class Func>
@@ -894,7 +898,6 @@ class DPDKDevice {
     if (!qp._sw_reta)
       return src_cpuid;
 
-    assert(!qp._sw_reta);
     auto hash = hashfn() >> _rss_table_bits;
     auto& reta = *qp._sw_reta;
     return reta[hash % reta.size()];
@@ -38,6 +38,7 @@
 #include "DPDKStack.h"
 
 #include "common/dout.h"
+#include "common/ceph_time.h"
 #include "include/assert.h"
 
 #define dout_subsys ceph_subsys_dpdk
@@ -108,11 +109,15 @@ class C_handle_l2forward : public EventCallback {
   unsigned &queue_depth;
   Packet p;
   unsigned dst;
+  ceph::mono_time start;
 
  public:
   C_handle_l2forward(std::shared_ptr<DPDKDevice> &p, unsigned &qd, Packet pkt, unsigned target)
-      : sdev(p), queue_depth(qd), p(std::move(pkt)), dst(target) {}
+      : sdev(p), queue_depth(qd), p(std::move(pkt)), dst(target),
+        start(ceph::mono_clock::now()) {}
   void do_request(uint64_t fd) {
+    sdev->queue_for_cpu(dst).get_perf_counter()->tinc(
+      l_dpdk_qp_rx_forward_lat, ceph::mono_clock::now() - start);
     sdev->l2receive(dst, std::move(p));
     queue_depth--;
     delete this;
@@ -122,11 +127,18 @@ class C_handle_l2forward : public EventCallback {
 void interface::forward(EventCenter *source, unsigned target, Packet p) {
   static __thread unsigned queue_depth;
 
+  // a packet landing here arrived on a queue whose worker doesn't own
+  // its flow; if these grow, the RSS table and the workers are out of
+  // step
+  PerfCounters *logger = _dev->queue_for_cpu(source->get_id()).get_perf_counter();
   if (queue_depth < 1000) {
     queue_depth++;
+    logger->inc(l_dpdk_qp_rx_forwarded);
     // FIXME: need ensure this event not be called after EventCenter destruct
     _dev->workers[target]->center.dispatch_event_external(
         new C_handle_l2forward(_dev, queue_depth, std::move(p.free_on_cpu(source)), target));
+  } else {
+    logger->inc(l_dpdk_qp_rx_forward_dropped);
   }
 }
 
@@ -20,13 +20,14 @@
 #include "RDMAStack.h"
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <algorithm>
+#include <functional>
 
 #define dout_subsys ceph_subsys_ms
 #undef dout_prefix
 #define dout_prefix *_dout << "Infiniband "
 
 static const uint32_t MAX_SHARED_RX_SGE_COUNT = 1;
-static const uint32_t MAX_INLINE_DATA = 0;
 static const uint32_t TCP_MSG_LEN = sizeof("0000:00000000:00000000:00000000:00000000000000000000000000000000");
 static const uint32_t CQ_DEPTH = 30000;
 
@@ -165,6 +166,7 @@ Infiniband::QueuePair::QueuePair(
   initial_psn(0),
   max_send_wr(tx_queue_len),
   max_recv_wr(rx_queue_len),
+  max_inline_data(0),
   q_key(q_key),
   dead(false)
 {
@@ -186,11 +188,19 @@ int Infiniband::QueuePair::init()
   qpia.srq = srq;                      // use the same shared receive queue
   qpia.cap.max_send_wr  = max_send_wr; // max outstanding send requests
   qpia.cap.max_send_sge = 1;           // max send scatter-gather elements
-  qpia.cap.max_inline_data = MAX_INLINE_DATA;          // max bytes of immediate data on send q
+  qpia.cap.max_inline_data = cct->_conf->ms_async_rdma_max_inline_data; // max bytes of immediate data on send q
   qpia.qp_type = type;                 // RC, UC, UD, or XRC
   qpia.sq_sig_all = 0;                 // only generate CQEs on requested WQEs
 
   qp = ibv_create_qp(pd, &qpia);
+  if (qp == NULL && qpia.cap.max_inline_data) {
+    // not every HCA supports the requested amount of inline data
+    ldout(cct, 1) << __func__ << " failed to create queue pair with "
+                  << qpia.cap.max_inline_data << " bytes of inline data, "
+                  << "retrying without inline sends" << dendl;
+    qpia.cap.max_inline_data = 0;
+    qp = ibv_create_qp(pd, &qpia);
+  }
   if (qp == NULL) {
     lderr(cct) << __func__ << " failed to create queue pair" << cpp_strerror(errno) << dendl;
     if (errno == ENOMEM) {
@@ -201,8 +211,10 @@ int Infiniband::QueuePair::init()
     return -1;
   }
 
+  // the provider reports back how much inline data it really accepts
+  max_inline_data = qpia.cap.max_inline_data;
   ldout(cct, 20) << __func__ << " successfully create queue pair: "
-                 << "qp=" << qp << dendl;
+                 << "qp=" << qp << " max_inline_data=" << max_inline_data << dendl;
 
   // move from RESET to INIT state
   ibv_qp_attr qpa;
@@ -681,6 +693,22 @@ void *Infiniband::MemoryManager::mem_pool::slow_malloc()
   return p;
 }
 
+bool Infiniband::MemoryManager::mem_pool::shrink()
+{
+  // boost::pool can only release a block when all of its chunks are on
+  // a sorted free list. rx buffers are returned unordered on the hot
+  // path, so rebuild the free list in address order first. Pushing in
+  // descending order keeps every ordered_free() at the list head.
+  std::vector<void*> chunks;
+  while (!store().empty())
+    chunks.push_back((store().malloc)());
+  std::sort(chunks.begin(), chunks.end(), std::greater<void*>());
+  for (auto c : chunks)
+    store().ordered_free(c);
+  // this will call PoolAllocator::free() for every idle block
+  return release_memory();
+}
+
 Infiniband::MemoryManager::MemPoolContext *Infiniband::MemoryManager::PoolAllocator::g_ctx = nullptr;
 Mutex Infiniband::MemoryManager::PoolAllocator::lock("pool-alloc-lock");
 
@@ -155,6 +155,8 @@ enum {
   l_msgr_rdma_created_queue_pair,
   l_msgr_rdma_active_queue_pair,
 
+  l_msgr_rdma_rx_pool_shrinks,
+
   l_msgr_rdma_dispatcher_last,
 };
 
@@ -167,6 +169,7 @@ enum {
 
   l_msgr_rdma_tx_chunks,
   l_msgr_rdma_tx_bytes,
+  l_msgr_rdma_tx_inline_chunks,
   l_msgr_rdma_rx_chunks,
   l_msgr_rdma_rx_bytes,
   l_msgr_rdma_pending_sent_conns,
@@ -305,6 +308,10 @@ class Infiniband {
         // slow path code
         return slow_malloc();
       }
+
+      // hand fully idle blocks back to the allocator (and deregister
+      // them); returns true if anything was released
+      bool shrink();
     };
 
     MemoryManager(CephContext *c, Device *d, ProtectionDomain *p);
@@ -332,6 +339,10 @@ class Infiniband {
       rxbuf_pool.free(chunk);
     }
 
+    bool shrink_rx_pool() {
+      return rxbuf_pool.shrink();
+    }
+
     void set_rx_stat_logger(PerfCounters *logger) {
       rxbuf_pool_ctx.set_stat_logger(logger);
     }
@@ -469,6 +480,7 @@ class Infiniband {
     void dec_tx_wr(uint32_t amt) { tx_wr_inflight -= amt; }
     uint32_t get_tx_wr() const { return tx_wr_inflight; }
     ibv_qp* get_qp() const { return qp; }
+    uint32_t get_max_inline_data() const { return max_inline_data; }
     Infiniband::CompletionQueue* get_tx_cq() const { return txcq; }
     Infiniband::CompletionQueue* get_rx_cq() const { return rxcq; }
     int to_dead();
@@ -488,6 +500,7 @@ class Infiniband {
     uint32_t     initial_psn;    // initial packet sequence number
     uint32_t     max_send_wr;
     uint32_t     max_recv_wr;
+    uint32_t     max_inline_data;
     uint32_t     q_key;
     bool dead;
     std::atomic<uint32_t> tx_wr_inflight = {0}; // counter for inflight Tx WQEs
@@ -503,6 +516,9 @@ class Infiniband {
   void post_chunk_to_pool(Chunk* chunk) {
     get_memory_manager()->release_rx_buffer(chunk);
   }
+  bool shrink_rx_pool() {
+    return get_memory_manager()->shrink_rx_pool();
+  }
   int get_tx_buffers(std::vector<Chunk*> &c, size_t bytes);
   CompletionChannel *create_comp_channel(CephContext *c);
   CompletionQueue *create_comp_queue(CephContext *c, CompletionChannel *cc=NULL);
@@ -554,10 +554,14 @@ int RDMAConnectedSocketImpl::post_work_request(std::vector<Chunk*> &tx_buffers)
     iswr[current_swr].num_sge = 1;
     iswr[current_swr].opcode = IBV_WR_SEND;
     iswr[current_swr].send_flags = IBV_SEND_SIGNALED;
-    /*if (isge[current_sge].length < infiniband->max_inline_data) {
-      iswr[current_swr].send_flags = IBV_SEND_INLINE;
-      ldout(cct, 20) << __func__ << " send_inline." << dendl;
-      }*/
+    // the HCA copies inline payload at post time, skipping the DMA read
+    // of the chunk; keep it signaled so the chunk is still returned via
+    // the tx completion
+    if (isge[current_sge].length <= qp->get_max_inline_data()) {
+      iswr[current_swr].send_flags |= IBV_SEND_INLINE;
+      worker->perf_logger->inc(l_msgr_rdma_tx_inline_chunks);
+      ldout(cct, 25) << __func__ << " send_inline." << dendl;
+    }
 
     num++;
     worker->perf_logger->inc(l_msgr_rdma_tx_bytes, isge[current_sge].length);
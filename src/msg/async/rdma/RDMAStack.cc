@@ -71,6 +71,8 @@ RDMADispatcher::RDMADispatcher(CephContext* c, RDMAStack* s)
   plb.add_u64_counter(l_msgr_rdma_created_queue_pair, "created_queue_pair", "Active queue pair number");
   plb.add_u64_counter(l_msgr_rdma_active_queue_pair, "active_queue_pair", "Created queue pair number");
 
+  plb.add_u64_counter(l_msgr_rdma_rx_pool_shrinks, "rx_pool_shrinks", "The number of times idle rx buffers were released");
+
   perf_logger = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perf_logger);
   Cycles::init();
@@ -267,6 +269,13 @@ void RDMADispatcher::polling()
       if (Cycles::to_microseconds(now - last_inactive) > cct->_conf->ms_async_rdma_polling_us) {
         handle_async_event();
         if (!rearmed) {
+          // about to go to sleep: give registered memory that a burst
+          // left behind in the rx pool back to the system
+          if (cct->_conf->ms_async_rdma_receive_buffers_shrink) {
+            Mutex::Locker l(lock);
+            if (get_stack()->get_infiniband().shrink_rx_pool())
+              perf_logger->inc(l_msgr_rdma_rx_pool_shrinks);
+          }
           // Clean up cq events after rearm notify ensure no new incoming event
           // arrived between polling and rearm
           tx_cq->rearm_notify();
@@ -468,6 +477,7 @@ RDMAWorker::RDMAWorker(CephContext *c, unsigned i)
 
   plb.add_u64_counter(l_msgr_rdma_tx_chunks, "tx_chunks", "The number of tx chunks transmitted");
   plb.add_u64_counter(l_msgr_rdma_tx_bytes, "tx_bytes", "The bytes of tx chunks transmitted");
+  plb.add_u64_counter(l_msgr_rdma_tx_inline_chunks, "tx_inline_chunks", "The number of tx chunks sent inline");
   plb.add_u64_counter(l_msgr_rdma_rx_chunks, "rx_chunks", "The number of rx chunks transmitted");
   plb.add_u64_counter(l_msgr_rdma_rx_bytes, "rx_bytes", "The bytes of rx chunks transmitted");
   plb.add_u64_counter(l_msgr_rdma_pending_sent_conns, "pending_sent_conns", "The count of pending sent conns");
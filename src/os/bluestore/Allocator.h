@@ -52,6 +52,16 @@ public:
 
   virtual uint64_t get_free() = 0;
 
+  /**
+   * get_fragmentation - free space fragmentation estimate
+   *
+   * 0 means all free space is one contiguous extent, 1 means every
+   * free alloc_unit sized chunk is its own extent.
+   */
+  virtual double get_fragmentation(uint64_t alloc_unit) {
+    return 0.0;
+  }
+
   virtual void shutdown() = 0;
   static Allocator *create(CephContext* cct, string type, int64_t size,
 			   int64_t block_size);
@@ -0,0 +1,290 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "AvlAllocator.h"
+#include "common/debug.h"
+
+#define dout_context cct
+#define dout_subsys ceph_subsys_bluestore
+#undef dout_prefix
+#define dout_prefix *_dout << "avl " << this << " "
+
+MEMPOOL_DEFINE_OBJECT_FACTORY(range_seg_t, range_seg_t, bluestore_alloc);
+
+AvlAllocator::AvlAllocator(CephContext* cct,
+			   int64_t device_size,
+			   int64_t block_size)
+  : num_total(device_size),
+    block_size(block_size),
+    cct(cct)
+{
+}
+
+AvlAllocator::~AvlAllocator()
+{
+  shutdown();
+}
+
+void AvlAllocator::_add_to_tree(uint64_t start, uint64_t size)
+{
+  assert(size != 0);
+
+  uint64_t end = start + size;
+
+  auto rs_after = range_tree.upper_bound(start, range_seg_t::key_less_t{});
+
+  /* Make sure we don't overlap with either of our neighbors */
+  auto rs_before = range_tree.end();
+  if (rs_after != range_tree.begin()) {
+    rs_before = std::prev(rs_after);
+  }
+
+  bool merge_before = (rs_before != range_tree.end() && rs_before->end == start);
+  bool merge_after = (rs_after != range_tree.end() && rs_after->start == end);
+  assert(rs_before == range_tree.end() || rs_before->end <= start);
+  assert(rs_after == range_tree.end() || rs_after->start >= end);
+
+  if (merge_before && merge_after) {
+    range_size_tree.erase(*rs_before);
+    range_size_tree.erase(*rs_after);
+    rs_after->start = rs_before->start;
+    range_tree.erase_and_dispose(rs_before, dispose_rs{});
+    range_size_tree.insert(*rs_after);
+  } else if (merge_before) {
+    range_size_tree.erase(*rs_before);
+    rs_before->end = end;
+    range_size_tree.insert(*rs_before);
+  } else if (merge_after) {
+    range_size_tree.erase(*rs_after);
+    rs_after->start = start;
+    range_size_tree.insert(*rs_after);
+  } else {
+    auto new_rs = new range_seg_t{start, end};
+    range_tree.insert_before(rs_after, *new_rs);
+    range_size_tree.insert(*new_rs);
+  }
+}
+
+void AvlAllocator::_remove_from_tree(uint64_t start, uint64_t size)
+{
+  uint64_t end = start + size;
+
+  assert(size != 0);
+  assert(size <= num_free);
+
+  auto rs = range_tree.upper_bound(start, range_seg_t::key_less_t{});
+  /* Make sure we completely overlap with someone */
+  assert(rs != range_tree.begin());
+  --rs;
+  assert(rs->start <= start);
+  assert(rs->end >= end);
+
+  bool left_over = (rs->start != start);
+  bool right_over = (rs->end != end);
+
+  range_size_tree.erase(*rs);
+
+  if (left_over && right_over) {
+    auto new_seg = new range_seg_t{end, rs->end};
+    rs->end = start;
+    range_tree.insert(rs, *new_seg);
+    range_size_tree.insert(*new_seg);
+    range_size_tree.insert(*rs);
+  } else if (left_over) {
+    rs->end = start;
+    range_size_tree.insert(*rs);
+  } else if (right_over) {
+    rs->start = end;
+    range_size_tree.insert(*rs);
+  } else {
+    range_tree.erase_and_dispose(rs, dispose_rs{});
+  }
+}
+
+int AvlAllocator::_allocate(
+  uint64_t want,
+  uint64_t unit,
+  uint64_t *offset,
+  uint64_t *length)
+{
+  // best fit: the shortest free segment that still holds want bytes
+  // once its start is aligned.  any segment of at least want + unit
+  // bytes always fits, so this stops after a few misaligned candidates.
+  auto p = range_size_tree.lower_bound(want, range_seg_t::size_less_t{});
+  for (; p != range_size_tree.end(); ++p) {
+    uint64_t off = P2ROUNDUP(p->start, unit);
+    if (off + want <= p->end) {
+      *offset = off;
+      *length = want;
+      goto found;
+    }
+  }
+
+  // nothing is big enough; take as much as we can from the longest
+  // segments, the caller will come back for the rest.
+  for (auto rp = range_size_tree.rbegin(); rp != range_size_tree.rend();
+       ++rp) {
+    if (rp->length() < unit) {
+      break;
+    }
+    uint64_t off = P2ROUNDUP(rp->start, unit);
+    if (off + unit <= rp->end) {
+      *offset = off;
+      *length = P2ALIGN(rp->end - off, unit);
+      goto found;
+    }
+  }
+  return -ENOSPC;
+
+ found:
+  ldout(cct, 30) << __func__ << " got 0x" << std::hex << *offset << "~"
+		 << *length << std::dec << dendl;
+  _remove_from_tree(*offset, *length);
+  return 0;
+}
+
+int AvlAllocator::reserve(uint64_t need)
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(cct, 10) << __func__ << " need 0x" << std::hex << need
+		 << " num_free 0x" << num_free
+		 << " num_reserved 0x" << num_reserved << std::dec << dendl;
+  if (need > num_free - num_reserved)
+    return -ENOSPC;
+  num_reserved += need;
+  return 0;
+}
+
+void AvlAllocator::unreserve(uint64_t unused)
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(cct, 10) << __func__ << " unused 0x" << std::hex << unused
+		 << " num_free 0x" << num_free
+		 << " num_reserved 0x" << num_reserved << std::dec << dendl;
+  assert(num_reserved >= unused);
+  num_reserved -= unused;
+}
+
+int64_t AvlAllocator::allocate(
+  uint64_t want_size,
+  uint64_t alloc_unit,
+  uint64_t max_alloc_size,
+  int64_t  hint, // unused, best fit does not care about locality
+  AllocExtentVector *extents)
+{
+  ldout(cct, 10) << __func__ << " want_size 0x" << std::hex << want_size
+		 << " alloc_unit 0x" << alloc_unit
+		 << " max_alloc_size 0x" << max_alloc_size
+		 << std::dec << dendl;
+  assert(ISP2(alloc_unit));
+  assert(want_size % alloc_unit == 0);
+
+  if (max_alloc_size == 0) {
+    max_alloc_size = want_size;
+  }
+
+  ExtentList block_list = ExtentList(extents, 1, max_alloc_size);
+  uint64_t allocated = 0;
+
+  // the whole request is served under a single lock acquisition
+  std::lock_guard<std::mutex> l(lock);
+  while (allocated < want_size) {
+    uint64_t offset, length;
+    int r = _allocate(MIN(max_alloc_size, want_size - allocated),
+		      alloc_unit, &offset, &length);
+    if (r < 0) {
+      break;
+    }
+    block_list.add_extents(offset, length);
+    allocated += length;
+  }
+  assert(num_free >= allocated);
+  num_free -= allocated;
+  assert(num_reserved >= allocated);
+  num_reserved -= allocated;
+
+  if (allocated == 0) {
+    return -ENOSPC;
+  }
+  return allocated;
+}
+
+void AvlAllocator::release(const interval_set<uint64_t>& release_set)
+{
+  std::lock_guard<std::mutex> l(lock);
+  for (auto p = release_set.begin(); p != release_set.end(); ++p) {
+    const auto offset = p.get_start();
+    const auto length = p.get_len();
+    ldout(cct, 10) << __func__ << std::hex
+		   << " offset 0x" << offset
+		   << " length 0x" << length
+		   << std::dec << dendl;
+    _add_to_tree(offset, length);
+    num_free += length;
+  }
+}
+
+uint64_t AvlAllocator::get_free()
+{
+  std::lock_guard<std::mutex> l(lock);
+  return num_free;
+}
+
+double AvlAllocator::get_fragmentation(uint64_t alloc_unit)
+{
+  std::lock_guard<std::mutex> l(lock);
+  auto free_blocks = P2ALIGN(num_free, alloc_unit) / alloc_unit;
+  if (free_blocks <= 1) {
+    return .0;
+  }
+  return (static_cast<double>(range_tree.size() - 1) / (free_blocks - 1));
+}
+
+void AvlAllocator::dump()
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(cct, 0) << __func__ << " range_tree: " << dendl;
+  for (auto& rs : range_tree) {
+    ldout(cct, 0) << std::hex
+		  << "0x" << rs.start << "~" << rs.end
+		  << std::dec
+		  << dendl;
+  }
+
+  ldout(cct, 0) << __func__ << " range_size_tree: " << dendl;
+  for (auto& rs : range_size_tree) {
+    ldout(cct, 0) << std::hex
+		  << "0x" << rs.start << "~" << rs.end
+		  << std::dec
+		  << dendl;
+  }
+}
+
+void AvlAllocator::init_add_free(uint64_t offset, uint64_t length)
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(cct, 10) << __func__ << std::hex
+		 << " offset 0x" << offset
+		 << " length 0x" << length
+		 << std::dec << dendl;
+  _add_to_tree(offset, length);
+  num_free += length;
+}
+
+void AvlAllocator::init_rm_free(uint64_t offset, uint64_t length)
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(cct, 10) << __func__ << std::hex
+		 << " offset 0x" << offset
+		 << " length 0x" << length
+		 << std::dec << dendl;
+  _remove_from_tree(offset, length);
+  num_free -= length;
+}
+
+void AvlAllocator::shutdown()
+{
+  std::lock_guard<std::mutex> l(lock);
+  range_size_tree.clear();
+  range_tree.clear_and_dispose(dispose_rs{});
+}
@@ -0,0 +1,144 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_OS_BLUESTORE_AVLALLOCATOR_H
+#define CEPH_OS_BLUESTORE_AVLALLOCATOR_H
+
+#include <mutex>
+#include <boost/intrusive/avl_set.hpp>
+
+#include "Allocator.h"
+#include "os/bluestore/bluestore_types.h"
+#include "include/mempool.h"
+
+/**
+ * range_seg_t - one free extent [start, end)
+ *
+ * Each segment is linked into two trees: one sorted by offset (used to
+ * merge neighbours on release) and one sorted by length (used for
+ * best-fit allocation).
+ */
+struct range_seg_t {
+  MEMPOOL_CLASS_HELPERS();  ///< memory monitoring
+  uint64_t start;  ///< starting offset of this segment
+  uint64_t end;    ///< ending offset (non-inclusive)
+
+  range_seg_t(uint64_t start, uint64_t end)
+    : start{start},
+      end{end}
+  {}
+  uint64_t length() const {
+    return end - start;
+  }
+
+  // Tree sorted by offset
+  boost::intrusive::avl_set_member_hook<> offset_hook;
+  struct before_t {
+    bool operator()(const range_seg_t& lhs, const range_seg_t& rhs) const {
+      return lhs.start < rhs.start;
+    }
+  };
+  /// key comparator for lookups by offset
+  struct key_less_t {
+    bool operator()(uint64_t lhs, const range_seg_t& rhs) const {
+      return lhs < rhs.start;
+    }
+    bool operator()(const range_seg_t& lhs, uint64_t rhs) const {
+      return lhs.start < rhs;
+    }
+  };
+
+  // Tree sorted by size, then offset
+  boost::intrusive::avl_set_member_hook<> size_hook;
+  struct shorter_t {
+    bool operator()(const range_seg_t& lhs, const range_seg_t& rhs) const {
+      const auto lhs_size = lhs.length();
+      const auto rhs_size = rhs.length();
+      if (lhs_size < rhs_size) {
+	return true;
+      } else if (lhs_size > rhs_size) {
+	return false;
+      } else {
+	return lhs.start < rhs.start;
+      }
+    }
+  };
+  /// key comparator for lookups by length
+  struct size_less_t {
+    bool operator()(uint64_t lhs, const range_seg_t& rhs) const {
+      return lhs < rhs.length();
+    }
+    bool operator()(const range_seg_t& lhs, uint64_t rhs) const {
+      return lhs.length() < rhs;
+    }
+  };
+};
+
+class AvlAllocator : public Allocator {
+  struct dispose_rs {
+    void operator()(range_seg_t* p)
+    {
+      delete p;
+    }
+  };
+
+public:
+  AvlAllocator(CephContext* cct, int64_t device_size, int64_t block_size);
+  ~AvlAllocator() override;
+
+  int reserve(uint64_t need) override;
+  void unreserve(uint64_t unused) override;
+
+  int64_t allocate(
+    uint64_t want_size, uint64_t alloc_unit, uint64_t max_alloc_size,
+    int64_t hint, AllocExtentVector *extents) override;
+
+  void release(const interval_set<uint64_t>& release_set) override;
+
+  uint64_t get_free() override;
+  double get_fragmentation(uint64_t alloc_unit) override;
+
+  void dump() override;
+
+  void init_add_free(uint64_t offset, uint64_t length) override;
+  void init_rm_free(uint64_t offset, uint64_t length) override;
+
+  void shutdown() override;
+
+private:
+  int _allocate(uint64_t want, uint64_t unit, uint64_t *offset,
+		uint64_t *length);
+
+  using range_tree_t =
+    boost::intrusive::avl_set<
+      range_seg_t,
+      boost::intrusive::compare<range_seg_t::before_t>,
+      boost::intrusive::member_hook<
+	range_seg_t,
+	boost::intrusive::avl_set_member_hook<>,
+	&range_seg_t::offset_hook>>;
+  range_tree_t range_tree;    ///< main range tree
+
+  using range_size_tree_t =
+    boost::intrusive::avl_multiset<
+      range_seg_t,
+      boost::intrusive::compare<range_seg_t::shorter_t>,
+      boost::intrusive::member_hook<
+	range_seg_t,
+	boost::intrusive::avl_set_member_hook<>,
+	&range_seg_t::size_hook>>;
+  range_size_tree_t range_size_tree;
+
+  const int64_t num_total;    ///< device size
+  const uint64_t block_size;  ///< block size
+  uint64_t num_free = 0;      ///< total bytes in freelist
+  uint64_t num_reserved = 0;  ///< reserved bytes
+
+  CephContext* cct;
+  std::mutex lock;
+
+  void _add_to_tree(uint64_t start, uint64_t size);
+  void _remove_from_tree(uint64_t start, uint64_t size);
+};
+
+#endif
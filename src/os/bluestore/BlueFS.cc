@@ -1618,8 +1618,15 @@ int BlueFS::_flush_range(FileWriter *h, uint64_t offset, uint64_t length)
     // we should never run out of log space here; see the min runway check
     // in _flush_and_sync_log.
     assert(h->file->fnode.ino != 1);
+    uint64_t want = offset + length - allocated;
+    if (cct->_conf->bluefs_preextend_wal_files &&
+	h->writer_type == WRITER_WAL) {
+      // grow the WAL in big steps so that appends rarely need to
+      // touch the bluefs log.
+      want = MAX(want, cct->_conf->get_val<uint64_t>("bluefs_wal_prealloc_size"));
+    }
     int r = _allocate(h->file->fnode.prefer_bdev,
-		      offset + length - allocated,
+		      want,
 		      &h->file->fnode.extents);
     if (r < 0) {
       derr << __func__ << " allocated: 0x" << std::hex << allocated
@@ -2095,6 +2102,33 @@ int BlueFS::open_for_write(
   dout(20) << __func__ << " mapping " << dirname << "/" << filename
 	   << " to bdev " << (int)file->fnode.prefer_bdev << dendl;
 
+  if (cct->_conf->bluefs_preextend_wal_files &&
+      boost::algorithm::ends_with(filename, ".log")) {
+    // preallocate (or top up a recycled) WAL file and expose the whole
+    // allocation as file size, so that the metadata update rides along
+    // with this open and subsequent appends only write data.  like
+    // preextending in _flush_range, this requires rocksdb log recycling.
+    uint64_t prealloc = cct->_conf->get_val<uint64_t>("bluefs_wal_prealloc_size");
+    uint64_t allocated = file->fnode.get_allocated();
+    if (allocated < prealloc) {
+      int r = _allocate(file->fnode.prefer_bdev, prealloc - allocated,
+			&file->fnode.extents);
+      if (r < 0) {
+	dout(1) << __func__ << " failed to preallocate 0x" << std::hex
+		<< prealloc - allocated << std::dec << " for " << filename
+		<< ": " << cpp_strerror(r) << dendl;
+      } else {
+	file->fnode.recalc_allocated();
+      }
+    }
+    if (file->fnode.size < file->fnode.get_allocated()) {
+      file->fnode.size = file->fnode.get_allocated();
+      dout(20) << __func__ << " extending WAL size to 0x" << std::hex
+	       << file->fnode.size << std::dec << " to include allocated"
+	       << dendl;
+    }
+  }
+
   log_t.op_file_update(file->fnode);
   if (create)
     log_t.op_dir_link(dirname, filename, file->fnode.ino);
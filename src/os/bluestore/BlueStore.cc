@@ -16,6 +16,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <thread>
 
 #include "include/cpp-btree/btree_set.h"
 
@@ -24,7 +25,9 @@
 #include "include/compat.h"
 #include "include/intarith.h"
 #include "include/stringify.h"
+#include "include/str_list.h"
 #include "include/str_map.h"
+#include "include/scope_guard.h"
 #include "common/errno.h"
 #include "common/safe_io.h"
 #include "Allocator.h"
@@ -564,6 +567,91 @@ struct Int64ArrayMergeOperator : public KeyValueDB::MergeOperator {
 };
 
 
+/*
+ * An attr patch is a merge operand on an onode key: a marker byte that
+ * no encoded onode starts with (that would be a struct_v of 255),
+ * followed by records of one op and its arguments.  Patches merge into
+ * each other by concatenation and into an onode by replaying them on its
+ * attrs; whatever follows the onode (spanning blobs, inline extents) is
+ * carried over untouched.
+ */
+static const char ONODE_ATTR_PATCH = (char)0xff;
+
+enum {
+  ONODE_ATTR_SET = 1,    ///< name, value
+  ONODE_ATTR_RM = 2,     ///< name
+  ONODE_ATTR_CLEAR = 3,
+};
+
+struct OnodeAttrMergeOperator : public KeyValueDB::MergeOperator {
+  void merge_nonexistent(
+    const char *rdata, size_t rlen, std::string *new_value) override {
+    // patches are only written to existing onodes; keep it around anyway
+    *new_value = std::string(rdata, rlen);
+  }
+  void merge(
+    const char *ldata, size_t llen,
+    const char *rdata, size_t rlen,
+    std::string *new_value) override {
+    assert(rlen > 0 && rdata[0] == ONODE_ATTR_PATCH);
+    if (llen > 0 && ldata[0] == ONODE_ATTR_PATCH) {
+      new_value->reserve(llen + rlen - 1);
+      new_value->assign(ldata, llen);
+      new_value->append(rdata + 1, rlen - 1);
+      return;
+    }
+
+    bufferptr v = buffer::copy(ldata, llen);
+    bufferptr::iterator p = v.begin();
+    bluestore_onode_t onode;
+    onode.decode(p);
+    size_t onode_len = p.get_offset();
+
+    bufferlist patch;
+    patch.append(rdata + 1, rlen - 1);
+    bufferlist::iterator q = patch.begin();
+    while (!q.end()) {
+      __u8 op;
+      string name;
+      ::decode(op, q);
+      switch (op) {
+      case ONODE_ATTR_SET:
+	{
+	  bufferptr val;
+	  ::decode(name, q);
+	  ::decode(val, q);
+	  onode.attrs[name.c_str()] = val;
+	}
+	break;
+      case ONODE_ATTR_RM:
+	::decode(name, q);
+	onode.attrs.erase(name.c_str());
+	break;
+      case ONODE_ATTR_CLEAR:
+	onode.attrs.clear();
+	break;
+      default:
+	assert(0 == "unknown onode attr patch op");
+      }
+    }
+
+    size_t bound = 0;
+    denc(onode, bound);
+    bufferlist bl;
+    {
+      auto a = bl.get_contiguous_appender(bound, true);
+      denc(onode, a);
+    }
+    new_value->reserve(bl.length() + llen - onode_len);
+    new_value->assign(bl.c_str(), bl.length());
+    new_value->append(ldata + onode_len, llen - onode_len);
+  }
+  string name() const override {
+    return "onode_attr_patch";
+  }
+};
+
+
 // Buffer
 
 ostream& operator<<(ostream& out, const BlueStore::Buffer& b)
@@ -792,7 +880,7 @@ void BlueStore::Cache::trim(
   float target_data_ratio,
   float bytes_per_onode)
 {
-  std::lock_guard<std::recursive_mutex> l(lock);
+  std::unique_lock<std::recursive_mutex> l(lock);
   uint64_t current_meta = _get_num_onodes() * bytes_per_onode;
   uint64_t current_buffer = _get_buffer_bytes();
   uint64_t current = current_meta + current_buffer;
@@ -848,7 +936,64 @@ void BlueStore::Cache::trim(
 	   << " -> max " << max_onodes << " onodes + "
 	   << max_buffer << " buffer"
 	   << dendl;
-  _trim(max_onodes, max_buffer);
+
+  uint64_t batch_bytes = cct->_conf->get_val<uint64_t>(
+    "bluestore_cache_trim_max_batch_bytes");
+  if (!batch_bytes) {
+    _trim(max_onodes, max_buffer);
+    ++trim_batches;
+    return;
+  }
+
+  // trim in bounded steps, dropping the lock in between, so that
+  // lookups on this shard do not stall behind one long trim.
+  uint64_t batch_onodes = batch_bytes;
+  if (bytes_per_onode > 0) {
+    batch_onodes = MAX(1, (uint64_t)(batch_bytes / bytes_per_onode));
+  }
+  while (true) {
+    uint64_t cur_onodes = _get_num_onodes();
+    uint64_t cur_buffer = _get_buffer_bytes();
+    uint64_t step_onodes = max_onodes;
+    uint64_t step_buffer = max_buffer;
+    if (cur_onodes > max_onodes + batch_onodes) {
+      step_onodes = cur_onodes - batch_onodes;
+    }
+    if (cur_buffer > max_buffer + batch_bytes) {
+      step_buffer = cur_buffer - batch_bytes;
+    }
+    _trim(step_onodes, step_buffer);
+    ++trim_batches;
+    if (step_onodes == max_onodes && step_buffer == max_buffer) {
+      break;
+    }
+    if (_get_num_onodes() >= cur_onodes &&
+	_get_buffer_bytes() >= cur_buffer) {
+      break;  // no progress (everything left is pinned)
+    }
+    l.unlock();
+    l.lock();
+  }
+}
+
+void BlueStore::Cache::dump_stats(Formatter *f)
+{
+  uint64_t onodes = 0, extents = 0, blobs = 0, buffers = 0, bytes = 0;
+  add_stats(&onodes, &extents, &blobs, &buffers, &bytes);
+  f->dump_unsigned("onodes", onodes);
+  f->dump_unsigned("extents", extents);
+  f->dump_unsigned("blobs", blobs);
+  f->dump_unsigned("buffers", buffers);
+  f->dump_unsigned("buffer_bytes", bytes);
+  f->dump_unsigned("onode_hits", onode_hits);
+  f->dump_unsigned("onode_misses", onode_misses);
+  f->dump_unsigned("buffer_hit_bytes", buffer_hit_bytes);
+  f->dump_unsigned("buffer_miss_bytes", buffer_miss_bytes);
+  f->dump_unsigned("onodes_evicted", onodes_evicted);
+  f->dump_unsigned("buffer_bytes_evicted", buffer_bytes_evicted);
+  f->dump_unsigned("trim_batches", trim_batches);
+  f->dump_unsigned("decompressed_cache_bytes", decompressed_cache_bytes);
+  f->dump_unsigned("decompressed_hit_bytes", decompressed_hit_bytes);
 }
 
 
@@ -882,6 +1027,7 @@ void BlueStore::LRUCache::_trim(uint64_t onode_max, uint64_t buffer_max)
     Buffer *b = &*i;
     assert(b->is_clean());
     dout(20) << __func__ << " rm " << *b << dendl;
+    buffer_bytes_evicted += b->length;
     b->space->_rm_buffer(this, b);
   }
 
@@ -925,6 +1071,7 @@ void BlueStore::LRUCache::_trim(uint64_t onode_max, uint64_t buffer_max)
     o->get();  // paranoia
     o->c->onode_map.remove(o->oid);
     o->put();
+    ++onodes_evicted;
     --num;
   }
 }
@@ -1143,6 +1290,7 @@ void BlueStore::TwoQCache::_trim(uint64_t onode_max, uint64_t buffer_max)
       dout(20) << __func__ << " evicted " << prettybyte_t(evicted)
                << " from warm_in list, done evicting warm_in buffers"
                << dendl;
+      buffer_bytes_evicted += evicted;
     }
 
     // adjust hot list
@@ -1169,6 +1317,7 @@ void BlueStore::TwoQCache::_trim(uint64_t onode_max, uint64_t buffer_max)
       dout(20) << __func__ << " evicted " << prettybyte_t(evicted)
                << " from hot list, done evicting hot buffers"
                << dendl;
+      buffer_bytes_evicted += evicted;
     }
 
     // adjust warm out list too, if necessary
@@ -1222,6 +1371,7 @@ void BlueStore::TwoQCache::_trim(uint64_t onode_max, uint64_t buffer_max)
     o->get();  // paranoia
     o->c->onode_map.remove(o->oid);
     o->put();
+    ++onodes_evicted;
     --num;
   }
 }
@@ -1420,6 +1570,8 @@ void BlueStore::BufferSpace::read(
   uint64_t miss_bytes = want_bytes - hit_bytes;
   cache->logger->inc(l_bluestore_buffer_hit_bytes, hit_bytes);
   cache->logger->inc(l_bluestore_buffer_miss_bytes, miss_bytes);
+  cache->buffer_hit_bytes += hit_bytes;
+  cache->buffer_miss_bytes += miss_bytes;
 }
 
 void BlueStore::BufferSpace::finish_write(Cache* cache, uint64_t seq)
@@ -1549,8 +1701,10 @@ BlueStore::OnodeRef BlueStore::OnodeSpace::lookup(const ghobject_t& oid)
 
   if (hit) {
     cache->logger->inc(l_bluestore_onode_hits);
+    ++cache->onode_hits;
   } else {
     cache->logger->inc(l_bluestore_onode_misses);
+    ++cache->onode_misses;
   }
   return o;
 }
@@ -2077,6 +2231,13 @@ void BlueStore::ExtentMap::update(KeyValueDB::Transaction t,
       prev_p = p;
       p = n;
     }
+    if (!force && !encoded_shards.empty()) {
+      unsigned n = std::min<size_t>(encoded_shards.size(), 64);
+      dirty_shards_avg = (dirty_shards_avg * 7 + n * 16) / 8;
+      if (dirty_shards_samples < 255) {
+	++dirty_shards_samples;
+      }
+    }
     if (needs_reshard()) {
       return;
     }
@@ -2120,6 +2281,29 @@ bid_t BlueStore::ExtentMap::allocate_spanning_blob_id()
   assert(0 == "no available blob id");
 }
 
+/*
+ * Every update rewrites its dirty shards whole.  An onode whose updates
+ * keep dirtying a single shard (small random overwrites) writes less per
+ * io with smaller shards; one whose updates dirty runs of shards
+ * (sequential writes) gets bigger ones and fewer keys.
+ */
+unsigned BlueStore::ExtentMap::get_shard_target(unsigned target,
+						unsigned min_size,
+						unsigned max_size) const
+{
+  if (dirty_shards_samples < 8) {
+    return target;  // not enough history
+  }
+  if (dirty_shards_avg <= 20) {        // <= 1.25 shards per update
+    return std::min(target, std::max(target / 2, min_size * 2));
+  }
+  if (dirty_shards_avg >= 4 * 16) {
+    // stay clear of max_size so that new shards are not split right away
+    return std::max(target, std::min(target * 2, max_size * 3 / 4));
+  }
+  return target;
+}
+
 void BlueStore::ExtentMap::reshard(
   KeyValueDB *db,
   KeyValueDB::Transaction t)
@@ -2188,6 +2372,11 @@ void BlueStore::ExtentMap::reshard(
     }
   }
   unsigned target = cct->_conf->bluestore_extent_map_shard_target_size;
+  if (cct->_conf->get_val<bool>("bluestore_extent_map_shard_adaptive")) {
+    target = get_shard_target(target,
+			      cct->_conf->bluestore_extent_map_shard_min_size,
+			      cct->_conf->bluestore_extent_map_shard_max_size);
+  }
   unsigned slop = target *
     cct->_conf->bluestore_extent_map_shard_target_size_slop;
   unsigned extent_avg = bytes / MAX(1, extents);
@@ -3024,6 +3213,7 @@ void BlueStore::DeferredBatch::prepare_write(
 	   << " crc " << i.first->second.bl.crc32c(-1)
 	   << std::dec << dendl;
   seq_bytes[seq] += length;
+  bytes += length;
 #ifdef DEBUG_DEFERRED
   _audit(cct);
 #endif
@@ -3361,6 +3551,9 @@ void *BlueStore::MempoolThread::entry()
     }
 
     float bytes_per_onode = (float)meta_bytes / (float)onode_num;
+    if (store->cct->_conf->get_val<bool>("bluestore_cache_autotune")) {
+      store->_autotune_cache_ratios(bytes_per_onode);
+    }
     size_t num_shards = store->cache_shards.size();
     float target_ratio = store->cache_meta_ratio + store->cache_data_ratio;
     // A little sloppy but should be close enough
@@ -3398,7 +3591,19 @@ BlueStore::OmapIteratorImpl::OmapIteratorImpl(
   if (o->onode.has_omap()) {
     get_omap_key(o->onode.nid, string(), &head);
     get_omap_tail(o->onode.nid, &tail);
-    it->lower_bound(head);
+    seek(head, false);
+    at_head = true;
+  }
+}
+
+void BlueStore::OmapIteratorImpl::seek(const string& key, bool upper)
+{
+  c->store->logger->inc(l_bluestore_omap_seeks);
+  at_head = false;
+  if (upper) {
+    it->upper_bound(key);
+  } else {
+    it->lower_bound(key);
   }
 }
 
@@ -3406,7 +3611,13 @@ int BlueStore::OmapIteratorImpl::seek_to_first()
 {
   RWLock::RLocker l(c->lock);
   if (o->onode.has_omap()) {
-    it->lower_bound(head);
+    if (at_head) {
+      // callers usually start with this right after construction
+      c->store->logger->inc(l_bluestore_omap_seeks_skipped);
+    } else {
+      seek(head, false);
+      at_head = true;
+    }
   } else {
     it = KeyValueDB::Iterator();
   }
@@ -3421,7 +3632,7 @@ int BlueStore::OmapIteratorImpl::upper_bound(const string& after)
     get_omap_key(o->onode.nid, after, &key);
     ldout(c->store->cct,20) << __func__ << " after " << after << " key "
 			    << pretty_binary_string(key) << dendl;
-    it->upper_bound(key);
+    seek(key, true);
   } else {
     it = KeyValueDB::Iterator();
   }
@@ -3432,11 +3643,15 @@ int BlueStore::OmapIteratorImpl::lower_bound(const string& to)
 {
   RWLock::RLocker l(c->lock);
   if (o->onode.has_omap()) {
+    if (at_head && to.empty()) {
+      c->store->logger->inc(l_bluestore_omap_seeks_skipped);
+      return 0;
+    }
     string key;
     get_omap_key(o->onode.nid, to, &key);
     ldout(c->store->cct,20) << __func__ << " to " << to << " key "
 			    << pretty_binary_string(key) << dendl;
-    it->lower_bound(key);
+    seek(key, false);
   } else {
     it = KeyValueDB::Iterator();
   }
@@ -3460,6 +3675,7 @@ int BlueStore::OmapIteratorImpl::next(bool validate)
 {
   RWLock::RLocker l(c->lock);
   if (o->onode.has_omap()) {
+    at_head = false;
     it->next();
     return 0;
   } else {
@@ -3507,12 +3723,12 @@ BlueStore::BlueStore(CephContext *cct, const string& path)
 		       cct->_conf->bluestore_throttle_deferred_bytes),
     deferred_finisher(cct, "defered_finisher", "dfin"),
     kv_sync_thread(this),
-    kv_finalize_thread(this),
     mempool_thread(this)
 {
   _init_logger();
   cct->_conf->add_observer(this);
   set_cache_shards(1);
+  pool_stats_enabled = cct->_conf->get_val<bool>("bluestore_pool_stats");
 }
 
 BlueStore::BlueStore(CephContext *cct,
@@ -3526,7 +3742,6 @@ BlueStore::BlueStore(CephContext *cct,
 		       cct->_conf->bluestore_throttle_deferred_bytes),
     deferred_finisher(cct, "defered_finisher", "dfin"),
     kv_sync_thread(this),
-    kv_finalize_thread(this),
     min_alloc_size(_min_alloc_size),
     min_alloc_size_order(ctz(_min_alloc_size)),
     mempool_thread(this)
@@ -3534,6 +3749,7 @@ BlueStore::BlueStore(CephContext *cct,
   _init_logger();
   cct->_conf->add_observer(this);
   set_cache_shards(1);
+  pool_stats_enabled = cct->_conf->get_val<bool>("bluestore_pool_stats");
 }
 
 BlueStore::~BlueStore()
@@ -3576,6 +3792,8 @@ const char **BlueStore::get_tracked_conf_keys() const
     "bluestore_deferred_batch_ops",
     "bluestore_deferred_batch_ops_hdd",
     "bluestore_deferred_batch_ops_ssd",
+    "bluestore_deferred_batch_bytes",
+    "bluestore_max_defer_interval",
     "bluestore_throttle_bytes",
     "bluestore_throttle_deferred_bytes",
     "bluestore_throttle_cost_per_io_hdd",
@@ -3584,6 +3802,7 @@ const char **BlueStore::get_tracked_conf_keys() const
     "bluestore_max_blob_size",
     "bluestore_max_blob_size_ssd",
     "bluestore_max_blob_size_hdd",
+    "bluestore_pool_stats",
     NULL
   };
   return KEYS;
@@ -3617,7 +3836,9 @@ void BlueStore::handle_conf_change(const struct md_config_t *conf,
       changed.count("bluestore_max_alloc_size") ||
       changed.count("bluestore_deferred_batch_ops") ||
       changed.count("bluestore_deferred_batch_ops_hdd") ||
-      changed.count("bluestore_deferred_batch_ops_ssd")) {
+      changed.count("bluestore_deferred_batch_ops_ssd") ||
+      changed.count("bluestore_deferred_batch_bytes") ||
+      changed.count("bluestore_max_defer_interval")) {
     if (bdev) {
       // only after startup
       _set_alloc_sizes();
@@ -3639,6 +3860,9 @@ void BlueStore::handle_conf_change(const struct md_config_t *conf,
     throttle_deferred_bytes.reset_max(
       conf->bluestore_throttle_bytes + conf->bluestore_throttle_deferred_bytes);
   }
+  if (changed.count("bluestore_pool_stats")) {
+    pool_stats_enabled = conf->get_val<bool>("bluestore_pool_stats");
+  }
 }
 
 void BlueStore::_set_compression()
@@ -3805,6 +4029,113 @@ int BlueStore::_set_cache_sizes()
   return 0;
 }
 
+/*
+ * Shift cache memory between onode metadata, buffered data and the kv
+ * (rocksdb block) cache.  Each interval we turn the misses of every
+ * pool into "missed bytes" and move one step of the total cache size
+ * from the pool that missed least to the full pool that missed most.
+ * The total stays at cache_size.  The kv pool only takes part when the
+ * kv store can report its misses (rocksdb_perf).
+ */
+void BlueStore::_autotune_cache_ratios(float bytes_per_onode)
+{
+  utime_t now = ceph_clock_now();
+  double interval =
+    cct->_conf->get_val<double>("bluestore_cache_autotune_interval");
+  if (cache_autotune_last != utime_t() &&
+      (double)(now - cache_autotune_last) < interval) {
+    return;
+  }
+  bool first = cache_autotune_last == utime_t();
+  cache_autotune_last = now;
+
+  enum { META = 0, DATA, KV, NUM_POOLS };
+  const char *names[NUM_POOLS] = { "meta", "data", "kv" };
+  float *ratios[NUM_POOLS] = {
+    &cache_meta_ratio, &cache_data_ratio, &cache_kv_ratio };
+  uint64_t usage[NUM_POOLS] = { 0, 0, 0 };
+  uint64_t missed[NUM_POOLS] = { 0, 0, 0 };
+
+  uint64_t onode_misses = 0, buffer_miss_bytes = 0;
+  uint64_t onodes = 0, extents = 0, blobs = 0, buffers = 0, bytes = 0;
+  for (auto c : cache_shards) {
+    onode_misses += c->onode_misses;
+    buffer_miss_bytes += c->buffer_miss_bytes;
+    c->add_stats(&onodes, &extents, &blobs, &buffers, &bytes);
+  }
+  usage[META] = onodes * bytes_per_onode;
+  usage[DATA] = bytes;
+  missed[META] = (onode_misses - cache_autotune_onode_misses) *
+    bytes_per_onode;
+  missed[DATA] = buffer_miss_bytes - cache_autotune_buffer_miss_bytes;
+  cache_autotune_onode_misses = onode_misses;
+  cache_autotune_buffer_miss_bytes = buffer_miss_bytes;
+
+  uint64_t kv_usage = 0, kv_capacity = 0, kv_misses = 0;
+  bool have_kv = db &&
+    db->get_cache_stats(&kv_usage, &kv_capacity, &kv_misses) == 0;
+  if (have_kv) {
+    usage[KV] = kv_usage;
+    missed[KV] = (kv_misses - cache_autotune_kv_misses) *
+      cct->_conf->rocksdb_block_size;
+    cache_autotune_kv_misses = kv_misses;
+  }
+  if (first) {
+    return;  // we only have a baseline so far
+  }
+
+  float step = cct->_conf->get_val<double>("bluestore_cache_autotune_step");
+  float min_ratio =
+    cct->_conf->get_val<double>("bluestore_cache_autotune_min_ratio");
+  int num_pools = have_kv ? NUM_POOLS : KV;
+
+  // recipient: the pool that is (nearly) full and missed the most
+  int to = -1;
+  for (int i = 0; i < num_pools; ++i) {
+    uint64_t target = cache_size * *ratios[i];
+    if (usage[i] < target * .9 || missed[i] == 0) {
+      continue;
+    }
+    if (to < 0 || missed[i] > missed[to]) {
+      to = i;
+    }
+  }
+  if (to < 0) {
+    return;
+  }
+  if (to == KV && cct->_conf->bluestore_cache_kv_max > 0 &&
+      cache_size * (cache_kv_ratio + step) >
+        cct->_conf->bluestore_cache_kv_max) {
+    return;
+  }
+
+  // donor: the pool with room to give that missed the least
+  int from = -1;
+  for (int i = 0; i < num_pools; ++i) {
+    if (i == to || *ratios[i] - step < min_ratio) {
+      continue;
+    }
+    if (from < 0 || missed[i] < missed[from]) {
+      from = i;
+    }
+  }
+  if (from < 0 || missed[from] >= missed[to]) {
+    return;
+  }
+
+  *ratios[from] -= step;
+  *ratios[to] += step;
+  dout(10) << __func__ << " moved " << step << " of " << cache_size
+	   << " from " << names[from] << " (missed " << missed[from] << ")"
+	   << " to " << names[to] << " (missed " << missed[to] << ")"
+	   << ", now meta " << cache_meta_ratio
+	   << " data " << cache_data_ratio
+	   << " kv " << cache_kv_ratio << dendl;
+  if (from == KV || to == KV) {
+    db->set_cache_size(cache_size * cache_kv_ratio);
+  }
+}
+
 int BlueStore::write_meta(const std::string& key, const std::string& value)
 {
   bluestore_bdev_label_t label;
@@ -3884,6 +4215,10 @@ void BlueStore::_init_logger()
 		 "r_l", PerfCountersBuilder::PRIO_CRITICAL);
   b.add_time_avg(l_bluestore_read_onode_meta_lat, "read_onode_meta_lat",
     "Average read onode metadata latency");
+  b.add_u64_counter(l_bluestore_read_bytes, "read_bytes",
+		    "Sum for bytes returned by reads");
+  b.add_u64_avg(l_bluestore_read_copied_bytes, "read_copied_bytes",
+		"Average bytes per read not shared with device or cache buffers");
   b.add_time_avg(l_bluestore_read_wait_aio_lat, "read_wait_aio_lat",
     "Average read latency");
   b.add_time_avg(l_bluestore_compress_lat, "compress_lat",
@@ -3902,6 +4237,8 @@ void BlueStore::_init_logger()
 		    "Sum for deferred write op");
   b.add_u64_counter(l_bluestore_deferred_write_bytes, "deferred_write_bytes",
 		    "Sum for deferred write bytes", "def");
+  b.add_u64_counter(l_bluestore_deferred_write_merged, "deferred_write_merged",
+		    "Sum for deferred write extents merged into a neighbouring io");
   b.add_u64_counter(l_bluestore_write_penalty_read_ops, "write_penalty_read_ops",
 		    "Sum for write penalty read ops");
   b.add_u64(l_bluestore_allocated, "bluestore_allocated",
@@ -3938,6 +4275,12 @@ void BlueStore::_init_logger()
     "Sum for bytes of read hit in the cache");
   b.add_u64(l_bluestore_buffer_miss_bytes, "bluestore_buffer_miss_bytes",
     "Sum for bytes of read missed in the cache");
+  b.add_u64_counter(l_bluestore_decompressed_cache_bytes,
+    "bluestore_decompressed_cache_bytes",
+    "Sum for bytes of decompressed blob data added to the cache");
+  b.add_u64_counter(l_bluestore_decompressed_hit_bytes,
+    "bluestore_decompressed_hit_bytes",
+    "Sum for bytes of compressed blob reads served from the cache");
 
   b.add_u64_counter(l_bluestore_write_big, "bluestore_write_big",
 		    "Large aligned writes into fresh blobs");
@@ -3974,6 +4317,12 @@ void BlueStore::_init_logger()
 		    "collection");
   b.add_u64_counter(l_bluestore_read_eio, "bluestore_read_eio",
                     "Read EIO errors propagated to high level callers");
+  b.add_u64_counter(l_bluestore_omap_seeks, "bluestore_omap_seeks",
+		    "Sum for kv seeks issued by omap reads");
+  b.add_u64_counter(l_bluestore_omap_seeks_skipped,
+		    "bluestore_omap_seeks_skipped",
+		    "Sum for omap iterator seeks avoided because the iterator "
+		    "was already in place");
   logger = b.create_perf_counters();
   cct->get_perfcounters_collection()->add(logger);
 }
@@ -4161,6 +4510,10 @@ void BlueStore::_set_alloc_sizes(void)
       deferred_batch_ops = cct->_conf->bluestore_deferred_batch_ops_ssd;
     }
   }
+  deferred_batch_bytes =
+    cct->_conf->get_val<uint64_t>("bluestore_deferred_batch_bytes");
+  max_defer_interval =
+    cct->_conf->get_val<double>("bluestore_max_defer_interval");
 
   dout(10) << __func__ << " min_alloc_size 0x" << std::hex << min_alloc_size
 	   << std::dec << " order " << min_alloc_size_order
@@ -4168,6 +4521,8 @@ void BlueStore::_set_alloc_sizes(void)
 	   << " prefer_deferred_size 0x" << prefer_deferred_size
 	   << std::dec
 	   << " deferred_batch_ops " << deferred_batch_ops
+	   << " deferred_batch_bytes 0x" << std::hex << deferred_batch_bytes
+	   << std::dec << " max_defer_interval " << max_defer_interval
 	   << dendl;
 }
 
@@ -4775,11 +5130,20 @@ int BlueStore::_open_db(bool create, bool to_repair_db)
 
   FreelistManager::setup_merge_operators(db);
   db->set_merge_operator(PREFIX_STAT, merge_op);
+  db->set_merge_operator(PREFIX_OBJ,
+			 std::make_shared<OnodeAttrMergeOperator>());
 
   db->set_cache_size(cache_size * cache_kv_ratio);
 
   if (kv_backend == "rocksdb") {
     options = cct->_conf->bluestore_rocksdb_options;
+    if (bluefs && cct->_conf->bluefs_preextend_wal_files &&
+	(options.find("recycle_log_file_num") == string::npos ||
+	 options.find("recycle_log_file_num=0") != string::npos)) {
+      derr << __func__ << " bluefs_preextend_wal_files requires rocksdb"
+	   << " log recycling; set recycle_log_file_num in"
+	   << " bluestore_rocksdb_options" << dendl;
+    }
 
     map<string,string> cf_map;
     get_str_map(cct->_conf->get_val<string>("bluestore_rocksdb_cfs"), &cf_map,
@@ -5599,6 +5963,213 @@ int BlueStore::_fsck_check_extents(
   return errors;
 }
 
+void BlueStore::_fsck_check_object(
+  FsckShard& s,
+  Collection *c,
+  OnodeRef& o,
+  bool deep)
+{
+  o->extent_map.fault_range(db, 0, OBJECT_MAX_SIZE);
+  _dump_onode(o, 30);
+  // lextents
+  map<BlobRef,bluestore_blob_t::unused_t> referenced;
+  uint64_t pos = 0;
+  mempool::bluestore_fsck::map<BlobRef,
+			       bluestore_blob_use_tracker_t> ref_map;
+  for (auto& l : o->extent_map.extent_map) {
+    dout(20) << __func__ << "    " << l << dendl;
+    if (l.logical_offset < pos) {
+      derr << "fsck error: " << o->oid << " lextent at 0x"
+	   << std::hex << l.logical_offset
+	   << " overlaps with the previous, which ends at 0x" << pos
+	   << std::dec << dendl;
+      ++s.errors;
+    }
+    if (o->extent_map.spans_shard(l.logical_offset, l.length)) {
+      derr << "fsck error: " << o->oid << " lextent at 0x"
+	   << std::hex << l.logical_offset << "~" << l.length
+	   << " spans a shard boundary"
+	   << std::dec << dendl;
+      ++s.errors;
+    }
+    pos = l.logical_offset + l.length;
+    s.expected_statfs.stored += l.length;
+    assert(l.blob);
+    const bluestore_blob_t& blob = l.blob->get_blob();
+
+    auto& ref = ref_map[l.blob];
+    if (ref.is_empty()) {
+      uint32_t min_release_size = blob.get_release_size(min_alloc_size);
+      uint32_t l = blob.get_logical_length();
+      ref.init(l, min_release_size);
+    }
+    ref.get(
+      l.blob_offset, 
+      l.length);
+    ++s.num_extents;
+    if (blob.has_unused()) {
+      auto p = referenced.find(l.blob);
+      bluestore_blob_t::unused_t *pu;
+      if (p == referenced.end()) {
+	pu = &referenced[l.blob];
+      } else {
+	pu = &p->second;
+      }
+      uint64_t blob_len = blob.get_logical_length();
+      assert((blob_len % (sizeof(*pu)*8)) == 0);
+      assert(l.blob_offset + l.length <= blob_len);
+      uint64_t chunk_size = blob_len / (sizeof(*pu)*8);
+      uint64_t start = l.blob_offset / chunk_size;
+      uint64_t end =
+	ROUND_UP_TO(l.blob_offset + l.length, chunk_size) / chunk_size;
+      for (auto i = start; i < end; ++i) {
+	(*pu) |= (1u << i);
+      }
+    }
+  }
+  for (auto &i : referenced) {
+    dout(20) << __func__ << "  referenced 0x" << std::hex << i.second
+	     << std::dec << " for " << *i.first << dendl;
+    const bluestore_blob_t& blob = i.first->get_blob();
+    if (i.second & blob.unused) {
+      derr << "fsck error: " << o->oid << " blob claims unused 0x"
+	   << std::hex << blob.unused
+	   << " but extents reference 0x" << i.second
+	   << " on blob " << *i.first << dendl;
+      ++s.errors;
+    }
+    if (blob.has_csum()) {
+      uint64_t blob_len = blob.get_logical_length();
+      uint64_t unused_chunk_size = blob_len / (sizeof(blob.unused)*8);
+      unsigned csum_count = blob.get_csum_count();
+      unsigned csum_chunk_size = blob.get_csum_chunk_size();
+      for (unsigned p = 0; p < csum_count; ++p) {
+	unsigned pos = p * csum_chunk_size;
+	unsigned firstbit = pos / unused_chunk_size;    // [firstbit,lastbit]
+	unsigned lastbit = (pos + csum_chunk_size - 1) / unused_chunk_size;
+	unsigned mask = 1u << firstbit;
+	for (unsigned b = firstbit + 1; b <= lastbit; ++b) {
+	  mask |= 1u << b;
+	}
+	if ((blob.unused & mask) == mask) {
+	  // this csum chunk region is marked unused
+	  if (blob.get_csum_item(p) != 0) {
+	    derr << "fsck error: " << o->oid
+		 << " blob claims csum chunk 0x" << std::hex << pos
+		 << "~" << csum_chunk_size
+		 << " is unused (mask 0x" << mask << " of unused 0x"
+		 << blob.unused << ") but csum is non-zero 0x"
+		 << blob.get_csum_item(p) << std::dec << " on blob "
+		 << *i.first << dendl;
+	    ++s.errors;
+	  }
+	}
+      }
+    }
+  }
+  for (auto &i : ref_map) {
+    ++s.num_blobs;
+    const bluestore_blob_t& blob = i.first->get_blob();
+    bool equal = i.first->get_blob_use_tracker().equal(i.second);
+    if (!equal) {
+      derr << "fsck error: " << o->oid << " blob " << *i.first
+	   << " doesn't match expected ref_map " << i.second << dendl;
+      ++s.errors;
+    }
+    if (blob.is_compressed()) {
+      s.expected_statfs.compressed += blob.get_compressed_payload_length();
+      s.expected_statfs.compressed_original += 
+	i.first->get_referenced_bytes();
+    }
+    if (blob.is_shared()) {
+      if (i.first->shared_blob->get_sbid() > blobid_max) {
+	derr << "fsck error: " << o->oid << " blob " << blob
+	     << " sbid " << i.first->shared_blob->get_sbid() << " > blobid_max "
+	     << blobid_max << dendl;
+	++s.errors;
+      } else if (i.first->shared_blob->get_sbid() == 0) {
+	derr << "fsck error: " << o->oid << " blob " << blob
+	     << " marked as shared but has uninitialized sbid"
+	     << dendl;
+	++s.errors;
+      }
+      fsck_sb_info_t& sbi = s.sb_info[i.first->shared_blob->get_sbid()];
+      sbi.sb = i.first->shared_blob;
+      sbi.oids.push_back(o->oid);
+      sbi.compressed = blob.is_compressed();
+      for (auto e : blob.get_extents()) {
+	if (e.is_valid()) {
+	  sbi.ref_map.get(e.offset, e.length);
+	}
+      }
+    } else {
+      s.errors += _fsck_check_extents(o->oid, blob.get_extents(),
+				      blob.is_compressed(),
+				      *s.used_blocks,
+				      s.expected_statfs);
+    }
+  }
+  if (deep) {
+    bufferlist bl;
+    int r = _do_read(c, o, 0, o->onode.size, bl, 0);
+    if (r < 0) {
+      ++s.errors;
+      derr << "fsck error: " << o->oid << " error during read: "
+	   << cpp_strerror(r) << dendl;
+    }
+  }
+}
+
+void BlueStore::_fsck_merge_shard(
+  FsckShard& s,
+  mempool_dynamic_bitset &used_blocks,
+  store_statfs_t& expected_statfs,
+  fsck_sb_info_map_t& sb_info,
+  int *errors)
+{
+  *errors += s.errors;
+  expected_statfs.allocated += s.expected_statfs.allocated;
+  expected_statfs.stored += s.expected_statfs.stored;
+  expected_statfs.compressed += s.expected_statfs.compressed;
+  expected_statfs.compressed_allocated +=
+    s.expected_statfs.compressed_allocated;
+  expected_statfs.compressed_original += s.expected_statfs.compressed_original;
+
+  for (auto& p : s.sb_info) {
+    fsck_sb_info_t& sbi = sb_info[p.first];
+    if (!sbi.sb) {
+      sbi.sb = p.second.sb;
+      sbi.compressed = p.second.compressed;
+    }
+    sbi.oids.splice(sbi.oids.end(), p.second.oids);
+    for (auto& r : p.second.ref_map.ref_map) {
+      for (unsigned i = 0; i < r.second.refs; ++i) {
+	sbi.ref_map.get(r.first, r.second.length);
+      }
+    }
+  }
+  s.sb_info.clear();
+
+  if (s.used_blocks == &used_blocks) {
+    return;
+  }
+  // blocks claimed by objects checked on different threads
+  auto& bs = *s.used_blocks;
+  for (size_t pos = bs.find_first();
+       pos != mempool_dynamic_bitset::npos;
+       pos = bs.find_next(pos)) {
+    if (used_blocks.test(pos)) {
+      derr << "fsck error: block 0x" << std::hex
+	   << ((uint64_t)pos * min_alloc_size) << "~" << min_alloc_size
+	   << std::dec << " is already allocated" << dendl;
+      ++(*errors);
+    } else {
+      used_blocks.set(pos);
+    }
+  }
+  bs.clear();
+}
+
 int BlueStore::_fsck(bool deep, bool repair)
 {
   dout(1) << __func__
@@ -5618,13 +6189,7 @@ int BlueStore::_fsck(bool deep, bool repair)
   mempool_dynamic_bitset used_blocks;
   KeyValueDB::Iterator it;
   store_statfs_t expected_statfs, actual_statfs;
-  struct sb_info_t {
-    list<ghobject_t> oids;
-    SharedBlobRef sb;
-    bluestore_extent_ref_map_t ref_map;
-    bool compressed;
-  };
-  mempool::bluestore_fsck::map<uint64_t,sb_info_t> sb_info;
+  fsck_sb_info_map_t sb_info;
 
   uint64_t num_objects = 0;
   uint64_t num_extents = 0;
@@ -5722,6 +6287,74 @@ int BlueStore::_fsck(bool deep, bool repair)
     CollectionRef c;
     spg_t pgid;
     mempool::bluestore_fsck::list<string> expecting_shards;
+
+    // keys are walked (and onodes decoded) here, in key order; the
+    // per-object extent and blob checks, and the deep read, are handed
+    // to fsck_threads workers, each with its own used block bitmap.
+    unsigned fsck_threads = MAX(1, cct->_conf->get_val<uint64_t>(
+				  "bluestore_fsck_threads"));
+    vector<FsckShard> fsck_shards(fsck_threads);
+    if (fsck_threads == 1) {
+      fsck_shards[0].used_blocks = &used_blocks;
+    } else {
+      for (auto& sh : fsck_shards) {
+	sh.local_used_blocks.resize(used_blocks.size());
+	sh.used_blocks = &sh.local_used_blocks;
+      }
+    }
+    struct {
+      std::mutex lock;
+      std::condition_variable cond;
+      deque<pair<CollectionRef,OnodeRef>> q;
+      size_t max = 0;
+      bool stop = false;
+    } fsck_q;
+    fsck_q.max = fsck_threads * 64;
+    vector<std::thread> fsck_workers;
+    auto stop_fsck_workers = [&] {
+      {
+	std::lock_guard<std::mutex> ql(fsck_q.lock);
+	fsck_q.stop = true;
+	fsck_q.cond.notify_all();
+      }
+      for (auto& t : fsck_workers) {
+	t.join();
+      }
+      fsck_workers.clear();
+    };
+    // also on abort
+    auto fsck_workers_guard = make_scope_guard([&] { stop_fsck_workers(); });
+    if (fsck_threads > 1) {
+      dout(1) << __func__ << " using " << fsck_threads << " threads" << dendl;
+      for (auto& sh : fsck_shards) {
+	FsckShard *shp = &sh;
+	fsck_workers.emplace_back([&, shp] {
+	    std::unique_lock<std::mutex> ql(fsck_q.lock);
+	    while (true) {
+	      if (fsck_q.q.empty()) {
+		if (fsck_q.stop) {
+		  break;
+		}
+		fsck_q.cond.wait(ql);
+		continue;
+	      }
+	      auto item = std::move(fsck_q.q.front());
+	      fsck_q.q.pop_front();
+	      fsck_q.cond.notify_all();
+	      ql.unlock();
+	      {
+		RWLock::RLocker l(item.first->lock);
+		_fsck_check_object(*shp, item.first.get(), item.second, deep);
+	      }
+	      item.second.reset();
+	      item.first.reset();
+	      ql.lock();
+	    }
+	  });
+      }
+    }
+    utime_t last_progress = ceph_clock_now();
+
     for (it->lower_bound(string()); it->valid(); it->next()) {
       if (g_conf->bluestore_debug_fsck_abort) {
 	goto out_scan;
@@ -5810,6 +6443,21 @@ int BlueStore::_fsck(bool deep, bool repair)
 	expecting_shards.clear();
       }
 
+      if ((num_objects & 1023) == 0) {
+	utime_t now = ceph_clock_now();
+	if (now - last_progress >= utime_t(10, 0)) {
+	  double elapsed = now - start;
+	  dout(1) << __func__ << " walked " << num_objects << " objects in "
+		  << elapsed << " seconds ("
+		  << (uint64_t)(num_objects / elapsed) << " objects/sec)"
+		  << dendl;
+	  if (fsck_progress_cb) {
+	    fsck_progress_cb(num_objects, elapsed);
+	  }
+	  last_progress = now;
+	}
+      }
+
       dout(10) << __func__ << "  " << oid << dendl;
       RWLock::RLocker l(c->lock);
       OnodeRef o = c->get_onode(oid, false);
@@ -5829,8 +6477,6 @@ int BlueStore::_fsck(bool deep, bool repair)
       }
       ++num_objects;
       num_spanning_blobs += o->extent_map.spanning_blob_map.size();
-      o->extent_map.fault_range(db, 0, OBJECT_MAX_SIZE);
-      _dump_onode(o, 30);
       // shards
       if (!o->extent_map.shards.empty()) {
 	++num_sharded_objects;
@@ -5848,152 +6494,15 @@ int BlueStore::_fsck(bool deep, bool repair)
 	  ++errors;
 	}
       }
-      // lextents
-      map<BlobRef,bluestore_blob_t::unused_t> referenced;
-      uint64_t pos = 0;
-      mempool::bluestore_fsck::map<BlobRef,
-				   bluestore_blob_use_tracker_t> ref_map;
-      for (auto& l : o->extent_map.extent_map) {
-	dout(20) << __func__ << "    " << l << dendl;
-	if (l.logical_offset < pos) {
-	  derr << "fsck error: " << oid << " lextent at 0x"
-	       << std::hex << l.logical_offset
-	       << " overlaps with the previous, which ends at 0x" << pos
-	       << std::dec << dendl;
-	  ++errors;
-	}
-	if (o->extent_map.spans_shard(l.logical_offset, l.length)) {
-	  derr << "fsck error: " << oid << " lextent at 0x"
-	       << std::hex << l.logical_offset << "~" << l.length
-	       << " spans a shard boundary"
-	       << std::dec << dendl;
-	  ++errors;
-	}
-	pos = l.logical_offset + l.length;
-	expected_statfs.stored += l.length;
-	assert(l.blob);
-	const bluestore_blob_t& blob = l.blob->get_blob();
-
-        auto& ref = ref_map[l.blob];
-        if (ref.is_empty()) {
-          uint32_t min_release_size = blob.get_release_size(min_alloc_size);
-          uint32_t l = blob.get_logical_length();
-          ref.init(l, min_release_size);
-        }
-	ref.get(
-	  l.blob_offset, 
-	  l.length);
-	++num_extents;
-	if (blob.has_unused()) {
-	  auto p = referenced.find(l.blob);
-	  bluestore_blob_t::unused_t *pu;
-	  if (p == referenced.end()) {
-	    pu = &referenced[l.blob];
-	  } else {
-	    pu = &p->second;
-	  }
-	  uint64_t blob_len = blob.get_logical_length();
-	  assert((blob_len % (sizeof(*pu)*8)) == 0);
-	  assert(l.blob_offset + l.length <= blob_len);
-	  uint64_t chunk_size = blob_len / (sizeof(*pu)*8);
-	  uint64_t start = l.blob_offset / chunk_size;
-	  uint64_t end =
-	    ROUND_UP_TO(l.blob_offset + l.length, chunk_size) / chunk_size;
-	  for (auto i = start; i < end; ++i) {
-	    (*pu) |= (1u << i);
-	  }
-	}
-      }
-      for (auto &i : referenced) {
-	dout(20) << __func__ << "  referenced 0x" << std::hex << i.second
-		 << std::dec << " for " << *i.first << dendl;
-	const bluestore_blob_t& blob = i.first->get_blob();
-	if (i.second & blob.unused) {
-	  derr << "fsck error: " << oid << " blob claims unused 0x"
-	       << std::hex << blob.unused
-	       << " but extents reference 0x" << i.second
-	       << " on blob " << *i.first << dendl;
-	  ++errors;
-	}
-	if (blob.has_csum()) {
-	  uint64_t blob_len = blob.get_logical_length();
-	  uint64_t unused_chunk_size = blob_len / (sizeof(blob.unused)*8);
-	  unsigned csum_count = blob.get_csum_count();
-	  unsigned csum_chunk_size = blob.get_csum_chunk_size();
-	  for (unsigned p = 0; p < csum_count; ++p) {
-	    unsigned pos = p * csum_chunk_size;
-	    unsigned firstbit = pos / unused_chunk_size;    // [firstbit,lastbit]
-	    unsigned lastbit = (pos + csum_chunk_size - 1) / unused_chunk_size;
-	    unsigned mask = 1u << firstbit;
-	    for (unsigned b = firstbit + 1; b <= lastbit; ++b) {
-	      mask |= 1u << b;
-	    }
-	    if ((blob.unused & mask) == mask) {
-	      // this csum chunk region is marked unused
-	      if (blob.get_csum_item(p) != 0) {
-		derr << "fsck error: " << oid
-		     << " blob claims csum chunk 0x" << std::hex << pos
-		     << "~" << csum_chunk_size
-		     << " is unused (mask 0x" << mask << " of unused 0x"
-		     << blob.unused << ") but csum is non-zero 0x"
-		     << blob.get_csum_item(p) << std::dec << " on blob "
-		     << *i.first << dendl;
-		++errors;
-	      }
-	    }
-	  }
-	}
-      }
-      for (auto &i : ref_map) {
-	++num_blobs;
-	const bluestore_blob_t& blob = i.first->get_blob();
-	bool equal = i.first->get_blob_use_tracker().equal(i.second);
-	if (!equal) {
-	  derr << "fsck error: " << oid << " blob " << *i.first
-	       << " doesn't match expected ref_map " << i.second << dendl;
-	  ++errors;
-	}
-	if (blob.is_compressed()) {
-	  expected_statfs.compressed += blob.get_compressed_payload_length();
-	  expected_statfs.compressed_original += 
-	    i.first->get_referenced_bytes();
-	}
-	if (blob.is_shared()) {
-	  if (i.first->shared_blob->get_sbid() > blobid_max) {
-	    derr << "fsck error: " << oid << " blob " << blob
-		 << " sbid " << i.first->shared_blob->get_sbid() << " > blobid_max "
-		 << blobid_max << dendl;
-	    ++errors;
-	  } else if (i.first->shared_blob->get_sbid() == 0) {
-            derr << "fsck error: " << oid << " blob " << blob
-                 << " marked as shared but has uninitialized sbid"
-                 << dendl;
-            ++errors;
-          }
-	  sb_info_t& sbi = sb_info[i.first->shared_blob->get_sbid()];
-	  sbi.sb = i.first->shared_blob;
-	  sbi.oids.push_back(oid);
-	  sbi.compressed = blob.is_compressed();
-	  for (auto e : blob.get_extents()) {
-	    if (e.is_valid()) {
-	      sbi.ref_map.get(e.offset, e.length);
-	    }
-	  }
-	} else {
-	  errors += _fsck_check_extents(oid, blob.get_extents(),
-					blob.is_compressed(),
-					used_blocks,
-					expected_statfs);
-        }
-      }
-      if (deep) {
-	bufferlist bl;
-	int r = _do_read(c.get(), o, 0, o->onode.size, bl, 0);
-	if (r < 0) {
-	  ++errors;
-	  derr << "fsck error: " << oid << " error during read: "
-	       << cpp_strerror(r) << dendl;
+      if (fsck_workers.empty()) {
+	_fsck_check_object(fsck_shards[0], c.get(), o, deep);
+      } else {
+	std::unique_lock<std::mutex> ql(fsck_q.lock);
+	while (fsck_q.q.size() >= fsck_q.max) {
+	  fsck_q.cond.wait(ql);
 	}
+	fsck_q.q.emplace_back(c, o);
+	fsck_q.cond.notify_all();
       }
       // omap
       if (o->onode.has_omap()) {
@@ -6008,6 +6517,12 @@ int BlueStore::_fsck(bool deep, bool repair)
 	}
       }
     }
+    stop_fsck_workers();
+    for (auto& sh : fsck_shards) {
+      num_extents += sh.num_extents;
+      num_blobs += sh.num_blobs;
+      _fsck_merge_shard(sh, used_blocks, expected_statfs, sb_info, &errors);
+    }
   }
   dout(1) << __func__ << " checking shared_blobs" << dendl;
   it = db->get_iterator(PREFIX_SHARED_BLOB);
@@ -6028,7 +6543,7 @@ int BlueStore::_fsck(bool deep, bool repair)
 	++errors;
       } else {
 	++num_shared_blobs;
-	sb_info_t& sbi = p->second;
+	fsck_sb_info_t& sbi = p->second;
 	bluestore_shared_blob_t shared_blob(sbid);
 	bufferlist bl = it->value();
 	bufferlist::iterator blp = bl.begin();
@@ -6441,7 +6956,40 @@ int BlueStore::set_collection_opts(
   if (!c->exists)
     return -ENOENT;
   RWLock::WLocker l(c->lock);
+  string old_dict, new_dict;
+  c->pool_opts.get(pool_opts_t::COMPRESSION_DICTIONARY, &old_dict);
+  opts.get(pool_opts_t::COMPRESSION_DICTIONARY, &new_dict);
   c->pool_opts = opts;
+  if (new_dict != old_dict || (!new_dict.empty() && !c->dict_compressor)) {
+    c->dict_compressor.reset();
+    // the option lists the current dictionary first, followed by the
+    // ones it replaced; loading a dictionary lets any zstd compressor
+    // read the blobs written with it
+    CompressorRef cp;
+    if (!new_dict.empty()) {
+      cp = Compressor::create(cct, "zstd");
+    }
+    vector<string> encoded;
+    get_str_vec(new_dict, ",", encoded);
+    for (auto& e : encoded) {
+      bufferlist in, dict;
+      in.append(e);
+      CompressorRef dc;
+      try {
+	dict.decode_base64(in);
+	if (cp) {
+	  dc = cp->with_dictionary(dict);
+	}
+      } catch (buffer::error& err) {
+      }
+      if (!dc) {
+	derr << __func__ << " " << cid
+	     << " unable to load compression dictionary" << dendl;
+      } else if (!c->dict_compressor) {
+	c->dict_compressor = dc;
+      }
+    }
+  }
   return 0;
 }
 
@@ -6575,11 +7123,22 @@ int BlueStore::_do_read(
     dout(20) << __func__ << " defaulting to buffered read" << dendl;
     buffered = true;
   }
+  // decompression is expensive enough that its result is worth keeping
+  // around even for reads that would not be cached otherwise.
+  bool cache_decompressed = buffered ||
+    (cct->_conf->bluestore_cache_decompressed &&
+     (op_flags & CEPH_OSD_OP_FLAG_FADVISE_NOCACHE) == 0);
 
   if (offset + length > o->onode.size) {
     length = o->onode.size - offset;
   }
 
+  // the result is assembled from substrings of the (aligned) device and
+  // cache buffers, so MOSDOpReply and the messenger end up sharing the
+  // same buffer::raw's.  track the bytes that do not come from there
+  // (decompressed data and zero-filled holes).
+  uint64_t copied = 0;
+
   utime_t start = ceph_clock_now();
   o->extent_map.fault_range(db, offset, length);
   logger->tinc(l_bluestore_read_onode_meta_lat, ceph_clock_now() - start);
@@ -6618,6 +7177,13 @@ int BlueStore::_do_read(
 	     << " cache has 0x" << cache_interval
 	     << std::dec << dendl;
 
+    if (bptr->get_blob().is_compressed() && cache_interval.size()) {
+      Cache *cache = bptr->shared_blob->get_cache();
+      cache->logger->inc(l_bluestore_decompressed_hit_bytes,
+			 cache_interval.size());
+      cache->decompressed_hit_bytes += cache_interval.size();
+    }
+
     auto pc = cache_res.begin();
     while (b_len > 0) {
       unsigned l;
@@ -6767,18 +7333,42 @@ int BlueStore::_do_read(
       r = _decompress(compressed_bl, &raw_bl);
       if (r < 0)
 	return r;
-      if (buffered) {
-	bptr->shared_blob->bc.did_read(bptr->shared_blob->get_cache(), 0,
-				       raw_bl);
+      if (cache_decompressed) {
+	Cache *cache = bptr->shared_blob->get_cache();
+	bptr->shared_blob->bc.did_read(cache, 0, raw_bl);
+	cache->logger->inc(l_bluestore_decompressed_cache_bytes,
+			   raw_bl.length());
+	cache->decompressed_cache_bytes += raw_bl.length();
       }
       for (auto& i : b2r_it->second) {
 	ready_regions[i.logical_offset].substr_of(
 	  raw_bl, i.blob_xoffset, i.length);
+	copied += i.length;
       }
     } else {
       for (auto& reg : b2r_it->second) {
-	if (_verify_csum(o, &bptr->get_blob(), reg.r_off, reg.bl,
-			 reg.logical_offset) < 0) {
+	// the read is rounded to the device block size, which can span
+	// several csum chunks: unless all of it goes to the cache, only
+	// the chunks holding the requested bytes need to be verified
+	const bluestore_blob_t& blob = bptr->get_blob();
+	uint64_t v_off = 0;
+	uint64_t v_len = reg.bl.length();
+	if (!buffered && blob.has_csum()) {
+	  uint64_t csum_chunk = blob.get_csum_chunk_size();
+	  v_off = P2ALIGN(reg.front, csum_chunk);
+	  v_len = P2ROUNDUP(reg.front + reg.length, csum_chunk) - v_off;
+	}
+	int vr;
+	if (v_len < reg.bl.length()) {
+	  bufferlist vbl;
+	  vbl.substr_of(reg.bl, v_off, v_len);
+	  vr = _verify_csum(o, &blob, reg.r_off + v_off, vbl,
+			    reg.logical_offset - reg.front + v_off);
+	} else {
+	  vr = _verify_csum(o, &blob, reg.r_off, reg.bl,
+			    reg.logical_offset - reg.front);
+	}
+	if (vr < 0) {
 	  return -EIO;
 	}
 	if (buffered) {
@@ -6816,12 +7406,15 @@ int BlueStore::_do_read(
 	       << ": zeros for 0x" << (pos + offset) << "~" << l
 	       << std::dec << dendl;
       bl.append_zero(l);
+      copied += l;
       pos += l;
     }
   }
   assert(bl.length() == length);
   assert(pos == length);
   assert(pr == pr_end);
+  logger->inc(l_bluestore_read_bytes, length);
+  logger->inc(l_bluestore_read_copied_bytes, copied);
   r = bl.length();
   return r;
 }
@@ -7342,10 +7935,11 @@ int BlueStore::omap_get(
   {
     const string& prefix =
       o->onode.is_pgmeta_omap() ? PREFIX_PGMETA_OMAP : PREFIX_OMAP;
-    KeyValueDB::Iterator it = db->get_iterator(prefix);
     string head, tail;
     get_omap_header(o->onode.nid, &head);
     get_omap_tail(o->onode.nid, &tail);
+    KeyValueDB::Iterator it = db->get_bounded_iterator(prefix, tail);
+    logger->inc(l_bluestore_omap_seeks);
     it->lower_bound(head);
     while (it->valid()) {
       if (it->key() == head) {
@@ -7455,10 +8049,11 @@ int BlueStore::omap_get_keys(
   {
     const string& prefix =
       o->onode.is_pgmeta_omap() ? PREFIX_PGMETA_OMAP : PREFIX_OMAP;
-    KeyValueDB::Iterator it = db->get_iterator(prefix);
     string head, tail;
     get_omap_key(o->onode.nid, string(), &head);
     get_omap_tail(o->onode.nid, &tail);
+    KeyValueDB::Iterator it = db->get_bounded_iterator(prefix, tail);
+    logger->inc(l_bluestore_omap_seeks);
     it->lower_bound(head);
     while (it->valid()) {
       if (it->key() >= tail) {
@@ -7519,15 +8114,21 @@ int BlueStore::omap_get_values(
     o->flush();
     _key_encode_u64(o->onode.nid, &final_key);
     final_key.push_back('.');
+    // the keys share their prefix, so their order is kept and they are
+    // all fetched with a single batched lookup
+    set<string> final_keys;
     for (set<string>::const_iterator p = keys.begin(); p != keys.end(); ++p) {
       final_key.resize(9); // keep prefix
       final_key += *p;
-      bufferlist val;
-      if (db->get(prefix, final_key, &val) >= 0) {
-	dout(30) << __func__ << "  got " << pretty_binary_string(final_key)
-		 << " -> " << *p << dendl;
-	out->insert(make_pair(*p, val));
-      }
+      final_keys.insert(final_keys.end(), final_key);
+    }
+    map<string, bufferlist> vals;
+    db->get(prefix, final_keys, &vals);
+    for (auto& v : vals) {
+      dout(30) << __func__ << "  got " << pretty_binary_string(v.first)
+	       << " -> " << v.first.substr(9) << dendl;
+      out->insert(out->end(), make_pair(v.first.substr(9),
+					std::move(v.second)));
     }
   }
  out:
@@ -7576,18 +8177,18 @@ int BlueStore::omap_check_keys(
     o->flush();
     _key_encode_u64(o->onode.nid, &final_key);
     final_key.push_back('.');
+    set<string> final_keys;
     for (set<string>::const_iterator p = keys.begin(); p != keys.end(); ++p) {
       final_key.resize(9); // keep prefix
       final_key += *p;
-      bufferlist val;
-      if (db->get(prefix, final_key, &val) >= 0) {
-	dout(30) << __func__ << "  have " << pretty_binary_string(final_key)
-		 << " -> " << *p << dendl;
-	out->insert(*p);
-      } else {
-	dout(30) << __func__ << "  miss " << pretty_binary_string(final_key)
-		 << " -> " << *p << dendl;
-      }
+      final_keys.insert(final_keys.end(), final_key);
+    }
+    map<string, bufferlist> vals;
+    db->get(prefix, final_keys, &vals);
+    for (auto& v : vals) {
+      dout(30) << __func__ << "  have " << pretty_binary_string(v.first)
+	       << " -> " << v.first.substr(9) << dendl;
+      out->insert(out->end(), v.first.substr(9));
     }
   }
  out:
@@ -7627,8 +8228,12 @@ ObjectMap::ObjectMapIterator BlueStore::get_omap_iterator(
   }
   o->flush();
   dout(10) << __func__ << " has_omap = " << (int)o->onode.has_omap() <<dendl;
-  KeyValueDB::Iterator it = db->get_iterator(
-    o->onode.is_pgmeta_omap() ? PREFIX_PGMETA_OMAP : PREFIX_OMAP);
+  // nothing past this onode's omap tail is of interest, so let the kv
+  // store stop there rather than wander into the next object's keys
+  string tail;
+  get_omap_tail(o->onode.nid, &tail);
+  KeyValueDB::Iterator it = db->get_bounded_iterator(
+    o->onode.is_pgmeta_omap() ? PREFIX_PGMETA_OMAP : PREFIX_OMAP, tail);
   return ObjectMap::ObjectMapIterator(new OmapIteratorImpl(c, o, it));
 }
 
@@ -7865,6 +8470,91 @@ void BlueStore::get_db_statistics(Formatter *f)
   db->get_statistics(f);
 }
 
+void BlueStore::dump_alloc_stats(Formatter *f)
+{
+  f->open_object_section("bluestore_allocator");
+  f->dump_string("type", cct->_conf->bluestore_allocator);
+  if (alloc) {
+    f->dump_unsigned("min_alloc_size", min_alloc_size);
+    f->dump_unsigned("free", alloc->get_free());
+    f->dump_float("fragmentation_rating",
+		  alloc->get_fragmentation(min_alloc_size));
+  }
+  f->close_section();
+}
+
+void BlueStore::dump_cache_stats(Formatter *f)
+{
+  f->open_object_section("bluestore_cache");
+  f->dump_string("type", cct->_conf->bluestore_cache_type);
+  f->dump_unsigned("cache_size", cache_size);
+  f->dump_float("meta_ratio", cache_meta_ratio);
+  f->dump_float("data_ratio", cache_data_ratio);
+  f->dump_float("kv_ratio", cache_kv_ratio);
+  f->open_array_section("shards");
+  for (unsigned i = 0; i < cache_shards.size(); ++i) {
+    f->open_object_section("shard");
+    f->dump_unsigned("id", i);
+    cache_shards[i]->dump_stats(f);
+    f->close_section();
+  }
+  f->close_section();
+  f->close_section();
+}
+
+static const char *state_lat_names[] = {
+  "prepare",
+  "aio_wait",
+  "io_done",
+  "kv_queued",
+  "kv_committing",
+  "kv_done",
+  "deferred_queued",
+  "deferred_aio_wait",
+  "deferred_cleanup",
+  "finishing",
+  "done",
+};
+static_assert(sizeof(state_lat_names) / sizeof(state_lat_names[0]) ==
+	      BlueStore::STATE_LAT_NUM,
+	      "state_lat_names out of sync with l_bluestore_state_*_lat");
+
+void BlueStore::pool_write_stats_t::dump(Formatter *f) const
+{
+  f->dump_unsigned("txcs", txcs);
+  f->dump_unsigned("bytes", bytes);
+  f->dump_unsigned("deferred_ops", deferred_ops);
+  f->dump_unsigned("deferred_bytes", deferred_bytes);
+  volatile_statfs s = statfs;
+  f->dump_int("allocated", s.allocated());
+  f->dump_int("stored", s.stored());
+  f->dump_int("compressed", s.compressed());
+  f->dump_int("compressed_original", s.compressed_original());
+  f->dump_int("compressed_allocated", s.compressed_allocated());
+  f->dump_stream("lat") << lat;
+  f->open_object_section("state_lat");
+  for (int i = 0; i < STATE_LAT_NUM; ++i) {
+    f->dump_stream(state_lat_names[i]) << state_lat[i];
+  }
+  f->close_section();
+}
+
+void BlueStore::dump_pool_stats(Formatter *f)
+{
+  f->open_object_section("bluestore_pool_stats");
+  f->dump_bool("enabled", pool_stats_enabled);
+  f->open_array_section("pools");
+  std::lock_guard<std::mutex> l(pool_stats_lock);
+  for (auto& p : pool_stats) {
+    f->open_object_section("pool");
+    f->dump_int("pool", p.first);
+    p.second.dump(f);
+    f->close_section();
+  }
+  f->close_section();
+  f->close_section();
+}
+
 BlueStore::TransContext *BlueStore::_txc_create(OpSequencer *osr)
 {
   TransContext *txc = new TransContext(cct, osr);
@@ -7903,6 +8593,11 @@ void BlueStore::_txc_update_store_statfs(TransContext *txc)
   if (txc->statfs_delta.is_empty())
     return;
 
+  if (txc->pool >= 0) {
+    std::lock_guard<std::mutex> l(pool_stats_lock);
+    pool_stats[txc->pool].statfs += txc->statfs_delta;
+  }
+
   logger->inc(l_bluestore_allocated, txc->statfs_delta.allocated());
   logger->inc(l_bluestore_stored, txc->statfs_delta.stored());
   logger->inc(l_bluestore_compressed, txc->statfs_delta.compressed());
@@ -8119,6 +8814,14 @@ void BlueStore::_txc_write_nodes(TransContext *txc, KeyValueDB::Transaction t)
     o->flushing_count++;
   }
 
+  // onodes whose attrs are all that changed (also in modified_objects)
+  for (auto& p : txc->attr_patches) {
+    dout(20) << __func__ << " onode " << p.first->oid << " attr patch is "
+	     << p.second.length() << " bytes" << dendl;
+    t->merge(PREFIX_OBJ, string(p.first->key.c_str(), p.first->key.size()),
+	     p.second);
+  }
+
   // objects we modified but didn't affect the onode
   auto p = txc->modified_objects.begin();
   while (p != txc->modified_objects.end()) {
@@ -8211,6 +8914,25 @@ void BlueStore::_txc_finalize_kv(TransContext *txc, KeyValueDB::Transaction t)
   _txc_update_store_statfs(txc);
 }
 
+void BlueStore::_txc_update_pool_stats(TransContext *txc)
+{
+  utime_t lat = ceph_clock_now() - txc->start;
+  std::lock_guard<std::mutex> l(pool_stats_lock);
+  pool_write_stats_t& ps = pool_stats[txc->pool];
+  ++ps.txcs;
+  ps.bytes += txc->bytes;
+  if (txc->deferred_txn) {
+    for (auto& op : txc->deferred_txn->ops) {
+      ++ps.deferred_ops;
+      ps.deferred_bytes += op.data.length();
+    }
+  }
+  ps.lat += lat;
+  for (int i = 0; i < STATE_LAT_NUM; ++i) {
+    ps.state_lat[i] += txc->state_lat[i];
+  }
+}
+
 void BlueStore::_txc_applied_kv(TransContext *txc)
 {
   for (auto ls : { &txc->onodes, &txc->modified_objects }) {
@@ -8310,6 +9032,9 @@ void BlueStore::_txc_finish(TransContext *txc)
     _txc_release_alloc(txc);
     releasing_txc.pop_front();
     txc->log_state_latency(logger, l_bluestore_state_done_lat);
+    if (txc->pool >= 0) {
+      _txc_update_pool_stats(txc);
+    }
     delete txc;
   }
 
@@ -8381,9 +9106,9 @@ void BlueStore::_osr_drain_all()
     std::lock_guard<std::mutex> l(kv_lock);
     kv_cond.notify_one();
   }
-  {
-    std::lock_guard<std::mutex> l(kv_finalize_lock);
-    kv_finalize_cond.notify_one();
+  for (auto sh : kv_finalize_shards) {
+    std::lock_guard<std::mutex> l(sh->lock);
+    sh->cond.notify_one();
   }
   for (auto osr : s) {
     dout(20) << __func__ << " drain " << osr << dendl;
@@ -8446,12 +9171,38 @@ void BlueStore::_kv_start()
     finishers.push_back(f);
   }
 
+  int num_final = MAX(1, cct->_conf->get_val<int64_t>(
+			  "bluestore_kv_finalize_threads"));
+  for (int i = 0; i < num_final; ++i) {
+    KVFinalizeShard *sh = new KVFinalizeShard(this, i);
+    PerfCountersBuilder b(cct, "bluestore_kv_final-" + stringify(i),
+			  l_bluestore_kv_final_first,
+			  l_bluestore_kv_final_last);
+    b.add_u64_counter(l_bluestore_kv_final_txc, "txc",
+		      "Transactions finalized by this shard");
+    b.add_u64_avg(l_bluestore_kv_final_batch, "batch",
+		  "Transactions and deferred batches finalized per wakeup");
+    b.add_time_avg(l_bluestore_kv_final_queue_lat, "queue_lat",
+		   "Time committed work waited for the finalize thread");
+    b.add_time_avg(l_bluestore_kv_final_lat, "lat",
+		   "Time spent finalizing one batch");
+    sh->logger = b.create_perf_counters();
+    cct->get_perfcounters_collection()->add(sh->logger);
+    kv_finalize_shards.push_back(sh);
+  }
+
   deferred_finisher.start();
   for (auto f : finishers) {
     f->start();
   }
   kv_sync_thread.create("bstore_kv_sync");
-  kv_finalize_thread.create("bstore_kv_final");
+  for (auto sh : kv_finalize_shards) {
+    if (kv_finalize_shards.size() == 1) {
+      sh->thread.create("bstore_kv_final");
+    } else {
+      sh->thread.create(("bstore_kvfin_" + stringify(sh->id)).c_str());
+    }
+  }
 }
 
 void BlueStore::_kv_stop()
@@ -8465,24 +9216,30 @@ void BlueStore::_kv_stop()
     kv_stop = true;
     kv_cond.notify_all();
   }
-  {
-    std::unique_lock<std::mutex> l(kv_finalize_lock);
-    while (!kv_finalize_started) {
-      kv_finalize_cond.wait(l);
+  for (auto sh : kv_finalize_shards) {
+    std::unique_lock<std::mutex> l(sh->lock);
+    while (!sh->started) {
+      sh->cond.wait(l);
     }
-    kv_finalize_stop = true;
-    kv_finalize_cond.notify_all();
+    sh->stop = true;
+    sh->cond.notify_all();
   }
   kv_sync_thread.join();
-  kv_finalize_thread.join();
+  for (auto sh : kv_finalize_shards) {
+    sh->thread.join();
+  }
   {
     std::lock_guard<std::mutex> l(kv_lock);
     kv_stop = false;
   }
-  {
-    std::lock_guard<std::mutex> l(kv_finalize_lock);
-    kv_finalize_stop = false;
+  for (auto sh : kv_finalize_shards) {
+    assert(sh->committing_to_finalize.empty());
+    assert(sh->deferred_stable_to_finalize.empty());
+    cct->get_perfcounters_collection()->remove(sh->logger);
+    delete sh->logger;
+    delete sh;
   }
+  kv_finalize_shards.clear();
   dout(10) << __func__ << " stopping finishers" << dendl;
   deferred_finisher.wait_for_empty();
   deferred_finisher.stop();
@@ -8508,7 +9265,18 @@ void BlueStore::_kv_sync_thread()
       if (kv_stop)
 	break;
       dout(20) << __func__ << " sleep" << dendl;
-      kv_cond.wait(l);
+      double interval = max_defer_interval.load();
+      if (interval > 0 && deferred_queue_size) {
+	// make sure an idle store does not sit on deferred writes forever
+	if (kv_cond.wait_for(l, ceph::make_timespan(interval)) ==
+	    std::cv_status::timeout) {
+	  l.unlock();
+	  deferred_try_submit(true);
+	  l.lock();
+	}
+      } else {
+	kv_cond.wait(l);
+      }
       dout(20) << __func__ << " wake" << dendl;
     } else {
       deque<TransContext*> kv_submitting;
@@ -8660,28 +9428,9 @@ void BlueStore::_kv_sync_thread()
       int r = cct->_conf->bluestore_debug_omit_kv_commit ? 0 : db->submit_transaction_sync(synct);
       assert(r == 0);
 
-      {
-	std::unique_lock<std::mutex> m(kv_finalize_lock);
-	if (kv_committing_to_finalize.empty()) {
-	  kv_committing_to_finalize.swap(kv_committing);
-	} else {
-	  kv_committing_to_finalize.insert(
-	      kv_committing_to_finalize.end(),
-	      kv_committing.begin(),
-	      kv_committing.end());
-	  kv_committing.clear();
-	}
-	if (deferred_stable_to_finalize.empty()) {
-	  deferred_stable_to_finalize.swap(deferred_stable);
-	} else {
-	  deferred_stable_to_finalize.insert(
-	      deferred_stable_to_finalize.end(),
-	      deferred_stable.begin(),
-	      deferred_stable.end());
-	  deferred_stable.clear();
-	}
-	kv_finalize_cond.notify_one();
-      }
+      size_t num_committed = kv_committing.size();
+      size_t num_cleaned = deferred_stable.size();
+      _kv_queue_finalize(kv_committing, deferred_stable);
 
       if (new_nid_max) {
 	nid_max = new_nid_max;
@@ -8697,8 +9446,8 @@ void BlueStore::_kv_sync_thread()
 	utime_t dur_flush = after_flush - start;
 	utime_t dur_kv = finish - after_flush;
 	utime_t dur = finish - start;
-	dout(20) << __func__ << " committed " << kv_committing.size()
-	  << " cleaned " << deferred_stable.size()
+	dout(20) << __func__ << " committed " << num_committed
+	  << " cleaned " << num_cleaned
 	  << " in " << dur
 	  << " (" << dur_flush << " flush + " << dur_kv << " kv commit)"
 	  << dendl;
@@ -8729,32 +9478,89 @@ void BlueStore::_kv_sync_thread()
   kv_sync_started = false;
 }
 
-void BlueStore::_kv_finalize_thread()
+void BlueStore::_kv_queue_finalize(deque<TransContext*>& committed,
+				   deque<DeferredBatch*>& stable)
+{
+  if (kv_finalize_shards.size() == 1) {
+    KVFinalizeShard *sh = kv_finalize_shards[0];
+    sh->staged_txcs.swap(committed);
+    sh->staged_deferred.swap(stable);
+  } else {
+    for (auto txc : committed) {
+      _get_kv_finalize_shard(txc->osr.get())->staged_txcs.push_back(txc);
+    }
+    for (auto b : stable) {
+      _get_kv_finalize_shard(b->osr)->staged_deferred.push_back(b);
+    }
+  }
+  committed.clear();
+  stable.clear();
+
+  utime_t now = ceph_clock_now();
+  for (auto sh : kv_finalize_shards) {
+    if (sh->staged_txcs.empty() && sh->staged_deferred.empty()) {
+      continue;
+    }
+    std::lock_guard<std::mutex> m(sh->lock);
+    if (sh->committing_to_finalize.empty()) {
+      sh->committing_to_finalize.swap(sh->staged_txcs);
+    } else {
+      sh->committing_to_finalize.insert(
+	  sh->committing_to_finalize.end(),
+	  sh->staged_txcs.begin(),
+	  sh->staged_txcs.end());
+      sh->staged_txcs.clear();
+    }
+    if (sh->deferred_stable_to_finalize.empty()) {
+      sh->deferred_stable_to_finalize.swap(sh->staged_deferred);
+    } else {
+      sh->deferred_stable_to_finalize.insert(
+	  sh->deferred_stable_to_finalize.end(),
+	  sh->staged_deferred.begin(),
+	  sh->staged_deferred.end());
+      sh->staged_deferred.clear();
+    }
+    if (sh->queued_stamp == utime_t()) {
+      sh->queued_stamp = now;
+    }
+    sh->cond.notify_one();
+  }
+}
+
+void BlueStore::_kv_finalize_thread(KVFinalizeShard *sh)
 {
   deque<TransContext*> kv_committed;
   deque<DeferredBatch*> deferred_stable;
-  dout(10) << __func__ << " start" << dendl;
-  std::unique_lock<std::mutex> l(kv_finalize_lock);
-  assert(!kv_finalize_started);
-  kv_finalize_started = true;
-  kv_finalize_cond.notify_all();
+  dout(10) << __func__ << " " << sh->id << " start" << dendl;
+  std::unique_lock<std::mutex> l(sh->lock);
+  assert(!sh->started);
+  sh->started = true;
+  sh->cond.notify_all();
   while (true) {
     assert(kv_committed.empty());
     assert(deferred_stable.empty());
-    if (kv_committing_to_finalize.empty() &&
-	deferred_stable_to_finalize.empty()) {
-      if (kv_finalize_stop)
+    if (sh->committing_to_finalize.empty() &&
+	sh->deferred_stable_to_finalize.empty()) {
+      if (sh->stop)
 	break;
-      dout(20) << __func__ << " sleep" << dendl;
-      kv_finalize_cond.wait(l);
-      dout(20) << __func__ << " wake" << dendl;
+      dout(20) << __func__ << " " << sh->id << " sleep" << dendl;
+      sh->cond.wait(l);
+      dout(20) << __func__ << " " << sh->id << " wake" << dendl;
     } else {
-      kv_committed.swap(kv_committing_to_finalize);
-      deferred_stable.swap(deferred_stable_to_finalize);
+      kv_committed.swap(sh->committing_to_finalize);
+      deferred_stable.swap(sh->deferred_stable_to_finalize);
+      utime_t start = ceph_clock_now();
+      sh->logger->tinc(l_bluestore_kv_final_queue_lat,
+		       start - sh->queued_stamp);
+      sh->queued_stamp = utime_t();
       l.unlock();
       dout(20) << __func__ << " kv_committed " << kv_committed << dendl;
       dout(20) << __func__ << " deferred_stable " << deferred_stable << dendl;
 
+      sh->logger->inc(l_bluestore_kv_final_txc, kv_committed.size());
+      sh->logger->inc(l_bluestore_kv_final_batch,
+		      kv_committed.size() + deferred_stable.size());
+
       while (!kv_committed.empty()) {
 	TransContext *txc = kv_committed.front();
 	assert(txc->state == TransContext::STATE_KV_SUBMITTED);
@@ -8777,17 +9583,20 @@ void BlueStore::_kv_finalize_thread()
 	if (deferred_queue_size >= deferred_batch_ops.load() ||
 	    throttle_deferred_bytes.past_midpoint()) {
 	  deferred_try_submit();
+	} else {
+	  deferred_try_submit(true);
 	}
       }
 
       // this is as good a place as any ...
       _reap_collections();
 
+      sh->logger->tinc(l_bluestore_kv_final_lat, ceph_clock_now() - start);
       l.lock();
     }
   }
-  dout(10) << __func__ << " finish" << dendl;
-  kv_finalize_started = false;
+  dout(10) << __func__ << " " << sh->id << " finish" << dendl;
+  sh->started = false;
 }
 
 bluestore_deferred_op_t *BlueStore::_get_deferred_op(
@@ -8823,7 +9632,10 @@ void BlueStore::_deferred_queue(TransContext *txc)
 	cct, wt.seq, e.offset, e.length, p);
     }
   }
-  if (deferred_aggressive &&
+  uint64_t batch_bytes = deferred_batch_bytes.load();
+  bool full = batch_bytes &&
+    txc->osr->deferred_pending->bytes >= batch_bytes;
+  if ((deferred_aggressive || full) &&
       !txc->osr->deferred_running) {
     _deferred_submit_unlock(txc->osr.get());
   } else {
@@ -8831,11 +9643,21 @@ void BlueStore::_deferred_queue(TransContext *txc)
   }
 }
 
-void BlueStore::deferred_try_submit()
+void BlueStore::deferred_try_submit(bool only_expired)
 {
   dout(20) << __func__ << " " << deferred_queue.size() << " osrs, "
 	   << deferred_queue_size << " txcs" << dendl;
   std::lock_guard<std::mutex> l(deferred_lock);
+  if (only_expired) {
+    double interval = max_defer_interval.load();
+    if (interval <= 0 || !deferred_queue_size ||
+	mono_clock::now() - deferred_last_submitted <
+	  ceph::make_timespan(interval)) {
+      return;
+    }
+    dout(10) << __func__ << " deferred writes queued for more than "
+	     << interval << "s, submitting" << dendl;
+  }
   vector<OpSequencerRef> osrs;
   osrs.reserve(deferred_queue.size());
   for (auto& osr : deferred_queue) {
@@ -8870,13 +9692,17 @@ void BlueStore::_deferred_submit_unlock(OpSequencer *osr)
 
   osr->deferred_running = osr->deferred_pending;
   osr->deferred_pending = nullptr;
+  deferred_last_submitted = mono_clock::now();
 
   deferred_lock.unlock();
 
   for (auto& txc : b->txcs) {
     txc.log_state_latency(logger, l_bluestore_state_deferred_queued_lat);
   }
+  // iomap is sorted by offset and free of overlaps (see _discard), so
+  // contiguous extents from any txc in the batch coalesce into one io.
   uint64_t start = 0, pos = 0;
+  uint64_t ios = 0;
   bufferlist bl;
   auto i = b->iomap.begin();
   while (true) {
@@ -8885,6 +9711,7 @@ void BlueStore::_deferred_submit_unlock(OpSequencer *osr)
 	dout(20) << __func__ << " write 0x" << std::hex
 		 << start << "~" << bl.length()
 		 << " crc " << bl.crc32c(-1) << std::dec << dendl;
+	++ios;
 	if (!g_conf->bluestore_debug_omit_block_device_write) {
 	  logger->inc(l_bluestore_deferred_write_ops);
 	  logger->inc(l_bluestore_deferred_write_bytes, bl.length());
@@ -8909,6 +9736,7 @@ void BlueStore::_deferred_submit_unlock(OpSequencer *osr)
     bl.claim_append(i->second.bl);
     ++i;
   }
+  logger->inc(l_bluestore_deferred_write_merged, b->iomap.size() - ios);
 
   bdev->aio_submit(&b->ioc);
 }
@@ -9120,6 +9948,15 @@ void BlueStore::_txc_add_transaction(TransContext *txc, Transaction *t)
        ++p, ++j) {
     cvec[j] = _get_collection(*p);
   }
+  if (txc->pool < 0 && pool_stats_enabled) {
+    for (auto& c : cvec) {
+      spg_t pgid;
+      if (c && c->cid.is_pg(&pgid)) {
+	txc->pool = pgid.pool();
+	break;
+      }
+    }
+  }
   vector<OnodeRef> ovec(i.objects.size());
 
   for (int pos = 0; i.have_op(); ++pos) {
@@ -9453,6 +10290,102 @@ void BlueStore::_txc_add_transaction(TransContext *txc, Transaction *t)
       }
     }
   }
+
+  for (auto& c : cvec) {
+    if (c && !c->gc_candidates.empty()) {
+      _txc_background_gc(txc, c);
+    }
+  }
+}
+
+/*
+ * Background gc piggybacks on transactions: it runs in the txc of some
+ * later transaction on the same collection, under the collection lock,
+ * so it is ordered with everything else done to the object.  It only
+ * runs while the store is not busy, within bluestore_gc_background_*.
+ */
+void BlueStore::_txc_background_gc(TransContext *txc, CollectionRef& c)
+{
+  uint64_t rate =
+    cct->_conf->get_val<uint64_t>("bluestore_gc_background_bytes_per_sec");
+  if (!rate ||
+      throttle_bytes.get_current() > throttle_bytes.get_max() / 4) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> l(gc_background_lock);
+    utime_t now = ceph_clock_now();
+    gc_background_budget = std::min<int64_t>(
+      rate,
+      gc_background_budget + (double)rate * (now - gc_background_stamp));
+    gc_background_stamp = now;
+    if (gc_background_budget <= 0) {
+      return;
+    }
+  }
+
+  RWLock::WLocker l(c->lock);
+  if (!c->exists || c->gc_candidates.empty()) {
+    return;
+  }
+  ghobject_t oid = *c->gc_candidates.begin();
+  c->gc_candidates.erase(c->gc_candidates.begin());
+  spg_t pgid;
+  if (c->cid.is_pg(&pgid) && !oid.match(c->cnode.bits, pgid.ps())) {
+    return;  // split off to another collection
+  }
+  OnodeRef o = c->get_onode(oid, false);
+  if (!o || !o->exists) {
+    return;
+  }
+  int64_t r = _do_background_gc(txc, c, o);
+  if (r > 0) {
+    std::lock_guard<std::mutex> l(gc_background_lock);
+    gc_background_budget -= r;
+  }
+}
+
+int64_t BlueStore::_do_background_gc(TransContext *txc, CollectionRef& c,
+				     OnodeRef o)
+{
+  double ratio = cct->_conf->get_val<double>("bluestore_gc_background_ratio");
+  o->extent_map.fault_range(db, 0, o->onode.size);
+
+  // every extent of compressed blobs that lost most of their references
+  vector<AllocExtent> extents_to_collect;
+  int64_t bytes = 0;
+  for (auto& e : o->extent_map.extent_map) {
+    const bluestore_blob_t& blob = e.blob->get_blob();
+    if (!blob.is_compressed() || blob.is_shared()) {
+      continue;  // rewriting a shared blob would not free it
+    }
+    if (e.blob->get_referenced_bytes() <
+	blob.get_logical_length() * ratio) {
+      extents_to_collect.emplace_back(e.logical_offset, e.length);
+      bytes += e.length;
+    }
+  }
+  if (extents_to_collect.empty()) {
+    return 0;
+  }
+  dout(20) << __func__ << " " << o->oid << " rewriting 0x" << std::hex
+	   << bytes << std::dec << " bytes in " << extents_to_collect.size()
+	   << " extents" << dendl;
+
+  WriteContext wctx;
+  _choose_write_options(c, o, 0, &wctx);
+  uint64_t dirty_start = o->onode.size, dirty_end = 0;
+  int r = _do_gc(txc, c, o, extents_to_collect, wctx,
+		 &dirty_start, &dirty_end);
+  if (r < 0) {
+    // like for any other write, there is no undoing a half applied txc
+    derr << __func__ << " _do_gc failed with " << cpp_strerror(r) << dendl;
+    assert(0 == "background gc failed");
+  }
+  o->extent_map.compress_extent_map(dirty_start, dirty_end - dirty_start);
+  o->extent_map.dirty_range(dirty_start, dirty_end - dirty_start);
+  txc->write_onode(o);
+  return bytes;
 }
 
 
@@ -10031,6 +10964,10 @@ int BlueStore::_do_alloc_write(
         return boost::optional<CompressorRef>();
       }
     );
+    if (c && coll->dict_compressor &&
+	c->get_type() == coll->dict_compressor->get_type()) {
+      c = coll->dict_compressor;
+    }
 
     crr = select_option(
       "compression_required_ratio",
@@ -10474,13 +11411,11 @@ int BlueStore::_do_gc(
   TransContext *txc,
   CollectionRef& c,
   OnodeRef o,
-  const GarbageCollector& gc,
+  const vector<AllocExtent>& extents_to_collect,
   const WriteContext& wctx,
   uint64_t *dirty_start,
   uint64_t *dirty_end)
 {
-  auto& extents_to_collect = gc.get_extents_to_collect();
-
   WriteContext wctx_gc;
   wctx_gc.fork(wctx); // make a clone for garbage collection
 
@@ -10545,6 +11480,7 @@ int BlueStore::_do_write(
 
   GarbageCollector gc(c->store->cct);
   int64_t benefit;
+  bool compressed_overwrite = false;
   auto dirty_start = offset;
   auto dirty_end = end;
 
@@ -10566,6 +11502,12 @@ int BlueStore::_do_write(
 		        o->extent_map,
 			wctx.old_extents,
 			min_alloc_size);
+  for (auto& oe : wctx.old_extents) {
+    if (oe.e.blob->get_blob().is_compressed()) {
+      compressed_overwrite = true;
+      break;
+    }
+  }
 
   _wctx_finish(txc, c, o, &wctx);
   if (end > o->onode.size) {
@@ -10578,14 +11520,22 @@ int BlueStore::_do_write(
     if (!gc.get_extents_to_collect().empty()) {
       dout(20) << __func__ << " perform garbage collection, "
                << "expected benefit = " << benefit << " AUs" << dendl;
-      r = _do_gc(txc, c, o, gc, wctx, &dirty_start, &dirty_end);
+      r = _do_gc(txc, c, o, gc.get_extents_to_collect(), wctx,
+		 &dirty_start, &dirty_end);
       if (r < 0) {
         derr << __func__ << " _do_gc failed with " << cpp_strerror(r)
              << dendl;
         goto out;
       }
+      compressed_overwrite = false;
     }
   }
+  if (compressed_overwrite &&
+      cct->_conf->get_val<uint64_t>("bluestore_gc_background_bytes_per_sec") &&
+      c->gc_candidates.size() < 1024) {
+    // leave the rest of the blobs to background gc
+    c->gc_candidates.insert(o->oid);
+  }
 
   o->extent_map.compress_extent_map(dirty_start, dirty_end - dirty_start);
   o->extent_map.dirty_range(dirty_start, dirty_end - dirty_start);
@@ -10842,6 +11792,25 @@ int BlueStore::_remove(TransContext *txc,
   return r;
 }
 
+void BlueStore::_patch_onode_attr(TransContext *txc, OnodeRef& o, __u8 op,
+				  const string& name, const bufferptr& val)
+{
+  bufferlist *patch = nullptr;
+  if (o->exists && cct->_conf->get_val<bool>("bluestore_onode_attr_patch"))
+    patch = txc->get_attr_patch(o);
+  if (!patch) {
+    txc->write_onode(o);
+    return;
+  }
+  if (patch->length() == 0)
+    patch->append(ONODE_ATTR_PATCH);
+  ::encode(op, *patch);
+  if (op != ONODE_ATTR_CLEAR)
+    ::encode(name, *patch);
+  if (op == ONODE_ATTR_SET)
+    ::encode(val, *patch);
+}
+
 int BlueStore::_setattr(TransContext *txc,
 			CollectionRef& c,
 			OnodeRef& o,
@@ -10860,7 +11829,7 @@ int BlueStore::_setattr(TransContext *txc,
     auto& b = o->onode.attrs[name.c_str()] = val;
     b.reassign_to_mempool(mempool::mempool_bluestore_cache_other);
   }
-  txc->write_onode(o);
+  _patch_onode_attr(txc, o, ONODE_ATTR_SET, name, val);
   dout(10) << __func__ << " " << c->cid << " " << o->oid
 	   << " " << name << " (" << val.length() << " bytes)"
 	   << " = " << r << dendl;
@@ -10886,8 +11855,8 @@ int BlueStore::_setattrs(TransContext *txc,
       auto& b = o->onode.attrs[p->first.c_str()] = p->second;
       b.reassign_to_mempool(mempool::mempool_bluestore_cache_other);
     }
+    _patch_onode_attr(txc, o, ONODE_ATTR_SET, p->first, p->second);
   }
-  txc->write_onode(o);
   dout(10) << __func__ << " " << c->cid << " " << o->oid
 	   << " " << aset.size() << " keys"
 	   << " = " << r << dendl;
@@ -10908,7 +11877,7 @@ int BlueStore::_rmattr(TransContext *txc,
     goto out;
 
   o->onode.attrs.erase(it);
-  txc->write_onode(o);
+  _patch_onode_attr(txc, o, ONODE_ATTR_RM, name, bufferptr());
 
  out:
   dout(10) << __func__ << " " << c->cid << " " << o->oid
@@ -10927,7 +11896,7 @@ int BlueStore::_rmattrs(TransContext *txc,
     goto out;
 
   o->onode.attrs.clear();
-  txc->write_onode(o);
+  _patch_onode_attr(txc, o, ONODE_ATTR_CLEAR, string(), bufferptr());
 
  out:
   dout(10) << __func__ << " " << c->cid << " " << o->oid << " = " << r << dendl;
@@ -77,6 +77,8 @@ enum {
   l_bluestore_read_lat,
   l_bluestore_read_onode_meta_lat,
   l_bluestore_read_wait_aio_lat,
+  l_bluestore_read_bytes,
+  l_bluestore_read_copied_bytes,
   l_bluestore_compress_lat,
   l_bluestore_decompress_lat,
   l_bluestore_csum_lat,
@@ -85,6 +87,7 @@ enum {
   l_bluestore_write_pad_bytes,
   l_bluestore_deferred_write_ops,
   l_bluestore_deferred_write_bytes,
+  l_bluestore_deferred_write_merged,
   l_bluestore_write_penalty_read_ops,
   l_bluestore_allocated,
   l_bluestore_stored,
@@ -102,6 +105,8 @@ enum {
   l_bluestore_buffer_bytes,
   l_bluestore_buffer_hit_bytes,
   l_bluestore_buffer_miss_bytes,
+  l_bluestore_decompressed_cache_bytes,
+  l_bluestore_decompressed_hit_bytes,
   l_bluestore_write_big,
   l_bluestore_write_big_bytes,
   l_bluestore_write_big_blobs,
@@ -117,9 +122,21 @@ enum {
   l_bluestore_extent_compress,
   l_bluestore_gc_merged,
   l_bluestore_read_eio,
+  l_bluestore_omap_seeks,
+  l_bluestore_omap_seeks_skipped,
   l_bluestore_last
 };
 
+/// per kv finalize shard counters
+enum {
+  l_bluestore_kv_final_first = 732530,
+  l_bluestore_kv_final_txc,
+  l_bluestore_kv_final_batch,
+  l_bluestore_kv_final_queue_lat,
+  l_bluestore_kv_final_lat,
+  l_bluestore_kv_final_last
+};
+
 class BlueStore : public ObjectStore,
 		  public md_config_obs_t {
   // -----------------------------------------------------
@@ -134,6 +151,7 @@ public:
   void _set_compression();
   void _set_throttle_params();
   int _set_cache_sizes();
+  void _autotune_cache_ratios(float bytes_per_onode);
 
   class TransContext;
 
@@ -751,6 +769,10 @@ public:
     uint32_t needs_reshard_begin = 0;
     uint32_t needs_reshard_end = 0;
 
+    /// average number of shards dirtied per update, in 1/16ths
+    uint16_t dirty_shards_avg = 0;
+    uint8_t dirty_shards_samples = 0;  ///< updates behind the average, capped
+
     bool needs_reshard() const {
       return needs_reshard_end > needs_reshard_begin;
     }
@@ -797,6 +819,8 @@ public:
     }
 
     void update(KeyValueDB::Transaction t, bool force);
+    unsigned get_shard_target(unsigned target, unsigned min_size,
+			      unsigned max_size) const;
     decltype(BlueStore::Blob::id) allocate_spanning_blob_id();
     void reshard(
       KeyValueDB *db,
@@ -1056,6 +1080,17 @@ public:
     std::atomic<uint64_t> num_extents = {0};
     std::atomic<uint64_t> num_blobs = {0};
 
+    // per-shard statistics; updated and read without the cache lock
+    std::atomic<uint64_t> onode_hits = {0};
+    std::atomic<uint64_t> onode_misses = {0};
+    std::atomic<uint64_t> buffer_hit_bytes = {0};
+    std::atomic<uint64_t> buffer_miss_bytes = {0};
+    std::atomic<uint64_t> onodes_evicted = {0};
+    std::atomic<uint64_t> buffer_bytes_evicted = {0};
+    std::atomic<uint64_t> trim_batches = {0};
+    std::atomic<uint64_t> decompressed_cache_bytes = {0};
+    std::atomic<uint64_t> decompressed_hit_bytes = {0};
+
     static Cache *create(CephContext* cct, string type, PerfCounters *logger);
 
     Cache(CephContext* cct) : cct(cct), logger(nullptr) {}
@@ -1107,6 +1142,8 @@ public:
       return _get_num_onodes() == 0 && _get_buffer_bytes() == 0;
     }
 
+    void dump_stats(Formatter *f);
+
 #ifdef DEBUG_CACHE
     virtual void _audit(const char *s) = 0;
 #else
@@ -1351,6 +1388,12 @@ public:
     //pool options
     pool_opts_t pool_opts;
 
+    /// objects with partly overwritten compressed blobs, for background gc
+    set<ghobject_t> gc_candidates;
+
+    // compressor using the pool compression dictionary, if any
+    CompressorRef dict_compressor;
+
     OnodeRef get_onode(const ghobject_t& oid, bool create);
 
     // the terminology is confusing here, sorry!
@@ -1400,6 +1443,9 @@ public:
     OnodeRef o;
     KeyValueDB::Iterator it;
     string head, tail;
+    bool at_head = false;  ///< it still sits where lower_bound(head) left it
+
+    void seek(const string& key, bool upper);
   public:
     OmapIteratorImpl(CollectionRef c, OnodeRef o, KeyValueDB::Iterator it);
     int seek_to_first() override;
@@ -1474,6 +1520,23 @@ public:
     }
   };
 
+  /// number of l_bluestore_state_*_lat counters
+  static constexpr int STATE_LAT_NUM =
+    l_bluestore_state_done_lat - l_bluestore_state_prepare_lat + 1;
+
+  /// write path stats of one pool, see bluestore_pool_stats
+  struct pool_write_stats_t {
+    uint64_t txcs = 0;
+    uint64_t bytes = 0;           ///< txc payload bytes
+    uint64_t deferred_ops = 0;
+    uint64_t deferred_bytes = 0;
+    volatile_statfs statfs;       ///< net change since mount
+    utime_t lat;                  ///< creation to done, sum over txcs
+    utime_t state_lat[STATE_LAT_NUM];  ///< sum over txcs, per state
+
+    void dump(Formatter *f) const;
+  };
+
   struct TransContext : public AioContext {
     MEMPOOL_CLASS_HELPERS();
 
@@ -1532,6 +1595,11 @@ public:
       utime_t lat, now = ceph_clock_now();
       lat = now - last_stamp;
       logger->tinc(state, lat);
+      if (pool >= 0 &&
+	  state >= l_bluestore_state_prepare_lat &&
+	  state <= l_bluestore_state_done_lat) {
+	state_lat[state - l_bluestore_state_prepare_lat] += lat;
+      }
 #if defined(WITH_LTTNG) && defined(WITH_EVENTTRACE)
       if (state >= l_bluestore_state_prepare_lat && state <= l_bluestore_state_done_lat) {
         double usecs = (now.to_nsec()-last_stamp.to_nsec())/1000;
@@ -1546,6 +1614,9 @@ public:
 
     uint64_t bytes = 0, cost = 0;
 
+    int64_t pool = -1;  ///< pool to account to, if bluestore_pool_stats
+    utime_t state_lat[STATE_LAT_NUM];
+
     set<OnodeRef> onodes;     ///< these need to be updated/written
     set<OnodeRef> modified_objects;  ///< objects we modified (and need a ref)
     set<SharedBlobRef> shared_blobs;  ///< these need to be updated/written
@@ -1584,8 +1655,18 @@ public:
       delete deferred_txn;
     }
 
+    map<OnodeRef, bufferlist> attr_patches;  ///< attr-only onode updates
+
     void write_onode(OnodeRef &o) {
       onodes.insert(o);
+      attr_patches.erase(o);
+    }
+    /// patch to append o's attr changes to, or null if o is written anyway
+    bufferlist *get_attr_patch(OnodeRef &o) {
+      if (onodes.count(o))
+	return nullptr;
+      modified_objects.insert(o);
+      return &attr_patches[o];
     }
     void write_shared_blob(SharedBlobRef &sb) {
       shared_blobs.insert(sb);
@@ -1602,6 +1683,7 @@ public:
     void removed(OnodeRef& o) {
       onodes.erase(o);
       modified_objects.erase(o);
+      attr_patches.erase(o);
     }
 
     void aio_finish(BlueStore *store) override {
@@ -1627,6 +1709,7 @@ public:
     IOContext ioc;                   ///< our aios
     /// bytes of pending io for each deferred seq (may be 0)
     map<uint64_t,int> seq_bytes;
+    uint64_t bytes = 0;              ///< bytes queued (incl. overwritten)
 
     void _discard(CephContext *cct, uint64_t offset, uint64_t length);
     void _audit(CephContext *cct);
@@ -1783,15 +1866,46 @@ public:
       return NULL;
     }
   };
+  struct KVFinalizeShard;
   struct KVFinalizeThread : public Thread {
     BlueStore *store;
-    explicit KVFinalizeThread(BlueStore *s) : store(s) {}
-    void *entry() {
-      store->_kv_finalize_thread();
+    KVFinalizeShard *shard;
+    KVFinalizeThread(BlueStore *s, KVFinalizeShard *sh)
+      : store(s), shard(sh) {}
+    void *entry() override {
+      store->_kv_finalize_thread(shard);
       return NULL;
     }
   };
 
+  /**
+   * KVFinalizeShard - one kv finalize thread and its queues
+   *
+   * Committed txcs are routed to a shard by their sequencer's
+   * shard_hint, so all txcs (and deferred batches) of one OpSequencer
+   * are finalized by the same thread, in commit order.
+   */
+  struct KVFinalizeShard {
+    unsigned id;
+    KVFinalizeThread thread;
+    std::mutex lock;
+    std::condition_variable cond;
+    bool started = false;
+    bool stop = false;
+    deque<TransContext*> committing_to_finalize;   ///< pending finalization
+    deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
+    utime_t queued_stamp;  ///< when the oldest pending item was queued
+
+    // only touched by the kv sync thread
+    deque<TransContext*> staged_txcs;
+    deque<DeferredBatch*> staged_deferred;
+
+    PerfCounters *logger = nullptr;
+
+    KVFinalizeShard(BlueStore *store, unsigned i)
+      : id(i), thread(store, this) {}
+  };
+
   struct DBHistogram {
     struct value_dist {
       uint64_t count;
@@ -1847,6 +1961,10 @@ private:
   std::atomic<uint64_t> blobid_max = {0};
 
   Throttle throttle_bytes;          ///< submit to commit
+
+  std::mutex gc_background_lock;
+  int64_t gc_background_budget = 0;  ///< bytes background gc may rewrite
+  utime_t gc_background_stamp;       ///< last budget refill
   Throttle throttle_deferred_bytes;  ///< submit to deferred complete
 
   interval_set<uint64_t> bluefs_extents;  ///< block extents owned by bluefs
@@ -1856,6 +1974,7 @@ private:
   std::atomic<uint64_t> deferred_seq = {0};
   deferred_osr_queue_t deferred_queue; ///< osr's with deferred io pending
   int deferred_queue_size = 0;         ///< num txc's queued across all osrs
+  mono_clock::time_point deferred_last_submitted; ///< last batch submission
   atomic_int deferred_aggressive = {0}; ///< aggressive wakeup of kv thread
   Finisher deferred_finisher;
 
@@ -1868,19 +1987,13 @@ private:
   bool _kv_only = false;
   bool kv_sync_started = false;
   bool kv_stop = false;
-  bool kv_finalize_started = false;
-  bool kv_finalize_stop = false;
   deque<TransContext*> kv_queue;             ///< ready, already submitted
   deque<TransContext*> kv_queue_unsubmitted; ///< ready, need submit by kv thread
   deque<TransContext*> kv_committing;        ///< currently syncing
   deque<DeferredBatch*> deferred_done_queue;   ///< deferred ios done
   deque<DeferredBatch*> deferred_stable_queue; ///< deferred ios done + stable
 
-  KVFinalizeThread kv_finalize_thread;
-  std::mutex kv_finalize_lock;
-  std::condition_variable kv_finalize_cond;
-  deque<TransContext*> kv_committing_to_finalize;   ///< pending finalization
-  deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
+  vector<KVFinalizeShard*> kv_finalize_shards;
 
   PerfCounters *logger = nullptr;
 
@@ -1910,9 +2023,20 @@ private:
   ///< number threshold for forced deferred writes
   std::atomic<int> deferred_batch_ops = {0};
 
+  ///< per-sequencer byte threshold for forced deferred writes (0 = none)
+  std::atomic<uint64_t> deferred_batch_bytes = {0};
+
+  ///< max seconds deferred writes may sit in the queue (0 = no limit)
+  std::atomic<double> max_defer_interval = {0};
+
   ///< size threshold for forced deferred writes
   std::atomic<uint64_t> prefer_deferred_size = {0};
 
+  ///< account write path stats per pool (bluestore_pool_stats)
+  std::atomic<bool> pool_stats_enabled = {false};
+  std::mutex pool_stats_lock;
+  map<int64_t, pool_write_stats_t> pool_stats;  ///< protected by pool_stats_lock
+
   ///< approx cost per io, in bytes
   std::atomic<uint64_t> throttle_cost_per_io = {0};
 
@@ -1933,6 +2057,12 @@ private:
   float cache_kv_ratio = 0;     ///< cache ratio dedicated to kv (e.g., rocksdb)
   float cache_data_ratio = 0;   ///< cache ratio dedicated to object data
 
+  // cache autotune state (only touched by the mempool thread)
+  utime_t cache_autotune_last;
+  uint64_t cache_autotune_onode_misses = 0;
+  uint64_t cache_autotune_buffer_miss_bytes = 0;
+  uint64_t cache_autotune_kv_misses = 0;
+
   std::mutex vstatfs_lock;
   volatile_statfs vstatfs;
 
@@ -2025,6 +2155,7 @@ private:
 
   TransContext *_txc_create(OpSequencer *osr);
   void _txc_update_store_statfs(TransContext *txc);
+  void _txc_update_pool_stats(TransContext *txc);
   void _txc_add_transaction(TransContext *txc, Transaction *t);
   void _txc_calc_cost(TransContext *txc);
   void _txc_write_nodes(TransContext *txc, KeyValueDB::Transaction t);
@@ -2049,12 +2180,23 @@ private:
   void _kv_start();
   void _kv_stop();
   void _kv_sync_thread();
-  void _kv_finalize_thread();
+  void _kv_finalize_thread(KVFinalizeShard *shard);
+  /// hand committed txcs and stable deferred batches to the finalizers
+  void _kv_queue_finalize(deque<TransContext*>& committed,
+			  deque<DeferredBatch*>& stable);
+  KVFinalizeShard *_get_kv_finalize_shard(OpSequencer *osr) {
+    if (kv_finalize_shards.size() == 1 || !osr->parent) {
+      return kv_finalize_shards[0];
+    }
+    unsigned n = osr->parent->shard_hint.hash_to_shard(
+      kv_finalize_shards.size());
+    return kv_finalize_shards[n];
+  }
 
   bluestore_deferred_op_t *_get_deferred_op(TransContext *txc, OnodeRef o);
   void _deferred_queue(TransContext *txc);
 public:
-  void deferred_try_submit();
+  void deferred_try_submit(bool only_expired = false);
 private:
   void _deferred_submit_unlock(OpSequencer *osr);
   void _deferred_aio_finish(OpSequencer *osr);
@@ -2066,12 +2208,45 @@ public:
 			  mempool::bluestore_fsck::pool_allocator<uint64_t>>;
 
 private:
+  struct fsck_sb_info_t {
+    list<ghobject_t> oids;
+    SharedBlobRef sb;
+    bluestore_extent_ref_map_t ref_map;
+    bool compressed = false;
+  };
+  typedef mempool::bluestore_fsck::map<uint64_t,fsck_sb_info_t>
+    fsck_sb_info_map_t;
+
+  /// per-thread state of the fsck object walk, merged once it is done
+  struct FsckShard {
+    mempool_dynamic_bitset local_used_blocks;
+    mempool_dynamic_bitset *used_blocks = nullptr;
+    store_statfs_t expected_statfs;
+    fsck_sb_info_map_t sb_info;
+    int errors = 0;
+    uint64_t num_extents = 0;
+    uint64_t num_blobs = 0;
+  };
+
+  std::function<void(uint64_t,double)> fsck_progress_cb;
+
   int _fsck_check_extents(
     const ghobject_t& oid,
     const PExtentVector& extents,
     bool compressed,
     mempool_dynamic_bitset &used_blocks,
     store_statfs_t& expected_statfs);
+  void _fsck_check_object(
+    FsckShard& s,
+    Collection *c,
+    OnodeRef& o,
+    bool deep);
+  void _fsck_merge_shard(
+    FsckShard& s,
+    mempool_dynamic_bitset &used_blocks,
+    store_statfs_t& expected_statfs,
+    fsck_sb_info_map_t& sb_info,
+    int *errors);
 
   void _buffer_cache_write(
     TransContext *txc,
@@ -2169,6 +2344,10 @@ public:
   int read_meta(const std::string& key, std::string *value) override;
 
 
+  /// called periodically during fsck with (objects walked, seconds elapsed)
+  void set_fsck_progress_cb(std::function<void(uint64_t,double)> cb) {
+    fsck_progress_cb = cb;
+  }
   int fsck(bool deep) override {
     return _fsck(deep, false);
   }
@@ -2192,6 +2371,9 @@ public:
   }
 
   void get_db_statistics(Formatter *f) override;
+  void dump_cache_stats(Formatter *f) override;
+  void dump_alloc_stats(Formatter *f) override;
+  void dump_pool_stats(Formatter *f) override;
   void generate_db_histogram(Formatter *f) override;
   void _flush_cache();
   void flush_cache() override;
@@ -2591,10 +2773,12 @@ private:
   int _do_gc(TransContext *txc,
              CollectionRef& c,
              OnodeRef o,
-             const GarbageCollector& gc,
+             const vector<AllocExtent>& extents_to_collect,
              const WriteContext& wctx,
              uint64_t *dirty_start,
              uint64_t *dirty_end);
+  void _txc_background_gc(TransContext *txc, CollectionRef& c);
+  int64_t _do_background_gc(TransContext *txc, CollectionRef& c, OnodeRef o);
 
   int _do_write(TransContext *txc,
 		CollectionRef &c,
@@ -2636,6 +2820,8 @@ private:
   int _do_remove(TransContext *txc,
 		 CollectionRef& c,
 		 OnodeRef o);
+  void _patch_onode_attr(TransContext *txc, OnodeRef& o, __u8 op,
+			 const string& name, const bufferptr& val);
   int _setattr(TransContext *txc,
 	       CollectionRef& c,
 	       OnodeRef& o,
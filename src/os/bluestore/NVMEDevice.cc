@@ -26,6 +26,7 @@
 #include <functional>
 #include <map>
 #include <thread>
+#include <vector>
 
 #include <spdk/nvme.h>
 
@@ -45,7 +46,10 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "bdev(" << sn << ") "
 
-thread_local SharedDriverQueueData *queue_t;
+// every thread that submits io (the osd shard threads, the kv sync
+// thread, ...) gets its own qpair for each device it talks to, and polls
+// for its completions itself, so io never changes threads
+thread_local std::vector<SharedDriverQueueData*> queue_t;
 
 static constexpr uint16_t data_buffer_default_num = 1024;
 
@@ -137,7 +141,8 @@ class SharedDriverQueueData {
   uint32_t sector_size;
   uint32_t max_queue_depth;
   struct spdk_nvme_qpair *qpair;
-  bool reap_io = false;
+  uint32_t max_io_completion;
+  uint64_t io_sleep_in_us;
   int alloc_buf_from_pool(Task *t, bool write);
 
   public:
@@ -146,6 +151,7 @@ class SharedDriverQueueData {
     std::vector<void*> data_buf_mempool;
     PerfCounters *logger = nullptr;
     void _aio_handle(Task *t, IOContext *ioc);
+    NVMEDevice *get_bdev() const { return bdev; }
 
     SharedDriverQueueData(NVMEDevice *bdev, SharedDriverData *driver)
       : bdev(bdev),
@@ -160,6 +166,8 @@ class SharedDriverQueueData {
     opts.qprio = SPDK_NVME_QPRIO_URGENT;
     // usable queue depth should minus 1 to aovid overflow.
     max_queue_depth = opts.io_queue_size - 1;
+    max_io_completion = (uint32_t)g_conf->get_val<uint64_t>("bluestore_spdk_max_io_completion");
+    io_sleep_in_us = g_conf->get_val<uint64_t>("bluestore_spdk_io_sleep");
     qpair = spdk_nvme_ctrlr_alloc_io_qpair(ctrlr, &opts, sizeof(opts));
     assert(qpair != NULL);
 
@@ -187,13 +195,11 @@ class SharedDriverQueueData {
     logger = b.create_perf_counters();
     g_ceph_context->get_perfcounters_collection()->add(logger);
     bdev->queue_number++;
-    if(bdev->queue_number.load() == 1)
-      reap_io = true;
   }
 
   ~SharedDriverQueueData() {
     g_ceph_context->get_perfcounters_collection()->remove(logger);
-    if (!qpair) {
+    if (qpair) {
       spdk_nvme_ctrlr_free_io_qpair(qpair);
       bdev->queue_number--;
     }
@@ -358,8 +364,6 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
 
   int r = 0;
   uint64_t lba_off, lba_count;
-  uint32_t max_io_completion = (uint32_t)g_conf->get_val<uint64_t>("bluestore_spdk_max_io_completion");
-  uint64_t io_sleep_in_us = g_conf->get_val<uint64_t>("bluestore_spdk_io_sleep");
 
   ceph::coarse_real_clock::time_point cur, start
     = ceph::coarse_real_clock::now();
@@ -370,7 +374,7 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
       r = spdk_nvme_qpair_process_completions(qpair, max_io_completion);
       if (r < 0) {
         ceph_abort();
-      } else if (r == 0) {
+      } else if (r == 0 && io_sleep_in_us) {
         usleep(io_sleep_in_us);
       }
     }
@@ -458,8 +462,7 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
     start = ceph::coarse_real_clock::now();
   }
 
-  if(reap_io)
-    bdev->reap_ioc();
+  bdev->reap_ioc();
   dout(20) << __func__ << " end" << dendl;
 }
 
@@ -838,9 +841,18 @@ void NVMEDevice::aio_submit(IOContext *ioc)
     assert(ioc->num_pending.load() == 0);  // we should be only thread doing this
     // Only need to push the first entry
     ioc->nvme_task_first = ioc->nvme_task_last = nullptr;
-    if(!queue_t)
-	queue_t = new SharedDriverQueueData(this, driver);
-    queue_t->_aio_handle(t, ioc);
+    SharedDriverQueueData *queue = nullptr;
+    for (auto q : queue_t) {
+      if (q->get_bdev() == this) {
+        queue = q;
+        break;
+      }
+    }
+    if (!queue) {
+      queue = new SharedDriverQueueData(this, driver);
+      queue_t.push_back(queue);
+    }
+    queue->_aio_handle(t, ioc);
   }
 }
 
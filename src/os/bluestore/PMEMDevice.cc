@@ -35,7 +35,7 @@
 
 PMEMDevice::PMEMDevice(CephContext *cct, aio_callback_t cb, void *cbpriv)
   : BlockDevice(cct, cb, cbpriv),
-    fd(-1), addr(0),
+    fd(-1), addr(0), is_pmem(0),
     debug_lock("PMEMDevice::debug_lock"),
     injecting_crash(0)
 {
@@ -94,7 +94,8 @@ int PMEMDevice::open(const string& p)
   }
 
   size_t map_len;
-  addr = (char *)pmem_map_file(path.c_str(), size, PMEM_FILE_EXCL, O_RDWR, &map_len, NULL);
+  addr = (char *)pmem_map_file(path.c_str(), size, PMEM_FILE_EXCL, O_RDWR, &map_len,
+			       &is_pmem);
   if (addr == NULL) {
     derr << __func__ << " pmem_map_file error" << dendl;
     goto out_fail;
@@ -117,6 +118,7 @@ int PMEMDevice::open(const string& p)
     << " (" << pretty_si_t(size) << "B)"
     << " block_size " << block_size
     << " (" << pretty_si_t(block_size) << "B)"
+    << (is_pmem ? "" : " not pmem, persisting with msync")
     << dendl;
   return 0;
 
@@ -231,15 +233,27 @@ int PMEMDevice::write(uint64_t off, bufferlist& bl, bool buffered)
     return 0;
   }
 
+  // copy every segment without waiting for it to drain, and wait once
+  // for the whole write
   bufferlist::iterator p = bl.begin();
-  uint32_t off1 = off;
+  uint64_t off1 = off;
   while (len) {
     const char *data;
     uint32_t l = p.get_ptr_and_advance(len, &data);
-    pmem_memcpy_persist(addr + off1, data, l);
+    if (is_pmem)
+      pmem_memcpy_nodrain(addr + off1, data, l);
+    else
+      memcpy(addr + off1, data, l);
     len -= l;
     off1 += l;
   }
+  if (is_pmem) {
+    pmem_drain();
+  } else if (pmem_msync(addr + off, bl.length()) < 0) {
+    int r = -errno;
+    derr << __func__ << " msync got " << cpp_strerror(r) << dendl;
+    return r;
+  }
 
   return 0;
 }
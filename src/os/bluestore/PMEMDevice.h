@@ -27,6 +27,7 @@
 class PMEMDevice : public BlockDevice {
   int fd;
   char *addr; //the address of mmap
+  int is_pmem;  //whether addr maps real pmem, otherwise writes need msync
   std::string path;
 
   Mutex debug_lock;
@@ -89,6 +89,13 @@ int64_t StupidAllocator::allocate_int(
   uint64_t *offset, uint32_t *length)
 {
   std::lock_guard<std::mutex> l(lock);
+  return _allocate_int(want_size, alloc_unit, hint, offset, length);
+}
+
+int64_t StupidAllocator::_allocate_int(
+  uint64_t want_size, uint64_t alloc_unit, int64_t hint,
+  uint64_t *offset, uint32_t *length)
+{
   ldout(cct, 10) << __func__ << " want_size 0x" << std::hex << want_size
 	   	 << " alloc_unit 0x" << alloc_unit
 	   	 << " hint 0x" << hint << std::dec
@@ -221,8 +228,10 @@ int64_t StupidAllocator::allocate(
 
   ExtentList block_list = ExtentList(extents, 1, max_alloc_size);
 
+  // take the lock once for the whole request rather than per extent
+  std::lock_guard<std::mutex> l(lock);
   while (allocated_size < want_size) {
-    res = allocate_int(MIN(max_alloc_size, (want_size - allocated_size)),
+    res = _allocate_int(MIN(max_alloc_size, (want_size - allocated_size)),
        alloc_unit, hint, &offset, &length);
     if (res != 0) {
       /*
@@ -263,6 +272,28 @@ uint64_t StupidAllocator::get_free()
   return num_free;
 }
 
+double StupidAllocator::get_fragmentation(uint64_t alloc_unit)
+{
+  assert(alloc_unit);
+  uint64_t max_intervals = 0;
+  uint64_t intervals = 0;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    max_intervals = num_free / alloc_unit;
+    for (unsigned bin = 0; bin < free.size(); ++bin) {
+      intervals += free[bin].num_intervals();
+    }
+  }
+  ldout(cct, 30) << __func__ << " " << intervals << "/" << max_intervals
+		 << dendl;
+  if (!intervals || max_intervals <= 1) {
+    return 0.0;
+  }
+  // a free extent smaller than alloc_unit still counts as an interval
+  intervals = MIN(intervals, max_intervals);
+  return (double)(intervals - 1) / (max_intervals - 1);
+}
+
 void StupidAllocator::dump()
 {
   std::lock_guard<std::mutex> l(lock);
@@ -161,6 +161,7 @@ int main(int argc, char **argv)
   string key, value;
   int log_level = 30;
   bool fsck_deep = false;
+  unsigned fsck_threads = 0;
   po::options_description po_options("Options");
   po_options.add_options()
     ("help,h", "produce help message")
@@ -170,6 +171,7 @@ int main(int argc, char **argv)
     ("log-level", po::value<int>(&log_level), "log level (30=most, 20=lots, 10=some, 1=little)")
     ("dev", po::value<vector<string>>(&devs), "device(s)")
     ("deep", po::value<bool>(&fsck_deep), "deep fsck (read all data)")
+    ("threads", po::value<unsigned>(&fsck_threads), "number of fsck threads")
     ("key,k", po::value<string>(&key), "label metadata key name")
     ("value,v", po::value<string>(&value), "label metadata value")
     ;
@@ -298,6 +300,11 @@ int main(int argc, char **argv)
   }
   args.push_back("--no-log-to-stderr");
   args.push_back("--err-to-stderr");
+  string fsck_threads_str = stringify(fsck_threads);
+  if (fsck_threads) {
+    args.push_back("--bluestore-fsck-threads");
+    args.push_back(fsck_threads_str.c_str());
+  }
 
   for (auto& i : ceph_option_strings) {
     args.push_back(i.c_str());
@@ -312,6 +319,12 @@ int main(int argc, char **argv)
       action == "repair") {
     validate_path(cct.get(), path, false);
     BlueStore bluestore(cct.get(), path);
+    bluestore.set_fsck_progress_cb([](uint64_t objects, double elapsed) {
+	cout << "  " << objects << " objects checked in " << elapsed
+	     << " seconds (" << (uint64_t)(objects / elapsed)
+	     << " objects/sec)" << std::endl;
+      });
+    utime_t start = ceph_clock_now();
     int r;
     if (action == "fsck") {
       r = bluestore.fsck(fsck_deep);
@@ -322,7 +335,8 @@ int main(int argc, char **argv)
       cerr << "error from fsck: " << cpp_strerror(r) << std::endl;
       exit(EXIT_FAILURE);
     }
-    cout << action << " success" << std::endl;
+    cout << action << " success (" << (ceph_clock_now() - start)
+	 << " seconds)" << std::endl;
   }
   else if (action == "prime-osd-dir") {
     bluestore_bdev_label_t label;
@@ -0,0 +1,306 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "io_uring.h"
+
+#if defined(HAVE_LIBAIO) && defined(HAVE_LIBURING)
+
+#include <liburing.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <map>
+
+#include "common/ceph_time.h"
+
+struct ioring_data {
+  struct io_uring io_uring;
+  int epoll_fd = -1;
+  /// device fd -> index in the registered file table
+  std::map<int, int> fixed_fds_map;
+};
+
+static int ioring_get_cqe(ioring_data *d, unsigned int max,
+			  aio_t **paio)
+{
+  struct io_uring *ring = &d->io_uring;
+  struct io_uring_cqe *cqe;
+
+  unsigned nr = 0;
+  unsigned head;
+  io_uring_for_each_cqe(ring, head, cqe) {
+    aio_t *io = (aio_t *)(uintptr_t)io_uring_cqe_get_data(cqe);
+    io->rval = cqe->res;
+
+    paio[nr++] = io;
+
+    if (nr == max)
+      break;
+  }
+  io_uring_cq_advance(ring, nr);
+
+  return nr;
+}
+
+static int find_fixed_fd(ioring_data *d, int real_fd)
+{
+  auto it = d->fixed_fds_map.find(real_fd);
+  if (it == d->fixed_fds_map.end())
+    return -1;
+
+  return it->second;
+}
+
+static void init_sqe(ioring_data *d, struct io_uring_sqe *sqe,
+		     aio_t *io)
+{
+  int fixed_fd = find_fixed_fd(d, io->fd);
+
+  assert(fixed_fd != -1);
+
+  if (io->is_write())
+    io_uring_prep_writev(sqe, fixed_fd, &io->iov[0],
+			 io->iov.size(), io->offset);
+  else
+    io_uring_prep_readv(sqe, fixed_fd, &io->iov[0],
+			io->iov.size(), io->offset);
+
+  io_uring_sqe_set_data(sqe, io);
+  io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+}
+
+static int ioring_queue(ioring_data *d, void *priv,
+			io_queue_t::aio_iter beg, io_queue_t::aio_iter end)
+{
+  struct io_uring *ring = &d->io_uring;
+  io_queue_t::aio_iter cur = beg;
+  unsigned queued = 0;
+
+  for (; cur != end; ++cur) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (!sqe)
+      break;
+
+    cur->priv = priv;
+    init_sqe(d, sqe, &*cur);
+    ++queued;
+  }
+
+  if (!queued)
+    return -EAGAIN;
+
+  int ret = io_uring_submit(ring);
+  if (ret < 0)
+    return ret;
+  return queued;
+}
+
+static void build_fixed_fds_map(ioring_data *d,
+				std::vector<int> &fds)
+{
+  int fixed_fd = 0;
+  for (int real_fd : fds) {
+    d->fixed_fds_map[real_fd] = fixed_fd++;
+  }
+}
+
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_,
+			       bool sq_thread_)
+  : d(new ioring_data),
+    iodepth(iodepth_),
+    hipri(hipri_),
+    sq_thread(sq_thread_)
+{
+}
+
+ioring_queue_t::~ioring_queue_t()
+{
+}
+
+int ioring_queue_t::init(std::vector<int> &fds)
+{
+  unsigned flags = 0;
+
+  if (hipri)
+    flags |= IORING_SETUP_IOPOLL;
+  if (sq_thread)
+    flags |= IORING_SETUP_SQPOLL;
+
+  int ret = io_uring_queue_init(iodepth, &d->io_uring, flags);
+  if (ret < 0)
+    return ret;
+
+  ret = io_uring_register_files(&d->io_uring,
+				&fds[0], fds.size());
+  if (ret < 0) {
+    ret = -errno;
+    goto close_ring_fd;
+  }
+
+  build_fixed_fds_map(d.get(), fds);
+
+  if (!hipri) {
+    // with IOPOLL the ring fd never signals readiness; completions are
+    // reaped by polling from get_next_completed() instead.
+    d->epoll_fd = epoll_create1(0);
+    if (d->epoll_fd < 0) {
+      ret = -errno;
+      goto close_ring_fd;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = d->io_uring.ring_fd;
+    ret = epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, d->io_uring.ring_fd, &ev);
+    if (ret < 0) {
+      ret = -errno;
+      goto close_epoll_fd;
+    }
+  }
+
+  return 0;
+
+close_epoll_fd:
+  close(d->epoll_fd);
+  d->epoll_fd = -1;
+close_ring_fd:
+  io_uring_queue_exit(&d->io_uring);
+
+  return ret;
+}
+
+void ioring_queue_t::shutdown()
+{
+  d->fixed_fds_map.clear();
+  if (d->epoll_fd >= 0) {
+    close(d->epoll_fd);
+    d->epoll_fd = -1;
+  }
+  io_uring_queue_exit(&d->io_uring);
+}
+
+int ioring_queue_t::submit_batch(aio_iter beg, aio_iter end,
+				 uint16_t aios_size, void *priv,
+				 int *retries)
+{
+  (void)aios_size;
+  // same backoff as aio_queue_t: 2^16 * 125us = ~8 seconds
+  int attempts = 16;
+  int delay = 125;
+  int done = 0;
+
+  std::lock_guard<std::mutex> l(sq_mutex);
+  while (beg != end) {
+    int r = ioring_queue(d.get(), priv, beg, end);
+    if (r < 0) {
+      if (r == -EAGAIN && attempts-- > 0) {
+	// the submission ring is full; let the reaper catch up
+	usleep(delay);
+	delay *= 2;
+	(*retries)++;
+	continue;
+      }
+      return r;
+    }
+    std::advance(beg, r);
+    done += r;
+  }
+  return done;
+}
+
+int ioring_queue_t::get_next_completed(int timeout_ms, aio_t **paio, int max)
+{
+  if (hipri) {
+    // polled completions: drive the kernel poll loop ourselves
+    auto deadline = ceph::mono_clock::now() +
+      std::chrono::milliseconds(timeout_ms);
+    while (true) {
+      {
+	std::lock_guard<std::mutex> l(cq_mutex);
+	int events = ioring_get_cqe(d.get(), max, paio);
+	if (events)
+	  return events;
+      }
+      if (ceph::mono_clock::now() >= deadline)
+	return 0;
+      int r = syscall(__NR_io_uring_enter, d->io_uring.ring_fd, 0, 1,
+		      IORING_ENTER_GETEVENTS, NULL, 0);
+      if (r < 0 && errno != EINTR && errno != EAGAIN)
+	return -errno;
+    }
+  }
+
+get_cqe:
+  {
+    std::lock_guard<std::mutex> l(cq_mutex);
+    int events = ioring_get_cqe(d.get(), max, paio);
+    if (events)
+      return events;
+  }
+
+  struct epoll_event ev;
+  int ret = TEMP_FAILURE_RETRY(epoll_wait(d->epoll_fd, &ev, 1, timeout_ms));
+  if (ret < 0)
+    return -errno;
+  if (ret > 0)
+    goto get_cqe;
+  return 0;
+}
+
+bool ioring_queue_t::supported()
+{
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  int fd = syscall(__NR_io_uring_setup, 16, &p);
+  if (fd < 0)
+    return false;
+
+  close(fd);
+
+  return true;
+}
+
+#elif defined(HAVE_LIBAIO)
+
+struct ioring_data {};
+
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_,
+			       bool sq_thread_)
+{
+  assert(0);
+}
+
+ioring_queue_t::~ioring_queue_t()
+{
+}
+
+int ioring_queue_t::init(std::vector<int> &fds)
+{
+  assert(0);
+}
+
+void ioring_queue_t::shutdown()
+{
+  assert(0);
+}
+
+int ioring_queue_t::submit_batch(aio_iter beg, aio_iter end,
+				 uint16_t aios_size, void *priv,
+				 int *retries)
+{
+  assert(0);
+}
+
+int ioring_queue_t::get_next_completed(int timeout_ms, aio_t **paio, int max)
+{
+  assert(0);
+}
+
+bool ioring_queue_t::supported()
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,49 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include "acconfig.h"
+
+#include <memory>
+#include <mutex>
+
+#include "aio.h"
+
+#if defined(HAVE_LIBAIO)
+
+struct ioring_data;
+
+/**
+ * ioring_queue_t - io_queue_t implemented on top of io_uring(7)
+ *
+ * All aios of a batch are placed on the submission ring and pushed to
+ * the kernel with a single io_uring_enter(2).  The device fds are
+ * registered with the ring so the kernel does not need to take a file
+ * reference per io.  Optionally the ring can be set up for polled
+ * completions (hipri) and/or with a kernel side submission thread.
+ */
+struct ioring_queue_t final : public io_queue_t {
+  std::unique_ptr<ioring_data> d;
+  unsigned iodepth = 0;
+  bool hipri = false;
+  bool sq_thread = false;
+
+  std::mutex sq_mutex;
+  std::mutex cq_mutex;
+
+  ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_);
+  ~ioring_queue_t() final;
+
+  /// true if this build and the running kernel support io_uring
+  static bool supported();
+
+  int init(std::vector<int> &fds) final;
+  void shutdown() final;
+
+  int submit_batch(aio_iter begin, aio_iter end, uint16_t aios_size,
+		   void *priv, int *retries) final;
+  int get_next_completed(int timeout_ms, aio_t **paio, int max) final;
+};
+
+#endif
@@ -966,22 +966,32 @@ int DBObjectMap::clone(const ghobject_t &oid,
     return r;
   _set_header(destination, bl, t);
 
-  map<string, bufferlist> to_set;
+  // keys go straight from the source iterators into the transaction
+  // instead of being gathered in a map first
+  const string dest_xattr_prefix = xattr_prefix(destination);
   KeyValueDB::Iterator xattr_iter = db->get_iterator(xattr_prefix(source));
   for (xattr_iter->seek_to_first();
        xattr_iter->valid();
        xattr_iter->next())
-    to_set.insert(make_pair(xattr_iter->key(), xattr_iter->value()));
-  t->set(xattr_prefix(destination), to_set);
-
-  map<string, bufferlist> to_write;
-  ObjectMapIterator iter = _get_iterator(source);
-  for (iter->seek_to_first() ; iter->valid() ; iter->next()) {
-    if (iter->status())
-      return iter->status();
-    to_write[iter->key()] = iter->value();
+    t->set(dest_xattr_prefix, xattr_iter->key(), xattr_iter->value());
+
+  const string dest_user_prefix = user_prefix(destination);
+  if (!source->parent) {
+    // no parent to merge or complete regions to skip: copy the raw keys
+    KeyValueDB::Iterator key_iter = db->get_iterator(user_prefix(source));
+    for (key_iter->seek_to_first(); key_iter->valid(); key_iter->next()) {
+      if (key_iter->status())
+	return key_iter->status();
+      t->set(dest_user_prefix, key_iter->key(), key_iter->value());
+    }
+  } else {
+    ObjectMapIterator iter = _get_iterator(source);
+    for (iter->seek_to_first() ; iter->valid() ; iter->next()) {
+      if (iter->status())
+	return iter->status();
+      t->set(dest_user_prefix, iter->key(), iter->value());
+    }
   }
-  t->set(user_prefix(destination), to_write);
 
   return db->submit_transaction(t);
 }
@@ -1146,41 +1156,34 @@ int DBObjectMap::write_state(KeyValueDB::Transaction _t) {
 }
 
 
-DBObjectMap::Header DBObjectMap::_lookup_map_header(
+bool DBObjectMap::read_map_header(
   const MapHeaderLock &l,
-  const ghobject_t &oid)
+  const ghobject_t &oid,
+  _Header *out)
 {
   assert(l.get_locked() == oid);
 
-  _Header *header = new _Header();
-  {
-    Mutex::Locker l(cache_lock);
-    if (caches.lookup(oid, header)) {
-      assert(!in_use.count(header->seq));
-      in_use.insert(header->seq);
-      return Header(header, RemoveOnDelete(this));
-    }
-  }
-
-  bufferlist out;
-  int r = db->get(HOBJECT_TO_SEQ, map_header_key(oid), &out);
-  if (r < 0 || out.length()==0) {
-    delete header;
-    return Header();
-  }
+  SimpleLRU<ghobject_t, _Header> &cache = header_cache(oid);
+  if (cache.lookup(oid, out))
+    return true;
 
-  Header ret(header, RemoveOnDelete(this));
-  bufferlist::iterator iter = out.begin();
+  bufferlist bl;
+  int r = db->get(HOBJECT_TO_SEQ, map_header_key(oid), &bl);
+  if (r < 0 || bl.length()==0)
+    return false;
 
-  ret->decode(iter);
-  {
-    Mutex::Locker l(cache_lock);
-    caches.add(oid, *ret);
-  }
+  bufferlist::iterator iter = bl.begin();
+  out->decode(iter);
+  cache.add(oid, *out);
+  return true;
+}
 
-  assert(!in_use.count(header->seq));
-  in_use.insert(header->seq);
-  return ret;
+DBObjectMap::Header DBObjectMap::_use_map_header(const _Header &header)
+{
+  assert(header_lock.is_locked_by_me());
+  assert(!in_use.count(header.seq));
+  in_use.insert(header.seq);
+  return Header(new _Header(header), RemoveOnDelete(this));
 }
 
 DBObjectMap::Header DBObjectMap::_generate_new_header(const ghobject_t &oid,
@@ -1237,12 +1240,14 @@ DBObjectMap::Header DBObjectMap::lookup_create_map_header(
   const ghobject_t &oid,
   KeyValueDB::Transaction t)
 {
+  _Header found;
+  bool exists = read_map_header(hl, oid, &found);
+
   Mutex::Locker l(header_lock);
-  Header header = _lookup_map_header(hl, oid);
-  if (!header) {
-    header = _generate_new_header(oid, Header());
-    set_map_header(hl, oid, *header, t);
-  }
+  if (exists)
+    return _use_map_header(found);
+  Header header = _generate_new_header(oid, Header());
+  set_map_header(hl, oid, *header, t);
   return header;
 }
 
@@ -1279,10 +1284,7 @@ void DBObjectMap::remove_map_header(
   set<string> to_remove;
   to_remove.insert(map_header_key(oid));
   t->rmkeys(HOBJECT_TO_SEQ, to_remove);
-  {
-    Mutex::Locker l(cache_lock);
-    caches.clear(oid);
-  }
+  header_cache(oid).clear(oid);
 }
 
 void DBObjectMap::set_map_header(
@@ -1297,10 +1299,7 @@ void DBObjectMap::set_map_header(
   map<string, bufferlist> to_set;
   header.encode(to_set[map_header_key(oid)]);
   t->set(HOBJECT_TO_SEQ, to_set);
-  {
-    Mutex::Locker l(cache_lock);
-    caches.add(oid, header);
-  }
+  header_cache(oid).add(oid, header);
 }
 
 bool DBObjectMap::check_spos(const ghobject_t &oid,
@@ -116,10 +116,13 @@ public:
   };
 
   DBObjectMap(CephContext* cct, KeyValueDB *db)
-    : ObjectMap(cct), db(db), header_lock("DBOBjectMap"),
-      cache_lock("DBObjectMap::CacheLock"),
-      caches(cct->_conf->filestore_omap_header_cache_size)
-    {}
+    : ObjectMap(cct), db(db), header_lock("DBOBjectMap")
+    {
+      size_t shard_size = std::max<size_t>(
+	1, cct->_conf->filestore_omap_header_cache_size / HEADER_CACHE_SHARDS);
+      for (auto &cache : caches)
+	cache.reset(new SimpleLRU<ghobject_t, _Header>(shard_size));
+    }
 
   int set_keys(
     const ghobject_t &oid,
@@ -366,8 +369,13 @@ public:
 private:
   /// Implicit lock on Header->seq
   typedef ceph::shared_ptr<_Header> Header;
-  Mutex cache_lock;
-  SimpleLRU<ghobject_t, _Header> caches;
+
+  /// map headers by object hash; every shard has its own lock
+  static const unsigned HEADER_CACHE_SHARDS = 8;
+  std::unique_ptr<SimpleLRU<ghobject_t, _Header>> caches[HEADER_CACHE_SHARDS];
+  SimpleLRU<ghobject_t, _Header> &header_cache(const ghobject_t &oid) {
+    return *caches[oid.hobj.get_hash() % HEADER_CACHE_SHARDS];
+  }
 
   string map_header_key(const ghobject_t &oid);
   string header_key(uint64_t seq);
@@ -504,15 +512,27 @@ private:
     return _generate_new_header(oid, parent);
   }
 
-  /// Lookup leaf header for c oid
-  Header _lookup_map_header(
+  /**
+   * Read leaf header for c oid from the cache or the db
+   *
+   * The MapHeaderLock is all that is needed, so misses do not hold
+   * header_lock over the db read.
+   */
+  bool read_map_header(
     const MapHeaderLock &l,
-    const ghobject_t &oid);
+    const ghobject_t &oid,
+    _Header *out);
+  /// Mark a header from read_map_header in use, header_lock held
+  Header _use_map_header(const _Header &header);
+  /// Lookup leaf header for c oid
   Header lookup_map_header(
     const MapHeaderLock &l2,
     const ghobject_t &oid) {
+    _Header header;
+    if (!read_map_header(l2, oid, &header))
+      return Header();
     Mutex::Locker l(header_lock);
-    return _lookup_map_header(l2, oid);
+    return _use_map_header(header);
   }
 
   /// Lookup header node for input
@@ -49,7 +49,12 @@ void WBThrottle::start()
     Mutex::Locker l(lock);
     stopping = false;
   }
-  create("wb_throttle");
+  uint64_t n = std::max<uint64_t>(
+    1, cct->_conf->get_val<uint64_t>("filestore_wbthrottle_flushers"));
+  for (uint64_t i = 0; i < n; ++i) {
+    flushers.emplace_back(new Flusher(this));
+    flushers.back()->create("wb_throttle");
+  }
 }
 
 void WBThrottle::stop()
@@ -57,10 +62,13 @@ void WBThrottle::stop()
   {
     Mutex::Locker l(lock);
     stopping = true;
-    cond.Signal();
+    cond.SignalAll();
   }
 
-  join();
+  for (auto &flusher : flushers) {
+    flusher->join();
+  }
+  flushers.clear();
 }
 
 const char** WBThrottle::get_tracked_conf_keys() const
@@ -115,7 +123,7 @@ void WBThrottle::set_from_conf()
   } else {
     assert(0 == "invalid value for fs");
   }
-  cond.Signal();
+  cond.SignalAll();
 }
 
 void WBThrottle::handle_conf_change(const md_config_t *conf,
@@ -150,12 +158,12 @@ bool WBThrottle::get_next_should_flush(
 }
 
 
-void *WBThrottle::entry()
+void WBThrottle::flush_entry()
 {
   Mutex::Locker l(lock);
   boost::tuple<ghobject_t, FDRef, PendingWB> wb;
   while (get_next_should_flush(&wb)) {
-    clearing = wb.get<0>();
+    auto clearing_it = clearing.insert(wb.get<0>());
     cur_ios -= wb.get<2>().ios;
     logger->dec(l_wbthrottle_ios_dirtied, wb.get<2>().ios);
     logger->inc(l_wbthrottle_ios_wb, wb.get<2>().ios);
@@ -177,11 +185,12 @@ void *WBThrottle::entry()
     }
 #endif
     lock.Lock();
-    clearing = ghobject_t();
-    cond.Signal();
+    clearing.erase(clearing_it);
+    // throttle() and clear_object() callers wait on the same cond as
+    // the other flushers
+    cond.SignalAll();
     wb = boost::tuple<ghobject_t, FDRef, PendingWB>();
   }
-  return 0;
 }
 
 void WBThrottle::queue_wb(
@@ -210,7 +219,7 @@ void WBThrottle::queue_wb(
   wbiter->second.first.add(nocache, len, 1);
   insert_object(hoid);
   if (beyond_limit())
-    cond.Signal();
+    cond.SignalAll();
 }
 
 void WBThrottle::clear()
@@ -235,13 +244,13 @@ void WBThrottle::clear()
   pending_wbs.clear();
   lru.clear();
   rev_lru.clear();
-  cond.Signal();
+  cond.SignalAll();
 }
 
 void WBThrottle::clear_object(const ghobject_t &hoid)
 {
   Mutex::Locker l(lock);
-  while (clearing == hoid)
+  while (clearing.count(hoid))
     cond.Wait(lock);
   ceph::unordered_map<ghobject_t, pair<PendingWB, FDRef> >::iterator i =
     pending_wbs.find(hoid);
@@ -256,7 +265,7 @@ void WBThrottle::clear_object(const ghobject_t &hoid)
 
   pending_wbs.erase(i);
   remove_object(hoid);
-  cond.Signal();
+  cond.SignalAll();
 }
 
 void WBThrottle::throttle()
@@ -16,6 +16,8 @@
 #define WBTHROTTLE_H
 
 #include "include/unordered_map.h"
+#include <set>
+#include <vector>
 #include <boost/tuple/tuple.hpp>
 #include "include/memory.h"
 #include "common/Formatter.h"
@@ -41,9 +43,14 @@ enum {
  * WBThrottle
  *
  * Tracks, throttles, and flushes outstanding IO
+ *
+ * Flushing is done by filestore_wbthrottle_flushers threads, each taking
+ * the next object off the lru, so that the fdatasyncs of independent
+ * objects are queued to the device together.
  */
-class WBThrottle : Thread, public md_config_obs_t {
-  ghobject_t clearing;
+class WBThrottle : public md_config_obs_t {
+  /// objects a flusher is syncing right now
+  multiset<ghobject_t> clearing;
   /* *_limits.first is the start_flusher limit and
    * *_limits.second is the hard limit
    */
@@ -83,6 +90,17 @@ class WBThrottle : Thread, public md_config_obs_t {
   Mutex lock;
   Cond cond;
 
+  class Flusher : public Thread {
+    WBThrottle *wbt;
+  public:
+    explicit Flusher(WBThrottle *wbt) : wbt(wbt) {}
+    void *entry() override {
+      wbt->flush_entry();
+      return 0;
+    }
+  };
+  vector<unique_ptr<Flusher>> flushers;
+
 
   /**
    * Flush objects in lru order
@@ -118,6 +136,9 @@ class WBThrottle : Thread, public md_config_obs_t {
   bool get_next_should_flush(
     boost::tuple<ghobject_t, FDRef, PendingWB> *next ///< [out] next to flush
     ); ///< @return false if we are shutting down
+
+  /// flusher thread body
+  void flush_entry();
 public:
   enum FS {
     BTRFS,
@@ -180,9 +201,6 @@ public:
   const char** get_tracked_conf_keys() const override;
   void handle_conf_change(const md_config_t *conf,
 			  const std::set<std::string> &changed) override;
-
-  /// Thread
-  void *entry() override;
 };
 
 #endif
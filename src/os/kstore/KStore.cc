@@ -1976,6 +1976,13 @@ void KStore::_txc_finalize(OpSequencer *osr, TransContext *txc)
   dout(20) << __func__ << " osr " << osr << " txc " << txc
 	   << " onodes " << txc->onodes << dendl;
 
+  // finalize stripes; repeated overwrites of a stripe within this txc
+  // collapse into a single kv set
+  for (auto& p : txc->dirty_stripes) {
+    txc->t->set(PREFIX_DATA, p.first, p.second);
+  }
+  txc->dirty_stripes.clear();
+
   // finalize onodes
   for (set<OnodeRef>::iterator p = txc->onodes.begin();
        p != txc->onodes.end();
@@ -2599,7 +2606,7 @@ void KStore::_do_write_stripe(TransContext *txc, OnodeRef o,
   o->pending_stripes[offset] = bl;
   string key;
   get_data_key(o->onode.nid, offset, &key);
-  txc->t->set(PREFIX_DATA, key, bl);
+  txc->dirty_stripes[key] = bl;
 }
 
 void KStore::_do_remove_stripe(TransContext *txc, OnodeRef o, uint64_t offset)
@@ -2607,6 +2614,7 @@ void KStore::_do_remove_stripe(TransContext *txc, OnodeRef o, uint64_t offset)
   o->pending_stripes.erase(offset);
   string key;
   get_data_key(o->onode.nid, offset, &key);
+  txc->dirty_stripes.erase(key);
   txc->t->rmkey(PREFIX_DATA, key);
 }
 
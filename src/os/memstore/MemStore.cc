@@ -63,18 +63,18 @@ int MemStore::_save()
   dout(10) << __func__ << dendl;
   dump_all();
   set<coll_t> collections;
-  for (ceph::unordered_map<coll_t,CollectionRef>::iterator p = coll_map.begin();
-       p != coll_map.end();
-       ++p) {
-    dout(20) << __func__ << " coll " << p->first << " " << p->second << dendl;
-    collections.insert(p->first);
-    bufferlist bl;
-    assert(p->second);
-    p->second->encode(bl);
-    string fn = path + "/" + stringify(p->first);
-    int r = bl.write_file(fn.c_str());
-    if (r < 0)
-      return r;
+  for (auto& shard : coll_shards) {
+    for (auto p = shard.coll_map.begin(); p != shard.coll_map.end(); ++p) {
+      dout(20) << __func__ << " coll " << p->first << " " << p->second << dendl;
+      collections.insert(p->first);
+      bufferlist bl;
+      assert(p->second);
+      p->second->encode(bl);
+      string fn = path + "/" + stringify(p->first);
+      int r = bl.write_file(fn.c_str());
+      if (r < 0)
+        return r;
+    }
   }
 
   string fn = path + "/collections";
@@ -102,36 +102,36 @@ void MemStore::dump_all()
 void MemStore::dump(Formatter *f)
 {
   f->open_array_section("collections");
-  for (ceph::unordered_map<coll_t,CollectionRef>::iterator p = coll_map.begin();
-       p != coll_map.end();
-       ++p) {
-    f->open_object_section("collection");
-    f->dump_string("name", stringify(p->first));
-
-    f->open_array_section("xattrs");
-    for (map<string,bufferptr>::iterator q = p->second->xattr.begin();
-	 q != p->second->xattr.end();
-	 ++q) {
-      f->open_object_section("xattr");
-      f->dump_string("name", q->first);
-      f->dump_int("length", q->second.length());
+  for (auto& shard : coll_shards) {
+    for (auto p = shard.coll_map.begin(); p != shard.coll_map.end(); ++p) {
+      f->open_object_section("collection");
+      f->dump_string("name", stringify(p->first));
+
+      f->open_array_section("xattrs");
+      for (map<string,bufferptr>::iterator q = p->second->xattr.begin();
+	   q != p->second->xattr.end();
+	   ++q) {
+	f->open_object_section("xattr");
+	f->dump_string("name", q->first);
+	f->dump_int("length", q->second.length());
+	f->close_section();
+      }
       f->close_section();
-    }
-    f->close_section();
-
-    f->open_array_section("objects");
-    for (map<ghobject_t,ObjectRef>::iterator q = p->second->object_map.begin();
-	 q != p->second->object_map.end();
-	 ++q) {
-      f->open_object_section("object");
-      f->dump_string("name", stringify(q->first));
-      if (q->second)
-	q->second->dump(f);
+
+      f->open_array_section("objects");
+      for (map<ghobject_t,ObjectRef>::iterator q = p->second->object_map.begin();
+	   q != p->second->object_map.end();
+	   ++q) {
+	f->open_object_section("object");
+	f->dump_string("name", stringify(q->first));
+	if (q->second)
+	  q->second->dump(f);
+	f->close_section();
+      }
       f->close_section();
-    }
-    f->close_section();
 
-    f->close_section();
+      f->close_section();
+    }
   }
   f->close_section();
 }
@@ -161,7 +161,7 @@ int MemStore::_load()
     CollectionRef c(new Collection(cct, *q));
     bufferlist::iterator p = cbl.begin();
     c->decode(p);
-    coll_map[*q] = c;
+    coll_shard(*q).coll_map[*q] = c;
     used_bytes += c->used_bytes();
   }
 
@@ -240,9 +240,10 @@ objectstore_perf_stat_t MemStore::get_cur_stats()
 
 MemStore::CollectionRef MemStore::get_collection(const coll_t& cid)
 {
-  RWLock::RLocker l(coll_lock);
-  ceph::unordered_map<coll_t,CollectionRef>::iterator cp = coll_map.find(cid);
-  if (cp == coll_map.end())
+  CollShard& shard = coll_shard(cid);
+  RWLock::RLocker l(shard.lock);
+  ceph::unordered_map<coll_t,CollectionRef>::iterator cp = shard.coll_map.find(cid);
+  if (cp == shard.coll_map.end())
     return CollectionRef();
   return cp->second;
 }
@@ -439,11 +440,11 @@ int MemStore::getattrs(CollectionHandle &c_, const ghobject_t& oid,
 int MemStore::list_collections(vector<coll_t>& ls)
 {
   dout(10) << __func__ << dendl;
-  RWLock::RLocker l(coll_lock);
-  for (ceph::unordered_map<coll_t,CollectionRef>::iterator p = coll_map.begin();
-       p != coll_map.end();
-       ++p) {
-    ls.push_back(p->first);
+  for (auto& shard : coll_shards) {
+    RWLock::RLocker l(shard.lock);
+    for (auto p = shard.coll_map.begin(); p != shard.coll_map.end(); ++p) {
+      ls.push_back(p->first);
+    }
   }
   return 0;
 }
@@ -451,8 +452,9 @@ int MemStore::list_collections(vector<coll_t>& ls)
 bool MemStore::collection_exists(const coll_t& cid)
 {
   dout(10) << __func__ << " " << cid << dendl;
-  RWLock::RLocker l(coll_lock);
-  return coll_map.count(cid);
+  CollShard& shard = coll_shard(cid);
+  RWLock::RLocker l(shard.lock);
+  return shard.coll_map.count(cid);
 }
 
 int MemStore::collection_empty(const coll_t& cid, bool *empty)
@@ -1364,8 +1366,9 @@ int MemStore::_omap_setheader(const coll_t& cid, const ghobject_t &oid,
 int MemStore::_create_collection(const coll_t& cid, int bits)
 {
   dout(10) << __func__ << " " << cid << dendl;
-  RWLock::WLocker l(coll_lock);
-  auto result = coll_map.insert(std::make_pair(cid, CollectionRef()));
+  CollShard& shard = coll_shard(cid);
+  RWLock::WLocker l(shard.lock);
+  auto result = shard.coll_map.insert(std::make_pair(cid, CollectionRef()));
   if (!result.second)
     return -EEXIST;
   result.first->second.reset(new Collection(cct, cid));
@@ -1376,9 +1379,10 @@ int MemStore::_create_collection(const coll_t& cid, int bits)
 int MemStore::_destroy_collection(const coll_t& cid)
 {
   dout(10) << __func__ << " " << cid << dendl;
-  RWLock::WLocker l(coll_lock);
-  ceph::unordered_map<coll_t,CollectionRef>::iterator cp = coll_map.find(cid);
-  if (cp == coll_map.end())
+  CollShard& shard = coll_shard(cid);
+  RWLock::WLocker l(shard.lock);
+  ceph::unordered_map<coll_t,CollectionRef>::iterator cp = shard.coll_map.find(cid);
+  if (cp == shard.coll_map.end())
     return -ENOENT;
   {
     RWLock::RLocker l2(cp->second->lock);
@@ -1387,7 +1391,7 @@ int MemStore::_destroy_collection(const coll_t& cid)
     cp->second->exists = false;
   }
   used_bytes -= cp->second->used_bytes();
-  coll_map.erase(cp);
+  shard.coll_map.erase(cp);
   return 0;
 }
 
@@ -1713,6 +1717,18 @@ int MemStore::PageSetObject::clone(Object *src, uint64_t srcoff,
   auto &dst_data = data;
   const auto dst_page_size = dst_data.get_page_size();
 
+  // when the pages line up, the destination takes references to the
+  // source pages and they are only copied once either side writes them
+  if (src != this && src_page_size == dst_page_size &&
+      srcoff % src_page_size == 0 && dstoff % dst_page_size == 0 &&
+      len >= src_page_size) {
+    const uint64_t shared = len & ~(src_page_size - 1);
+    dst_data.share_range(src_data, srcoff, shared, dstoff);
+    srcoff += shared;
+    dstoff += shared;
+    len -= shared;
+  }
+
   DEFINE_PAGE_VECTOR(tls_pages);
   PageSet::page_vector dst_pages;
 
@@ -1809,6 +1825,7 @@ int MemStore::PageSetObject::truncate(uint64_t size)
     return 0;
 
   auto page = tls_pages.begin();
+  (*page)->unshare();
   auto data = (*page)->data;
   std::fill(data + (size - page_offset), data + page_size, 0);
   tls_pages.clear(); // drop page ref
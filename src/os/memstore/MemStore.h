@@ -190,8 +190,19 @@ private:
   class OmapIteratorImpl;
 
 
-  ceph::unordered_map<coll_t, CollectionRef> coll_map;
-  RWLock coll_lock;    ///< rwlock to protect coll_map
+  /// coll_map is split by pg so that lookups of different collections
+  /// don't all contend on one lock
+  static const unsigned COLL_SHARDS = 16;
+  struct CollShard {
+    ceph::unordered_map<coll_t, CollectionRef> coll_map;
+    RWLock lock;    ///< rwlock to protect coll_map
+    CollShard() : lock("MemStore::coll_lock") {}
+  };
+  CollShard coll_shards[COLL_SHARDS];
+
+  CollShard& coll_shard(const coll_t& cid) {
+    return coll_shards[cid.hash_to_shard(COLL_SHARDS)];
+  }
 
   CollectionRef get_collection(const coll_t& cid);
 
@@ -239,7 +250,6 @@ private:
 public:
   MemStore(CephContext *cct, const string& path)
     : ObjectStore(cct, path),
-      coll_lock("MemStore::coll_lock"),
       finisher(cct),
       used_bytes(0) {}
   ~MemStore() override { }
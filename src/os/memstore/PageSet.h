@@ -23,10 +23,12 @@
 #include <boost/intrusive/avl_set.hpp>
 #include <boost/intrusive_ptr.hpp>
 
+#include "include/buffer.h"
 #include "include/encoding.h"
 
 struct Page {
-  char *const data;
+  bufferptr buf;  ///< page data, may be shared with the pages of clones
+  char *data;
   boost::intrusive::avl_set_member_hook<> hook;
   uint64_t offset;
 
@@ -60,14 +62,23 @@ struct Page {
     ::decode(offset, p);
   }
 
+  // the data is shared with another page until one of them is written
+  bool is_shared() const { return buf.raw_nref() > 1; }
+  // take a private copy of shared data, before it is modified
+  void unshare() {
+    if (is_shared()) {
+      buf = buffer::copy(data, buf.length());
+      data = buf.c_str();
+    }
+  }
+
   static Ref create(size_t page_size, uint64_t offset = 0) {
-    // ensure proper alignment of the Page
-    const auto align = alignof(Page);
-    page_size = (page_size + align - 1) & ~(align - 1);
-    // allocate the Page and its data in a single buffer
-    auto buffer = new char[page_size + sizeof(Page)];
-    // place the Page structure at the end of the buffer
-    return new (buffer + page_size) Page(buffer, offset);
+    // the data and its refcount come in a single allocation
+    return new Page(buffer::create(page_size), offset);
+  }
+  // a page at offset that shares the data of src
+  static Ref create_shared(const Page &src, uint64_t offset) {
+    return new Page(src.buf, offset);
   }
 
   // copy disabled
@@ -75,11 +86,8 @@ struct Page {
   const Page& operator=(const Page&) = delete;
 
  private: // private constructor, use create() instead
-  Page(char *data, uint64_t offset) : data(data), offset(offset), nrefs(1) {}
-
-  static void operator delete(void *p) {
-    delete[] reinterpret_cast<Page*>(p)->data;
-  }
+  Page(const bufferptr &buf, uint64_t offset)
+    : buf(buf), data(this->buf.c_str()), offset(offset), nrefs(1) {}
 };
 
 class PageSet {
@@ -142,7 +150,8 @@ class PageSet {
   size_t size() const { return pages.size(); }
   size_t get_page_size() const { return page_size; }
 
-  // allocate all pages that intersect the range [offset,length)
+  // allocate all pages that intersect the range [offset,length). the
+  // pages returned are private to this set and can be written to
   void alloc_range(uint64_t offset, uint64_t length, page_vector &range) {
     // loop in reverse so we can provide hints to avl_set::insert_check()
     //	and get O(1) insertions after the first
@@ -174,6 +183,7 @@ class PageSet {
           std::fill(page->data, page->data + offset - page->offset, 0);
       } else { // exists
         cur = insert.first;
+        cur->unshare();
       }
       // add a reference to output vector
       out->reset(&*cur);
@@ -194,6 +204,26 @@ class PageSet {
       range.push_back(&*cur++);
   }
 
+  // make the range [dstoff,dstoff+length) refer to the pages of src in
+  // [srcoff,srcoff+length) without copying their data. offsets and
+  // length must be page aligned; holes in src become holes here
+  void share_range(const PageSet &src, uint64_t srcoff, uint64_t length,
+                   uint64_t dstoff) {
+    assert(&src != this);
+    assert(src.page_size == page_size);
+    assert((srcoff | dstoff | length) % page_size == 0);
+
+    std::lock_guard<lock_type> lock(mutex);
+    auto end = pages.lower_bound(dstoff + length, page_cmp());
+    free_pages(pages.lower_bound(dstoff, page_cmp()), end);
+
+    auto p = src.pages.lower_bound(srcoff, page_cmp());
+    for (; p != src.pages.end() && p->offset < srcoff + length; ++p) {
+      auto page = Page::create_shared(*p, p->offset - srcoff + dstoff);
+      pages.insert_before(end, *page);
+    }
+  }
+
   void free_pages_after(uint64_t offset) {
     std::lock_guard<lock_type> lock(mutex);
     auto cur = pages.lower_bound(offset & ~(page_size-1), page_cmp());
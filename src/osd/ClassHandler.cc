@@ -16,6 +16,8 @@
 
 #include "common/config.h"
 #include "common/debug.h"
+#include "common/Formatter.h"
+#include "common/ceph_time.h"
 
 #define dout_subsys ceph_subsys_osd
 #undef dout_prefix
@@ -321,6 +323,7 @@ void ClassHandler::ClassFilter::unregister()
 int ClassHandler::ClassMethod::exec(cls_method_context_t ctx, bufferlist& indata, bufferlist& outdata)
 {
   int ret;
+  auto start = ceph::mono_clock::now();
   if (cxx_func) {
     // C++ call version
     ret = cxx_func(ctx, &indata, &outdata);
@@ -335,6 +338,50 @@ int ClassHandler::ClassMethod::exec(cls_method_context_t ctx, bufferlist& indata
       outdata.push_back(bp);
     }
   }
+  uint64_t lat = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    ceph::mono_clock::now() - start).count();
+  num_calls++;
+  if (ret < 0)
+    num_errors++;
+  lat_ns += lat;
+  uint64_t max = max_lat_ns.load();
+  while (lat > max && !max_lat_ns.compare_exchange_weak(max, lat))
+    ;
+  in_bytes += indata.length();
+  out_bytes += outdata.length();
   return ret;
 }
 
+void ClassHandler::ClassMethod::dump_stats(ceph::Formatter *f) const
+{
+  uint64_t calls = num_calls;
+  f->dump_string("method", name);
+  f->dump_unsigned("calls", calls);
+  f->dump_unsigned("errors", num_errors);
+  f->dump_float("avg_lat_us", calls ? (double)lat_ns / calls / 1000.0 : 0.0);
+  f->dump_float("max_lat_us", (double)max_lat_ns / 1000.0);
+  f->dump_unsigned("in_bytes", in_bytes);
+  f->dump_unsigned("out_bytes", out_bytes);
+}
+
+void ClassHandler::dump_stats(ceph::Formatter *f)
+{
+  Mutex::Locker lock(mutex);
+  f->open_array_section("classes");
+  for (auto& p : classes) {
+    if (p.second.status != ClassData::CLASS_OPEN)
+      continue;
+    f->open_object_section("class");
+    f->dump_string("name", p.first);
+    f->open_array_section("methods");
+    for (auto& m : p.second.methods_map) {
+      f->open_object_section("method");
+      m.second.dump_stats(f);
+      f->close_section();
+    }
+    f->close_section();
+    f->close_section();
+  }
+  f->close_section();
+}
+
@@ -3,6 +3,8 @@
 #ifndef CEPH_CLASSHANDLER_H
 #define CEPH_CLASSHANDLER_H
 
+#include <atomic>
+
 #include "include/types.h"
 #include "objclass/objclass.h"
 #include "common/Mutex.h"
@@ -24,7 +26,16 @@ public:
     cls_method_call_t func;
     cls_method_cxx_call_t cxx_func;
 
+    // call stats, updated without the handler mutex
+    std::atomic<uint64_t> num_calls = {0};
+    std::atomic<uint64_t> num_errors = {0};
+    std::atomic<uint64_t> lat_ns = {0};      ///< summed call latency
+    std::atomic<uint64_t> max_lat_ns = {0};
+    std::atomic<uint64_t> in_bytes = {0};
+    std::atomic<uint64_t> out_bytes = {0};
+
     int exec(cls_method_context_t ctx, bufferlist& indata, bufferlist& outdata);
+    void dump_stats(ceph::Formatter *f) const;
     void unregister();
 
     int get_flags() {
@@ -123,6 +134,8 @@ public:
   ClassData *register_class(const char *cname);
   void unregister_class(ClassData *cls);
 
+  void dump_stats(ceph::Formatter *f);
+
   void shutdown();
 };
 
@@ -1210,6 +1210,12 @@ void ECBackend::handle_sub_read_reply(
 
   assert(rop.in_progress.count(from));
   rop.in_progress.erase(from);
+  if (!rop.for_recovery) {
+    auto sent = rop.sent.find(from);
+    if (sent != rop.sent.end())
+      note_sub_read_latency(
+	from, (double)(ceph_clock_now() - sent->second), false);
+  }
   unsigned is_complete = 0;
   // For redundant reads check for completion as each shard comes in,
   // or in a non-recovery read check for completion once all the shards read.
@@ -1273,6 +1279,14 @@ void ECBackend::handle_sub_read_reply(
   if (rop.in_progress.empty() || is_complete == rop.complete.size()) {
     dout(20) << __func__ << " Complete: " << rop << dendl;
     rop.trace.event("ec read complete");
+    if (rop.hedged) {
+      for (auto &&i : rop.hedged_from) {
+	if (rop.in_progress.count(i)) {
+	  get_parent()->get_logger()->inc(l_osd_ec_read_hedge_won);
+	  break;
+	}
+      }
+    }
     complete_read_op(rop, m);
   } else {
     dout(10) << __func__ << " readop not complete: " << rop << dendl;
@@ -1294,6 +1308,17 @@ void ECBackend::complete_read_op(ReadOp &rop, RecoveryMessages *m)
       reqiter->second.cb = nullptr;
     }
   }
+  // Any shard still outstanding (fast or hedged reads) will have its reply
+  // dropped; record how long it has taken so far and forget the tid.
+  utime_t now = ceph_clock_now();
+  for (auto &&i : rop.in_progress) {
+    auto sent = rop.sent.find(i);
+    if (!rop.for_recovery && sent != rop.sent.end())
+      note_sub_read_latency(i, (double)(now - sent->second), true);
+    auto siter = shard_to_read_map.find(i);
+    if (siter != shard_to_read_map.end())
+      siter->second.erase(rop.tid);
+  }
   tid_to_read_map.erase(rop.tid);
 }
 
@@ -1426,6 +1451,7 @@ void ECBackend::on_change()
   tid_to_read_map.clear();
   in_progress_client_reads.clear();
   shard_to_read_map.clear();
+  shard_read_lat.clear();
   clear_recovery_state();
 }
 
@@ -1583,6 +1609,9 @@ int ECBackend::get_min_avail_to_read_shards(
   map<shard_id_t, pg_shard_t> shards;
 
   get_all_avail_shards(hoid, have, shards, for_recovery);
+  if (!for_recovery && !do_redundant_reads &&
+      cct->_conf->osd_ec_hedged_read)
+    filter_slow_shards(want, shards, &have);
 
   map<int, vector<pair<int, int>>> need;
   int r = ec_impl->minimum_to_decode(want, have, &need);
@@ -1656,6 +1685,9 @@ void ECBackend::start_read_op(
     op.trace.event("start ec read");
   }
   do_read_op(op);
+  if (!for_recovery && !do_redundant_reads &&
+      cct->_conf->osd_ec_hedged_read)
+    schedule_read_hedge(tid);
 }
 
 void ECBackend::do_read_op(ReadOp &op)
@@ -1701,10 +1733,12 @@ void ECBackend::do_read_op(ReadOp &op)
     }
   }
 
+  utime_t now = ceph_clock_now();
   for (map<pg_shard_t, ECSubRead>::iterator i = messages.begin();
        i != messages.end();
        ++i) {
     op.in_progress.insert(i->first);
+    op.sent[i->first] = now;
     shard_to_read_map[i->first].insert(op.tid);
     i->second.tid = tid;
     MOSDECSubOpRead *msg = new MOSDECSubOpRead;
@@ -1835,6 +1869,16 @@ bool ECBackend::try_state_to_reads()
   waiting_state.pop_front();
   waiting_reads.push_back(*op);
 
+  if (op->requires_rmw()) {
+    uint64_t read_bytes = 0;
+    for (auto &&i : op->plan.to_read)
+      read_bytes += i.second.size();
+    get_parent()->get_logger()->inc(l_osd_ec_write_rmw);
+    get_parent()->get_logger()->inc(l_osd_ec_write_rmw_read_bytes, read_bytes);
+  } else {
+    get_parent()->get_logger()->inc(l_osd_ec_write_full);
+  }
+
   if (op->using_cache) {
     cache.open_write_pin(op->pin);
 
@@ -2375,6 +2419,139 @@ int ECBackend::send_all_remaining_reads(
   return 0;
 }
 
+void ECBackend::note_sub_read_latency(
+  pg_shard_t from, double lat, bool censored)
+{
+  // A censored sample is only a lower bound (the reply never arrived in
+  // time), so it can raise the shard's average but not lower it.
+  auto p = shard_read_lat.find(from);
+  if (p == shard_read_lat.end()) {
+    shard_read_lat[from] = lat;
+  } else if (!censored || lat > p->second) {
+    p->second = p->second * 0.875 + lat * 0.125;
+  }
+  if (censored)
+    return;
+  const unsigned window = 128;
+  if (recent_read_lat.size() < window) {
+    recent_read_lat.push_back(lat);
+  } else {
+    recent_read_lat[recent_read_lat_pos] = lat;
+    recent_read_lat_pos = (recent_read_lat_pos + 1) % window;
+  }
+}
+
+double ECBackend::get_hedge_delay() const
+{
+  double min_delay = cct->_conf->osd_ec_hedged_read_min_delay;
+  if (recent_read_lat.empty())
+    return min_delay;
+  vector<double> v(recent_read_lat);
+  size_t n = (size_t)(v.size() * cct->_conf->osd_ec_hedged_read_percentile /
+		      100.0);
+  if (n >= v.size())
+    n = v.size() - 1;
+  std::nth_element(v.begin(), v.begin() + n, v.end());
+  return MAX(min_delay, v[n]);
+}
+
+void ECBackend::filter_slow_shards(
+  const set<int> &want,
+  const map<shard_id_t, pg_shard_t> &shards,
+  set<int> *have)
+{
+  double factor = cct->_conf->osd_ec_read_slow_shard_factor;
+  if (factor <= 0)
+    return;
+  // Now and then read from a shard we would skip so that its average
+  // can come back down once it recovers.
+  if ((++slow_shard_probe % 64) == 0)
+    return;
+
+  vector<double> lats;
+  for (auto i : *have) {
+    auto p = shard_read_lat.find(shards.at(shard_id_t(i)));
+    if (p != shard_read_lat.end())
+      lats.push_back(p->second);
+  }
+  if (lats.size() < 2)
+    return;
+  std::nth_element(lats.begin(), lats.begin() + lats.size() / 2, lats.end());
+  double limit = lats[lats.size() / 2] * factor;
+
+  set<int> fast;
+  for (auto i : *have) {
+    auto p = shard_read_lat.find(shards.at(shard_id_t(i)));
+    if (p == shard_read_lat.end() || p->second <= limit)
+      fast.insert(i);
+  }
+  if (fast.size() == have->size())
+    return;
+  map<int, vector<pair<int, int>>> need;
+  if (ec_impl->minimum_to_decode(want, fast, &need) < 0)
+    return;
+  dout(20) << __func__ << " avoiding slow shards, reading from " << fast
+	   << " of " << *have << dendl;
+  get_parent()->get_logger()->inc(l_osd_ec_read_slow_shard_skip);
+  have->swap(fast);
+}
+
+void ECBackend::schedule_read_hedge(ceph_tid_t tid)
+{
+  double delay = get_hedge_delay();
+  dout(20) << __func__ << " tid " << tid << " in " << delay << "s" << dendl;
+  get_parent()->schedule_read_hedge(
+    delay,
+    get_parent()->bless_context(
+      new FunctionContext([this, tid](int r) {
+	  auto i = tid_to_read_map.find(tid);
+	  if (i != tid_to_read_map.end())
+	    send_hedged_reads(i->second);
+	})));
+}
+
+void ECBackend::send_hedged_reads(ReadOp &rop)
+{
+  if (rop.hedged || rop.do_redundant_reads)
+    return;
+
+  map<hobject_t, read_request_t> hedge;
+  for (auto &&i : rop.to_read) {
+    set<int> already_read;
+    for (auto &&j : rop.obj_to_source[i.first])
+      already_read.insert(j.shard);
+    map<pg_shard_t, vector<pair<int, int>>> shards;
+    get_remaining_shards(i.first, already_read, &shards, false);
+    if (shards.empty())
+      continue;
+    hedge.insert(
+      make_pair(
+	i.first,
+	read_request_t(
+	  i.second.to_read,
+	  shards,
+	  false,
+	  i.second.cb)));
+  }
+  if (hedge.empty())
+    return;
+
+  dout(10) << __func__ << " tid " << rop.tid << " outstanding "
+	   << rop.in_progress << dendl;
+  rop.hedged = true;
+  rop.hedged_from = rop.in_progress;
+  // complete as soon as the replies we have are enough to decode
+  rop.do_redundant_reads = true;
+  rop.trace.event("ec hedged read");
+  get_parent()->get_logger()->inc(l_osd_ec_read_hedged);
+
+  // do_read_op sends whatever is in to_read, so only hand it the new
+  // shards and then restore the original requests (and callbacks).
+  rop.to_read.swap(hedge);
+  do_read_op(rop);
+  rop.to_read.swap(hedge);
+}
+
 int ECBackend::objects_get_attrs(
   const hobject_t &hoid,
   map<string, bufferlist> *out)
@@ -395,6 +395,12 @@ public:
     void dump(Formatter *f) const;
 
     set<pg_shard_t> in_progress;
+    map<pg_shard_t, utime_t> sent;
+
+    // True once hedged sub-reads went out; hedged_from holds the shards
+    // that were still outstanding at that point
+    bool hedged = false;
+    set<pg_shard_t> hedged_from;
 
     ReadOp(
       int priority,
@@ -439,6 +445,29 @@ public:
     const hobject_t &hoid,
     ReadOp &rop);
 
+  /**
+   * Hedged client reads
+   *
+   * With osd_ec_hedged_read, client reads skip shards whose average
+   * sub-read latency is well above the median (as long as the rest can
+   * still decode), and a read still outstanding after
+   * osd_ec_hedged_read_percentile of recent sub-read latencies is sent
+   * to the remaining shards as well.  From then on it completes as soon
+   * as the replies are decodable, like a fast_read.
+   */
+  map<pg_shard_t, double> shard_read_lat;  ///< moving average, seconds
+  vector<double> recent_read_lat;          ///< ring of recent samples
+  unsigned recent_read_lat_pos = 0;
+  unsigned slow_shard_probe = 0;
+  void note_sub_read_latency(pg_shard_t from, double lat, bool censored);
+  double get_hedge_delay() const;
+  void filter_slow_shards(
+    const set<int> &want,
+    const map<shard_id_t, pg_shard_t> &shards,
+    set<int> *have);
+  void schedule_read_hedge(ceph_tid_t tid);
+  void send_hedged_reads(ReadOp &rop);
+
 
   /**
    * Client writes
@@ -28,6 +28,29 @@ int ECUtil::decode(
   if (total_data_size == 0)
     return 0;
 
+  if (ec_impl->supports_multi_stripe() &&
+      ec_impl->get_sub_chunk_count() == 1) {
+    // rebuild the missing data shards in one call, then interleave
+    // the data chunks back into stripes
+    const vector<int> &mapping = ec_impl->get_chunk_mapping();
+    vector<int> data_chunks;
+    for (unsigned i = 0; i < ec_impl->get_data_chunk_count(); i++)
+      data_chunks.push_back(mapping.size() > i ? mapping[i] : (int)i);
+    set<int> want(data_chunks.begin(), data_chunks.end());
+    map<int, bufferlist> decoded;
+    int r = ec_impl->decode_stripes(want, to_decode, sinfo.get_chunk_size(),
+				    &decoded);
+    assert(r == 0);
+    for (uint64_t i = 0; i < total_data_size; i += sinfo.get_chunk_size()) {
+      for (auto j : data_chunks) {
+	bufferlist bl;
+	bl.substr_of(decoded[j], i, sinfo.get_chunk_size());
+	out->claim_append(bl);
+      }
+    }
+    return 0;
+  }
+
   for (uint64_t i = 0; i < total_data_size; i += sinfo.get_chunk_size()) {
     map<int, bufferlist> chunks;
     for (map<int, bufferlist>::iterator j = to_decode.begin();
@@ -93,6 +116,20 @@ int ECUtil::decode(
     }
   }
 
+  if (ec_impl->supports_multi_stripe() &&
+      ec_impl->get_sub_chunk_count() == 1) {
+    // the shards can be decoded whole, no need to go stripe by stripe
+    map<int, bufferlist> out_bls;
+    r = ec_impl->decode_stripes(need, to_decode, sinfo.get_chunk_size(),
+				&out_bls);
+    assert(r == 0);
+    for (auto j = out.begin(); j != out.end(); ++j) {
+      assert(out_bls.count(j->first));
+      j->second->claim_append(out_bls[j->first]);
+    }
+    return 0;
+  }
+
   for (int i = 0; i < chunks_count; i++) {
     map<int, bufferlist> chunks;
     for (auto j = to_decode.begin();
@@ -133,6 +170,16 @@ int ECUtil::encode(
   if (logical_size == 0)
     return 0;
 
+  if (ec_impl->supports_multi_stripe()) {
+    int r = ec_impl->encode_stripes(want, in, sinfo.get_stripe_width(), out);
+    if (r != -EINVAL) {
+      assert(r == 0);
+      return 0;
+    }
+    // a stripe width the plugin would pad: go stripe by stripe
+    out->clear();
+  }
+
   for (uint64_t i = 0; i < logical_size; i += sinfo.get_stripe_width()) {
     map<int, bufferlist> encoded;
     bufferlist buf;
@@ -0,0 +1,103 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_OSD_FREQUENCYSKETCH_H
+#define CEPH_OSD_FREQUENCYSKETCH_H
+
+#include <algorithm>
+#include <vector>
+
+#include "common/hobject.h"
+
+/**
+ * FrequencySketch - approximate access counts of objects
+ *
+ * A count-min sketch of saturating 8 bit counters.  Every time the
+ * sketch has seen ten accesses per counter of a row, all counters are
+ * halved, so the counts favor recent accesses (as in TinyLFU) and the
+ * sketch never needs to be reset.  Estimates never undercount the
+ * accesses since the last halving.
+ */
+class FrequencySketch {
+  static const unsigned DEPTH = 4;
+
+  unsigned width_mask;
+  std::vector<uint8_t> counters;   ///< DEPTH rows of width_mask + 1
+  uint32_t samples = 0;            ///< increments since the last halving
+  uint32_t sample_limit;
+  bool warm = false;               ///< seen enough accesses to be trusted
+
+  static uint64_t mix(uint64_t h) {
+    // splitmix64 finalizer
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+  }
+  static uint64_t key(const hobject_t& oid) {
+    return ((uint64_t)oid.get_hash() << 32) ^ (uint64_t)oid.snap;
+  }
+  unsigned slot(uint64_t k, unsigned row) const {
+    return row * (width_mask + 1) +
+      (mix(k + (row + 1) * 0x9e3779b97f4a7c15ull) & width_mask);
+  }
+
+  void age() {
+    for (auto& c : counters) {
+      c >>= 1;
+    }
+    samples = 0;
+  }
+
+public:
+  /// @param width counters per row, rounded up to a power of two
+  explicit FrequencySketch(unsigned width) {
+    unsigned w = 1;
+    while (w < width) {
+      w <<= 1;
+    }
+    width_mask = w - 1;
+    counters.resize(DEPTH * w);
+    sample_limit = 10 * w;
+  }
+
+  void increment(const hobject_t& oid) {
+    uint64_t k = key(oid);
+    for (unsigned row = 0; row < DEPTH; ++row) {
+      uint8_t& c = counters[slot(k, row)];
+      if (c < 255) {
+	++c;
+      }
+    }
+    if (++samples > width_mask) {
+      warm = true;
+    }
+    if (samples >= sample_limit) {
+      age();
+    }
+  }
+
+  unsigned estimate(const hobject_t& oid) const {
+    uint64_t k = key(oid);
+    unsigned est = 255;
+    for (unsigned row = 0; row < DEPTH; ++row) {
+      est = std::min<unsigned>(est, counters[slot(k, row)]);
+    }
+    return est;
+  }
+
+  /// true once the sketch has seen as many accesses as a row has counters
+  bool is_warm() const {
+    return warm;
+  }
+};
+
+#endif
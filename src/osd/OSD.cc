@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <ctype.h>
+#include <thread>
 #include <boost/scoped_ptr.hpp>
 
 #ifdef HAVE_SYS_PARAM_H
@@ -30,6 +31,10 @@
 #include <sys/mount.h>
 #endif
 
+#ifdef HAVE_SCHED
+#include <sched.h>
+#endif
+
 #include "osd/PG.h"
 
 #include "include/types.h"
@@ -54,6 +59,10 @@
 
 #include "PrimaryLogPG.h"
 
+extern "C" {
+#include "crush/hash.h"
+}
+
 
 #include "msg/Messenger.h"
 #include "msg/Message.h"
@@ -67,6 +76,7 @@
 #include "messages/MOSDFailure.h"
 #include "messages/MOSDMarkMeDown.h"
 #include "messages/MOSDFull.h"
+#include "messages/MOSDFastDispatchOp.h"
 #include "messages/MOSDOp.h"
 #include "messages/MOSDOpReply.h"
 #include "messages/MOSDBackoff.h"
@@ -257,6 +267,9 @@ OSDService::OSDService(OSD *osd) :
   scrub_sleep_lock("OSDService::scrub_sleep_lock"),
   scrub_sleep_timer(
     osd->client_messenger->cct, scrub_sleep_lock, false /* relax locking */),
+  read_hedge_lock("OSDService::read_hedge_lock"),
+  read_hedge_timer(
+    osd->client_messenger->cct, read_hedge_lock, false /* relax locking */),
   snap_reserver(cct, &reserver_finisher,
 		cct->_conf->osd_max_trimming_pgs),
   recovery_lock("OSDService::recovery_lock"),
@@ -548,6 +561,11 @@ void OSDService::shutdown()
     scrub_sleep_timer.shutdown();
   }
 
+  {
+    Mutex::Locker l(read_hedge_lock);
+    read_hedge_timer.shutdown();
+  }
+
   osdmap = OSDMapRef();
   next_osdmap = OSDMapRef();
 }
@@ -567,6 +585,7 @@ void OSDService::init()
   agent_timer.init();
   snap_sleep_timer.init();
   scrub_sleep_timer.init();
+  read_hedge_timer.init();
 
   agent_thread.create("osd_srv_agent");
 
@@ -997,7 +1016,16 @@ void OSDService::send_message_osd_cluster(int peer, Message *m, epoch_t from_epo
     return;
   }
   const entity_inst_t& peer_inst = next_map->get_cluster_inst(peer);
-  ConnectionRef peer_con = osd->cluster_messenger->get_connection(peer_inst);
+  ConnectionRef peer_con;
+  if (static_cast<Dispatcher*>(osd)->ms_can_fast_dispatch(m)) {
+    // pg-scoped ops only need ordering within their pg, which lets them
+    // spread over several sessions to the peer (ms_async_peer_lanes)
+    spg_t pgid = static_cast<MOSDFastDispatchOp*>(m)->get_spg();
+    peer_con = osd->cluster_messenger->get_connection_lane(
+      peer_inst, pgid.pgid.ps() ^ pgid.pgid.pool());
+  } else {
+    peer_con = osd->cluster_messenger->get_connection(peer_inst);
+  }
   share_map_peer(peer, peer_con.get(), next_map);
   peer_con->send_message(m);
   release_map(next_map);
@@ -1551,11 +1579,16 @@ OSDMapRef OSDService::_add_map(OSDMap *o)
       OSDMap::dedup(for_dedup.get(), o);
     }
   }
+  if (cct->_conf->osd_map_mapping_cache) {
+    // maps in the cache are never modified again
+    o->enable_mapping_cache();
+  }
   bool existed;
   OSDMapRef l = map_cache.add(e, o, &existed);
   if (existed) {
     delete o;
   }
+  logger->set(l_osd_map_bytes, mempool::osdmap::allocated_bytes());
   return l;
 }
 
@@ -2015,6 +2048,8 @@ OSD::OSD(CephContext *cct_, ObjectStore *store_,
                                            cct->_conf->osd_op_history_duration);
   op_tracker.set_history_slow_op_size_and_threshold(cct->_conf->osd_op_history_slow_op_size,
                                                     cct->_conf->osd_op_history_slow_op_threshold);
+  op_tracker.set_lite(cct->_conf->get_val<bool>("osd_op_tracker_lite"),
+                      cct->_conf->get_val<uint64_t>("osd_op_tracker_sample_rate"));
 #ifdef WITH_BLKIN
   std::stringstream ss;
   ss << "osd." << whoami;
@@ -2207,6 +2242,10 @@ will start to track new ops received afterwards.";
     service.remote_reserver.dump(f);
     f->close_section();
     f->close_section();
+  } else if (admin_command == "dump_cls_stats") {
+    f->open_object_section("cls_stats");
+    class_handler->dump_stats(f);
+    f->close_section();
   } else if (admin_command == "get_latest_osdmap") {
     get_latest_osdmap();
   } else if (admin_command == "heap") {
@@ -2268,6 +2307,14 @@ will start to track new ops received afterwards.";
     store->generate_db_histogram(f);
   } else if (admin_command == "flush_store_cache") {
     store->flush_cache();
+  } else if (admin_command == "dump_objectstore_cache_stats") {
+    store->dump_cache_stats(f);
+  } else if (admin_command == "dump_objectstore_alloc_stats") {
+    store->dump_alloc_stats(f);
+  } else if (admin_command == "dump_objectstore_pool_stats") {
+    store->dump_pool_stats(f);
+  } else if (admin_command == "dump_heartbeat_peers") {
+    dump_heartbeat_peers(f);
   } else if (admin_command == "dump_pgstate_history") {
     f->open_object_section("pgstate_history");
     RWLock::RLocker l2(pg_map_lock);
@@ -2387,6 +2434,27 @@ int OSD::get_num_op_shards()
     return cct->_conf->osd_op_num_shards_ssd;
 }
 
+int OSD::get_op_shard_cpu(unsigned shard)
+{
+  // shard N shares a core with messenger worker N (both wrap around
+  // ms_async_affinity_cores), so ops for PGs in that shard that arrive on
+  // that worker are processed without leaving the core
+  if (!cct->_conf->get_val<bool>("osd_op_shard_affinity"))
+    return -1;
+  vector<string> corestrs;
+  get_str_vec(cct->_conf->ms_async_affinity_cores, corestrs);
+  vector<int> cores;
+  for (auto& corestr : corestrs) {
+    string err;
+    int core = strict_strtol(corestr.c_str(), 10, &err);
+    if (err.empty())
+      cores.push_back(core);
+  }
+  if (cores.empty())
+    return -1;
+  return cores[shard % cores.size()];
+}
+
 int OSD::get_num_op_threads()
 {
   if (cct->_conf->osd_op_num_threads_per_shard)
@@ -2416,6 +2484,7 @@ int OSD::init()
   if (is_stopping())
     return 0;
 
+  init_stamp = ceph_clock_now();
   tick_timer.init();
   tick_timer_without_osd_lock.init();
   service.recovery_request_timer.init();
@@ -2574,8 +2643,10 @@ int OSD::init()
   dout(2) << "superblock: I am osd." << superblock.whoami << dendl;
   dout(0) << "using " << op_queue << " op queue with priority op cut off at " <<
     op_prio_cutoff << "." << dendl;
+  calibrate_mclock_capacity();
 
   create_logger();
+  logger->tset(l_osd_boot_load_pgs, load_pgs_time);
 
   // i'm ready!
   client_messenger->add_dispatcher_head(this);
@@ -2759,6 +2830,10 @@ void OSD::final_init()
 				     asok_hook,
 				     "show recovery reservations");
   assert(r == 0);
+  r = admin_socket->register_command("dump_cls_stats", "dump_cls_stats",
+				     asok_hook,
+				     "show per-method object class call stats");
+  assert(r == 0);
   r = admin_socket->register_command("get_latest_osdmap", "get_latest_osdmap",
 				     asok_hook,
 				     "force osd to update the latest map from "
@@ -2811,6 +2886,26 @@ void OSD::final_init()
                                      asok_hook,
                                      "Flush bluestore internal cache");
   assert(r == 0);
+  r = admin_socket->register_command("dump_objectstore_cache_stats",
+				     "dump_objectstore_cache_stats",
+				     asok_hook,
+				     "dump per-shard objectstore cache statistics");
+  assert(r == 0);
+  r = admin_socket->register_command("dump_objectstore_alloc_stats",
+				     "dump_objectstore_alloc_stats",
+				     asok_hook,
+				     "dump objectstore allocator free space and fragmentation");
+  assert(r == 0);
+  r = admin_socket->register_command("dump_objectstore_pool_stats",
+				     "dump_objectstore_pool_stats",
+				     asok_hook,
+				     "dump objectstore per-pool write statistics");
+  assert(r == 0);
+  r = admin_socket->register_command("dump_heartbeat_peers",
+				     "dump_heartbeat_peers",
+				     asok_hook,
+				     "dump heartbeat peers and ping round trip times");
+  assert(r == 0);
   r = admin_socket->register_command("dump_pgstate_history", "dump_pgstate_history",
 				     asok_hook,
 				     "show recent state history");
@@ -3100,6 +3195,8 @@ void OSD::create_logger()
     PerfCountersBuilder::PRIO_USEFUL);
   osd_plb.add_u64(
     l_osd_hb_to, "heartbeat_to_peers", "Heartbeat (ping) peers we send to");
+  osd_plb.add_time_avg(
+    l_osd_hb_rtt, "heartbeat_rtt", "Heartbeat (ping) round trip time");
   osd_plb.add_u64_counter(l_osd_map, "map_messages", "OSD map messages");
   osd_plb.add_u64_counter(l_osd_mape, "map_message_epochs", "OSD map epochs");
   osd_plb.add_u64_counter(
@@ -3124,6 +3221,12 @@ void OSD::create_logger()
   osd_plb.add_u64_counter(
     l_osd_map_bl_cache_miss, "osd_map_bl_cache_miss",
     "OSDMap buffer cache misses");
+  osd_plb.add_u64_counter(
+    l_osd_map_inc_shared, "osd_map_inc_shared",
+    "Incremental OSDMaps applied to a cached decoded map");
+  osd_plb.add_u64(
+    l_osd_map_bytes, "osd_map_bytes",
+    "Bytes allocated for decoded OSDMaps (osdmap mempool)");
 
   osd_plb.add_u64(
     l_osd_stat_bytes, "stat_bytes", "OSD size", "size",
@@ -3136,6 +3239,25 @@ void OSD::create_logger()
   osd_plb.add_u64_counter(
     l_osd_copyfrom, "copyfrom", "Rados \"copy-from\" operations");
 
+  osd_plb.add_u64_counter(
+    l_osd_ec_write_full, "ec_write_full",
+    "EC writes covering whole stripes");
+  osd_plb.add_u64_counter(
+    l_osd_ec_write_rmw, "ec_write_rmw",
+    "EC writes that read partial stripes before encoding");
+  osd_plb.add_u64_counter(
+    l_osd_ec_write_rmw_read_bytes, "ec_write_rmw_read_bytes",
+    "Logical bytes read for EC partial stripe writes");
+  osd_plb.add_u64_counter(
+    l_osd_ec_read_hedged, "ec_read_hedged",
+    "EC reads that sent hedged sub-reads to extra shards");
+  osd_plb.add_u64_counter(
+    l_osd_ec_read_hedge_won, "ec_read_hedge_won",
+    "Hedged EC reads completed using a hedged sub-read");
+  osd_plb.add_u64_counter(
+    l_osd_ec_read_slow_shard_skip, "ec_read_slow_shard_skip",
+    "EC reads that avoided a shard because of its latency");
+
   osd_plb.add_u64_counter(l_osd_tier_promote, "tier_promote", "Tier promotions");
   osd_plb.add_u64_counter(l_osd_tier_flush, "tier_flush", "Tier flushes");
   osd_plb.add_u64_counter(
@@ -3190,6 +3312,46 @@ void OSD::create_logger()
   osd_plb.add_u64_counter(
     l_osd_pg_biginfo, "osd_pg_biginfo", "PG updated its biginfo attr");
 
+  osd_plb.add_time(
+    l_osd_boot_load_pgs, "boot_load_pgs",
+    "Time spent loading PGs at startup");
+  osd_plb.add_time(
+    l_osd_boot_up, "boot_up",
+    "Time from OSD init until it was marked up");
+
+  osd_plb.add_u64_counter(
+    l_osd_snap_trim_objects, "snap_trim_objects",
+    "Clones trimmed by the snap trimmer");
+  osd_plb.add_u64_counter(
+    l_osd_snap_trim_snaps, "snap_trim_snaps",
+    "Snaps completely trimmed and added to purged_snaps");
+  osd_plb.add_time_avg(
+    l_osd_snap_trim_lat, "snap_trim_lat",
+    "Latency of a clone trim, from submit to commit");
+
+  osd_plb.add_u64_counter(
+    l_osd_notify, "notify", "Completed notifies");
+  osd_plb.add_u64_counter(
+    l_osd_notify_watchers, "notify_watchers",
+    "Watchers notified by completed notifies");
+  osd_plb.add_u64_counter(
+    l_osd_notify_timeout, "notify_timeout",
+    "Notifies completed by timeout");
+  osd_plb.add_time_avg(
+    l_osd_notify_lat, "notify_latency",
+    "Latency of notify, from start until the last ack or timeout");
+  PerfHistogramCommon::axis_config_d notify_hist_y_axis_config{
+    "Watchers",
+    PerfHistogramCommon::SCALE_LOG2, ///< Watcher count in logarithmic scale
+    0,                               ///< Start at 0
+    1,                               ///< Quantization unit is 1 watcher
+    20,                              ///< Enough for any practical fan-out
+  };
+  osd_plb.add_u64_counter_histogram(
+    l_osd_notify_lat_watchers_hist, "notify_latency_watchers_histogram",
+    op_hist_x_axis_config, notify_hist_y_axis_config,
+    "Histogram of notify latency + number of watchers notified");
+
   logger = osd_plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(logger);
 }
@@ -3297,6 +3459,7 @@ int OSD::shutdown()
   cct->get_admin_socket()->unregister_command("dump_blacklist");
   cct->get_admin_socket()->unregister_command("dump_watchers");
   cct->get_admin_socket()->unregister_command("dump_reservations");
+  cct->get_admin_socket()->unregister_command("dump_cls_stats");
   cct->get_admin_socket()->unregister_command("get_latest_osdmap");
   cct->get_admin_socket()->unregister_command("heap");
   cct->get_admin_socket()->unregister_command("set_heap_property");
@@ -3305,6 +3468,10 @@ int OSD::shutdown()
   cct->get_admin_socket()->unregister_command("dump_scrubs");
   cct->get_admin_socket()->unregister_command("calc_objectstore_db_histogram");
   cct->get_admin_socket()->unregister_command("flush_store_cache");
+  cct->get_admin_socket()->unregister_command("dump_objectstore_cache_stats");
+  cct->get_admin_socket()->unregister_command("dump_objectstore_alloc_stats");
+  cct->get_admin_socket()->unregister_command("dump_objectstore_pool_stats");
+  cct->get_admin_socket()->unregister_command("dump_heartbeat_peers");
   cct->get_admin_socket()->unregister_command("dump_pgstate_history");
   cct->get_admin_socket()->unregister_command("compact");
   delete asok_hook;
@@ -3892,7 +4059,9 @@ void OSD::load_pgs()
     derr << "failed to list pgs: " << cpp_strerror(-r) << dendl;
   }
 
+  utime_t start = ceph_clock_now();
   int num = 0;
+  vector<PGRef> to_load;
   for (vector<coll_t>::iterator it = ls.begin();
        it != ls.end();
        ++it) {
@@ -3947,12 +4116,44 @@ void OSD::load_pgs()
       pg = _open_lock_pg(osdmap, pgid);
     }
     // there can be no waiters here, so we don't call wake_pg_waiters
+    op_shardedwq.register_pg(pg);
 
     pg->ch = store->open_collection(pg->coll);
+    pg->unlock();
+    to_load.push_back(pg);
+  }
+
+  // read pg state, log.  this is where the time goes, and each pg only
+  // touches its own collection, so spread it over a few threads.
+  unsigned num_threads = MIN(
+    MAX(1, cct->_conf->get_val<uint64_t>("osd_load_pgs_threads")),
+    MAX(1, to_load.size()));
+  std::atomic<size_t> next_pg = { 0 };
+  auto read_pgs = [&]() {
+    size_t i;
+    while ((i = next_pg++) < to_load.size()) {
+      PG *pg = to_load[i].get();
+      pg->lock();
+      pg->read_state(store);
+      pg->unlock();
+    }
+  };
+  if (num_threads > 1) {
+    dout(10) << __func__ << " reading " << to_load.size() << " pgs on "
+	     << num_threads << " threads" << dendl;
+    vector<std::thread> readers;
+    for (unsigned i = 0; i < num_threads; ++i) {
+      readers.emplace_back(read_pgs);
+    }
+    for (auto& t : readers) {
+      t.join();
+    }
+  } else {
+    read_pgs();
+  }
 
-    // read pg state, log
-    pg->read_state(store);
-
+  for (auto& pg : to_load) {
+    pg->lock();
     service.init_splits_between(pg->pg_id, pg->get_osdmap(), osdmap);
 
     pg->reg_next_scrub();
@@ -3961,7 +4162,9 @@ void OSD::load_pgs()
     pg->unlock();
     ++num;
   }
-  dout(0) << __func__ << " opened " << num << " pgs" << dendl;
+  load_pgs_time = ceph_clock_now() - start;
+  dout(0) << __func__ << " opened " << num << " pgs in " << load_pgs_time
+	  << dendl;
 }
 
 
@@ -4499,16 +4702,29 @@ void OSD::maybe_update_heartbeat_peers()
 
   // build heartbeat from set
   if (is_active()) {
-    RWLock::RLocker l(pg_map_lock);
-    for (ceph::unordered_map<spg_t, PG*>::iterator i = pg_map.begin();
-	 i != pg_map.end();
-	 ++i) {
-      PG *pg = i->second;
-      pg->with_heartbeat_peers([&](int peer) {
-	  if (osdmap->is_up(peer)) {
-	    _add_heartbeat_peer(peer);
-	  }
-	});
+    set<int> pg_peers;
+    {
+      RWLock::RLocker l(pg_map_lock);
+      for (ceph::unordered_map<spg_t, PG*>::iterator i = pg_map.begin();
+	   i != pg_map.end();
+	   ++i) {
+	PG *pg = i->second;
+	pg->with_heartbeat_peers([&](int peer) {
+	    if (osdmap->is_up(peer)) {
+	      pg_peers.insert(peer);
+	    }
+	  });
+      }
+    }
+    unsigned max_pg_peers =
+      cct->_conf->get_val<uint64_t>("osd_heartbeat_max_pg_peers");
+    if (max_pg_peers > 0 && pg_peers.size() > max_pg_peers) {
+      dout(10) << " subsampling " << pg_peers.size() << " pg peers to "
+	       << max_pg_peers << dendl;
+      _subsample_heartbeat_peers(&pg_peers, max_pg_peers);
+    }
+    for (auto peer : pg_peers) {
+      _add_heartbeat_peer(peer);
     }
   }
 
@@ -4569,6 +4785,71 @@ void OSD::maybe_update_heartbeat_peers()
   dout(10) << "maybe_update_heartbeat_peers " << heartbeat_peers.size() << " peers, extras " << extras << dendl;
 }
 
+/*
+ * Pick at most max of the given peers.  Peers are grouped by their
+ * crush host and taken round-robin across hosts, so that every host we
+ * share PGs with keeps being watched before any host gets a second
+ * peer.  The starting host and the order within a host are seeded by
+ * our id so that different OSDs watch different peers.
+ */
+void OSD::_subsample_heartbeat_peers(set<int> *peers, unsigned max)
+{
+  assert(heartbeat_lock.is_locked());
+  int host_type = osdmap->crush->get_type_id("host");
+  map<int, vector<pair<uint32_t, int>>> by_host;
+  for (auto p : *peers) {
+    int host = host_type >= 0 ?
+      osdmap->crush->get_parent_of_type(p, host_type) : 0;
+    by_host[host].push_back(
+      make_pair(crush_hash32_2(CRUSH_HASH_RJENKINS1, whoami, p), p));
+  }
+  vector<vector<pair<uint32_t, int>>*> hosts;
+  for (auto& i : by_host) {
+    std::sort(i.second.begin(), i.second.end());
+    hosts.push_back(&i.second);
+  }
+
+  set<int> chosen;
+  size_t first = whoami % hosts.size();
+  for (size_t round = 0; chosen.size() < max; ++round) {
+    bool any = false;
+    for (size_t n = 0; n < hosts.size() && chosen.size() < max; ++n) {
+      auto& host = *hosts[(first + n) % hosts.size()];
+      if (round < host.size()) {
+	chosen.insert(host[round].second);
+	any = true;
+      }
+    }
+    if (!any)
+      break;
+  }
+  peers->swap(chosen);
+}
+
+void OSD::dump_heartbeat_peers(Formatter *f)
+{
+  Mutex::Locker l(heartbeat_lock);
+  f->open_array_section("heartbeat_peers");
+  for (auto& i : heartbeat_peers) {
+    const HeartbeatInfo& hi = i.second;
+    f->open_object_section("peer");
+    f->dump_int("osd", i.first);
+    f->dump_unsigned("epoch", hi.epoch);
+    f->dump_stream("first_tx") << hi.first_tx;
+    f->dump_stream("last_tx") << hi.last_tx;
+    f->dump_stream("last_rx_front") << hi.last_rx_front;
+    f->dump_stream("last_rx_back") << hi.last_rx_back;
+    f->dump_float("last_rtt_front", (double)hi.last_rtt_front);
+    f->dump_float("last_rtt_back", (double)hi.last_rtt_back);
+    f->dump_float("avg_rtt",
+		  hi.rtt_count ? (double)hi.rtt_sum / hi.rtt_count : 0.0);
+    f->dump_float("max_rtt", (double)hi.rtt_max);
+    f->dump_unsigned("rtt_samples", hi.rtt_count);
+    f->close_section();
+  }
+  f->close_section();
+}
+
 void OSD::reset_heartbeat_peers()
 {
   assert(osd_lock.is_locked());
@@ -4685,6 +4966,9 @@ void OSD::handle_osd_ping(MOSDPing *m)
 	  // if there is no front con, set both stamps.
 	  if (i->second.con_front == NULL)
 	    i->second.last_rx_front = m->stamp;
+	  utime_t rtt = ceph_clock_now() - m->stamp;
+	  i->second.note_rtt(rtt, false);
+	  logger->tinc(l_osd_hb_rtt, rtt);
 	} else if (m->get_connection() == i->second.con_front) {
 	  dout(25) << "handle_osd_ping got reply from osd." << from
 		   << " first_tx " << i->second.first_tx
@@ -4693,6 +4977,9 @@ void OSD::handle_osd_ping(MOSDPing *m)
 		   << " last_rx_front " << i->second.last_rx_front << " -> " << m->stamp
 		   << dendl;
 	  i->second.last_rx_front = m->stamp;
+	  utime_t rtt = ceph_clock_now() - m->stamp;
+	  i->second.note_rtt(rtt, true);
+	  logger->tinc(l_osd_hb_rtt, rtt);
 	}
 
         utime_t cutoff = ceph_clock_now();
@@ -4992,10 +5279,46 @@ void OSD::tick_without_osd_lock()
   }
 
   check_ops_in_flight();
+  check_memory_target();
   service.kick_recovery_queue();
   tick_timer_without_osd_lock.add_event_after(OSD_TICK_INTERVAL, new C_Tick_WithoutOSDLock(this));
 }
 
+void OSD::check_memory_target()
+{
+  uint64_t target = cct->_conf->get_val<uint64_t>("osd_memory_target");
+  if (!target && !memory_pressure)
+    return;
+
+  uint64_t total = 0;
+  for (int i = 0; i < mempool::num_pools; ++i)
+    total += mempool::get_pool(mempool::pool_index_t(i)).allocated_bytes();
+  bool over = target && total > target;
+
+  if (over != memory_pressure) {
+    if (over) {
+      dout(1) << __func__ << " mempools at " << prettybyte_t(total)
+	      << " exceed osd_memory_target " << prettybyte_t(target)
+	      << ", shrinking caches" << dendl;
+    } else {
+      dout(1) << __func__ << " mempools at " << prettybyte_t(total)
+	      << " back under target, restoring caches" << dendl;
+    }
+    memory_pressure = over;
+  }
+
+  // keep only a quarter of the osdmap cache while under pressure
+  size_t map_cache_size = cct->_conf->osd_map_cache_size;
+  if (memory_pressure)
+    map_cache_size = MAX(map_cache_size / 4, (size_t)1);
+  service.map_cache.set_size(map_cache_size);
+  service.map_bl_cache.set_size(map_cache_size);
+  service.map_bl_inc_cache.set_size(map_cache_size);
+
+  if (memory_pressure && ceph_using_tcmalloc())
+    ceph_heap_release_free_memory();
+}
+
 void OSD::check_ops_in_flight()
 {
   vector<string> warnings;
@@ -5667,6 +5990,9 @@ void OSD::_collect_metadata(map<string,string> *pm)
   (*pm)["back_addr"] = stringify(cluster_messenger->get_myaddr());
   (*pm)["hb_front_addr"] = stringify(hb_front_server_messenger->get_myaddr());
   (*pm)["hb_back_addr"] = stringify(hb_back_server_messenger->get_myaddr());
+  int64_t numa_node = cct->_conf->get_val<int64_t>("osd_numa_node");
+  if (numa_node >= 0)
+    (*pm)["numa_node"] = stringify(numa_node);
 
   // backend
   (*pm)["osd_objectstore"] = store->get_type();
@@ -6144,9 +6470,6 @@ void OSD::do_command(Connection *con, ceph_tid_t tid, vector<string>& cmd, buffe
     cmd_getval(cct, cmdmap, "object_size", osize, (int64_t)0);
     cmd_getval(cct, cmdmap, "object_num", onum, (int64_t)0);
 
-    ceph::shared_ptr<ObjectStore::Sequencer> osr (std::make_shared<
-                                        ObjectStore::Sequencer>("bench"));
-
     uint32_t duration = cct->_conf->osd_bench_duration;
 
     if (bsize > (int64_t) cct->_conf->osd_bench_max_block_size) {
@@ -6204,79 +6527,8 @@ void OSD::do_command(Connection *con, ceph_tid_t tid, vector<string>& cmd, buffe
     if (osize && bsize > osize)
       bsize = osize;
 
-    dout(1) << " bench count " << count
-            << " bsize " << prettybyte_t(bsize) << dendl;
-
-    ObjectStore::Transaction cleanupt;
-
-    if (osize && onum) {
-      bufferlist bl;
-      bufferptr bp(osize);
-      bp.zero();
-      bl.push_back(std::move(bp));
-      bl.rebuild_page_aligned();
-      for (int i=0; i<onum; ++i) {
-	char nm[30];
-	snprintf(nm, sizeof(nm), "disk_bw_test_%d", i);
-	object_t oid(nm);
-	hobject_t soid(sobject_t(oid, 0));
-	ObjectStore::Transaction t;
-	t.write(coll_t(), ghobject_t(soid), 0, osize, bl);
-	store->queue_transaction(osr.get(), std::move(t), NULL);
-	cleanupt.remove(coll_t(), ghobject_t(soid));
-      }
-    }
-
-    bufferlist bl;
-    bufferptr bp(bsize);
-    bp.zero();
-    bl.push_back(std::move(bp));
-    bl.rebuild_page_aligned();
-
-    {
-      C_SaferCond waiter;
-      if (!osr->flush_commit(&waiter)) {
-	waiter.wait();
-      }
-    }
-
-    utime_t start = ceph_clock_now();
-    for (int64_t pos = 0; pos < count; pos += bsize) {
-      char nm[30];
-      unsigned offset = 0;
-      if (onum && osize) {
-	snprintf(nm, sizeof(nm), "disk_bw_test_%d", (int)(rand() % onum));
-	offset = rand() % (osize / bsize) * bsize;
-      } else {
-	snprintf(nm, sizeof(nm), "disk_bw_test_%lld", (long long)pos);
-      }
-      object_t oid(nm);
-      hobject_t soid(sobject_t(oid, 0));
-      ObjectStore::Transaction t;
-      t.write(coll_t::meta(), ghobject_t(soid), offset, bsize, bl);
-      store->queue_transaction(osr.get(), std::move(t), NULL);
-      if (!onum || !osize)
-	cleanupt.remove(coll_t::meta(), ghobject_t(soid));
-    }
-
-    {
-      C_SaferCond waiter;
-      if (!osr->flush_commit(&waiter)) {
-	waiter.wait();
-      }
-    }
-    utime_t end = ceph_clock_now();
-
-    // clean up
-    store->queue_transaction(osr.get(), std::move(cleanupt), NULL);
-    {
-      C_SaferCond waiter;
-      if (!osr->flush_commit(&waiter)) {
-	waiter.wait();
-      }
-    }
-
-    uint64_t rate = (double)count / (end - start);
+    double elapsed = run_bench(count, bsize, osize, onum);
+    uint64_t rate = (double)count / elapsed;
     if (f) {
       f->open_object_section("osd_bench_results");
       f->dump_int("bytes_written", count);
@@ -6287,7 +6539,7 @@ void OSD::do_command(Connection *con, ceph_tid_t tid, vector<string>& cmd, buffe
     } else {
       ss << "bench: wrote " << prettybyte_t(count)
 	 << " in blocks of " << prettybyte_t(bsize) << " in "
-	 << (end-start) << " sec at " << prettybyte_t(rate) << "/sec";
+	 << elapsed << " sec at " << prettybyte_t(rate) << "/sec";
     }
   }
 
@@ -6402,6 +6654,121 @@ void OSD::do_command(Connection *con, ceph_tid_t tid, vector<string>& cmd, buffe
   }
 }
 
+double OSD::run_bench(int64_t count, int64_t bsize, int64_t osize, int64_t onum)
+{
+  ceph::shared_ptr<ObjectStore::Sequencer> osr (std::make_shared<
+                                      ObjectStore::Sequencer>("bench"));
+
+  dout(1) << " bench count " << count
+	  << " bsize " << prettybyte_t(bsize) << dendl;
+
+  ObjectStore::Transaction cleanupt;
+
+  if (osize && onum) {
+    bufferlist bl;
+    bufferptr bp(osize);
+    bp.zero();
+    bl.push_back(std::move(bp));
+    bl.rebuild_page_aligned();
+    for (int i=0; i<onum; ++i) {
+      char nm[30];
+      snprintf(nm, sizeof(nm), "disk_bw_test_%d", i);
+      object_t oid(nm);
+      hobject_t soid(sobject_t(oid, 0));
+      ObjectStore::Transaction t;
+      t.write(coll_t(), ghobject_t(soid), 0, osize, bl);
+      store->queue_transaction(osr.get(), std::move(t), NULL);
+      cleanupt.remove(coll_t(), ghobject_t(soid));
+    }
+  }
+
+  bufferlist bl;
+  bufferptr bp(bsize);
+  bp.zero();
+  bl.push_back(std::move(bp));
+  bl.rebuild_page_aligned();
+
+  {
+    C_SaferCond waiter;
+    if (!osr->flush_commit(&waiter)) {
+      waiter.wait();
+    }
+  }
+
+  utime_t start = ceph_clock_now();
+  for (int64_t pos = 0; pos < count; pos += bsize) {
+    char nm[30];
+    unsigned offset = 0;
+    if (onum && osize) {
+      snprintf(nm, sizeof(nm), "disk_bw_test_%d", (int)(rand() % onum));
+      offset = rand() % (osize / bsize) * bsize;
+    } else {
+      snprintf(nm, sizeof(nm), "disk_bw_test_%lld", (long long)pos);
+    }
+    object_t oid(nm);
+    hobject_t soid(sobject_t(oid, 0));
+    ObjectStore::Transaction t;
+    t.write(coll_t::meta(), ghobject_t(soid), offset, bsize, bl);
+    store->queue_transaction(osr.get(), std::move(t), NULL);
+    if (!onum || !osize)
+      cleanupt.remove(coll_t::meta(), ghobject_t(soid));
+  }
+
+  {
+    C_SaferCond waiter;
+    if (!osr->flush_commit(&waiter)) {
+      waiter.wait();
+    }
+  }
+  utime_t end = ceph_clock_now();
+
+  // clean up
+  store->queue_transaction(osr.get(), std::move(cleanupt), NULL);
+  {
+    C_SaferCond waiter;
+    if (!osr->flush_commit(&waiter)) {
+      waiter.wait();
+    }
+  }
+  return end - start;
+}
+
+void OSD::calibrate_mclock_capacity()
+{
+  if (op_queue != io_queue::mclock_opclass &&
+      op_queue != io_queue::mclock_client)
+    return;
+  if (!cct->_conf->get_val<bool>("osd_op_queue_mclock_calibrate"))
+    return;
+
+  // the same shape as 'ceph tell osd.N bench', but short enough for
+  // the start of a slow disk: 1000 random 4k writes over 16MB of
+  // preallocated objects, and 64MB in 4MB objects
+  const int64_t small = 4 << 10;
+  const int64_t large = 4 << 20;
+  bool changed = false;
+  if (cct->_conf->get_val<double>("osd_op_queue_mclock_iops_capacity") <= 0) {
+    double iops = 1000 / std::max(run_bench(1000 * small, small, large, 4),
+				  0.001);
+    dout(1) << __func__ << " osd_op_queue_mclock_iops_capacity "
+	    << iops << dendl;
+    cct->_conf->set_val("osd_op_queue_mclock_iops_capacity",
+			stringify(iops));
+    changed = true;
+  }
+  if (cct->_conf->get_val<uint64_t>("osd_op_queue_mclock_bandwidth_capacity") == 0) {
+    uint64_t bw = (16 * large) / std::max(run_bench(16 * large, large, 0, 0),
+					  0.001);
+    dout(1) << __func__ << " osd_op_queue_mclock_bandwidth_capacity "
+	    << prettybyte_t(bw) << "/s" << dendl;
+    cct->_conf->set_val("osd_op_queue_mclock_bandwidth_capacity",
+			stringify(bw));
+    changed = true;
+  }
+  if (changed)
+    cct->_conf->apply_changes(nullptr);
+}
+
 bool OSD::heartbeat_dispatch(Message *m)
 {
   dout(30) << "heartbeat_dispatch " << m << dendl;
@@ -7316,10 +7683,19 @@ void OSD::handle_osd_map(MOSDMap *m)
 
       OSDMap *o = new OSDMap;
       if (e > 1) {
-	bufferlist obl;
-        bool got = get_map_bl(e - 1, obl);
-        assert(got);
-	o->decode(obl);
+	OSDMapRef prev;
+	if (cct->_conf->osd_map_share_decoded)
+	  prev = service.map_cache.lookup(e - 1);
+	if (prev) {
+	  // share everything the incremental does not touch
+	  o->cow_copy_from(*prev);
+	  logger->inc(l_osd_map_inc_shared);
+	} else {
+	  bufferlist obl;
+	  bool got = get_map_bl(e - 1, obl);
+	  assert(got);
+	  o->decode(obl);
+	}
       }
 
       OSDMap::Incremental inc;
@@ -7495,6 +7871,7 @@ void OSD::_committed_osd_maps(epoch_t first, epoch_t last, MOSDMap *m)
     if (is_booting()) {
       dout(1) << "state: booting -> active" << dendl;
       set_state(STATE_ACTIVE);
+      logger->tset(l_osd_boot_up, ceph_clock_now() - init_stamp);
 
       // set incarnation so that osd_reqid_t's we generate for our
       // objecter requests are unique across restarts.
@@ -9249,6 +9626,8 @@ const char** OSD::get_tracked_conf_keys() const
     "osd_op_history_slow_op_size",
     "osd_op_history_slow_op_threshold",
     "osd_enable_op_tracker",
+    "osd_op_tracker_lite",
+    "osd_op_tracker_sample_rate",
     "osd_map_cache_size",
     "osd_map_max_advance",
     "osd_pg_epoch_persisted_max_stale",
@@ -9307,6 +9686,11 @@ void OSD::handle_conf_change(const struct md_config_t *conf,
   if (changed.count("osd_enable_op_tracker")) {
       op_tracker.set_tracking(cct->_conf->osd_enable_op_tracker);
   }
+  if (changed.count("osd_op_tracker_lite") ||
+      changed.count("osd_op_tracker_sample_rate")) {
+    op_tracker.set_lite(cct->_conf->get_val<bool>("osd_op_tracker_lite"),
+                        cct->_conf->get_val<uint64_t>("osd_op_tracker_sample_rate"));
+  }
   if (changed.count("osd_disk_thread_ioprio_class") ||
       changed.count("osd_disk_thread_ioprio_priority")) {
     set_disk_tp_priority();
@@ -9617,9 +10001,15 @@ int OSD::init_op_flags(OpRequestRef& op)
 }
 
 void OSD::PeeringWQ::_dequeue(list<PG*> *out) {
+  // when the queue backs up (e.g. a peering storm after a host restart),
+  // take larger batches so that notifies, queries and infos for more pgs
+  // are coalesced into one message per peer osd
+  uint64_t batch = osd->cct->_conf->osd_peering_wq_batch_size;
+  int threads = MAX(1, (int)osd->cct->_conf->osd_peering_wq_threads);
+  batch = MAX(batch, MIN(peering_queue.size() / threads, batch * 8));
   for (list<PG*>::iterator i = peering_queue.begin();
       i != peering_queue.end() &&
-      out->size() < osd->cct->_conf->osd_peering_wq_batch_size;
+      out->size() < batch;
       ) {
         if (in_use.count(*i)) {
           ++i;
@@ -9719,6 +10109,44 @@ void OSD::ShardedOpWQ::prune_pg_waiters(OSDMapRef osdmap, int whoami)
   }
 }
 
+PerfCounters *OSD::ShardedOpWQ::create_shard_logger(uint32_t i)
+{
+  PerfCountersBuilder b(osd->cct, string("osd_op_shard-") + stringify(i),
+			l_osd_shard_first, l_osd_shard_last);
+  b.add_u64_counter(l_osd_shard_ops, "ops", "Items processed");
+  b.add_time_avg(l_osd_shard_process_lat, "process_lat",
+		 "Time spent running items (sum over time is occupancy)");
+  b.add_u64(l_osd_shard_queue_len, "queue_len", "Items queued");
+  b.add_u64(l_osd_shard_pgs, "pgs", "PGs owned by this shard");
+  b.add_u64_counter(l_osd_shard_pg_lookups, "pg_lookups",
+		    "PG lookups that fell back to the global pg_map");
+  b.add_u64_avg(l_osd_shard_batch, "batch",
+		"Items run per PG lock acquisition");
+  b.add_u64_counter(l_osd_shard_cross_core, "cross_core",
+		    "Items queued from a core other than the shard's "
+		    "(osd_op_shard_affinity)");
+  PerfCounters *logger = b.create_perf_counters();
+  osd->cct->get_perfcounters_collection()->add(logger);
+  return logger;
+}
+
+void OSD::ShardedOpWQ::register_pg(PGRef pg)
+{
+  if (!osd->cct->_conf->get_val<bool>("osd_op_shard_own_pgs") ||
+      pg->is_deleting()) {
+    return;
+  }
+  spg_t pgid = pg->get_pgid();
+  uint32_t shard_index = pgid.hash_to_shard(shard_list.size());
+  auto sdata = shard_list[shard_index];
+  Mutex::Locker l(sdata->sdata_op_ordering_lock);
+  auto& slot = sdata->pg_slots[pgid];
+  if (!slot.pg) {
+    dout(20) << __func__ << " " << pgid << " pg " << pg << dendl;
+    sdata->_set_slot_pg(slot, pg);
+  }
+}
+
 void OSD::ShardedOpWQ::clear_pg_pointer(spg_t pgid)
 {
   uint32_t shard_index = pgid.hash_to_shard(shard_list.size());
@@ -9729,7 +10157,7 @@ void OSD::ShardedOpWQ::clear_pg_pointer(spg_t pgid)
     auto& slot = p->second;
     dout(20) << __func__ << " " << pgid << " pg " << slot.pg << dendl;
     assert(!slot.pg || slot.pg->is_deleting());
-    slot.pg = nullptr;
+    sdata->_set_slot_pg(slot, nullptr);
   }
 }
 
@@ -9738,6 +10166,8 @@ void OSD::ShardedOpWQ::clear_pg_slots()
   for (auto sdata : shard_list) {
     Mutex::Locker l(sdata->sdata_op_ordering_lock);
     sdata->pg_slots.clear();
+    sdata->num_pgs = 0;
+    sdata->logger->set(l_osd_shard_pgs, 0);
     sdata->waiting_for_pg_osdmap.reset();
     // don't bother with reserved pushes; we are shutting down
   }
@@ -9751,6 +10181,21 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   uint32_t shard_index = thread_index % num_shards;
   auto& sdata = shard_list[shard_index];
   assert(sdata);
+#ifdef HAVE_SCHED
+  if (sdata->cpu >= 0) {
+    // a thread always serves the same shard; pin it the first time through
+    static thread_local int pinned_cpu = -1;
+    if (pinned_cpu != sdata->cpu) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(sdata->cpu, &cpuset);
+      if (sched_setaffinity(0, sizeof(cpuset), &cpuset) < 0)
+	derr << __func__ << " failed to pin to cpu " << sdata->cpu << ": "
+	     << cpp_strerror(errno) << dendl;
+      pinned_cpu = sdata->cpu;
+    }
+  }
+#endif
   // peek at spg_t
   sdata->sdata_op_ordering_lock.Lock();
   if (sdata->pqueue->empty()) {
@@ -9776,6 +10221,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
     }
   }
   OpQueueItem item = sdata->pqueue->dequeue();
+  sdata->logger->set(l_osd_shard_queue_len, sdata->pqueue->length());
   if (osd->is_stopping()) {
     sdata->sdata_op_ordering_lock.Unlock();
     return;    // OSD shutdown, discard.
@@ -9809,6 +10255,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   // [lookup +] lock pg (if we have it)
   if (!pg) {
+    sdata->logger->inc(l_osd_shard_pg_lookups);
     pg = osd->_lookup_lock_pg(token);
   } else {
     pg->lock();
@@ -9848,7 +10295,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   }
   if (pg && !slot.pg && !pg->is_deleting()) {
     dout(20) << __func__ << " " << token << " set pg to " << pg << dendl;
-    slot.pg = pg;
+    sdata->_set_slot_pg(slot, pg);
   }
   dout(30) << __func__ << " " << token
 	   << " to_process " << slot.to_process
@@ -9912,19 +10359,6 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   sdata->sdata_op_ordering_lock.Unlock();
 
 
-  // osd_opwq_process marks the point at which an operation has been dequeued
-  // and will begin to be handled by a worker thread.
-  {
-#ifdef WITH_LTTNG
-    osd_reqid_t reqid;
-    if (boost::optional<OpRequestRef> _op = qi.maybe_get_op()) {
-      reqid = (*_op)->get_reqid();
-    }
-#endif
-    tracepoint(osd, opwq_process_start, reqid.name._type,
-        reqid.name._num, reqid.tid, reqid.inc);
-  }
-
   lgeneric_subdout(osd->cct, osd, 30) << "dequeue status: ";
   Formatter *f = Formatter::create("json");
   f->open_object_section("q");
@@ -9936,28 +10370,105 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   ThreadPool::TPHandle tp_handle(osd->cct, hb, timeout_interval,
 				 suicide_interval);
-  qi.run(osd, pg, tp_handle);
+  utime_t batch_start = ceph_clock_now();
+  utime_t run_start = batch_start;
+  unsigned batch = 0;
+  bool store_batch = osd->cct->_conf->osd_op_batch_store;
+  while (true) {
+    // only writes from clients and primaries go through the pg's store
+    // batch; anything else may queue on the sequencer directly, so the
+    // batch so far is submitted before it runs.
+    if (store_batch && is_store_batchable(qi)) {
+      pg->begin_store_batch();
+    } else {
+      pg->flush_store_batch();
+    }
 
-  {
+    // osd_opwq_process marks the point at which an operation has been
+    // dequeued and will begin to be handled by a worker thread.
+    {
 #ifdef WITH_LTTNG
-    osd_reqid_t reqid;
-    if (boost::optional<OpRequestRef> _op = qi.maybe_get_op()) {
-      reqid = (*_op)->get_reqid();
+      osd_reqid_t reqid;
+      if (boost::optional<OpRequestRef> _op = qi.maybe_get_op()) {
+	reqid = (*_op)->get_reqid();
+      }
+#endif
+      tracepoint(osd, opwq_process_start, reqid.name._type,
+	  reqid.name._num, reqid.tid, reqid.inc);
     }
+
+    qi.run(osd, pg, tp_handle);
+    ++batch;
+    utime_t now = ceph_clock_now();
+    sdata->logger->inc(l_osd_shard_ops);
+    sdata->logger->tinc(l_osd_shard_process_lat, now - run_start);
+    run_start = now;
+
+    {
+#ifdef WITH_LTTNG
+      osd_reqid_t reqid;
+      if (boost::optional<OpRequestRef> _op = qi.maybe_get_op()) {
+	reqid = (*_op)->get_reqid();
+      }
 #endif
-    tracepoint(osd, opwq_process_finish, reqid.name._type,
-        reqid.name._num, reqid.tid, reqid.inc);
+      tracepoint(osd, opwq_process_finish, reqid.name._type,
+	  reqid.name._num, reqid.tid, reqid.inc);
+    }
+
+    // while we hold the pg lock, also run whatever other threads have
+    // already queued for this pg behind us; they will find the slot
+    // empty once they get the lock.  bounded so other pgs in the
+    // shard are not starved.
+    if (batch >= osd->cct->_conf->osd_op_batch_max ||
+	(double)(now - batch_start) >= osd->cct->_conf->osd_op_batch_max_time) {
+      break;
+    }
+    Mutex::Locker l(sdata->sdata_op_ordering_lock);
+    auto q = sdata->pg_slots.find(token);
+    if (q == sdata->pg_slots.end() ||
+	q->second.to_process.empty() ||
+	q->second.waiting_for_pg ||
+	q->second.requeue_seq != requeue_seq ||
+	q->second.pg != pg) {
+      break;
+    }
+    qi = std::move(q->second.to_process.front());
+    q->second.to_process.pop_front();
+    dout(20) << __func__ << " " << qi << " pg " << pg << " (batched)" << dendl;
+    tp_handle.reset_tp_timeout();
   }
+  sdata->logger->inc(l_osd_shard_batch, batch);
 
+  pg->flush_store_batch();
   pg->unlock();
 }
 
+bool OSD::ShardedOpWQ::is_store_batchable(const OpQueueItem& qi)
+{
+  boost::optional<OpRequestRef> op = qi.maybe_get_op();
+  if (!op) {
+    return false;
+  }
+  switch ((*op)->get_req()->get_type()) {
+  case CEPH_MSG_OSD_OP:
+  case MSG_OSD_REPOP:
+  case MSG_OSD_EC_WRITE:
+    return true;
+  default:
+    return false;
+  }
+}
+
 void OSD::ShardedOpWQ::_enqueue(OpQueueItem&& item) {
   uint32_t shard_index =
     item.get_ordering_token().hash_to_shard(shard_list.size());
 
   ShardData* sdata = shard_list[shard_index];
   assert (NULL != sdata);
+#ifdef HAVE_SCHED
+  if (sdata->cpu >= 0 && sched_getcpu() != sdata->cpu)
+    sdata->logger->inc(l_osd_shard_cross_core);
+#endif
   unsigned priority = item.get_priority();
   unsigned cost = item.get_cost();
   sdata->sdata_op_ordering_lock.Lock();
@@ -9969,6 +10480,7 @@ void OSD::ShardedOpWQ::_enqueue(OpQueueItem&& item) {
   else
     sdata->pqueue->enqueue(
       item.get_owner(), priority, cost, std::move(item));
+  sdata->logger->set(l_osd_shard_queue_len, sdata->pqueue->length());
   sdata->sdata_op_ordering_lock.Unlock();
 
   sdata->sdata_lock.Lock();
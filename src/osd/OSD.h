@@ -129,6 +129,7 @@ enum {
   l_osd_pg_stray,
   l_osd_pg_removing,
   l_osd_hb_to,
+  l_osd_hb_rtt,
   l_osd_map,
   l_osd_mape,
   l_osd_mape_dup,
@@ -141,6 +142,8 @@ enum {
   l_osd_map_cache_miss_low_avg,
   l_osd_map_bl_cache_hit,
   l_osd_map_bl_cache_miss,
+  l_osd_map_inc_shared,
+  l_osd_map_bytes,
 
   l_osd_stat_bytes,
   l_osd_stat_bytes_used,
@@ -148,6 +151,13 @@ enum {
 
   l_osd_copyfrom,
 
+  l_osd_ec_write_full,
+  l_osd_ec_write_rmw,
+  l_osd_ec_write_rmw_read_bytes,
+  l_osd_ec_read_hedged,
+  l_osd_ec_read_hedge_won,
+  l_osd_ec_read_slow_shard_skip,
+
   l_osd_tier_promote,
   l_osd_tier_flush,
   l_osd_tier_flush_fail,
@@ -178,6 +188,19 @@ enum {
   l_osd_pg_fastinfo,
   l_osd_pg_biginfo,
 
+  l_osd_boot_load_pgs,
+  l_osd_boot_up,
+
+  l_osd_snap_trim_objects,
+  l_osd_snap_trim_snaps,
+  l_osd_snap_trim_lat,
+
+  l_osd_notify,
+  l_osd_notify_watchers,
+  l_osd_notify_timeout,
+  l_osd_notify_lat,
+  l_osd_notify_lat_watchers_hist,
+
   l_osd_last,
 };
 
@@ -218,6 +241,19 @@ enum {
   rs_last,
 };
 
+// ShardedOpWQ per-shard perf counters
+enum {
+  l_osd_shard_first = 21000,
+  l_osd_shard_ops,        ///< items processed
+  l_osd_shard_process_lat, ///< time spent running items (occupancy)
+  l_osd_shard_queue_len,  ///< items queued
+  l_osd_shard_pgs,        ///< pgs owned by the shard
+  l_osd_shard_pg_lookups, ///< lookups in the global pg_map
+  l_osd_shard_batch,      ///< items run per pg lock acquisition
+  l_osd_shard_cross_core, ///< items queued from a core other than the shard's
+  l_osd_shard_last,
+};
+
 class Messenger;
 class Message;
 class MonClient;
@@ -858,6 +894,10 @@ public:
   Mutex scrub_sleep_lock;
   SafeTimer scrub_sleep_timer;
 
+  // -- hedged EC reads --
+  Mutex read_hedge_lock;
+  SafeTimer read_hedge_timer;
+
   AsyncReserver<spg_t> snap_reserver;
   void queue_for_snap_trim(PG *pg);
   void queue_for_scrub(PG *pg, bool with_high_priority);
@@ -1194,6 +1234,9 @@ protected:
   bool store_is_rotational = true;
   bool journal_is_rotational = true;
 
+  utime_t init_stamp;       ///< when init() started
+  utime_t load_pgs_time;    ///< how long load_pgs() took
+
   ZTracer::Endpoint trace_endpoint;
   void create_logger();
   void create_recoverystate_perf();
@@ -1437,6 +1480,22 @@ private:
     utime_t last_rx_front;  ///< last time we got a ping reply on the front side
     utime_t last_rx_back;   ///< last time we got a ping reply on the back side
     epoch_t epoch;      ///< most recent epoch we wanted this peer
+    utime_t last_rtt_front;  ///< most recent ping round trip (front)
+    utime_t last_rtt_back;   ///< most recent ping round trip (back)
+    utime_t rtt_sum;         ///< sum of measured round trips
+    utime_t rtt_max;         ///< worst measured round trip
+    uint64_t rtt_count = 0;  ///< number of measured round trips
+
+    void note_rtt(utime_t rtt, bool front) {
+      if (front)
+	last_rtt_front = rtt;
+      else
+	last_rtt_back = rtt;
+      rtt_sum += rtt;
+      if (rtt > rtt_max)
+	rtt_max = rtt;
+      ++rtt_count;
+    }
 
     bool is_unhealthy(utime_t cutoff) const {
       return
@@ -1473,6 +1532,8 @@ private:
   
   void _add_heartbeat_peer(int p);
   void _remove_heartbeat_peer(int p);
+  void _subsample_heartbeat_peers(set<int> *peers, unsigned max);
+  void dump_heartbeat_peers(Formatter *f);
   bool heartbeat_reset(Connection *con);
   void maybe_update_heartbeat_peers();
   void reset_heartbeat_peers();
@@ -1555,6 +1616,8 @@ private:
   // -- op tracking --
   OpTracker op_tracker;
   void check_ops_in_flight();
+  bool memory_pressure = false;  ///< mempools above osd_memory_target
+  void check_memory_target();
   void test_ops(std::string command, std::string args, ostream& ss);
   friend class TestOpsSocketHook;
   TestOpsSocketHook *test_ops_hook;
@@ -1603,6 +1666,10 @@ private:
       Mutex sdata_lock;
       Cond sdata_cond;
 
+      PerfCounters *logger = nullptr;
+
+      int cpu = -1;  ///< core this shard's threads are pinned to, if any
+
       Mutex sdata_op_ordering_lock;   ///< protects all members below
 
       OSDMapRef waiting_for_pg_osdmap;
@@ -1625,6 +1692,19 @@ private:
       /// pg lock.  slots are removed only by prune_pg_waiters.
       unordered_map<spg_t,pg_slot> pg_slots;
 
+      /// number of pg_slots with a pg attached
+      unsigned num_pgs = 0;
+
+      void _set_slot_pg(pg_slot& slot, PGRef pg) {
+	if (!slot.pg && pg) {
+	  ++num_pgs;
+	} else if (slot.pg && !pg) {
+	  --num_pgs;
+	}
+	slot.pg = pg;
+	logger->set(l_osd_shard_pgs, num_pgs);
+      }
+
       /// priority queue
       std::unique_ptr<OpQueue<OpQueueItem, uint64_t>> pqueue;
 
@@ -1689,12 +1769,19 @@ private:
 	  lock_name, order_lock,
 	  osd->cct->_conf->osd_op_pq_max_tokens_per_priority, 
 	  osd->cct->_conf->osd_op_pq_min_cost, osd->cct, osd->op_queue);
+	one_shard->logger = create_shard_logger(i);
+	one_shard->cpu = osd->get_op_shard_cpu(i);
 	shard_list.push_back(one_shard);
       }
     }
+
+    PerfCounters *create_shard_logger(uint32_t i);
     ~ShardedOpWQ() override {
       while (!shard_list.empty()) {
-	delete shard_list.back();
+	auto sdata = shard_list.back();
+	osd->cct->get_perfcounters_collection()->remove(sdata->logger);
+	delete sdata->logger;
+	delete sdata;
 	shard_list.pop_back();
       }
     }
@@ -1705,6 +1792,9 @@ private:
     /// prune ops (and possibly pg_slots) for pgs that shouldn't be here
     void prune_pg_waiters(OSDMapRef osdmap, int whoami);
 
+    /// attach a new/loaded pg to its shard so ops skip the pg_map lookup
+    void register_pg(PGRef pg);
+
     /// clear cached PGRef on pg deletion
     void clear_pg_pointer(spg_t pgid);
 
@@ -1714,6 +1804,9 @@ private:
     /// try to do some work
     void _process(uint32_t thread_index, heartbeat_handle_d *hb) override;
 
+    /// may qi's store transactions be deferred to the pg's store batch?
+    static bool is_store_batchable(const OpQueueItem& qi);
+
     /// enqueue a new item
     void _enqueue(OpQueueItem&& item) override;
 
@@ -2002,6 +2095,7 @@ protected:
   // this must be called with pg->lock held on any pg addition to pg_map
   void wake_pg_waiters(PGRef pg) {
     assert(pg->is_locked());
+    op_shardedwq.register_pg(pg);
     op_shardedwq.wake_pg_waiters(pg->get_pgid());
   }
   epoch_t last_pg_create_epoch;
@@ -2176,6 +2270,10 @@ protected:
   void handle_command(class MMonCommand *m);
   void handle_command(class MCommand *m);
   void do_command(Connection *con, ceph_tid_t tid, vector<string>& cmd, bufferlist& data);
+  /// write **count** bytes in **bsize** blocks, return the seconds it took
+  double run_bench(int64_t count, int64_t bsize, int64_t osize, int64_t onum);
+  /// fill in the mclock device capacities left at 0, see options.cc
+  void calibrate_mclock_capacity();
 
   // -- pg recovery --
   void do_recovery(PG *pg, epoch_t epoch_queued, uint64_t pushes_reserved,
@@ -2357,6 +2455,7 @@ private:
   int init_op_flags(OpRequestRef& op);
 
   int get_num_op_shards();
+  int get_op_shard_cpu(unsigned shard);
   int get_num_op_threads();
 
   float get_osd_recovery_sleep();
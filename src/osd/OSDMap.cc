@@ -1418,10 +1418,14 @@ void OSDMap::dedup(const OSDMap *o, OSDMap *n)
 
   int diff = 0;
 
-  // do addrs match?
+  // do addrs match?  if n still shares them with some other map,
+  // leave them alone; rewriting the entries would modify that map too.
+  bool addrs_shared = n->osd_addrs.use_count() > 1;
   if (o->max_osd != n->max_osd)
     diff++;
-  for (int i = 0; i < o->max_osd && i < n->max_osd; i++) {
+  for (int i = 0;
+       !addrs_shared && i < o->max_osd && i < n->max_osd;
+       i++) {
     if ( n->osd_addrs->client_addr[i] &&  o->osd_addrs->client_addr[i] &&
 	*n->osd_addrs->client_addr[i] == *o->osd_addrs->client_addr[i])
       n->osd_addrs->client_addr[i] = o->osd_addrs->client_addr[i];
@@ -1443,31 +1447,36 @@ void OSDMap::dedup(const OSDMap *o, OSDMap *n)
     else
       diff++;
   }
-  if (diff == 0) {
+  if (!addrs_shared && diff == 0) {
     // zoinks, no differences at all!
     n->osd_addrs = o->osd_addrs;
   }
 
   // does crush match?
-  bufferlist oc, nc;
-  ::encode(*o->crush, oc, CEPH_FEATURES_SUPPORTED_DEFAULT);
-  ::encode(*n->crush, nc, CEPH_FEATURES_SUPPORTED_DEFAULT);
-  if (oc.contents_equal(nc)) {
-    n->crush = o->crush;
+  if (n->crush != o->crush) {
+    bufferlist oc, nc;
+    ::encode(*o->crush, oc, CEPH_FEATURES_SUPPORTED_DEFAULT);
+    ::encode(*n->crush, nc, CEPH_FEATURES_SUPPORTED_DEFAULT);
+    if (oc.contents_equal(nc)) {
+      n->crush = o->crush;
+    }
   }
 
   // does pg_temp match?
-  if (*o->pg_temp == *n->pg_temp)
+  if (n->pg_temp != o->pg_temp &&
+      *o->pg_temp == *n->pg_temp)
     n->pg_temp = o->pg_temp;
 
   // does primary_temp match?
-  if (o->primary_temp->size() == n->primary_temp->size()) {
+  if (n->primary_temp != o->primary_temp &&
+      o->primary_temp->size() == n->primary_temp->size()) {
     if (*o->primary_temp == *n->primary_temp)
       n->primary_temp = o->primary_temp;
   }
 
   // do uuids match?
-  if (o->osd_uuid->size() == n->osd_uuid->size() &&
+  if (n->osd_uuid != o->osd_uuid &&
+      o->osd_uuid->size() == n->osd_uuid->size() &&
       *o->osd_uuid == *n->osd_uuid)
     n->osd_uuid = o->osd_uuid;
 }
@@ -1544,6 +1553,52 @@ void OSDMap::clean_temps(CephContext *cct,
   }
 }
 
+namespace {
+// clone a piece that another map still references before modifying it
+template<typename T>
+void unshare(ceph::shared_ptr<T>& p)
+{
+  if (p && p.use_count() > 1)
+    p.reset(new T(*p));
+}
+
+// replace a shared piece that is about to be overwritten entirely
+template<typename T>
+void unshare_empty(ceph::shared_ptr<T>& p)
+{
+  if (p && p.use_count() > 1)
+    p.reset(new T);
+}
+} // anonymous namespace
+
+void OSDMap::_unshare_for_decode()
+{
+  unshare_empty(osd_addrs);
+  unshare_empty(pg_temp);
+  unshare_empty(primary_temp);
+  unshare_empty(osd_uuid);
+  unshare_empty(crush);
+  // osd_primary_affinity is always reallocated or reset by decode
+}
+
+void OSDMap::_unshare_for_incremental(const Incremental& inc)
+{
+  // only clone what this incremental touches; everything else stays
+  // shared with the map we were copied from.
+  bool osds = inc.new_max_osd >= 0 || !inc.new_state.empty();
+  if (osds || !inc.new_up_client.empty() || !inc.new_up_cluster.empty())
+    unshare(osd_addrs);
+  if (osds || !inc.new_uuid.empty())
+    unshare(osd_uuid);
+  if (osds || !inc.new_primary_affinity.empty())
+    unshare(osd_primary_affinity);
+  if (!inc.new_pg_temp.empty())
+    unshare(pg_temp);
+  if (!inc.new_primary_temp.empty())
+    unshare(primary_temp);
+  // crush is replaced, never modified, by apply_incremental
+}
+
 int OSDMap::apply_incremental(const Incremental &inc)
 {
   new_blacklist_entries = false;
@@ -1554,6 +1609,8 @@ int OSDMap::apply_incremental(const Incremental &inc)
   
   assert(inc.epoch == epoch+1);
 
+  if (mapping_cache.cache)
+    mapping_cache.cache.reset(new mapping_cache_t);
   epoch++;
   modified = inc.modified;
 
@@ -1565,6 +1622,8 @@ int OSDMap::apply_incremental(const Incremental &inc)
   }
 
   // nope, incremental.
+  _unshare_for_incremental(inc);
+
   if (inc.new_flags >= 0) {
     flags = inc.new_flags;
     // the below is just to cover a newly-upgraded luminous mon
@@ -1858,10 +1917,70 @@ void OSDMap::_remove_nonexistent_osds(const pg_pool_t& pool,
   }
 }
 
+template<typename V>
+static bool names_any_osd(const V& v, const set<int>& osds)
+{
+  for (auto o : v) {
+    if (osds.count(o))
+      return true;
+  }
+  return false;
+}
+
+void OSDMap::get_pools_mapping_to(const set<int>& osds,
+				  set<int64_t> *pools) const
+{
+  for (auto& p : get_pools()) {
+    const pg_pool_t& pool = p.second;
+    int ruleno = crush->find_rule(pool.get_crush_rule(), pool.get_type(),
+				  pool.get_size());
+    if (ruleno < 0)
+      continue;
+    bool any_take = false;
+    bool reaches = false;
+    int len = crush->get_rule_len(ruleno);
+    for (int step = 0; step < len && !reaches; ++step) {
+      if (crush->get_rule_op(ruleno, step) != CRUSH_RULE_TAKE)
+	continue;
+      any_take = true;
+      int root = crush->get_rule_arg1(ruleno, step);
+      for (auto o : osds) {
+	if (crush->subtree_contains(root, o)) {
+	  reaches = true;
+	  break;
+	}
+      }
+    }
+    if (reaches || !any_take)
+      pools->insert(p.first);
+  }
+  for (const auto pg : *pg_temp) {
+    if (names_any_osd(pg.second, osds))
+      pools->insert(pg.first.pool());
+  }
+  for (auto& pg : *primary_temp) {
+    if (osds.count(pg.second))
+      pools->insert(pg.first.pool());
+  }
+  for (auto& pg : pg_upmap) {
+    if (names_any_osd(pg.second, osds))
+      pools->insert(pg.first.pool());
+  }
+  for (auto& pg : pg_upmap_items) {
+    for (auto& q : pg.second) {
+      if (osds.count(q.first) || osds.count(q.second)) {
+	pools->insert(pg.first.pool());
+	break;
+      }
+    }
+  }
+}
+
 void OSDMap::_pg_to_raw_osds(
   const pg_pool_t& pool, pg_t pg,
   vector<int> *osds,
-  ps_t *ppps) const
+  ps_t *ppps,
+  void *crush_work) const
 {
   // map to osds[]
   ps_t pps = pool.raw_pg_to_pps(pg);  // placement ps
@@ -1869,8 +1988,13 @@ void OSDMap::_pg_to_raw_osds(
 
   // what crush rule?
   int ruleno = crush->find_rule(pool.get_crush_rule(), pool.get_type(), size);
-  if (ruleno >= 0)
-    crush->do_rule(ruleno, pps, *osds, size, osd_weight, pg.pool());
+  if (ruleno >= 0) {
+    if (crush_work)
+      crush->do_rule(ruleno, pps, *osds, size, osd_weight, pg.pool(),
+		     crush_work);
+    else
+      crush->do_rule(ruleno, pps, *osds, size, osd_weight, pg.pool());
+  }
 
   _remove_nonexistent_osds(pool, *osds);
 
@@ -2079,7 +2203,8 @@ void OSDMap::pg_to_raw_up(pg_t pg, vector<int> *up, int *primary) const
 void OSDMap::_pg_to_up_acting_osds(
   const pg_t& pg, vector<int> *up, int *up_primary,
   vector<int> *acting, int *acting_primary,
-  bool raw_pg_to_pg) const
+  bool raw_pg_to_pg,
+  void *crush_work) const
 {
   const pg_pool_t *pool = get_pg_pool(pg.pool());
   if (!pool ||
@@ -2094,15 +2219,33 @@ void OSDMap::_pg_to_up_acting_osds(
       *acting_primary = -1;
     return;
   }
+  mapping_cache_t::shard_t *cache_shard = nullptr;
+  if (mapping_cache.cache) {
+    cache_shard = &mapping_cache.cache->get_shard(pg);
+    std::lock_guard<std::mutex> l(cache_shard->lock);
+    auto p = cache_shard->entries.find(pg);
+    if (p != cache_shard->entries.end()) {
+      if (up)
+	*up = p->second.up;
+      if (up_primary)
+	*up_primary = p->second.up_primary;
+      if (acting)
+	*acting = p->second.acting;
+      if (acting_primary)
+	*acting_primary = p->second.acting_primary;
+      return;
+    }
+  }
   vector<int> raw;
   vector<int> _up;
   vector<int> _acting;
-  int _up_primary;
+  int _up_primary = -1;
   int _acting_primary;
   ps_t pps;
   _get_temp_osds(*pool, pg, &_acting, &_acting_primary);
-  if (_acting.empty() || up || up_primary) {
-    _pg_to_raw_osds(*pool, pg, &raw, &pps);
+  // compute the whole mapping when we are going to remember it
+  if (_acting.empty() || up || up_primary || cache_shard) {
+    _pg_to_raw_osds(*pool, pg, &raw, &pps, crush_work);
     _apply_upmap(*pool, pg, &raw);
     _raw_to_up_osds(*pool, raw, &_up);
     _up_primary = _pick_primary(_up);
@@ -2113,6 +2256,16 @@ void OSDMap::_pg_to_up_acting_osds(
         _acting_primary = _up_primary;
       }
     }
+    if (cache_shard) {
+      std::lock_guard<std::mutex> l(cache_shard->lock);
+      if (cache_shard->entries.size() < mapping_cache_t::max_shard_entries) {
+	auto& e = cache_shard->entries[pg];
+	e.up = _up;
+	e.up_primary = _up_primary;
+	e.acting = _acting;
+	e.acting_primary = _acting_primary;
+      }
+    }
   
     if (up)
       up->swap(_up);
@@ -2551,6 +2704,10 @@ void OSDMap::decode_classic(bufferlist::iterator& p)
 
 void OSDMap::decode(bufferlist::iterator& bl)
 {
+  _unshare_for_decode();
+  if (mapping_cache.cache)
+    mapping_cache.cache.reset(new mapping_cache_t);
+
   /**
    * Older encodings of the OSDMap had a single struct_v which
    * covered the whole encoding, and was prior to our modern
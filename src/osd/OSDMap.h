@@ -33,6 +33,7 @@
 #include <list>
 #include <set>
 #include <map>
+#include <mutex>
 #include "include/memory.h"
 #include "include/btree_map.h"
 using namespace std;
@@ -407,6 +408,17 @@ public:
     int get_net_marked_down(const OSDMap *previous) const;
     int identify_osd(uuid_d u) const;
 
+    /// true if applying this may change the result of OSDMap::check_health()
+    bool may_change_health() const {
+      return fullmap.length() || crush.length() ||
+	new_flags >= 0 || new_max_osd >= 0 ||
+	new_require_osd_release >= 0 || new_require_min_compat_client >= 0 ||
+	!new_pools.empty() || !new_pool_names.empty() || !old_pools.empty() ||
+	!new_up_client.empty() || !new_state.empty() || !new_weight.empty() ||
+	new_nearfull_ratio >= 0 || new_backfillfull_ratio >= 0 ||
+	new_full_ratio >= 0;
+    }
+
     void encode_client_old(bufferlist& bl) const;
     void encode_classic(bufferlist& bl, uint64_t features) const;
     void encode(bufferlist& bl, uint64_t features=CEPH_FEATURES_ALL) const;
@@ -555,6 +567,41 @@ private:
 
   friend class OSDMonitor;
 
+  /**
+   * memoized _pg_to_up_acting_osds results, filled lazily as pgs are
+   * looked up.  Only maps that will not be modified again (see
+   * enable_mapping_cache()) carry one; sharded by pg so lookups of
+   * different pgs from different threads do not contend.
+   */
+  struct mapping_cache_t {
+    struct entry_t {
+      vector<int> up, acting;
+      int up_primary, acting_primary;
+    };
+    struct shard_t {
+      std::mutex lock;
+      mempool::osdmap_mapping::unordered_map<pg_t,entry_t> entries;
+    };
+    static const unsigned num_shards = 16;
+    static const size_t max_shard_entries = 4096;
+    shard_t shards[num_shards];
+
+    shard_t& get_shard(const pg_t& pg) {
+      return shards[std::hash<pg_t>()(pg) % num_shards];
+    }
+  };
+  /// owner of the cache; copies of the map start without one
+  struct mapping_cache_ref_t {
+    std::unique_ptr<mapping_cache_t> cache;
+    mapping_cache_ref_t() {}
+    mapping_cache_ref_t(const mapping_cache_ref_t&) {}
+    mapping_cache_ref_t& operator=(const mapping_cache_ref_t&) {
+      cache.reset();
+      return *this;
+    }
+  };
+  mutable mapping_cache_ref_t mapping_cache;
+
  public:
   OSDMap() : epoch(0), 
 	     pool_max(0),
@@ -579,6 +626,17 @@ private:
   OSDMap& operator=(const OSDMap& other) = default;
 public:
 
+  /**
+   * remember the up/acting mapping of each pg as it is looked up.  Call
+   * this only on a map that is not going to change any more (e.g. once
+   * it has been decoded into the osd map cache); decode() and
+   * apply_incremental() drop whatever was remembered.
+   */
+  void enable_mapping_cache() {
+    if (!mapping_cache.cache)
+      mapping_cache.cache.reset(new mapping_cache_t);
+  }
+
   void deepish_copy_from(const OSDMap& o) {
     *this = o;
     primary_temp.reset(new mempool::osdmap::map<pg_t,int32_t>(*o.primary_temp));
@@ -595,6 +653,19 @@ public:
     // allocate a new CrushWrapper, though.
   }
 
+  /**
+   * copy o, sharing all of the refcounted pieces (addrs, pg_temp,
+   * primary_temp, primary affinity, uuids, crush) with it.
+   *
+   * apply_incremental() and decode() clone a shared piece before they
+   * modify it, so maps built this way share whatever did not change
+   * between epochs.  o must not be modified afterwards by anything
+   * other than those two methods.
+   */
+  void cow_copy_from(const OSDMap& o) {
+    *this = o;
+  }
+
   // map info
   const uuid_d& get_fsid() const { return fsid; }
   void set_fsid(uuid_d& f) { fsid = f; }
@@ -966,6 +1037,14 @@ public:
   /// try to re-use/reference addrs in oldmap from newmap
   static void dedup(const OSDMap *oldmap, OSDMap *newmap);
 
+  /**
+   * Find the pools whose pg mappings can change when only the per-osd
+   * state (weight, up/down, existence, primary affinity) of the given
+   * osds changes: those whose crush rule can reach one of them, or
+   * with a pg_temp, primary_temp or upmap entry naming one of them.
+   */
+  void get_pools_mapping_to(const set<int>& osds, set<int64_t> *pools) const;
+
   static void clean_temps(CephContext *cct, const OSDMap& osdmap,
 			  Incremental *pending_inc);
 
@@ -975,6 +1054,8 @@ private:
   void encode_classic(bufferlist& bl, uint64_t features) const;
   void decode_classic(bufferlist::iterator& p);
   void post_decode();
+  void _unshare_for_decode();
+  void _unshare_for_incremental(const Incremental& inc);
 public:
   void encode(bufferlist& bl, uint64_t features=CEPH_FEATURES_ALL) const;
   void decode(bufferlist& bl);
@@ -1046,7 +1127,8 @@ private:
   void _pg_to_raw_osds(
     const pg_pool_t& pool, pg_t pg,
     vector<int> *osds,
-    ps_t *ppps) const;
+    ps_t *ppps,
+    void *crush_work = nullptr) const;
   int _pick_primary(const vector<int>& osds) const;
   void _remove_nonexistent_osds(const pg_pool_t& pool, vector<int>& osds) const;
 
@@ -1075,7 +1157,8 @@ private:
    */
   void _pg_to_up_acting_osds(const pg_t& pg, vector<int> *up, int *up_primary,
                              vector<int> *acting, int *acting_primary,
-			     bool raw_pg_to_pg = true) const;
+			     bool raw_pg_to_pg = true,
+			     void *crush_work = nullptr) const;
 
 public:
   /***
@@ -1109,6 +1192,17 @@ public:
                             vector<int> *acting, int *acting_primary) const {
     _pg_to_up_acting_osds(pg, up, up_primary, acting, acting_primary);
   }
+  /**
+   * As above, reusing a crush workspace prepared with
+   * crush->init_work() for at least the pool size; see
+   * CrushWrapper::work_size().
+   */
+  void pg_to_up_acting_osds(pg_t pg, vector<int> *up, int *up_primary,
+                            vector<int> *acting, int *acting_primary,
+			    void *crush_work) const {
+    _pg_to_up_acting_osds(pg, up, up_primary, acting, acting_primary, true,
+			  crush_work);
+  }
   void pg_to_up_acting_osds(pg_t pg, vector<int>& up, vector<int>& acting) const {
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
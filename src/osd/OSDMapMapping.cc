@@ -56,6 +56,50 @@ void OSDMapMapping::update(const OSDMap& osdmap, pg_t pgid)
   _update_range(osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
 }
 
+bool OSDMapMapping::update(const OSDMap& osdmap,
+			   const OSDMap::Incremental& inc)
+{
+  if (epoch == 0 ||
+      inc.epoch != osdmap.get_epoch() ||
+      epoch + 1 != osdmap.get_epoch()) {
+    return false;
+  }
+  if (inc.fullmap.length() ||
+      inc.crush.length() ||
+      inc.new_max_osd >= 0 ||
+      !inc.new_pools.empty() ||
+      !inc.old_pools.empty() ||
+      !inc.new_pg_temp.empty() ||
+      !inc.new_primary_temp.empty() ||
+      !inc.new_pg_upmap.empty() ||
+      !inc.new_pg_upmap_items.empty() ||
+      !inc.old_pg_upmap.empty() ||
+      !inc.old_pg_upmap_items.empty()) {
+    return false;
+  }
+
+  set<int> osds;
+  for (auto& p : inc.new_state)
+    osds.insert(p.first);
+  for (auto& p : inc.new_up_client)
+    osds.insert(p.first);
+  for (auto& p : inc.new_weight)
+    osds.insert(p.first);
+  for (auto& p : inc.new_primary_affinity)
+    osds.insert(p.first);
+
+  set<int64_t> affected;
+  if (!osds.empty())
+    osdmap.get_pools_mapping_to(osds, &affected);
+  for (auto pool : affected) {
+    auto i = pools.find(pool);
+    assert(i != pools.end());
+    _update_range(osdmap, pool, 0, i->second.pg_num);
+  }
+  _finish(osdmap);
+  return true;
+}
+
 void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
 {
   acting_rmap.resize(osdmap.get_max_osd());
@@ -111,12 +155,17 @@ void OSDMapMapping::_update_range(
   assert(i != pools.end());
   assert(pg_begin <= pg_end);
   assert(pg_end <= i->second.pg_num);
+  // set up one crush workspace for the whole range instead of per pg
+  const pg_pool_t *pi = osdmap.get_pg_pool(pool);
+  assert(pi);
+  vector<char> work(osdmap.crush->work_size(pi->get_size()));
+  osdmap.crush->init_work(work.data());
   for (unsigned ps = pg_begin; ps < pg_end; ++ps) {
     vector<int> up, acting;
     int up_primary, acting_primary;
     osdmap.pg_to_up_acting_osds(
       pg_t(ps, pool),
-      &up, &up_primary, &acting, &acting_primary);
+      &up, &up_primary, &acting, &acting_primary, work.data());
     i->second.set(ps, std::move(up), up_primary,
 		  std::move(acting), acting_primary);
   }
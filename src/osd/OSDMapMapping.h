@@ -9,10 +9,9 @@
 #include <map>
 
 #include "osd/osd_types.h"
+#include "osd/OSDMap.h"
 #include "common/WorkQueue.h"
 
-class OSDMap;
-
 /// work queue to perform work on batches of pgids on multiple CPUs
 class ParallelPGMapper {
 public:
@@ -303,6 +302,16 @@ public:
   void update(const OSDMap& map);
   void update(const OSDMap& map, pg_t pgid);
 
+  /**
+   * Bring a complete mapping of the previous epoch up to date with
+   * map, which is that epoch with inc applied, recomputing only the
+   * pools inc can affect.  Only incrementals that change nothing but
+   * per-osd state qualify; for anything else (or if we do not hold
+   * the previous epoch) change nothing and return false, and the
+   * caller should do a full update.
+   */
+  bool update(const OSDMap& map, const OSDMap::Incremental& inc);
+
   std::unique_ptr<MappingJob> start_update(
     const OSDMap& map,
     ParallelPGMapper& mapper,
@@ -31,6 +31,7 @@
  * to it, which it puts() when destroyed.
  */
 struct OpRequest : public TrackedOp {
+  MEMPOOL_CLASS_HELPERS();
   friend class OpTracker;
 
   // rmw flags
@@ -356,6 +356,20 @@ void PG::lock(bool no_lockdep) const
   dout(30) << "lock" << dendl;
 }
 
+void PG::flush_store_batch()
+{
+  store_batch = false;
+  if (store_batch_tls.empty())
+    return;
+  dout(20) << __func__ << " " << store_batch_tls.size() << " transactions"
+	   << dendl;
+  int r = osd->store->queue_transactions(osr.get(), store_batch_tls, 0, 0, 0,
+					 store_batch_op, NULL);
+  assert(r == 0);
+  store_batch_tls.clear();
+  store_batch_op.reset();
+}
+
 std::string PG::gen_prefix() const
 {
   stringstream out;
@@ -2119,8 +2133,34 @@ unsigned PG::get_recovery_priority()
   if (state & PG_STATE_FORCED_RECOVERY) {
     ret = OSD_RECOVERY_PRIORITY_FORCED;
   } else {
-    pool.info.opts.get(pool_opts_t::RECOVERY_PRIORITY, &ret);
-    ret = clamp_recovery_priority(OSD_RECOVERY_PRIORITY_BASE + ret);
+    if (acting.size() < pool.info.min_size) {
+      // inactive: no. of replicas < min_size, highest priority since it blocks IO
+      ret = OSD_RECOVERY_INACTIVE_PRIORITY_BASE +
+	(pool.info.min_size - acting.size());
+    } else {
+      // degraded: OSD_RECOVERY_PRIORITY_BASE + num shards missing objects,
+      // so pgs with the fewest complete copies recover first
+      unsigned complete = 0;
+      for (auto& shard : actingset) {
+	if (shard == pg_whoami) {
+	  if (!pg_log.get_missing().have_missing())
+	    ++complete;
+	  continue;
+	}
+	auto p = peer_missing.find(shard);
+	if (p != peer_missing.end() && !p->second.have_missing())
+	  ++complete;
+      }
+      ret = OSD_RECOVERY_PRIORITY_BASE;
+      if (pool.info.size > complete)
+	ret += pool.info.size - complete;
+    }
+
+    // Adjust with pool's recovery priority
+    int pool_recovery_priority = 0;
+    pool.info.opts.get(pool_opts_t::RECOVERY_PRIORITY, &pool_recovery_priority);
+
+    ret = clamp_recovery_priority(pool_recovery_priority + ret);
   }
   dout(20) << __func__ << " recovery priority for " << *this << " is " << ret << ", state is " << state << dendl;
   return static_cast<unsigned>(ret);
@@ -4425,6 +4465,138 @@ void PG::scrub(epoch_t queued, ThreadPool::TPHandle &handle)
  * scrubber.state encodes the current state of the scrub (refer to state diagram
  * for details).
  */
+bool PG::scrub_pick_chunk(const hobject_t& start, hobject_t *end)
+{
+  /* get the start and end of our scrub chunk
+   *
+   * Our scrub chunk has an important restriction we're going to need to
+   * respect. We can't let head be start or end.
+   * Using a half-open interval means that if end == head,
+   * we'd scrub/lock head and the clone right next to head in different
+   * chunks which would allow us to miss clones created between
+   * scrubbing that chunk and scrubbing the chunk including head.
+   * This isn't true for any of the other clones since clones can
+   * only be created "just to the left of" head.  There is one exception
+   * to this: promotion of clones which always happens to the left of the
+   * left-most clone, but promote_object checks the scrubber in that
+   * case, so it should be ok.  Also, it's ok to "miss" clones at the
+   * left end of the range if we are a tier because they may legitimately
+   * not exist (see _scrub).
+   */
+  int min = MAX(3, cct->_conf->osd_scrub_chunk_min);
+  hobject_t candidate_end;
+  vector<hobject_t> objects;
+  int ret = get_pgbackend()->objects_list_partial(
+    start,
+    min,
+    MAX(min, cct->_conf->osd_scrub_chunk_max),
+    &objects,
+    &candidate_end);
+  assert(ret >= 0);
+
+  if (!objects.empty()) {
+    hobject_t back = objects.back();
+    while (candidate_end.is_head() &&
+	   candidate_end == back.get_head()) {
+      candidate_end = back;
+      objects.pop_back();
+      if (objects.empty()) {
+	assert(0 ==
+	       "Somehow we got more than 2 objects which"
+	       "have the same head but are not clones");
+      }
+      back = objects.back();
+    }
+    if (candidate_end.is_head()) {
+      assert(candidate_end != back.get_head());
+      candidate_end = candidate_end.get_object_boundary();
+    }
+  } else {
+    assert(candidate_end.is_max());
+  }
+
+  if (!_range_available_for_scrub(start, candidate_end)) {
+    // we'll be requeued by whatever made us unavailable for scrub
+    dout(10) << __func__ << ": scrub blocked somewhere in range "
+	     << "[" << start << ", " << candidate_end << ")"
+	     << dendl;
+    return false;
+  }
+  *end = candidate_end;
+  return true;
+}
+
+eversion_t PG::scrub_chunk_last_update(const hobject_t& start,
+				       const hobject_t& end)
+{
+  // walk the log to find the latest update that affects our chunk
+  for (auto p = projected_log.log.rbegin();
+       p != projected_log.log.rend();
+       ++p) {
+    if (p->soid >= start &&
+	p->soid < end) {
+      return p->version;
+    }
+  }
+  for (list<pg_log_entry_t>::const_reverse_iterator p =
+	 pg_log.get_log().log.rbegin();
+       p != pg_log.get_log().log.rend();
+       ++p) {
+    if (p->soid >= start &&
+	p->soid < end) {
+      return p->version;
+    }
+  }
+  return eversion_t();
+}
+
+void PG::scrub_request_chunk_maps(const hobject_t& start, const hobject_t& end,
+				  eversion_t last_update)
+{
+  // ask replicas to wait until
+  // last_update_applied >= last_update and then scan
+  scrubber.waiting_on_whom.insert(pg_whoami);
+  ++scrubber.waiting_on;
+
+  // request maps from replicas
+  for (set<pg_shard_t>::iterator i = actingbackfill.begin();
+       i != actingbackfill.end();
+       ++i) {
+    if (*i == pg_whoami) continue;
+    _request_scrub_map(*i, last_update,
+		       start, end, scrubber.deep,
+		       scrubber.seed);
+    scrubber.waiting_on_whom.insert(*i);
+    ++scrubber.waiting_on;
+  }
+}
+
+/*
+ * Pick the chunk after [start,end) and ask the replicas for its maps
+ * now, so that they scan it while we compare the current one.  Their
+ * replies are not processed until we drop the pg lock, by which time
+ * the current chunk's maps have been consumed.  Writes to the new
+ * chunk are blocked from here on, just as they would be in NEW_CHUNK.
+ */
+void PG::scrub_request_next_chunk()
+{
+  assert(!scrubber.next_requested);
+  assert(scrubber.waiting_on == 0);
+
+  hobject_t next_end;
+  if (!scrub_pick_chunk(scrubber.end, &next_end))
+    return;  // NEW_CHUNK will try again without the pipeline
+
+  scrubber.next_end = next_end;
+  scrubber.next_subset_last_update =
+    scrub_chunk_last_update(scrubber.end, next_end);
+  scrubber.next_requested = true;
+  dout(15) << __func__ << " [" << scrubber.end << "," << next_end << ")"
+	   << " last_update " << scrubber.next_subset_last_update << dendl;
+  scrub_request_chunk_maps(scrubber.end, next_end,
+			   scrubber.next_subset_last_update);
+}
+
 void PG::chunky_scrub(ThreadPool::TPHandle &handle)
 {
   // check for map changes
@@ -4488,106 +4660,18 @@ void PG::chunky_scrub(ThreadPool::TPHandle &handle)
         scrubber.received_maps.clear();
 
         {
-          /* get the start and end of our scrub chunk
-	   *
-	   * Our scrub chunk has an important restriction we're going to need to
-	   * respect. We can't let head be start or end.
-	   * Using a half-open interval means that if end == head,
-	   * we'd scrub/lock head and the clone right next to head in different
-	   * chunks which would allow us to miss clones created between
-	   * scrubbing that chunk and scrubbing the chunk including head.
-	   * This isn't true for any of the other clones since clones can
-	   * only be created "just to the left of" head.  There is one exception
-	   * to this: promotion of clones which always happens to the left of the
-	   * left-most clone, but promote_object checks the scrubber in that
-	   * case, so it should be ok.  Also, it's ok to "miss" clones at the
-	   * left end of the range if we are a tier because they may legitimately
-	   * not exist (see _scrub).
-	   */
-	  int min = MAX(3, cct->_conf->osd_scrub_chunk_min);
-          hobject_t start = scrubber.start;
 	  hobject_t candidate_end;
-	  vector<hobject_t> objects;
-	  ret = get_pgbackend()->objects_list_partial(
-	    start,
-	    min,
-	    MAX(min, cct->_conf->osd_scrub_chunk_max),
-	    &objects,
-	    &candidate_end);
-	  assert(ret >= 0);
-
-	  if (!objects.empty()) {
-	    hobject_t back = objects.back();
-	    while (candidate_end.is_head() &&
-		   candidate_end == back.get_head()) {
-	      candidate_end = back;
-	      objects.pop_back();
-	      if (objects.empty()) {
-		assert(0 ==
-		       "Somehow we got more than 2 objects which"
-		       "have the same head but are not clones");
-	      }
-	      back = objects.back();
-	    }
-	    if (candidate_end.is_head()) {
-	      assert(candidate_end != back.get_head());
-	      candidate_end = candidate_end.get_object_boundary();
-	    }
-	  } else {
-	    assert(candidate_end.is_max());
-	  }
-
-	  if (!_range_available_for_scrub(scrubber.start, candidate_end)) {
-	    // we'll be requeued by whatever made us unavailable for scrub
-	    dout(10) << __func__ << ": scrub blocked somewhere in range "
-		     << "[" << scrubber.start << ", " << candidate_end << ")"
-		     << dendl;
+	  if (!scrub_pick_chunk(scrubber.start, &candidate_end)) {
 	    done = true;
 	    break;
 	  }
 	  scrubber.end = candidate_end;
         }
 
-        // walk the log to find the latest update that affects our chunk
-        scrubber.subset_last_update = eversion_t();
-	for (auto p = projected_log.log.rbegin();
-	     p != projected_log.log.rend();
-	     ++p) {
-          if (p->soid >= scrubber.start &&
-	      p->soid < scrubber.end) {
-            scrubber.subset_last_update = p->version;
-            break;
-	  }
-	}
-	if (scrubber.subset_last_update == eversion_t()) {
-	  for (list<pg_log_entry_t>::const_reverse_iterator p =
-		 pg_log.get_log().log.rbegin();
-	       p != pg_log.get_log().log.rend();
-	       ++p) {
-	    if (p->soid >= scrubber.start &&
-		p->soid < scrubber.end) {
-	      scrubber.subset_last_update = p->version;
-	      break;
-	    }
-	  }
-	}
-
-        // ask replicas to wait until
-        // last_update_applied >= scrubber.subset_last_update and then scan
-        scrubber.waiting_on_whom.insert(pg_whoami);
-        ++scrubber.waiting_on;
-
-        // request maps from replicas
-	for (set<pg_shard_t>::iterator i = actingbackfill.begin();
-	     i != actingbackfill.end();
-	     ++i) {
-	  if (*i == pg_whoami) continue;
-          _request_scrub_map(*i, scrubber.subset_last_update,
-                             scrubber.start, scrubber.end, scrubber.deep,
-			     scrubber.seed);
-          scrubber.waiting_on_whom.insert(*i);
-          ++scrubber.waiting_on;
-        }
+        scrubber.subset_last_update =
+	  scrub_chunk_last_update(scrubber.start, scrubber.end);
+	scrub_request_chunk_maps(scrubber.start, scrubber.end,
+				 scrubber.subset_last_update);
 
         scrubber.state = PG::Scrubber::WAIT_PUSHES;
 
@@ -4647,8 +4731,18 @@ void PG::chunky_scrub(ThreadPool::TPHandle &handle)
         assert(last_update_applied >= scrubber.subset_last_update);
         assert(scrubber.waiting_on == 0);
 
+	// let the replicas scan the next chunk while we compare this one
+	if (cct->_conf->osd_scrub_pipeline && !scrubber.end.is_max())
+	  scrub_request_next_chunk();
+
         scrub_compare_maps();
 	scrubber.start = scrubber.end;
+	if (scrubber.next_requested) {
+	  scrubber.end = scrubber.next_end;
+	  scrubber.subset_last_update = scrubber.next_subset_last_update;
+	  scrubber.primary_scrubmap = ScrubMap();
+	  scrubber.received_maps.clear();
+	}
 	scrubber.run_callbacks();
 
         // requeue the writes from the chunk that just finished
@@ -4667,7 +4761,13 @@ void PG::chunky_scrub(ThreadPool::TPHandle &handle)
 	  break;
 	}
 
-	if (!(scrubber.end.is_max())) {
+	if (scrubber.next_requested) {
+	  // the next chunk's maps are already on their way
+	  scrubber.next_requested = false;
+	  scrubber.state = PG::Scrubber::WAIT_PUSHES;
+	  requeue_scrub();
+	  done = true;
+	} else if (!(scrubber.end.is_max())) {
           scrubber.state = PG::Scrubber::NEW_CHUNK;
 	  requeue_scrub();
           done = true;
@@ -7451,6 +7551,8 @@ boost::statechart::result PG::RecoveryState::Active::react(const QueryState& q)
     q.f->dump_stream("scrubber.start") << pg->scrubber.start;
     q.f->dump_stream("scrubber.end") << pg->scrubber.end;
     q.f->dump_stream("scrubber.subset_last_update") << pg->scrubber.subset_last_update;
+    if (pg->scrubber.next_requested)
+      q.f->dump_stream("scrubber.next_end") << pg->scrubber.next_end;
     q.f->dump_bool("scrubber.deep", pg->scrubber.deep);
     q.f->dump_unsigned("scrubber.seed", pg->scrubber.seed);
     q.f->dump_int("scrubber.waiting_on", pg->scrubber.waiting_on);
@@ -254,6 +254,23 @@ public:
   // for ordering writes
   ceph::shared_ptr<ObjectStore::Sequencer> osr;
 
+  /**
+   * While an op shard thread runs several client/replica ops for this pg
+   * back to back (see osd_op_batch_store), the transactions they queue
+   * through the PGBackend listener are collected here and submitted to
+   * the store in one queue_transactions call, so they share a single
+   * store transaction and kv commit.  Anything queued directly on osr
+   * while a batch is open must flush it first to keep the order.
+   */
+  bool store_batch = false;
+  vector<ObjectStore::Transaction> store_batch_tls;
+  OpRequestRef store_batch_op;
+
+  void begin_store_batch() {
+    store_batch = true;
+  }
+  void flush_store_batch();
+
   ObjectStore::CollectionHandle ch;
 
   // -- classes --
@@ -1514,6 +1531,12 @@ public:
     hobject_t start, end;    // [start,end)
     eversion_t subset_last_update;
 
+    // pipelined scrub: replica maps for [end,next_end) were requested
+    // before comparing [start,end)
+    bool next_requested = false;
+    hobject_t next_end;
+    eversion_t next_subset_last_update;
+
     // chunky scrub state
     enum State {
       INACTIVE,
@@ -1568,7 +1591,9 @@ public:
     // classic (non chunk) scrubs block all writes
     // chunky scrubs only block writes to a range
     bool write_blocked_by_scrub(const hobject_t &soid) {
-      return (soid >= start && soid < end);
+      if (soid >= start && soid < end)
+	return true;
+      return next_requested && soid >= end && soid < next_end;
     }
 
     // clear all state
@@ -1590,6 +1615,9 @@ public:
       start = hobject_t();
       end = hobject_t();
       subset_last_update = eversion_t();
+      next_requested = false;
+      next_end = hobject_t();
+      next_subset_last_update = eversion_t();
       shallow_errors = 0;
       deep_errors = 0;
       large_omap_objects = 0;
@@ -1621,6 +1649,12 @@ protected:
     pg_shard_t bad_peer);
 
   void chunky_scrub(ThreadPool::TPHandle &handle);
+  bool scrub_pick_chunk(const hobject_t& start, hobject_t *end);
+  eversion_t scrub_chunk_last_update(const hobject_t& start,
+				     const hobject_t& end);
+  void scrub_request_chunk_maps(const hobject_t& start, const hobject_t& end,
+				eversion_t last_update);
+  void scrub_request_next_chunk();
   void scrub_compare_maps();
   /**
    * return true if any inconsistency/missing is repaired, false otherwise
@@ -254,6 +254,9 @@ typedef ceph::shared_ptr<const OSDMap> OSDMapRef;
      virtual void schedule_recovery_work(
        GenContext<ThreadPool::TPHandle&> *c) = 0;
 
+     /// run c after delay seconds, without the pg lock held
+     virtual void schedule_read_hedge(double delay, Context *c) = 0;
+
      virtual pg_shard_t whoami_shard() const = 0;
      int whoami() const {
        return whoami_shard().osd;
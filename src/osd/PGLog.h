@@ -82,10 +82,11 @@ public:
    * plus some methods to manipulate it all.
    */
   struct IndexedLog : public pg_log_t {
-    mutable ceph::unordered_map<hobject_t,pg_log_entry_t*> objects;  // ptrs into log.  be careful!
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_entry_t*> caller_ops;
-    mutable ceph::unordered_multimap<osd_reqid_t,pg_log_entry_t*> extra_caller_ops;
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_dup_t*> dup_index;
+    // indexes live in the osd_pglog mempool along with the entries
+    mutable mempool::osd_pglog::unordered_map<hobject_t,pg_log_entry_t*> objects;  // ptrs into log.  be careful!
+    mutable mempool::osd_pglog::unordered_map<osd_reqid_t,pg_log_entry_t*> caller_ops;
+    mutable mempool::osd_pglog::unordered_multimap<osd_reqid_t,pg_log_entry_t*> extra_caller_ops;
+    mutable mempool::osd_pglog::unordered_map<osd_reqid_t,pg_log_dup_t*> dup_index;
 
     // recovery pointers
     list<pg_log_entry_t>::iterator complete_to; // not inclusive of referenced item
@@ -251,6 +252,18 @@ public:
       return objects.count(oid);
     }
 
+    /// true if oid or its head has a log entry newer than bound
+    bool has_write_since(const hobject_t &oid, const eversion_t &bound) const {
+      if (!(indexed_data & PGLOG_INDEXED_OBJECTS)) {
+         index_objects();
+      }
+      auto p = objects.find(oid);
+      if (p != objects.end() && p->second->version > bound)
+	return true;
+      p = objects.find(oid.get_head());
+      return p != objects.end() && p->second->version > bound;
+    }
+
     bool logged_req(const osd_reqid_t &r) const {
       if (!(indexed_data & PGLOG_INDEXED_CALLER_OPS)) {
         index_caller_ops();
@@ -273,7 +286,7 @@ public:
       assert(version);
       assert(user_version);
       assert(return_code);
-      ceph::unordered_map<osd_reqid_t,pg_log_entry_t*>::const_iterator p;
+      decltype(caller_ops)::const_iterator p;
       if (!(indexed_data & PGLOG_INDEXED_CALLER_OPS)) {
         index_caller_ops();
       }
@@ -352,14 +365,21 @@ public:
       // IndexedLog (and indirectly through assignment operator)
       if (!to_index) return;
 
-      if (to_index & PGLOG_INDEXED_OBJECTS)
+      // size the tables up front so a full reindex doesn't rehash
+      // repeatedly as it walks the log
+      if (to_index & PGLOG_INDEXED_OBJECTS) {
 	objects.clear();
-      if (to_index & PGLOG_INDEXED_CALLER_OPS)
+	objects.reserve(log.size());
+      }
+      if (to_index & PGLOG_INDEXED_CALLER_OPS) {
 	caller_ops.clear();
+	caller_ops.reserve(log.size());
+      }
       if (to_index & PGLOG_INDEXED_EXTRA_CALLER_OPS)
 	extra_caller_ops.clear();
       if (to_index & PGLOG_INDEXED_DUPS) {
 	dup_index.clear();
+	dup_index.reserve(dups.size());
 	for (auto& i : dups) {
 	  dup_index[i.reqid] = const_cast<pg_log_dup_t*>(&i);
 	}
@@ -418,9 +438,9 @@ public:
 
     void index(pg_log_entry_t& e) {
       if ((indexed_data & PGLOG_INDEXED_OBJECTS) && e.object_is_indexed()) {
-        if (objects.count(e.soid) == 0 ||
-            objects[e.soid]->version < e.version)
-          objects[e.soid] = &e;
+	auto r = objects.insert(make_pair(e.soid, &e));
+	if (!r.second && r.first->second->version < e.version)
+	  r.first->second = &e;
       }
       if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
 	// divergent merge_log indexes new before unindexing old
@@ -448,22 +468,23 @@ public:
     void unindex(const pg_log_entry_t& e) {
       // NOTE: this only works if we remove from the _tail_ of the log!
       if (indexed_data & PGLOG_INDEXED_OBJECTS) {
-        if (objects.count(e.soid) && objects[e.soid]->version == e.version)
-          objects.erase(e.soid);
+	auto p = objects.find(e.soid);
+	if (p != objects.end() && p->second->version == e.version)
+	  objects.erase(p);
       }
       if (e.reqid_is_indexed()) {
         if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
 	  // divergent merge_log indexes new before unindexing old
-          if (caller_ops.count(e.reqid) && caller_ops[e.reqid] == &e)
-            caller_ops.erase(e.reqid);
+	  auto p = caller_ops.find(e.reqid);
+	  if (p != caller_ops.end() && p->second == &e)
+	    caller_ops.erase(p);
         }
       }
       if (indexed_data & PGLOG_INDEXED_EXTRA_CALLER_OPS) {
         for (auto j = e.extra_reqids.begin();
              j != e.extra_reqids.end();
              ++j) {
-          for (ceph::unordered_multimap<osd_reqid_t,pg_log_entry_t*>::iterator k =
-		 extra_caller_ops.find(j->first);
+          for (auto k = extra_caller_ops.find(j->first);
                k != extra_caller_ops.end() && k->first == j->first;
                ++k) {
             if (k->second == &e) {
@@ -912,8 +933,7 @@ protected:
 		       << " last_divergent_update: " << last_divergent_update
 		       << dendl;
 
-    ceph::unordered_map<hobject_t, pg_log_entry_t*>::const_iterator objiter =
-      log.objects.find(hoid);
+    auto objiter = log.objects.find(hoid);
     if (objiter != log.objects.end() &&
 	objiter->second->version >= first_divergent_update) {
       /// Case 1)
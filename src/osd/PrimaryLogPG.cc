@@ -500,6 +500,12 @@ void PrimaryLogPG::schedule_recovery_work(
   osd->recovery_gen_wq.queue(c);
 }
 
+void PrimaryLogPG::schedule_read_hedge(double delay, Context *c)
+{
+  Mutex::Locker l(osd->read_hedge_lock);
+  osd->read_hedge_timer.add_event_after(delay, c);
+}
+
 void PrimaryLogPG::send_message_osd_cluster(
   int peer, Message *m, epoch_t from_epoch)
 {
@@ -557,6 +563,16 @@ bool PrimaryLogPG::is_missing_object(const hobject_t& soid) const
   return pg_log.get_missing().get_items().count(soid);
 }
 
+bool PrimaryLogPG::can_serve_replica_read(const hobject_t &oid) const
+{
+  assert(!is_primary());
+  // entries up to the primary's min_last_complete_ondisk are on every
+  // acting osd and cannot be rolled back; anything newer may still be
+  if (is_missing_object(oid) || is_missing_object(oid.get_head()))
+    return false;
+  return !pg_log.get_log().has_write_since(oid, replica_read_bound);
+}
+
 void PrimaryLogPG::maybe_kick_recovery(
   const hobject_t &soid)
 {
@@ -1880,6 +1896,18 @@ void PrimaryLogPG::do_op(OpRequestRef& op)
       osd->handle_misdirected_op(this, op);
       return;
     }
+    if (!is_primary()) {
+      // only a replicated pool's replica holds the whole object, and only
+      // an object with no uncommitted writes is safe to read; the client
+      // resends anything bounced with EAGAIN to the primary
+      if (!pool.info.is_replicated() || !is_active() ||
+	  !can_serve_replica_read(head)) {
+	dout(20) << __func__ << ": cannot read " << head
+		 << " on replica, bouncing to primary " << *m << dendl;
+	osd->reply_op_error(op, -EAGAIN);
+	return;
+      }
+    }
   } else {
     // normal case; must be primary
     if (!is_primary()) {
@@ -2172,6 +2200,8 @@ void PrimaryLogPG::do_op(OpRequestRef& op)
     }
     if (!op->hitset_inserted) {
       hit_set->insert(oid);
+      if (hit_sketch)
+	hit_sketch->increment(oid);
       op->hitset_inserted = true;
       if (hit_set->is_full() ||
           hit_set_start_stamp + pool.info.hit_set_period <= m->get_recv_stamp()) {
@@ -9458,6 +9488,7 @@ void PrimaryLogPG::submit_log_entries(
       }
       t.register_on_applied(
 	new C_OSD_OnApplied{this, get_osdmap()->get_epoch(), info.last_update});
+      flush_store_batch();
       int r = osd->store->queue_transaction(osr.get(), std::move(t), NULL);
       assert(r == 0);
     });
@@ -10225,6 +10256,7 @@ void PrimaryLogPG::remove_missing_object(const hobject_t &soid,
 	 on_complete->complete(-EAGAIN);
        }
      }));
+  flush_store_batch();
   int r = osd->store->queue_transaction(osr.get(), std::move(t), nullptr);
   assert(r == 0);
 }
@@ -10855,6 +10887,8 @@ void PrimaryLogPG::on_change(ObjectStore::Transaction *t)
 {
   dout(10) << "on_change" << dendl;
 
+  replica_read_bound = eversion_t();
+
   if (hit_set && hit_set->insert_count() == 0) {
     dout(20) << " discarding empty hit_set" << dendl;
     hit_set_clear();
@@ -11531,6 +11565,14 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
   dout(10) << __func__ << "(" << max << ")" << dendl;
   uint64_t started = 0;
 
+  // Small objects are pushed in one go, so let a batch of them share a
+  // recovery op slot; send_pushes then packs them into a few messages.
+  const uint64_t small_size = cct->_conf->get_val<uint64_t>(
+    "osd_recovery_batch_small_object_size");
+  const uint64_t small_batch = std::max<uint64_t>(
+    1, cct->_conf->get_val<uint64_t>("osd_recovery_batch_small_objects"));
+  uint64_t small_left = 0;  // room left in the current small object slot
+
   PGBackend::RecoveryHandle *h = pgbackend->open_recovery_op();
 
   // this is FAR from an optimal recovery order.  pretty lame, really.
@@ -11572,7 +11614,7 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
     // oldest first!
     const pg_missing_t &m(pm->second);
     for (map<version_t, hobject_t>::const_iterator p = m.get_rmissing().begin();
-	 p != m.get_rmissing().end() && started < max;
+	 p != m.get_rmissing().end() && (started < max || small_left > 0);
 	   ++p) {
       handle.reset_tp_timeout();
       const hobject_t soid(p->second);
@@ -11598,6 +11640,8 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
       }
 
       if (missing_loc.is_deleted(soid)) {
+	if (started >= max)
+	  continue;
 	dout(10) << __func__ << ": " << soid << " is a delete, removing" << dendl;
 	map<hobject_t,pg_missing_item>::const_iterator r = m.get_items().find(soid);
 	started += prep_object_replica_deletes(soid, r->second.need, h);
@@ -11615,9 +11659,28 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
 	continue;
       }
 
+      bool small = false;
+      if (small_size) {
+	ObjectContextRef obc = get_object_context(soid, false);
+	small = obc && !obc->obs.oi.is_omap() &&
+	  obc->obs.oi.size <= small_size;
+      }
+      if (!small && started >= max)
+	continue;
+
       dout(10) << __func__ << ": recover_object_replicas(" << soid << ")" << dendl;
       map<hobject_t,pg_missing_item>::const_iterator r = m.get_items().find(soid);
-      started += prep_object_replica_pushes(soid, r->second.need, h);
+      if (!prep_object_replica_pushes(soid, r->second.need, h))
+	continue;
+      if (!small) {
+	++started;
+      } else {
+	if (small_left == 0) {
+	  ++started;
+	  small_left = small_batch;
+	}
+	--small_left;
+      }
     }
   }
 
@@ -12168,6 +12231,7 @@ void PrimaryLogPG::scan_range(
   dout(10) << " got " << ls.size() << " items, next " << bi->end << dendl;
   dout(20) << ls << dendl;
 
+  const auto &log_objects = pg_log.get_log().objects;
   for (vector<hobject_t>::iterator p = ls.begin(); p != ls.end(); ++p) {
     handle.reset_tp_timeout();
     ObjectContextRef obc;
@@ -12176,22 +12240,36 @@ void PrimaryLogPG::scan_range(
     if (obc) {
       bi->objects[*p] = obc->obs.oi.version;
       dout(20) << "  " << *p << " " << obc->obs.oi.version << dendl;
-    } else {
-      bufferlist bl;
-      int r = pgbackend->objects_get_attr(*p, OI_ATTR, &bl);
+      continue;
+    }
 
-      /* If the object does not exist here, it must have been removed
-	 * between the collection_list_partial and here.  This can happen
-	 * for the first item in the range, which is usually last_backfill.
-	 */
-      if (r == -ENOENT)
+    // on the primary, an applied modify in the log carries the version
+    // the object has on disk, saving a getattr per recently written object
+    if (is_primary() && !is_missing_object(*p)) {
+      auto e = log_objects.find(*p);
+      if (e != log_objects.end() &&
+	  e->second->is_modify() &&
+	  e->second->version <= bi->version) {
+	bi->objects[*p] = e->second->version;
+	dout(20) << "  " << *p << " " << e->second->version << " (log)" << dendl;
 	continue;
-
-      assert(r >= 0);
-      object_info_t oi(bl);
-      bi->objects[*p] = oi.version;
-      dout(20) << "  " << *p << " " << oi.version << dendl;
+      }
     }
+
+    bufferlist bl;
+    int r = pgbackend->objects_get_attr(*p, OI_ATTR, &bl);
+
+    /* If the object does not exist here, it must have been removed
+     * between the collection_list_partial and here.  This can happen
+     * for the first item in the range, which is usually last_backfill.
+     */
+    if (r == -ENOENT)
+      continue;
+
+    assert(r >= 0);
+    object_info_t oi(bl);
+    bi->objects[*p] = oi.version;
+    dout(20) << "  " << *p << " " << oi.version << dendl;
   }
 }
 
@@ -12277,6 +12355,7 @@ void PrimaryLogPG::hit_set_clear()
 {
   dout(20) << __func__ << dendl;
   hit_set.reset();
+  hit_sketch.reset();
   hit_set_start_stamp = utime_t();
 }
 
@@ -12301,6 +12380,11 @@ void PrimaryLogPG::hit_set_setup()
 
   // FIXME: discard any previous data for now
   hit_set_create();
+  unsigned sketch_width = cct->_conf->get_val<uint64_t>("osd_hit_set_sketch_width");
+  if (!sketch_width)
+    hit_sketch.reset();
+  else if (!hit_sketch)
+    hit_sketch.reset(new FrequencySketch(sketch_width));
 
   // include any writes we know about from the pg log.  this doesn't
   // capture reads, but it is better than nothing!
@@ -12412,6 +12496,8 @@ bool PrimaryLogPG::hit_set_apply_log()
     ++p;
   while (p != pg_log.get_log().log.rend() && p->version > from) {
     hit_set->insert(p->soid);
+    if (hit_sketch)
+      hit_sketch->increment(p->soid);
     ++p;
   }
 
@@ -13284,6 +13370,12 @@ void PrimaryLogPG::agent_estimate_temp(const hobject_t& oid, int *temp)
   assert(hit_set);
   assert(temp);
   *temp = 0;
+  if (hit_sketch && hit_sketch->is_warm()) {
+    // the sketch ages its counts, so it already weighs recent accesses
+    // over old ones; scale it like the hit set grades
+    *temp = hit_sketch->estimate(oid) * 4000;
+    return;
+  }
   if (hit_set->contains(oid))
     *temp = 1000000;
   unsigned i = 0;
@@ -14057,6 +14149,7 @@ boost::statechart::result PrimaryLogPG::AwaitAsyncWork::react(const DoSnapWork&)
 		       << dendl;
     pg->info.purged_snaps.insert(snap_to_trim);
     pg->snap_trimq.erase(snap_to_trim);
+    pg->osd->logger->inc(l_osd_snap_trim_snaps);
     ldout(pg->cct, 10) << "purged_snaps now "
 		       << pg->info.purged_snaps << ", snap_trimq now "
 		       << pg->snap_trimq << dendl;
@@ -14100,8 +14193,11 @@ boost::statechart::result PrimaryLogPG::AwaitAsyncWork::react(const DoSnapWork&)
     }
 
     in_flight.insert(object);
+    utime_t start = ceph_clock_now();
     ctx->register_on_success(
-      [pg, object, &in_flight]() {
+      [pg, object, &in_flight, start]() {
+	pg->osd->logger->inc(l_osd_snap_trim_objects);
+	pg->osd->logger->tinc(l_osd_snap_trim_lat, ceph_clock_now() - start);
 	assert(in_flight.find(object) != in_flight.end());
 	in_flight.erase(object);
 	if (in_flight.empty()) {
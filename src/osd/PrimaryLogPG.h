@@ -22,6 +22,7 @@
 #include "PG.h"
 #include "Watch.h"
 #include "TierAgentState.h"
+#include "FrequencySketch.h"
 #include "messages/MOSDOpReply.h"
 #include "common/Checksummer.h"
 #include "common/sharedptr_registry.hpp"
@@ -294,10 +295,22 @@ public:
   }
   void queue_transaction(ObjectStore::Transaction&& t,
 			 OpRequestRef op) override {
+    if (store_batch) {
+      store_batch_tls.push_back(std::move(t));
+      store_batch_op = op;
+      return;
+    }
     osd->store->queue_transaction(osr.get(), std::move(t), 0, 0, 0, op);
   }
   void queue_transactions(vector<ObjectStore::Transaction>& tls,
 			  OpRequestRef op) override {
+    if (store_batch) {
+      for (auto& t : tls) {
+	store_batch_tls.push_back(std::move(t));
+      }
+      store_batch_op = op;
+      return;
+    }
     osd->store->queue_transactions(osr.get(), tls, 0, 0, 0, op, NULL);
   }
   epoch_t get_epoch() const override {
@@ -395,6 +408,8 @@ public:
     if (hset_history) {
       info.hit_set = *hset_history;
     }
+    if (!is_primary() && roll_forward_to > replica_read_bound)
+      replica_read_bound = roll_forward_to;
     append_log(logv, trim_to, roll_forward_to, t, transaction_applied);
   }
 
@@ -439,6 +454,7 @@ public:
 
   void schedule_recovery_work(
     GenContext<ThreadPool::TPHandle&> *c) override;
+  void schedule_read_hedge(double delay, Context *c) override;
 
   pg_shard_t whoami_shard() const override {
     return pg_whoami;
@@ -896,6 +912,7 @@ protected:
   // hot/cold tracking
   HitSetRef hit_set;        ///< currently accumulating HitSet
   utime_t hit_set_start_stamp;    ///< time the current HitSet started recording
+  std::unique_ptr<FrequencySketch> hit_sketch; ///< recency weighted access counts
 
 
   void hit_set_clear();     ///< discard any HitSet state
@@ -1743,8 +1760,12 @@ private:
   void maybe_create_new_object(OpContext *ctx, bool ignore_transaction=false);
   int _delete_oid(OpContext *ctx, bool no_whiteout, bool try_no_whiteout);
   int _rollback_to(OpContext *ctx, ceph_osd_op& op);
+  /// primary's min_last_complete_ondisk, as last seen on a replica
+  eversion_t replica_read_bound;
 public:
   bool is_missing_object(const hobject_t& oid) const;
+  /// true if this replica has a committed copy of oid to read from
+  bool can_serve_replica_read(const hobject_t &oid) const;
   bool is_unreadable_object(const hobject_t &oid) const {
     return is_missing_object(oid) ||
       !missing_loc.readable_with_acting(oid, actingset);
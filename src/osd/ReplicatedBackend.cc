@@ -954,6 +954,8 @@ Message * ReplicatedBackend::generate_subop(
   const vector<pg_log_entry_t> &log_entries,
   boost::optional<pg_hit_set_history_t> &hset_hist,
   ObjectStore::Transaction &op_t,
+  bufferlist &op_tbl,
+  bufferlist &logbl,
   pg_shard_t peer,
   const pg_info_t &pinfo)
 {
@@ -977,11 +979,16 @@ Message * ReplicatedBackend::generate_subop(
     ObjectStore::Transaction t;
     ::encode(t, wr->get_data());
   } else {
-    ::encode(op_t, wr->get_data());
+    // encode once and share the buffers with every replica's message
+    if (!op_tbl.length())
+      ::encode(op_t, op_tbl);
+    wr->set_data(op_tbl);
     wr->get_header().data_off = op_t.get_data_alignment();
   }
 
-  ::encode(log_entries, wr->logbl);
+  if (!logbl.length())
+    ::encode(log_entries, logbl);
+  wr->logbl = logbl;
 
   if (pinfo.is_incomplete())
     wr->pg_stats = pinfo.stats;  // reflects backfill progress
@@ -1022,6 +1029,7 @@ void ReplicatedBackend::issue_op(
     if (op->op)
       op->op->mark_sub_op_sent(ss.str());
   }
+  bufferlist op_tbl, logbl;
   for (set<pg_shard_t>::const_iterator i =
 	 parent->get_actingbackfill_shards().begin();
        i != parent->get_actingbackfill_shards().end();
@@ -1043,6 +1051,8 @@ void ReplicatedBackend::issue_op(
       log_entries,
       hset_hist,
       op_t,
+      op_tbl,
+      logbl,
       peer,
       pinfo);
     if (op->op)
@@ -1834,6 +1844,11 @@ void ReplicatedBackend::send_pushes(int prio, map<pg_shard_t, vector<PushOp> > &
       get_osdmap()->get_epoch());
     if (!con)
       continue;
+    // small object recovery is batched (see PrimaryLogPG::recover_replicas);
+    // let a whole batch fit in one message, subject to osd_max_push_cost
+    uint64_t max_pushes = std::max<uint64_t>(
+      cct->_conf->osd_max_push_objects,
+      cct->_conf->get_val<uint64_t>("osd_recovery_batch_small_objects"));
     vector<PushOp>::iterator j = i->second.begin();
     while (j != i->second.end()) {
       uint64_t cost = 0;
@@ -1847,13 +1862,13 @@ void ReplicatedBackend::send_pushes(int prio, map<pg_shard_t, vector<PushOp> > &
       for (;
            (j != i->second.end() &&
 	    cost < cct->_conf->osd_max_push_cost &&
-	    pushes < cct->_conf->osd_max_push_objects) ;
+	    pushes < max_pushes) ;
 	   ++j) {
 	dout(20) << __func__ << ": sending push " << *j
 		 << " to osd." << i->first << dendl;
 	cost += j->cost(cct);
 	pushes += 1;
-	msg->pushes.push_back(*j);
+	msg->pushes.push_back(std::move(*j));
       }
       msg->set_cost(cost);
       get_parent()->send_message_osd_cluster(msg, con);
@@ -387,6 +387,8 @@ private:
     const vector<pg_log_entry_t> &log_entries,
     boost::optional<pg_hit_set_history_t> &hset_history,
     ObjectStore::Transaction &op_t,
+    bufferlist &op_tbl,
+    bufferlist &logbl,
     pg_shard_t peer,
     const pg_info_t &pinfo);
   void issue_op(
@@ -51,6 +51,26 @@ int OSDriver::get_next(
   }
 }
 
+int OSDriver::get_next_keys(
+  const std::string &key,
+  unsigned max,
+  std::vector<pair<std::string, bufferlist> > *out)
+{
+  ObjectMap::ObjectMapIterator iter =
+    os->get_omap_iterator(cid, hoid);
+  if (!iter) {
+    ceph_abort();
+    return -EINVAL;
+  }
+  unsigned start = out->size();
+  for (iter->upper_bound(key);
+       iter->valid() && out->size() - start < max;
+       iter->next()) {
+    out->push_back(make_pair(iter->key(), iter->value()));
+  }
+  return out->size() == start ? -ENOENT : 0;
+}
+
 struct Mapping {
   snapid_t snap;
   hobject_t hoid;
@@ -277,28 +297,35 @@ int SnapMapper::get_next_objects_to_trim(
     string prefix(get_prefix(snap) + *i);
     string pos = prefix;
     while (out->size() < max) {
-      pair<string, bufferlist> next;
-      r = backend.get_next(pos, &next);
-      dout(20) << __func__ << " get_next(" << pos << ") returns " << r
-	       << " " << next << dendl;
+      // read the rest of the batch with a single scan of the mappings
+      vector<pair<string, bufferlist> > next;
+      r = backend.get_next_keys(pos, max - out->size(), &next);
+      dout(20) << __func__ << " get_next_keys(" << pos << ") returns " << r
+	       << " " << next.size() << " keys" << dendl;
       if (r != 0) {
 	break; // Done
       }
 
-      if (next.first.substr(0, prefix.size()) !=
-	  prefix) {
-	break; // Done with this prefix
-      }
+      bool prefix_done = false;
+      for (auto& n : next) {
+	if (n.first.substr(0, prefix.size()) != prefix) {
+	  prefix_done = true;
+	  break; // Done with this prefix
+	}
 
-      assert(is_mapping(next.first));
+	assert(is_mapping(n.first));
 
-      dout(20) << __func__ << " " << next.first << dendl;
-      pair<snapid_t, hobject_t> next_decoded(from_raw(next));
-      assert(next_decoded.first == snap);
-      assert(check(next_decoded.second));
+	dout(20) << __func__ << " " << n.first << dendl;
+	pair<snapid_t, hobject_t> next_decoded(from_raw(n));
+	assert(next_decoded.first == snap);
+	assert(check(next_decoded.second));
 
-      out->push_back(next_decoded.second);
-      pos = next.first;
+	out->push_back(next_decoded.second);
+	pos = n.first;
+      }
+      if (prefix_done) {
+	break;
+      }
     }
   }
   if (out->size() == 0) {
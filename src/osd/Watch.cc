@@ -41,6 +41,8 @@ Notify::Notify(
     complete(false),
     discarded(false),
     timed_out(false),
+    num_watchers(0),
+    start(ceph_clock_now()),
     payload(payload),
     timeout(timeout),
     cookie(cookie),
@@ -150,6 +152,7 @@ void Notify::start_watcher(WatchRef watch)
   Mutex::Locker l(lock);
   dout(10) << "start_watcher" << dendl;
   watchers.insert(watch);
+  ++num_watchers;
 }
 
 void Notify::complete_watcher(WatchRef watch, bufferlist& reply_bl)
@@ -203,6 +206,15 @@ void Notify::maybe_complete_notify()
     client->send_message(reply);
     unregister_cb();
 
+    utime_t lat = ceph_clock_now() - start;
+    osd->logger->inc(l_osd_notify);
+    osd->logger->inc(l_osd_notify_watchers, num_watchers);
+    if (timed_out)
+      osd->logger->inc(l_osd_notify_timeout);
+    osd->logger->tinc(l_osd_notify_lat, lat);
+    osd->logger->hinc(l_osd_notify_lat_watchers_hist, lat.to_nsec(),
+		      num_watchers);
+
     complete = true;
   }
 }
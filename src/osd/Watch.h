@@ -57,6 +57,8 @@ class Notify {
   bool discarded;
   bool timed_out;  ///< true if the notify timed out
   set<WatchRef> watchers;
+  unsigned num_watchers; ///< watchers the notify was sent to
+  utime_t start;         ///< for notify latency stats
 
   bufferlist payload;
   uint32_t timeout;
@@ -78,7 +78,9 @@ namespace ceph {
 					 unsigned cost,
 					 Request&& item) {
     auto qos_params = item.get_qos_params();
-    queue.enqueue_distributed(get_inner_client(cl, item), priority, cost,
+    InnerClient inner = get_inner_client(cl, item);
+    double addl_cost = client_info_mgr.get_addl_cost(inner.second, cost);
+    queue.enqueue_distributed(inner, priority, addl_cost,
 			      std::move(item), qos_params);
   }
 
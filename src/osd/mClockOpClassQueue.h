@@ -92,10 +92,11 @@ namespace ceph {
 			unsigned priority,
 			unsigned cost,
 			Request&& item) override final {
-      queue.enqueue(client_info_mgr.osd_op_type(item),
-		    priority,
-		    cost,
-		    std::move(item));
+      osd_op_type_t type = client_info_mgr.osd_op_type(item);
+      queue.enqueue_addl_cost(type,
+			      priority,
+			      client_info_mgr.get_addl_cost(type, cost),
+			      std::move(item));
     }
 
     // Enqueue the op in the front of the regular queue
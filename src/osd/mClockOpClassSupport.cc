@@ -24,6 +24,7 @@ namespace ceph {
   namespace mclock {
 
     OpClassClientInfoMgr::OpClassClientInfoMgr(CephContext *cct) :
+      cct(cct),
       client_op(cct->_conf->osd_op_queue_mclock_client_op_res,
 		cct->_conf->osd_op_queue_mclock_client_op_wgt,
 		cct->_conf->osd_op_queue_mclock_client_op_lim),
@@ -38,7 +39,8 @@ namespace ceph {
 	    cct->_conf->osd_op_queue_mclock_recov_lim),
       scrub(cct->_conf->osd_op_queue_mclock_scrub_res,
 	    cct->_conf->osd_op_queue_mclock_scrub_wgt,
-	    cct->_conf->osd_op_queue_mclock_scrub_lim)
+	    cct->_conf->osd_op_queue_mclock_scrub_lim),
+      bytes_per_io(0.0)
     {
       constexpr int rep_ops[] = {
 	MSG_OSD_REPOP,
@@ -66,6 +68,40 @@ namespace ceph {
       lgeneric_subdout(cct, osd, 30) <<
 	"mClock OpClass message bit set:: " <<
 	rep_op_msg_bitset.to_string() << dendl;
+
+      update_bytes_per_io();
+      cct->_conf->add_observer(this);
+    }
+
+    OpClassClientInfoMgr::~OpClassClientInfoMgr() {
+      cct->_conf->remove_observer(this);
+    }
+
+    const char** OpClassClientInfoMgr::get_tracked_conf_keys() const {
+      static const char* KEYS[] = {
+	"osd_op_queue_mclock_iops_capacity",
+	"osd_op_queue_mclock_bandwidth_capacity",
+	NULL
+      };
+      return KEYS;
+    }
+
+    void OpClassClientInfoMgr::handle_conf_change(
+      const md_config_t *conf,
+      const std::set<std::string> &changed) {
+      update_bytes_per_io();
+    }
+
+    void OpClassClientInfoMgr::update_bytes_per_io() {
+      double iops =
+	cct->_conf->get_val<double>("osd_op_queue_mclock_iops_capacity");
+      uint64_t bw =
+	cct->_conf->get_val<uint64_t>("osd_op_queue_mclock_bandwidth_capacity");
+      double b = (iops > 0.0 && bw > 0) ? bw / iops : 0.0;
+      bytes_per_io.store(b, std::memory_order_relaxed);
+
+      lgeneric_subdout(cct, osd, 10) <<
+	"mClock OpClass bytes per io: " << b << dendl;
     }
 
     void OpClassClientInfoMgr::add_rep_op_msg(int message_code) {
@@ -15,8 +15,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <bitset>
 
+#include "common/config_obs.h"
 #include "dmclock/src/dmclock_server.h"
 #include "osd/OpRequest.h"
 #include "osd/OpQueueItem.h"
@@ -31,7 +33,9 @@ namespace ceph {
       client_op, osd_rep_op, bg_snaptrim, bg_recovery, bg_scrub
     };
 
-    class OpClassClientInfoMgr {
+    class OpClassClientInfoMgr : public md_config_obs_t {
+      CephContext *cct;
+
       crimson::dmclock::ClientInfo client_op;
       crimson::dmclock::ClientInfo osd_rep_op;
       crimson::dmclock::ClientInfo snaptrim;
@@ -42,9 +46,19 @@ namespace ceph {
       std::bitset<rep_op_msg_bitset_size> rep_op_msg_bitset;
       void add_rep_op_msg(int message_code);
 
+      // bytes of op cost that hold the device as long as one small
+      // io; 0 leaves the cost out of the tags
+      std::atomic<double> bytes_per_io;
+      void update_bytes_per_io();
+
     public:
 
       OpClassClientInfoMgr(CephContext *cct);
+      ~OpClassClientInfoMgr() override;
+
+      const char** get_tracked_conf_keys() const override;
+      void handle_conf_change(const md_config_t *conf,
+			      const std::set<std::string> &changed) override;
 
       inline const crimson::dmclock::ClientInfo*
       get_client_info(osd_op_type_t type) {
@@ -65,6 +79,18 @@ namespace ceph {
 	}
       }
 
+      // the op cost is in bytes, while the reservation tag is in
+      // seconds: an op of cost bytes takes as long as cost /
+      // bytes_per_io small ios more than a small io, so its next
+      // reservation comes that many reservation periods later
+      inline double get_addl_cost(osd_op_type_t type, unsigned cost) {
+	double b = bytes_per_io.load(std::memory_order_relaxed);
+	if (b <= 0.0) {
+	  return 0.0;
+	}
+	return cost / b * get_client_info(type)->reservation_inv;
+      }
+
       // converts operation type from op queue internal to mclock
       // equivalent
       inline static osd_op_type_t convert_op_type(op_item_type_t t) {
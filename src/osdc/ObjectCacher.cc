@@ -1027,9 +1027,11 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
   SnapContext snapc;
   vector<pair<loff_t, uint64_t> > ranges;
   vector<pair<uint64_t, bufferlist> > io_vec;
+  vector<ceph_tid_t> journal_tids;
 
   ranges.reserve(blist.size());
   io_vec.reserve(blist.size());
+  journal_tids.reserve(blist.size());
 
   uint64_t total_len = 0;
   for (list<BufferHead*>::iterator p = blist.begin(); p != blist.end(); ++p) {
@@ -1043,6 +1045,7 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
     io_vec.resize(n + 1);
     io_vec[n].first = bh->start();
     io_vec[n].second = bh->bl;
+    journal_tids.push_back(bh->journal_tid);
 
     total_len += bh->length();
     if (bh->snapc.seq > snapc.seq)
@@ -1054,7 +1057,8 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
   C_WriteCommit *oncommit = new C_WriteCommit(this, ob->oloc.pool, ob->get_soid(), ranges);
 
   ceph_tid_t tid = writeback_handler.write(ob->get_oid(), ob->get_oloc(),
-					   io_vec, snapc, last_write,
+					   io_vec, journal_tids, snapc,
+					   last_write,
 					   ob->truncate_size, ob->truncate_seq,
 					   oncommit);
   oncommit->tid = tid;
@@ -1219,7 +1223,8 @@ void ObjectCacher::bh_write_commit(int64_t poolid, sobject_t oid,
     finish_contexts(cct, ls, r);
 }
 
-void ObjectCacher::flush(ZTracer::Trace *trace, loff_t amount)
+void ObjectCacher::flush(ZTracer::Trace *trace, loff_t amount,
+			 int *max_count)
 {
   assert(trace != nullptr);
   assert(lock.is_locked());
@@ -1234,17 +1239,19 @@ void ObjectCacher::flush(ZTracer::Trace *trace, loff_t amount)
    * lru_dirty.lru_get_next_expire() again.
    */
   int64_t left = amount;
-  while (amount == 0 || left > 0) {
+  while ((amount == 0 || left > 0) && (!max_count || *max_count > 0)) {
     BufferHead *bh = static_cast<BufferHead*>(
       bh_lru_dirty.lru_get_next_expire());
     if (!bh) break;
     if (bh->last_write > cutoff) break;
 
     if (scattered_write) {
-      bh_write_adjacencies(bh, cutoff, amount > 0 ? &left : NULL, NULL);
+      bh_write_adjacencies(bh, cutoff, amount > 0 ? &left : NULL, max_count);
     } else {
       left -= bh->length();
       bh_write(bh, *trace);
+      if (max_count)
+	--*max_count;
     }
   }
 }
@@ -1900,7 +1907,15 @@ void ObjectCacher::flusher_entry()
       ldout(cct, 10) << "flusher " << get_stat_dirty() << " dirty + "
 		     << get_stat_dirty_waiting() << " dirty_waiting > target "
 		     << target_dirty << ", flushing some dirty bhs" << dendl;
-      flush(&trace, actual - target_dirty);
+      int max = MAX_FLUSH_UNDER_LOCK;
+      flush(&trace, actual - target_dirty, &max);
+      if (max <= 0) {
+	// back off the lock to avoid starving other threads
+	trace.event("backoff");
+	lock.Unlock();
+	lock.Lock();
+	continue;
+      }
     } else {
       // check tail of lru for old dirty items
       ceph::real_time cutoff = ceph::real_clock::now();
@@ -1919,7 +1934,7 @@ void ObjectCacher::flusher_entry()
 	  --max;
 	}
       }
-      if (!max) {
+      if (max <= 0) {
 	// back off the lock to avoid starving other threads
         trace.event("backoff");
 	lock.Unlock();
@@ -143,6 +143,17 @@ enum {
   l_osdc_osdop_omap_rd,
   l_osdc_osdop_omap_del,
 
+  l_osdc_pg_mapping_hit,
+  l_osdc_pg_mapping_miss,
+
+  l_osdc_op_window_held,
+  l_osdc_op_window_shrink,
+
+  l_osdc_op_submit_lat,
+  l_osdc_op_osd_lat,
+  l_osdc_op_submit_lat_hist,
+  l_osdc_op_osd_lat_hist,
+
   l_osdc_last,
 };
 
@@ -152,6 +163,7 @@ enum {
 static const char *config_keys[] = {
   "crush_location",
   "objecter_mclock_service_tracker",
+  "osdc_blkin_trace_sample_rate",
   NULL
 };
 
@@ -226,6 +238,10 @@ void Objecter::handle_conf_change(const struct md_config_t *conf,
   if (changed.count("objecter_mclock_service_tracker")) {
     update_mclock_service_tracker();
   }
+  if (changed.count("osdc_blkin_trace_sample_rate")) {
+    trace_sample_rate = cct->_conf->get_val<uint64_t>(
+      "osdc_blkin_trace_sample_rate");
+  }
 }
 
 void Objecter::update_crush_location()
@@ -380,6 +396,44 @@ void Objecter::init()
     pcb.add_u64_counter(l_osdc_osdop_omap_del, "omap_del",
 			"OSD OMAP delete operations");
 
+    pcb.add_u64_counter(l_osdc_pg_mapping_hit, "pg_mapping_hit",
+			"PG mappings served from the per-epoch cache");
+    pcb.add_u64_counter(l_osdc_pg_mapping_miss, "pg_mapping_miss",
+			"PG mappings computed with CRUSH");
+
+    pcb.add_u64_counter(l_osdc_op_window_held, "op_window_held",
+			"Operations held back by a full per-OSD window");
+    pcb.add_u64_counter(l_osdc_op_window_shrink, "op_window_shrink",
+			"Per-OSD window reductions on latency or backoff");
+
+    // latency in nsec on a log2 scale of 100usec units, op data in bytes
+    PerfHistogramCommon::axis_config_d lat_hist_x_axis_config{
+      "Latency (usec)",
+      PerfHistogramCommon::SCALE_LOG2,
+      0,
+      100000,
+      32,
+    };
+    PerfHistogramCommon::axis_config_d lat_hist_y_axis_config{
+      "Request size (bytes)",
+      PerfHistogramCommon::SCALE_LOG2,
+      0,
+      512,
+      32,
+    };
+    pcb.add_time_avg(l_osdc_op_submit_lat, "op_submit_latency",
+		     "Time from submission until last sent to an OSD");
+    pcb.add_time_avg(l_osdc_op_osd_lat, "op_osd_latency",
+		     "Time from last send until the OSD's reply (network and OSD)");
+    pcb.add_u64_counter_histogram(
+      l_osdc_op_submit_lat_hist, "op_submit_latency_bytes_histogram",
+      lat_hist_x_axis_config, lat_hist_y_axis_config,
+      "Histogram of submission to send latency + op data");
+    pcb.add_u64_counter_histogram(
+      l_osdc_op_osd_lat_hist, "op_osd_latency_bytes_histogram",
+      lat_hist_x_axis_config, lat_hist_y_axis_config,
+      "Histogram of send to reply latency + op data");
+
     logger = pcb.create_perf_counters();
     cct->get_perfcounters_collection()->add(logger);
   }
@@ -2148,6 +2202,12 @@ void Objecter::tick()
        siter != osd_sessions.end(); ++siter) {
     OSDSession *s = siter->second;
     OSDSession::lock_guard l(s->lock);
+    // let the base latency follow workload changes, and make sure held
+    // ops do not wait on replies that will never come (e.g. cancels)
+    if (s->min_lat < s->srtt) {
+      s->min_lat += (s->srtt - s->min_lat) / 16;
+    }
+    _session_window_kick(s);
     bool found = false;
     for (map<ceph_tid_t,Op*>::iterator p = s->ops.begin();
 	p != s->ops.end();
@@ -2272,6 +2332,19 @@ void Objecter::op_submit(Op *op, ceph_tid_t *ptid, int *ctx_budget)
   _op_submit_with_budget(op, rl, ptid, ctx_budget);
 }
 
+void Objecter::op_submit_batch(const vector<Op*>& ops)
+{
+  // one rwlock acquisition for the lot; ops bound for the same osd
+  // are queued back to back and leave in as few writes as the
+  // messenger can manage
+  shunique_lock rl(rwlock, ceph::acquire_shared);
+  for (auto op : ops) {
+    ceph_tid_t tid = 0;
+    op->trace.event("op submit");
+    _op_submit_with_budget(op, rl, &tid);
+  }
+}
+
 void Objecter::_op_submit_with_budget(Op *op, shunique_lock& sul,
 				      ceph_tid_t *ptid,
 				      int *ctx_budget)
@@ -2282,6 +2355,10 @@ void Objecter::_op_submit_with_budget(Op *op, shunique_lock& sul,
   assert(op->ops.size() == op->out_rval.size());
   assert(op->ops.size() == op->out_handler.size());
 
+  if (cct->_conf->objecter_op_latency_stages) {
+    op->lat.submit = ceph::mono_clock::now();
+  }
+
   // throttle.  before we look at any state, because
   // _take_op_budget() may drop our lock while it blocks.
   if (!op->ctx_budgeted || (ctx_budget && (*ctx_budget == -1))) {
@@ -2758,6 +2835,40 @@ int64_t Objecter::get_object_pg_hash_position(int64_t pool, const string& key,
   return p->raw_hash_to_pg(p->hash_key(key, ns));
 }
 
+void Objecter::_pg_to_up_acting_osds(const pg_pool_t *pi, pg_t pgid,
+				     vector<int> *up, int *up_primary,
+				     vector<int> *acting, int *acting_primary)
+{
+  // rwlock is locked
+  if (!pg_mapping_cache_enabled) {
+    osdmap->pg_to_up_acting_osds(pgid, up, up_primary, acting, acting_primary);
+    return;
+  }
+
+  // object hashes give nearly unique raw pgids; key on the actual pg
+  pg_t pg = pi->raw_pg_to_pg(pgid);
+  pg_mapping_shard_t& shard =
+    pg_mapping_cache[std::hash<pg_t>()(pg) % PG_MAPPING_SHARDS];
+  std::lock_guard<std::mutex> l(shard.lock);
+  if (shard.epoch != osdmap->get_epoch()) {
+    shard.pgs.clear();
+    shard.epoch = osdmap->get_epoch();
+  }
+  auto p = shard.pgs.find(pg);
+  if (p == shard.pgs.end()) {
+    logger->inc(l_osdc_pg_mapping_miss);
+    p = shard.pgs.emplace(pg, pg_mapping_t()).first;
+    osdmap->pg_to_up_acting_osds(pg, &p->second.up, &p->second.up_primary,
+				 &p->second.acting, &p->second.acting_primary);
+  } else {
+    logger->inc(l_osdc_pg_mapping_hit);
+  }
+  *up = p->second.up;
+  *up_primary = p->second.up_primary;
+  *acting = p->second.acting;
+  *acting_primary = p->second.acting_primary;
+}
+
 int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
 {
   // rwlock is locked
@@ -2830,8 +2941,8 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
   unsigned pg_num = pi->get_pg_num();
   int up_primary, acting_primary;
   vector<int> up, acting;
-  osdmap->pg_to_up_acting_osds(pgid, &up, &up_primary,
-			       &acting, &acting_primary);
+  _pg_to_up_acting_osds(pi, pgid, &up, &up_primary,
+			&acting, &acting_primary);
   bool sort_bitwise = osdmap->test_flag(CEPH_OSDMAP_SORTBITWISE);
   bool recovery_deletes = osdmap->test_flag(CEPH_OSDMAP_RECOVERY_DELETES);
   unsigned prev_seed = ceph_stable_mod(pgid.ps(), t->pg_num, t->pg_num_mask);
@@ -2899,7 +3010,8 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
       t->osd = -1;
     } else {
       int osd;
-      bool read = is_read && !is_write;
+      // only a replicated pool's replicas can serve reads
+      bool read = is_read && !is_write && pi->is_replicated();
       if (read && (t->flags & CEPH_OSD_FLAG_BALANCE_READS)) {
 	int p = rand() % acting.size();
 	if (p)
@@ -2925,11 +3037,11 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
 	      (best_locality < 0 && locality >= 0)) {
 	    best = i;
 	    best_locality = locality;
-	    if (i)
-	      t->used_replica = true;
 	  }
 	}
 	assert(best >= 0);
+	if (best)
+	  t->used_replica = true;
 	osd = acting[best];
       } else {
 	osd = acting_primary;
@@ -2978,6 +3090,10 @@ void Objecter::_session_op_remove(OSDSession *from, Op *op)
   if (from->is_homeless()) {
     num_homeless_ops--;
   }
+  if (op->window_counted) {
+    --from->window_inflight;
+    op->window_counted = false;
+  }
 
   from->ops.erase(op->tid);
   put_session(from);
@@ -2986,6 +3102,81 @@ void Objecter::_session_op_remove(OSDSession *from, Op *op)
   ldout(cct, 15) << __func__ << " " << from->osd << " " << op->tid << dendl;
 }
 
+bool Objecter::_session_window_full(OSDSession *s)
+{
+  // s->lock is locked unique
+  if (s->window == 0) {
+    s->window = std::max<uint64_t>(
+      1, cct->_conf->objecter_adaptive_window_max);
+  }
+  // once anything is held, later ops queue behind it so that ops to
+  // the same object are still sent in order
+  return !s->window_held.empty() || s->window_inflight >= s->window;
+}
+
+void Objecter::_session_window_update(OSDSession *s, ceph::timespan lat,
+				      bool congested)
+{
+  // s->lock is locked unique
+  double wmin = std::max<uint64_t>(1, cct->_conf->objecter_adaptive_window_min);
+  double wmax = std::max<double>(wmin,
+				 cct->_conf->objecter_adaptive_window_max);
+  if (s->window == 0) {
+    s->window = wmax;
+  }
+  if (lat > ceph::timespan::zero()) {
+    if (s->srtt == ceph::timespan::zero()) {
+      s->srtt = lat;
+    } else {
+      s->srtt = (s->srtt * 7 + lat) / 8;
+    }
+    if (s->min_lat == ceph::timespan::zero() || lat < s->min_lat) {
+      s->min_lat = lat;
+    }
+    if (s->srtt.count() > s->min_lat.count() *
+	cct->_conf->objecter_adaptive_window_latency_ratio) {
+      congested = true;
+    }
+  }
+  if (congested) {
+    // at most one decrease per round trip
+    auto now = ceph::mono_clock::now();
+    if (now - s->last_decrease >= s->srtt) {
+      s->window = std::max(wmin, s->window * 0.75);
+      s->last_decrease = now;
+      logger->inc(l_osdc_op_window_shrink);
+      ldout(cct, 10) << __func__ << " osd." << s->osd << " srtt " << s->srtt
+		     << " min_lat " << s->min_lat << ", window now "
+		     << s->window << dendl;
+    }
+  } else {
+    s->window = std::min(wmax, s->window + 1.0 / s->window);
+  }
+}
+
+void Objecter::_session_window_kick(OSDSession *s)
+{
+  // rwlock is locked
+  // s->lock is locked unique
+  bool enabled = cct->_conf->objecter_adaptive_window;
+  while (!s->window_held.empty() &&
+	 (!enabled || s->window_inflight < s->window)) {
+    ceph_tid_t tid = s->window_held.front();
+    s->window_held.pop_front();
+    auto p = s->ops.find(tid);
+    if (p == s->ops.end() || p->second->window_counted) {
+      // completed, cancelled, retargeted or already resent
+      continue;
+    }
+    Op *op = p->second;
+    ldout(cct, 15) << __func__ << " osd." << s->osd << " sending " << op
+		   << " tid " << tid << dendl;
+    ++s->window_inflight;
+    op->window_counted = true;
+    _send_op(op);
+  }
+}
+
 void Objecter::_session_linger_op_assign(OSDSession *to, LingerOp *op)
 {
   // to lock is locked unique
@@ -3115,7 +3306,9 @@ void Objecter::_finish_op(Op *op, int r)
 
   logger->dec(l_osdc_op_active);
 
-  assert(check_latest_map_ops.find(op->tid) == check_latest_map_ops.end());
+  // check_latest_map_ops is guarded by rwlock, which the reply path
+  // does not hold, so it can't be asserted on here; ops parked there
+  // are homeless and never complete through a reply.
 
   inflight_ops--;
 
@@ -3169,8 +3362,12 @@ MOSDOp *Objecter::_prepare_osd_op(Op *op)
   m->set_mtime(op->mtime);
   m->set_retry_attempt(op->attempts++);
 
-  if (!op->trace.valid() && cct->_conf->osdc_blkin_trace_all) {
-    op->trace.init("op", &trace_endpoint);
+  if (!op->trace.valid()) {
+    uint64_t sample_rate = trace_sample_rate;
+    if (cct->_conf->osdc_blkin_trace_all ||
+	(sample_rate && ++trace_sample_count % sample_rate == 0)) {
+      op->trace.init("op", &trace_endpoint);
+    }
   }
 
   if (op->priority)
@@ -3222,6 +3419,29 @@ void Objecter::_send_op(Op *op, MOSDOp *m)
     }
   }
 
+  if (!op->window_counted && !op->session->is_homeless() &&
+      cct->_conf->objecter_adaptive_window) {
+    OSDSession *s = op->session;
+    if (_session_window_full(s)) {
+      ldout(cct, 15) << __func__ << " osd." << s->osd << " window "
+		     << s->window_inflight << "/" << s->window
+		     << ", holding " << op << " tid " << op->tid << dendl;
+      s->window_held.push_back(op->tid);
+      logger->inc(l_osdc_op_window_held);
+      if (m) {
+	m->put();
+      }
+      return;
+    }
+    ++s->window_inflight;
+    op->window_counted = true;
+  }
+  if (op->window_counted || op->lat.is_set()) {
+    auto now = ceph::mono_clock::now();
+    op->window_sent = now;
+    op->lat.sent = now;
+  }
+
   if (!m) {
     assert(op->tid > 0);
     m = _prepare_osd_op(op);
@@ -3333,7 +3553,11 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   // get pio
   ceph_tid_t tid = m->get_tid();
 
-  shunique_lock sul(rwlock, ceph::acquire_shared);
+  // A reply only touches the session it arrived on, so it is handled
+  // under that session's lock without rwlock; rwlock is taken only if
+  // the op has to be resubmitted (see _op_resubmit).  shutdown() and
+  // close_session() empty s->ops under s->lock before anything we use
+  // here goes away.
   if (!initialized) {
     m->put();
     return;
@@ -3341,16 +3565,20 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
 
   ConnectionRef con = m->get_connection();
   OSDSession *s = static_cast<OSDSession*>(con->get_priv());
-  if (!s || s->con != con) {
+  if (!s) {
     ldout(cct, 7) << __func__ << " no session on con " << con << dendl;
-    if (s) {
-      s->put();
-    }
     m->put();
     return;
   }
 
   OSDSession::unique_lock sl(s->lock);
+  if (s->con != con) {
+    ldout(cct, 7) << __func__ << " no session on con " << con << dendl;
+    sl.unlock();
+    s->put();
+    m->put();
+    return;
+  }
 
   map<ceph_tid_t, Op *>::iterator iter = s->ops.find(tid);
   if (iter == s->ops.end()) {
@@ -3384,7 +3612,7 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     sl.unlock();
     s->put();
 
-    _op_submit(op, sul, NULL);
+    _op_resubmit(op);
     m->put();
     return;
   }
@@ -3425,7 +3653,7 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     m->get_redirect().combine_with_locator(op->target.target_oloc,
 					   op->target.target_oid.name);
     op->target.flags |= CEPH_OSD_FLAG_REDIRECTED;
-    _op_submit(op, sul, NULL);
+    _op_resubmit(op);
     m->put();
     return;
   }
@@ -3434,6 +3662,10 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     ldout(cct, 7) << " got -EAGAIN, resubmitting" << dendl;
     if (op->onfinish)
       num_in_flight--;
+    if (op->window_counted) {
+      _session_window_update(s, ceph::mono_clock::now() - op->window_sent,
+			     true);
+    }
     _session_op_remove(s, op);
     sl.unlock();
     s->put();
@@ -3442,13 +3674,11 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     op->target.flags &= ~(CEPH_OSD_FLAG_BALANCE_READS |
 			  CEPH_OSD_FLAG_LOCALIZE_READS);
     op->target.pgid = pg_t();
-    _op_submit(op, sul, NULL);
+    _op_resubmit(op);
     m->put();
     return;
   }
 
-  sul.unlock();
-
   if (op->objver)
     *op->objver = m->get_user_version();
   if (op->reply_epoch)
@@ -3506,6 +3736,9 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     op->onfinish = NULL;
   }
   logger->inc(l_osdc_op_reply);
+  if (op->lat.is_set()) {
+    _account_op_latency(op, m);
+  }
 
   /* get it before we call _finish_op() */
   auto completion_lock = s->get_lock(op->target.base_oid);
@@ -3513,8 +3746,13 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   if (mclock_service_tracker) {
     qos_trk->track_resp(op->target.osd, m->get_qos_resp());
   }
+  if (op->window_counted) {
+    _session_window_update(s, ceph::mono_clock::now() - op->window_sent,
+			   false);
+  }
   ldout(cct, 15) << "handle_osd_op_reply completed tid " << tid << dendl;
   _finish_op(op, 0);
+  bool kick = !s->window_held.empty();
 
   ldout(cct, 5) << num_in_flight << " in flight" << dendl;
 
@@ -3532,10 +3770,51 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     completion_lock.unlock();
   }
 
+  if (kick) {
+    // sending needs rwlock, which has to be taken before s->lock
+    shared_lock rl(rwlock);
+    if (initialized) {
+      OSDSession::unique_lock wl(s->lock);
+      _session_window_kick(s);
+    }
+  }
+
   m->put();
   s->put();
 }
 
+void Objecter::_op_resubmit(Op *op)
+{
+  // op has already been taken off its session
+  shunique_lock sul(rwlock, ceph::acquire_shared);
+  if (!initialized) {
+    // shutdown() has swept the sessions and won't see op
+    op->put();
+    return;
+  }
+  _op_submit(op, sul, NULL);
+}
+
+void Objecter::_account_op_latency(Op *op, MOSDOpReply *m)
+{
+  op->lat.reply = ceph::mono_clock::now();
+  uint64_t bytes = m->get_data_len();
+  for (auto& o : op->ops) {
+    bytes += o.indata.length();
+  }
+  auto submit_lat = op->lat.sent - op->lat.submit;
+  auto osd_lat = op->lat.reply - op->lat.sent;
+  logger->tinc(l_osdc_op_submit_lat, submit_lat);
+  logger->tinc(l_osdc_op_osd_lat, osd_lat);
+  logger->hinc(l_osdc_op_submit_lat_hist,
+	       std::chrono::nanoseconds(submit_lat).count(), bytes);
+  logger->hinc(l_osdc_op_osd_lat_hist,
+	       std::chrono::nanoseconds(osd_lat).count(), bytes);
+  if (op->latency_out) {
+    *op->latency_out = op->lat;
+  }
+}
+
 void Objecter::handle_osd_backoff(MOSDBackoff *m)
 {
   ldout(cct, 10) << __func__ << " " << *m << dendl;
@@ -3563,6 +3842,10 @@ void Objecter::handle_osd_backoff(MOSDBackoff *m)
   switch (m->op) {
   case CEPH_OSD_BACKOFF_OP_BLOCK:
     {
+      if (cct->_conf->objecter_adaptive_window) {
+	_session_window_update(s, ceph::timespan::zero(), true);
+      }
+
       // register
       OSDBackoff& b = s->backoffs[m->pgid][m->begin];
       s->backoffs_by_id.insert(make_pair(m->id, &b));
@@ -16,12 +16,14 @@
 #define CEPH_OBJECTER_H
 
 #include <condition_variable>
+#include <deque>
 #include <list>
 #include <map>
 #include <mutex>
 #include <memory>
 #include <sstream>
 #include <type_traits>
+#include <unordered_map>
 
 #include <boost/thread/shared_mutex.hpp>
 
@@ -1218,6 +1220,8 @@ private:
   std::atomic<int> client_inc{-1};
   uint64_t max_linger_id;
   std::atomic<unsigned> num_in_flight{0};
+  std::atomic<uint64_t> trace_sample_rate{0};
+  std::atomic<uint64_t> trace_sample_count{0};
   std::atomic<int> global_op_flags{0}; // flags which are applied to each IO op
   bool keep_balanced_budget;
   bool honor_osdmap_full;
@@ -1337,6 +1341,21 @@ public:
     void dump(Formatter *f) const;
   };
 
+  /**
+   * where the time of one op went (objecter_op_latency_stages): from
+   * op_submit() until it was last sent to an osd, and from then until
+   * the reply arrived.
+   */
+  struct op_latency_t {
+    ceph::mono_time submit;  ///< op_submit() called
+    ceph::mono_time sent;    ///< last handed to the messenger
+    ceph::mono_time reply;   ///< reply received
+
+    bool is_set() const {
+      return submit != ceph::mono_time();
+    }
+  };
+
   struct Op : public RefCountedObject {
     OSDSession *session;
     int incarnation;
@@ -1369,6 +1388,14 @@ public:
 
     ceph::coarse_mono_time stamp;
 
+    /// counted against the session's adaptive window, and when it was sent
+    bool window_counted = false;
+    ceph::mono_time window_sent;
+
+    /// stage timestamps, copied to *latency_out (if set) before onfinish
+    op_latency_t lat;
+    op_latency_t *latency_out = nullptr;
+
     epoch_t map_dne_bound;
 
     bool budgeted;
@@ -1837,6 +1864,14 @@ public:
     map<spg_t,map<hobject_t,OSDBackoff>> backoffs;
     map<uint64_t,OSDBackoff*> backoffs_by_id;
 
+    // adaptive window (objecter_adaptive_window)
+    unsigned window_inflight = 0;  ///< ops sent and not yet answered
+    double window = 0;             ///< current limit; 0 until first used
+    ceph::timespan srtt = ceph::timespan::zero();     ///< smoothed latency
+    ceph::timespan min_lat = ceph::timespan::zero();  ///< base latency
+    ceph::mono_time last_decrease;
+    std::deque<ceph_tid_t> window_held;  ///< ops waiting for room
+
     int osd;
     int incarnation;
     ConnectionRef con;
@@ -1893,6 +1928,26 @@ public:
 
   map<epoch_t,list< pair<Context*, int> > > waiting_for_map;
 
+  // pg -> up/acting under the current osdmap epoch, so that CRUSH is
+  // evaluated once per pg per epoch instead of once per op.
+  // _calc_target runs with rwlock shared, hence the sharded locks;
+  // each shard drops its contents when it sees a new epoch.
+  struct pg_mapping_t {
+    vector<int> up, acting;
+    int up_primary = -1, acting_primary = -1;
+  };
+  struct pg_mapping_shard_t {
+    std::mutex lock;
+    epoch_t epoch = 0;
+    std::unordered_map<pg_t, pg_mapping_t> pgs;
+  };
+  static const unsigned PG_MAPPING_SHARDS = 16;
+  bool pg_mapping_cache_enabled;
+  pg_mapping_shard_t pg_mapping_cache[PG_MAPPING_SHARDS];
+  void _pg_to_up_acting_osds(const pg_pool_t *pi, pg_t pgid,
+			     vector<int> *up, int *up_primary,
+			     vector<int> *acting, int *acting_primary);
+
   ceph::timespan mon_timeout;
   ceph::timespan osd_timeout;
 
@@ -1926,6 +1981,10 @@ public:
 
   void _session_op_assign(OSDSession *s, Op *op);
   void _session_op_remove(OSDSession *s, Op *op);
+  bool _session_window_full(OSDSession *s);
+  void _session_window_update(OSDSession *s, ceph::timespan lat,
+			      bool congested);
+  void _session_window_kick(OSDSession *s);
   void _session_linger_op_assign(OSDSession *to, LingerOp *op);
   void _session_linger_op_remove(OSDSession *from, LingerOp *op);
   void _session_command_op_assign(OSDSession *to, CommandOp *op);
@@ -2020,11 +2079,14 @@ private:
     mclock_service_tracker(cct->_conf->objecter_mclock_service_tracker),
     osdmap(new OSDMap),
     max_linger_id(0),
+    trace_sample_rate(
+      cct->_conf->get_val<uint64_t>("osdc_blkin_trace_sample_rate")),
     keep_balanced_budget(false), honor_osdmap_full(true), osdmap_full_try(false),
     blacklist_events_enabled(false),
     last_seen_osdmap_version(0), last_seen_pgmap_version(0),
     logger(NULL), tick_event(0), m_request_state_hook(NULL),
     homeless_session(new OSDSession(cct, -1)),
+    pg_mapping_cache_enabled(cct->_conf->objecter_pg_mapping_cache),
     mon_timeout(ceph::make_timespan(mon_timeout)),
     osd_timeout(ceph::make_timespan(osd_timeout)),
     op_throttle_bytes(cct, "objecter_bytes",
@@ -2115,6 +2177,7 @@ private:
   }
 
   void handle_osd_op_reply(class MOSDOpReply *m);
+  void _account_op_latency(Op *op, class MOSDOpReply *m);
   void handle_osd_backoff(class MOSDBackoff *m);
   void handle_watch_notify(class MWatchNotify *m);
   void handle_osd_map(class MOSDMap *m);
@@ -2145,6 +2208,7 @@ private:
 
   // low-level
   void _op_submit(Op *op, shunique_lock& lc, ceph_tid_t *ptid);
+  void _op_resubmit(Op *op);
   void _op_submit_with_budget(Op *op, shunique_lock& lc,
 			      ceph_tid_t *ptid,
 			      int *ctx_budget = NULL);
@@ -2153,6 +2217,7 @@ private:
   // public interface
 public:
   void op_submit(Op *op, ceph_tid_t *ptid = NULL, int *ctx_budget = NULL);
+  void op_submit_batch(const vector<Op*>& ops);
   bool is_active() {
     shared_lock l(rwlock);
     return !((!inflight_ops) && linger_ops.empty() &&
@@ -33,6 +33,40 @@ void Striper::file_to_extents(CephContext *cct, const char *object_format,
 			      vector<ObjectExtent>& extents,
 			      uint64_t buffer_offset)
 {
+  __u32 object_size = layout->object_size;
+  __u32 su = layout->stripe_unit;
+  __u32 stripe_count = layout->stripe_count;
+  if (stripe_count == 1)
+    su = object_size;
+  if (len > 0 && su > 0 && offset / su == (offset + len - 1) / su) {
+    // the whole range is inside one stripe unit, and so inside a single
+    // object extent; most small IOs take this path, which skips building
+    // the per-object map
+    uint64_t blockno = offset / su;
+    uint64_t stripeno = blockno / stripe_count;
+    uint64_t stripepos = blockno % stripe_count;
+    uint64_t stripes_per_object = object_size / su;
+    uint64_t objectsetno = stripeno / stripes_per_object;
+    uint64_t objectno = objectsetno * stripe_count + stripepos;
+
+    char buf[strlen(object_format) + 32];
+    snprintf(buf, sizeof(buf), object_format, (long long unsigned)objectno);
+
+    extents.resize(extents.size() + 1);
+    ObjectExtent *ex = &extents.back();
+    ex->oid = buf;
+    ex->objectno = objectno;
+    ex->oloc = OSDMap::file_to_object_locator(*layout);
+    ex->offset = (stripeno % stripes_per_object) * su + offset % su;
+    ex->length = len;
+    ex->truncate_size = object_truncate_size(cct, layout, objectno,
+					     trunc_size);
+    ex->buffer_extents.push_back(make_pair(buffer_offset, len));
+    ldout(cct, 15) << "file_to_extents  " << *ex << " in " << ex->oloc
+		   << dendl;
+    return;
+  }
+
   map<object_t,vector<ObjectExtent> > object_extents;
   file_to_extents(cct, object_format, layout, offset, len, trunc_size,
 		  object_extents, buffer_offset);
@@ -70,6 +104,7 @@ void Striper::file_to_extents(
   ldout(cct, 20) << " su " << su << " sc " << stripe_count << " os "
 		 << object_size << " stripes_per_object " << stripes_per_object
 		 << dendl;
+  object_locator_t oloc = OSDMap::file_to_object_locator(*layout);
 
   uint64_t cur = offset;
   uint64_t left = len;
@@ -116,7 +151,7 @@ void Striper::file_to_extents(
       ex = &exv.back();
       ex->oid = oid;
       ex->objectno = objectno;
-      ex->oloc = OSDMap::file_to_object_locator(*layout);
+      ex->oloc = oloc;
 
       ex->offset = x_offset;
       ex->length = x_len;
@@ -149,6 +184,10 @@ void Striper::assimilate_extents(
   vector<ObjectExtent>& extents)
 {
   // make final list
+  size_t n = extents.size();
+  for (auto& p : object_extents)
+    n += p.second.size();
+  extents.reserve(n);
   for (map<object_t, vector<ObjectExtent> >::iterator it
 	 = object_extents.begin();
        it != object_extents.end();
@@ -156,7 +195,7 @@ void Striper::assimilate_extents(
     for (vector<ObjectExtent>::iterator p = it->second.begin();
 	 p != it->second.end();
 	 ++p) {
-      extents.push_back(*p);
+      extents.push_back(std::move(*p));
     }
   }
 }
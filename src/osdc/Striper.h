@@ -54,6 +54,7 @@ class CephContext;
       file_to_extents(cct, buf, layout, offset, len, trunc_size, extents);
     }
 
+    /// append the extents of object_extents, moving them out of the map
     static void assimilate_extents(
       map<object_t, vector<ObjectExtent> >& object_extents,
       vector<ObjectExtent>& extents);
@@ -44,8 +44,15 @@ class WritebackHandler {
                                 ceph_tid_t new_journal_tid) {}
 
   virtual bool can_scattered_write() { return false; }
+  /**
+   * write several extents of one object as a single request
+   *
+   * @param io_vec extents to write, in offset order
+   * @param journal_tids journal tid of each extent (0 if unjournaled)
+   */
   virtual ceph_tid_t write(const object_t& oid, const object_locator_t& oloc,
 			   vector<pair<uint64_t, bufferlist> >& io_vec,
+			   const vector<ceph_tid_t>& journal_tids,
 			   const SnapContext& snapc, ceph::real_time mtime,
 			   uint64_t trunc_size, __u32 trunc_seq,
 			   Context *oncommit) {
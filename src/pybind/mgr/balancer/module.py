@@ -21,16 +21,18 @@ TIME_FORMAT = '%Y-%m-%d_%H:%M:%S'
 
 
 class MappingState:
-    def __init__(self, osdmap, pg_dump, desc=''):
+    def __init__(self, osdmap, pg_dump, desc='', pg_stat=None):
         self.desc = desc
         self.osdmap = osdmap
         self.osdmap_dump = self.osdmap.dump()
         self.crush = osdmap.get_crush()
         self.crush_dump = self.crush.dump()
         self.pg_dump = pg_dump
-        self.pg_stat = {
-            i['pgid']: i['stat_sum'] for i in pg_dump.get('pg_stats', [])
-        }
+        if pg_stat is None:
+            pg_stat = {
+                i['pgid']: i['stat_sum'] for i in pg_dump.get('pg_stats', [])
+            }
+        self.pg_stat = pg_stat
         self.poolids = [p['pool'] for p in self.osdmap_dump.get('pools', [])]
         self.pg_up = {}
         self.pg_up_by_poolid = {}
@@ -64,7 +66,8 @@ class Plan:
         self.inc.set_crush_compat_weight_set_weights(self.compat_ws)
         return MappingState(self.initial.osdmap.apply_incremental(self.inc),
                             self.initial.pg_dump,
-                            'plan %s final' % self.name)
+                            'plan %s final' % self.name,
+                            pg_stat=self.initial.pg_stat)
 
     def dump(self):
         return json.dumps(self.inc.dump(), indent=4)
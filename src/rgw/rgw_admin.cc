@@ -2168,6 +2168,20 @@ static void get_data_sync_status(const string& source_zone, list<string>& status
       if (!ceph::real_clock::is_zero(oldest)) {
         push_ss(ss, status, tab) << "oldest incremental change not applied: " << oldest;
       }
+
+      /* how far each lagging shard is behind the source */
+      ceph::real_time now = ceph::real_clock::now();
+      for (auto iter : master_pos) {
+        rgw_datalog_shard_data& shard_data = iter.second;
+        if (shard_data.entries.empty() ||
+            ceph::real_clock::is_zero(shard_data.entries.front().timestamp)) {
+          continue;
+        }
+        auto lag = std::chrono::duration_cast<std::chrono::seconds>(
+            now - shard_data.entries.front().timestamp);
+        push_ss(ss, status, tab) << "shard " << iter.first << ": lag "
+            << lag.count() << "s";
+      }
     }
   }
 
@@ -5542,7 +5556,7 @@ next:
     formatter->open_array_section("objects");
     while (is_truncated) {
       map<string, rgw_bucket_dir_entry> result;
-      int r = store->cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, 1000, true,
+      int r = store->cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, string(), 1000, true,
                                      result, &is_truncated, &marker,
                                      bucket_object_check_filter);
 
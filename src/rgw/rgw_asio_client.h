@@ -4,6 +4,7 @@
 #define RGW_ASIO_CLIENT_H
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/spawn.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include "include/assert.h"
@@ -23,6 +24,7 @@ class ClientIO : public io::RestfulClient,
   tcp::socket& socket;
   parser_type& parser;
   beast::flat_buffer& buffer; //< parse buffer
+  boost::asio::yield_context yield; //< suspends the connection on socket io
 
   RGWEnv env;
 
@@ -33,7 +35,7 @@ class ClientIO : public io::RestfulClient,
 
  public:
   ClientIO(tcp::socket& socket, parser_type& parser,
-           beast::flat_buffer& buffer);
+           beast::flat_buffer& buffer, boost::asio::yield_context yield);
   ~ClientIO() override;
 
   void init_env(CephContext *cct) override;
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include <boost/asio.hpp>
+#include <boost/asio/spawn.hpp>
 
 #include "rgw_asio_client.h"
 #include "rgw_asio_frontend.h"
@@ -67,9 +68,9 @@ class Connection {
   boost::asio::strand strand;
   tcp::socket socket;
 
-  // references are bound to callbacks for async operations. if a callback
-  // function returns without issuing another operation, the reference is
-  // dropped and the Connection is deleted/closed
+  // the coroutine spawned by on_connect() holds a reference for as long as
+  // it runs. once it returns, the reference is dropped and the Connection is
+  // deleted/closed
   std::atomic<int> nref{0};
   using Ref = boost::intrusive_ptr<Connection>;
 
@@ -77,102 +78,97 @@ class Connection {
   static constexpr size_t header_limit = 4096;
   // don't impose a limit on the body, since we read it in pieces
   static constexpr size_t body_limit = std::numeric_limits<size_t>::max();
+  // process_request() runs on the coroutine's stack, so give it room well
+  // beyond the coroutine library's default
+  static constexpr size_t stack_size = 512 * 1024;
 
   beast::flat_buffer buffer;
-  boost::optional<rgw::asio::parser_type> parser;
 
   using bad_response_type = beast::http::response<beast::http::empty_body>;
-  boost::optional<bad_response_type> response;
 
   CephContext* ctx() const { return env.store->ctx(); }
 
-  void read_header() {
-    // configure the parser
-    parser.emplace();
-    parser->header_limit(header_limit);
-    parser->body_limit(body_limit);
-
-    // parse the header
-    beast::http::async_read_header(socket, buffer, *parser, strand.wrap(
-            std::bind(&Connection::on_header, Ref{this},
-                      std::placeholders::_1)));
-  }
-
-  void discard_unread_message() {
-    if (parser->is_done()) {
-      // nothing left to discard, start reading the next message
-      read_header();
-      return;
-    }
-
-    // read the rest of the request into a static buffer. multiple clients could
-    // write at the same time, but this is okay because we never read it back
+  // read the rest of the request into a static buffer so the next message can
+  // be parsed. multiple clients could write at the same time, but this is
+  // okay because we never read it back
+  bool discard_unread_message(rgw::asio::parser_type& parser,
+                              boost::asio::yield_context yield) {
     static std::array<char, 1024> discard_buffer;
 
-    auto& body = parser->get().body();
-    body.size = discard_buffer.size();
-    body.data = discard_buffer.data();
-
-    beast::http::async_read_some(socket, buffer, *parser, strand.wrap(
-            std::bind(&Connection::on_discard_unread, Ref{this},
-                      std::placeholders::_1)));
-  }
-
-  void on_discard_unread(boost::system::error_code ec) {
-    if (ec == boost::asio::error::connection_reset) {
-      return;
-    }
-    if (ec) {
-      ldout(ctx(), 5) << "discard_unread_message failed: "
-          << ec.message() << dendl;
-      return;
-    }
-    discard_unread_message();
-  }
+    boost::system::error_code ec;
+    while (!parser.is_done()) {
+      auto& body = parser.get().body();
+      body.size = discard_buffer.size();
+      body.data = discard_buffer.data();
 
-  void on_write_error(boost::system::error_code ec) {
-    if (ec) {
-      ldout(ctx(), 5) << "failed to write response: " << ec.message() << dendl;
+      beast::http::async_read_some(socket, buffer, parser, yield[ec]);
+      if (ec == boost::asio::error::connection_reset) {
+        return false;
+      }
+      if (ec) {
+        ldout(ctx(), 5) << "discard_unread_message failed: "
+            << ec.message() << dendl;
+        return false;
+      }
     }
+    return true;
   }
 
-  void on_header(boost::system::error_code ec) {
-    if (ec == boost::asio::error::connection_reset ||
-        ec == beast::http::error::end_of_stream) {
-      return;
-    }
-    if (ec) {
-      auto& message = parser->get();
-      ldout(ctx(), 1) << "failed to read header: " << ec.message() << dendl;
-      ldout(ctx(), 1) << "====== req done http_status=400 ======" << dendl;
-      response.emplace();
-      response->result(beast::http::status::bad_request);
-      response->version(message.version() == 10 ? 10 : 11);
-      response->prepare_payload();
-      beast::http::async_write(socket, *response, strand.wrap(
-            std::bind(&Connection::on_write_error, Ref{this},
-                      std::placeholders::_1)));
-      return;
-    }
+  // serve requests until the client closes the connection. socket reads and
+  // writes suspend the coroutine instead of blocking the thread, so a slow
+  // client only holds a thread while its request is being executed
+  void handle_connection(boost::asio::yield_context yield) {
+    for (;;) {
+      // configure the parser
+      rgw::asio::parser_type parser;
+      parser.header_limit(header_limit);
+      parser.body_limit(body_limit);
+
+      // parse the header
+      boost::system::error_code ec;
+      beast::http::async_read_header(socket, buffer, parser, yield[ec]);
+      if (ec == boost::asio::error::connection_reset ||
+          ec == beast::http::error::end_of_stream) {
+        return;
+      }
+      if (ec) {
+        auto& message = parser.get();
+        ldout(ctx(), 1) << "failed to read header: " << ec.message() << dendl;
+        ldout(ctx(), 1) << "====== req done http_status=400 ======" << dendl;
+        bad_response_type response;
+        response.result(beast::http::status::bad_request);
+        response.version(message.version() == 10 ? 10 : 11);
+        response.prepare_payload();
+        beast::http::async_write(socket, response, yield[ec]);
+        if (ec) {
+          ldout(ctx(), 5) << "failed to write response: " << ec.message()
+              << dendl;
+        }
+        return;
+      }
 
-    // process the request
-    RGWRequest req{env.store->get_new_req_id()};
+      // process the request
+      RGWRequest req{env.store->get_new_req_id()};
 
-    rgw::asio::ClientIO real_client{socket, *parser, buffer};
+      rgw::asio::ClientIO real_client{socket, parser, buffer, yield};
 
-    auto real_client_io = rgw::io::add_reordering(
-                            rgw::io::add_buffering(ctx(),
-                              rgw::io::add_chunking(
-                                rgw::io::add_conlen_controlling(
-                                  &real_client))));
-    RGWRestfulIO client(ctx(), &real_client_io);
-    process_request(env.store, env.rest, &req, env.uri_prefix,
-                    *env.auth_registry, &client, env.olog);
+      auto real_client_io = rgw::io::add_reordering(
+                              rgw::io::add_buffering(ctx(),
+                                rgw::io::add_chunking(
+                                  rgw::io::add_conlen_controlling(
+                                    &real_client))));
+      RGWRestfulIO client(ctx(), &real_client_io);
+      process_request(env.store, env.rest, &req, env.uri_prefix,
+                      *env.auth_registry, &client, env.olog);
 
-    if (parser->is_keep_alive()) {
+      if (!parser.is_keep_alive()) {
+        return;
+      }
       // parse any unread bytes from the previous message (in case we replied
       // before reading the entire body) before reading the next
-      discard_unread_message();
+      if (!discard_unread_message(parser, yield)) {
+        return;
+      }
     }
   }
 
@@ -181,7 +177,10 @@ class Connection {
     : env(env), strand(socket.get_io_service()), socket(std::move(socket)) {}
 
   void on_connect() {
-    read_header();
+    boost::asio::spawn(strand,
+                       std::bind(&Connection::handle_connection, Ref{this},
+                                 std::placeholders::_1),
+                       boost::coroutines::attributes{stack_size});
   }
 
   void get() { ++nref; }
@@ -260,9 +259,17 @@ void AsioFrontend::accept(boost::system::error_code ec)
                           return accept(ec);
                         });
 
+  // keep-alive connections carry many small responses whose header and body
+  // go out in separate writes. without nodelay, nagle holds the second write
+  // back until the client's delayed ack arrives
+  socket.set_option(tcp::no_delay(true), ec);
+  if (ec) {
+    ldout(ctx(), 1) << "failed to set TCP_NODELAY: " << ec.message() << dendl;
+  }
+
   boost::intrusive_ptr<Connection> conn{new Connection(env, std::move(socket))};
   conn->on_connect();
-  // reference drops here, but on_connect() takes another
+  // reference drops here, but the spawned coroutine holds another
 }
 
 int AsioFrontend::run()
@@ -118,6 +118,10 @@ public:
     return "rgw::auth::keystone::EC2Engine";
   }
 
+  int get_lat_counter() const noexcept override {
+    return l_rgw_auth_keystone_lat;
+  }
+
 }; /* class EC2Engine */
 
 }; /* namespace keystone */
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "common/armor.h"
+#include "common/lru_map.h"
 #include "common/utf8.h"
 #include "rgw_auth_s3.h"
 #include "rgw_common.h"
@@ -647,19 +648,42 @@ get_v4_canon_req_hash(CephContext* cct,
 {
   ldout(cct, 10) << "payload request hash = " << request_payload_hash << dendl;
 
-  const auto canonical_req = string_join_reserve("\n",
+  /* Hash the pieces in place instead of joining them into a temporary
+   * canonical request, which is only built when it's going to be logged. */
+  const std::array<boost::string_view, 6> parts = {
     http_verb,
     canonical_uri,
     canonical_qs,
     canonical_hdrs,
     signed_hdrs,
-    request_payload_hash);
+    request_payload_hash
+  };
 
-  const auto canonical_req_hash = calc_hash_sha256(canonical_req);
+  ceph::crypto::SHA256 hasher;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    if (i > 0) {
+      hasher.Update(reinterpret_cast<const unsigned char*>("\n"), 1);
+    }
+    hasher.Update(reinterpret_cast<const unsigned char*>(parts[i].data()),
+                  parts[i].size());
+  }
 
-  ldout(cct, 10) << "canonical request = " << canonical_req << dendl;
-  ldout(cct, 10) << "canonical request hash = "
-                 << buf_to_hex(canonical_req_hash).data() << dendl;
+  sha256_digest_t canonical_req_hash;
+  hasher.Final(canonical_req_hash.data());
+
+  if (cct->_conf->subsys.should_gather(ceph_subsys_rgw, 10)) {
+    const auto canonical_req = string_join_reserve("\n",
+      http_verb,
+      canonical_uri,
+      canonical_qs,
+      canonical_hdrs,
+      signed_hdrs,
+      request_payload_hash);
+
+    ldout(cct, 10) << "canonical request = " << canonical_req << dendl;
+    ldout(cct, 10) << "canonical request hash = "
+                   << buf_to_hex(canonical_req_hash).data() << dendl;
+  }
 
   return canonical_req_hash;
 }
@@ -740,12 +764,32 @@ transform_secret_key(const boost::string_view& secret_access_key)
 
 /*
  * calculate the SigningKey of AWS auth version 4
+ *
+ * The key only depends on the secret and on the date, region and service
+ * of the credential scope, so it stays the same for a whole day of requests
+ * by a client. Keep the recent ones instead of rederiving them through four
+ * HMACs every time.
  */
 static sha256_digest_t
 get_v4_signing_key(CephContext* const cct,
                    const boost::string_view& credential_scope,
                    const boost::string_view& secret_access_key)
 {
+  static lru_map<std::string, sha256_digest_t> signing_key_cache(
+    cct->_conf->rgw_s3_signing_key_cache_size);
+
+  const bool use_cache = cct->_conf->rgw_s3_signing_key_cache_size > 0;
+  std::string cache_key;
+  if (use_cache) {
+    cache_key = string_join_reserve("\n", credential_scope, secret_access_key);
+
+    sha256_digest_t cached_key;
+    if (signing_key_cache.find(cache_key, cached_key)) {
+      ldout(cct, 20) << "signing_k found in cache" << dendl;
+      return cached_key;
+    }
+  }
+
   boost::string_view date, region, service;
   std::tie(date, region, service) = parse_cred_scope(credential_scope);
 
@@ -763,6 +807,11 @@ get_v4_signing_key(CephContext* const cct,
   ldout(cct, 10) << "service_k = " << buf_to_hex(service_k).data() << dendl;
   ldout(cct, 10) << "signing_k = " << buf_to_hex(signing_key).data() << dendl;
 
+  if (use_cache) {
+    sha256_digest_t cached_key = signing_key;
+    signing_key_cache.add(cache_key, cached_key);
+  }
+
   return signing_key;
 }
 
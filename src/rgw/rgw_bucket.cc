@@ -500,7 +500,8 @@ static bool bucket_object_check_filter(const string& oid)
   return rgw_obj_key::oid_to_key_in_ns(oid, &key, ns);
 }
 
-int rgw_remove_object(RGWRados *store, RGWBucketInfo& bucket_info, rgw_bucket& bucket, rgw_obj_key& key)
+int rgw_remove_object(RGWRados *store, RGWBucketInfo& bucket_info, rgw_bucket& bucket, rgw_obj_key& key,
+                      RGWIndexCompleteBatch *index_batch)
 {
   RGWObjectCtx rctx(store);
 
@@ -510,7 +511,8 @@ int rgw_remove_object(RGWRados *store, RGWBucketInfo& bucket_info, rgw_bucket& b
 
   rgw_obj obj(bucket, key);
 
-  return store->delete_obj(rctx, bucket_info, obj, bucket_info.versioning_status());
+  return store->delete_obj(rctx, bucket_info, obj, bucket_info.versioning_status(),
+                           0, ceph::real_time(), nullptr, index_batch);
 }
 
 int rgw_remove_bucket(RGWRados *store, rgw_bucket& bucket, bool delete_children)
@@ -1137,7 +1139,7 @@ int RGWBucket::check_object_index(RGWBucketAdminOpState& op_state,
   while (is_truncated) {
     map<string, rgw_bucket_dir_entry> result;
 
-    int r = store->cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, 1000, true,
+    int r = store->cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, string(), 1000, true,
                                    result, &is_truncated, &marker,
                                    bucket_object_check_filter);
     if (r == -ENOENT) {
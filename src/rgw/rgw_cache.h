@@ -7,6 +7,9 @@
 #include "rgw_rados.h"
 #include <string>
 #include <map>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include "include/types.h"
 #include "include/utime.h"
 #include "include/assert.h"
@@ -134,31 +137,56 @@ struct ObjectCacheEntry {
   ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
 };
 
-class ObjectCache {
+/*
+ * The cache is split into rgw_cache_shards independent shards, selected by
+ * a hash of the entry name, so that lookups of unrelated metadata don't
+ * serialize on a single lock. Each shard has its own LRU, bounded by its
+ * share of rgw_cache_lru_size.
+ */
+struct ObjectCacheShard {
   std::map<string, ObjectCacheEntry> cache_map;
   std::list<string> lru;
   unsigned long lru_size;
   unsigned long lru_counter;
   unsigned long lru_window;
+  unsigned long lru_max;
   RWLock lock;
+
+  ObjectCacheShard(unsigned long _lru_max)
+    : lru_size(0), lru_counter(0), lru_window(_lru_max / 2),
+      lru_max(_lru_max), lock("ObjectCacheShard") {}
+};
+
+class ObjectCache {
+  std::vector<std::unique_ptr<ObjectCacheShard> > shards;
   CephContext *cct;
 
+  RWLock chained_lock;
   list<RGWChainedCache *> chained_cache;
 
-  bool enabled;
+  std::atomic<bool> enabled;
+
+  ObjectCacheShard& get_shard(const string& name) {
+    return *shards[ceph_str_hash_linux(name.c_str(), name.size()) % shards.size()];
+  }
 
-  void touch_lru(string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter);
-  void remove_lru(string& name, std::list<string>::iterator& lru_iter);
+  void touch_lru(ObjectCacheShard& shard, string& name, ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter);
+  void remove_lru(ObjectCacheShard& shard, string& name, std::list<string>::iterator& lru_iter);
 
   void do_invalidate_all();
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), lock("ObjectCache"), cct(NULL), enabled(false) { }
+  ObjectCache() : cct(NULL), chained_lock("ObjectCache::chained_lock"), enabled(false) { }
   int get(std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   void put(std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   void remove(std::string& name);
   void set_ctx(CephContext *_cct) {
     cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
+    int64_t num_shards = std::max<int64_t>(cct->_conf->rgw_cache_shards, 1);
+    unsigned long lru_max = std::max<int64_t>(cct->_conf->rgw_cache_lru_size / num_shards, 1);
+    shards.clear();
+    for (int i = 0; i < num_shards; i++) {
+      shards.emplace_back(new ObjectCacheShard(lru_max));
+    }
   }
   bool chain_cache_entry(list<rgw_cache_entry_info *>& cache_info_entries, RGWChainedCache::Entry *chained_entry);
 
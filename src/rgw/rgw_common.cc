@@ -157,6 +157,21 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64_counter(l_rgw_keystone_token_cache_hit, "keystone_token_cache_hit", "Keystone token cache hits");
   plb.add_u64_counter(l_rgw_keystone_token_cache_miss, "keystone_token_cache_miss", "Keystone token cache miss");
 
+  plb.add_u64_counter(l_rgw_gc_retire_object, "gc_retire_object", "GC object retires");
+  plb.add_u64_counter(l_rgw_gc_retire_chain, "gc_retire_chain", "GC chains retired");
+  plb.add_u64_counter(l_rgw_gc_retire_fail, "gc_retire_fail", "GC object retire failures");
+  plb.add_u64(l_rgw_gc_aio, "gc_aio", "GC deletes in flight");
+  plb.add_u64(l_rgw_gc_unfinished_shards, "gc_unfinished_shards", "GC shards left with expired entries by the last pass");
+
+  plb.add_u64_counter(l_rgw_data_sync_shard, "data_sync_shard", "Bucket shards synced from data logs");
+  plb.add_u64_counter(l_rgw_data_sync_shard_fail, "data_sync_shard_fail", "Bucket shard sync failures");
+  plb.add_u64_counter(l_rgw_data_sync_obj, "data_sync_obj", "Objects synced from bucket index logs");
+  plb.add_u64_counter(l_rgw_data_sync_obj_fail, "data_sync_obj_fail", "Object sync failures");
+
+  plb.add_time_avg(l_rgw_auth_local_lat, "auth_local_lat", "S3 local auth engine latency");
+  plb.add_time_avg(l_rgw_auth_ldap_lat, "auth_ldap_lat", "S3 LDAP auth engine latency");
+  plb.add_time_avg(l_rgw_auth_keystone_lat, "auth_keystone_lat", "S3 Keystone EC2 auth engine latency");
+
   perfcounter = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perfcounter);
   return 0;
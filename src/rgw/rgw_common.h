@@ -258,6 +258,21 @@ enum {
   l_rgw_keystone_token_cache_hit,
   l_rgw_keystone_token_cache_miss,
 
+  l_rgw_gc_retire_object,
+  l_rgw_gc_retire_chain,
+  l_rgw_gc_retire_fail,
+  l_rgw_gc_aio,
+  l_rgw_gc_unfinished_shards,
+
+  l_rgw_data_sync_shard,
+  l_rgw_data_sync_shard_fail,
+  l_rgw_data_sync_obj,
+  l_rgw_data_sync_obj_fail,
+
+  l_rgw_auth_local_lat,
+  l_rgw_auth_ldap_lat,
+  l_rgw_auth_keystone_lat,
+
   l_rgw_last,
 };
 
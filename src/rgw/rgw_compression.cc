@@ -3,11 +3,127 @@
 // vim: ts=8 sw=2 smarttab
 
 #include "rgw_compression.h"
+#include "common/Cond.h"
+#include "common/WorkQueue.h"
 
 #define dout_subsys ceph_subsys_rgw
 
+namespace {
+
+class RGWCompressionPool : public ThreadPool {
+public:
+  ContextWQ *work_queue;
+
+  explicit RGWCompressionPool(CephContext *cct)
+    : ThreadPool(cct, "rgw::compression_pool", "tp_rgw_compress",
+                 cct->_conf->rgw_compression_threads),
+      work_queue(new ContextWQ("rgw::compression_wq", 0, this)) {
+    start();
+  }
+  ~RGWCompressionPool() override {
+    work_queue->drain();
+    delete work_queue;
+
+    stop();
+  }
+
+  static RGWCompressionPool *get_instance(CephContext *cct) {
+    RGWCompressionPool *pool;
+    cct->lookup_or_create_singleton_object<RGWCompressionPool>(
+      pool, "rgw::compression_pool");
+    return pool;
+  }
+};
+
+struct CompressBlock {
+  bufferlist in;
+  bufferlist out;
+  int r = 0;
+};
+
+class C_CompressBlock : public Context {
+  CompressorRef compressor;
+  CompressBlock *block;
+  Mutex& lock;
+  Cond& cond;
+  int& pending;
+public:
+  C_CompressBlock(CompressorRef compressor, CompressBlock *block,
+                  Mutex& lock, Cond& cond, int& pending)
+    : compressor(compressor), block(block),
+      lock(lock), cond(cond), pending(pending) {}
+
+  void finish(int) override {
+    int r = compressor->compress(block->in, block->out);
+    Mutex::Locker l(lock);
+    block->r = r;
+    if (--pending == 0) {
+      cond.Signal();
+    }
+  }
+};
+
+} // anonymous namespace
+
 //------------RGWPutObj_Compress---------------
 
+/*
+ * Chunks larger than rgw_compression_split_size are cut into blocks that
+ * the compression pool works on in parallel, the request thread taking the
+ * first one itself. Every block is recorded separately, so the decompressor
+ * needs nothing new to read them back.
+ */
+int RGWPutObj_Compress::compress_part(const bufferlist& bl, off_t ofs, bufferlist& out)
+{
+  uint64_t split = std::max<int64_t>(cct->_conf->rgw_compression_split_size, 0);
+  std::vector<CompressBlock> parts;
+  if (cct->_conf->rgw_compression_threads > 0 && split > 0) {
+    parts.resize((bl.length() + split - 1) / split);
+  }
+
+  if (parts.size() <= 1) {
+    parts.resize(1);
+    parts[0].r = compressor->compress(bl, parts[0].out);
+  } else {
+    for (size_t i = 0; i < parts.size(); ++i) {
+      uint64_t o = i * split;
+      parts[i].in.substr_of(bl, o, std::min<uint64_t>(split, bl.length() - o));
+    }
+
+    Mutex lock("RGWPutObj_Compress::compress_part");
+    Cond cond;
+    int pending = parts.size() - 1;
+    RGWCompressionPool *pool = RGWCompressionPool::get_instance(cct);
+    for (size_t i = 1; i < parts.size(); ++i) {
+      pool->work_queue->queue(new C_CompressBlock(compressor, &parts[i],
+                                                  lock, cond, pending));
+    }
+    parts[0].r = compressor->compress(parts[0].in, parts[0].out);
+
+    Mutex::Locker l(lock);
+    while (pending > 0) {
+      cond.Wait(lock);
+    }
+  }
+
+  for (auto& part : parts) {
+    if (part.r < 0) {
+      return part.r;
+    }
+  }
+
+  for (size_t i = 0; i < parts.size(); ++i) {
+    compression_block newbl;
+    size_t bs = blocks.size();
+    newbl.old_ofs = ofs + i * split;
+    newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
+    newbl.len = parts[i].out.length();
+    blocks.push_back(newbl);
+    out.claim_append(parts[i].out);
+  }
+  return 0;
+}
+
 int RGWPutObj_Compress::handle_data(bufferlist& bl, off_t ofs, void **phandle, rgw_raw_obj *pobj, bool *again)
 {
   bufferlist in_bl;
@@ -19,7 +135,7 @@ int RGWPutObj_Compress::handle_data(bufferlist& bl, off_t ofs, void **phandle, r
     if ((ofs > 0 && compressed) ||                                // if previous part was compressed
         (ofs == 0)) {                                             // or it's the first part
       ldout(cct, 10) << "Compression for rgw is enabled, compress part " << bl.length() << dendl;
-      int cr = compressor->compress(bl, in_bl);
+      int cr = compress_part(bl, ofs, in_bl);
       if (cr < 0) {
         if (ofs > 0) {
           lderr(cct) << "Compression failed with exit code " << cr
@@ -32,13 +148,6 @@ int RGWPutObj_Compress::handle_data(bufferlist& bl, off_t ofs, void **phandle, r
         in_bl.claim(bl);
       } else {
         compressed = true;
-    
-        compression_block newbl;
-        size_t bs = blocks.size();
-        newbl.old_ofs = ofs;
-        newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
-        newbl.len = in_bl.length();
-        blocks.push_back(newbl);
       }
     } else {
       compressed = false;
@@ -37,6 +37,8 @@ class RGWPutObj_Compress : public RGWPutObj_Filter
   bool compressed{false};
   CompressorRef compressor;
   std::vector<compression_block> blocks;
+
+  int compress_part(const bufferlist& bl, off_t ofs, bufferlist& out);
 public:
   RGWPutObj_Compress(CephContext* cct_, CompressorRef compressor,
                      RGWPutObjDataProcessor* next)
@@ -1024,6 +1024,10 @@ public:
       } while (marker_tracker && marker_tracker->need_retry(raw_key));
 
       sync_status = retcode;
+      if (perfcounter) {
+        perfcounter->inc(sync_status < 0 && sync_status != -ENOENT ?
+                         l_rgw_data_sync_shard_fail : l_rgw_data_sync_shard);
+      }
 
       if (sync_status == -ENOENT) {
         // this was added when 'tenant/' was added to datalog entries, because
@@ -1067,8 +1071,28 @@ public:
   }
 };
 
-#define BUCKET_SHARD_SYNC_SPAWN_WINDOW 20
 #define DATA_SYNC_MAX_ERR_ENTRIES 10
+#define SYNC_SPAWN_WINDOW_MAX_FACTOR 4
+
+/*
+ * How many children a sync stage keeps in flight.  Each stage (datalog
+ * shard, bucket shard full and incremental sync) has its own window: it
+ * opens up while the stage is working through a backlog, and drops back
+ * to the configured size once it has caught up.
+ */
+class RGWSyncSpawnWindow {
+  int base;
+  int max;
+  int cur;
+public:
+  explicit RGWSyncSpawnWindow(int64_t _base)
+    : base(std::max<int64_t>(1, _base)),
+      max(base * SYNC_SPAWN_WINDOW_MAX_FACTOR), cur(base) {}
+
+  void behind() { cur = std::min(cur * 2, max); }
+  void caught_up() { cur = base; }
+  int size() const { return cur; }
+};
 
 enum RemoteDatalogStatus {
   RemoteNotTrimmed = 0,
@@ -1113,7 +1137,7 @@ class RGWDataSyncShardCR : public RGWCoroutine {
 
   int total_entries;
 
-  int spawn_window;
+  RGWSyncSpawnWindow spawn_window;
 
   bool *reset_backoff;
 
@@ -1151,7 +1175,7 @@ public:
 						      shard_id(_shard_id),
 						      sync_marker(_marker),
                                                       marker_tracker(NULL), truncated(false), remote_trimmed(RemoteNotTrimmed), inc_lock("RGWDataSyncShardCR::inc_lock"),
-                                                      total_entries(0), spawn_window(BUCKET_SHARD_SYNC_SPAWN_WINDOW), reset_backoff(NULL),
+                                                      total_entries(0), spawn_window(_sync_env->cct->_conf->rgw_data_sync_spawn_window), reset_backoff(NULL),
                                                       lease_cr(nullptr), lease_stack(nullptr), error_repo(nullptr), max_error_entries(DATA_SYNC_MAX_ERR_ENTRIES),
                                                       retry_backoff_secs(RETRY_BACKOFF_SECS_DEFAULT), tn(_tn) {
     set_description() << "data sync shard source_zone=" << sync_env->source_zone << " shard_id=" << shard_id;
@@ -1272,6 +1296,21 @@ public:
             }
           }
           sync_marker.marker = iter->first;
+
+          /* keep listing ahead while these sync, but don't run away */
+          while ((int)num_spawned() > spawn_window.size()) {
+            set_status() << "num_spawned() > spawn_window";
+            yield wait_for_child();
+            int ret;
+            while (collect(&ret, lease_stack.get())) {
+              if (ret < 0) {
+                tn->log(10, "a sync operation returned error");
+              }
+            }
+          }
+        }
+        if ((int)entries.size() == max_entries) {
+          spawn_window.behind();
         }
       } while ((int)entries.size() == max_entries);
 
@@ -1395,6 +1434,11 @@ public:
           if (log_entries.size() > 0) {
             tn->set_flag(RGW_SNS_FLAG_ACTIVE); /* actually have entries to sync */
           }
+          if (truncated) {
+            spawn_window.behind();
+          } else {
+            spawn_window.caught_up();
+          }
 
           for (log_iter = log_entries.begin(); log_iter != log_entries.end(); ++log_iter) {
             tn->log(20, SSTR("shard_id=" << shard_id << " log_entry: " << log_iter->log_id << ":" << log_iter->log_timestamp << ":" << log_iter->entry.key));
@@ -1420,7 +1464,7 @@ public:
               }
             }
 	  }
-          while ((int)num_spawned() > spawn_window) {
+          while ((int)num_spawned() > spawn_window.size()) {
             set_status() << "num_spawned() > spawn_window";
             yield wait_for_child();
             int ret;
@@ -2402,6 +2446,10 @@ public:
       {
         tn->unset_flag(RGW_SNS_FLAG_ACTIVE);
         stringstream ss;
+        if (perfcounter) {
+          perfcounter->inc(retcode < 0 && retcode != -ENOENT ?
+                           l_rgw_data_sync_obj_fail : l_rgw_data_sync_obj);
+        }
         if (retcode >= 0) {
           ss << "done";
           tn->log(10, "success");
@@ -2438,8 +2486,6 @@ done:
   }
 };
 
-#define BUCKET_SYNC_SPAWN_WINDOW 20
-
 class RGWBucketShardFullSyncCR : public RGWCoroutine {
   RGWDataSyncEnv *sync_env;
   const rgw_bucket_shard& bs;
@@ -2459,6 +2505,8 @@ class RGWBucketShardFullSyncCR : public RGWCoroutine {
 
   const string& status_oid;
 
+  RGWSyncSpawnWindow spawn_window;
+
   RGWDataSyncDebugLogger logger;
   rgw_zone_set zones_trace;
 
@@ -2473,7 +2521,8 @@ public:
     : RGWCoroutine(_sync_env->cct), sync_env(_sync_env), bs(bs),
       bucket_info(_bucket_info), lease_cr(lease_cr), full_marker(_full_marker),
       marker_tracker(sync_env, status_oid, full_marker),
-      status_oid(status_oid) {
+      status_oid(status_oid),
+      spawn_window(_sync_env->cct->_conf->rgw_bucket_sync_spawn_window) {
     logger.init(sync_env, "BucketFull", bs.get_key());
     zones_trace.insert(sync_env->source_zone);
     tn = sync_env->sync_tracer->add_node(new RGWSyncTraceNode(sync_env->cct,
@@ -2511,6 +2560,9 @@ int RGWBucketShardFullSyncCR::operate()
       if (list_result.entries.size() > 0) {
         tn->set_flag(RGW_SNS_FLAG_ACTIVE); /* actually have entries to sync */
       }
+      if (list_result.is_truncated) {
+        spawn_window.behind();
+      }
       entries_iter = list_result.entries.begin();
       for (; entries_iter != list_result.entries.end(); ++entries_iter) {
         if (!lease_cr->is_locked()) {
@@ -2534,7 +2586,7 @@ int RGWBucketShardFullSyncCR::operate()
                                  entry->key, &marker_tracker, zones_trace, tn),
                       false);
         }
-        while (num_spawned() > BUCKET_SYNC_SPAWN_WINDOW) {
+        while ((int)num_spawned() > spawn_window.size()) {
           yield wait_for_child();
           bool again = true;
           while (again) {
@@ -2618,6 +2670,8 @@ class RGWBucketShardIncrementalSyncCR : public RGWCoroutine {
   int sync_status{0};
   bool syncstopped{false};
 
+  RGWSyncSpawnWindow spawn_window;
+
   RGWSyncTraceNodeRef tn;
 public:
   RGWBucketShardIncrementalSyncCR(RGWDataSyncEnv *_sync_env,
@@ -2629,7 +2683,8 @@ public:
                                   RGWSyncTraceNodeRef& _tn_parent)
     : RGWCoroutine(_sync_env->cct), sync_env(_sync_env), bs(bs),
       bucket_info(_bucket_info), lease_cr(lease_cr), inc_marker(_inc_marker),
-      marker_tracker(sync_env, status_oid, inc_marker), status_oid(status_oid) , zone_id(_sync_env->store->get_zone().id){
+      marker_tracker(sync_env, status_oid, inc_marker), status_oid(status_oid) , zone_id(_sync_env->store->get_zone().id),
+      spawn_window(_sync_env->cct->_conf->rgw_bucket_sync_spawn_window) {
     set_description() << "bucket shard incremental sync bucket="
         << bucket_shard_str{bs};
     set_status("init");
@@ -2670,6 +2725,12 @@ int RGWBucketShardIncrementalSyncCR::operate()
 	}
       }
       squash_map.clear();
+      /* more changes than we can run at once means we're falling behind */
+      if (list_result.size() > (size_t)spawn_window.size()) {
+        spawn_window.behind();
+      } else {
+        spawn_window.caught_up();
+      }
       for (auto& e : list_result) {
         if (e.op == RGWModifyOp::CLS_RGW_OP_SYNCSTOP && (sync_modify_time < e.timestamp)) {
           ldout(sync_env->cct, 20) << " syncstop on " << e.timestamp << dendl;
@@ -2809,7 +2870,7 @@ int RGWBucketShardIncrementalSyncCR::operate()
                   false);
           }
         // }
-        while (num_spawned() > BUCKET_SYNC_SPAWN_WINDOW) {
+        while ((int)num_spawned() > spawn_window.size()) {
           set_status() << "num_spawned() > spawn_window";
           yield wait_for_child();
           bool again = true;
@@ -9,6 +9,7 @@
 #include "include/random.h"
 
 #include <list>
+#include <deque>
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_rgw
@@ -128,11 +129,179 @@ int RGWGC::list(int *index, string& marker, uint32_t max, bool expired_only, std
   return 0;
 }
 
-int RGWGC::process(int index, int max_secs)
+#define MAX_REMOVE_CHUNK 16
+
+/*
+ * Keeps up to rgw_gc_max_concurrent_io tail object deletes in flight
+ * across all gc shards, and only queues a chain's tag for removal from
+ * the gc log once every delete in that chain has completed.
+ */
+class RGWGCIOManager {
+  CephContext *cct;
+  RGWGC *gc;
+
+  struct IO {
+    librados::AioCompletion *c;
+    int index;
+    string tag;
+    string oid;
+  };
+
+  struct ChainState {
+    int pending = 0;
+    bool failed = false;
+    bool sealed = false;
+  };
+
+  std::deque<IO> ios;
+  std::map<pair<int, string>, ChainState> chains;
+  vector<std::list<string> > remove_tags;
+  size_t max_aio;
+
+  void handle_next_completion();
+  void try_retire(const pair<int, string>& key);
+
+public:
+  RGWGCIOManager(CephContext *_cct, RGWGC *_gc) : cct(_cct), gc(_gc),
+    remove_tags(_gc->max_objs),
+    max_aio(std::max<int64_t>(1, _cct->_conf->rgw_gc_max_concurrent_io)) {}
+  ~RGWGCIOManager() {
+    for (auto& io : ios) {
+      io.c->release();
+    }
+    if (perfcounter) {
+      perfcounter->set(l_rgw_gc_aio, 0);
+    }
+  }
+
+  int schedule_io(IoCtx *ioctx, const string& oid, ObjectWriteOperation *op,
+                  int index, const string& tag);
+  void seal_chain(int index, const string& tag, bool failed);
+  void flush_remove_tags(int index);
+  void drain();
+};
+
+int RGWGCIOManager::schedule_io(IoCtx *ioctx, const string& oid,
+                                ObjectWriteOperation *op,
+                                int index, const string& tag)
+{
+  while (ios.size() >= max_aio) {
+    if (gc->going_down()) {
+      return -ECANCELED;
+    }
+    handle_next_completion();
+  }
+
+  AioCompletion *c = librados::Rados::aio_create_completion(NULL, NULL, NULL);
+  int ret = ioctx->aio_operate(oid, c, op);
+  if (ret < 0) {
+    c->release();
+    return ret;
+  }
+  ios.push_back(IO{c, index, tag, oid});
+  chains[make_pair(index, tag)].pending++;
+  if (perfcounter) {
+    perfcounter->set(l_rgw_gc_aio, ios.size());
+  }
+  return 0;
+}
+
+void RGWGCIOManager::handle_next_completion()
+{
+  IO& io = ios.front();
+  io.c->wait_for_complete();
+  int ret = io.c->get_return_value();
+  io.c->release();
+
+  auto key = make_pair(io.index, io.tag);
+  ChainState& chain = chains[key];
+  chain.pending--;
+  if (ret == -ENOENT) {
+    ret = 0;
+  }
+  if (ret < 0) {
+    chain.failed = true;
+    dout(0) << "failed to remove " << io.oid << " tag=" << io.tag
+            << " ret=" << ret << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_gc_retire_fail);
+    }
+  } else if (perfcounter) {
+    perfcounter->inc(l_rgw_gc_retire_object);
+  }
+  ios.pop_front();
+  if (perfcounter) {
+    perfcounter->set(l_rgw_gc_aio, ios.size());
+  }
+
+  try_retire(key);
+}
+
+void RGWGCIOManager::try_retire(const pair<int, string>& key)
+{
+  auto iter = chains.find(key);
+  if (iter == chains.end()) {
+    return;
+  }
+  ChainState& chain = iter->second;
+  if (!chain.sealed || chain.pending > 0) {
+    return;
+  }
+  if (!chain.failed) {
+    std::list<string>& tags = remove_tags[key.first];
+    tags.push_back(key.second);
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_gc_retire_chain);
+    }
+    if (tags.size() > MAX_REMOVE_CHUNK) {
+      flush_remove_tags(key.first);
+    }
+  }
+  chains.erase(iter);
+}
+
+void RGWGCIOManager::seal_chain(int index, const string& tag, bool failed)
+{
+  auto key = make_pair(index, tag);
+  ChainState& chain = chains[key];
+  chain.sealed = true;
+  chain.failed |= failed;
+  try_retire(key);
+}
+
+void RGWGCIOManager::flush_remove_tags(int index)
+{
+  std::list<string>& tags = remove_tags[index];
+  if (tags.empty()) {
+    return;
+  }
+  int ret = gc->remove(index, tags);
+  if (ret < 0) {
+    dout(0) << "WARNING: failed to remove tags on " << index
+            << " ret=" << ret << dendl;
+  }
+  tags.clear();
+}
+
+void RGWGCIOManager::drain()
+{
+  /* don't hold up shutdown on an unresponsive backend; whatever isn't
+   * retired here is picked up again by the next gc pass */
+  while (!ios.empty() && !gc->going_down()) {
+    handle_next_completion();
+  }
+  for (size_t i = 0; i < remove_tags.size(); i++) {
+    flush_remove_tags(i);
+  }
+}
+
+int RGWGC::process(int index, int max_secs, RGWGCIOManager& io_manager,
+                   bool *unfinished)
 {
   rados::cls::lock::Lock l(gc_index_lock_name);
   utime_t end = ceph_clock_now();
-  std::list<string> remove_tags;
+
+  *unfinished = false;
 
   /* max_secs should be greater than zero. We don't want a zero max_secs
    * to be translated as no timeout, since we'd then need to break the
@@ -168,19 +337,22 @@ int RGWGC::process(int index, int max_secs)
     if (ret < 0)
       goto done;
 
+    marker = next_marker;
+
     string last_pool;
     std::list<cls_rgw_gc_obj_info>::iterator iter;
     for (iter = entries.begin(); iter != entries.end(); ++iter) {
-      bool remove_tag;
       cls_rgw_gc_obj_info& info = *iter;
       std::list<cls_rgw_obj>::iterator liter;
       cls_rgw_obj_chain& chain = info.chain;
+      bool scheduled_all = true;
 
       utime_t now = ceph_clock_now();
-      if (now >= end)
+      if (now >= end) {
+        *unfinished = true;
         goto done;
+      }
 
-      remove_tag = true;
       for (liter = chain.objs.begin(); liter != chain.objs.end(); ++liter) {
         cls_rgw_obj& obj = *liter;
 
@@ -202,35 +374,24 @@ int RGWGC::process(int index, int max_secs)
 	dout(5) << "gc::process: removing " << obj.pool << ":" << obj.key.name << dendl;
 	ObjectWriteOperation op;
 	cls_refcount_put(op, info.tag, true);
-        ret = ctx->operate(oid, &op);
-	if (ret == -ENOENT)
-	  ret = 0;
+        ret = io_manager.schedule_io(ctx, oid, &op, index, info.tag);
         if (ret < 0) {
-          remove_tag = false;
-          dout(0) << "failed to remove " << obj.pool << ":" << oid << "@" << obj.loc << dendl;
+          dout(0) << "WARNING: failed to schedule deletion for oid=" << oid << dendl;
+          scheduled_all = false;
         }
 
         if (going_down()) // leave early, even if tag isn't removed, it's ok
           goto done;
       }
-      if (remove_tag) {
-        remove_tags.push_back(info.tag);
-#define MAX_REMOVE_CHUNK 16
-        if (remove_tags.size() > MAX_REMOVE_CHUNK) {
-          RGWGC::remove(index, remove_tags);
-          remove_tags.clear();
-        }
-      }
-    }
-    if (!remove_tags.empty()) {
-      RGWGC::remove(index, remove_tags);
-      remove_tags.clear();
+      io_manager.seal_chain(index, info.tag, !scheduled_all);
     }
   } while (truncated);
 
 done:
-  if (!remove_tags.empty())
-    RGWGC::remove(index, remove_tags);
+  /* tags of chains still in flight are removed once their deletes
+   * complete, after the shard lock is gone; that's harmless, as
+   * dropping a refcount tag twice is a no-op */
+  io_manager.flush_remove_tags(index);
   l.unlock(&store->gc_pool_ctx, obj_names[index]);
   delete ctx;
   return 0;
@@ -242,11 +403,22 @@ int RGWGC::process()
 
   const int start = ceph::util::generate_random_number(0, max_objs - 1);
 
+  RGWGCIOManager io_manager(cct, this);
+  int unfinished_shards = 0;
+
   for (int i = 0; i < max_objs; i++) {
     int index = (i + start) % max_objs;
-    int ret = process(index, max_secs);
+    bool unfinished;
+    int ret = process(index, max_secs, io_manager, &unfinished);
     if (ret < 0)
       return ret;
+    if (unfinished)
+      unfinished_shards++;
+  }
+  io_manager.drain();
+
+  if (perfcounter) {
+    perfcounter->set(l_rgw_gc_unfinished_shards, unfinished_shards);
   }
 
   return 0;
@@ -16,7 +16,11 @@
 
 #include <atomic>
 
+class RGWGCIOManager;
+
 class RGWGC {
+  friend class RGWGCIOManager;
+
   CephContext *cct;
   RGWRados *store;
   int max_objs;
@@ -55,7 +59,8 @@ public:
 
   int list(int *index, string& marker, uint32_t max, bool expired_only, std::list<cls_rgw_gc_obj_info>& result, bool *truncated);
   void list_init(int *index) { *index = 0; }
-  int process(int index, int process_max_secs);
+  int process(int index, int process_max_secs, RGWGCIOManager& io_manager,
+              bool *unfinished);
   int process();
 
   bool going_down();
@@ -248,6 +248,23 @@ int RGWLC::bucket_lc_prepare(int index)
   return 0;
 }
 
+ceph::real_time RGWLC::expiration_cutoff(int days)
+{
+  /* the newest mtime obj_has_expired() can still accept for @days */
+  utime_t base_time;
+  time_t cmp;
+  if (cct->_conf->rgw_lc_debug_interval <= 0) {
+    cmp = days*24*60*60;
+    base_time = ceph_clock_now().round_to_day();
+  } else {
+    cmp = days*cct->_conf->rgw_lc_debug_interval;
+    base_time = ceph_clock_now();
+  }
+  base_time -= utime_t(cmp, 0);
+
+  return base_time.to_real_time();
+}
+
 bool RGWLC::obj_has_expired(ceph::real_time mtime, int days)
 {
   double timediff, cmp;
@@ -266,10 +283,11 @@ bool RGWLC::obj_has_expired(ceph::real_time mtime, int days)
   return (timediff >= cmp);
 }
 
-int RGWLC::remove_expired_obj(RGWBucketInfo& bucket_info, rgw_obj_key obj_key, bool remove_indeed)
+int RGWLC::remove_expired_obj(RGWBucketInfo& bucket_info, rgw_obj_key obj_key, bool remove_indeed,
+                              RGWIndexCompleteBatch *index_batch)
 {
   if (remove_indeed) {
-    return rgw_remove_object(store, bucket_info, bucket_info.bucket, obj_key);
+    return rgw_remove_object(store, bucket_info, bucket_info.bucket, obj_key, index_batch);
   } else {
     obj_key.instance.clear();
     RGWObjectCtx rctx(store);
@@ -380,7 +398,8 @@ int RGWLC::bucket_lc_process(string& shard_id)
   map<string, lc_op>& prefix_map = config.get_prefix_map();
   list_op.params.list_versions = bucket_info.versioned();
   if (!bucket_info.versioned()) {
-    for(auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end(); ++prefix_iter) {
+    vector<pair<const string, lc_op> *> rules;
+    for (auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end(); ++prefix_iter) {
       if (!prefix_iter->second.status || 
         (prefix_iter->second.expiration <=0 && prefix_iter->second.expiration_date == boost::none)) {
         continue;
@@ -389,7 +408,33 @@ int RGWLC::bucket_lc_process(string& shard_id)
         ceph_clock_now() < ceph::real_clock::to_time_t(*prefix_iter->second.expiration_date)) {
         continue;
       }
-      list_op.params.prefix = prefix_iter->first;
+      rules.push_back(&*prefix_iter);
+    }
+
+    /* rules whose prefix falls under the prefix of an earlier rule are all
+     * evaluated in one listing, so each object is only listed once */
+    for (auto rule_iter = rules.begin(); rule_iter != rules.end(); ) {
+      const string& list_prefix = (*rule_iter)->first;
+      vector<pair<const string, lc_op> *> group;
+      bool by_date = false;
+      int min_days = 0;
+      for (; rule_iter != rules.end() &&
+             (*rule_iter)->first.compare(0, list_prefix.size(), list_prefix) == 0;
+           ++rule_iter) {
+        const lc_op& op = (*rule_iter)->second;
+        if (op.expiration_date != boost::none) {
+          by_date = true;
+        } else if (group.empty() || op.expiration < min_days) {
+          min_days = op.expiration;
+        }
+        group.push_back(*rule_iter);
+      }
+
+      list_op.params.prefix = list_prefix;
+      list_op.params.marker = rgw_obj_key();
+      list_op.next_marker = rgw_obj_key();
+      /* let the index skip whatever is too recent for every rule here */
+      list_op.params.max_mtime = (by_date ? ceph::real_time() : expiration_cutoff(min_days));
       do {
         objs.clear();
         list_op.params.marker = list_op.get_next_marker();
@@ -402,47 +447,66 @@ int RGWLC::bucket_lc_process(string& shard_id)
           return ret;
         }
         
-        bool is_expired;
+        /* index updates for the expired entries of this page go out together */
+        RGWIndexCompleteBatch index_batch(store);
         for (auto obj_iter = objs.begin(); obj_iter != objs.end(); ++obj_iter) {
           rgw_obj_key key(obj_iter->key);
           RGWObjState *state;
           rgw_obj obj(bucket_info.bucket, key);
           RGWObjectCtx rctx(store);
-          if (prefix_iter->second.obj_tags != boost::none) {
-            bufferlist tags_bl;
-            int ret = read_obj_tags(store, bucket_info, obj, rctx, tags_bl);
-            if (ret < 0) {
-              if (ret != -ENODATA)
-                ldout(cct, 5) << "ERROR: read_obj_tags returned r=" << ret << dendl;
+
+          if (!key.ns.empty()) {
+            continue;
+          }
+
+          bool is_expired = false;
+          bool tags_read = false;
+          RGWObjTags dest_obj_tags;
+          for (auto rule : group) {
+            const lc_op& op = rule->second;
+            if (key.name.compare(0, rule->first.size(), rule->first) != 0) {
               continue;
             }
-            RGWObjTags dest_obj_tags;
-            try {
-              auto iter = tags_bl.begin();
-              dest_obj_tags.decode(iter);
-            } catch (buffer::error& err) {
-               ldout(cct,0) << "ERROR: caught buffer::error, couldn't decode TagSet" << dendl;
-              return -EIO;
+            if (op.obj_tags != boost::none) {
+              if (!tags_read) {
+                bufferlist tags_bl;
+                int ret = read_obj_tags(store, bucket_info, obj, rctx, tags_bl);
+                if (ret < 0) {
+                  /* no tags to match; rules without a tag filter still apply */
+                  if (ret != -ENODATA)
+                    ldout(cct, 5) << "ERROR: read_obj_tags returned r=" << ret << dendl;
+                } else {
+                  try {
+                    auto iter = tags_bl.begin();
+                    dest_obj_tags.decode(iter);
+                  } catch (buffer::error& err) {
+                     ldout(cct,0) << "ERROR: caught buffer::error, couldn't decode TagSet" << dendl;
+                    return -EIO;
+                  }
+                }
+                tags_read = true;
+              }
+
+              if (!includes(dest_obj_tags.get_tags().begin(),
+                            dest_obj_tags.get_tags().end(),
+                            op.obj_tags->get_tags().begin(),
+                            op.obj_tags->get_tags().end())){
+                ldout(cct, 20) << __func__ << "() skipping rule " << rule->first << " for obj " << key << " as tags do not match" << dendl;
+                continue;
+              }
             }
 
-            if (!includes(dest_obj_tags.get_tags().begin(),
-                          dest_obj_tags.get_tags().end(),
-                          prefix_iter->second.obj_tags->get_tags().begin(),
-                          prefix_iter->second.obj_tags->get_tags().end())){
-              ldout(cct, 20) << __func__ << "() skipping obj " << key << " as tags do not match" << dendl;
-              continue;
+            if (op.expiration_date != boost::none) {
+              //we have checked it before
+              is_expired = true;
+            } else {
+              is_expired = obj_has_expired(obj_iter->meta.mtime, op.expiration);
+            }
+            if (is_expired) {
+              break;
             }
           }
 
-          if (!key.ns.empty()) {
-            continue;
-          }
-          if (prefix_iter->second.expiration_date != boost::none) {
-            //we have checked it before
-            is_expired = true;
-          } else {
-            is_expired = obj_has_expired(obj_iter->meta.mtime, prefix_iter->second.expiration);
-          }
           if (is_expired) {
             int ret = store->get_obj_state(&rctx, bucket_info, obj, &state, false);
             if (ret < 0) {
@@ -453,7 +517,7 @@ int RGWLC::bucket_lc_process(string& shard_id)
               ldout(cct, 20) << __func__ << "() skipping removal: state->mtime " << state->mtime << " obj->mtime " << obj_iter->meta.mtime << dendl;
               continue;
             }
-            ret = remove_expired_obj(bucket_info, obj_iter->key, true);
+            ret = remove_expired_obj(bucket_info, obj_iter->key, true, &index_batch);
             if (ret < 0) {
               ldout(cct, 0) << "ERROR: remove_expired_obj " << dendl;
             } else {
@@ -732,19 +796,23 @@ exit:
 
 void RGWLC::start_processor()
 {
-  worker = new LCWorker(cct, this);
-  worker->create("lifecycle_thr");
+  int num_workers = std::max<int64_t>(1, cct->_conf->rgw_lc_max_worker);
+  for (int i = 0; i < num_workers; i++) {
+    LCWorker *worker = new LCWorker(cct, this);
+    worker->create("lifecycle_thr");
+    workers.push_back(worker);
+  }
 }
 
 void RGWLC::stop_processor()
 {
   down_flag = true;
-  if (worker) {
+  for (auto worker : workers) {
     worker->stop();
     worker->join();
+    delete worker;
   }
-  delete worker;
-  worker = NULL;
+  workers.clear();
 }
 
 void RGWLC::LCWorker::stop()
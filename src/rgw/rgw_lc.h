@@ -357,8 +357,10 @@ class RGWLC {
   };
   
   public:
-  LCWorker *worker;
-  RGWLC() : cct(NULL), store(NULL), worker(NULL) {}
+  /* each worker claims buckets from the lc shards on its own, so several
+   * of them process different buckets in parallel */
+  vector<LCWorker *> workers;
+  RGWLC() : cct(NULL), store(NULL) {}
   ~RGWLC() {
     stop_processor();
     finalize();
@@ -379,8 +381,10 @@ class RGWLC {
   void stop_processor();
 
   private:
-  int remove_expired_obj(RGWBucketInfo& bucket_info, rgw_obj_key obj_key, bool remove_indeed = true);
+  int remove_expired_obj(RGWBucketInfo& bucket_info, rgw_obj_key obj_key, bool remove_indeed = true,
+                         RGWIndexCompleteBatch *index_batch = nullptr);
   bool obj_has_expired(ceph::real_time mtime, int days);
+  ceph::real_time expiration_cutoff(int days);
   int handle_multipart_expiration(RGWRados::Bucket *target, const map<string, lc_op>& prefix_map);
 };
 
@@ -169,13 +169,125 @@ public:
 
 static UsageLogger *usage_logger = NULL;
 
+/* ops logger: batches the entries bound for each rados log object into a
+ * single append, written out by the timer thread */
+class OpsLogger {
+  CephContext *cct;
+  RGWRados *store;
+  map<string, bufferlist> pending;
+  uint64_t pending_bytes;
+  uint64_t dropped;
+  Mutex lock;
+  Mutex timer_lock;
+  SafeTimer timer;
+  bool early_flush;
+
+  class C_OpsLogTimeout : public Context {
+    OpsLogger *logger;
+    bool early;
+  public:
+    C_OpsLogTimeout(OpsLogger *_l, bool _early) : logger(_l), early(_early) {}
+    void finish(int r) override {
+      if (early) {
+        logger->early_flush = false;
+      }
+      logger->flush();
+      if (!early) {
+        logger->set_timer();
+      }
+    }
+  };
+
+  void set_timer() {
+    timer.add_event_after(cct->_conf->rgw_ops_log_flush_interval, new C_OpsLogTimeout(this, false));
+  }
+
+  int append(const string& oid, bufferlist& bl) {
+    rgw_raw_obj obj(store->get_zone_params().log_pool, oid);
+
+    int ret = store->append_async(obj, bl.length(), bl);
+    if (ret == -ENOENT) {
+      ret = store->create_pool(store->get_zone_params().log_pool);
+      if (ret < 0)
+        return ret;
+      // retry
+      ret = store->append_async(obj, bl.length(), bl);
+    }
+    return ret;
+  }
+public:
+
+  OpsLogger(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), pending_bytes(0), dropped(0), lock("OpsLogger"), timer_lock("OpsLogger::timer_lock"), timer(cct, timer_lock), early_flush(false) {
+    timer.init();
+    Mutex::Locker l(timer_lock);
+    set_timer();
+  }
+
+  ~OpsLogger() {
+    Mutex::Locker l(timer_lock);
+    flush();
+    timer.cancel_all_events();
+    timer.shutdown();
+  }
+
+  void insert(const string& oid, bufferlist& bl) {
+    uint64_t len = bl.length();
+    lock.Lock();
+    if (pending_bytes + len > (uint64_t)cct->_conf->rgw_ops_log_max_pending) {
+      dropped++;
+      lock.Unlock();
+      return;
+    }
+    pending[oid].claim_append(bl);
+    pending_bytes += len;
+    bool need_flush = (pending_bytes >= (uint64_t)cct->_conf->rgw_ops_log_flush_threshold);
+    lock.Unlock();
+    if (need_flush) {
+      /* hand the flush to the timer thread rather than doing it here */
+      Mutex::Locker l(timer_lock);
+      if (!early_flush) {
+        early_flush = true;
+        timer.add_event_after(0, new C_OpsLogTimeout(this, true));
+      }
+    }
+  }
+
+  void flush() {
+    map<string, bufferlist> old_pending;
+    lock.Lock();
+    old_pending.swap(pending);
+    pending_bytes = 0;
+    uint64_t old_dropped = dropped;
+    dropped = 0;
+    lock.Unlock();
+
+    if (old_dropped) {
+      ldout(cct, 0) << "WARNING: dropped " << old_dropped << " ops log entries, "
+                    << "more than rgw_ops_log_max_pending bytes were waiting" << dendl;
+    }
+
+    for (auto& iter : old_pending) {
+      int ret = append(iter.first, iter.second);
+      if (ret < 0) {
+        ldout(cct, 0) << "ERROR: failed to write ops log object " << iter.first
+                      << " ret=" << ret << dendl;
+      }
+    }
+  }
+};
+
+static OpsLogger *ops_logger = NULL;
+
 void rgw_log_usage_init(CephContext *cct, RGWRados *store)
 {
   usage_logger = new UsageLogger(cct, store);
+  ops_logger = new OpsLogger(cct, store);
 }
 
 void rgw_log_usage_finalize()
 {
+  delete ops_logger;
+  ops_logger = NULL;
   delete usage_logger;
   usage_logger = NULL;
 }
@@ -435,15 +547,19 @@ int rgw_log_op(RGWRados *store, RGWREST* const rest, struct req_state *s,
     string oid = render_log_object_name(s->cct->_conf->rgw_log_object_name, &bdt,
 				        s->bucket.bucket_id, entry.bucket);
 
-    rgw_raw_obj obj(store->get_zone_params().log_pool, oid);
+    if (ops_logger) {
+      ops_logger->insert(oid, bl);
+    } else {
+      rgw_raw_obj obj(store->get_zone_params().log_pool, oid);
 
-    ret = store->append_async(obj, bl.length(), bl);
-    if (ret == -ENOENT) {
-      ret = store->create_pool(store->get_zone_params().log_pool);
-      if (ret < 0)
-        goto done;
-      // retry
       ret = store->append_async(obj, bl.length(), bl);
+      if (ret == -ENOENT) {
+        ret = store->create_pool(store->get_zone_params().log_pool);
+        if (ret < 0)
+          goto done;
+        // retry
+        ret = store->append_async(obj, bl.length(), bl);
+      }
     }
   }
 
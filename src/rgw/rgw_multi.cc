@@ -4,7 +4,9 @@
 #include <string.h>
 
 #include <iostream>
+#include <limits>
 #include <map>
+#include <vector>
 
 #include "include/types.h"
 
@@ -173,6 +175,125 @@ int list_multipart_parts(RGWRados *store, RGWBucketInfo& bucket_info, CephContex
   return 0;
 }
 
+#define MULTIPART_LIST_CHUNK 1000
+
+/*
+ * Read the part entries of a v2 upload, whose omap keys sort by part
+ * number, with one omap read per MULTIPART_LIST_CHUNK part numbers, all in
+ * flight at once. Returns -EAGAIN if the entries aren't the contiguous run
+ * 1..N this expects, in which case the caller should list them serially.
+ */
+static int list_sorted_parts_parallel(RGWRados *store, RGWBucketInfo& bucket_info,
+                                      CephContext *cct, string& meta_oid,
+                                      uint32_t max_part_num,
+                                      map<uint32_t, RGWUploadPartInfo>& parts)
+{
+  rgw_obj obj;
+  obj.init_ns(bucket_info.bucket, meta_oid, RGW_OBJ_NS_MULTIPART);
+  obj.set_in_extra_data(true);
+
+  rgw_raw_obj raw_obj;
+  store->obj_to_raw(bucket_info.placement_rule, obj, &raw_obj);
+
+  rgw_rados_ref ref;
+  int ret = store->get_raw_obj_ref(raw_obj, &ref);
+  if (ret < 0) {
+    return ret;
+  }
+
+  uint32_t num_chunks = (max_part_num + MULTIPART_LIST_CHUNK - 1) / MULTIPART_LIST_CHUNK;
+  vector<map<string, bufferlist> > results(num_chunks);
+  vector<int> rvals(num_chunks, 0);
+  bool more = false;
+  vector<librados::AioCompletion *> completions;
+
+  for (uint32_t i = 0; i < num_chunks; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "part.%08d", i * MULTIPART_LIST_CHUNK);
+
+    librados::ObjectReadOperation op;
+    op.omap_get_vals2(buf, MULTIPART_LIST_CHUNK, &results[i],
+                      (i == num_chunks - 1 ? &more : nullptr), &rvals[i]);
+
+    librados::AioCompletion *c = librados::Rados::aio_create_completion(nullptr, nullptr, nullptr);
+    ret = ref.ioctx.aio_operate(ref.oid, c, &op, nullptr);
+    if (ret < 0) {
+      c->release();
+      break;
+    }
+    completions.push_back(c);
+  }
+
+  for (auto c : completions) {
+    c->wait_for_complete();
+    int r = c->get_return_value();
+    c->release();
+    if (r < 0 && ret >= 0) {
+      ret = r;
+    }
+  }
+  if (ret < 0) {
+    return ret;
+  }
+
+  uint32_t expected_next = 1;
+
+  for (uint32_t i = 0; i < num_chunks; i++) {
+    bool last_chunk = (i == num_chunks - 1);
+    for (auto& iter : results[i]) {
+      bufferlist::iterator bli = iter.second.begin();
+      RGWUploadPartInfo info;
+      try {
+        ::decode(info, bli);
+      } catch (buffer::error& err) {
+        ldout(cct, 0) << "ERROR: could not part info, caught buffer::error" << dendl;
+        return -EIO;
+      }
+      if (!last_chunk && info.num > (i + 1) * MULTIPART_LIST_CHUNK) {
+        /* belongs to the next chunk, which fetched it as well */
+        break;
+      }
+      if (info.num != expected_next) {
+        /* a gap, or unsorted keys written by an older gateway */
+        return -EAGAIN;
+      }
+      expected_next++;
+      parts[info.num] = info;
+    }
+  }
+
+  if (more) {
+    /* more parts were uploaded than requested, let the caller see them all */
+    return -EAGAIN;
+  }
+
+  return 0;
+}
+
+int list_all_multipart_parts(RGWRados *store, struct req_state *s,
+                             const string& upload_id, string& meta_oid,
+                             uint32_t max_part_num,
+                             map<uint32_t, RGWUploadPartInfo>& parts)
+{
+  parts.clear();
+
+  if (is_v2_upload_id(upload_id) && max_part_num > 0) {
+    int ret = list_sorted_parts_parallel(store, s->bucket_info, s->cct, meta_oid,
+                                         max_part_num, parts);
+    if (ret != -EAGAIN) {
+      return ret;
+    }
+    ldout(s->cct, 10) << "parallel listing of upload " << upload_id
+                      << " not possible, listing parts serially" << dendl;
+    parts.clear();
+  }
+
+  /* read the whole omap once instead of a page at a time */
+  return list_multipart_parts(store, s->bucket_info, s->cct, upload_id, meta_oid,
+                              std::numeric_limits<int>::max(), 0, parts,
+                              nullptr, nullptr, true);
+}
+
 int list_multipart_parts(RGWRados *store, struct req_state *s,
                                 const string& upload_id,
                                 string& meta_oid, int num_parts,
@@ -95,6 +95,12 @@ extern int list_multipart_parts(RGWRados *store, struct req_state *s,
                                 int *next_marker, bool *truncated,
                                 bool assume_unsorted = false);
 
+/* list every part of an upload, reading them in parallel where possible */
+extern int list_all_multipart_parts(RGWRados *store, struct req_state *s,
+                                    const string& upload_id, string& meta_oid,
+                                    uint32_t max_part_num,
+                                    map<uint32_t, RGWUploadPartInfo>& parts);
+
 extern int abort_multipart_upload(RGWRados *store, CephContext *cct, RGWObjectCtx *obj_ctx,
                                 RGWBucketInfo& bucket_info, RGWMPObj& mp_obj);
 
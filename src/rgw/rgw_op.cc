@@ -1666,7 +1666,11 @@ void RGWGetObj::execute()
     lderr(s->cct) << "ERROR: failed to decode compression info, cannot decompress" << dendl;
     goto done_err;
   }
-  if (need_decompress) {
+  if (need_decompress && skip_decompress) {
+    /* multisite sync: send the stored bytes, the other zone keeps them
+     * compressed along with RGW_ATTR_COMPRESSION */
+    sent_compressed = true;
+  } else if (need_decompress) {
       s->obj_size = cs_info.orig_size;
       decompress.emplace(s->cct, &cs_info, partial_content, filter);
       filter = &*decompress;
@@ -5334,9 +5338,6 @@ void RGWCompleteMultipart::execute()
 
   int total_parts = 0;
   int handled_parts = 0;
-  int max_parts = 1000;
-  int marker = 0;
-  bool truncated;
   RGWCompressionInfo cs_info;
   bool compressed = false;
   uint64_t accounted_size = 0;
@@ -5382,102 +5383,100 @@ void RGWCompleteMultipart::execute()
     return;
   }
 
-  do {
-    op_ret = list_multipart_parts(store, s, upload_id, meta_oid, max_parts,
-				  marker, obj_parts, &marker, &truncated);
-    if (op_ret == -ENOENT) {
-      op_ret = -ERR_NO_SUCH_UPLOAD;
-    }
-    if (op_ret < 0)
+  op_ret = list_all_multipart_parts(store, s, upload_id, meta_oid,
+                                    parts->parts.rbegin()->first, obj_parts);
+  if (op_ret == -ENOENT) {
+    op_ret = -ERR_NO_SUCH_UPLOAD;
+  }
+  if (op_ret < 0)
+    return;
+
+  total_parts = obj_parts.size();
+  if (total_parts != (int)parts->parts.size()) {
+    ldout(s->cct, 0) << "NOTICE: total parts mismatch: have: " << total_parts
+		     << " expected: " << parts->parts.size() << dendl;
+    op_ret = -ERR_INVALID_PART;
+    return;
+  }
+
+  for (obj_iter = obj_parts.begin(); iter != parts->parts.end() && obj_iter != obj_parts.end(); ++iter, ++obj_iter, ++handled_parts) {
+    uint64_t part_size = obj_iter->second.accounted_size;
+    if (handled_parts < (int)parts->parts.size() - 1 &&
+        part_size < min_part_size) {
+      op_ret = -ERR_TOO_SMALL;
       return;
+    }
 
-    total_parts += obj_parts.size();
-    if (!truncated && total_parts != (int)parts->parts.size()) {
-      ldout(s->cct, 0) << "NOTICE: total parts mismatch: have: " << total_parts
-		       << " expected: " << parts->parts.size() << dendl;
+    char petag[CEPH_CRYPTO_MD5_DIGESTSIZE];
+    if (iter->first != (int)obj_iter->first) {
+      ldout(s->cct, 0) << "NOTICE: parts num mismatch: next requested: "
+		       << iter->first << " next uploaded: "
+		       << obj_iter->first << dendl;
+      op_ret = -ERR_INVALID_PART;
+      return;
+    }
+    string part_etag = rgw_string_unquote(iter->second);
+    if (part_etag.compare(obj_iter->second.etag) != 0) {
+      ldout(s->cct, 0) << "NOTICE: etag mismatch: part: " << iter->first
+		       << " etag: " << iter->second << dendl;
       op_ret = -ERR_INVALID_PART;
       return;
     }
 
-    for (obj_iter = obj_parts.begin(); iter != parts->parts.end() && obj_iter != obj_parts.end(); ++iter, ++obj_iter, ++handled_parts) {
-      uint64_t part_size = obj_iter->second.accounted_size;
-      if (handled_parts < (int)parts->parts.size() - 1 &&
-          part_size < min_part_size) {
-        op_ret = -ERR_TOO_SMALL;
-        return;
-      }
-
-      char petag[CEPH_CRYPTO_MD5_DIGESTSIZE];
-      if (iter->first != (int)obj_iter->first) {
-        ldout(s->cct, 0) << "NOTICE: parts num mismatch: next requested: "
-			 << iter->first << " next uploaded: "
-			 << obj_iter->first << dendl;
-        op_ret = -ERR_INVALID_PART;
-        return;
-      }
-      string part_etag = rgw_string_unquote(iter->second);
-      if (part_etag.compare(obj_iter->second.etag) != 0) {
-        ldout(s->cct, 0) << "NOTICE: etag mismatch: part: " << iter->first
-			 << " etag: " << iter->second << dendl;
-        op_ret = -ERR_INVALID_PART;
-        return;
-      }
+    hex_to_buf(obj_iter->second.etag.c_str(), petag,
+	      CEPH_CRYPTO_MD5_DIGESTSIZE);
+    hash.Update((const byte *)petag, sizeof(petag));
 
-      hex_to_buf(obj_iter->second.etag.c_str(), petag,
-		CEPH_CRYPTO_MD5_DIGESTSIZE);
-      hash.Update((const byte *)petag, sizeof(petag));
+    RGWUploadPartInfo& obj_part = obj_iter->second;
 
-      RGWUploadPartInfo& obj_part = obj_iter->second;
+    /* update manifest for part */
+    string oid = mp.get_part(obj_iter->second.num);
+    rgw_obj src_obj;
+    src_obj.init_ns(s->bucket, oid, mp_ns);
 
-      /* update manifest for part */
-      string oid = mp.get_part(obj_iter->second.num);
-      rgw_obj src_obj;
-      src_obj.init_ns(s->bucket, oid, mp_ns);
+    if (obj_part.manifest.empty()) {
+      ldout(s->cct, 0) << "ERROR: empty manifest for object part: obj="
+		       << src_obj << dendl;
+      op_ret = -ERR_INVALID_PART;
+      return;
+    } else {
+      manifest.append(obj_part.manifest, store);
+    }
 
-      if (obj_part.manifest.empty()) {
-        ldout(s->cct, 0) << "ERROR: empty manifest for object part: obj="
-			 << src_obj << dendl;
+    if (obj_part.cs_info.compression_type != "none") {
+      if (compressed && cs_info.compression_type != obj_part.cs_info.compression_type) {
+        ldout(s->cct, 0) << "ERROR: compression type was changed during multipart upload ("
+                         << cs_info.compression_type << ">>" << obj_part.cs_info.compression_type << ")" << dendl;
         op_ret = -ERR_INVALID_PART;
         return;
-      } else {
-        manifest.append(obj_part.manifest, store);
       }
-
-      if (obj_part.cs_info.compression_type != "none") {
-        if (compressed && cs_info.compression_type != obj_part.cs_info.compression_type) {
-          ldout(s->cct, 0) << "ERROR: compression type was changed during multipart upload ("
-                           << cs_info.compression_type << ">>" << obj_part.cs_info.compression_type << ")" << dendl;
-          op_ret = -ERR_INVALID_PART;
-          return;
-        }
-        int64_t new_ofs; // offset in compression data for new part
-        if (cs_info.blocks.size() > 0)
-          new_ofs = cs_info.blocks.back().new_ofs + cs_info.blocks.back().len;
-        else
-          new_ofs = 0;
-        for (const auto& block : obj_part.cs_info.blocks) {
-          compression_block cb;
-          cb.old_ofs = block.old_ofs + cs_info.orig_size;
-          cb.new_ofs = new_ofs;
-          cb.len = block.len;
-          cs_info.blocks.push_back(cb);
-          new_ofs = cb.new_ofs + cb.len;
-        } 
-        if (!compressed)
-          cs_info.compression_type = obj_part.cs_info.compression_type;
-        cs_info.orig_size += obj_part.cs_info.orig_size;
-        compressed = true;
-      }
-
-      rgw_obj_index_key remove_key;
-      src_obj.key.get_index_key(&remove_key);
-
-      remove_objs.push_back(remove_key);
-
-      ofs += obj_part.size;
-      accounted_size += obj_part.accounted_size;
-    }
-  } while (truncated);
+      int64_t new_ofs; // offset in compression data for new part
+      if (cs_info.blocks.size() > 0)
+        new_ofs = cs_info.blocks.back().new_ofs + cs_info.blocks.back().len;
+      else
+        new_ofs = 0;
+      for (const auto& block : obj_part.cs_info.blocks) {
+        compression_block cb;
+        cb.old_ofs = block.old_ofs + cs_info.orig_size;
+        cb.new_ofs = new_ofs;
+        cb.len = block.len;
+        cs_info.blocks.push_back(cb);
+        new_ofs = cb.new_ofs + cb.len;
+      } 
+      if (!compressed)
+        cs_info.compression_type = obj_part.cs_info.compression_type;
+      cs_info.orig_size += obj_part.cs_info.orig_size;
+      compressed = true;
+    }
+
+    rgw_obj_index_key remove_key;
+    src_obj.key.get_index_key(&remove_key);
+
+    remove_objs.push_back(remove_key);
+
+    ofs += obj_part.size;
+    accounted_size += obj_part.accounted_size;
+  }
   hash.Final((byte *)final_etag);
 
   buf_to_hex((unsigned char *)final_etag, sizeof(final_etag), final_etag_str);
@@ -5733,6 +5732,7 @@ void RGWDeleteMultiObj::execute()
   RGWMultiDelXMLParser parser;
   int num_processed = 0;
   RGWObjectCtx *obj_ctx = static_cast<RGWObjectCtx *>(s->obj_ctx);
+  RGWIndexCompleteBatch index_batch(store);
 
   op_ret = get_params();
   if (op_ret < 0) {
@@ -5794,6 +5794,7 @@ void RGWDeleteMultiObj::execute()
     del_op.params.bucket_owner = s->bucket_owner.get_id();
     del_op.params.versioning_status = s->bucket_info.versioning_status();
     del_op.params.obj_owner = s->owner;
+    del_op.params.index_batch = &index_batch;
 
     op_ret = del_op.delete_obj();
     if (op_ret == -ENOENT) {
@@ -5804,6 +5805,9 @@ void RGWDeleteMultiObj::execute()
 			  del_op.result.version_id, op_ret);
   }
 
+  /* apply the index updates of all the deletes, one call per index shard */
+  index_batch.flush();
+
   /*  set the return code to zero, errors at this point will be
   dumped to the response */
   op_ret = 0;
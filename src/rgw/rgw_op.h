@@ -206,6 +206,8 @@ protected:
   bool range_parsed;
   bool skip_manifest;
   bool skip_decrypt{false};
+  bool skip_decompress{false};
+  bool sent_compressed{false}; /* data went out in its stored, compressed form */
   rgw_obj obj;
   utime_t gc_invalidate_time;
   bool is_slo;
@@ -27,6 +27,7 @@
 #include "rgw_user.h"
 
 #include <atomic>
+#include <memory>
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_rgw
@@ -38,11 +39,55 @@ struct RGWQuotaCacheStats {
   utime_t async_refresh_time;
 };
 
+#define RGW_QUOTA_CACHE_SHARDS 16
+
+static inline size_t quota_cache_hash(const rgw_bucket& bucket)
+{
+  return std::hash<string>()(bucket.bucket_id) ^ std::hash<string>()(bucket.name);
+}
+
+static inline size_t quota_cache_hash(const rgw_user& user)
+{
+  return std::hash<string>()(user.id) ^ std::hash<string>()(user.tenant);
+}
+
+/*
+ * lru_map split into shards by key hash, so that every request checking or
+ * adjusting quota stats doesn't contend on a single lock
+ */
+template<class T>
+class RGWQuotaStatsMap {
+  using map_t = lru_map<T, RGWQuotaCacheStats>;
+  std::vector<std::unique_ptr<map_t>> shards;
+
+  map_t& shard(const T& key) {
+    return *shards[quota_cache_hash(key) % shards.size()];
+  }
+public:
+  explicit RGWQuotaStatsMap(int size) {
+    int shard_size = std::max(1, (size + RGW_QUOTA_CACHE_SHARDS - 1) / RGW_QUOTA_CACHE_SHARDS);
+    for (int i = 0; i < RGW_QUOTA_CACHE_SHARDS; i++) {
+      shards.emplace_back(new map_t(shard_size));
+    }
+  }
+
+  bool find(const T& key, RGWQuotaCacheStats& value) {
+    return shard(key).find(key, value);
+  }
+  bool find_and_update(const T& key, RGWQuotaCacheStats *value,
+                       typename map_t::UpdateContext *ctx) {
+    return shard(key).find_and_update(key, value, ctx);
+  }
+  void add(const T& key, RGWQuotaCacheStats& value) {
+    shard(key).add(key, value);
+  }
+};
+
 template<class T>
 class RGWQuotaCache {
 protected:
   RGWRados *store;
-  lru_map<T, RGWQuotaCacheStats> stats_map;
+  RGWQuotaStatsMap<T> stats_map;
   RefCountedWaitObject *async_refcount;
 
   class StatsAsyncTestSet : public lru_map<T, RGWQuotaCacheStats>::UpdateContext {
@@ -61,6 +106,15 @@ protected:
     }
   };
 
+  /* let the next request retry a refresh that failed */
+  class StatsAsyncRearm : public lru_map<T, RGWQuotaCacheStats>::UpdateContext {
+  public:
+    bool update(RGWQuotaCacheStats *entry) override {
+      entry->async_refresh_time = ceph_clock_now();
+      return true;
+    }
+  };
+
   virtual int fetch_stats_from_storage(const rgw_user& user, const rgw_bucket& bucket, RGWStorageStats& stats) = 0;
 
   virtual bool map_find(const rgw_user& user, const rgw_bucket& bucket, RGWQuotaCacheStats& qs) = 0;
@@ -162,6 +216,9 @@ void RGWQuotaCache<T>::async_refresh_fail(const rgw_user& user, rgw_bucket& buck
 {
   ldout(store->ctx(), 20) << "async stats refresh response for bucket=" << bucket << dendl;
 
+  StatsAsyncRearm rearm;
+  map_find_and_update(user, bucket, &rearm);
+
   async_refcount->put();
 }
 
@@ -205,10 +262,16 @@ int RGWQuotaCache<T>::get_stats(const rgw_user& user, const rgw_bucket& bucket,
       }
     }
 
-    if (can_use_cached_stats(quota, qs.stats) && qs.expiration >
-	ceph_clock_now()) {
-      stats = qs.stats;
-      return 0;
+    if (can_use_cached_stats(quota, qs.stats)) {
+      /* past expiration, keep serving the cached stats for a grace period
+       * while the async refresh above replaces them, rather than stalling
+       * this request on a synchronous fetch */
+      utime_t stale_limit = qs.expiration;
+      stale_limit += store->ctx()->_conf->rgw_bucket_quota_stale_grace;
+      if (qs.expiration > now || stale_limit > now) {
+        stats = qs.stats;
+        return 0;
+      }
     }
   }
 
@@ -5530,6 +5530,15 @@ int RGWRados::Bucket::List::list_objects(int64_t max,
 
   string bigger_than_delim;
 
+  /* let the index fold common prefixes itself, unless a filter has to see
+   * every entry or the delimiter could match the '_' namespace and escape
+   * characters of raw index names */
+  string cls_delim;
+  if (!params.delim.empty() && !params.filter &&
+      params.delim.find('_') == string::npos) {
+    cls_delim = params.delim;
+  }
+
   if (!params.delim.empty()) {
     unsigned long val = decode_utf8((unsigned char *)params.delim.c_str(), params.delim.size());
     char buf[params.delim.size() + 16];
@@ -5559,8 +5568,8 @@ int RGWRados::Bucket::List::list_objects(int64_t max,
     }
     std::map<string, rgw_bucket_dir_entry> ent_map;
     int r = store->cls_bucket_list(target->get_bucket_info(), shard_id, cur_marker, cur_prefix,
-                                   read_ahead + 1 - count, params.list_versions, ent_map,
-                                   &truncated, &cur_marker);
+                                   cls_delim, read_ahead + 1 - count, params.list_versions, ent_map,
+                                   &truncated, &cur_marker, NULL, params.max_mtime);
     if (r < 0)
       return r;
 
@@ -7191,6 +7200,8 @@ class RGWRadosPutObj : public RGWGetDataCB
   bufferlist extra_data_bl;
   uint64_t extra_data_left;
   uint64_t data_len;
+  uint64_t accounted_len{0};
+  bool passthrough_compressed{false};
   map<string, bufferlist> src_attrs;
 public:
   RGWRadosPutObj(CephContext* cct,
@@ -7221,11 +7232,28 @@ public:
 
       JSONDecoder::decode_json("attrs", src_attrs, &jp);
 
-      src_attrs.erase(RGW_ATTR_COMPRESSION);
+      bool compressed = false;
+      JSONDecoder::decode_json("compressed", compressed, &jp);
+      if (compressed) {
+        /* the payload arrives as the source stored it; write it as is and
+         * keep the compression info that describes it */
+        bool need_decompress;
+        RGWCompressionInfo cs_info;
+        int r = rgw_compression_info_from_attrset(src_attrs, need_decompress, cs_info);
+        if (r < 0 || !need_decompress) {
+          ldout(cct, 0) << "ERROR: source sent compressed data without valid compression info" << dendl;
+          return -EIO;
+        }
+        passthrough_compressed = true;
+        accounted_len = cs_info.orig_size;
+      } else {
+        src_attrs.erase(RGW_ATTR_COMPRESSION);
+      }
       src_attrs.erase(RGW_ATTR_MANIFEST); // not interested in original object layout
     }
 
-    if (plugin && src_attrs.find(RGW_ATTR_CRYPT_MODE) == src_attrs.end()) {
+    if (plugin && !passthrough_compressed &&
+        src_attrs.find(RGW_ATTR_CRYPT_MODE) == src_attrs.end()) {
       //do not compress if object is encrypted
       compressor = boost::in_place(cct, plugin, filter);
       filter = &*compressor;
@@ -7315,7 +7343,9 @@ public:
 
   int complete(const string& etag, real_time *mtime, real_time set_mtime,
                map<string, bufferlist>& attrs, real_time delete_at, rgw_zone_set *zones_trace) {
-    return processor->complete(data_len, etag, mtime, set_mtime, attrs, delete_at, NULL, NULL, NULL, zones_trace);
+    /* a compressed payload accounts for its original size */
+    uint64_t size = (passthrough_compressed ? accounted_len : data_len);
+    return processor->complete(size, etag, mtime, set_mtime, attrs, delete_at, NULL, NULL, NULL, zones_trace);
   }
 
   bool is_canceled() {
@@ -7538,10 +7568,12 @@ int RGWRados::stat_remote_obj(RGWObjectCtx& obj_ctx,
   constexpr bool rgwx_stat = true;
   constexpr bool sync_manifest = true;
   constexpr bool skip_decrypt = true;
+  constexpr bool skip_decompress = false;
   int ret = conn->get_obj(user_id, info, src_obj, pmod, unmod_ptr,
                       dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver,
                       prepend_meta, get_op, rgwx_stat,
-                      sync_manifest, skip_decrypt, &cb, &in_stream_req);
+                      sync_manifest, skip_decrypt, skip_decompress,
+                      &cb, &in_stream_req);
   if (ret < 0) {
     return ret;
   }
@@ -7714,10 +7746,16 @@ int RGWRados::fetch_remote_obj(RGWObjectCtx& obj_ctx,
   static constexpr bool rgwx_stat = false;
   static constexpr bool sync_manifest = true;
   static constexpr bool skip_decrypt = true;
+  /* when this zone compresses too, take compressed objects from another
+   * zone as they are stored instead of inflating and recompressing them;
+   * copies from another zonegroup may rewrite attrs, so they don't */
+  const bool skip_decompress = !source_zone.empty() && plugin &&
+                               cct->_conf->rgw_sync_fetch_compressed;
   ret = conn->get_obj(user_id, info, src_obj, pmod, unmod_ptr,
                       dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver,
                       prepend_meta, get_op, rgwx_stat,
-                      sync_manifest, skip_decrypt, &cb, &in_stream_req);
+                      sync_manifest, skip_decrypt, skip_decompress,
+                      &cb, &in_stream_req);
   if (ret < 0) {
     goto set_err_state;
   }
@@ -8287,7 +8325,7 @@ int RGWRados::check_bucket_empty(RGWBucketInfo& bucket_info)
 
   do {
 #define NUM_ENTRIES 1000
-    int r = cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, NUM_ENTRIES, true, ent_map,
+    int r = cls_bucket_list(bucket_info, RGW_NO_SHARD, marker, prefix, string(), NUM_ENTRIES, true, ent_map,
                         &is_truncated, &marker);
     if (r < 0)
       return r;
@@ -8838,6 +8876,7 @@ int RGWRados::Object::Delete::delete_obj()
   
   index_op.set_zones_trace(params.zones_trace);
   index_op.set_bilog_flags(params.bilog_flags);
+  index_op.set_complete_batch(params.index_batch);
 
   r = index_op.prepare(CLS_RGW_OP_DEL, &state->write_tag);
   if (r < 0)
@@ -8892,7 +8931,8 @@ int RGWRados::delete_obj(RGWObjectCtx& obj_ctx,
                          int versioning_status,
                          uint16_t bilog_flags,
                          const real_time& expiration_time,
-                         rgw_zone_set *zones_trace)
+                         rgw_zone_set *zones_trace,
+                         RGWIndexCompleteBatch *index_batch)
 {
   RGWRados::Object del_target(this, bucket_info, obj_ctx, obj);
   RGWRados::Object::Delete del_op(&del_target);
@@ -8902,6 +8942,7 @@ int RGWRados::delete_obj(RGWObjectCtx& obj_ctx,
   del_op.params.bilog_flags = bilog_flags;
   del_op.params.expiration_time = expiration_time;
   del_op.params.zones_trace = zones_trace;
+  del_op.params.index_batch = index_batch;
 
   return del_op.delete_obj();
 }
@@ -10019,7 +10060,12 @@ int RGWRados::Bucket::UpdateIndex::complete_del(int64_t poolid, uint64_t epoch,
     return ret;
   }
 
-  ret = store->cls_obj_complete_del(*bs, optag, poolid, epoch, obj, removed_mtime, remove_objs, bilog_flags, zones_trace);
+  if (complete_batch) {
+    complete_batch->add_del(*bs, optag, poolid, epoch, obj, removed_mtime, remove_objs, bilog_flags, zones_trace);
+    ret = 0;
+  } else {
+    ret = store->cls_obj_complete_del(*bs, optag, poolid, epoch, obj, removed_mtime, remove_objs, bilog_flags, zones_trace);
+  }
 
   if (target->bucket_info.datasync_flag_enabled()) {
     int r = store->data_log->add_entry(bs->bucket, bs->shard_id);
@@ -10266,6 +10312,7 @@ struct get_obj_data : public RefCountedObject {
   std::atomic<bool> cancelled = { false };
   std::atomic<int64_t> err_code = { 0 };
   Throttle throttle;
+  int64_t max_window;
   list<bufferlist> read_list;
 
   explicit get_obj_data(CephContext *_cct)
@@ -10273,7 +10320,8 @@ struct get_obj_data : public RefCountedObject {
       rados(NULL), ctx(NULL),
       total_read(0), lock("get_obj_data"), data_lock("get_obj_data::data_lock"),
       client_cb(NULL),
-      throttle(cct, "get_obj_data", cct->_conf->rgw_get_obj_window_size, false) {}
+      throttle(cct, "get_obj_data", cct->_conf->rgw_get_obj_window_size, false),
+      max_window(cct->_conf->rgw_get_obj_max_window_size) {}
   ~get_obj_data() override { } 
   void set_cancelled(int r) {
     cancelled = true;
@@ -10288,6 +10336,27 @@ struct get_obj_data : public RefCountedObject {
     return err_code;
   }
 
+  /* returns a larger window size if a read of len bytes would have to wait
+   * for the current window while the client has already drained everything
+   * that completed, i.e. when we are waiting on the osds rather than on the
+   * client; 0 keeps the current window */
+  int64_t next_window(off_t len) {
+    int64_t cur_max = throttle.get_max();
+    if (cur_max >= max_window ||
+        throttle.get_current() + len <= cur_max) {
+      return 0;
+    }
+    {
+      Mutex::Locker l(data_lock);
+      if (!read_list.empty()) {
+        return 0;
+      }
+    }
+    int64_t new_max = std::min(cur_max * 2, max_window);
+    ldout(cct, 20) << "get_obj_data: growing window to " << new_max << dendl;
+    return new_max;
+  }
+
   int wait_next_io(bool *done) {
     lock.Lock();
     map<off_t, librados::AioCompletion *>::iterator iter = completion_map.begin();
@@ -10553,7 +10622,13 @@ int RGWRados::get_obj_iterate_cb(RGWObjectCtx *ctx, RGWObjState *astate,
     }
   }
 
-  d->throttle.get(len);
+  // hand whatever already completed to the client before we possibly wait
+  // for the window, so the stream keeps moving while the reads are in flight
+  r = flush_read_list(d);
+  if (r < 0)
+    return r;
+
+  d->throttle.get(len, d->next_window(len));
   if (d->is_cancelled()) {
     return d->get_err_code();
   }
@@ -11490,6 +11565,13 @@ int RGWRados::follow_olh(const RGWBucketInfo& bucket_info, RGWObjectCtx& obj_ctx
   return 0;
 }
 
+/*
+ * stat, xattrs and (with @first_chunk) the head's data all come back from a
+ * single compound op. With prefetch_data set, that is what makes a GET of an
+ * object that fits in its head cost one osd op: get_obj_iterate_cb() and
+ * Object::Read::read() serve the data from the state instead of reading it
+ * again.
+ */
 int RGWRados::raw_obj_stat(rgw_raw_obj& obj, uint64_t *psize, real_time *pmtime, uint64_t *epoch,
                            map<string, bufferlist> *attrs, bufferlist *first_chunk,
                            RGWObjVersionTracker *objv_tracker)
@@ -12691,6 +12773,95 @@ int RGWRados::cls_obj_complete_del(BucketShard& bs, string& tag,
   return cls_obj_complete_op(bs, obj, CLS_RGW_OP_DEL, tag, pool, epoch, ent, RGW_OBJ_CATEGORY_NONE, remove_objs, bilog_flags, zones_trace);
 }
 
+void RGWIndexCompleteBatch::add_del(RGWRados::BucketShard& bs, const string& tag,
+                                    int64_t pool, uint64_t epoch,
+                                    const rgw_obj& obj,
+                                    const real_time& removed_mtime,
+                                    list<rgw_obj_index_key> *remove_objs,
+                                    uint16_t bilog_flags,
+                                    rgw_zone_set *zones_trace)
+{
+  auto iter = shards.find(bs.bucket_obj);
+  if (iter == shards.end()) {
+    iter = shards.emplace(bs.bucket_obj, ShardOps(bs)).first;
+  }
+
+  PendingOp op;
+  op.obj = obj;
+  op.tag = tag;
+  op.pool = pool;
+  op.epoch = epoch;
+  op.ent.meta.mtime = removed_mtime;
+  obj.key.get_index_key(&op.ent.key);
+  if (remove_objs) {
+    op.remove_objs = *remove_objs;
+  }
+  op.bilog_flags = bilog_flags;
+  if (zones_trace) {
+    op.zones_trace = *zones_trace;
+  }
+  iter->second.ops.push_back(std::move(op));
+}
+
+int RGWIndexCompleteBatch::flush_shard(ShardOps& shard)
+{
+  list<rgw_cls_obj_complete_op> ops;
+  for (auto& pending : shard.ops) {
+    rgw_cls_obj_complete_op op;
+    op.op = CLS_RGW_OP_DEL;
+    op.key = cls_rgw_obj_key(pending.ent.key.name, pending.ent.key.instance);
+    op.tag = pending.tag;
+    op.ver.pool = pending.pool;
+    op.ver.epoch = pending.epoch;
+    op.meta = pending.ent.meta;
+    op.meta.category = RGW_OBJ_CATEGORY_NONE;
+    op.log_op = store->get_zone().log_data;
+    op.bilog_flags = pending.bilog_flags;
+    op.remove_objs = pending.remove_objs;
+    op.zones_trace = pending.zones_trace;
+    ops.push_back(std::move(op));
+  }
+
+  ObjectWriteOperation o;
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_bucket_complete_op_batch(o, ops);
+  int r = shard.bs.index_ctx.operate(shard.bs.bucket_obj, &o);
+  if (r >= 0) {
+    return 0;
+  }
+
+  /* hand the ops to the regular completion path, which knows how to wait
+   * out a reshard and retry */
+  ldout(store->ctx(), 5) << "batched index completion on " << shard.bs.bucket_obj
+                         << " failed, r=" << r << ", completing "
+                         << shard.ops.size() << " ops one by one" << dendl;
+  int ret = 0;
+  for (auto& pending : shard.ops) {
+    r = store->cls_obj_complete_op(shard.bs, pending.obj, CLS_RGW_OP_DEL,
+                                   pending.tag, pending.pool, pending.epoch,
+                                   pending.ent, RGW_OBJ_CATEGORY_NONE,
+                                   &pending.remove_objs, pending.bilog_flags,
+                                   &pending.zones_trace);
+    if (r < 0 && ret == 0) {
+      ret = r;
+    }
+  }
+  return ret;
+}
+
+int RGWIndexCompleteBatch::flush()
+{
+  int ret = 0;
+  for (auto& iter : shards) {
+    int r = flush_shard(iter.second);
+    if (r < 0 && ret == 0) {
+      ret = r;
+    }
+  }
+  shards.clear();
+  return ret;
+}
+
 int RGWRados::cls_obj_complete_cancel(BucketShard& bs, string& tag, rgw_obj& obj, uint16_t bilog_flags, rgw_zone_set *zones_trace)
 {
   rgw_bucket_dir_entry ent;
@@ -12709,10 +12880,14 @@ int RGWRados::cls_obj_set_bucket_tag_timeout(RGWBucketInfo& bucket_info, uint64_
   return CLSRGWIssueSetTagTimeout(index_ctx, bucket_objs, cct->_conf->rgw_bucket_index_max_aio, timeout)();
 }
 
+/* smallest number of entries asked of each shard of a sharded bucket index */
+static const uint32_t RGW_BUCKET_LIST_MIN_SHARD_WINDOW = 8;
+
 int RGWRados::cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_index_key& start, const string& prefix,
-		              uint32_t num_entries, bool list_versions, map<string, rgw_bucket_dir_entry>& m,
+		              const string& delimiter, uint32_t num_entries, bool list_versions, map<string, rgw_bucket_dir_entry>& m,
 			      bool *is_truncated, rgw_obj_index_key *last_entry,
-			      bool (*force_check_filter)(const string&  name))
+			      bool (*force_check_filter)(const string&  name),
+			      const ceph::real_time& max_mtime)
 {
   ldout(cct, 10) << "cls_bucket_list " << bucket_info.bucket << " start " << start.name << "[" << start.instance << "] num_entries " << num_entries << dendl;
 
@@ -12725,32 +12900,109 @@ int RGWRados::cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_
   if (r < 0)
     return r;
 
+  // Ask each shard for roughly its share of the page rather than the whole
+  // page: with many shards that is most of what gets read and thrown away.
+  // A shard that runs dry while it still has entries is refilled on its own
+  // with a doubled window.
+  uint32_t window = num_entries;
+  if (oids.size() > 1) {
+    window = std::min<uint32_t>(
+      num_entries,
+      std::max<uint32_t>(RGW_BUCKET_LIST_MIN_SHARD_WINDOW,
+                         num_entries * 2 / oids.size() + 1));
+  }
+
   cls_rgw_obj_key start_key(start.name, start.instance);
-  r = CLSRGWIssueBucketList(index_ctx, start_key, prefix, num_entries, list_versions,
-                            oids, list_results, cct->_conf->rgw_bucket_index_max_aio)();
+  r = CLSRGWIssueBucketList(index_ctx, start_key, prefix, delimiter, window, list_versions,
+                            oids, list_results, cct->_conf->rgw_bucket_index_max_aio,
+                            max_mtime)();
   if (r < 0)
     return r;
 
-  // Create a list of iterators that are used to iterate each shard
-  vector<map<string, struct rgw_bucket_dir_entry>::iterator> vcurrents(list_results.size());
-  vector<map<string, struct rgw_bucket_dir_entry>::iterator> vends(list_results.size());
-  vector<string> vnames(list_results.size());
-  map<int, struct rgw_cls_list_ret>::iterator iter = list_results.begin();
-  *is_truncated = false;
-  for (; iter != list_results.end(); ++iter) {
-    vcurrents.push_back(iter->second.dir.m.begin());
-    vends.push_back(iter->second.dir.m.end());
-    vnames.push_back(oids[iter->first]);
-    *is_truncated = (*is_truncated || iter->second.is_truncated);
-  }
+  struct ShardListState {
+    int shard_id;
+    string oid;
+    rgw_cls_list_ret result;
+    map<string, struct rgw_bucket_dir_entry>::iterator cur;
+    cls_rgw_obj_key next_start;
+    uint32_t window;
+
+    void reset(rgw_cls_list_ret&& r) {
+      result = std::move(r);
+      cur = result.dir.m.begin();
+      if (!result.marker.empty()) {
+        // the shard says how far it scanned, past any entries it skipped
+        next_start = result.marker;
+      } else if (!result.dir.m.empty()) {
+        // resume after the last entry, or past everything under a prefix
+        rgw_bucket_dir_entry& last = result.dir.m.rbegin()->second;
+        next_start = last.key;
+        if (last.is_common_prefix()) {
+          next_start.name.append(1, (char)0xFF);
+        }
+      }
+    }
+  };
+  vector<ShardListState> shards(list_results.size());
+  size_t n = 0;
+  for (auto& iter : list_results) {
+    ShardListState& shard = shards[n++];
+    shard.shard_id = iter.first;
+    shard.oid = oids[iter.first];
+    shard.window = window;
+    shard.reset(std::move(iter.second));
+  }
+
+  // Refill an exhausted shard that still has more entries.  Returns 1 if
+  // the shard has a next entry, 0 if it is done.  With max_mtime a shard
+  // may come back empty but truncated, so keep going from its marker.
+  auto refill = [&](ShardListState& shard) -> int {
+    while (shard.cur == shard.result.dir.m.end()) {
+      if (!shard.result.is_truncated ||
+          (shard.result.dir.m.empty() && shard.result.marker.empty())) {
+        return 0;
+      }
 
-  // Create a map to track the next candidate entry from each shard, if the entry
-  // from a specified shard is selected/erased, the next entry from that shard will
-  // be inserted for next round selection
+      shard.window = std::min(shard.window * 2, num_entries);
+      ldout(cct, 20) << "cls_bucket_list refilling " << shard.oid << " from "
+                     << shard.next_start.name << " window " << shard.window
+                     << dendl;
+
+      map<int, string> shard_oids{{shard.shard_id, shard.oid}};
+      map<int, struct rgw_cls_list_ret> shard_results;
+      int ret = CLSRGWIssueBucketList(index_ctx, shard.next_start, prefix,
+                                      delimiter, shard.window, list_versions,
+                                      shard_oids, shard_results, 1,
+                                      max_mtime)();
+      if (ret < 0) {
+        return ret;
+      }
+      shard.reset(std::move(shard_results[shard.shard_id]));
+    }
+    return 1;
+  };
+
+  // k-way merge: candidates holds the next entry of every shard that has
+  // one, so its first element is the next entry overall
   map<string, size_t> candidates;
-  for (size_t i = 0; i < vcurrents.size(); ++i) {
-    if (vcurrents[i] != vends[i]) {
-      candidates[vcurrents[i]->first] = i;
+  auto add_candidate = [&](size_t pos) -> int {
+    ShardListState& shard = shards[pos];
+    while (true) {
+      int ret = refill(shard);
+      if (ret <= 0) {
+        return ret;
+      }
+      // the same common prefix may come back from several shards; keep one
+      if (candidates.emplace(shard.cur->first, pos).second) {
+        return 0;
+      }
+      ++shard.cur;
+    }
+  };
+  for (size_t i = 0; i < shards.size(); ++i) {
+    r = add_candidate(i);
+    if (r < 0) {
+      return r;
     }
   }
 
@@ -12760,19 +13012,22 @@ int RGWRados::cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_
     r = 0;
     // Select the next one
     int pos = candidates.begin()->second;
-    const string& name = vcurrents[pos]->first;
-    struct rgw_bucket_dir_entry& dirent = vcurrents[pos]->second;
+    ShardListState& shard = shards[pos];
+    const string& name = shard.cur->first;
+    struct rgw_bucket_dir_entry& dirent = shard.cur->second;
 
     bool force_check = force_check_filter &&
         force_check_filter(dirent.key.name);
-    if ((!dirent.exists && !dirent.is_delete_marker()) ||
+    if (dirent.is_common_prefix()) {
+      // nothing on disk to check
+    } else if ((!dirent.exists && !dirent.is_delete_marker()) ||
         !dirent.pending_map.empty() ||
         force_check) {
       /* there are uncommitted ops. We need to check the current state,
        * and if the tags are old we need to do cleanup as well. */
       librados::IoCtx sub_ctx;
       sub_ctx.dup(index_ctx);
-      r = check_disk_state(sub_ctx, bucket_info, dirent, dirent, updates[vnames[pos]]);
+      r = check_disk_state(sub_ctx, bucket_info, dirent, dirent, updates[shard.oid]);
       if (r < 0 && r != -ENOENT) {
           return r;
       }
@@ -12783,11 +13038,15 @@ int RGWRados::cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_
       ++count;
     }
 
-    // Refresh the candidates map
+    // Refresh the candidates map; only a shard that was just consumed from
+    // can need another round trip
     candidates.erase(candidates.begin());
-    ++vcurrents[pos];
-    if (vcurrents[pos] != vends[pos]) {
-      candidates[vcurrents[pos]->first] = pos;
+    ++shard.cur;
+    if (count < num_entries) {
+      r = add_candidate(pos);
+      if (r < 0) {
+        return r;
+      }
     }
   }
 
@@ -12805,12 +13064,19 @@ int RGWRados::cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_
   }
 
   // Check if all the returned entries are consumed or not
-  for (size_t i = 0; i < vcurrents.size(); ++i) {
-    if (vcurrents[i] != vends[i])
+  *is_truncated = false;
+  for (auto& shard : shards) {
+    if (shard.cur != shard.result.dir.m.end() || shard.result.is_truncated) {
       *is_truncated = true;
+    }
   }
-  if (!m.empty())
+  if (!m.empty()) {
     *last_entry = m.rbegin()->first;
+    if (m.rbegin()->second.is_common_prefix()) {
+      // resume past everything under the prefix
+      last_entry->name.append(1, (char)0xFF);
+    }
+  }
 
   return 0;
 }
@@ -2214,6 +2214,7 @@ struct tombstone_entry {
 };
 
 class RGWIndexCompletionManager;
+class RGWIndexCompleteBatch;
 
 class RGWRados
 {
@@ -2861,8 +2862,9 @@ public:
         ceph::real_time mtime; /* for setting delete marker mtime */
         bool high_precision_time;
         rgw_zone_set *zones_trace;
+        RGWIndexCompleteBatch *index_batch; /* defer the index completion to this batch */
 
-        DeleteParams() : versioning_status(0), olh_epoch(0), bilog_flags(0), remove_objs(NULL), high_precision_time(false), zones_trace(nullptr) {}
+        DeleteParams() : versioning_status(0), olh_epoch(0), bilog_flags(0), remove_objs(NULL), high_precision_time(false), zones_trace(nullptr), index_batch(nullptr) {}
       } params;
 
       struct DeleteResult {
@@ -2940,6 +2942,7 @@ public:
       bool blind;
       bool prepared{false};
       rgw_zone_set *zones_trace{nullptr};
+      RGWIndexCompleteBatch *complete_batch{nullptr};
 
       int init_bs() {
         int r = bs.init(target->get_bucket(), obj);
@@ -2981,6 +2984,10 @@ public:
         zones_trace = _zones_trace;
       }
 
+      void set_complete_batch(RGWIndexCompleteBatch *batch) {
+        complete_batch = batch;
+      }
+
       int prepare(RGWModifyOp, const string *write_tag);
       int complete(int64_t poolid, uint64_t epoch, uint64_t size,
                    uint64_t accounted_size, ceph::real_time& ut,
@@ -3010,6 +3017,7 @@ public:
         bool enforce_ns;
         RGWAccessListFilter *filter;
         bool list_versions;
+        ceph::real_time max_mtime; // if set, the index skips newer entries
 
         Params() : enforce_ns(true), filter(NULL), list_versions(false) {}
       } params;
@@ -3225,7 +3233,8 @@ public:
                          int versioning_status,
                          uint16_t bilog_flags = 0,
                          const ceph::real_time& expiration_time = ceph::real_time(),
-                         rgw_zone_set *zones_trace = nullptr);
+                         rgw_zone_set *zones_trace = nullptr,
+                         RGWIndexCompleteBatch *index_batch = nullptr);
 
   /** Delete a raw object.*/
   int delete_raw_obj(const rgw_raw_obj& obj);
@@ -3428,9 +3437,10 @@ public:
   int cls_obj_complete_cancel(BucketShard& bs, string& tag, rgw_obj& obj, uint16_t bilog_flags, rgw_zone_set *zones_trace = nullptr);
   int cls_obj_set_bucket_tag_timeout(RGWBucketInfo& bucket_info, uint64_t timeout);
   int cls_bucket_list(RGWBucketInfo& bucket_info, int shard_id, rgw_obj_index_key& start, const string& prefix,
-                      uint32_t num_entries, bool list_versions, map<string, rgw_bucket_dir_entry>& m,
+                      const string& delimiter, uint32_t num_entries, bool list_versions, map<string, rgw_bucket_dir_entry>& m,
                       bool *is_truncated, rgw_obj_index_key *last_entry,
-                      bool (*force_check_filter)(const string&  name) = NULL);
+                      bool (*force_check_filter)(const string&  name) = NULL,
+                      const ceph::real_time& max_mtime = ceph::real_time());
   int cls_bucket_head(const RGWBucketInfo& bucket_info, int shard_id, map<string, struct rgw_bucket_dir_header>& headers, map<int, string> *bucket_instance_ids = NULL);
   int cls_bucket_head_async(const RGWBucketInfo& bucket_info, int shard_id, RGWGetDirHeader_CB *ctx, int *num_aio);
   int list_bi_log_entries(RGWBucketInfo& bucket_info, int shard_id, string& marker, uint32_t max, std::list<rgw_bi_log_entry>& result, bool *truncated);
@@ -3710,6 +3720,48 @@ public:
   uint64_t next_bucket_id();
 };
 
+/*
+ * Collects bucket index delete completions so that each index shard
+ * receives them in a single bucket_complete_op_batch call instead of one
+ * call per object. Anything still queued is flushed on destruction.
+ */
+class RGWIndexCompleteBatch {
+  struct PendingOp {
+    rgw_obj obj;
+    string tag;
+    int64_t pool;
+    uint64_t epoch;
+    rgw_bucket_dir_entry ent;
+    list<rgw_obj_index_key> remove_objs;
+    uint16_t bilog_flags;
+    rgw_zone_set zones_trace;
+  };
+
+  struct ShardOps {
+    RGWRados::BucketShard bs;
+    list<PendingOp> ops;
+
+    explicit ShardOps(const RGWRados::BucketShard& _bs) : bs(_bs) {}
+  };
+
+  RGWRados *store;
+  map<string, ShardOps> shards; /* by index shard oid */
+
+  int flush_shard(ShardOps& shard);
+public:
+  explicit RGWIndexCompleteBatch(RGWRados *_store) : store(_store) {}
+  ~RGWIndexCompleteBatch() {
+    flush();
+  }
+
+  void add_del(RGWRados::BucketShard& bs, const string& tag, int64_t pool,
+               uint64_t epoch, const rgw_obj& obj,
+               const ceph::real_time& removed_mtime,
+               list<rgw_obj_index_key> *remove_objs, uint16_t bilog_flags,
+               rgw_zone_set *zones_trace);
+  int flush();
+};
+
 class RGWStoreManager {
 public:
   RGWStoreManager() {}
@@ -22,6 +22,11 @@ using namespace std;
 
 #define RESHARD_SHARD_WINDOW 64
 #define RESHARD_MAX_AIO 128
+#define RESHARD_REPLAY_WINDOW 1000
+/* replay passes made while writes still flow, and the number of objects
+ * changed during a pass below which writes are blocked for the last one */
+#define RESHARD_MAX_REPLAY_PASSES 5
+#define RESHARD_CUTOVER_OBJECTS 1000
 
 class BucketReshardShard {
   RGWRados *store;
@@ -242,6 +247,174 @@ int RGWBucketReshard::set_resharding_status(const string& new_instance_id, int32
   return 0;
 }
 
+int RGWBucketReshard::get_index_log_marker(string *marker)
+{
+  map<int, string> markers;
+  int ret = store->get_bi_log_status(bucket_info, RGW_NO_SHARD, markers);
+  if (ret < 0) {
+    ldout(store->ctx(), 0) << __func__ << " ERROR: failed to read bucket index log position: "
+                           << cpp_strerror(-ret) << dendl;
+    return ret;
+  }
+
+  if (bucket_info.num_shards == 0) {
+    *marker = markers[0];
+    return 0;
+  }
+
+  BucketIndexShardsManager marker_mgr;
+  for (auto& m : markers) {
+    marker_mgr.add(m.first, m.second);
+  }
+  marker_mgr.to_string(marker);
+  return 0;
+}
+
+static int list_object_index_entries(RGWRados *store, RGWRados::BucketShard& bs,
+                                     const string& name,
+                                     map<string, rgw_cls_bi_entry> *entries)
+{
+  string marker;
+  bool is_truncated = true;
+  while (is_truncated) {
+    list<rgw_cls_bi_entry> result;
+    int ret = store->bi_list(bs, name, marker, RESHARD_REPLAY_WINDOW, &result, &is_truncated);
+    if (ret < 0 && ret != -ENOENT) {
+      return ret;
+    }
+    for (auto& entry : result) {
+      marker = entry.idx;
+      (*entries)[entry.idx] = std::move(entry);
+    }
+    if (result.empty()) {
+      break;
+    }
+  }
+  return 0;
+}
+
+static void add_entry_stats(rgw_cls_bi_entry& entry, bool add,
+                            map<uint8_t, rgw_bucket_category_stats> *stats)
+{
+  cls_rgw_obj_key cls_key;
+  uint8_t category;
+  rgw_bucket_category_stats entry_stats;
+  if (!entry.get_info(&cls_key, &category, &entry_stats)) {
+    return;
+  }
+
+  /* the stats update is additive; unsigned wrap-around subtracts */
+  rgw_bucket_category_stats& target = (*stats)[category];
+  if (add) {
+    target.num_entries += entry_stats.num_entries;
+    target.total_size += entry_stats.total_size;
+    target.total_size_rounded += entry_stats.total_size_rounded;
+  } else {
+    target.num_entries -= entry_stats.num_entries;
+    target.total_size -= entry_stats.total_size;
+    target.total_size_rounded -= entry_stats.total_size_rounded;
+  }
+}
+
+int RGWBucketReshard::replay_object(const RGWBucketInfo& new_bucket_info,
+                                    const string& name)
+{
+  cls_rgw_obj_key cls_key(name);
+  rgw_obj_key key(cls_key);
+
+  RGWRados::BucketShard source_bs(store);
+  int ret = source_bs.init(bucket_info.bucket, rgw_obj(bucket_info.bucket, key));
+  if (ret < 0) {
+    return ret;
+  }
+  RGWRados::BucketShard target_bs(store);
+  ret = target_bs.init(new_bucket_info.bucket, rgw_obj(new_bucket_info.bucket, key));
+  if (ret < 0) {
+    return ret;
+  }
+
+  map<string, rgw_cls_bi_entry> source_entries;
+  ret = list_object_index_entries(store, source_bs, name, &source_entries);
+  if (ret < 0) {
+    return ret;
+  }
+  map<string, rgw_cls_bi_entry> target_entries;
+  ret = list_object_index_entries(store, target_bs, name, &target_entries);
+  if (ret < 0) {
+    return ret;
+  }
+
+  /* make the object's entries in the target shard match the source */
+  librados::ObjectWriteOperation op;
+  map<uint8_t, rgw_bucket_category_stats> stats;
+  set<string> removed;
+  for (auto& iter : target_entries) {
+    add_entry_stats(iter.second, false, &stats);
+    if (source_entries.find(iter.first) == source_entries.end()) {
+      removed.insert(iter.first);
+    }
+  }
+  for (auto& iter : source_entries) {
+    add_entry_stats(iter.second, true, &stats);
+    store->bi_put(op, target_bs, iter.second);
+  }
+  if (!removed.empty()) {
+    op.omap_rm_keys(removed);
+  }
+  if (op.size() == 0) {
+    return 0;
+  }
+  cls_rgw_bucket_update_stats(op, false, stats);
+
+  ret = target_bs.index_ctx.operate(target_bs.bucket_obj, &op);
+  if (ret < 0) {
+    lderr(store->ctx()) << "ERROR: failed to replay " << name << " to target bucket shard (bs="
+                        << target_bs.bucket << "/" << target_bs.shard_id << ") error=" << cpp_strerror(-ret) << dendl;
+    return ret;
+  }
+  return 0;
+}
+
+int RGWBucketReshard::replay_index_log(const RGWBucketInfo& new_bucket_info,
+                                       string *marker, uint64_t *num_replayed)
+{
+  *num_replayed = 0;
+
+  bool truncated = true;
+  while (truncated) {
+    list<rgw_bi_log_entry> entries;
+    int ret = store->list_bi_log_entries(bucket_info, RGW_NO_SHARD, *marker,
+                                         RESHARD_REPLAY_WINDOW, entries, &truncated);
+    if (ret < 0) {
+      ldout(store->ctx(), 0) << __func__ << " ERROR: failed to list bucket index log: "
+                             << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+    if (entries.empty()) {
+      break;
+    }
+
+    /* the log says which objects changed; their current index entries
+     * are what gets copied, however many times they changed */
+    set<string> names;
+    for (auto& entry : entries) {
+      if (!entry.object.empty()) {
+        names.insert(entry.object);
+      }
+    }
+    for (auto& name : names) {
+      ret = replay_object(new_bucket_info, name);
+      if (ret < 0) {
+        return ret;
+      }
+    }
+    *num_replayed += names.size();
+  }
+
+  ldout(store->ctx(), 10) << __func__ << " replayed " << *num_replayed << " objects" << dendl;
+  return 0;
+}
+
 int RGWBucketReshard::clear_resharding()
 {
   cls_rgw_bucket_instance_entry instance_entry;
@@ -381,6 +554,14 @@ int RGWBucketReshard::do_reshard(
     return ret;
   }
 
+  /* the index is already logging every change (CLS_RGW_RESHARD_LOGGING),
+   * so whatever is written during the copy gets replayed from here */
+  string log_marker;
+  ret = get_index_log_marker(&log_marker);
+  if (ret < 0) {
+    return ret;
+  }
+
   int num_target_shards = (new_bucket_info.num_shards > 0 ? new_bucket_info.num_shards : 1);
 
   BucketReshardManager target_shards_mgr(store, new_bucket_info, num_target_shards);
@@ -470,6 +651,29 @@ int RGWBucketReshard::do_reshard(
     return EIO;
   }
 
+  /* catch up with writes made during the copy while they keep flowing,
+   * until the remaining delta is small */
+  uint64_t num_replayed = 0;
+  for (int pass = 0; pass < RESHARD_MAX_REPLAY_PASSES; ++pass) {
+    ret = replay_index_log(new_bucket_info, &log_marker, &num_replayed);
+    if (ret < 0) {
+      return ret;
+    }
+    if (num_replayed < RESHARD_CUTOVER_OBJECTS) {
+      break;
+    }
+  }
+
+  /* block writes only for the last pass and the cutover */
+  ret = set_resharding_status(new_bucket_info.bucket.bucket_id, num_shards, CLS_RGW_RESHARD_IN_PROGRESS);
+  if (ret < 0) {
+    return ret;
+  }
+  ret = replay_index_log(new_bucket_info, &log_marker, &num_replayed);
+  if (ret < 0) {
+    return ret;
+  }
+
   RGWBucketAdminOpState bucket_op;
 
   bucket_op.set_bucket_name(new_bucket_info.bucket.name);
@@ -539,7 +743,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
     }
   }
 
-  ret = set_resharding_status(new_bucket_info.bucket.bucket_id, num_shards, CLS_RGW_RESHARD_IN_PROGRESS);
+  ret = set_resharding_status(new_bucket_info.bucket.bucket_id, num_shards, CLS_RGW_RESHARD_LOGGING);
   if (ret < 0) {
     unlock_bucket();
     return ret;
@@ -551,6 +755,8 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
                    verbose, out, formatter);
 
   if (ret < 0) {
+    /* stop logging (or blocking) writes to the old index */
+    clear_resharding();
     unlock_bucket();
     return ret;
   }
@@ -29,6 +29,11 @@ class RGWBucketReshard {
   int set_resharding_status(const string& new_instance_id, int32_t num_shards, cls_rgw_reshard_status status);
   int clear_resharding();
 
+  int get_index_log_marker(string *marker);
+  int replay_object(const RGWBucketInfo& new_bucket_info, const string& name);
+  int replay_index_log(const RGWBucketInfo& new_bucket_info, string *marker,
+                       uint64_t *num_replayed);
+
   int create_new_bucket_instance(int new_num_shards, RGWBucketInfo& new_bucket_info);
   int do_reshard(int num_shards,
 		 const RGWBucketInfo& new_bucket_info,
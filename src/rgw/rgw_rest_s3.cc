@@ -133,6 +133,7 @@ int RGWGetObj_ObjStore_S3::get_params()
   // attributes needed to support decryption on the other zone
   if (s->system_request) {
     skip_decrypt = s->info.args.exists(RGW_SYS_PARAM_PREFIX "skip-decrypt");
+    skip_decompress = s->info.args.exists(RGW_SYS_PARAM_PREFIX "skip-decompress");
   }
 
   return RGWGetObj_ObjStore::get_params();
@@ -212,6 +213,9 @@ int RGWGetObj_ObjStore_S3::send_response_data(bufferlist& bl, off_t bl_ofs,
     encode_json("attrs", attrs, &jf);
     utime_t ut(lastmod);
     encode_json("mtime", ut, &jf);
+    if (sent_compressed) {
+      encode_json("compressed", true, &jf);
+    }
     jf.close_section();
     stringstream ss;
     jf.flush(ss);
@@ -4036,12 +4040,18 @@ AWSEngine::authenticate(const req_state* const s) const
   if (auth_data.access_key_id.empty() || auth_data.client_signature.empty()) {
     return result_t::deny(-EINVAL);
   } else {
-    return authenticate(auth_data.access_key_id,
-		        auth_data.client_signature,
-			auth_data.string_to_sign,
-                        auth_data.signature_factory,
-			auth_data.completer_factory,
-			s);
+    const utime_t start = ceph_clock_now();
+    auto result = authenticate(auth_data.access_key_id,
+                               auth_data.client_signature,
+                               auth_data.string_to_sign,
+                               auth_data.signature_factory,
+                               auth_data.completer_factory,
+                               s);
+    const int lat_counter = get_lat_counter();
+    if (perfcounter && lat_counter) {
+      perfcounter->tinc(lat_counter, ceph_clock_now() - start);
+    }
+    return result;
   }
 }
 
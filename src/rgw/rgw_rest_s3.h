@@ -759,6 +759,11 @@ protected:
                                 const completer_factory_t& completer_factory,
                                 const req_state* s) const = 0;
 
+  /* The time_avg perf counter authenticate() reports into, 0 for none. */
+  virtual int get_lat_counter() const noexcept {
+    return 0;
+  }
+
 public:
   result_t authenticate(const req_state* const s) const final;
 };
@@ -852,6 +857,10 @@ public:
   const char* get_name() const noexcept override {
     return "rgw::auth::s3::LDAPEngine";
   }
+
+  int get_lat_counter() const noexcept override {
+    return l_rgw_auth_ldap_lat;
+  }
 };
 
 
@@ -880,6 +889,10 @@ public:
   const char* get_name() const noexcept override {
     return "rgw::auth::s3::LocalEngine";
   }
+
+  int get_lat_counter() const noexcept override {
+    return l_rgw_auth_local_lat;
+  }
 };
 
 
@@ -1138,6 +1138,29 @@ TEST(BufferListIterator, iterator_crc32c) {
   ASSERT_EQ(0u, it.get_remaining());
 }
 
+TEST(BufferListIterator, iterator_crc32c_blocks) {
+  // blocks within a single buffer, and blocks spanning two of them
+  string s1(4096 * 5, 'a');
+  string s2(100, 'b');
+  string s3(4096 * 3 - 100, 'c');
+  bufferlist bl;
+  bl.append(s1);
+  bl.append(s2);
+  bl.append(s3);
+  string s = s1 + s2 + s3;
+
+  const size_t blocks = s.length() / 512;
+  vector<uint32_t> crcs(blocks - 1);
+  bufferlist::iterator it = bl.begin();
+  it.advance(512);
+  it.crc32c_blocks(512, blocks - 1, -1, crcs.data());
+  ASSERT_EQ(0u, it.get_remaining());
+  for (size_t i = 0; i < blocks - 1; i++) {
+    ASSERT_EQ(ceph_crc32c(-1, (unsigned char*)s.c_str() + (i + 1) * 512, 512),
+	      crcs[i]);
+  }
+}
+
 TEST(BufferListIterator, seek) {
   bufferlist bl;
   bl.append("ABC", 3);
@@ -2255,6 +2278,20 @@ TEST(BufferList, copy_in) {
   }
 }
 
+TEST(BufferList, append_buffer_reuse) {
+  // a freed append buffer is handed to the next list of the thread
+  const char *first;
+  {
+    bufferlist bl;
+    bl.append("foo");
+    first = bl.c_str();
+  }
+  bufferlist bl;
+  bl.append("bar");
+  EXPECT_EQ(first, bl.c_str());
+  EXPECT_EQ(0, memcmp(bl.c_str(), "bar", 3));
+}
+
 TEST(BufferList, append) {
   //
   // void append(char c);
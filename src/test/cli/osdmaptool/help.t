@@ -23,4 +23,5 @@
                              max deviation from target [default: .01]
      --upmap-pool <poolname> restrict upmap balancing to 1 or more pools
      --upmap-save            write modified OSDMap with upmap changes
+     --test-decode <count>   time <count> encode/decode rounds of the map
   [1]
@@ -269,6 +269,206 @@ TEST(cls_rgw, index_remove_object)
   test_stats(ioctx, bucket_oid, 0, NUM_OBJS - 1, total_size);
 }
 
+TEST(cls_rgw, index_list_delimiter)
+{
+  string bucket_oid = str_int("bucket", 4);
+
+  OpMgr mgr;
+
+  ObjectWriteOperation *op = mgr.write_op();
+  cls_rgw_bucket_init(*op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  vector<string> objs = {"a/1", "a/2", "a/3", "b", "c/d/1", "c/e", "f"};
+  int epoch = 0;
+  for (auto& obj : objs) {
+    string tag = "tag-" + obj;
+    string loc = "loc-" + obj;
+    index_prepare(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+
+    rgw_bucket_dir_entry_meta meta;
+    meta.category = 0;
+    meta.size = 1024;
+    index_complete(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, ++epoch, obj, meta);
+  }
+
+  map<int, string> oids;
+  oids[0] = bucket_oid;
+
+  /* everything under a common prefix folds into one entry */
+  map<int, struct rgw_cls_list_ret> results;
+  cls_rgw_obj_key start_key;
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "/", 100, false,
+                                     oids, results, 8)());
+  map<string, struct rgw_bucket_dir_entry>& m = results[0].dir.m;
+  ASSERT_EQ(4u, m.size());
+  ASSERT_FALSE(results[0].is_truncated);
+  auto iter = m.begin();
+  ASSERT_EQ("a/", iter->first);
+  ASSERT_TRUE(iter->second.is_common_prefix());
+  ++iter;
+  ASSERT_EQ("b", iter->first);
+  ASSERT_FALSE(iter->second.is_common_prefix());
+  ++iter;
+  ASSERT_EQ("c/", iter->first);
+  ASSERT_TRUE(iter->second.is_common_prefix());
+  ++iter;
+  ASSERT_EQ("f", iter->first);
+
+  /* the delimiter is only looked for past the filter prefix */
+  results.clear();
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "c/", "/", 100, false,
+                                     oids, results, 8)());
+  ASSERT_EQ(2u, results[0].dir.m.size());
+  ASSERT_TRUE(results[0].dir.m["c/d/"].is_common_prefix());
+  ASSERT_FALSE(results[0].dir.m["c/e"].is_common_prefix());
+
+  /* a common prefix counts as one entry towards the limit */
+  results.clear();
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "/", 2, false,
+                                     oids, results, 8)());
+  ASSERT_EQ(2u, results[0].dir.m.size());
+  ASSERT_TRUE(results[0].is_truncated);
+  ASSERT_EQ("b", results[0].dir.m.rbegin()->first);
+}
+
+TEST(cls_rgw, index_list_max_mtime)
+{
+  string bucket_oid = str_int("bucket", 6);
+
+  OpMgr mgr;
+
+  ObjectWriteOperation *op = mgr.write_op();
+  cls_rgw_bucket_init(*op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  ceph::real_time old_mtime = ceph::real_clock::from_time_t(1000);
+  ceph::real_time new_mtime = ceph::real_clock::from_time_t(2000);
+  map<string, ceph::real_time> objs = {
+    {"a", old_mtime}, {"b", new_mtime}, {"c", new_mtime},
+    {"d", old_mtime}, {"e", new_mtime}, {"f", old_mtime}};
+  int epoch = 0;
+  for (auto& i : objs) {
+    string obj = i.first;
+    string tag = "tag-" + obj;
+    string loc = "loc-" + obj;
+    index_prepare(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+
+    rgw_bucket_dir_entry_meta meta;
+    meta.category = 0;
+    meta.size = 1024;
+    meta.mtime = i.second;
+    index_complete(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, ++epoch, obj, meta);
+  }
+
+  map<int, string> oids;
+  oids[0] = bucket_oid;
+
+  /* only entries modified at or before max_mtime come back */
+  map<int, struct rgw_cls_list_ret> results;
+  cls_rgw_obj_key start_key;
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "", 100, false,
+                                     oids, results, 8, old_mtime)());
+  ASSERT_EQ(3u, results[0].dir.m.size());
+  ASSERT_FALSE(results[0].is_truncated);
+  ASSERT_EQ(1u, results[0].dir.m.count("a"));
+  ASSERT_EQ(1u, results[0].dir.m.count("d"));
+  ASSERT_EQ(1u, results[0].dir.m.count("f"));
+
+  /* skipped entries count towards the limit, and the marker says where
+   * the scan stopped */
+  results.clear();
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "", 3, false,
+                                     oids, results, 8, old_mtime)());
+  ASSERT_EQ(1u, results[0].dir.m.size());
+  ASSERT_TRUE(results[0].is_truncated);
+  ASSERT_EQ("c", results[0].marker.name);
+
+  start_key = results[0].marker;
+  results.clear();
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "", 100, false,
+                                     oids, results, 8, old_mtime)());
+  ASSERT_EQ(2u, results[0].dir.m.size());
+  ASSERT_FALSE(results[0].is_truncated);
+  ASSERT_EQ("d", results[0].dir.m.begin()->first);
+}
+
+TEST(cls_rgw, index_complete_batch)
+{
+  string bucket_oid = str_int("bucket", 5);
+
+  OpMgr mgr;
+
+  ObjectWriteOperation *op = mgr.write_op();
+  cls_rgw_bucket_init(*op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  uint64_t obj_size = 1024;
+  int epoch = 0;
+
+  /* prepare a set of writes and complete them all in one call */
+  list<rgw_cls_obj_complete_op> ops;
+  for (int i = 0; i < NUM_OBJS; i++) {
+    string obj = str_int("obj", i);
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+
+    index_prepare(mgr, ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+
+    rgw_cls_obj_complete_op complete_op;
+    complete_op.op = CLS_RGW_OP_ADD;
+    complete_op.key = cls_rgw_obj_key(obj, string());
+    complete_op.tag = tag;
+    complete_op.ver.pool = ioctx.get_id();
+    complete_op.ver.epoch = ++epoch;
+    complete_op.meta.category = 0;
+    complete_op.meta.size = obj_size;
+    complete_op.meta.accounted_size = obj_size;
+    complete_op.log_op = true;
+    ops.push_back(complete_op);
+  }
+  test_stats(ioctx, bucket_oid, 0, 0, 0);
+
+  op = mgr.write_op();
+  cls_rgw_bucket_complete_op_batch(*op, ops);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  test_stats(ioctx, bucket_oid, 0, NUM_OBJS, obj_size * NUM_OBJS);
+
+  /* delete half of them in a batch that also carries an op for an entry
+   * that was never written; that op fails on its own */
+  ops.clear();
+  for (int i = 0; i < NUM_OBJS / 2; i++) {
+    string obj = str_int("obj", i);
+    string tag = str_int("tag-del", i);
+    string loc = str_int("loc", i);
+
+    index_prepare(mgr, ioctx, bucket_oid, CLS_RGW_OP_DEL, tag, obj, loc);
+
+    rgw_cls_obj_complete_op complete_op;
+    complete_op.op = CLS_RGW_OP_DEL;
+    complete_op.key = cls_rgw_obj_key(obj, string());
+    complete_op.tag = tag;
+    complete_op.ver.pool = ioctx.get_id();
+    complete_op.ver.epoch = ++epoch;
+    complete_op.log_op = true;
+    ops.push_back(complete_op);
+  }
+  rgw_cls_obj_complete_op missing_op;
+  missing_op.op = CLS_RGW_OP_DEL;
+  missing_op.key = cls_rgw_obj_key("missing", string());
+  missing_op.ver.pool = ioctx.get_id();
+  missing_op.ver.epoch = ++epoch;
+  ops.push_back(missing_op);
+
+  op = mgr.write_op();
+  cls_rgw_bucket_complete_op_batch(*op, ops);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, op));
+
+  test_stats(ioctx, bucket_oid, 0, NUM_OBJS - NUM_OBJS / 2,
+             obj_size * (NUM_OBJS - NUM_OBJS / 2));
+}
+
 TEST(cls_rgw, index_suggest)
 {
   string bucket_oid = str_int("bucket", 3);
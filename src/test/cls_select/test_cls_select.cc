@@ -0,0 +1,107 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <errno.h>
+#include <string>
+
+#include "cls/select/cls_select_client.h"
+#include "gtest/gtest.h"
+#include "include/rados/librados.hpp"
+#include "test/librados/test.h"
+
+using namespace librados;
+
+static const string csv_data =
+  "alice,31,paris\n"
+  "bob,25,london\n"
+  "carol,47,berlin\n"
+  "dave,30,madrid\n";
+
+static string to_str(bufferlist& bl)
+{
+  return string(bl.c_str(), bl.length());
+}
+
+class ClsSelect : public ::testing::Test {
+protected:
+  static Rados cluster;
+  static string pool_name;
+  IoCtx ioctx;
+
+  static void SetUpTestCase() {
+    pool_name = get_temp_pool_name();
+    ASSERT_EQ("", create_one_pool_pp(pool_name, cluster));
+  }
+
+  static void TearDownTestCase() {
+    ASSERT_EQ(0, destroy_one_pool_pp(pool_name, cluster));
+  }
+
+  void SetUp() override {
+    ASSERT_EQ(0, cluster.ioctx_create(pool_name.c_str(), ioctx));
+    bufferlist bl;
+    bl.append(csv_data);
+    ASSERT_EQ(0, ioctx.write_full("data.csv", bl));
+  }
+};
+
+Rados ClsSelect::cluster;
+string ClsSelect::pool_name;
+
+TEST_F(ClsSelect, Filter)
+{
+  cls_select_csv_filter filter;
+  filter.column = 1;
+  filter.cmp = CLS_SELECT_CMP_GE;
+  filter.value = "31";
+  filter.projection.push_back(0);
+  filter.projection.push_back(2);
+
+  cls_select_csv_ret ret;
+  ASSERT_EQ(0, cls_select_csv(ioctx, "data.csv", 0, 0, filter, &ret));
+  ASSERT_EQ("alice,paris\ncarol,berlin\n", to_str(ret.rows));
+  ASSERT_EQ(4u, ret.records);
+  ASSERT_EQ(0u, ret.head.length());
+  ASSERT_EQ(0u, ret.tail.length());
+
+  /* string comparison when the value isn't a number */
+  filter.column = 2;
+  filter.cmp = CLS_SELECT_CMP_EQ;
+  filter.value = "london";
+  filter.projection.clear();
+
+  ret = cls_select_csv_ret();
+  ASSERT_EQ(0, cls_select_csv(ioctx, "data.csv", 0, 0, filter, &ret));
+  ASSERT_EQ("bob,25,london\n", to_str(ret.rows));
+}
+
+TEST_F(ClsSelect, Ranges)
+{
+  cls_select_csv_filter filter;
+  filter.column = 0;
+  filter.cmp = CLS_SELECT_CMP_NE;
+  filter.value = "nobody";
+
+  /* split the object in the middle of bob's record */
+  const uint64_t split = csv_data.find("london");
+
+  cls_select_csv_ret first;
+  ASSERT_EQ(0, cls_select_csv(ioctx, "data.csv", 0, split, filter, &first));
+  ASSERT_EQ("alice,31,paris\n", to_str(first.rows));
+  ASSERT_EQ("bob,25,", to_str(first.tail));
+
+  cls_select_csv_ret second;
+  ASSERT_EQ(0, cls_select_csv(ioctx, "data.csv", split, 0, filter, &second));
+  ASSERT_EQ("london\n", to_str(second.head));
+  ASSERT_EQ("carol,47,berlin\ndave,30,madrid\n", to_str(second.rows));
+
+  /* the caller filters the record made of the two pieces */
+  bufferlist joined;
+  joined.append(first.tail);
+  joined.append(second.head);
+  bufferlist out;
+  ASSERT_TRUE(filter.apply(joined.c_str(), joined.length() - 1, out));
+  ASSERT_EQ("bob,25,london\n", to_str(out));
+
+  ASSERT_EQ(-ENOENT, cls_select_csv(ioctx, "missing.csv", 0, 0, filter, &first));
+}
@@ -213,6 +213,37 @@ TEST_F(ThrottleTest, wait) {
   } while(!waited);
 }
 
+TEST_F(ThrottleTest, get_put_threads) {
+  // lock-free and locked gets and puts racing: nobody may go over max,
+  // and nobody may be left waiting
+  const int64_t throttle_max = 4;
+  Throttle throttle(g_ceph_context, "throttle", throttle_max);
+  std::atomic<int64_t> held = { 0 };
+  std::atomic<bool> over = { false };
+
+  auto worker = [&](int i) {
+    for (int n = 0; n < 10000; ++n) {
+      if ((n + i) % 3 == 0) {
+	if (!throttle.get_or_fail(1))
+	  continue;
+      } else {
+	throttle.get(1);
+      }
+      if (++held > throttle_max)
+	over = true;
+      --held;
+      throttle.put(1);
+    }
+  };
+  vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i)
+    threads.emplace_back(worker, i);
+  for (auto& t : threads)
+    t.join();
+  ASSERT_FALSE(over);
+  ASSERT_EQ(0, throttle.get_current());
+}
+
 std::pair<double, std::chrono::duration<double> > test_backoff(
   double low_threshhold,
   double high_threshhold,
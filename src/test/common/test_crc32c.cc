@@ -267,6 +267,42 @@ TEST(Crc32c, RangeNull) {
   }
 }
 
+TEST(Crc32c, Combine) {
+  int len = 10000;
+  unsigned char *b = (unsigned char *)malloc(len);
+  for (int i = 0; i < len; i++)
+    b[i] = i * 7;
+  for (int a : {0, 1, 15, 4096, 9999}) {
+    uint32_t crc_a = ceph_crc32c(1234, b, a);
+    uint32_t crc_b = ceph_crc32c(0, b + a, len - a);
+    ASSERT_EQ(ceph_crc32c(1234, b, len),
+	      ceph_crc32c_combine(crc_a, crc_b, len - a));
+  }
+  free(b);
+}
+
+TEST(Crc32c, Multi) {
+  const unsigned count = 8;
+  int len = 4096 * count + count;
+  unsigned char *b = (unsigned char *)malloc(len);
+  for (int i = 0; i < len; i++)
+    b[i] = i * 13;
+  // unaligned, to exercise the word loads too
+  unsigned char const *data[count];
+  for (unsigned i = 0; i < count; i++)
+    data[i] = b + i * 4097 + 1;
+  uint32_t crcs[count];
+  for (unsigned length : {0, 1, 7, 8, 13, 512, 4095}) {
+    for (unsigned n = 0; n <= count; n++) {
+      ceph_crc32c_multi(-1, data, length, n, crcs);
+      for (unsigned i = 0; i < n; i++) {
+	ASSERT_EQ(ceph_crc32c_sctp(-1, data[i], length), crcs[i]);
+      }
+    }
+  }
+  free(b);
+}
+
 double estimate_clock_resolution()
 {
   volatile char* p = (volatile char*)malloc(1024);
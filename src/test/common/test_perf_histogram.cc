@@ -245,3 +245,42 @@ TEST(PerfHistogram, AxisAddressing) {
     }
   }
 }
+
+TEST(PerfLatencyHistogram, Buckets) {
+  for (uint64_t v : {0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 9ull, 1000ull,
+	             123456789ull, (1ull << 63) + 5, ~0ull}) {
+    int bucket = PerfLatencyHistogram::get_bucket(v);
+    ASSERT_LE(0, bucket);
+    ASSERT_GT(PerfLatencyHistogram::num_buckets, bucket);
+    ASSERT_LE(v, PerfLatencyHistogram::get_bucket_max(bucket));
+    if (bucket > 0) {
+      ASSERT_LT(PerfLatencyHistogram::get_bucket_max(bucket - 1), v);
+    }
+  }
+  ASSERT_EQ(PerfLatencyHistogram::num_buckets - 1,
+	    PerfLatencyHistogram::get_bucket(~0ull));
+  // within 1/4 of the magnitude
+  ASSERT_EQ(1023u, PerfLatencyHistogram::get_bucket_max(
+	      PerfLatencyHistogram::get_bucket(1000)));
+}
+
+TEST(PerfLatencyHistogram, Percentile) {
+  PerfLatencyHistogram h;
+  ASSERT_EQ(0u, h.get_percentile(.99));
+  for (int i = 0; i < 990; i++) {
+    h.inc(1000);
+  }
+  for (int i = 0; i < 9; i++) {
+    h.inc(1000000);
+  }
+  h.inc(1000000000);
+  ASSERT_EQ(1023u, h.get_percentile(.5));
+  ASSERT_EQ(1023u, h.get_percentile(.99));
+  ASSERT_EQ(1048575u, h.get_percentile(.999));
+  ASSERT_EQ(1073741823u, h.get_percentile(1));
+
+  PerfLatencyHistogram copy(h);
+  ASSERT_EQ(1048575u, copy.get_percentile(.999));
+  h.reset();
+  ASSERT_EQ(0u, h.get_percentile(.999));
+}
@@ -376,6 +376,57 @@ TEST(ZlibCompressor, zlib_isal_compatibility)
 }
 #endif
 
+TEST(ZstdCompressor, dictionary)
+{
+  CompressorRef zstd = Compressor::create(g_ceph_context, "zstd");
+  ASSERT_TRUE(zstd);
+
+  // small records sharing most of their content
+  srand(0);
+  auto record = [](int i) {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+	     "{\"bucket\": \"photos-%d\", \"owner\": \"user%d\", "
+	     "\"storage_class\": \"STANDARD\", \"size\": %d, "
+	     "\"etag\": \"%08x%08x\", \"content_type\": \"image/jpeg\"}",
+	     i % 7, i % 13, rand(), rand(), rand());
+    bufferlist bl;
+    bl.append(buf);
+    return bl;
+  };
+  vector<bufferlist> samples;
+  for (int i = 0; i < 2000; i++)
+    samples.push_back(record(i));
+
+  bufferlist dict;
+  ASSERT_EQ(0, zstd->train_dictionary(samples, 4096, &dict));
+  ASSERT_GT(dict.length(), 0u);
+  CompressorRef zd = zstd->with_dictionary(dict);
+  ASSERT_TRUE(zd);
+  EXPECT_EQ(zstd->get_type(), zd->get_type());
+
+  bufferlist garbage;
+  garbage.append("not a dictionary");
+  EXPECT_FALSE(zstd->with_dictionary(garbage));
+
+  bufferlist in = record(12345);
+  bufferlist plain, with_dict;
+  ASSERT_EQ(0, zstd->compress(in, plain));
+  ASSERT_EQ(0, zd->compress(in, with_dict));
+  EXPECT_LT(with_dict.length(), plain.length());
+
+  // both compressors read both formats
+  bufferlist out;
+  ASSERT_EQ(0, zstd->decompress(with_dict, out));
+  EXPECT_TRUE(in.contents_equal(out));
+  out.clear();
+  ASSERT_EQ(0, zd->decompress(plain, out));
+  EXPECT_TRUE(in.contents_equal(out));
+  out.clear();
+  ASSERT_EQ(0, zd->decompress(with_dict, out));
+  EXPECT_TRUE(in.contents_equal(out));
+}
+
 TEST(CompressionPlugin, all)
 {
   const char* env = getenv("CEPH_LIB");
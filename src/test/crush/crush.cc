@@ -509,6 +509,59 @@ TEST(CRUSH, straw2_stddev)
   }
 }
 
+TEST(CRUSH, hash32_3_batch)
+{
+  // the batched (possibly vectorized) hash must match the scalar one
+  // for every length, including partial groups
+  __s32 ids[40];
+  __u32 out[40];
+  for (int i = 0; i < 40; ++i)
+    ids[i] = -1 - i * 7919;
+  for (unsigned n = 0; n <= 40; ++n) {
+    for (__u32 x = 0; x < 100; ++x) {
+      crush_hash32_3_batch(CRUSH_HASH_RJENKINS1, x, ids, n % 3, out, n);
+      for (unsigned i = 0; i < n; ++i)
+	ASSERT_EQ(crush_hash32_3(CRUSH_HASH_RJENKINS1, x, ids[i], n % 3),
+		  out[i]);
+    }
+  }
+}
+
+TEST(CRUSH, straw2_wide_bucket_rate)
+{
+  // how fast we map through a single wide (60-item) straw2 bucket
+  const int n = 60;
+  CrushWrapper c;
+  c.create();
+  c.set_type_name(0, "osd");
+  c.set_type_name(1, "host");
+  int items[n], weights[n];
+  for (int i = 0; i < n; ++i) {
+    items[i] = i;
+    weights[i] = 0x10000;
+  }
+  int bucketno;
+  c.add_bucket(0, CRUSH_BUCKET_STRAW2, CRUSH_HASH_RJENKINS1, 1, n, items,
+	       weights, &bucketno);
+  c.set_item_name(bucketno, "host0");
+  int ruleno = c.add_simple_rule("data", "host0", "osd", "", "firstn",
+				 pg_pool_t::TYPE_REPLICATED);
+  ASSERT_GE(ruleno, 0);
+  c.finalize();
+
+  vector<__u32> reweight(n, 0x10000);
+  const int num_x = 200000;
+  utime_t start = ceph_clock_now();
+  for (int x = 0; x < num_x; ++x) {
+    vector<int> out;
+    c.do_rule(ruleno, x, out, 3, reweight, 0);
+    ASSERT_EQ(3u, out.size());
+  }
+  utime_t elapsed = ceph_clock_now() - start;
+  cout << num_x << " mappings in " << elapsed << " s ("
+       << (int)(num_x / (double)elapsed) << "/s)" << std::endl;
+}
+
 TEST(CRUSH, straw2_reweight) {
   // when we adjust the weight of an item in a straw2 bucket,
   // we should *only* see movement from or to that item, never
@@ -75,6 +75,36 @@ TEST(AES, Encrypt) {
   delete kh;
 }
 
+TEST(AES, EncryptBlock) {
+  CryptoHandler *h = g_ceph_context->get_crypto_handler(CEPH_CRYPTO_AES);
+  char secret_s[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  };
+  bufferptr secret(secret_s, sizeof(secret_s));
+
+  char plaintext_s[] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0x1a, 0x3b, 0x4c, 0x5d, 0x6e, 0x7f,
+  };
+  bufferlist plaintext;
+  plaintext.append(plaintext_s, sizeof(plaintext_s));
+
+  std::string error;
+  CryptoKeyHandler *kh = h->get_key_handler(secret, error);
+  bufferlist cipher;
+  ASSERT_EQ(0, kh->encrypt(plaintext, cipher, &error));
+
+  // the first CBC block is the raw cipher of the first block xor the IV
+  char block[CEPH_AES_BLOCK_LEN], cblock[CEPH_AES_BLOCK_LEN];
+  for (unsigned i = 0; i < sizeof(block); ++i)
+    block[i] = plaintext_s[i] ^ CEPH_AES_IV[i];
+  ASSERT_EQ(0, kh->encrypt_block(block, cblock));
+  ASSERT_EQ(0, memcmp(cblock, cipher.c_str(), sizeof(cblock)));
+
+  delete kh;
+}
+
 TEST(AES, Decrypt) {
   CryptoHandler *h = g_ceph_context->get_crypto_handler(CEPH_CRYPTO_AES);
   char secret_s[] = {
@@ -115,6 +145,52 @@ TEST(AES, Decrypt) {
   delete kh;
 }
 
+TEST(AES, GCM) {
+  CryptoHandler *h = g_ceph_context->get_crypto_handler(CEPH_CRYPTO_AES);
+  char secret_s[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  };
+  bufferptr secret(secret_s, sizeof(secret_s));
+  char nonce[CEPH_AES_GCM_NONCE_LEN] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+  char aad = 2;
+
+  // fragmented on purpose
+  bufferlist plaintext;
+  plaintext.append(std::string(100, 'a'));
+  plaintext.append(std::string(4000, 'b'));
+
+  std::string error;
+  CryptoKeyHandler *kh = h->get_key_handler(secret, error);
+  bufferlist cipher;
+  int r = kh->encrypt_aead(nonce, &aad, 1, plaintext, cipher, &error);
+  if (r == -EOPNOTSUPP) {
+    delete kh;
+    return;
+  }
+  ASSERT_EQ(0, r);
+  ASSERT_EQ(plaintext.length() + CEPH_AES_GCM_TAG_LEN, cipher.length());
+
+  bufferlist restored;
+  r = kh->decrypt_aead(nonce, &aad, 1, cipher, restored, &error);
+  ASSERT_EQ(0, r);
+  ASSERT_TRUE(restored.contents_equal(plaintext));
+
+  // the aad is authenticated
+  char other_aad = 1;
+  bufferlist bad;
+  ASSERT_GT(0, kh->decrypt_aead(nonce, &other_aad, 1, cipher, bad, &error));
+
+  // and so is the ciphertext
+  bufferlist tampered;
+  tampered.append(cipher.c_str(), cipher.length());
+  tampered.c_str()[10] ^= 1;
+  bad.clear();
+  ASSERT_GT(0, kh->decrypt_aead(nonce, &aad, 1, tampered, bad, &error));
+
+  delete kh;
+}
+
 TEST(AES, Loop) {
   CryptoRandom random;
 
@@ -0,0 +1,163 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph distributed storage system
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "include/stringify.h"
+#include "erasure-code/clay/ErasureCodeClay.h"
+#include "global/global_context.h"
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+static bufferlist random_stripe(unsigned length)
+{
+  bufferlist in;
+  bufferptr ptr(buffer::create_aligned(length, ErasureCode::SIMD_ALIGN));
+  for (unsigned i = 0; i < length; i++)
+    ptr[i] = rand() % 256;
+  in.push_back(ptr);
+  return in;
+}
+
+TEST(ErasureCodeClay, sanity_check_d)
+{
+  ErasureCodeClay clay(g_conf->get_val<std::string>("erasure_code_dir"));
+  ErasureCodeProfile profile;
+  profile["k"] = "4";
+  profile["m"] = "2";
+  profile["d"] = "6";
+  ostringstream errors;
+  EXPECT_EQ(-EINVAL, clay.init(profile, &errors));
+  EXPECT_NE(std::string::npos, errors.str().find("must be within"));
+}
+
+TEST(ErasureCodeClay, sub_chunks)
+{
+  ErasureCodeClay clay(g_conf->get_val<std::string>("erasure_code_dir"));
+  ErasureCodeProfile profile;
+  profile["k"] = "8";
+  profile["m"] = "3";
+  profile["d"] = "10";
+  ASSERT_EQ(0, clay.init(profile, &cerr));
+  // q = 3 and one virtual chunk pads the 11 chunks to a 3 x 4 grid
+  EXPECT_EQ(3, clay.q);
+  EXPECT_EQ(4, clay.t);
+  EXPECT_EQ(1, clay.nu);
+  EXPECT_EQ(81, clay.get_sub_chunk_count());
+  EXPECT_EQ(0u, clay.get_chunk_size(1) % 81);
+}
+
+TEST(ErasureCodeClay, encode_decode)
+{
+  for (auto kmd : { "4 2 5", "4 3 5", "5 3 7", "8 3 10" }) {
+    int k, m, d;
+    sscanf(kmd, "%d %d %d", &k, &m, &d);
+    ErasureCodeClay clay(g_conf->get_val<std::string>("erasure_code_dir"));
+    ErasureCodeProfile profile;
+    profile["k"] = stringify(k);
+    profile["m"] = stringify(m);
+    profile["d"] = stringify(d);
+    ASSERT_EQ(0, clay.init(profile, &cerr));
+
+    unsigned stripe = clay.get_chunk_size(1) * k;
+    bufferlist in = random_stripe(stripe);
+    set<int> want_to_encode;
+    for (int i = 0; i < k + m; i++)
+      want_to_encode.insert(i);
+    map<int, bufferlist> encoded;
+    ASSERT_EQ(0, clay.encode(want_to_encode, in, &encoded));
+    ASSERT_EQ((unsigned)(k + m), encoded.size());
+    bufferlist data;
+    for (int i = 0; i < k; i++)
+      data.append(encoded[i]);
+    EXPECT_TRUE(data.contents_equal(in));
+
+    // any m erasures can be decoded
+    for (int first = 0; first < k + m; first++) {
+      for (int last = first; last < k + m; last++) {
+	map<int, bufferlist> degraded = encoded;
+	degraded.erase(first);
+	degraded.erase(last);
+	set<int> want_to_read = { first, last };
+	map<int, bufferlist> decoded;
+	ASSERT_EQ(0, clay.decode(want_to_read, degraded, &decoded,
+				 clay.get_chunk_size(stripe)));
+	EXPECT_TRUE(decoded[first].contents_equal(encoded[first]));
+	EXPECT_TRUE(decoded[last].contents_equal(encoded[last]));
+      }
+    }
+  }
+}
+
+TEST(ErasureCodeClay, repair)
+{
+  for (auto kmd : { "4 2 5", "4 3 5", "5 3 7", "8 3 10" }) {
+    int k, m, d;
+    sscanf(kmd, "%d %d %d", &k, &m, &d);
+    ErasureCodeClay clay(g_conf->get_val<std::string>("erasure_code_dir"));
+    ErasureCodeProfile profile;
+    profile["k"] = stringify(k);
+    profile["m"] = stringify(m);
+    profile["d"] = stringify(d);
+    ASSERT_EQ(0, clay.init(profile, &cerr));
+
+    unsigned chunk_size = clay.get_chunk_size(1);
+    unsigned sc_size = chunk_size / clay.get_sub_chunk_count();
+    bufferlist in = random_stripe(chunk_size * k);
+    set<int> want_to_encode;
+    for (int i = 0; i < k + m; i++)
+      want_to_encode.insert(i);
+    map<int, bufferlist> encoded;
+    ASSERT_EQ(0, clay.encode(want_to_encode, in, &encoded));
+
+    for (int lost = 0; lost < k + m; lost++) {
+      set<int> want_to_read = { lost };
+      set<int> available;
+      for (int i = 0; i < k + m; i++) {
+	if (i != lost)
+	  available.insert(i);
+      }
+      map<int, vector<pair<int, int>>> minimum;
+      ASSERT_EQ(0, clay.minimum_to_decode(want_to_read, available, &minimum));
+      ASSERT_EQ((unsigned)d, minimum.size());
+
+      // read only the repair sub-chunks of each helper
+      map<int, bufferlist> helpers;
+      unsigned read = 0;
+      for (auto& i : minimum) {
+	for (auto& range : i.second) {
+	  bufferlist bl;
+	  bl.substr_of(encoded[i.first], range.first * sc_size,
+		       range.second * sc_size);
+	  helpers[i.first].append(bl);
+	}
+	read += helpers[i.first].length();
+      }
+      EXPECT_EQ(d * chunk_size / clay.q, read);
+
+      map<int, bufferlist> decoded;
+      ASSERT_EQ(0, clay.decode(want_to_read, helpers, &decoded, chunk_size));
+      EXPECT_TRUE(decoded[lost].contents_equal(encoded[lost]));
+    }
+  }
+}
+
+/*
+ * Local Variables:
+ * compile-command: "cd ../.. ;
+ *   make -j4 unittest_erasure_code_clay &&
+ *   valgrind --tool=memcheck \
+ *      ./unittest_erasure_code_clay \
+ *      --gtest_filter=*.* --log-to-stderr=true --debug-osd=20"
+ * End:
+ */
@@ -366,6 +366,151 @@ TEST_F(IsaErasureCodeTest, encode)
   }
 }
 
+TEST_F(IsaErasureCodeTest, encode_parity_delta)
+{
+  for (auto technique : { "reed_sol_van", "cauchy" }) {
+    ErasureCodeIsaDefault Isa(tcache,
+			      string(technique) == "cauchy" ?
+			      ErasureCodeIsaDefault::kCauchy :
+			      ErasureCodeIsaDefault::kVandermonde);
+    ErasureCodeProfile profile;
+    profile["k"] = "3";
+    profile["m"] = "2";
+    profile["technique"] = technique;
+    Isa.init(profile, &cerr);
+    ASSERT_TRUE(Isa.supports_parity_delta());
+
+    unsigned chunk = Isa.get_chunk_size(1);
+    set<int> want_to_encode = { 0, 1, 2, 3, 4 };
+    bufferlist in;
+    in.append(string(chunk, 'A'));
+    in.append(string(chunk, 'B'));
+    in.append(string(chunk, 'C'));
+    map<int, bufferlist> encoded;
+    ASSERT_EQ(0, Isa.encode(want_to_encode, in, &encoded));
+
+    bufferlist new_in;
+    new_in.append(string(chunk, 'A'));
+    new_in.append(string(chunk, 'B'));
+    new_in.append(string(chunk, 'D'));
+    map<int, bufferlist> reencoded;
+    ASSERT_EQ(0, Isa.encode(want_to_encode, new_in, &reencoded));
+
+    map<int, bufferlist> parity;
+    parity[3] = encoded[3];
+    parity[4] = encoded[4];
+    ASSERT_EQ(0, Isa.encode_parity_delta(2, encoded[2], reencoded[2],
+					 &parity));
+    EXPECT_TRUE(parity[3].contents_equal(reencoded[3]));
+    EXPECT_TRUE(parity[4].contents_equal(reencoded[4]));
+  }
+}
+
+TEST_F(IsaErasureCodeTest, encode_decode_stripes)
+{
+  for (auto technique : { "reed_sol_van", "cauchy" }) {
+    ErasureCodeIsaDefault Isa(tcache,
+			      string(technique) == "cauchy" ?
+			      ErasureCodeIsaDefault::kCauchy :
+			      ErasureCodeIsaDefault::kVandermonde);
+    ErasureCodeProfile profile;
+    profile["k"] = "3";
+    profile["m"] = "2";
+    profile["technique"] = technique;
+    Isa.init(profile, &cerr);
+    ASSERT_TRUE(Isa.supports_multi_stripe());
+
+    unsigned chunk = Isa.get_chunk_size(1);
+    unsigned stripe = chunk * 3;
+    unsigned stripes = 4;
+    bufferlist in;
+    for (unsigned s = 0; s < stripes; s++)
+      in.append(string(stripe, 'A' + s));
+    set<int> want_to_encode = { 0, 1, 2, 3, 4 };
+
+    map<int, bufferlist> expected;
+    for (unsigned s = 0; s < stripes; s++) {
+      bufferlist bl;
+      bl.substr_of(in, s * stripe, stripe);
+      map<int, bufferlist> encoded;
+      ASSERT_EQ(0, Isa.encode(want_to_encode, bl, &encoded));
+      for (auto& i : encoded)
+	expected[i.first].claim_append(i.second);
+    }
+    map<int, bufferlist> shards;
+    ASSERT_EQ(0, Isa.encode_stripes(want_to_encode, in, stripe, &shards));
+    for (int i = 0; i < 5; i++)
+      EXPECT_TRUE(shards[i].contents_equal(expected[i]));
+
+    map<int, bufferlist> degraded = shards;
+    degraded.erase(1);
+    degraded.erase(4);
+    map<int, bufferlist> decoded;
+    ASSERT_EQ(0, Isa.decode_stripes(set<int>{1, 4}, degraded, chunk,
+				    &decoded));
+    EXPECT_TRUE(decoded[1].contents_equal(shards[1]));
+    EXPECT_TRUE(decoded[4].contents_equal(shards[4]));
+  }
+}
+
+TEST_F(IsaErasureCodeTest, decoding_table_cache)
+{
+  ErasureCodeIsaTableCache cache;
+  const int matrix = ErasureCodeIsaDefault::kCauchy;
+  ErasureCodeProfile profile;
+  profile["k"] = "4";
+  profile["m"] = "3";
+  profile["technique"] = "cauchy";
+
+  // init pre-computes the tables of all single and double erasures
+  ErasureCodeIsaDefault Isa(cache, matrix);
+  Isa.init(profile, &cerr);
+  EXPECT_EQ(7 + 21, cache.getDecodingTableCacheSize(matrix));
+  EXPECT_EQ(0u, cache.getDecodingTableHits());
+  EXPECT_EQ(28u, cache.getDecodingTableMisses());
+
+  // but only once per profile
+  ErasureCodeIsaDefault other(cache, matrix);
+  other.init(profile, &cerr);
+  EXPECT_EQ(28, cache.getDecodingTableCacheSize(matrix));
+  EXPECT_EQ(28u, cache.getDecodingTableMisses());
+
+  set<int> want_to_encode = { 0, 1, 2, 3, 4, 5, 6 };
+  bufferlist in;
+  in.append(string(Isa.get_chunk_size(1) * 4, 'X'));
+  map<int, bufferlist> encoded;
+  ASSERT_EQ(0, Isa.encode(want_to_encode, in, &encoded));
+
+  // a double erasure is found in the cache
+  {
+    map<int, bufferlist> degraded = encoded;
+    degraded.erase(0);
+    degraded.erase(5);
+    map<int, bufferlist> decoded;
+    ASSERT_EQ(0, Isa._decode(set<int>{0, 5}, degraded, &decoded));
+    EXPECT_TRUE(decoded[0].contents_equal(encoded[0]));
+    EXPECT_TRUE(decoded[5].contents_equal(encoded[5]));
+    EXPECT_EQ(1u, cache.getDecodingTableHits());
+    EXPECT_EQ(28u, cache.getDecodingTableMisses());
+  }
+
+  // a triple erasure is computed once and then found in the cache
+  for (int i = 0; i < 2; i++) {
+    map<int, bufferlist> degraded = encoded;
+    degraded.erase(1);
+    degraded.erase(2);
+    degraded.erase(6);
+    map<int, bufferlist> decoded;
+    ASSERT_EQ(0, other._decode(set<int>{1, 2, 6}, degraded, &decoded));
+    EXPECT_TRUE(decoded[1].contents_equal(encoded[1]));
+    EXPECT_TRUE(decoded[2].contents_equal(encoded[2]));
+    EXPECT_TRUE(decoded[6].contents_equal(encoded[6]));
+  }
+  EXPECT_EQ(2u, cache.getDecodingTableHits());
+  EXPECT_EQ(29u, cache.getDecodingTableMisses());
+  EXPECT_EQ(29, cache.getDecodingTableCacheSize(matrix));
+}
+
 TEST_F(IsaErasureCodeTest, sanity_check_k)
 {
   ErasureCodeIsaDefault Isa(tcache);
@@ -401,6 +546,9 @@ TEST_F(IsaErasureCodeTest, isa_vandermonde_exhaustive)
   // Test all possible failure scenarios and reconstruction cases for
   // a (12,4) configuration using the vandermonde matrix
 
+  // tables of the smaller profiles of the previous tests
+  int cached = std::max(0, tcache.getDecodingTableCacheSize());
+
   ErasureCodeIsaDefault Isa(tcache);
   ErasureCodeProfile profile;
   profile["k"] = "12";
@@ -519,7 +667,10 @@ TEST_F(IsaErasureCodeTest, isa_vandermonde_exhaustive)
     want_to_decode.erase(l1);
   }
   EXPECT_EQ(2516, cnt_cf);
-  EXPECT_EQ(2506, tcache.getDecodingTableCacheSize()); // 3 entries from (2,2) test and 2503 from (12,4)
+  // 2503 entries from (12,4) on top of the previous ones, up to the lru length
+  EXPECT_EQ(std::min(cached + 2503,
+                     ErasureCodeIsaTableCache::decoding_tables_lru_length),
+            tcache.getDecodingTableCacheSize());
 }
 
 TEST_F(IsaErasureCodeTest, isa_cauchy_exhaustive)
@@ -129,6 +129,98 @@ TYPED_TEST(ErasureCodeTest, encode_decode)
   }
 }
 
+TYPED_TEST(ErasureCodeTest, encode_parity_delta)
+{
+  TypeParam jerasure;
+  ErasureCodeProfile profile;
+  profile["k"] = "2";
+  profile["m"] = "2";
+  profile["packetsize"] = "8";
+  jerasure.init(profile, &cerr);
+  ASSERT_TRUE(jerasure.supports_parity_delta());
+
+  unsigned stripe = jerasure.get_chunk_size(1) * 2;
+  set<int> want_to_encode = { 0, 1, 2, 3 };
+  bufferlist in;
+  in.append(string(stripe / 2, 'A'));
+  in.append(string(stripe / 2, 'B'));
+  map<int, bufferlist> encoded;
+  ASSERT_EQ(0, jerasure.encode(want_to_encode, in, &encoded));
+
+  // rewrite the second data chunk and update the parity from the delta
+  bufferlist new_in;
+  new_in.append(string(stripe / 2, 'A'));
+  new_in.append(string(stripe / 2, 'C'));
+  map<int, bufferlist> reencoded;
+  ASSERT_EQ(0, jerasure.encode(want_to_encode, new_in, &reencoded));
+
+  map<int, bufferlist> parity;
+  parity[2] = encoded[2];
+  parity[3] = encoded[3];
+  ASSERT_EQ(0, jerasure.encode_parity_delta(1, encoded[1], reencoded[1],
+					    &parity));
+  EXPECT_TRUE(parity[2].contents_equal(reencoded[2]));
+  EXPECT_TRUE(parity[3].contents_equal(reencoded[3]));
+  // the old parity is left alone
+  bufferlist old_parity = encoded[2];
+  EXPECT_FALSE(old_parity.contents_equal(reencoded[2]));
+
+  // only data chunks can be the source of a delta
+  EXPECT_EQ(-EINVAL, jerasure.encode_parity_delta(2, encoded[1],
+						  reencoded[1], &parity));
+}
+
+TYPED_TEST(ErasureCodeTest, encode_decode_stripes)
+{
+  TypeParam jerasure;
+  ErasureCodeProfile profile;
+  profile["k"] = "2";
+  profile["m"] = "2";
+  profile["packetsize"] = "8";
+  jerasure.init(profile, &cerr);
+  ASSERT_TRUE(jerasure.supports_multi_stripe());
+
+  unsigned chunk = jerasure.get_chunk_size(1);
+  unsigned stripe = chunk * 2;
+  unsigned stripes = 5;
+  bufferlist in;
+  for (unsigned s = 0; s < stripes; s++)
+    in.append(string(stripe, 'a' + s));
+  set<int> want_to_encode = { 0, 1, 2, 3 };
+
+  // one call over all stripes matches one encode per stripe
+  map<int, bufferlist> expected;
+  for (unsigned s = 0; s < stripes; s++) {
+    bufferlist bl;
+    bl.substr_of(in, s * stripe, stripe);
+    map<int, bufferlist> encoded;
+    ASSERT_EQ(0, jerasure.encode(want_to_encode, bl, &encoded));
+    for (auto& i : encoded)
+      expected[i.first].claim_append(i.second);
+  }
+  map<int, bufferlist> shards;
+  ASSERT_EQ(0, jerasure.encode_stripes(want_to_encode, in, stripe, &shards));
+  ASSERT_EQ(4u, shards.size());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(stripes * chunk, shards[i].length());
+    EXPECT_TRUE(shards[i].contents_equal(expected[i]));
+  }
+
+  // and the shards decode whole
+  map<int, bufferlist> degraded = shards;
+  degraded.erase(0);
+  degraded.erase(3);
+  map<int, bufferlist> decoded;
+  ASSERT_EQ(0, jerasure.decode_stripes(set<int>{0, 3}, degraded, chunk,
+				       &decoded));
+  EXPECT_TRUE(decoded[0].contents_equal(shards[0]));
+  EXPECT_TRUE(decoded[3].contents_equal(shards[3]));
+
+  // a stripe that does not split into whole chunks is refused
+  EXPECT_EQ(-EINVAL, jerasure.encode_stripes(want_to_encode, in, stripe + 1,
+					     &shards));
+}
+
 TYPED_TEST(ErasureCodeTest, minimum_to_decode)
 {
   TypeParam jerasure;
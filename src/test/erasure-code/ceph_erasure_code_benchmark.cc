@@ -44,6 +44,11 @@ int ErasureCodeBench::setup(int argc, char** argv) {
     ("verbose,v", "explain what happens")
     ("size,s", po::value<int>()->default_value(1024 * 1024),
      "size of the buffer to be encoded")
+    ("stripe-width", po::value<int>()->default_value(0),
+     "code the buffer as consecutive stripes of this size, one call "
+     "per stripe like the OSD does (0 to code it as a single stripe)")
+    ("batch,b", "with --stripe-width, code all the stripes in a single "
+     "encode_stripes/decode_stripes call")
     ("iterations,i", po::value<int>()->default_value(1),
      "number of encode/decode runs")
     ("plugin,p", po::value<string>()->default_value("jerasure"),
@@ -109,6 +114,8 @@ int ErasureCodeBench::setup(int argc, char** argv) {
   }
 
   in_size = vm["size"].as<int>();
+  stripe_width = vm["stripe-width"].as<int>();
+  batch = vm.count("batch") > 0;
   max_iterations = vm["iterations"].as<int>();
   plugin = vm["plugin"].as<string>();
   workload = vm["workload"].as<string>();
@@ -132,6 +139,12 @@ int ErasureCodeBench::setup(int argc, char** argv) {
     return -EINVAL;
   } 
 
+  if (stripe_width < 0 || (stripe_width > 0 && in_size % stripe_width)) {
+    cout << "size " << in_size << " is not a multiple of stripe width "
+	 << stripe_width << endl;
+    return -EINVAL;
+  }
+
   verbose = vm.count("verbose") > 0 ? true : false;
 
   return 0;
@@ -179,7 +192,10 @@ int ErasureCodeBench::encode()
   utime_t begin_time = ceph_clock_now();
   for (int i = 0; i < max_iterations; i++) {
     map<int,bufferlist> encoded;
-    code = erasure_code->encode(want_to_encode, in, &encoded);
+    if (stripe_width)
+      code = encode_stripes(erasure_code, want_to_encode, in, &encoded);
+    else
+      code = erasure_code->encode(want_to_encode, in, &encoded);
     if (code)
       return code;
   }
@@ -188,6 +204,51 @@ int ErasureCodeBench::encode()
   return 0;
 }
 
+int ErasureCodeBench::encode_stripes(ErasureCodeInterfaceRef erasure_code,
+				     const set<int> &want_to_encode,
+				     const bufferlist &in,
+				     map<int,bufferlist> *encoded)
+{
+  if (batch)
+    return erasure_code->encode_stripes(want_to_encode, in, stripe_width,
+					encoded);
+  for (int offset = 0; offset < in_size; offset += stripe_width) {
+    bufferlist stripe;
+    stripe.substr_of(in, offset, stripe_width);
+    map<int,bufferlist> chunks;
+    int code = erasure_code->encode(want_to_encode, stripe, &chunks);
+    if (code)
+      return code;
+    for (auto& i : chunks)
+      (*encoded)[i.first].claim_append(i.second);
+  }
+  return 0;
+}
+
+int ErasureCodeBench::decode_stripes(ErasureCodeInterfaceRef erasure_code,
+				     const set<int> &want_to_read,
+				     const map<int,bufferlist> &chunks,
+				     map<int,bufferlist> *decoded)
+{
+  unsigned chunk_size = erasure_code->get_chunk_size(stripe_width);
+  if (batch)
+    return erasure_code->decode_stripes(want_to_read, chunks, chunk_size,
+					decoded);
+  unsigned shard_size = chunks.begin()->second.length();
+  for (unsigned offset = 0; offset < shard_size; offset += chunk_size) {
+    map<int,bufferlist> stripe;
+    for (auto& i : chunks)
+      stripe[i.first].substr_of(i.second, offset, chunk_size);
+    map<int,bufferlist> out;
+    int code = erasure_code->decode(want_to_read, stripe, &out, chunk_size);
+    if (code)
+      return code;
+    for (auto& i : out)
+      (*decoded)[i.first].claim_append(i.second);
+  }
+  return 0;
+}
+
 static void display_chunks(const map<int,bufferlist> &chunks,
 			   unsigned int chunk_count) {
   cout << "chunks ";
@@ -281,7 +342,10 @@ int ErasureCodeBench::decode()
   }
 
   map<int,bufferlist> encoded;
-  code = erasure_code->encode(want_to_encode, in, &encoded);
+  if (stripe_width)
+    code = encode_stripes(erasure_code, want_to_encode, in, &encoded);
+  else
+    code = erasure_code->encode(want_to_encode, in, &encoded);
   if (code)
     return code;
 
@@ -303,7 +367,10 @@ int ErasureCodeBench::decode()
 	return code;
     } else if (erased.size() > 0) {
       map<int,bufferlist> decoded;
-      code = erasure_code->decode(want_to_read, encoded, &decoded, 0);
+      if (stripe_width)
+	code = decode_stripes(erasure_code, want_to_read, encoded, &decoded);
+      else
+	code = erasure_code->decode(want_to_read, encoded, &decoded, 0);
       if (code)
 	return code;
     } else {
@@ -316,7 +383,10 @@ int ErasureCodeBench::decode()
 	chunks.erase(erasure);
       }
       map<int,bufferlist> decoded;
-      code = erasure_code->decode(want_to_read, chunks, &decoded, 0);
+      if (stripe_width)
+	code = decode_stripes(erasure_code, want_to_read, chunks, &decoded);
+      else
+	code = erasure_code->decode(want_to_read, chunks, &decoded, 0);
       if (code)
 	return code;
     }
@@ -24,6 +24,8 @@ using namespace std;
 
 class ErasureCodeBench {
   int in_size;
+  int stripe_width;
+  bool batch;
   int max_iterations;
   int erasures;
   int k;
@@ -49,6 +51,14 @@ public:
 		      ErasureCodeInterfaceRef erasure_code);
   int decode();
   int encode();
+  int encode_stripes(ErasureCodeInterfaceRef erasure_code,
+		     const set<int> &want_to_encode,
+		     const bufferlist &in,
+		     map<int,bufferlist> *encoded);
+  int decode_stripes(ErasureCodeInterfaceRef erasure_code,
+		     const set<int> &want_to_read,
+		     const map<int,bufferlist> &chunks,
+		     map<int,bufferlist> *decoded);
 };
 
 #endif
@@ -17,7 +17,7 @@ public:
   TestObjectRecorder()
     : m_flush_interval(std::numeric_limits<uint32_t>::max()),
       m_flush_bytes(std::numeric_limits<uint64_t>::max()),
-      m_flush_age(600)
+      m_flush_age(600), m_max_in_flight_appends(0)
   {
   }
 
@@ -57,6 +57,7 @@ public:
   uint32_t m_flush_interval;
   uint64_t m_flush_bytes;
   double m_flush_age;
+  uint64_t m_max_in_flight_appends;
   Handler m_handler;
 
   void TearDown() override {
@@ -80,6 +81,9 @@ public:
   inline void set_flush_age(double i) {
     m_flush_age = i;
   }
+  inline void set_max_in_flight_appends(uint64_t i) {
+    m_max_in_flight_appends = i;
+  }
 
   journal::AppendBuffer create_append_buffer(uint64_t tag_tid, uint64_t entry_tid,
                                              const std::string &payload) {
@@ -96,7 +100,8 @@ public:
                                            uint8_t order, shared_ptr<Mutex> lock) {
     journal::ObjectRecorderPtr object(new journal::ObjectRecorder(
       m_ioctx, oid, 0, lock, m_work_queue, *m_timer, m_timer_lock, &m_handler,
-      order, m_flush_interval, m_flush_bytes, m_flush_age));
+      order, m_flush_interval, m_flush_bytes, m_flush_age,
+      m_max_in_flight_appends));
     m_object_recorders.push_back(object);
     m_object_recorder_locks.insert(std::make_pair(oid, lock));
     m_handler.object_lock = lock;
@@ -197,6 +202,38 @@ TEST_F(TestObjectRecorder, AppendFlushByBytes) {
   ASSERT_EQ(0, cond.wait());
 }
 
+TEST_F(TestObjectRecorder, AppendMaxInFlight) {
+  std::string oid = get_temp_oid();
+  ASSERT_EQ(0, create(oid));
+  ASSERT_EQ(0, client_register(oid));
+  journal::JournalMetadataPtr metadata = create_metadata(oid);
+  ASSERT_EQ(0, init_metadata(metadata));
+
+  // every append is flushed at once, but only one is sent at a time
+  set_flush_interval(1);
+  set_max_in_flight_appends(1);
+  shared_ptr<Mutex> lock(new Mutex("object_recorder_lock"));
+  journal::ObjectRecorderPtr object = create_object(oid, 24, lock);
+
+  journal::AppendBuffers all_buffers;
+  for (uint64_t entry_tid = 123; entry_tid < 133; ++entry_tid) {
+    journal::AppendBuffer append_buffer = create_append_buffer(234, entry_tid,
+                                                               "payload");
+    all_buffers.push_back(append_buffer);
+    journal::AppendBuffers append_buffers = {append_buffer};
+    lock->Lock();
+    ASSERT_FALSE(object->append_unlock(std::move(append_buffers)));
+    ASSERT_EQ(0U, object->get_pending_appends());
+  }
+
+  C_SaferCond cond;
+  all_buffers.back().first->wait(&cond);
+  ASSERT_EQ(0, cond.wait());
+  for (auto &append_buffer : all_buffers) {
+    ASSERT_TRUE(append_buffer.first->is_complete());
+  }
+}
+
 TEST_F(TestObjectRecorder, AppendFlushByAge) {
   std::string oid = get_temp_oid();
   ASSERT_EQ(0, create(oid));
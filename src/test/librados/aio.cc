@@ -788,6 +788,113 @@ TEST(LibRadosAioPP, RemoveTestPP) {
   ASSERT_EQ(-ENOENT, test_data.m_ioctx.read("foo", bl2, sizeof(buf), 0));
 }
 
+TEST(LibRadosAioPP, OperateBatchPP) {
+  AioTestDataPP test_data;
+  ASSERT_EQ("", test_data.init());
+  bufferlist bl;
+  bl.append("batch");
+  ASSERT_EQ(0, test_data.m_ioctx.write_full("exists", bl));
+
+  std::vector<std::string> oids;
+  std::vector<ObjectWriteOperation> ops(3);
+  std::vector<ObjectWriteOperation*> pops;
+  for (unsigned i = 0; i < 2; ++i) {
+    oids.push_back("batch" + stringify(i));
+    ops[i].write_full(bl);
+  }
+  oids.push_back("exists");
+  ops[2].create(true);  // exclusive, so this one fails
+  for (auto& op : ops)
+    pops.push_back(&op);
+
+  boost::scoped_ptr<AioCompletion> my_completion
+    (test_data.m_cluster.aio_create_completion
+     ((void*)&test_data, set_completion_completePP, set_completion_safePP));
+  std::vector<int> rvals;
+  ASSERT_EQ(0, test_data.m_ioctx.aio_operate_batch(oids, pops,
+						   my_completion.get(),
+						   &rvals, 0));
+  {
+    TestAlarm alarm;
+    ASSERT_EQ(0, my_completion->wait_for_complete());
+  }
+  ASSERT_EQ(-EEXIST, my_completion->get_return_value());
+  ASSERT_EQ(3u, rvals.size());
+  ASSERT_EQ(0, rvals[0]);
+  ASSERT_EQ(0, rvals[1]);
+  ASSERT_EQ(-EEXIST, rvals[2]);
+
+  for (unsigned i = 0; i < 2; ++i) {
+    bufferlist out;
+    ASSERT_EQ((int)bl.length(), test_data.m_ioctx.read(oids[i], out, 0, 0));
+    ASSERT_TRUE(out.contents_equal(bl));
+  }
+}
+
+TEST(LibRadosAioPP, CompletionQueuePP) {
+  AioTestDataPP test_data;
+  ASSERT_EQ("", test_data.init());
+  bufferlist bl;
+  bl.append("queued");
+
+  AioCompletionQueue cq;
+  std::set<AioCompletion*> pending;
+  for (unsigned i = 0; i < 8; ++i) {
+    AioCompletion *c = Rados::aio_create_completion(&cq);
+    ASSERT_EQ(0, test_data.m_ioctx.aio_write_full("cq" + stringify(i), c, bl));
+    pending.insert(c);
+  }
+
+  // nothing extra shows up once everything is reaped
+  AioCompletion *reaped[8];
+  while (!pending.empty()) {
+    TestAlarm alarm;
+    int n = cq.wait(1, 8, reaped, nullptr);
+    ASSERT_LT(0, n);
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(1u, pending.erase(reaped[i]));
+      ASSERT_TRUE(reaped[i]->is_complete());
+      ASSERT_EQ(0, reaped[i]->get_return_value());
+      reaped[i]->release();
+    }
+  }
+  struct timespec ts = { 0, 1000000 };
+  ASSERT_EQ(0, cq.wait(1, 8, reaped, &ts));
+}
+
+TEST(LibRadosAioPP, LatencyPP) {
+  AioTestDataPP test_data;
+  ASSERT_EQ("", test_data.init());
+  bufferlist bl;
+  bl.append("timed");
+
+  // nothing is recorded unless asked for
+  AioCompletion *c = Rados::aio_create_completion();
+  ASSERT_EQ(0, test_data.m_ioctx.aio_write_full("lat", c, bl));
+  {
+    TestAlarm alarm;
+    ASSERT_EQ(0, c->wait_for_complete());
+  }
+  struct rados_aio_latency lat;
+  ASSERT_EQ(-ENODATA, c->get_latency(&lat));
+  c->release();
+
+  ASSERT_EQ(0, test_data.m_cluster.conf_set("objecter_op_latency_stages",
+					    "true"));
+  c = Rados::aio_create_completion();
+  ASSERT_EQ(0, test_data.m_ioctx.aio_write_full("lat", c, bl));
+  {
+    TestAlarm alarm;
+    ASSERT_EQ(0, c->wait_for_complete());
+  }
+  ASSERT_EQ(0, c->get_latency(&lat));
+  ASSERT_LT(0u, lat.osd_ns);
+  ASSERT_EQ(0u, lat.dispatch_ns);
+  c->release();
+  ASSERT_EQ(0, test_data.m_cluster.conf_set("objecter_op_latency_stages",
+					    "false"));
+}
+
 TEST(LibRadosAio, XattrsRoundTrip) {
   char buf[128];
   char attr1[] = "attr1";
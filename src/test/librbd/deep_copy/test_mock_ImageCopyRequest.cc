@@ -9,6 +9,7 @@
 #include "librbd/deep_copy/ImageCopyRequest.h"
 #include "librbd/deep_copy/ObjectCopyRequest.h"
 #include "librbd/internal.h"
+#include "librbd/object_map/DiffRequest.h"
 #include "test/librados_test_stub/MockTestMemIoCtxImpl.h"
 #include "test/librbd/mock/MockImageCtx.h"
 #include "test/librbd/test_support.h"
@@ -59,6 +60,35 @@ struct ObjectCopyRequest<librbd::MockTestImageCtx> {
 ObjectCopyRequest<librbd::MockTestImageCtx>* ObjectCopyRequest<librbd::MockTestImageCtx>::s_instance = nullptr;
 
 } // namespace deep_copy
+
+namespace object_map {
+
+template <>
+struct DiffRequest<librbd::MockTestImageCtx> {
+  static DiffRequest* s_instance;
+  static DiffRequest* create(librbd::MockTestImageCtx &image_ctx,
+                             uint64_t snap_id_start, uint64_t snap_id_end,
+                             ceph::BitVector<2> *object_diff_state,
+                             Context *on_finish) {
+    assert(s_instance != nullptr);
+    s_instance->object_diff_state = object_diff_state;
+    s_instance->on_finish = on_finish;
+    return s_instance;
+  }
+
+  ceph::BitVector<2> *object_diff_state = nullptr;
+  Context *on_finish = nullptr;
+
+  DiffRequest() {
+    s_instance = this;
+  }
+
+  MOCK_METHOD0(send, void());
+};
+
+DiffRequest<librbd::MockTestImageCtx>* DiffRequest<librbd::MockTestImageCtx>::s_instance = nullptr;
+
+} // namespace object_map
 } // namespace librbd
 
 // template definitions
@@ -70,12 +100,14 @@ namespace deep_copy {
 
 using ::testing::_;
 using ::testing::InSequence;
+using ::testing::Invoke;
 using ::testing::Return;
 
 class TestMockDeepCopyImageCopyRequest : public TestMockFixture {
 public:
   typedef ImageCopyRequest<librbd::MockTestImageCtx> MockImageCopyRequest;
   typedef ObjectCopyRequest<librbd::MockTestImageCtx> MockObjectCopyRequest;
+  typedef object_map::DiffRequest<librbd::MockTestImageCtx> MockDiffRequest;
 
   librbd::ImageCtx *m_src_image_ctx;
   librbd::ImageCtx *m_dst_image_ctx;
@@ -98,6 +130,17 @@ public:
                                                &m_thread_pool, &m_work_queue);
   }
 
+  void expect_diff_send(MockDiffRequest &mock_diff_request,
+                        const ceph::BitVector<2> &diff_state, int r) {
+    EXPECT_CALL(mock_diff_request, send())
+      .WillOnce(Invoke([this, &mock_diff_request, diff_state, r]() {
+          if (r >= 0) {
+            *mock_diff_request.object_diff_state = diff_state;
+          }
+          m_work_queue->queue(mock_diff_request.on_finish, r);
+        }));
+  }
+
   void expect_get_image_size(librbd::MockTestImageCtx &mock_image_ctx,
                              uint64_t size) {
     EXPECT_CALL(mock_image_ctx, get_image_size(_))
@@ -202,8 +245,10 @@ TEST_F(TestMockDeepCopyImageCopyRequest, SimpleImage) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
   InSequence seq;
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx, 1 << m_src_image_ctx->order);
   expect_get_image_size(mock_src_image_ctx, 0);
   expect_object_copy_send(mock_object_copy_request);
@@ -221,6 +266,54 @@ TEST_F(TestMockDeepCopyImageCopyRequest, SimpleImage) {
   ASSERT_EQ(0, ctx.wait());
 }
 
+TEST_F(TestMockDeepCopyImageCopyRequest, FastDiff) {
+  librados::snap_t snap_id_end;
+  ASSERT_EQ(0, create_snap("copy", &snap_id_end));
+
+  librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
+  librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
+  MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
+
+  ceph::BitVector<2> diff_state;
+  diff_state.resize(4);
+  diff_state[0] = object_map::DIFF_STATE_NONE;
+  diff_state[1] = object_map::DIFF_STATE_UPDATED;
+  diff_state[2] = object_map::DIFF_STATE_NONE;
+  diff_state[3] = object_map::DIFF_STATE_HOLE;
+
+  InSequence seq;
+  expect_diff_send(mock_diff_request, diff_state, 0);
+  expect_get_image_size(mock_src_image_ctx, 4 * (1 << m_src_image_ctx->order));
+  expect_get_image_size(mock_src_image_ctx, 0);
+  EXPECT_CALL(mock_object_copy_request, send()).Times(2);
+
+  struct ProgressContext : public librbd::ProgressContext {
+    uint64_t object_no = 0;
+
+    int update_progress(uint64_t object_no, uint64_t end_object_no) override {
+      EXPECT_EQ(this->object_no + 1, object_no);
+      this->object_no = object_no;
+      return 0;
+    }
+  } prog_ctx;
+
+  C_SaferCond ctx;
+  auto request = new MockImageCopyRequest(&mock_src_image_ctx,
+                                          &mock_dst_image_ctx,
+                                          0, snap_id_end, boost::none,
+                                          m_snap_seqs, &prog_ctx, &ctx);
+  request->send();
+
+  ASSERT_EQ(m_snap_map, wait_for_snap_map(mock_object_copy_request));
+  ASSERT_TRUE(complete_object_copy(mock_object_copy_request, 1, 0));
+  ASSERT_TRUE(complete_object_copy(mock_object_copy_request, 3, 0));
+  ASSERT_EQ(0, ctx.wait());
+  ASSERT_EQ(4U, prog_ctx.object_no);
+  ASSERT_EQ(0U, mock_object_copy_request.object_contexts.count(0));
+  ASSERT_EQ(0U, mock_object_copy_request.object_contexts.count(2));
+}
+
 TEST_F(TestMockDeepCopyImageCopyRequest, Throttled) {
   librados::snap_t snap_id_end;
   ASSERT_EQ(0, create_snap("copy", &snap_id_end));
@@ -230,7 +323,9 @@ TEST_F(TestMockDeepCopyImageCopyRequest, Throttled) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx,
                         object_count * (1 << m_src_image_ctx->order));
   expect_get_image_size(mock_src_image_ctx, 0);
@@ -292,8 +387,10 @@ TEST_F(TestMockDeepCopyImageCopyRequest, SnapshotSubset) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
   InSequence seq;
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx, 1 << m_src_image_ctx->order);
   expect_get_image_size(mock_src_image_ctx, 0);
   expect_get_image_size(mock_src_image_ctx, 0);
@@ -324,8 +421,10 @@ TEST_F(TestMockDeepCopyImageCopyRequest, RestartPartialSync) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
   InSequence seq;
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx, 2 * (1 << m_src_image_ctx->order));
   expect_get_image_size(mock_src_image_ctx, 0);
   expect_object_copy_send(mock_object_copy_request);
@@ -358,8 +457,10 @@ TEST_F(TestMockDeepCopyImageCopyRequest, Cancel) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
   InSequence seq;
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx, 1 << m_src_image_ctx->order);
   expect_get_image_size(mock_src_image_ctx, 0);
   expect_object_copy_send(mock_object_copy_request);
@@ -394,8 +495,10 @@ TEST_F(TestMockDeepCopyImageCopyRequest, Cancel_Inflight_Sync) {
   librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
   librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
   MockObjectCopyRequest mock_object_copy_request;
+  MockDiffRequest mock_diff_request;
 
   InSequence seq;
+  expect_diff_send(mock_diff_request, {}, -EINVAL);
   expect_get_image_size(mock_src_image_ctx, 6 * (1 << m_src_image_ctx->order));
   expect_get_image_size(mock_src_image_ctx, m_image_size);
 
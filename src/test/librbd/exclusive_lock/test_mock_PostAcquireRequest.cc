@@ -4,6 +4,7 @@
 #include "test/librbd/test_mock_fixture.h"
 #include "test/librbd/test_support.h"
 #include "test/librbd/mock/MockImageCtx.h"
+#include "test/librbd/mock/cache/MockImageCache.h"
 #include "test/librbd/mock/MockImageState.h"
 #include "test/librbd/mock/MockJournal.h"
 #include "test/librbd/mock/MockJournalPolicy.h"
@@ -168,6 +169,18 @@ public:
                   .WillOnce(CompleteContext(r, mock_image_ctx.image_ctx->op_work_queue));
   }
 
+  void expect_create_image_cache(MockTestImageCtx &mock_image_ctx,
+                                 cache::MockImageCache *mock_image_cache) {
+    EXPECT_CALL(mock_image_ctx, create_image_cache())
+                  .WillOnce(Return(mock_image_cache));
+  }
+
+  void expect_init_image_cache(MockTestImageCtx &mock_image_ctx,
+                               cache::MockImageCache &mock_image_cache, int r) {
+    EXPECT_CALL(mock_image_cache, init(_))
+                  .WillOnce(CompleteContext(r, mock_image_ctx.image_ctx->op_work_queue));
+  }
+
   void expect_handle_prepare_lock_complete(MockTestImageCtx &mock_image_ctx) {
     EXPECT_CALL(*mock_image_ctx.state, handle_prepare_lock_complete());
   }
@@ -274,6 +287,80 @@ TEST_F(TestMockExclusiveLockPostAcquireRequest, SuccessJournalDisabled) {
   ASSERT_EQ(0, ctx.wait());
 }
 
+TEST_F(TestMockExclusiveLockPostAcquireRequest, SuccessImageCache) {
+  REQUIRE_FEATURE(RBD_FEATURE_EXCLUSIVE_LOCK);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.persistent_cache_enabled = true;
+  mock_image_ctx.read_only = false;
+  expect_op_work_queue(mock_image_ctx);
+
+  InSequence seq;
+  expect_is_refresh_required(mock_image_ctx, false);
+  expect_test_features(mock_image_ctx, RBD_FEATURE_OBJECT_MAP, false);
+
+  cache::MockImageCache *mock_image_cache = new cache::MockImageCache();
+  expect_test_features(mock_image_ctx, RBD_FEATURE_JOURNALING,
+                       mock_image_ctx.snap_lock, false);
+  expect_create_image_cache(mock_image_ctx, mock_image_cache);
+  expect_init_image_cache(mock_image_ctx, *mock_image_cache, 0);
+
+  expect_test_features(mock_image_ctx, RBD_FEATURE_JOURNALING,
+                       mock_image_ctx.snap_lock, false);
+  expect_handle_prepare_lock_complete(mock_image_ctx);
+
+  C_SaferCond acquire_ctx;
+  C_SaferCond ctx;
+  MockPostAcquireRequest *req = MockPostAcquireRequest::create(mock_image_ctx,
+                                                               &acquire_ctx,
+                                                               &ctx);
+  req->send();
+  ASSERT_EQ(0, acquire_ctx.wait());
+  ASSERT_EQ(0, ctx.wait());
+  ASSERT_EQ(mock_image_cache, mock_image_ctx.image_cache);
+  delete mock_image_ctx.image_cache;
+  mock_image_ctx.image_cache = nullptr;
+}
+
+TEST_F(TestMockExclusiveLockPostAcquireRequest, ImageCacheError) {
+  REQUIRE_FEATURE(RBD_FEATURE_EXCLUSIVE_LOCK);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.persistent_cache_enabled = true;
+  mock_image_ctx.read_only = false;
+  expect_op_work_queue(mock_image_ctx);
+
+  InSequence seq;
+  expect_is_refresh_required(mock_image_ctx, false);
+  expect_test_features(mock_image_ctx, RBD_FEATURE_OBJECT_MAP, false);
+
+  cache::MockImageCache *mock_image_cache = new cache::MockImageCache();
+  expect_test_features(mock_image_ctx, RBD_FEATURE_JOURNALING,
+                       mock_image_ctx.snap_lock, false);
+  expect_create_image_cache(mock_image_ctx, mock_image_cache);
+  expect_init_image_cache(mock_image_ctx, *mock_image_cache, -EACCES);
+
+  expect_test_features(mock_image_ctx, RBD_FEATURE_JOURNALING,
+                       mock_image_ctx.snap_lock, false);
+  expect_handle_prepare_lock_complete(mock_image_ctx);
+
+  C_SaferCond acquire_ctx;
+  C_SaferCond ctx;
+  MockPostAcquireRequest *req = MockPostAcquireRequest::create(mock_image_ctx,
+                                                               &acquire_ctx,
+                                                               &ctx);
+  req->send();
+  ASSERT_EQ(0, acquire_ctx.wait());
+  ASSERT_EQ(0, ctx.wait());
+  ASSERT_EQ(nullptr, mock_image_ctx.image_cache);
+}
+
 TEST_F(TestMockExclusiveLockPostAcquireRequest, SuccessObjectMapDisabled) {
   REQUIRE_FEATURE(RBD_FEATURE_EXCLUSIVE_LOCK);
 
@@ -256,6 +256,56 @@ TEST_F(TestMockIoImageRequest, AioWriteJournalAppendDisabled) {
   ASSERT_EQ(0, aio_comp_ctx.wait());
 }
 
+TEST_F(TestMockIoImageRequest, AioWriteJournalConcurrentIO) {
+  REQUIRE_FEATURE(RBD_FEATURE_JOURNALING);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+  REQUIRE(!ictx->cache);
+
+  MockObjectRequest mock_aio_object_request;
+  MockTestImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.journal_concurrent_io = true;
+  MockJournal mock_journal;
+  mock_image_ctx.journal = &mock_journal;
+
+  // the object write goes out without waiting for the event to be safe
+  Context *on_safe = nullptr;
+  InSequence seq;
+  expect_is_journal_appending(mock_journal, true);
+  EXPECT_CALL(mock_journal, append_write_event(0, 1, _, _, false))
+    .WillOnce(Invoke([](uint64_t, size_t, const bufferlist &,
+                        const MockJournal::ObjectRequests &requests, bool) {
+                       EXPECT_TRUE(requests.empty());
+                       return 1;
+                     }));
+  EXPECT_CALL(mock_journal, wait_event(1, _))
+    .WillOnce(WithArg<1>(Invoke([&on_safe](Context *ctx) {
+                           on_safe = ctx;
+                         })));
+  expect_object_request_send(mock_image_ctx, mock_aio_object_request, 0);
+
+  C_SaferCond aio_comp_ctx;
+  AioCompletion *aio_comp = AioCompletion::create_and_start(
+    &aio_comp_ctx, ictx, AIO_TYPE_WRITE);
+
+  bufferlist bl;
+  bl.append("1");
+  MockImageWriteRequest mock_aio_image_write(mock_image_ctx, aio_comp,
+                                             {{0, 1}}, std::move(bl), 0, {});
+  {
+    RWLock::RLocker owner_locker(mock_image_ctx.owner_lock);
+    mock_aio_image_write.send();
+  }
+
+  // ... but the write is only acknowledged once it is
+  ictx->op_work_queue->drain();
+  ASSERT_FALSE(aio_comp->is_complete());
+  ASSERT_TRUE(on_safe != nullptr);
+  on_safe->complete(0);
+  ASSERT_EQ(0, aio_comp_ctx.wait());
+}
+
 TEST_F(TestMockIoImageRequest, AioDiscardJournalAppendDisabled) {
   REQUIRE_FEATURE(RBD_FEATURE_JOURNALING);
 
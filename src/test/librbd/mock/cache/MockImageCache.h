@@ -48,6 +48,9 @@ struct MockImageCache {
     aio_compare_and_write_mock(image_extents, cmp_bl, bl, mismatch_offset,
                                fadvise_flags, on_finish);
   }
+
+  MOCK_METHOD1(init, void(Context *));
+  MOCK_METHOD1(shut_down, void(Context *));
 };
 
 } // namespace cache
@@ -0,0 +1,230 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "test/librbd/test_mock_fixture.h"
+#include "test/librbd/test_support.h"
+#include "test/librbd/mock/MockImageCtx.h"
+#include "test/librados_test_stub/MockTestMemIoCtxImpl.h"
+#include "common/bit_vector.hpp"
+#include "include/rbd/object_map_types.h"
+#include "librbd/ObjectMap.h"
+#include "librbd/object_map/DiffRequest.h"
+
+// template definitions
+#include "librbd/object_map/DiffRequest.cc"
+
+namespace librbd {
+namespace object_map {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::InSequence;
+using ::testing::Return;
+using ::testing::StrEq;
+using ::testing::WithArg;
+
+class TestMockObjectMapDiffRequest : public TestMockFixture {
+public:
+  typedef DiffRequest<MockImageCtx> MockDiffRequest;
+
+  uint64_t object_size(MockImageCtx &mock_image_ctx) {
+    return mock_image_ctx.layout.object_size;
+  }
+
+  void add_snap(MockImageCtx &mock_image_ctx, uint64_t snap_id,
+                uint64_t size, uint64_t flags = 0) {
+    mock_image_ctx.snap_info.insert(
+      {snap_id, {"snap" + stringify(snap_id), cls::rbd::UserSnapshotNamespace(),
+                 size, {}, 0, flags, {}}});
+  }
+
+  void expect_test_features(MockImageCtx &mock_image_ctx, bool enabled) {
+    EXPECT_CALL(mock_image_ctx, test_features(RBD_FEATURE_FAST_DIFF, _))
+      .WillOnce(Return(enabled));
+  }
+
+  void expect_object_map_load(MockImageCtx &mock_image_ctx, uint64_t snap_id,
+                              ceph::BitVector<2> object_map, int r) {
+    std::string oid(ObjectMap<>::object_map_name(mock_image_ctx.id, snap_id));
+    auto &expect = EXPECT_CALL(get_mock_io_ctx(mock_image_ctx.md_ctx),
+                               exec(oid, _, StrEq("rbd"),
+                                    StrEq("object_map_load"), _, _, _));
+    if (r < 0) {
+      expect.WillOnce(Return(r));
+    } else {
+      object_map.set_crc_enabled(false);
+
+      bufferlist bl;
+      ::encode(object_map, bl);
+
+      std::string str(bl.c_str(), bl.length());
+      expect.WillOnce(DoAll(WithArg<5>(CopyInBufferlist(str)), Return(0)));
+    }
+  }
+
+  ceph::BitVector<2> make_object_map(std::initializer_list<uint8_t> states) {
+    ceph::BitVector<2> object_map;
+    object_map.resize(states.size());
+    uint64_t i = 0;
+    for (auto state : states) {
+      object_map[i++] = state;
+    }
+    return object_map;
+  }
+};
+
+TEST_F(TestMockObjectMapDiffRequest, FullDelta) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.snap_info.clear();
+  mock_image_ctx.size = 3 * object_size(mock_image_ctx);
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, true);
+  expect_object_map_load(mock_image_ctx, CEPH_NOSNAP,
+                         make_object_map({OBJECT_EXISTS, OBJECT_NONEXISTENT,
+                                          OBJECT_EXISTS_CLEAN}), 0);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 0, CEPH_NOSNAP,
+                                 &object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(0, ctx.wait());
+
+  ASSERT_EQ(make_object_map({DIFF_STATE_UPDATED, DIFF_STATE_NONE,
+                             DIFF_STATE_UPDATED}), object_diff_state);
+}
+
+TEST_F(TestMockObjectMapDiffRequest, IntermediateDelta) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.snap_info.clear();
+  add_snap(mock_image_ctx, 1, 4 * object_size(mock_image_ctx));
+  add_snap(mock_image_ctx, 2, 5 * object_size(mock_image_ctx));
+  add_snap(mock_image_ctx, 3, 5 * object_size(mock_image_ctx));
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, true);
+  expect_object_map_load(mock_image_ctx, 1,
+                         make_object_map({OBJECT_EXISTS, OBJECT_EXISTS,
+                                          OBJECT_NONEXISTENT, OBJECT_EXISTS}),
+                         0);
+  expect_object_map_load(mock_image_ctx, 2,
+                         make_object_map({OBJECT_EXISTS_CLEAN, OBJECT_EXISTS,
+                                          OBJECT_EXISTS, OBJECT_NONEXISTENT,
+                                          OBJECT_NONEXISTENT}), 0);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 1, 2, &object_diff_state,
+                                 &ctx);
+  req->send();
+  ASSERT_EQ(0, ctx.wait());
+
+  ASSERT_EQ(make_object_map({DIFF_STATE_NONE, DIFF_STATE_UPDATED,
+                             DIFF_STATE_UPDATED, DIFF_STATE_HOLE,
+                             DIFF_STATE_NONE}), object_diff_state);
+}
+
+TEST_F(TestMockObjectMapDiffRequest, Shrink) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.snap_info.clear();
+  mock_image_ctx.size = 2 * object_size(mock_image_ctx);
+  add_snap(mock_image_ctx, 1, 3 * object_size(mock_image_ctx));
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, true);
+  expect_object_map_load(mock_image_ctx, 1,
+                         make_object_map({OBJECT_EXISTS, OBJECT_NONEXISTENT,
+                                          OBJECT_EXISTS}), 0);
+  expect_object_map_load(mock_image_ctx, CEPH_NOSNAP,
+                         make_object_map({OBJECT_EXISTS_CLEAN,
+                                          OBJECT_NONEXISTENT}), 0);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 1, CEPH_NOSNAP,
+                                 &object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(0, ctx.wait());
+
+  ASSERT_EQ(make_object_map({DIFF_STATE_NONE, DIFF_STATE_NONE,
+                             DIFF_STATE_HOLE}), object_diff_state);
+}
+
+TEST_F(TestMockObjectMapDiffRequest, FastDiffDisabled) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, false);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 0, CEPH_NOSNAP,
+                                 &object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(-EINVAL, ctx.wait());
+}
+
+TEST_F(TestMockObjectMapDiffRequest, FastDiffInvalid) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.snap_info.clear();
+  add_snap(mock_image_ctx, 1, object_size(mock_image_ctx),
+           RBD_FLAG_FAST_DIFF_INVALID);
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, true);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 1, CEPH_NOSNAP,
+                                 &object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(-EINVAL, ctx.wait());
+}
+
+TEST_F(TestMockObjectMapDiffRequest, LoadObjectMapError) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.snap_info.clear();
+
+  InSequence seq;
+  expect_test_features(mock_image_ctx, true);
+  expect_object_map_load(mock_image_ctx, CEPH_NOSNAP, {}, -ENOENT);
+
+  ceph::BitVector<2> object_diff_state;
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(mock_image_ctx, 0, CEPH_NOSNAP,
+                                 &object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(-ENOENT, ctx.wait());
+}
+
+} // namespace object_map
+} // namespace librbd
@@ -145,3 +145,46 @@ TEST(pgmap, dump_object_stat_sum_2)
   ASSERT_EQ(stringify(si_t(avail/pool.size)), tbl.get(0, col++));
   ASSERT_EQ(stringify(0), tbl.get(0, col++));
 }
+
+// a stats-only update must leave the per-osd accounting intact, and a
+// remap must still move it
+TEST(pgmap, apply_incremental_sameosds)
+{
+  PGMap pg_map;
+  pg_t pgid(0, 1);
+  pg_stat_t s;
+  s.state = PG_STATE_ACTIVE;
+  s.up = s.acting = {0, 1};
+  s.up_primary = s.acting_primary = 0;
+  s.stats.sum.num_objects = 1;
+
+  PGMap::Incremental inc;
+  inc.version = 1;
+  inc.pg_stat_updates[pgid] = s;
+  pg_map.apply_incremental(nullptr, inc);
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(0));
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(1));
+  ASSERT_EQ(1, pg_map.get_num_primary_pg_by_osd(0));
+
+  s.stats.sum.num_objects = 5;
+  inc = PGMap::Incremental();
+  inc.version = 2;
+  inc.pg_stat_updates[pgid] = s;
+  pg_map.apply_incremental(nullptr, inc);
+  ASSERT_EQ(5, pg_map.pg_sum.stats.sum.num_objects);
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(0));
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(1));
+  ASSERT_EQ(1, pg_map.get_num_primary_pg_by_osd(0));
+
+  s.up = s.acting = {1, 2};
+  s.up_primary = s.acting_primary = 1;
+  inc = PGMap::Incremental();
+  inc.version = 3;
+  inc.pg_stat_updates[pgid] = s;
+  pg_map.apply_incremental(nullptr, inc);
+  ASSERT_EQ(0u, pg_map.get_num_pg_by_osd(0));
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(1));
+  ASSERT_EQ(1u, pg_map.get_num_pg_by_osd(2));
+  ASSERT_EQ(0, pg_map.get_num_primary_pg_by_osd(0));
+  ASSERT_EQ(1, pg_map.get_num_primary_pg_by_osd(1));
+}
@@ -1444,6 +1444,57 @@ class MarkdownDispatcher : public Dispatcher {
 
 
 // Markdown with external lock
+TEST_P(MessengerTest, LaneTest) {
+  FakeDispatcher cli_dispatcher(false), srv_dispatcher(true);
+  entity_addr_t bind_addr;
+  bind_addr.parse("127.0.0.1");
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  g_ceph_context->_conf->set_val("ms_async_peer_lanes", "4");
+  ConnectionRef conn = client_msgr->get_connection(server_msgr->get_myinst());
+  vector<ConnectionRef> lanes;
+  for (uint32_t h = 0; h < 4; ++h)
+    lanes.push_back(client_msgr->get_connection_lane(server_msgr->get_myinst(), h));
+  // the same hash keeps using the same connection
+  ASSERT_EQ(lanes[1], client_msgr->get_connection_lane(server_msgr->get_myinst(), 5));
+  ASSERT_EQ(lanes[0], conn);
+  if (string(GetParam()) == "simple") {
+    for (auto& c : lanes)
+      ASSERT_EQ(c, conn);
+  } else {
+    ASSERT_NE(lanes[1], conn);
+    ASSERT_NE(lanes[1], lanes[2]);
+  }
+
+  // every lane is an independent, working session
+  for (auto& c : lanes) {
+    MPing *m = new MPing();
+    ASSERT_EQ(c->send_message(m), 0);
+    Mutex::Locker l(cli_dispatcher.lock);
+    while (!cli_dispatcher.got_new)
+      cli_dispatcher.cond.Wait(cli_dispatcher.lock);
+    cli_dispatcher.got_new = false;
+  }
+  for (auto& c : lanes)
+    ASSERT_TRUE(c->is_connected());
+
+  // marking the peer down takes all of its lanes with it
+  client_msgr->mark_down(server_msgr->get_myaddr());
+  for (auto& c : lanes)
+    ASSERT_FALSE(c->is_connected());
+
+  g_ceph_context->_conf->set_val("ms_async_peer_lanes", "1");
+  client_msgr->shutdown();
+  client_msgr->wait();
+  server_msgr->shutdown();
+  server_msgr->wait();
+}
+
 TEST_P(MessengerTest, MarkdownTest) {
   Messenger *server_msgr2 = Messenger::create(g_ceph_context, string(GetParam()), entity_name_t::OSD(0), "server", getpid(), 0);
   MarkdownDispatcher cli_dispatcher(false), srv_dispatcher(true);
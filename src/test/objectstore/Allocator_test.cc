@@ -218,7 +218,7 @@ TEST_P(AllocTest, test_alloc_big)
 
 TEST_P(AllocTest, test_alloc_hint_bmap)
 {
-  if (GetParam() == std::string("stupid")) {
+  if (GetParam() != std::string("bitmap")) {
     return;
   }
   int64_t blocks = BitMapArea::get_level_factor(g_ceph_context, 2) * 4;
@@ -290,11 +290,51 @@ TEST_P(AllocTest, test_alloc_non_aligned_len)
   EXPECT_EQ(want_size, alloc->allocate(want_size, alloc_unit, 0, &extents));
 }
 
+TEST_P(AllocTest, test_alloc_fragmentation)
+{
+  if (GetParam() == std::string("bitmap")) {
+    return;
+  }
+  uint64_t capacity = 4 * 1024 * 1024;
+  uint64_t alloc_unit = 4096;
+  uint64_t want_size = alloc_unit;
+  init_alloc(capacity, alloc_unit);
+  alloc->init_add_free(0, capacity);
+  EXPECT_EQ(0.0, alloc->get_fragmentation(alloc_unit));
+
+  // allocate everything, one unit at a time
+  AllocExtentVector allocated;
+  for (uint64_t i = 0; i < capacity / alloc_unit; ++i) {
+    EXPECT_EQ(0, alloc->reserve(want_size));
+    AllocExtentVector extents;
+    EXPECT_EQ(want_size, alloc->allocate(want_size, alloc_unit, 0, &extents));
+    ASSERT_EQ(1u, extents.size());
+    allocated.push_back(extents[0]);
+  }
+  EXPECT_EQ(0u, alloc->get_free());
+
+  // releasing every other unit leaves the free space maximally fragmented
+  for (size_t i = 0; i < allocated.size(); i += 2) {
+    interval_set<uint64_t> release_set;
+    release_set.insert(allocated[i].offset, allocated[i].length);
+    alloc->release(release_set);
+  }
+  EXPECT_EQ(1.0, alloc->get_fragmentation(alloc_unit));
+
+  // releasing the rest merges it back into a single extent
+  for (size_t i = 1; i < allocated.size(); i += 2) {
+    interval_set<uint64_t> release_set;
+    release_set.insert(allocated[i].offset, allocated[i].length);
+    alloc->release(release_set);
+  }
+  EXPECT_EQ(capacity, alloc->get_free());
+  EXPECT_EQ(0.0, alloc->get_fragmentation(alloc_unit));
+}
 
 INSTANTIATE_TEST_CASE_P(
   Allocator,
   AllocTest,
-  ::testing::Values("stupid", "bitmap"));
+  ::testing::Values("stupid", "bitmap", "avl"));
 
 #else
 
@@ -0,0 +1,404 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ * Replays the transaction shapes the osd builds for rbd, rgw and
+ * cephfs clients against an object store, and reports the commit
+ * latency of each workload along with the store's own per stage
+ * latencies (the state_*_lat counters of bluestore).
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/Cond.h"
+#include "common/errno.h"
+#include "common/Formatter.h"
+#include "common/perf_counters.h"
+#include "global/global_init.h"
+#include "include/random.h"
+#include "include/stringify.h"
+#include "os/ObjectStore.h"
+
+using namespace std;
+
+static void usage(const char *name)
+{
+  cout << "usage: " << name << " [options] <rbd|rbd_snap|rgw|cephfs|all>\n"
+       << "  --ops N          transactions per workload (default 10000)\n"
+       << "  --in-flight N    transactions queued at once (default 16)\n"
+       << "  --objects N      objects the workload spreads over (default 256)\n"
+       << "the store is the one osd_objectstore and osd_data point to, and\n"
+       << "is created from scratch." << std::endl;
+}
+
+static ghobject_t make_oid(const string& prefix, unsigned n,
+			   snapid_t snap = CEPH_NOSNAP)
+{
+  // in pool 1, the pool of the bench collection
+  return ghobject_t(hobject_t(prefix + stringify(n), "", snap, 0, 1, ""));
+}
+
+static bufferlist make_bl(unsigned len, char c)
+{
+  bufferlist bl;
+  bl.append(bufferptr(buffer::create_page_aligned(len)));
+  memset(bl.c_str(), c, len);
+  return bl;
+}
+
+class WorkloadBench {
+  ObjectStore *store;
+  spg_t pgid;
+  coll_t cid;
+  ghobject_t pgmeta;		///< pg log and info, like the osd's pgmeta
+  ObjectStore::Sequencer osr;
+  unsigned num_objects;
+  unsigned max_in_flight;
+
+  Mutex lock;
+  Cond cond;
+  unsigned in_flight = 0;
+  vector<double> latencies;
+
+  // what the osd adds to every client write
+  bufferlist oi_bl = make_bl(256, 'o');	///< object_info_t
+  bufferlist ss_bl = make_bl(48, 's');	///< SnapSet
+  bufferlist log_bl = make_bl(180, 'l');	///< pg log entry
+  uint64_t version = 0;
+
+  struct C_Committed : public Context {
+    WorkloadBench *bench;
+    ceph::mono_time start;
+    C_Committed(WorkloadBench *b) : bench(b), start(ceph::mono_clock::now()) {}
+    void finish(int r) override {
+      bench->committed(ceph::mono_clock::now() - start);
+    }
+  };
+
+  void committed(ceph::timespan lat) {
+    Mutex::Locker l(lock);
+    latencies.push_back(std::chrono::duration<double>(lat).count());
+    --in_flight;
+    cond.Signal();
+  }
+
+  void submit(ObjectStore::Transaction&& t) {
+    {
+      Mutex::Locker l(lock);
+      while (in_flight >= max_in_flight)
+	cond.Wait(lock);
+      ++in_flight;
+    }
+    store->queue_transaction(&osr, std::move(t), nullptr,
+			     new C_Committed(this));
+  }
+
+  void wait_all() {
+    Mutex::Locker l(lock);
+    while (in_flight)
+      cond.Wait(lock);
+  }
+
+  void add_pg_log(ObjectStore::Transaction& t) {
+    map<string, bufferlist> keys;
+    char key[32];
+    snprintf(key, sizeof(key), "0000000001.%020llu",
+	     (unsigned long long)++version);
+    keys[key] = log_bl;
+    t.omap_setkeys(cid, pgmeta, keys);
+  }
+
+  unsigned pick() {
+    return ceph::util::generate_random_number<unsigned>(0, num_objects - 1);
+  }
+
+  // -- workloads: populate, then one transaction per op --
+
+  /// 4MB images objects, overwritten 4KB at a time
+  void rbd_populate() {
+    bufferlist bl = make_bl(4 << 20, 'r');
+    for (unsigned i = 0; i < num_objects; ++i) {
+      ObjectStore::Transaction t;
+      t.write(cid, make_oid("rbd_data.", i), 0, bl.length(), bl);
+      t.setattr(cid, make_oid("rbd_data.", i), "_", oi_bl);
+      submit(std::move(t));
+    }
+  }
+  void rbd_op(unsigned n, unsigned snap_every) {
+    static bufferlist bl = make_bl(4096, 'w');
+    unsigned i = pick();
+    ghobject_t oid = make_oid("rbd_data.", i);
+    ObjectStore::Transaction t;
+    if (snap_every) {
+      // the first write to an object after a snapshot clones it, as
+      // in PrimaryLogPG::make_writeable
+      snapid_t snap = n / snap_every + 1;
+      if (clone_snap[i] != snap) {
+	t.clone(cid, oid, make_oid("rbd_data.", i, snap));
+	clone_snap[i] = snap;
+      }
+    }
+    uint64_t off = ceph::util::generate_random_number<uint64_t>(0, 1023) * 4096;
+    t.write(cid, oid, off, bl.length(), bl);
+    t.setattr(cid, oid, "_", oi_bl);
+    t.setattr(cid, oid, "snapset", ss_bl);
+    add_pg_log(t);
+    submit(std::move(t));
+  }
+  vector<snapid_t> clone_snap;
+
+  /// small objects created with their rgw xattrs and listed in a
+  /// bucket index object
+  void rgw_op(unsigned n) {
+    static bufferlist data = make_bl(4096, 'g');
+    static bufferlist acl = make_bl(160, 'a');
+    static bufferlist etag = make_bl(33, 'e');
+    static bufferlist manifest = make_bl(256, 'm');
+    static bufferlist entry = make_bl(300, 'i');
+    ghobject_t oid = make_oid("default.1234.1_obj", n);
+    ObjectStore::Transaction t;
+    t.touch(cid, oid);
+    t.write(cid, oid, 0, data.length(), data);
+    map<string, bufferptr> attrs;
+    attrs["_"] = bufferptr(oi_bl.c_str(), oi_bl.length());
+    attrs["snapset"] = bufferptr(ss_bl.c_str(), ss_bl.length());
+    attrs["_user.rgw.acl"] = bufferptr(acl.c_str(), acl.length());
+    attrs["_user.rgw.etag"] = bufferptr(etag.c_str(), etag.length());
+    attrs["_user.rgw.manifest"] = bufferptr(manifest.c_str(), manifest.length());
+    t.setattrs(cid, oid, attrs);
+    add_pg_log(t);
+    map<string, bufferlist> keys;
+    keys["obj" + stringify(n)] = entry;
+    t.omap_setkeys(cid, make_oid(".dir.default.1234.1.", pick()), keys);
+    submit(std::move(t));
+  }
+  void rgw_populate() {
+    for (unsigned i = 0; i < num_objects; ++i) {
+      ObjectStore::Transaction t;
+      t.touch(cid, make_oid(".dir.default.1234.1.", i));
+      submit(std::move(t));
+    }
+  }
+
+  /// file creates: a dentry in a dirfrag object, and the backtrace and
+  /// layout xattrs on the first object of the file
+  void cephfs_op(unsigned n) {
+    static bufferlist parent = make_bl(512, 'p');
+    static bufferlist layout = make_bl(64, 'y');
+    static bufferlist dentry = make_bl(600, 'd');
+    ghobject_t oid = make_oid("10000000000.00000000_", n);
+    ObjectStore::Transaction t;
+    t.touch(cid, oid);
+    t.setattr(cid, oid, "_", oi_bl);
+    t.setattr(cid, oid, "snapset", ss_bl);
+    t.setattr(cid, oid, "_parent", parent);
+    t.setattr(cid, oid, "_layout", layout);
+    add_pg_log(t);
+    map<string, bufferlist> keys;
+    keys["file" + stringify(n) + "_head"] = dentry;
+    t.omap_setkeys(cid, make_oid("1.00000000_", pick()), keys);
+    submit(std::move(t));
+  }
+  void cephfs_populate() {
+    for (unsigned i = 0; i < num_objects; ++i) {
+      ObjectStore::Transaction t;
+      t.touch(cid, make_oid("1.00000000_", i));
+      submit(std::move(t));
+    }
+  }
+
+  void report(const string& name, double elapsed, Formatter *f) {
+    sort(latencies.begin(), latencies.end());
+    auto pct = [this](double p) {
+      if (latencies.empty())
+	return 0.0;
+      size_t i = std::min(latencies.size() - 1,
+			  (size_t)(latencies.size() * p / 100.0));
+      return latencies[i];
+    };
+    double sum = 0;
+    for (auto l : latencies)
+      sum += l;
+    f->open_object_section(name.c_str());
+    f->dump_unsigned("ops", latencies.size());
+    f->dump_float("seconds", elapsed);
+    f->dump_float("iops", latencies.size() / elapsed);
+    f->dump_float("avg_lat", latencies.empty() ? 0 : sum / latencies.size());
+    f->dump_float("p50_lat", pct(50));
+    f->dump_float("p99_lat", pct(99));
+    f->dump_float("p99.9_lat", pct(99.9));
+    f->dump_float("max_lat", latencies.empty() ? 0 : latencies.back());
+    // where the time went, as the store accounts for it
+    static const char *stages[] = {
+      "state_prepare_lat",
+      "state_aio_wait_lat",
+      "state_io_done_lat",
+      "state_kv_queued_lat",
+      "state_kv_commiting_lat",
+      "state_kv_done_lat",
+      "state_deferred_queued_lat",
+      "state_deferred_aio_wait_lat",
+      "state_deferred_cleanup_lat",
+      "state_finishing_lat",
+      "state_done_lat",
+    };
+    f->open_object_section("stages");
+    for (auto s : stages)
+      g_ceph_context->get_perfcounters_collection()->dump_formatted(
+	f, false, "bluestore", s);
+    f->close_section();
+    f->close_section();
+    f->flush(cout);
+    cout << std::endl;
+  }
+
+public:
+  WorkloadBench(ObjectStore *s, unsigned objects, unsigned in_flight)
+    : store(s),
+      pgid(pg_t(0, 1), shard_id_t::NO_SHARD),
+      cid(pgid),
+      pgmeta(pgid.make_pgmeta_oid()),
+      osr("bench"),
+      num_objects(objects),
+      max_in_flight(in_flight),
+      lock("WorkloadBench::lock"),
+      clone_snap(objects, 0) {}
+
+  int run(const string& name, unsigned ops, Formatter *f) {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.touch(cid, pgmeta);
+    int r = store->apply_transaction(&osr, std::move(t));
+    if (r < 0)
+      return r;
+
+    if (name == "rbd" || name == "rbd_snap")
+      rbd_populate();
+    else if (name == "rgw")
+      rgw_populate();
+    else if (name == "cephfs")
+      cephfs_populate();
+    else
+      return -EINVAL;
+    wait_all();
+    latencies.clear();
+    g_ceph_context->get_perfcounters_collection()->reset("all");
+
+    unsigned snap_every = name == "rbd_snap" ? std::max(ops / 10, 1u) : 0;
+    auto start = ceph::mono_clock::now();
+    for (unsigned n = 0; n < ops; ++n) {
+      if (name == "rbd" || name == "rbd_snap")
+	rbd_op(n, snap_every);
+      else if (name == "rgw")
+	rgw_op(n);
+      else
+	cephfs_op(n);
+    }
+    wait_all();
+    double elapsed = std::chrono::duration<double>(
+      ceph::mono_clock::now() - start).count();
+    report(name, elapsed, f);
+
+    // leave an empty store for the next workload
+    vector<ghobject_t> ls;
+    ghobject_t next;
+    while (true) {
+      store->collection_list(cid, next, ghobject_t::get_max(), 1000,
+			     &ls, &next);
+      ObjectStore::Transaction rm;
+      for (auto& o : ls)
+	rm.remove(cid, o);
+      if (!ls.empty())
+	submit(std::move(rm));
+      ls.clear();
+      if (next.is_max())
+	break;
+    }
+    wait_all();
+    ObjectStore::Transaction rmc;
+    rmc.remove_collection(cid);
+    return store->apply_transaction(&osr, std::move(rmc));
+  }
+};
+
+int main(int argc, char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, (const char **)argv, args);
+  env_to_vec(args);
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_OSD,
+			 CODE_ENVIRONMENT_UTILITY, 0);
+  common_init_finish(g_ceph_context);
+
+  unsigned ops = 10000, in_flight = 16, objects = 256;
+  string val;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_witharg(args, i, &val, "--ops", (char*)NULL)) {
+      ops = atoi(val.c_str());
+    } else if (ceph_argparse_witharg(args, i, &val, "--in-flight", (char*)NULL)) {
+      in_flight = std::max(atoi(val.c_str()), 1);
+    } else if (ceph_argparse_witharg(args, i, &val, "--objects", (char*)NULL)) {
+      objects = std::max(atoi(val.c_str()), 1);
+    } else {
+      ++i;
+    }
+  }
+  if (args.size() != 1) {
+    usage(argv[0]);
+    return 1;
+  }
+  vector<string> workloads;
+  if (string(args[0]) == "all")
+    workloads = { "rbd", "rbd_snap", "rgw", "cephfs" };
+  else
+    workloads.push_back(args[0]);
+
+  ObjectStore *store = ObjectStore::create(g_ceph_context,
+					   g_conf->osd_objectstore,
+					   g_conf->osd_data,
+					   g_conf->osd_journal);
+  if (!store) {
+    cerr << "unknown objectstore " << g_conf->osd_objectstore << std::endl;
+    return 1;
+  }
+  int r = store->mkfs();
+  if (r < 0) {
+    cerr << "mkfs failed: " << cpp_strerror(r) << std::endl;
+    return 1;
+  }
+  r = store->mount();
+  if (r < 0) {
+    cerr << "mount failed: " << cpp_strerror(r) << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<Formatter> f(Formatter::create("json-pretty"));
+  for (auto& w : workloads) {
+    WorkloadBench bench(store, objects, in_flight);
+    r = bench.run(w, ops, f.get());
+    if (r < 0) {
+      cerr << w << ": " << cpp_strerror(r) << std::endl;
+      if (r == -EINVAL)
+	usage(argv[0]);
+      break;
+    }
+  }
+
+  store->umount();
+  delete store;
+  return r < 0 ? 1 : 0;
+}
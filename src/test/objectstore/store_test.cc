@@ -2438,6 +2438,96 @@ TEST_P(StoreTest, SimpleAttrTest) {
   }
 }
 
+TEST_P(StoreTest, BluestoreOnodeAttrPatchTest) {
+  if (string(GetParam()) != "bluestore")
+    return;
+  g_conf->set_val("bluestore_onode_attr_patch", "true");
+  g_ceph_context->_conf->apply_changes(NULL);
+
+  ObjectStore::Sequencer osr("test");
+  int r;
+  coll_t cid;
+  ghobject_t hoid(hobject_t(sobject_t("attr patch object", CEPH_NOSNAP)));
+  bufferlist data, val, val2;
+  data.append("data");
+  val.append("value");
+  val2.append("value2");
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.write(cid, hoid, 0, data.length(), data);
+    t.setattr(cid, hoid, "foo", val);
+    t.setattr(cid, hoid, "bar", val);
+    r = apply_transaction(store, &osr, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  // attr-only updates are merged into the onode
+  {
+    ObjectStore::Transaction t;
+    t.setattr(cid, hoid, "foo", val2);
+    t.rmattr(cid, hoid, "bar");
+    t.setattr(cid, hoid, "baz", val);
+    r = apply_transaction(store, &osr, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  {
+    ObjectStore::Transaction t;
+    t.setattr(cid, hoid, "qux", val2);
+    r = apply_transaction(store, &osr, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  // drop the cached onode so it is read back from the db
+  r = store->umount();
+  ASSERT_EQ(0, r);
+  r = store->mount();
+  ASSERT_EQ(0, r);
+  {
+    map<string,bufferptr> aset;
+    r = store->getattrs(cid, hoid, aset);
+    ASSERT_EQ(0, r);
+    ASSERT_EQ(3u, aset.size());
+    bufferlist bl;
+    bl.append(aset["foo"]);
+    ASSERT_TRUE(bl_eq(val2, bl));
+    bl.clear();
+    bl.append(aset["baz"]);
+    ASSERT_TRUE(bl_eq(val, bl));
+    bl.clear();
+    bl.append(aset["qux"]);
+    ASSERT_TRUE(bl_eq(val2, bl));
+
+    bl.clear();
+    r = store->read(cid, hoid, 0, data.length(), bl);
+    ASSERT_EQ((int)data.length(), r);
+    ASSERT_TRUE(bl_eq(data, bl));
+  }
+  {
+    ObjectStore::Transaction t;
+    t.rmattrs(cid, hoid);
+    r = apply_transaction(store, &osr, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  r = store->umount();
+  ASSERT_EQ(0, r);
+  r = store->mount();
+  ASSERT_EQ(0, r);
+  {
+    map<string,bufferptr> aset;
+    r = store->getattrs(cid, hoid, aset);
+    ASSERT_EQ(0, r);
+    ASSERT_TRUE(aset.empty());
+  }
+  {
+    ObjectStore::Transaction t;
+    t.remove(cid, hoid);
+    t.remove_collection(cid);
+    r = apply_transaction(store, &osr, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  g_conf->set_val("bluestore_onode_attr_patch", "false");
+  g_ceph_context->_conf->apply_changes(NULL);
+}
+
 TEST_P(StoreTest, SimpleListTest) {
   ObjectStore::Sequencer osr("test");
   int r;
@@ -4315,6 +4405,16 @@ TEST_P(StoreTest, Synthetic) {
   doSyntheticTest(store, 10000, 400*1024, 40*1024, 0);
 }
 
+TEST_P(StoreTest, SyntheticParallelFsck) {
+  if (string(GetParam()) != "bluestore")
+    return;
+  g_conf->set_val("bluestore_fsck_threads", "4");
+  g_ceph_context->_conf->apply_changes(NULL);
+  doSyntheticTest(store, 5000, 400*1024, 40*1024, 0);
+  g_conf->set_val("bluestore_fsck_threads", "1");
+  g_ceph_context->_conf->apply_changes(NULL);
+}
+
 
 TEST_P(StoreTestSpecificAUSize, SyntheticMatrixSharding) {
   if (string(GetParam()) != "bluestore")
@@ -526,6 +526,50 @@ TEST(BlueFS, test_compaction_async) {
   rm_temp_bdev(fn);
 }
 
+TEST(BlueFS, preextend_wal) {
+  uint64_t size = 1048576 * 128;
+  string fn = get_temp_bdev(size);
+  g_ceph_context->_conf->set_val("bluefs_preextend_wal_files", "true");
+  g_ceph_context->_conf->set_val("bluefs_wal_prealloc_size", "4194304");
+  g_ceph_context->_conf->apply_changes(NULL);
+
+  BlueFS fs(g_ceph_context);
+  ASSERT_EQ(0, fs.add_block_device(BlueFS::BDEV_DB, fn));
+  fs.add_block_extent(BlueFS::BDEV_DB, 1048576, size - 1048576);
+  uuid_d fsid;
+  ASSERT_EQ(0, fs.mkfs(fsid));
+  ASSERT_EQ(0, fs.mount());
+  uint64_t file_size;
+  utime_t mtime;
+  {
+    BlueFS::FileWriter *h;
+    ASSERT_EQ(0, fs.mkdir("dir"));
+    ASSERT_EQ(0, fs.open_for_write("dir", "000001.log", &h, false));
+    ASSERT_EQ(0, fs.stat("dir", "000001.log", &file_size, &mtime));
+    ASSERT_EQ(4194304u, file_size);
+    for (unsigned i = 0; i < 1000; ++i) {
+      h->append("abcdeabcdeabcdeabcdeabcdeabc", 23);
+      ASSERT_EQ(0, fs.fsync(h));
+    }
+    fs.close_writer(h);
+    ASSERT_EQ(0, fs.stat("dir", "000001.log", &file_size, &mtime));
+    ASSERT_EQ(4194304u, file_size);
+  }
+  {
+    // recycled logs keep their preallocated space
+    BlueFS::FileWriter *h;
+    ASSERT_EQ(0, fs.rename("dir", "000001.log", "dir", "000002.log"));
+    ASSERT_EQ(0, fs.open_for_write("dir", "000002.log", &h, true));
+    ASSERT_EQ(0, fs.stat("dir", "000002.log", &file_size, &mtime));
+    ASSERT_EQ(4194304u, file_size);
+    fs.close_writer(h);
+  }
+  fs.umount();
+  g_ceph_context->_conf->set_val("bluefs_preextend_wal_files", "false");
+  g_ceph_context->_conf->apply_changes(NULL);
+  rm_temp_bdev(fn);
+}
+
 TEST(BlueFS, test_replay) {
   uint64_t size = 1048576 * 128;
   string fn = get_temp_bdev(size);
@@ -306,6 +306,52 @@ TEST(bluestore_blob_t, calc_csum)
   }
 }
 
+TEST(bluestore_blob_t, calc_csum_fragmented)
+{
+  // 32 chunks, some of them split across buffers, others not
+  const unsigned chunk = 4096;
+  string s;
+  for (unsigned i = 0; i < chunk * 32; ++i)
+    s.push_back(i * 7 + i / 13);
+  bufferlist flat;
+  flat.append(s);
+  bufferlist frag;
+  unsigned pos = 0;
+  for (unsigned len : {chunk * 5, 100u, chunk * 3, chunk - 100, chunk * 11}) {
+    frag.append(s.substr(pos, len));
+    pos += len;
+  }
+  frag.append(s.substr(pos));
+  ASSERT_EQ(flat.length(), frag.length());
+
+  for (unsigned csum_type = Checksummer::CSUM_NONE + 1;
+       csum_type < Checksummer::CSUM_MAX;
+       ++csum_type) {
+    cout << "csum_type " << Checksummer::get_csum_type_string(csum_type)
+	 << std::endl;
+    bluestore_blob_t a, b;
+    a.init_csum(csum_type, 12, flat.length());
+    b.init_csum(csum_type, 12, flat.length());
+    a.calc_csum(0, flat);
+    b.calc_csum(0, frag);
+    ASSERT_EQ(a.csum_data.length(), b.csum_data.length());
+    ASSERT_EQ(0, memcmp(a.csum_data.c_str(), b.csum_data.c_str(),
+			a.csum_data.length()));
+
+    int bad_off;
+    uint64_t bad_csum;
+    ASSERT_EQ(0, a.verify_csum(0, frag, &bad_off, &bad_csum));
+    ASSERT_EQ(-1, bad_off);
+
+    string t = s;
+    t[chunk * 21 + 5] ^= 1;
+    bufferlist bad;
+    bad.append(t);
+    ASSERT_EQ(-1, a.verify_csum(0, bad, &bad_off, &bad_csum));
+    ASSERT_EQ((int)chunk * 21, bad_off);
+  }
+}
+
 TEST(bluestore_blob_t, csum_bench)
 {
   bufferlist bl;
@@ -161,6 +161,135 @@ TEST_P(KVTest, PutReopen) {
   fini();
 }
 
+TEST_P(KVTest, GetMany) {
+  ASSERT_EQ(0, db->create_and_open(cout));
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int i = 0; i < 10; i += 2) {
+      bufferlist value;
+      value.append("value" + stringify(i));
+      t->set("prefix", "key" + stringify(i), value);
+    }
+    t->set("other", "key1", bufferlist());
+    db->submit_transaction_sync(t);
+  }
+  {
+    set<string> keys;
+    for (int i = 0; i < 10; i++)
+      keys.insert("key" + stringify(i));
+    map<string, bufferlist> out;
+    ASSERT_EQ(0, db->get("prefix", keys, &out));
+    ASSERT_EQ(5u, out.size());
+    for (int i = 0; i < 10; i += 2)
+      ASSERT_EQ("value" + stringify(i), _bl_to_str(out["key" + stringify(i)]));
+
+    out.clear();
+    ASSERT_EQ(0, db->get("prefix", set<string>(), &out));
+    ASSERT_TRUE(out.empty());
+  }
+  fini();
+}
+
+TEST_P(KVTest, PrefixIterator) {
+  ASSERT_EQ(0, db->create_and_open(cout));
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    t->set("a", "key", bufferlist());
+    for (int i = 0; i < 5; i++) {
+      bufferlist value;
+      value.append("value" + stringify(i));
+      t->set("b", "key" + stringify(i), value);
+    }
+    for (int i = 0; i < 100; i++)
+      t->set("c", "key" + stringify(i), bufferlist());
+    db->submit_transaction_sync(t);
+  }
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int i = 0; i < 100; i++)
+      t->rmkey("c", "key" + stringify(i));
+    db->submit_transaction_sync(t);
+  }
+  KeyValueDB::Iterator it = db->get_iterator("b");
+  ASSERT_EQ(0, it->seek_to_first());
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(it->valid());
+    ASSERT_EQ("key" + stringify(i), it->key());
+    ASSERT_EQ("b", it->raw_key().first);
+    ASSERT_EQ("value" + stringify(i), _bl_to_str(it->value()));
+    ASSERT_EQ(0, it->next());
+  }
+  ASSERT_FALSE(it->valid());
+
+  ASSERT_EQ(0, it->upper_bound("key4"));
+  ASSERT_FALSE(it->valid());
+  ASSERT_EQ(0, it->lower_bound("key2"));
+  ASSERT_TRUE(it->valid());
+  ASSERT_EQ("key2", it->key());
+
+  ASSERT_EQ(0, it->seek_to_last());
+  ASSERT_TRUE(it->valid());
+  ASSERT_EQ("key4", it->key());
+  for (int i = 4; i > 0; i--)
+    ASSERT_EQ(0, it->prev());
+  ASSERT_EQ("key0", it->key());
+  ASSERT_EQ(0, it->prev());
+  ASSERT_FALSE(it->valid());
+
+  it = db->get_iterator("c");
+  ASSERT_EQ(0, it->seek_to_first());
+  ASSERT_FALSE(it->valid());
+  it.reset();
+  fini();
+}
+
+TEST_P(KVTest, IteratorSnapshot) {
+  ASSERT_EQ(0, db->create_and_open(cout));
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int i = 0; i < 10; i++) {
+      bufferlist value;
+      value.append("old" + stringify(i));
+      t->set("prefix", "key" + stringify(i), value);
+    }
+    db->submit_transaction_sync(t);
+  }
+  KeyValueDB::Iterator it = db->get_iterator("prefix");
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int i = 0; i < 10; i += 2) {
+      t->rmkey("prefix", "key" + stringify(i));
+    }
+    for (int i = 1; i < 10; i += 2) {
+      bufferlist value;
+      value.append("new" + stringify(i));
+      t->set("prefix", "key" + stringify(i), value);
+    }
+    t->set("prefix", "key99", bufferlist());
+    db->submit_transaction_sync(t);
+  }
+  int n = 0;
+  for (it->seek_to_first(); it->valid(); it->next()) {
+    ASSERT_EQ("key" + stringify(n), it->key());
+    ASSERT_EQ("old" + stringify(n), _bl_to_str(it->value()));
+    n++;
+  }
+  ASSERT_EQ(10, n);
+
+  it = db->get_iterator("prefix");
+  n = 0;
+  for (it->seek_to_first(); it->valid(); it->next()) {
+    n++;
+  }
+  ASSERT_EQ(6, n);
+  bufferlist bl;
+  ASSERT_EQ(-ENOENT, db->get("prefix", "key0", &bl));
+  ASSERT_EQ(0, db->get("prefix", "key1", &bl));
+  ASSERT_EQ("new1", _bl_to_str(bl));
+  it.reset();
+  fini();
+}
+
 TEST_P(KVTest, BenchCommit) {
   int n = 1024;
   ASSERT_EQ(0, db->create_and_open(cout));
@@ -368,6 +497,37 @@ TEST_P(KVTest, RocksDBColumnFamilyTest) {
   fini();
 }
 
+TEST_P(KVTest, RocksDBCFCompact) {
+  if(string(GetParam()) != "rocksdb")
+    return;
+
+  std::vector<KeyValueDB::ColumnFamily> cfs;
+  cfs.push_back(KeyValueDB::ColumnFamily("cf1", ""));
+  ASSERT_EQ(0, db->init(g_conf->bluestore_rocksdb_options));
+  ASSERT_EQ(0, db->create_and_open(cout, cfs));
+  for (int round = 0; round < 2; round++) {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int i = 0; i < 100; i++) {
+      bufferlist value;
+      value.append("value" + stringify(round));
+      t->set("cf1", "key" + stringify(i), value);
+      t->set("prefix", "key" + stringify(i), value);
+    }
+    ASSERT_EQ(0, db->submit_transaction_sync(t));
+  }
+  db->compact_prefix("cf1");
+  db->compact_range("cf1", "key10", "key50");
+  db->compact_prefix("prefix");
+  {
+    bufferlist v1, v2;
+    ASSERT_EQ(0, db->get("cf1", "key42", &v1));
+    ASSERT_EQ("value1", _bl_to_str(v1));
+    ASSERT_EQ(0, db->get("prefix", "key42", &v2));
+    ASSERT_EQ("value1", _bl_to_str(v2));
+  }
+  fini();
+}
+
 TEST_P(KVTest, RocksDBIteratorTest) {
   if(string(GetParam()) != "rocksdb")
     return;
@@ -0,0 +1,451 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ * Drives the write path of ECBackend without a cluster: every op is
+ * planned (ECTransaction::get_write_plan), pins and reads through the
+ * ExtentCache the way try_state_to_reads and try_reads_to_commit do,
+ * is encoded into per shard transactions
+ * (ECTransaction::generate_transactions) and updates the cache.  The
+ * reads that would go to the other shards are answered with zeros.
+ * Reports the cpu time of each stage per op and per stripe, and the
+ * allocations made along the way.
+ */
+
+#include <stdlib.h>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "common/ceph_argparse.h"
+#include "common/ceph_time.h"
+#include "common/errno.h"
+#include "common/Formatter.h"
+#include "erasure-code/ErasureCodePlugin.h"
+#include "global/global_init.h"
+#include "include/random.h"
+#include "include/stringify.h"
+#include "osd/ECTransaction.h"
+#include "osd/ExtentCache.h"
+#include "osd/osd_internal_types.h"
+
+using namespace std;
+
+// count every operator new while the bench runs, not only bufferptrs
+static std::atomic<uint64_t> new_calls(0);
+
+void *operator new(size_t size)
+{
+  new_calls.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+void operator delete[](void *p) noexcept
+{
+  free(p);
+}
+
+static void usage(const char *name)
+{
+  cout << "usage: " << name << " [options]\n"
+       << "  --plugin NAME       erasure code plugin (default jerasure)\n"
+       << "  --technique NAME    plugin technique (default reed_sol_van)\n"
+       << "  --k N --m N         data and coding chunks (default 4 and 2)\n"
+       << "  --stripe-unit N     bytes per chunk and stripe (default 4096)\n"
+       << "  --pattern P         full, append, overwrite or small\n"
+       << "                      (default overwrite)\n"
+       << "  --io-size N         bytes per write (default 65536, small\n"
+       << "                      writes are 4096)\n"
+       << "  --object-size N     size objects are populated to (default 4MB)\n"
+       << "  --objects N         objects the writes spread over (default 16)\n"
+       << "  --iterations N      writes to time (default 10000)\n"
+       << "  --in-flight N       writes between reserve and commit, as in\n"
+       << "                      the ECBackend pipeline (default 1)"
+       << std::endl;
+}
+
+struct mydpp : public DoutPrefixProvider {
+  string gen_prefix() const override { return "ec bench: "; }
+  CephContext *get_cct() const override { return g_ceph_context; }
+  unsigned get_subsys() const override { return ceph_subsys_osd; }
+} dpp;
+
+class ECTransactionBench {
+  ErasureCodeInterfaceRef ec_impl;
+  ECUtil::stripe_info_t sinfo;
+  unsigned k, m;
+  pg_t pgid = pg_t(0, 1);
+  ExtentCache cache;
+  string pattern;
+  uint64_t io_size, object_size;
+  unsigned in_flight;
+
+  struct Obj {
+    hobject_t oid;
+    ObjectContextRef obc;
+    ECUtil::HashInfoRef hinfo;
+    uint64_t cursor = 0;	///< next offset of append and small
+  };
+  vector<Obj> objs;
+  eversion_t version = eversion_t(1, 0);
+
+  /// one write on its way through the pipeline, like ECBackend::Op
+  struct Op {
+    hobject_t oid;
+    ECTransaction::WritePlan plan;
+    ExtentCache::write_pin pin;
+    map<hobject_t,extent_set> pending_read;
+    map<hobject_t,extent_map> remote_read_result;
+    vector<pg_log_entry_t> log_entries;
+  };
+  std::deque<Op> waiting;
+
+  // totals over the timed writes
+  struct Stage {
+    const char *name;
+    ceph::timespan t = ceph::timespan::zero();
+  };
+  Stage plan_stage{"plan"}, reserve_stage{"reserve"},
+    encode_stage{"encode"}, update_stage{"cache_update"};
+  uint64_t ops = 0, stripes = 0, rmw_ops = 0;
+  uint64_t remote_read_bytes = 0, cache_read_bytes = 0;
+  uint64_t shard_bytes = 0;
+  bool timing = false;
+
+  void add_time(Stage &s, ceph::mono_time start) {
+    if (timing)
+      s.t += ceph::mono_clock::now() - start;
+  }
+
+  void pick(Obj **o, uint64_t *off, uint64_t *len) {
+    *o = &objs[ceph::util::generate_random_number<size_t>(0, objs.size() - 1)];
+    uint64_t sw = sinfo.get_stripe_width();
+    if (pattern == "full") {
+      *len = sinfo.logical_to_next_stripe_offset(io_size);
+      uint64_t nstripes = std::max<uint64_t>(object_size / sw, 1);
+      uint64_t n = std::max<uint64_t>(*len / sw, 1);
+      *off = ceph::util::generate_random_number<uint64_t>(
+	0, nstripes > n ? nstripes - n : 0) * sw;
+    } else if (pattern == "append") {
+      *len = io_size;
+      *off = (*o)->cursor;
+      (*o)->cursor += *len;
+    } else if (pattern == "small") {
+      // walks the object 4k at a time, so that the ops in flight keep
+      // hitting the stripes their predecessors pinned
+      *len = 4096;
+      if ((*o)->cursor + *len > object_size)
+	(*o)->cursor = 0;
+      *off = (*o)->cursor;
+      (*o)->cursor += *len;
+    } else {
+      *len = io_size;
+      uint64_t blocks = object_size > *len ? (object_size - *len) / 4096 : 0;
+      *off = ceph::util::generate_random_number<uint64_t>(0, blocks) * 4096;
+    }
+  }
+
+  void start_op(Obj &o, uint64_t off, uint64_t len, bool create) {
+    static bufferlist data;
+    if (data.length() < len) {
+      data.clear();
+      data.append(buffer::create_page_aligned(len));
+      memset(data.c_str(), 'e', len);
+    }
+
+    ++version.version;
+    waiting.emplace_back();
+    Op &op = waiting.back();
+    op.oid = o.oid;
+    op.log_entries.push_back(
+      pg_log_entry_t(pg_log_entry_t::MODIFY, o.oid, version,
+		     eversion_t(version.epoch, version.version - 1),
+		     version.version, osd_reqid_t(), utime_t(), 0));
+
+    auto start = ceph::mono_clock::now();
+    PGTransactionUPtr t(new PGTransaction);
+    if (create)
+      t->create(o.oid);
+    bufferlist bl;
+    bl.substr_of(data, 0, len);
+    t->write(o.oid, off, len, bl);
+    t->add_obc(o.obc);
+    op.plan = ECTransaction::get_write_plan(
+      sinfo,
+      std::move(t),
+      [&](const hobject_t &) { return o.hinfo; },
+      &dpp);
+    add_time(plan_stage, start);
+
+    // try_state_to_reads
+    start = ceph::mono_clock::now();
+    cache.open_write_pin(op.pin);
+    extent_set empty;
+    for (auto &&hpair : op.plan.will_write) {
+      auto riter = op.plan.to_read.find(hpair.first);
+      const extent_set &to_read =
+	riter == op.plan.to_read.end() ? empty : riter->second;
+      extent_set remote_read = cache.reserve_extents_for_rmw(
+	hpair.first, op.pin, hpair.second, to_read);
+      extent_set pending_read = to_read;
+      pending_read.subtract(remote_read);
+      if (!pending_read.empty()) {
+	if (timing)
+	  cache_read_bytes += pending_read.size();
+	op.pending_read[hpair.first] = std::move(pending_read);
+      }
+      // what the other shards would have sent back
+      for (auto e = remote_read.begin(); e != remote_read.end(); ++e) {
+	bufferlist zeros;
+	zeros.append_zero(e.get_len());
+	op.remote_read_result[hpair.first].insert(e.get_start(), e.get_len(),
+						  zeros);
+	if (timing)
+	  remote_read_bytes += e.get_len();
+      }
+    }
+    add_time(reserve_stage, start);
+    if (timing) {
+      ++ops;
+      if (!op.plan.to_read.empty())
+	++rmw_ops;
+      for (auto &&i : op.plan.will_write)
+	stripes += i.second.size() / sinfo.get_stripe_width();
+    }
+  }
+
+  void commit_op() {
+    Op &op = waiting.front();
+
+    // try_reads_to_commit
+    auto start = ceph::mono_clock::now();
+    for (auto &&hpair : op.pending_read) {
+      op.remote_read_result[hpair.first].insert(
+	cache.get_remaining_extents_for_rmw(hpair.first, op.pin,
+					    hpair.second));
+    }
+    add_time(update_stage, start);
+
+    start = ceph::mono_clock::now();
+    map<shard_id_t, ObjectStore::Transaction> trans;
+    for (unsigned i = 0; i < k + m; ++i)
+      trans[shard_id_t(i)];
+    map<hobject_t,extent_map> written;
+    set<hobject_t> temp_added, temp_removed;
+    ECTransaction::generate_transactions(
+      op.plan, ec_impl, pgid, sinfo, op.remote_read_result, op.log_entries,
+      &written, &trans, &temp_added, &temp_removed, &dpp);
+    add_time(encode_stage, start);
+
+    map<hobject_t,extent_set> written_set;
+    for (auto &&i : written)
+      written_set[i.first] = i.second.get_interval_set();
+    assert(written_set == op.plan.will_write);
+    if (timing) {
+      for (auto &&i : trans)
+	shard_bytes += i.second.get_num_bytes();
+    }
+
+    // try_finish_rmw, the shards having committed at once
+    start = ceph::mono_clock::now();
+    for (auto &&i : written)
+      cache.present_rmw_update(i.first, op.pin, i.second);
+    cache.release_write_pin(op.pin);
+    add_time(update_stage, start);
+    waiting.pop_front();
+  }
+
+  void dump_stage(Formatter *f, const Stage &s) {
+    double sec = std::chrono::duration<double>(s.t).count();
+    f->open_object_section(s.name);
+    f->dump_float("seconds", sec);
+    f->dump_float("usec_per_op", ops ? sec * 1000000 / ops : 0);
+    f->dump_float("usec_per_stripe", stripes ? sec * 1000000 / stripes : 0);
+    f->close_section();
+  }
+
+public:
+  ECTransactionBench(ErasureCodeInterfaceRef ec, unsigned k, unsigned m,
+		     uint64_t stripe_unit, const string &pattern,
+		     uint64_t io_size, uint64_t object_size, unsigned objects,
+		     unsigned in_flight)
+    : ec_impl(ec), sinfo(k, k * stripe_unit), k(k), m(m), pattern(pattern),
+      io_size(io_size), object_size(object_size), in_flight(in_flight) {
+    for (unsigned i = 0; i < objects; ++i) {
+      Obj o;
+      o.oid = hobject_t(object_t("ecbench." + stringify(i)), "", CEPH_NOSNAP,
+			i, pgid.pool(), "");
+      o.obc = ObjectContextRef(new ObjectContext);
+      o.obc->obs.oi.soid = o.oid;
+      o.obc->obs.exists = true;
+      o.hinfo = ECUtil::HashInfoRef(new ECUtil::HashInfo(k + m));
+      objs.push_back(o);
+    }
+  }
+
+  int run(unsigned iterations, Formatter *f) {
+    // the objects start out full, but for appends
+    uint64_t populate = pattern == "append" ? 0 :
+      sinfo.logical_to_next_stripe_offset(object_size);
+    for (auto &o : objs) {
+      for (uint64_t off = 0; off < populate; off += 1 << 20) {
+	start_op(o, off, std::min<uint64_t>(1 << 20, populate - off),
+		 off == 0);
+	commit_op();
+      }
+      if (populate == 0) {
+	start_op(o, 0, sinfo.get_stripe_width(), true);
+	commit_op();
+	o.cursor = sinfo.get_stripe_width();
+      }
+    }
+
+    buffer::track_alloc(true);
+    uint64_t buf_num = buffer::get_history_alloc_num();
+    uint64_t buf_bytes = buffer::get_history_alloc_bytes();
+    uint64_t news = new_calls.load();
+    timing = true;
+    auto start = ceph::mono_clock::now();
+    for (unsigned n = 0; n < iterations; ++n) {
+      Obj *o;
+      uint64_t off, len;
+      pick(&o, &off, &len);
+      start_op(*o, off, len, false);
+      if (waiting.size() >= in_flight)
+	commit_op();
+    }
+    while (!waiting.empty())
+      commit_op();
+    double elapsed = std::chrono::duration<double>(
+      ceph::mono_clock::now() - start).count();
+    timing = false;
+    news = new_calls.load() - news;
+    buf_num = buffer::get_history_alloc_num() - buf_num;
+    buf_bytes = buffer::get_history_alloc_bytes() - buf_bytes;
+
+    f->open_object_section("ec_transaction_bench");
+    f->dump_string("pattern", pattern);
+    f->dump_unsigned("stripe_width", sinfo.get_stripe_width());
+    f->dump_unsigned("ops", ops);
+    f->dump_unsigned("stripes", stripes);
+    f->dump_unsigned("rmw_ops", rmw_ops);
+    f->dump_unsigned("remote_read_bytes", remote_read_bytes);
+    f->dump_unsigned("cache_read_bytes", cache_read_bytes);
+    f->dump_unsigned("shard_transaction_bytes", shard_bytes);
+    f->dump_float("seconds", elapsed);
+    f->dump_float("ops_per_sec", ops / elapsed);
+    f->open_object_section("stages");
+    dump_stage(f, plan_stage);
+    dump_stage(f, reserve_stage);
+    dump_stage(f, encode_stage);
+    dump_stage(f, update_stage);
+    f->close_section();
+    f->open_object_section("allocations");
+    f->dump_float("new_per_op", ops ? (double)news / ops : 0);
+    f->dump_float("new_per_stripe", stripes ? (double)news / stripes : 0);
+    f->dump_float("buffers_per_op", ops ? (double)buf_num / ops : 0);
+    f->dump_float("buffer_bytes_per_op", ops ? (double)buf_bytes / ops : 0);
+    f->close_section();
+    f->close_section();
+    return 0;
+  }
+};
+
+int main(int argc, char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, (const char **)argv, args);
+  env_to_vec(args);
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_OSD,
+			 CODE_ENVIRONMENT_UTILITY, 0);
+  common_init_finish(g_ceph_context);
+
+  string plugin = "jerasure", technique = "reed_sol_van";
+  string pattern = "overwrite";
+  unsigned k = 4, m = 2, objects = 16, iterations = 10000, in_flight = 1;
+  uint64_t stripe_unit = 4096, io_size = 65536, object_size = 4 << 20;
+  string val;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_witharg(args, i, &val, "--plugin", (char*)NULL)) {
+      plugin = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--technique", (char*)NULL)) {
+      technique = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--k", (char*)NULL)) {
+      k = std::max(atoi(val.c_str()), 1);
+    } else if (ceph_argparse_witharg(args, i, &val, "--m", (char*)NULL)) {
+      m = std::max(atoi(val.c_str()), 1);
+    } else if (ceph_argparse_witharg(args, i, &val, "--stripe-unit", (char*)NULL)) {
+      stripe_unit = std::max(atoll(val.c_str()), 1ll);
+    } else if (ceph_argparse_witharg(args, i, &val, "--pattern", (char*)NULL)) {
+      pattern = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--io-size", (char*)NULL)) {
+      io_size = std::max(atoll(val.c_str()), 1ll);
+    } else if (ceph_argparse_witharg(args, i, &val, "--object-size", (char*)NULL)) {
+      object_size = std::max(atoll(val.c_str()), 1ll);
+    } else if (ceph_argparse_witharg(args, i, &val, "--objects", (char*)NULL)) {
+      objects = std::max(atoi(val.c_str()), 1);
+    } else if (ceph_argparse_witharg(args, i, &val, "--iterations", (char*)NULL)) {
+      iterations = atoi(val.c_str());
+    } else if (ceph_argparse_witharg(args, i, &val, "--in-flight", (char*)NULL)) {
+      in_flight = std::max(atoi(val.c_str()), 1);
+    } else {
+      ++i;
+    }
+  }
+  if (!args.empty() ||
+      (pattern != "full" && pattern != "append" &&
+       pattern != "overwrite" && pattern != "small")) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  ErasureCodeProfile profile;
+  profile["plugin"] = plugin;
+  profile["technique"] = technique;
+  profile["k"] = stringify(k);
+  profile["m"] = stringify(m);
+  ErasureCodeInterfaceRef ec_impl;
+  stringstream ss;
+  int r = ceph::ErasureCodePluginRegistry::instance().factory(
+    plugin, g_conf->get_val<std::string>("erasure_code_dir"), profile,
+    &ec_impl, &ss);
+  if (r < 0) {
+    cerr << "loading " << plugin << " failed: " << ss.str() << std::endl;
+    return 1;
+  }
+  if (ec_impl->get_data_chunk_count() != k ||
+      ec_impl->get_chunk_size(k * stripe_unit) != stripe_unit) {
+    cerr << "stripe unit " << stripe_unit << " is not aligned for "
+	 << plugin << " with k=" << k << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<Formatter> f(Formatter::create("json-pretty"));
+  ECTransactionBench bench(ec_impl, k, m, stripe_unit, pattern, io_size,
+			   object_size, objects, in_flight);
+  r = bench.run(iterations, f.get());
+  f->flush(cout);
+  cout << std::endl;
+  return r < 0 ? 1 : 0;
+}
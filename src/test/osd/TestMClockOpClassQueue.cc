@@ -182,3 +182,30 @@ TEST_F(MClockOpClassQueueTest, TestRemoveByClass) {
   r = q.dequeue();
   ASSERT_EQ(104u, r.get_map_epoch());
 }
+
+
+TEST_F(MClockOpClassQueueTest, TestCostModel) {
+  using namespace ceph::mclock;
+  OpClassClientInfoMgr mgr(g_ceph_context);
+
+  // no capacities, the cost is left out
+  ASSERT_EQ(0.0, mgr.get_addl_cost(osd_op_type_t::bg_recovery, 4 << 20));
+
+  g_ceph_context->_conf->set_val("osd_op_queue_mclock_iops_capacity", "100");
+  g_ceph_context->_conf->set_val("osd_op_queue_mclock_bandwidth_capacity",
+				 stringify(100 << 20));
+  g_ceph_context->_conf->apply_changes(nullptr);
+
+  // 4MB take the device as long as 4 small ios
+  double r_inv =
+    mgr.get_client_info(osd_op_type_t::bg_recovery)->reservation_inv;
+  ASSERT_DOUBLE_EQ(4.0 * r_inv,
+		   mgr.get_addl_cost(osd_op_type_t::bg_recovery, 4 << 20));
+  ASSERT_LT(mgr.get_addl_cost(osd_op_type_t::bg_recovery, 4 << 10),
+	    mgr.get_addl_cost(osd_op_type_t::bg_recovery, 4 << 20));
+
+  g_ceph_context->_conf->set_val("osd_op_queue_mclock_iops_capacity", "0");
+  g_ceph_context->_conf->set_val("osd_op_queue_mclock_bandwidth_capacity", "0");
+  g_ceph_context->_conf->apply_changes(nullptr);
+  ASSERT_EQ(0.0, mgr.get_addl_cost(osd_op_type_t::bg_recovery, 4 << 20));
+}
@@ -285,6 +285,54 @@ TEST_F(OSDMapTest, PrimaryTempRespected) {
   EXPECT_EQ(acting_primary, acting_osds[1]);
 }
 
+TEST_F(OSDMapTest, CowCopyApplyIncremental) {
+  set_up_map();
+
+  pg_t rawpg(0, my_rep_pool, -1);
+  pg_t pgid = osdmap.raw_pg_to_pg(rawpg);
+  vector<int> up_osds, acting_osds;
+  int up_primary, acting_primary;
+  osdmap.pg_to_up_acting_osds(pgid, &up_osds, &up_primary,
+                              &acting_osds, &acting_primary);
+
+  vector<int> new_acting_osds(acting_osds.rbegin(), acting_osds.rend());
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.new_pg_temp[pgid] = mempool::osdmap::vector<int>(
+    new_acting_osds.begin(), new_acting_osds.end());
+  inc.new_primary_temp[pgid] = new_acting_osds[1];
+  inc.new_weight[0] = CEPH_OSD_OUT;
+
+  // same incremental applied to a shared copy and to a decoded copy
+  OSDMap shared;
+  shared.cow_copy_from(osdmap);
+  ASSERT_EQ(0, shared.apply_incremental(inc));
+
+  bufferlist obl;
+  osdmap.encode(obl);
+  OSDMap decoded;
+  decoded.decode(obl);
+  ASSERT_EQ(0, decoded.apply_incremental(inc));
+
+  bufferlist sbl, dbl;
+  shared.encode(sbl);
+  decoded.encode(dbl);
+  EXPECT_TRUE(sbl.contents_equal(dbl));
+
+  // the source map is untouched
+  vector<int> acting_after;
+  int primary_after;
+  osdmap.pg_to_up_acting_osds(pgid, &up_osds, &up_primary,
+                              &acting_after, &primary_after);
+  EXPECT_EQ(acting_osds, acting_after);
+  EXPECT_EQ(acting_primary, primary_after);
+  EXPECT_NE(CEPH_OSD_OUT, osdmap.get_weight(0));
+
+  shared.pg_to_up_acting_osds(pgid, &up_osds, &up_primary,
+                              &acting_after, &primary_after);
+  EXPECT_EQ(new_acting_osds, acting_after);
+  EXPECT_EQ(new_acting_osds[1], primary_after);
+}
+
 TEST_F(OSDMapTest, CleanTemps) {
   set_up_map();
 
@@ -443,6 +491,85 @@ TEST_F(OSDMapTest, PrimaryAffinity) {
   }
 }
 
+TEST_F(OSDMapTest, IncrementalMappingUpdate) {
+  set_up_map();
+  mapping.update(osdmap);
+
+  // an osd-only change is applied incrementally...
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.fsid = osdmap.get_fsid();
+  inc.new_weight[0] = CEPH_OSD_OUT;
+  inc.new_state[1] = CEPH_OSD_UP;  // mark osd.1 down
+  osdmap.apply_incremental(inc);
+  ASSERT_TRUE(mapping.update(osdmap, inc));
+  ASSERT_EQ(osdmap.get_epoch(), mapping.get_epoch());
+
+  // ...and matches a full recomputation
+  for (auto& p : osdmap.get_pools()) {
+    for (unsigned ps = 0; ps < p.second.get_pg_num(); ++ps) {
+      pg_t pgid(ps, p.first);
+      vector<int> up, acting, up2, acting2;
+      int up_primary, acting_primary, up_primary2, acting_primary2;
+      osdmap.pg_to_up_acting_osds(pgid,
+				  &up, &up_primary, &acting, &acting_primary);
+      mapping.get(pgid, &up2, &up_primary2, &acting2, &acting_primary2);
+      ASSERT_EQ(up, up2);
+      ASSERT_EQ(up_primary, up_primary2);
+      ASSERT_EQ(acting, acting2);
+      ASSERT_EQ(acting_primary, acting_primary2);
+    }
+  }
+  ASSERT_TRUE(mapping.get_osd_acting_pgs(0).empty());
+
+  // anything else needs a full update
+  OSDMap::Incremental pool_inc(osdmap.get_epoch() + 1);
+  pool_inc.fsid = osdmap.get_fsid();
+  pg_pool_t *p = pool_inc.get_new_pool(
+    my_rep_pool, osdmap.get_pg_pool(my_rep_pool));
+  p->set_pg_num(128);
+  osdmap.apply_incremental(pool_inc);
+  ASSERT_FALSE(mapping.update(osdmap, pool_inc));
+  ASSERT_EQ(osdmap.get_epoch() - 1, mapping.get_epoch());
+}
+
+TEST_F(OSDMapTest, MappingCache) {
+  set_up_map();
+
+  pg_t rawpg(0, my_rep_pool, -1);
+  pg_t pgid = osdmap.raw_pg_to_pg(rawpg);
+  vector<int> up_osds, acting_osds;
+  int up_primary, acting_primary;
+  osdmap.pg_to_up_acting_osds(pgid, &up_osds, &up_primary,
+                              &acting_osds, &acting_primary);
+
+  // lookups are answered the same way once remembered
+  osdmap.enable_mapping_cache();
+  for (int i = 0; i < 2; ++i) {
+    vector<int> up2, acting2;
+    int up_primary2, acting_primary2;
+    osdmap.pg_to_acting_osds(pgid, &acting2, &acting_primary2);
+    EXPECT_EQ(acting_osds, acting2);
+    EXPECT_EQ(acting_primary, acting_primary2);
+    osdmap.pg_to_up_acting_osds(pgid, &up2, &up_primary2,
+				&acting2, &acting_primary2);
+    EXPECT_EQ(up_osds, up2);
+    EXPECT_EQ(up_primary, up_primary2);
+    EXPECT_EQ(acting_osds, acting2);
+    EXPECT_EQ(acting_primary, acting_primary2);
+  }
+
+  // and forgotten when the map changes
+  vector<int> new_acting_osds(acting_osds.rbegin(), acting_osds.rend());
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.new_pg_temp[pgid] = mempool::osdmap::vector<int>(
+    new_acting_osds.begin(), new_acting_osds.end());
+  ASSERT_EQ(0, osdmap.apply_incremental(inc));
+  osdmap.pg_to_up_acting_osds(pgid, &up_osds, &up_primary,
+                              &acting_osds, &acting_primary);
+  EXPECT_EQ(new_acting_osds, acting_osds);
+  EXPECT_EQ(new_acting_osds[0], acting_primary);
+}
+
 TEST_F(OSDMapTest, parse_osd_id_list) {
   set_up_map();
   set<int> out;
@@ -12,6 +12,7 @@
 
 #include "gtest/gtest.h"
 #include "osd/HitSet.h"
+#include "osd/FrequencySketch.h"
 #include <iostream>
 
 class HitSetTestStrap {
@@ -195,3 +196,37 @@ TEST_F(ExplicitObjectHitSetTest, RejectsNoMatch) {
   }
   EXPECT_EQ(matches, 0);
 }
+
+TEST(FrequencySketch, Counts) {
+  FrequencySketch sketch(1024);
+  hobject_t hot(object_t("hot"), "", 0, 1, 0, "");
+  hobject_t warm(object_t("warm"), "", 0, 2, 0, "");
+  hobject_t cold(object_t("cold"), "", 0, 3, 0, "");
+  for (int i = 0; i < 20; ++i) {
+    sketch.increment(hot);
+    if (i % 4 == 0)
+      sketch.increment(warm);
+  }
+  // never undercounts
+  EXPECT_GE(sketch.estimate(hot), 20u);
+  EXPECT_GE(sketch.estimate(warm), 5u);
+  EXPECT_LT(sketch.estimate(cold), 5u);
+  EXPECT_FALSE(sketch.is_warm());
+}
+
+TEST(FrequencySketch, Ages) {
+  FrequencySketch sketch(64);
+  hobject_t old(object_t("old"), "", 0, 1, 0, "");
+  for (int i = 0; i < 300; ++i)
+    sketch.increment(old);
+  unsigned before = sketch.estimate(old);
+  EXPECT_TRUE(sketch.is_warm());
+
+  // enough other accesses to halve the counters a few times
+  char buf[50];
+  for (unsigned i = 0; i < 64 * 10 * 6; ++i) {
+    sprintf(buf, "other_%u", i);
+    sketch.increment(hobject_t(object_t(buf), "", 0, i, 0, ""));
+  }
+  EXPECT_LT(sketch.estimate(old), before / 4);
+}
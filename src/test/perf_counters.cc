@@ -40,6 +40,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <thread>
 #include <time.h>
 #include <unistd.h>
 
@@ -201,6 +202,44 @@ TEST(PerfCounters, CephContextPerfCounters) {
   g_ceph_context->disable_perf_counter();
 }
 
+enum {
+  TEST_PERFCOUNTERS3_ELEMENT_FIRST = 600,
+  TEST_PERFCOUNTERS3_ELEMENT_COUNTER,
+  TEST_PERFCOUNTERS3_ELEMENT_AVG,
+  TEST_PERFCOUNTERS3_ELEMENT_LAST,
+};
+
+TEST(PerfCounters, ShardedCounters) {
+  PerfCountersBuilder bld(g_ceph_context, "test_perfcounter_3",
+	  TEST_PERFCOUNTERS3_ELEMENT_FIRST, TEST_PERFCOUNTERS3_ELEMENT_LAST);
+  bld.add_u64_counter(TEST_PERFCOUNTERS3_ELEMENT_COUNTER, "counter");
+  bld.add_time_avg(TEST_PERFCOUNTERS3_ELEMENT_AVG, "avg");
+  std::unique_ptr<PerfCounters> pf(bld.create_perf_counters());
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&pf] {
+      for (int i = 0; i < 1000; ++i) {
+	pf->inc(TEST_PERFCOUNTERS3_ELEMENT_COUNTER);
+	pf->tinc(TEST_PERFCOUNTERS3_ELEMENT_AVG, utime_t(0, 1000));
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  ASSERT_EQ(8000u, pf->get(TEST_PERFCOUNTERS3_ELEMENT_COUNTER));
+  ASSERT_EQ(utime_t(0, 8000000), pf->tget(TEST_PERFCOUNTERS3_ELEMENT_AVG));
+  ASSERT_EQ(make_pair(8000ul, 8ul),
+	    pf->get_tavg_ms(TEST_PERFCOUNTERS3_ELEMENT_AVG));
+
+  pf->dec(TEST_PERFCOUNTERS3_ELEMENT_COUNTER, 10);
+  ASSERT_EQ(7990u, pf->get(TEST_PERFCOUNTERS3_ELEMENT_COUNTER));
+  pf->set(TEST_PERFCOUNTERS3_ELEMENT_COUNTER, 5);
+  ASSERT_EQ(5u, pf->get(TEST_PERFCOUNTERS3_ELEMENT_COUNTER));
+  pf->reset();
+  ASSERT_EQ(0u, pf->get(TEST_PERFCOUNTERS3_ELEMENT_COUNTER));
+}
+
 TEST(PerfCounters, ResetPerfCounters) {
   AdminSocketClient client(get_rand_socket_path());
   std::string msg;
@@ -219,3 +258,46 @@ TEST(PerfCounters, ResetPerfCounters) {
   ASSERT_EQ("", client.do_request("{ \"prefix\": \"perf reset\", \"var\": \"test_perfcounter_1\", \"format\": \"json\" }", &msg));
   ASSERT_EQ(sd("{\"error\":\"Not find: test_perfcounter_1\"}"), msg);
 }
+
+TEST(PerfCounters, BinaryDump) {
+  AdminSocketClient client(get_rand_socket_path());
+  std::string msg;
+  PerfCountersCollection *coll = g_ceph_context->get_perfcounters_collection();
+  coll->clear();
+  PerfCounters* fake_pf = setup_test_perfcounters1(g_ceph_context);
+  coll->add(fake_pf);
+  fake_pf->inc(TEST_PERFCOUNTERS1_ELEMENT_1, 7);
+  fake_pf->tset(TEST_PERFCOUNTERS1_ELEMENT_2, utime_t(0, 500));
+  fake_pf->tinc(TEST_PERFCOUNTERS1_ELEMENT_3, utime_t(1, 0));
+
+  ASSERT_EQ("", client.do_request("{ \"prefix\": \"perf dump binary\" }", &msg));
+  bufferlist bl;
+  bl.append(msg);
+  bufferlist::iterator p = bl.begin();
+  __u8 v;
+  uint32_t schema_id, n;
+  ::decode(v, p);
+  ::decode(schema_id, p);
+  ::decode(n, p);
+  ASSERT_EQ(1u, v);
+  ASSERT_EQ(coll->get_schema_id(), schema_id);
+  ASSERT_EQ(4u, n);
+  uint64_t val;
+  ::decode(val, p);
+  ASSERT_EQ(7u, val);
+  ::decode(val, p);
+  ASSERT_EQ(500u, val);
+  ::decode(val, p);
+  ASSERT_EQ(1000000000u, val);
+  ::decode(val, p);
+  ASSERT_EQ(1u, val);
+  ASSERT_TRUE(p.end());
+
+  // the id only moves when the set of counters does
+  fake_pf->inc(TEST_PERFCOUNTERS1_ELEMENT_1);
+  ASSERT_EQ(schema_id, coll->get_schema_id());
+  PerfCounters* fake_pf2 = setup_test_perfcounter2(g_ceph_context);
+  coll->add(fake_pf2);
+  ASSERT_NE(schema_id, coll->get_schema_id());
+  coll->clear();
+}
@@ -540,6 +540,28 @@ TEST(CommonIPAddr, ParseNetwork_IPv6_9000)
   ASSERT_EQ(0, memcmp(want.sin6_addr.s6_addr, network.sin6_addr.s6_addr, sizeof(network.sin6_addr.s6_addr)));
 }
 
+TEST(CommonIPAddr, NetworkContains)
+{
+  struct sockaddr_storage net;
+  unsigned int prefix_len;
+  struct sockaddr_in a4;
+  struct sockaddr_in6 a6;
+
+  ASSERT_TRUE(parse_network("10.11.0.0/16", &net, &prefix_len));
+  ipv4(&a4, "10.11.12.13");
+  ASSERT_TRUE(network_contains(net, prefix_len, (struct sockaddr*)&a4));
+  ipv4(&a4, "10.12.12.13");
+  ASSERT_FALSE(network_contains(net, prefix_len, (struct sockaddr*)&a4));
+  ipv6(&a6, "2001:1234:5678:90ab::cdef");
+  ASSERT_FALSE(network_contains(net, prefix_len, (struct sockaddr*)&a6));
+
+  ASSERT_TRUE(parse_network("2001:1234:5678:90ab::/64", &net, &prefix_len));
+  ASSERT_TRUE(network_contains(net, prefix_len, (struct sockaddr*)&a6));
+  ipv6(&a6, "2001:1234:5678:90ac::cdef");
+  ASSERT_FALSE(network_contains(net, prefix_len, (struct sockaddr*)&a6));
+  ASSERT_FALSE(network_contains(net, prefix_len, (struct sockaddr*)&a4));
+}
+
 TEST(pick_address, find_ip_in_subnet_list)
 {
   struct ifaddrs one, two;
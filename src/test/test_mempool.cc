@@ -308,6 +308,14 @@ TEST(mempool, unordered_map)
   h[2] = obj(1);
 }
 
+TEST(mempool, unordered_multimap)
+{
+  mempool::osdmap::unordered_multimap<int,obj> h;
+  h.insert(make_pair(1, obj()));
+  h.insert(make_pair(1, obj(1)));
+  ASSERT_EQ(2u, h.count(1));
+}
+
 TEST(mempool, string_test)
 {
   mempool::osdmap::string s;
@@ -281,3 +281,52 @@ TEST(PageSet, FreeHoles)
   pages.get_range(0, 8, range);
   ASSERT_EQ(0u, range.size());
 }
+
+TEST(PageSet, ShareRange)
+{
+  // allocate pages at offsets 0, 2 and 3, leaving a hole at 1
+  PageSet src(1);
+  PageSet::page_vector range;
+  for (uint64_t i : {0, 2, 3})
+    src.alloc_range(i, 1, range);
+  for (auto &page : range)
+    page->data[0] = 'a' + page->offset;
+  range.clear();
+
+  // the destination has a page where src has its hole
+  PageSet dst(1);
+  dst.alloc_range(5, 1, range);
+  range.clear();
+
+  // share [0,4) at offset 4
+  dst.share_range(src, 0, 4, 4);
+  dst.get_range(0, 8, range);
+  ASSERT_EQ(3u, range.size());
+  ASSERT_EQ(4u, range[0]->offset);
+  ASSERT_EQ(6u, range[1]->offset);
+  ASSERT_EQ(7u, range[2]->offset);
+  ASSERT_EQ('a', range[0]->data[0]);
+  ASSERT_EQ('c', range[1]->data[0]);
+  ASSERT_TRUE(range[1]->is_shared());
+  range.clear();
+
+  // writing to the clone copies its page, the source is left alone
+  dst.alloc_range(6, 1, range);
+  ASSERT_FALSE(range[0]->is_shared());
+  range[0]->data[0] = 'x';
+  range.clear();
+
+  src.get_range(2, 1, range);
+  ASSERT_EQ('c', range[0]->data[0]);
+  ASSERT_FALSE(range[0]->is_shared());
+  range.clear();
+
+  // writing to the source copies its page, the clone is left alone
+  src.alloc_range(3, 1, range);
+  range[0]->data[0] = 'y';
+  range.clear();
+
+  dst.get_range(7, 1, range);
+  ASSERT_EQ('d', range[0]->data[0]);
+  range.clear();
+}
@@ -364,6 +364,31 @@ public:
       cur = next.first;
     }
   }
+  void get_next_keys() {
+    string cur;
+    unsigned max = 1 + random_num() % 4;
+    while (true) {
+      vector<pair<string, bufferlist> > next;
+      int r = cache->get_next_keys(cur, max, &next);
+
+      map<string, bufferlist>::iterator i = truth.upper_bound(cur);
+      int r_truth = (i == truth.end()) ? -ENOENT : 0;
+      ASSERT_EQ(r, r_truth);
+      if (r == -ENOENT)
+	break;
+
+      ASSERT_LE(next.size(), max);
+      for (auto& n : next) {
+	ASSERT_TRUE(i != truth.end());
+	ASSERT_EQ(n.first, i->first);
+	assert_bl_eq(n.second, i->second);
+	++i;
+      }
+      if (next.size() < max)
+	ASSERT_TRUE(i == truth.end());
+      cur = next.back().first;
+    }
+  }
   void SetUp() override {
     driver.reset(new PausyAsyncMap());
     cache.reset(new MapCacher::MapCacher<string, bufferlist>(driver.get()));
@@ -418,7 +443,7 @@ TEST_F(MapCacherTest, Random)
     if (!(i % 50)) {
       std::cout << "On iteration " << i << std::endl;
     }
-    switch (rand() % 4) {
+    switch (rand() % 5) {
     case 0:
       get();
       break;
@@ -431,6 +456,9 @@ TEST_F(MapCacherTest, Random)
     case 3:
       remove();
       break;
+    case 4:
+      get_next_keys();
+      break;
     }
   }
 }
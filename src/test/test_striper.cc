@@ -22,6 +22,38 @@ TEST(Striper, Stripe1)
   ASSERT_EQ(94208u, ex[2].truncate_size);
 }
 
+TEST(Striper, SingleExtent)
+{
+  file_layout_t l;
+
+  l.object_size = 262144;
+  l.stripe_unit = 4096;
+  l.stripe_count = 3;
+
+  // a range inside one stripe unit maps the same way as through the map
+  for (uint64_t off : {0ull, 4096ull, 13000ull, 5006035ull}) {
+    uint64_t len = 4096 - off % 4096;
+    vector<ObjectExtent> ex;
+    Striper::file_to_extents(g_ceph_context, "foo.%016llx", &l, off, len,
+			     off, ex, 7);
+
+    map<object_t, vector<ObjectExtent> > object_extents;
+    Striper::file_to_extents(g_ceph_context, "foo.%016llx", &l, off, len,
+			     off, object_extents, 7);
+    vector<ObjectExtent> expected;
+    Striper::assimilate_extents(object_extents, expected);
+
+    ASSERT_EQ(1u, ex.size());
+    ASSERT_EQ(1u, expected.size());
+    ASSERT_EQ(expected[0].oid, ex[0].oid);
+    ASSERT_EQ(expected[0].objectno, ex[0].objectno);
+    ASSERT_EQ(expected[0].offset, ex[0].offset);
+    ASSERT_EQ(expected[0].length, ex[0].length);
+    ASSERT_EQ(expected[0].truncate_size, ex[0].truncate_size);
+    ASSERT_EQ(expected[0].buffer_extents, ex[0].buffer_extents);
+  }
+}
+
 TEST(Striper, EmptyPartialResult)
 {
   file_layout_t l;
@@ -71,6 +71,9 @@ CompatSet get_test_compat_set() {
 #endif
 
 const ssize_t max_read = 1024 * 1024;
+// objects imported are committed in batches of this many objects or bytes
+const unsigned import_batch_objects = 64;
+const uint64_t import_batch_bytes = 16 * 1024 * 1024;
 const int fd_none = INT_MIN;
 bool outistty;
 bool dry_run;
@@ -897,10 +900,8 @@ int get_omap(ObjectStore *store, coll_t coll, ghobject_t hoid,
 int ObjectStoreTool::get_object(ObjectStore *store, coll_t coll,
 				bufferlist &bl, OSDMap &curmap,
 				bool *skipped_objects,
-				ObjectStore::Sequencer &osr)
+				ObjectStore::Transaction *t)
 {
-  ObjectStore::Transaction tran;
-  ObjectStore::Transaction *t = &tran;
   bufferlist::iterator ebliter = bl.begin();
   object_begin ob;
   ob.decode(ebliter);
@@ -990,8 +991,6 @@ int ObjectStoreTool::get_object(ObjectStore *store, coll_t coll,
       return -EFAULT;
     }
   }
-  if (!dry_run)
-    store->apply_transaction(&osr, std::move(*t));
   return 0;
 }
 
@@ -1400,6 +1399,10 @@ int ObjectStoreTool::do_import(ObjectStore *store, OSDSuperblock& sb,
   bool done = false;
   bool found_metadata = false;
   metadata_section ms;
+  ObjectStore::Transaction batch;
+  unsigned batch_objects = 0;
+  uint64_t num_objects = 0;
+  utime_t start = ceph_clock_now();
   while(!done) {
     ret = read_section(&type, &ebl);
     if (ret)
@@ -1412,8 +1415,18 @@ int ObjectStoreTool::do_import(ObjectStore *store, OSDSuperblock& sb,
     }
     switch(type) {
     case TYPE_OBJECT_BEGIN:
-      ret = get_object(store, coll, ebl, curmap, &skipped_objects, osr);
+      ret = get_object(store, coll, ebl, curmap, &skipped_objects, &batch);
       if (ret) return ret;
+      ++num_objects;
+      // objects are independent; commit them in batches rather than
+      // waiting on the store once per object
+      if (!dry_run &&
+	  (++batch_objects >= import_batch_objects ||
+	   batch.get_num_bytes() >= import_batch_bytes)) {
+	store->apply_transaction(&osr, std::move(batch));
+	batch = ObjectStore::Transaction();
+	batch_objects = 0;
+      }
       break;
     case TYPE_PG_METADATA:
       ret = get_pg_metadata(store, ebl, ms, sb, curmap, pgid);
@@ -1434,6 +1447,17 @@ int ObjectStoreTool::do_import(ObjectStore *store, OSDSuperblock& sb,
     return -EFAULT;
   }
 
+  if (!dry_run && batch_objects)
+    store->apply_transaction(&osr, std::move(batch));
+  {
+    utime_t elapsed = ceph_clock_now() - start;
+    cout << "Imported " << num_objects << " objects in " << elapsed
+	 << " seconds";
+    if (elapsed > utime_t())
+      cout << " (" << (double)num_objects / (double)elapsed << " objects/s)";
+    cout << std::endl;
+  }
+
   ObjectStore::Transaction t;
   if (!dry_run) {
     pg_log_t newlog, reject;
@@ -575,8 +575,10 @@ int DataScan::forall_objects(
 
   int r = 0;
   while(range_i < range_end) {
+    // list many objects per round trip rather than paying a pgls
+    // request for every object in the pool
     std::vector<librados::ObjectItem> result;
-    int r = ioctx.object_list(range_i, range_end, 1,
+    int r = ioctx.object_list(range_i, range_end, OBJECT_LIST_BATCH,
                                 filter_bl, &result, &range_i);
     if (r < 0) {
       derr << "Unexpected error listing objects: " << cpp_strerror(r) << dendl;
@@ -249,6 +249,9 @@ class DataScan : public MDSUtility, public MetadataTool
     uint32_t n;
     uint32_t m;
 
+    // Max objects returned by each object_list call in forall_objects
+    static const int OBJECT_LIST_BATCH = 1024;
+
     /**
      * Scan data pool for backtraces, and inject inodes to metadata pool
      */
@@ -51,6 +51,7 @@ void usage()
   cout << "                           max deviation from target [default: .01]" << std::endl;
   cout << "   --upmap-pool <poolname> restrict upmap balancing to 1 or more pools" << std::endl;
   cout << "   --upmap-save            write modified OSDMap with upmap changes" << std::endl;
+  cout << "   --test-decode <count>   time <count> encode/decode rounds of the map" << std::endl;
   exit(1);
 }
 
@@ -132,6 +133,7 @@ int main(int argc, const char **argv)
   std::set<std::string> upmap_pools;
   int64_t pg_num = -1;
   bool test_map_pgs_dump_all = false;
+  int test_decode = 0;
 
   std::string val;
   std::ostringstream err;
@@ -187,6 +189,7 @@ int main(int argc, const char **argv)
       test_map_pgs_dump = true;
     } else if (ceph_argparse_flag(args, i, "--test-map-pgs-dump-all", (char*)NULL)) {
       test_map_pgs_dump_all = true;
+    } else if (ceph_argparse_witharg(args, i, &test_decode, err, "--test-decode", (char*)NULL)) {
     } else if (ceph_argparse_flag(args, i, "--test-random", (char*)NULL)) {
       test_random = true;
     } else if (ceph_argparse_flag(args, i, "--clobber", (char*)NULL)) {
@@ -475,6 +478,25 @@ int main(int argc, const char **argv)
          << ") acting (" << acting << ", p" << acting_primary << ")"
          << std::endl;
   }
+  if (test_decode > 0) {
+    bufferlist bl;
+    utime_t start = ceph_clock_now();
+    for (int i = 0; i < test_decode; ++i) {
+      bl.clear();
+      osdmap.encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+    }
+    utime_t encode_time = ceph_clock_now() - start;
+    start = ceph_clock_now();
+    for (int i = 0; i < test_decode; ++i) {
+      OSDMap m;
+      m.decode(bl);
+    }
+    utime_t decode_time = ceph_clock_now() - start;
+    cout << "encoded size " << bl.length() << " bytes" << std::endl;
+    cout << "encode avg " << (double)encode_time / test_decode * 1000.0
+	 << " ms, decode avg " << (double)decode_time / test_decode * 1000.0
+	 << " ms over " << test_decode << " rounds" << std::endl;
+  }
   if (test_map_pgs || test_map_pgs_dump || test_map_pgs_dump_all) {
     if (pool != -1 && !osdmap.have_pg_pool(pool)) {
       cerr << "There is no pool " << pool << std::endl;
@@ -630,7 +652,7 @@ int main(int argc, const char **argv)
       export_crush.empty() && import_crush.empty() && 
       test_map_pg.empty() && test_map_object.empty() &&
       !test_map_pgs && !test_map_pgs_dump && !test_map_pgs_dump_all &&
-      !upmap && !upmap_cleanup) {
+      !upmap && !upmap_cleanup && !test_decode) {
     cerr << me << ": no action specified?" << std::endl;
     usage();
   }
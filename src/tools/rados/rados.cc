@@ -204,6 +204,10 @@ void usage(ostream& out)
 "        prefix output with date/time\n"
 "   --no-verify\n"
 "        do not verify contents of read objects\n"
+"   --write-percent=N\n"
+"        make N percent of the rand bench ops overwrites\n"
+"   --zipf=THETA\n"
+"        pick the objects of the rand bench with zipf popularity THETA\n"
 "   --write-object\n"
 "        write contents to the objects\n"
 "   --write-omap\n"
@@ -1621,6 +1625,8 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
   bool cleanup = true;
   bool hints = true; // for rados bench
   bool no_verify = false;
+  int write_percent = 0;
+  double zipf_theta = 0;
   bool use_striper = false;
   bool with_clones = false;
   const char *snapname = NULL;
@@ -1827,6 +1833,25 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
   if (i != opts.end()) {
     no_verify = true;
   }
+  i = opts.find("write-percent");
+  if (i != opts.end()) {
+    if (rados_sistrtoll(i, &write_percent)) {
+      return -EINVAL;
+    }
+    if (write_percent < 0 || write_percent > 100) {
+      cerr << "--write-percent must be between 0 and 100" << std::endl;
+      return -EINVAL;
+    }
+  }
+  i = opts.find("zipf");
+  if (i != opts.end()) {
+    string err;
+    zipf_theta = strict_strtod(i->second.c_str(), &err);
+    if (!err.empty() || zipf_theta < 0) {
+      cerr << "Invalid value for zipf: '" << i->second << "'" << std::endl;
+      return -EINVAL;
+    }
+  }
   i = opts.find("output");
   if (i != opts.end()) {
     output = i->second.c_str();
@@ -2993,9 +3018,11 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
         ret = -EINVAL;
         goto out;
       }
-      if (bench_write_dest != 0) {
+      if (bench_write_dest != 0 &&
+	  !(operation == OP_RAND_READ && write_percent)) {
         cerr << "--write-object, --write-omap and --write-xattr options can "
-                "only be used with the 'write' bench test"
+                "only be used with the 'write' bench test, or the 'rand' "
+                "bench test with --write-percent"
              << std::endl;
         ret = -EINVAL;
         goto out;
@@ -3004,6 +3031,15 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
     else if (bench_write_dest == 0) {
       bench_write_dest = OP_WRITE_DEST_OBJ;
     }
+    if (operation != OP_RAND_READ && (write_percent || zipf_theta > 0)) {
+      cerr << "--write-percent and --zipf can only be used with the 'rand' "
+              "bench test" << std::endl;
+      ret = -EINVAL;
+      goto out;
+    }
+    if (write_percent && bench_write_dest == 0) {
+      bench_write_dest = OP_WRITE_DEST_OBJ;
+    }
 
     if (!formatter && output) {
       cerr << "-o|--output option can only be used with '--format' option"
@@ -3014,6 +3050,8 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
     RadosBencher bencher(g_ceph_context, rados, io_ctx);
     bencher.set_show_time(show_time);
     bencher.set_write_destination(static_cast<OpWriteDest>(bench_write_dest));
+    bencher.set_write_percent(write_percent);
+    bencher.set_zipf_theta(zipf_theta);
 
     ostream *outstream = NULL;
     if (formatter) {
@@ -3642,6 +3680,10 @@ int main(int argc, const char **argv)
       opts["no-hints"] = "true";
     } else if (ceph_argparse_flag(args, i, "--no-verify", (char*)NULL)) {
       opts["no-verify"] = "true";
+    } else if (ceph_argparse_witharg(args, i, &val, "--write-percent", (char*)NULL)) {
+      opts["write-percent"] = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--zipf", (char*)NULL)) {
+      opts["zipf"] = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--run-name", (char*)NULL)) {
       opts["run-name"] = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--prefix", (char*)NULL)) {
@@ -9,6 +9,7 @@
 #include "common/errno.h"
 #include "common/Throttle.h"
 #include "include/encoding.h"
+#include "include/interval_set.h"
 #include <iostream>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -502,22 +503,59 @@ static int do_export_v2(librbd::Image& image, librbd::image_info_t &info, int fd
   return r;
 }
 
+static int export_allocated_cb(uint64_t offset, size_t length, int exists,
+                               void *arg)
+{
+  if (exists) {
+    auto allocated = reinterpret_cast<interval_set<uint64_t> *>(arg);
+    if (!allocated->intersects(offset, length)) {
+      allocated->insert(offset, length);
+    } else {
+      interval_set<uint64_t> extent;
+      extent.insert(offset, length);
+      allocated->union_of(extent);
+    }
+  }
+  return 0;
+}
+
 static int do_export_v1(librbd::Image& image, librbd::image_info_t &info, int fd,
 		        uint64_t period, int max_concurrent_ops, utils::ProgressContext &pc)
 {
   int r = 0;
   size_t file_size = 0;
-  SimpleThrottle throttle(max_concurrent_ops, false);
-  for (uint64_t offset = 0; offset < info.size; offset += period) {
-    if (throttle.pending_error()) {
-      break;
+
+  // a file can be left sparse, so only read what is allocated (per object,
+  // from the object map when fast-diff is available)
+  interval_set<uint64_t> allocated;
+  if (fd != STDOUT_FILENO && info.size > 0) {
+    r = image.diff_iterate2(nullptr, 0, info.size, true, true,
+                            &export_allocated_cb, &allocated);
+    if (r < 0) {
+      allocated.clear();
     }
+  }
+  if (allocated.empty() && (fd == STDOUT_FILENO || r < 0) && info.size > 0) {
+    allocated.insert(0, info.size);
+  }
+  r = 0;
 
-    uint64_t length = min(period, info.size - offset);
-    C_Export *ctx = new C_Export(throttle, image, file_size + offset, offset, length, fd);
-    ctx->send();
+  SimpleThrottle throttle(max_concurrent_ops, false);
+  for (auto it = allocated.begin(); it != allocated.end(); ++it) {
+    uint64_t end = it.get_start() + it.get_len();
+    for (uint64_t offset = it.get_start(); offset < end; ) {
+      if (throttle.pending_error()) {
+        break;
+      }
 
-    pc.update_progress(offset, info.size);
+      // stay within a stripe period, as a whole-period read would
+      uint64_t length = min(period - (offset % period), end - offset);
+      C_Export *ctx = new C_Export(throttle, image, file_size + offset, offset, length, fd);
+      ctx->send();
+
+      pc.update_progress(offset, info.size);
+      offset += length;
+    }
   }
 
   file_size += info.size;
@@ -29,6 +29,7 @@
 #include "tools/rbd_mirror/image_replayer/PrepareLocalImageRequest.h"
 #include "tools/rbd_mirror/image_replayer/PrepareRemoteImageRequest.h"
 #include "tools/rbd_mirror/image_replayer/ReplayStatusFormatter.h"
+#include <iomanip>
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_rbd_mirror
@@ -825,6 +826,8 @@ void ImageReplayer<I>::handle_replay_ready()
   }
 
   if (!m_remote_journaler->try_pop_front(&m_replay_entry, &m_replay_tag_tid)) {
+    Mutex::Locker locker(m_lock);
+    m_replay_event_timestamp = utime_t();
     return;
   }
 
@@ -1212,6 +1215,11 @@ void ImageReplayer<I>::process_entry() {
     return;
   }
 
+  {
+    Mutex::Locker locker(m_lock);
+    m_replay_event_timestamp = m_event_entry.timestamp;
+  }
+
   Context *on_ready = create_context_callback<
     ImageReplayer, &ImageReplayer<I>::handle_process_entry_ready>(this);
   Context *on_commit = new C_ReplayCommitted(this, std::move(m_replay_entry));
@@ -1319,6 +1327,7 @@ void ImageReplayer<I>::send_mirror_status_update(const OptionalState &opt_state)
   std::string state_desc;
   int last_r;
   bool stopping_replay;
+  utime_t replay_event_timestamp;
 
   OptionalMirrorImageStatusState mirror_image_status_state{
     boost::make_optional(false, cls::rbd::MirrorImageStatusState{})};
@@ -1330,6 +1339,7 @@ void ImageReplayer<I>::send_mirror_status_update(const OptionalState &opt_state)
     mirror_image_status_state = m_mirror_image_status_state;
     last_r = m_last_r;
     stopping_replay = (m_local_image_ctx != nullptr);
+    replay_event_timestamp = m_replay_event_timestamp;
 
     if (m_bootstrap_request != nullptr) {
       bootstrap_request = m_bootstrap_request;
@@ -1382,7 +1392,17 @@ void ImageReplayer<I>::send_mirror_status_update(const OptionalState &opt_state)
         dout(20) << "waiting for replay status" << dendl;
         return;
       }
-      status.description = "replaying, " + desc;
+      // how old the event being replayed is, i.e. how far behind in
+      // time the local image is
+      double seconds_behind = 0;
+      if (!replay_event_timestamp.is_zero()) {
+        seconds_behind = std::max<double>(
+          0, ceph_clock_now() - replay_event_timestamp);
+      }
+      std::stringstream ss;
+      ss << std::fixed << std::setprecision(3) << seconds_behind;
+      status.description = "replaying, " + desc + ", seconds_behind_master=" +
+                           ss.str();
       mirror_image_status_state = boost::none;
     }
     break;
@@ -342,6 +342,8 @@ private:
   librbd::journal::TagData m_replay_tag_data;
   librbd::journal::EventEntry m_event_entry;
   AsyncOpTracker m_event_replay_tracker;
+  utime_t m_replay_event_timestamp;	///< of the last event replayed, zero
+					///< once caught up with the journal
   Context *m_delayed_preprocess_task = nullptr;
 
   struct RemoteJournalerListener : public ::journal::JournalMetadataListener {
@@ -63,6 +63,7 @@
 struct Config {
   int nbds_max = 0;
   int max_part = 255;
+  int num_connections = 1;
 
   bool exclusive = false;
   bool readonly = false;
@@ -85,6 +86,7 @@ static void usage()
             << "  --nbds_max <limit>      Override for module param nbds_max\n"
             << "  --max_part <limit>      Override for module param max_part\n"
             << "  --exclusive             Forbid writes by other clients\n"
+            << "  --connections <num>     Number of sockets to the nbd device\n"
             << std::endl;
   generic_server_usage();
 }
@@ -100,6 +102,10 @@ static enum {
 
 #define RBD_NBD_BLKSIZE 512UL
 
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN (1 << 8)
+#endif
+
 #define HELP_INFO 1
 #define VERSION_INFO 2
 
@@ -342,20 +348,20 @@ private:
 
       dout(20) << __func__ << ": got: " << *ctx << dendl;
 
-      int r = safe_write(fd, &ctx->reply, sizeof(struct nbd_reply));
+      // header and read payload go out in a single writev, straight from
+      // the buffers librbd read into
+      bufferlist reply;
+      reply.push_back(buffer::create_static(sizeof(struct nbd_reply),
+                                            reinterpret_cast<char *>(&ctx->reply)));
+      if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
+        reply.claim_append(ctx->data);
+      }
+      int r = reply.write_fd(fd);
       if (r < 0) {
-	derr << *ctx << ": failed to write reply header: " << cpp_strerror(r)
+	derr << *ctx << ": failed to write reply: " << cpp_strerror(r)
 	     << dendl;
         return;
       }
-      if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-	r = ctx->data.write_fd(fd);
-        if (r < 0) {
-	  derr << *ctx << ": failed to write replay data: " << cpp_strerror(r)
-	       << dendl;
-          return;
-	}
-      }
       dout(20) << *ctx << ": finish" << dendl;
     }
     dout(20) << __func__ << ": terminated" << dendl;
@@ -562,7 +568,7 @@ static int do_map(int argc, const char *argv[], Config *cfg)
   unsigned long size;
 
   int index = 0;
-  int fd[2];
+  std::vector<std::pair<int, int>> socks;
 
   librbd::image_info_t info;
 
@@ -597,9 +603,15 @@ static int do_map(int argc, const char *argv[], Config *cfg)
   common_init_finish(g_ceph_context);
   global_init_chdir(g_ceph_context);
 
-  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
-    r = -errno;
-    goto close_ret;
+  // one socket pair per connection: the kernel end is handed to the nbd
+  // device, the other one is served by its own reader and writer
+  for (int i = 0; i < cfg->num_connections; ++i) {
+    int fd[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
+      r = -errno;
+      goto close_fd;
+    }
+    socks.push_back(std::make_pair(fd[0], fd[1]));
   }
 
   if (cfg->devpath.empty()) {
@@ -631,7 +643,7 @@ static int do_map(int argc, const char *argv[], Config *cfg)
         goto close_fd;
       }
 
-      r = ioctl(nbd, NBD_SET_SOCK, fd[0]);
+      r = ioctl(nbd, NBD_SET_SOCK, socks[0].first);
       if (r < 0) {
         close(nbd);
         ++index;
@@ -655,7 +667,7 @@ static int do_map(int argc, const char *argv[], Config *cfg)
       goto close_fd;
     }
 
-    r = ioctl(nbd, NBD_SET_SOCK, fd[0]);
+    r = ioctl(nbd, NBD_SET_SOCK, socks[0].first);
     if (r < 0) {
       r = -errno;
       cerr << "rbd-nbd: the device " << cfg->devpath << " is busy" << std::endl;
@@ -664,7 +676,21 @@ static int do_map(int argc, const char *argv[], Config *cfg)
     }
   }
 
+  for (size_t i = 1; i < socks.size(); ++i) {
+    r = ioctl(nbd, NBD_SET_SOCK, socks[i].first);
+    if (r < 0) {
+      r = -errno;
+      cerr << "rbd-nbd: failed to add connection " << i << " to "
+           << cfg->devpath << ": " << cpp_strerror(r)
+           << " (kernel without multi-connection support?)" << std::endl;
+      goto close_nbd;
+    }
+  }
+
   flags = NBD_FLAG_SEND_FLUSH | NBD_FLAG_SEND_TRIM | NBD_FLAG_HAS_FLAGS;
+  if (socks.size() > 1) {
+    flags |= NBD_FLAG_CAN_MULTI_CONN;
+  }
   if (!cfg->snapname.empty() || cfg->readonly) {
     flags |= NBD_FLAG_READ_ONLY;
     read_only = 1;
@@ -756,9 +782,11 @@ static int do_map(int argc, const char *argv[], Config *cfg)
     }
 
     {
-      NBDServer server(fd[1], image);
-
-      server.start();
+      std::vector<std::unique_ptr<NBDServer>> servers;
+      for (auto &sock : socks) {
+        servers.emplace_back(new NBDServer(sock.second, image));
+        servers.back()->start();
+      }
       
       init_async_signal_handler();
       register_async_signal_handler(SIGHUP, sighup_handler);
@@ -784,9 +812,10 @@ close_nbd:
   }
   close(nbd);
 close_fd:
-  close(fd[0]);
-  close(fd[1]);
-close_ret:
+  for (auto &sock : socks) {
+    close(sock.first);
+    close(sock.second);
+  }
   image.close();
   io_ctx.close();
   rados.shutdown();
@@ -983,6 +1012,16 @@ static int parse_args(vector<const char*>& args, std::ostream *err_msg, Config *
       cfg->readonly = true;
     } else if (ceph_argparse_flag(args, i, "--exclusive", (char *)NULL)) {
       cfg->exclusive = true;
+    } else if (ceph_argparse_witharg(args, i, &cfg->num_connections, err,
+                                     "--connections", (char *)NULL)) {
+      if (!err.str().empty()) {
+        *err_msg << "rbd-nbd: " << err.str();
+        return -EINVAL;
+      }
+      if (cfg->num_connections < 1) {
+        *err_msg << "rbd-nbd: Invalid argument for connections!";
+        return -EINVAL;
+      }
     } else {
       ++i;
     }